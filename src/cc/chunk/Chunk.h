@@ -70,6 +70,10 @@ const uint32_t MAX_CHUNK_CHECKSUM_BLOCKS           =
 const size_t   CHUNK_META_MAX_FILENAME_LEN         = 256;
 const uint32_t CHUNK_META_MAGIC                    = 0xCAFECAFE;
 const uint32_t CHUNK_META_VERSION                  = 0x1;
+/// Header version of the chunks with non adler32 block checksums. The prior
+/// versions ignore the checksum type flags, the version change ensures that
+/// these reject such chunks instead of reporting checksum mismatches.
+const uint32_t CHUNK_META_VERSION_CHECKSUM_TYPE    = 0x2;
 static const char* const kKfsChunkFsIdPrefix       =
     "\0QFSFsId\xe4\x5e\x23\x0e\x34\x9a\x07\xce";
 static size_t const      kKfsChunkFsIdPrefixLength = 16;
@@ -79,14 +83,18 @@ struct DiskChunkInfo_t
 {
     enum Flags
     {
-        kFlagsNone          = 0,
-        kFlagsMinHeaderSize = 1,
+        kFlagsNone              = 0,
+        kFlagsMinHeaderSize     = 1,
+        // Block checksums algorithm id, KfsChecksumType. Zero, adler32, in
+        // the headers written by the prior versions.
+        kFlagsChecksumTypeShift = 8,
+        kFlagsChecksumTypeMask  = 0xFF << kFlagsChecksumTypeShift
     };
 
     DiskChunkInfo_t(
         kfsFileId_t f, kfsChunkId_t c, int64_t s, kfsSeq_t v, uint32_t cf)
         : metaMagic(CHUNK_META_MAGIC),
-          metaVersion(CHUNK_META_VERSION),
+          metaVersion(GetMetaVersion(cf)),
           fileId(f),
           chunkId(c),
           chunkVersion(v),
@@ -115,7 +123,8 @@ struct DiskChunkInfo_t
 
     bool IsReverseByteOrder() const {
         return (ReverseInt(CHUNK_META_MAGIC) == metaMagic &&
-            ReverseInt(CHUNK_META_VERSION) == metaVersion);
+            (ReverseInt(CHUNK_META_VERSION) == metaVersion ||
+            ReverseInt(CHUNK_META_VERSION_CHECKSUM_TYPE) == metaVersion));
     }
 
     void SetChecksums(const uint32_t* checksums) {
@@ -123,6 +132,16 @@ struct DiskChunkInfo_t
             MAX_CHUNK_CHECKSUM_BLOCKS * sizeof(chunkBlockChecksum[0]));
     }
 
+    static int GetChecksumType(uint32_t chunkFlags) {
+        return (int)((chunkFlags & kFlagsChecksumTypeMask) >>
+            kFlagsChecksumTypeShift);
+    }
+
+    static uint32_t GetMetaVersion(uint32_t chunkFlags) {
+        return (GetChecksumType(chunkFlags) == kKfsChecksumTypeAdler32 ?
+            CHUNK_META_VERSION : CHUNK_META_VERSION_CHECKSUM_TYPE);
+    }
+
     int Validate() const {
         if (metaMagic != CHUNK_META_MAGIC) {
             KFS_LOG_STREAM_INFO <<
@@ -132,11 +151,11 @@ struct DiskChunkInfo_t
             KFS_LOG_EOM;
             return -EBADCKSUM;
         }
-        if (metaVersion != CHUNK_META_VERSION) {
+        if (metaVersion != GetMetaVersion(flags)) {
             KFS_LOG_STREAM_INFO <<
                 "chunk header version mismatch:" << hex <<
                 " actual: "   << metaVersion <<
-                " expected: " << CHUNK_META_VERSION << dec <<
+                " expected: " << GetMetaVersion(flags) << dec <<
             KFS_LOG_EOM;
             return -EBADCKSUM;
         }
@@ -146,6 +165,12 @@ struct DiskChunkInfo_t
             KFS_LOG_EOM;
             return -EBADCKSUM;
         }
+        if (! IsValidChecksumType(GetChecksumType(flags))) {
+            KFS_LOG_STREAM_INFO <<
+                "invalid checksum type: " << GetChecksumType(flags) <<
+            KFS_LOG_EOM;
+            return -EBADCKSUM;
+        }
         return 0;
     }
 
@@ -314,11 +339,21 @@ struct ChunkInfo_t
                 KFS_LOG_EOM;
                 return -EINVAL;
             }
-            if (dci.metaVersion != CHUNK_META_VERSION) {
+            if (dci.metaVersion !=
+                    DiskChunkInfo_t::GetMetaVersion(dci.flags)) {
                 KFS_LOG_STREAM_ERROR <<
                     "chunk header version mismatch:" << hex <<
                     " actual: "   << dci.metaVersion <<
-                    " expected: " << CHUNK_META_VERSION << dec <<
+                    " expected: " <<
+                        DiskChunkInfo_t::GetMetaVersion(dci.flags) << dec <<
+                KFS_LOG_EOM;
+                return -EINVAL;
+            }
+            if (! IsValidChecksumType(
+                    DiskChunkInfo_t::GetChecksumType(dci.flags))) {
+                KFS_LOG_STREAM_ERROR <<
+                    "chunk header invalid checksum type: " <<
+                    DiskChunkInfo_t::GetChecksumType(dci.flags) <<
                 KFS_LOG_EOM;
                 return -EINVAL;
             }
@@ -350,6 +385,16 @@ struct ChunkInfo_t
         }
     }
 
+    void SetChecksumType(KfsChecksumType type) {
+        chunkFlags = (chunkFlags &
+            ~((uint32_t)DiskChunkInfo_t::kFlagsChecksumTypeMask)) |
+            ((uint32_t)type << DiskChunkInfo_t::kFlagsChecksumTypeShift);
+    }
+
+    KfsChecksumType GetChecksumType() const {
+        return (KfsChecksumType)DiskChunkInfo_t::GetChecksumType(chunkFlags);
+    }
+
     size_t GetHeaderSize() const {
         return ((chunkFlags & DiskChunkInfo_t::kFlagsMinHeaderSize) == 0 ?
             KFS_CHUNK_HEADER_SIZE : KFS_MIN_CHUNK_HEADER_SIZE);
@@ -0,0 +1,256 @@
+//---------------------------------------------------------- -*- Mode: C++ -*-
+// $Id$
+//
+// Created 2026/10/16
+//
+// Copyright 2026 Quantcast Corp.
+//
+// This file is part of Kosmos File System (KFS).
+//
+// Licensed under the Apache License, Version 2.0
+// (the "License"); you may not use this file except in compliance with
+// the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+//
+// \file ChunkBlockCache.cc
+// \brief In memory cache of recently read chunk checksum blocks.
+//
+//----------------------------------------------------------------------------
+
+#include "ChunkBlockCache.h"
+
+#include "kfsio/checksum.h"
+
+#include <algorithm>
+#include <limits>
+#include <utility>
+
+namespace KFS
+{
+
+using std::max;
+using std::min;
+using std::numeric_limits;
+using std::make_pair;
+
+class ChunkBlockCache::Entry
+{
+public:
+    Entry(
+        const Key& inKey)
+        : mKey(inKey),
+          mBuf()
+        { QCDLListOp<Entry, 0>::Init(*this); }
+    const Key mKey;
+    IOBuffer  mBuf;
+private:
+    Entry* mPrevPtr[1];
+    Entry* mNextPtr[1];
+
+    friend class QCDLListOp<Entry, 0>;
+private:
+    Entry(
+        const Entry& inEntry);
+    Entry& operator=(
+        const Entry& inEntry);
+};
+
+const int kChunkBlockCacheBlockSize = (int)CHECKSUM_BLOCKSIZE;
+
+ChunkBlockCache::ChunkBlockCache()
+    : BufferManager::Client(),
+      mEntries(),
+      mBufferManagerPtr(0),
+      mMaxSize(0),
+      mSize(0)
+{
+    Lru::Init(mLruPtr);
+}
+
+ChunkBlockCache::~ChunkBlockCache()
+{
+    ChunkBlockCache::Clear();
+}
+
+    void
+ChunkBlockCache::SetBufferManager(
+    BufferManager* inBufferManagerPtr)
+{
+    if (inBufferManagerPtr == mBufferManagerPtr) {
+        return;
+    }
+    Clear();
+    mBufferManagerPtr = inBufferManagerPtr;
+}
+
+    void
+ChunkBlockCache::SetMaxSize(
+    ChunkBlockCache::ByteCount inMaxSize)
+{
+    mMaxSize = max(ByteCount(0), inMaxSize);
+    if (mMaxSize < mSize) {
+        Evict(mSize - mMaxSize);
+    }
+}
+
+    bool
+ChunkBlockCache::Get(
+    kfsChunkId_t inChunkId,
+    int64_t      inChunkVersion,
+    int64_t      inOffset,
+    int          inLength,
+    IOBuffer&    outBuf)
+{
+    if (mSize <= 0 || inLength <= 0 || inOffset < 0 ||
+            inOffset % kChunkBlockCacheBlockSize != 0) {
+        return false;
+    }
+    const int64_t           theStart = inOffset / kChunkBlockCacheBlockSize;
+    const int64_t           theEnd   = theStart +
+        (inLength + kChunkBlockCacheBlockSize - 1) / kChunkBlockCacheBlockSize;
+    const Entries::iterator theFirst =
+        mEntries.find(Key(inChunkId, inChunkVersion, theStart));
+    Entries::iterator       theIt    = theFirst;
+    for (int64_t theIdx = theStart; theIdx < theEnd; ++theIdx, ++theIt) {
+        if (theIt == mEntries.end() ||
+                theIt->first.mChunkId != inChunkId ||
+                theIt->first.mChunkVersion != inChunkVersion ||
+                theIt->first.mBlockIdx != theIdx) {
+            return false;
+        }
+    }
+    int theRem = inLength;
+    for (theIt = theFirst; 0 < theRem; ++theIt) {
+        Entry& theEntry = *theIt->second;
+        theRem -= outBuf.Copy(
+            &theEntry.mBuf, min(theRem, kChunkBlockCacheBlockSize));
+        Lru::PushFront(mLruPtr, theEntry);
+    }
+    return true;
+}
+
+    void
+ChunkBlockCache::Put(
+    kfsChunkId_t    inChunkId,
+    int64_t         inChunkVersion,
+    int64_t         inOffset,
+    const IOBuffer& inBuf)
+{
+    if (! mBufferManagerPtr || mMaxSize < kChunkBlockCacheBlockSize ||
+            inOffset < 0 || inOffset % kChunkBlockCacheBlockSize != 0 ||
+            inBuf.BytesConsumable() <= 0) {
+        return;
+    }
+    Shrink();
+    BufferManager& theBufMgr = *mBufferManagerPtr;
+    IOBuffer       theBuf;
+    theBuf.Copy(&inBuf, inBuf.BytesConsumable());
+    const int theTail = theBuf.BytesConsumable() % kChunkBlockCacheBlockSize;
+    if (0 < theTail) {
+        theBuf.ZeroFill(kChunkBlockCacheBlockSize - theTail);
+    }
+    for (int64_t theIdx = inOffset / kChunkBlockCacheBlockSize;
+            kChunkBlockCacheBlockSize <= theBuf.BytesConsumable();
+            ++theIdx) {
+        const Key               theKey(inChunkId, inChunkVersion, theIdx);
+        const Entries::iterator theIt = mEntries.lower_bound(theKey);
+        if (theIt != mEntries.end() && ! (theKey < theIt->first)) {
+            Lru::PushFront(mLruPtr, *theIt->second);
+            theBuf.Consume(kChunkBlockCacheBlockSize);
+            continue;
+        }
+        // Do not compete for buffers with the clients waiting for them.
+        if (theBufMgr.IsLowOnBuffers() || 0 < theBufMgr.GetWaitingCount()) {
+            break;
+        }
+        const ByteCount theMaxSize = min(mMaxSize,
+            theBufMgr.GetMaxClientQuota() - GetWaitingForByteCount());
+        if (theMaxSize < mSize + kChunkBlockCacheBlockSize &&
+                ! Evict(mSize + kChunkBlockCacheBlockSize - theMaxSize)) {
+            break;
+        }
+        if (! theBufMgr.Get(*this, kChunkBlockCacheBlockSize)) {
+            CancelRequest();
+            break;
+        }
+        Entry& theEntry = *(new Entry(theKey));
+        theEntry.mBuf.Move(&theBuf, kChunkBlockCacheBlockSize);
+        // Insert hint can not be used, as eviction above might invalidate
+        // the iterator.
+        mEntries.insert(make_pair(theKey, &theEntry));
+        Lru::PushFront(mLruPtr, theEntry);
+        mSize += kChunkBlockCacheBlockSize;
+    }
+}
+
+    void
+ChunkBlockCache::Invalidate(
+    kfsChunkId_t inChunkId)
+{
+    Entries::iterator theIt = mEntries.lower_bound(Key(
+        inChunkId,
+        numeric_limits<int64_t>::min(),
+        numeric_limits<int64_t>::min()
+    ));
+    while (theIt != mEntries.end() && theIt->first.mChunkId == inChunkId) {
+        Erase(theIt++);
+    }
+}
+
+    void
+ChunkBlockCache::Clear()
+{
+    while (! mEntries.empty()) {
+        Erase(mEntries.begin());
+    }
+}
+
+    void
+ChunkBlockCache::Shrink()
+{
+    if (mSize <= 0 || ! mBufferManagerPtr) {
+        return;
+    }
+    BufferManager& theBufMgr = *mBufferManagerPtr;
+    if (theBufMgr.IsLowOnBuffers() || 0 < theBufMgr.GetWaitingCount()) {
+        Evict(max(theBufMgr.GetWaitingByteCount(),
+            ByteCount(16) * kChunkBlockCacheBlockSize));
+    }
+}
+
+    void
+ChunkBlockCache::Erase(
+    ChunkBlockCache::Entries::iterator inIt)
+{
+    Entry* const theEntryPtr = inIt->second;
+    mEntries.erase(inIt);
+    Lru::Remove(mLruPtr, *theEntryPtr);
+    delete theEntryPtr;
+    mSize -= kChunkBlockCacheBlockSize;
+    mBufferManagerPtr->Put(*this, kChunkBlockCacheBlockSize);
+}
+
+    bool
+ChunkBlockCache::Evict(
+    ChunkBlockCache::ByteCount inByteCount)
+{
+    ByteCount theRem = inByteCount;
+    while (0 < theRem) {
+        const Entry* const theEntryPtr = Lru::Back(mLruPtr);
+        if (! theEntryPtr) {
+            break;
+        }
+        Erase(mEntries.find(theEntryPtr->mKey));
+        theRem -= kChunkBlockCacheBlockSize;
+    }
+    return (theRem <= 0);
+}
+
+}
@@ -0,0 +1,152 @@
+//---------------------------------------------------------- -*- Mode: C++ -*-
+// $Id$
+//
+// Created 2026/10/16
+//
+// Copyright 2026 Quantcast Corp.
+//
+// This file is part of Kosmos File System (KFS).
+//
+// Licensed under the Apache License, Version 2.0
+// (the "License"); you may not use this file except in compliance with
+// the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+//
+// \file ChunkBlockCache.h
+// \brief In memory cache of recently read chunk checksum blocks.
+//
+//----------------------------------------------------------------------------
+
+#ifndef CHUNK_BLOCK_CACHE_H
+#define CHUNK_BLOCK_CACHE_H
+
+#include "BufferManager.h"
+
+#include "common/kfstypes.h"
+#include "common/StdAllocator.h"
+#include "kfsio/IOBuffer.h"
+#include "qcdio/QCDLList.h"
+
+#include <map>
+
+namespace KFS
+{
+
+using std::map;
+using std::less;
+using std::pair;
+
+// Bounded LRU cache of chunk checksum blocks (CHECKSUM_BLOCKSIZE each), keyed
+// by chunk id, version, and block index. The chunk manager adds only blocks
+// that were read from disk and whose checksums were verified, and that belong
+// to stable chunks. The cached blocks share io buffers with the read requests
+// that produced them, and are charged against the disk io buffer manager as a
+// separate client, therefore the cache never waits for buffers: the block is
+// not added if the buffer manager would not grant the buffers immediately, and
+// the least recently used blocks are released when other clients are waiting
+// for buffers, or the buffer pool runs low. The cache is disabled until the
+// buffer manager is set.
+class ChunkBlockCache : public BufferManager::Client
+{
+public:
+    typedef BufferManager::ByteCount ByteCount;
+
+    ChunkBlockCache();
+    virtual ~ChunkBlockCache();
+    virtual void Granted(
+        ByteCount /* inByteCount */)
+        {}
+    void SetMaxSize(
+        ByteCount inMaxSize);
+    ByteCount GetMaxSize() const
+        { return mMaxSize; }
+    // Clears the cache if the buffer manager changes.
+    void SetBufferManager(
+        BufferManager* inBufferManagerPtr);
+    bool IsEnabled() const
+        { return (0 < mMaxSize && mBufferManagerPtr); }
+    ByteCount GetSize() const
+        { return mSize; }
+    // Returns true, and appends the data to outBuf only if all blocks covering
+    // the range are present in the cache. The offset must be checksum block
+    // aligned.
+    bool Get(
+        kfsChunkId_t inChunkId,
+        int64_t      inChunkVersion,
+        int64_t      inOffset,
+        int          inLength,
+        IOBuffer&    outBuf);
+    // Adds checksum blocks from the buffer that starts at the checksum block
+    // aligned offset. The trailing partial block, if any, is zero padded, and
+    // is expected to be the last block of the chunk: the cached block data
+    // past the chunk end is never returned by Get() as the read length is
+    // limited by the chunk size.
+    void Put(
+        kfsChunkId_t    inChunkId,
+        int64_t         inChunkVersion,
+        int64_t         inOffset,
+        const IOBuffer& inBuf);
+    void Invalidate(
+        kfsChunkId_t inChunkId);
+    void Clear();
+    // Releases blocks if buffer manager is running low on buffers.
+    void Shrink();
+private:
+    struct Key
+    {
+        Key(
+            kfsChunkId_t inChunkId      = 0,
+            int64_t      inChunkVersion = 0,
+            int64_t      inBlockIdx     = 0)
+            : mChunkId(inChunkId),
+              mChunkVersion(inChunkVersion),
+              mBlockIdx(inBlockIdx)
+            {}
+        bool operator<(
+            const Key& inRhs) const
+        {
+            return (mChunkId < inRhs.mChunkId || (mChunkId == inRhs.mChunkId &&
+                (mChunkVersion < inRhs.mChunkVersion || (
+                    mChunkVersion == inRhs.mChunkVersion &&
+                    mBlockIdx < inRhs.mBlockIdx))));
+        }
+        kfsChunkId_t mChunkId;
+        int64_t      mChunkVersion;
+        int64_t      mBlockIdx;
+    };
+    class Entry;
+    typedef QCDLList<Entry, 0> Lru;
+    typedef map<
+        Key,
+        Entry*,
+        less<Key>,
+        StdFastAllocator<pair<const Key, Entry*> >
+    > Entries;
+
+    Entries        mEntries;
+    Entry*         mLruPtr[1];
+    BufferManager* mBufferManagerPtr;
+    ByteCount      mMaxSize;
+    ByteCount      mSize;
+
+    void Erase(
+        Entries::iterator inIt);
+    bool Evict(
+        ByteCount inByteCount);
+private:
+    ChunkBlockCache(
+        const ChunkBlockCache& inCache);
+    ChunkBlockCache& operator=(
+        const ChunkBlockCache& inCache);
+};
+
+}
+
+#endif /* CHUNK_BLOCK_CACHE_H */
@@ -54,6 +54,7 @@
 #include <sys/resource.h>
 #include <sys/stat.h>
 #include <unistd.h>
+#include <fcntl.h>
 #include <sys/types.h>
 
 #include <fstream>
@@ -76,6 +77,7 @@ using std::vector;
 using std::make_pair;
 using std::sort;
 using std::unique;
+using std::copy;
 using std::greater;
 using std::set;
 using std::binary_function;
@@ -828,6 +830,7 @@ public:
     ChunkInfoHandle(ChunkDirInfo& chunkdir, bool stableFlag = true)
         : KfsCallbackObj(),
           chunkInfo(),
+          writeChecksums(),
           dataFH(),
           lastIOTime(0),
           readChunkMetaOp(0),
@@ -905,6 +908,10 @@ public:
     }
 
     ChunkInfo_t      chunkInfo;
+    /// Adler32 checksums of the blocks written through the write protocol,
+    /// maintained only for not stable chunks with different block checksums
+    /// algorithm, in order to verify write sync checksums.
+    vector<uint32_t> writeChecksums;
     /// Chunks are stored as files in he underlying filesystem; each
     /// chunk file is named by the chunkId.  Each chunk has a header;
     /// this header is hidden from clients; all the client I/O is
@@ -1375,12 +1382,45 @@ ChunkManager::Release(ChunkInfoHandle& cih)
     cih.Release(mChunkInfoLists);
 }
 
+inline void
+ChunkManager::InvalidateReadCaches(kfsChunkId_t chunkId)
+{
+    mBlockCache.Invalidate(chunkId);
+    mTierReadCache.Invalidate(chunkId);
+}
+
 inline void
 ChunkManager::DeleteSelf(ChunkInfoHandle& cih)
 {
+    InvalidateReadCaches(cih.chunkInfo.chunkId);
     cih.Delete(mChunkInfoLists);
 }
 
+inline bool
+ChunkManager::IsBlockCacheable(
+    const ChunkInfoHandle* cih, const ReadOp* op) const
+{
+    // Only client reads of stable chunks are cached: the stable chunk content
+    // does not change, and background reads should not displace the client
+    // "working set".
+    return (mBlockCache.IsEnabled() && ! op->wop && ! op->scrubOp &&
+        op->repairCoefficient < 0 && 0 <= cih->chunkInfo.chunkVersion &&
+        cih->IsStable());
+}
+
+inline bool
+ChunkManager::IsTierReadCacheable(
+    const ChunkInfoHandle* cih, const ReadOp* op) const
+{
+    // Only client reads of stable chunks that reside outside of the cache
+    // storage tier.
+    return (mTierReadCacheTier != kKfsSTierUndef &&
+        mTierReadCache.IsEnabled() && ! op->wop && ! op->scrubOp &&
+        op->repairCoefficient < 0 && 0 <= cih->chunkInfo.chunkVersion &&
+        cih->IsStable() &&
+        cih->GetDirInfo().storageTier != mTierReadCacheTier);
+}
+
 inline void
 ChunkManager::Delete(ChunkInfoHandle& cih)
 {
@@ -1709,6 +1749,7 @@ ChunkInfoHandle::HandleChunkMetaWriteDone(int codeIn, void* dataIn)
                 }
                 if (mStableFlag) {
                     mWriteAppenderOwnsFlag = false;
+                    vector<uint32_t>().swap(writeChecksums);
                     // LruUpdate below will add it back to the lru list.
                 }
             }
@@ -1812,7 +1853,12 @@ ChunkManager::ChunkManager()
       mCheckDirWritableFlag(true),
       mCheckDirTestWriteSize(16 << 10),
       mCheckDirWritableTmpFileName("checkdir.tmp"),
-      mNullBlockChecksum(0),
+      mChecksumType(kKfsChecksumTypeAdler32),
+      mBlockCache(),
+      mTierReadCache(),
+      mTierReadCacheTier(kKfsSTierUndef),
+      mTierReadCacheDir("readcache"),
+      mTierReadCacheFileSeq(0),
       mCounters(),
       mDirChecker(),
       mCleanupChunkDirsFlag(true),
@@ -1938,6 +1984,8 @@ ChunkManager::Shutdown()
     // Force meta server connection down first.
     gMetaServerSM.Shutdown();
     mDirChecker.Stop();
+    mBlockCache.SetBufferManager(0);
+    mTierReadCache.Shutdown();
     gClientManager.Shutdown();
     // Run delete queue before removing chunk table entries.
     RunStaleChunksQueue();
@@ -2095,6 +2143,16 @@ ChunkManager::SetParameters(const Properties& prop)
     mAllowSparseChunksFlag = prop.getValue(
         "chunkServer.allowSparseChunks",
         mAllowSparseChunksFlag ? 1 : 0) != 0;
+    const int checksumType = prop.getValue(
+        "chunkServer.checksumType", (int)mChecksumType);
+    if (IsValidChecksumType(checksumType)) {
+        mChecksumType = (KfsChecksumType)checksumType;
+    } else {
+        KFS_LOG_STREAM_ERROR <<
+            "invalid chunkServer.checksumType: " << checksumType <<
+            " ignored" <<
+        KFS_LOG_EOM;
+    }
     mBufferedIoFlag = prop.getValue(
         "chunkServer.bufferedIo",
         mBufferedIoFlag ? 1 : 0) != 0;
@@ -2198,6 +2256,9 @@ ChunkManager::SetParameters(const Properties& prop)
     mForceVerifyDiskReadChecksumFlag = prop.getValue(
         "chunkServer.forceVerifyDiskReadChecksum",
         mForceVerifyDiskReadChecksumFlag ? 1 : 0) != 0;
+    mBlockCache.SetMaxSize(prop.getValue(
+        "chunkServer.readBlockCacheSize", mBlockCache.GetMaxSize()));
+    mTierReadCache.SetParameters(prop);
     mWritePrepareReplyFlag = prop.getValue(
         "chunkServer.debugTestWriteSync",
         mWritePrepareReplyFlag ? 0 : 1) == 0;
@@ -2526,6 +2587,27 @@ ChunkManager::Init(const vector<string>& chunkDirs, const Properties& prop)
     }
     mStaleChunksDir = AddTrailingPathSeparator(mStaleChunksDir);
     mDirtyChunksDir = AddTrailingPathSeparator(mDirtyChunksDir);
+    // The read cache storage tier and its sub directory name can only be set
+    // at startup, the copies are removed on restart.
+    const int tierReadCacheTier = prop.getValue(
+        "chunkServer.tierReadCache.tier", -1);
+    mTierReadCacheDir = prop.getValue(
+        "chunkServer.tierReadCache.dirName",
+        mTierReadCacheDir);
+    mTierReadCacheTier = (kKfsSTierMin <= tierReadCacheTier &&
+        tierReadCacheTier <= kKfsSTierMax) ?
+        (kfsSTier_t)tierReadCacheTier : kKfsSTierUndef;
+    if (mTierReadCacheTier != kKfsSTierUndef && (
+            mTierReadCacheDir.empty() ||
+            mTierReadCacheDir.find('/') != string::npos ||
+            AddTrailingPathSeparator(mTierReadCacheDir) == mStaleChunksDir ||
+            AddTrailingPathSeparator(mTierReadCacheDir) == mDirtyChunksDir)) {
+        KFS_LOG_STREAM_ERROR <<
+            "invalid tier read cache dir name: " << mTierReadCacheDir <<
+        KFS_LOG_EOM;
+        return false;
+    }
+    mTierReadCacheDir = AddTrailingPathSeparator(mTierReadCacheDir);
 
     mMaxOpenFds = SetMaxNoFileLimit();
     mMaxClientCount = mMaxOpenFds * 2 / 3;
@@ -2551,6 +2633,7 @@ ChunkManager::Init(const vector<string>& chunkDirs, const Properties& prop)
         KFS_LOG_EOM;
         return false;
     }
+    mBlockCache.SetBufferManager(&DiskIo::GetBufferManager());
     const int kMinOpenFds = 32;
     if (mMaxOpenFds < kMinOpenFds) {
         KFS_LOG_STREAM_ERROR <<
@@ -2577,7 +2660,11 @@ ChunkManager::Init(const vector<string>& chunkDirs, const Properties& prop)
     {
         IOBuffer buf;
         buf.ZeroFill((int)CHECKSUM_BLOCKSIZE);
-        mNullBlockChecksum = ComputeBlockChecksum(&buf, buf.BytesConsumable());
+        for (int i = 0; i < kKfsChecksumTypeCount; i++) {
+            const KfsChecksumType type = (KfsChecksumType)i;
+            mNullBlockChecksum[i] = ComputeBlockChecksum(&buf,
+                buf.BytesConsumable(), type);
+        }
     }
     // force a stat of the dirs and update space usage counts
     return StartDiskIo();
@@ -2710,6 +2797,7 @@ ChunkManager::AllocChunk(
         GetChunkHeaderSize(cih->chunkInfo.chunkVersion) ==
         KFS_MIN_CHUNK_HEADER_SIZE
     );
+    cih->chunkInfo.SetChecksumType(mChecksumType);
     cih->SetBeingReplicated(isBeingReplicated);
     cih->SetMetaDirty();
     bool newEntryFlag = false;
@@ -2722,6 +2810,7 @@ ChunkManager::AllocChunk(
         cih->Delete(mChunkInfoLists);
         return -EFAULT;
     }
+    InvalidateReadCaches(cih->chunkInfo.chunkId);
     if (cih->chunkInfo.chunkVersion < 0 &&
             ! cih->ScheduleObjTableCleanup(mChunkInfoLists)) {
         die("alloc object schedule cleanup failure");
@@ -2790,6 +2879,17 @@ ChunkManager::AllocChunkForAppend(
         return;
     }
     assert(cih);
+    // Record append computes chunk checksum from the block checksums, and
+    // the metaserver compares it between the replicas, therefore all replicas
+    // must use the same algorithm.
+    if (cih->chunkInfo.GetChecksumType() != kKfsChecksumTypeAdler32) {
+        if (0 < cih->chunkInfo.chunkSize) {
+            op->statusMsg = "append not supported with non adler32 checksums";
+            op->status    = -EINVAL;
+            return;
+        }
+        cih->chunkInfo.SetChecksumType(kKfsChecksumTypeAdler32);
+    }
     gAtomicRecordAppendManager.AllocateChunk(
         op, replicationPos, peerLoc, cih->dataFH);
     if (op->status == 0) {
@@ -3339,6 +3439,7 @@ ChunkManager::StaleChunk(ChunkInfoHandle* cih,
         ;
         die(os.str());
     }
+    InvalidateReadCaches(cih->chunkInfo.chunkId);
     MakeStale(*cih, forceDeleteFlag, evacuatedFlag, op);
     return 0;
 }
@@ -3357,6 +3458,7 @@ ChunkManager::TruncateChunk(kfsChunkId_t chunkId, int64_t chunkSize)
     ChunkInfoHandle* const cih = *ci;
     string const chunkPathname = MakeChunkPathname(cih);
 
+    InvalidateReadCaches(chunkId);
     // Cnunk close will truncate it to the cih->chunkInfo.chunkSize
 
     UpdateDirSpace(cih, -cih->chunkInfo.chunkSize);
@@ -3372,6 +3474,9 @@ ChunkManager::TruncateChunk(kfsChunkId_t chunkId, int64_t chunkSize)
 
     // XXX: Could do better; recompute the checksum for this last block
     cih->chunkInfo.chunkBlockChecksum[lastChecksumBlock] = 0;
+    if (lastChecksumBlock < cih->writeChecksums.size()) {
+        cih->writeChecksums[lastChecksumBlock] = 0;
+    }
     cih->SetMetaDirty();
 
     return 0;
@@ -3445,6 +3550,7 @@ ChunkManager::ChangeChunkVers(
     bool             stableFlag,
     KfsCallbackObj*  cb)
 {
+    InvalidateReadCaches(cih->chunkInfo.chunkId);
     if (! cih->chunkInfo.AreChecksumsLoaded()) {
         KFS_LOG_STREAM_ERROR <<
             "attempt to change version on chunk: " <<
@@ -4125,7 +4231,7 @@ ChunkManager::GetDirName(chunkId_t chunkId, int64_t chunkVersion) const
 }
 
 int
-ChunkManager::ReadChunk(ReadOp* op)
+ChunkManager::ReadChunk(ReadOp* op, bool useReadCacheFlag)
 {
     ChunkInfoHandle* const cih = GetChunkInfoHandle(op->chunkId, op->chunkVersion);
     if (! cih) {
@@ -4172,8 +4278,57 @@ ChunkManager::ReadChunk(ReadOp* op)
         numBytesIO = cih->chunkInfo.chunkSize - offset;
     }
     op->diskIOTime = microseconds();
+    if (op->sendFileFlag && SendFileRead(cih, op)) {
+        return 0;
+    }
+    if (useReadCacheFlag && IsBlockCacheable(cih, op)) {
+        IOBuffer buf;
+        if (mBlockCache.Get(cih->chunkInfo.chunkId,
+                cih->chunkInfo.chunkVersion, offset, (int)numBytesIO, buf)) {
+            mCounters.mReadBlockCacheHitCount++;
+            mCounters.mReadBlockCacheHitByteCount += numBytesIO;
+            // Complete the read with the cached data the same way as disk io
+            // completion would, in order to re-use checksum verification and
+            // data adjustment logic. The op must not be accessed upon return.
+            op->HandleEvent(EVENT_DISK_READ, &buf);
+            return 0;
+        }
+        mCounters.mReadBlockCacheMissCount++;
+        // Only verified blocks are added to the cache, therefore verify the
+        // checksums even if the client will do so.
+        op->skipVerifyDiskChecksumFlag = false;
+    }
+    if (useReadCacheFlag && IsTierReadCacheable(cih, op)) {
+        const DiskIo::FilePtr filePtr = mTierReadCache.Get(
+            cih->chunkInfo.chunkId, cih->chunkInfo.chunkVersion);
+        if (filePtr) {
+            const DiskIoPtr chunkDiskIo = op->diskIo;
+            op->diskIo.reset(new DiskIo(filePtr, op));
+            op->tierReadCacheFlag = true;
+            if (0 <= op->diskIo->Read(
+                    offset + cih->chunkInfo.GetHeaderSize(), numBytesIO,
+                    op->ioPriority)) {
+                mCounters.mTierReadCacheHitCount++;
+                mCounters.mTierReadCacheHitByteCount += numBytesIO;
+                return 0;
+            }
+            // Discard the copy, and read the chunk file.
+            mTierReadCache.Invalidate(cih->chunkInfo.chunkId);
+            op->tierReadCacheFlag = false;
+            op->diskIo = chunkDiskIo;
+        } else {
+            mCounters.mTierReadCacheMissCount++;
+            if (mTierReadCache.RecordRead(
+                    cih->chunkInfo.chunkId, cih->chunkInfo.chunkVersion)) {
+                AddToTierReadCache(cih);
+            }
+        }
+    }
+    // Scrub and pipelined RS repair reads are background io.
     const int ret = op->diskIo->Read(
-        offset + cih->chunkInfo.GetHeaderSize(), numBytesIO);
+        offset + cih->chunkInfo.GetHeaderSize(), numBytesIO,
+        (op->scrubOp || 0 <= op->repairCoefficient) ?
+            int(kKfsIoPriorityLow) : op->ioPriority);
     if (ret < 0) {
         cih->ReadStats(ret, (int64_t)numBytesIO, 0);
         ReportIOFailure(cih, ret);
@@ -4183,6 +4338,142 @@ ChunkManager::ReadChunk(ReadOp* op)
     return 0;
 }
 
+bool
+ChunkManager::SendFileRead(ChunkInfoHandle* cih, ReadOp* op)
+{
+    // The client verifies the checksums, and the stable chunk content does
+    // not change: skip the disk read, and let the client connection send the
+    // data with sendfile from the chunk file. The checksums are the ones
+    // stored with the chunk, the same as the skip disk checksum verification
+    // read would return. The stored checksums cover whole blocks, therefore
+    // both read start and end must be on the checksum block boundaries, the
+    // client computes the checksum of the partial tail block over the bytes
+    // it receives.
+    const KfsChecksumType checksumType = cih->chunkInfo.GetChecksumType();
+    if (! op->skipVerifyDiskChecksumFlag || mForceVerifyDiskReadChecksumFlag ||
+            op->wop || op->scrubOp || 0 <= op->repairCoefficient ||
+            op->numBytesIO <= 0 ||
+            op->offset % CHECKSUM_BLOCKSIZE != 0 ||
+            (op->offset + op->numBytesIO) % CHECKSUM_BLOCKSIZE != 0 ||
+            cih->chunkInfo.chunkVersion < 0 ||
+            ! cih->IsStable() || ! cih->IsFileOpen() ||
+            ! (mBufferedIoFlag || cih->GetDirInfo().bufferedIoFlag) ||
+            (checksumType != kKfsChecksumTypeAdler32 &&
+                checksumType != op->acceptChecksumType)) {
+        return false;
+    }
+    const int fd = cih->dataFH->DupBufferedIoFd();
+    if (fd < 0) {
+        return false;
+    }
+    const int64_t fileOffset = op->offset + cih->chunkInfo.GetHeaderSize();
+#ifdef KFS_OS_NAME_LINUX
+    // Start asynchronous read ahead, in order to minimize the chances of the
+    // network thread waiting for the data in sendfile.
+    posix_fadvise(fd, (off_t)fileOffset, (off_t)op->numBytesIO,
+        POSIX_FADV_WILLNEED);
+#endif
+    size_t         checksumBlock     = OffsetToChecksumBlockNum(op->offset);
+    const size_t   blockCount        = (size_t)(
+        (op->numBytesIO + CHECKSUM_BLOCKSIZE - 1) / CHECKSUM_BLOCKSIZE);
+    const uint32_t nullBlockChecksum = mNullBlockChecksum[checksumType];
+    op->checksumType = checksumType;
+    op->checksum.resize(blockCount);
+    for (size_t i = 0; i < blockCount; i++, checksumBlock++) {
+        const uint32_t checksum =
+            cih->chunkInfo.chunkBlockChecksum[checksumBlock];
+        op->checksum[i] = (checksum == 0 && mAllowSparseChunksFlag) ?
+            nullBlockChecksum : checksum;
+    }
+    op->ReleaseSendFileFd();
+    op->sendFileFd     = fd;
+    op->sendFileOffset = fileOffset;
+    op->diskIOTime     = 1;
+    op->status         = (int)op->numBytesIO;
+    mCounters.mReadSendFileCount++;
+    mCounters.mReadSendFileByteCount += op->numBytesIO;
+    // The op completes with empty data buffer, and must not be accessed upon
+    // return.
+    op->HandleEvent(EVENT_CMD_DONE, 0);
+    return true;
+}
+
+void
+ChunkManager::AddToTierReadCache(ChunkInfoHandle* cih)
+{
+    StorageTiers::const_iterator const tit =
+        mStorageTiers.find(mTierReadCacheTier);
+    if (tit == mStorageTiers.end() || ! cih->IsFileOpen()) {
+        return;
+    }
+    const int64_t fileSize =
+        cih->chunkInfo.GetHeaderSize() + cih->chunkInfo.chunkSize;
+    ChunkDirInfo* dir      = 0;
+    int64_t       maxSpace = 0;
+    for (StorageTiers::mapped_type::const_iterator it = tit->second.begin();
+            it != tit->second.end();
+            ++it) {
+        ChunkDirInfo& di = **it;
+        if (di.evacuateStartedFlag) {
+            continue;
+        }
+        const int64_t space = min(di.dirCountSpaceAvailable ?
+            di.dirCountSpaceAvailable->availableSpace : di.availableSpace,
+            di.availableSpace) - fileSize;
+        if (space < mMinFsAvailableSpace ||
+                space <= di.totalSpace * mMaxSpaceUtilizationThreshold ||
+                space <= maxSpace) {
+            continue;
+        }
+        dir      = &di;
+        maxSpace = space;
+    }
+    if (! dir) {
+        return;
+    }
+    // Unique file name suffix ensures that the pending delete of the previous
+    // copy does not remove the new one.
+    string fileName = MakeChunkPathname(dir->dirname, cih->chunkInfo.fileId,
+        cih->chunkInfo.chunkId, cih->chunkInfo.chunkVersion,
+        mTierReadCacheDir);
+    fileName += '.';
+    AppendDecIntToString(fileName, ++mTierReadCacheFileSeq);
+    mTierReadCache.Add(
+        cih->chunkInfo.chunkId,
+        cih->chunkInfo.chunkVersion,
+        fileSize,
+        cih->dataFH,
+        dir->dirname,
+        fileName,
+        mBufferedIoFlag || dir->bufferedIoFlag
+    );
+}
+
+bool
+ChunkManager::RetryTierReadCacheRead(ReadOp* op)
+{
+    KFS_LOG_STREAM_INFO <<
+        "tier read cache:"
+        " chunk: "   << op->chunkId <<
+        " version: " << op->chunkVersion <<
+        " offset: "  << op->offset <<
+        " status: "  << op->status <<
+        " retrying read with chunk file" <<
+    KFS_LOG_EOM;
+    mCounters.mTierReadCacheRetryCount++;
+    mTierReadCache.Invalidate(op->chunkId, op->diskIo.get());
+    op->tierReadCacheFlag = false;
+    op->status            = 0;
+    op->dataBuf.Clear();
+    op->checksum.clear();
+    const int res = ReadChunk(op);
+    if (res == 0) {
+        return false;
+    }
+    op->status = res;
+    return true;
+}
+
 int
 ChunkManager::WriteChunk(WriteOp* op, const DiskIo::FilePtr* filePtr /* = 0 */)
 {
@@ -4195,6 +4486,7 @@ ChunkManager::WriteChunk(WriteOp* op, const DiskIo::FilePtr* filePtr /* = 0 */)
     if (filePtr && *filePtr != cih->dataFH) {
         return -EINVAL;
     }
+    InvalidateReadCaches(op->chunkId);
     // the checksums should be loaded...
     cih->chunkInfo.VerifyChecksumsLoaded();
 
@@ -4229,15 +4521,25 @@ ChunkManager::WriteChunk(WriteOp* op, const DiskIo::FilePtr* filePtr /* = 0 */)
         return -ENOSPC;
     }
 
-    int64_t offset     = op->offset;
-    ssize_t numBytesIO = op->numBytesIO;
+    int64_t               offset       = op->offset;
+    ssize_t               numBytesIO   = op->numBytesIO;
+    const KfsChecksumType checksumType = cih->chunkInfo.GetChecksumType();
     if ((OffsetToChecksumBlockStart(offset) == offset) &&
             ((size_t)numBytesIO >= (size_t)CHECKSUM_BLOCKSIZE)) {
         if (numBytesIO % CHECKSUM_BLOCKSIZE != 0) {
             op->statusMsg = "invalid request size";
             return -EINVAL;
         }
-        if (op->wpop && ! op->isFromReReplication &&
+        if (op->checksumType != checksumType) {
+            if (op->wpop && op->checksumType == kKfsChecksumTypeAdler32 &&
+                    op->checksums.size() ==
+                        (size_t)(numBytesIO / CHECKSUM_BLOCKSIZE)) {
+                // Keep write prepare checksums for write sync verification.
+                op->writeChecksums.swap(op->checksums);
+            }
+            op->checksums = ComputeChecksums(&op->dataBuf, numBytesIO, 0,
+                CHECKSUM_BLOCKSIZE, checksumType);
+        } else if (op->wpop && ! op->isFromReReplication &&
                 op->checksums.size() ==
                     (size_t)(numBytesIO / CHECKSUM_BLOCKSIZE)) {
             if (op->checksums.size() == 1 &&
@@ -4253,7 +4555,8 @@ ChunkManager::WriteChunk(WriteOp* op, const DiskIo::FilePtr* filePtr /* = 0 */)
                 return -EFAULT;
             }
         } else {
-            op->checksums = ComputeChecksums(&op->dataBuf, numBytesIO);
+            op->checksums = ComputeChecksums(&op->dataBuf, numBytesIO, 0,
+                CHECKSUM_BLOCKSIZE, checksumType);
         }
     } else {
         if ((size_t)numBytesIO >= (size_t) CHECKSUM_BLOCKSIZE) {
@@ -4312,7 +4615,11 @@ ChunkManager::WriteChunk(WriteOp* op, const DiskIo::FilePtr* filePtr /* = 0 */)
         }
 
         assert(op->dataBuf.BytesConsumable() == (int) blkSize);
-        op->checksums = ComputeChecksums(&op->dataBuf, blkSize);
+        op->checksums = ComputeChecksums(&op->dataBuf, blkSize, 0,
+            CHECKSUM_BLOCKSIZE, checksumType);
+        if (op->wpop && checksumType != kKfsChecksumTypeAdler32) {
+            op->writeChecksums = ComputeChecksums(&op->dataBuf, blkSize);
+        }
 
         // Trim data at the buffer boundary from the beginning, to make write
         // offset close to where we were asked from.
@@ -4322,6 +4629,7 @@ ChunkManager::WriteChunk(WriteOp* op, const DiskIo::FilePtr* filePtr /* = 0 */)
         offset += off;
         numBytesIO = numBytes;
     }
+    op->checksumType = checksumType;
 
     DiskIo* const d = SetupDiskIo(cih, op);
     if (! d) {
@@ -4337,8 +4645,12 @@ ChunkManager::WriteChunk(WriteOp* op, const DiskIo::FilePtr* filePtr /* = 0 */)
     */
 
     op->diskIOTime = microseconds();
+    const bool    kSyncFlag = false;
+    const int64_t kEofHint  = -1;
     int res = op->diskIo->Write(
-        offset + cih->chunkInfo.GetHeaderSize(), numBytesIO, &op->dataBuf);
+        offset + cih->chunkInfo.GetHeaderSize(), numBytesIO, &op->dataBuf,
+        kSyncFlag, kEofHint, op->isFromReReplication ?
+            kKfsIoPriorityLow : kKfsIoPriorityNormal);
     if (res >= 0) {
         UpdateChecksums(cih, op);
         assert(res <= numBytesIO);
@@ -4360,6 +4672,8 @@ ChunkManager::UpdateChecksums(ChunkInfoHandle *cih, WriteOp *op)
 
     // the checksums should be loaded...
     cih->chunkInfo.VerifyChecksumsLoaded();
+    // Invalidate again, in case if a read completed while write was in flight.
+    InvalidateReadCaches(cih->chunkInfo.chunkId);
 
     for (vector<uint32_t>::size_type i = 0; i < op->checksums.size(); i++) {
         int64_t  offset = op->offset + i * CHECKSUM_BLOCKSIZE;
@@ -4367,6 +4681,15 @@ ChunkManager::UpdateChecksums(ChunkInfoHandle *cih, WriteOp *op)
 
         cih->chunkInfo.chunkBlockChecksum[checksumBlock] = op->checksums[i];
     }
+    if (! op->writeChecksums.empty() &&
+            op->writeChecksums.size() == op->checksums.size()) {
+        if (cih->writeChecksums.empty()) {
+            cih->writeChecksums.resize(MAX_CHUNK_CHECKSUM_BLOCKS, 0);
+        }
+        copy(op->writeChecksums.begin(), op->writeChecksums.end(),
+            cih->writeChecksums.begin() +
+                OffsetToChecksumBlockNum(op->offset));
+    }
 
     if (cih->chunkInfo.chunkSize < endOffset) {
 
@@ -4406,10 +4729,18 @@ ChunkManager::ReadChunkDone(ReadOp* op)
     const bool kAddObjectBlockMappingFlag = false;
     ChunkInfoHandle* const cih = GetChunkInfoHandle(
         op->chunkId, op->chunkVersion, kAddObjectBlockMappingFlag);
-    bool staleRead = false;
+    const bool cacheRead = op->tierReadCacheFlag;
+    bool       staleRead = false;
     if (! cih ||
             op->chunkVersion != cih->chunkInfo.chunkVersion ||
-            (staleRead = ! cih->IsFileEquals(op->diskIo))) {
+            (staleRead = ! (cacheRead ?
+                mTierReadCache.IsFileEquals(
+                    op->chunkId, op->chunkVersion, op->diskIo.get()) :
+                cih->IsFileEquals(op->diskIo)))) {
+        if (staleRead && cacheRead) {
+            // The chunk copy was discarded while the read was in flight.
+            return RetryTierReadCacheRead(op);
+        }
         op->dataBuf.Clear();
         if (cih) {
             KFS_LOG_STREAM_INFO << "Version # mismatch (have=" <<
@@ -4424,6 +4755,9 @@ ChunkManager::ReadChunkDone(ReadOp* op)
 
     op->diskIOTime = max(int64_t(1), microseconds() - op->diskIOTime);
     const int readLen = op->dataBuf.BytesConsumable();
+    if (readLen <= 0 && cacheRead) {
+        return RetryTierReadCacheRead(op);
+    }
     if (readLen <= 0) {
         KFS_LOG_STREAM_ERROR << "short read for" <<
             " chunk: "    << cih->chunkInfo.chunkId  <<
@@ -4461,7 +4795,8 @@ ChunkManager::ReadChunkDone(ReadOp* op)
         op->status    = -EAGAIN;
         return true;
     }
-    if (mForceVerifyDiskReadChecksumFlag) {
+    if (mForceVerifyDiskReadChecksumFlag || cacheRead) {
+        // Chunk copy content is not verified when the copy is created.
         op->skipVerifyDiskChecksumFlag = false;
     }
 
@@ -4477,13 +4812,17 @@ ChunkManager::ReadChunkDone(ReadOp* op)
         return true;
     }
     // either nothing to verify or it better match
-    bool   mismatchFlag = false;
-    size_t obi          = 0;
+    const KfsChecksumType checksumType      = cih->chunkInfo.GetChecksumType();
+    const uint32_t        nullChecksum      = KfsNullChecksum(checksumType);
+    const uint32_t        nullBlockChecksum = mNullBlockChecksum[checksumType];
+    bool                  mismatchFlag      = false;
+    size_t                obi               = 0;
+    op->checksumType = checksumType;
     if (op->skipVerifyDiskChecksumFlag) {
         // The buffer should always start at the checksum block boundary.
         // AdjustDataRead() below trims the front of the buffer if offset isn't
         // checksum block aligned.
-        op->checksum.resize((size_t)blockCount, mNullBlockChecksum);
+        op->checksum.resize((size_t)blockCount, nullBlockChecksum);
         int len = (int)(op->offset % CHECKSUM_BLOCKSIZE);
         if (len > 0) {
             mCounters.mReadSkipDiskVerifyChecksumByteCount +=
@@ -4492,14 +4831,15 @@ ChunkManager::ReadChunkDone(ReadOp* op)
             IOBuffer::iterator       it  = op->dataBuf.begin();
             int                      el  = (int)CHECKSUM_BLOCKSIZE - len;
             int                      nb  = 0;
-            int32_t                  bcs = kKfsNullChecksum;
+            int32_t                  bcs = nullChecksum;
             for ( ; it != eit; ++it) {
                 nb = it->BytesConsumable();
                 if(nb <= 0) {
                     continue;
                 }
                 const int l = min(nb, len);
-                bcs = ComputeBlockChecksum(bcs, it->Consumer(), (size_t)l);
+                bcs = ComputeBlockChecksum(
+                    bcs, it->Consumer(), (size_t)l, checksumType);
                 nb  -= l;
                 len -= l;
                 if (len <= 0) {
@@ -4514,13 +4854,13 @@ ChunkManager::ReadChunkDone(ReadOp* op)
             const int ml = min(op->numBytesIO, (ssize_t)el);
             el -= ml;
             len = ml;
-            uint32_t mcs = kKfsNullChecksum;
-            uint32_t ecs = kKfsNullChecksum;
+            uint32_t mcs = nullChecksum;
+            uint32_t ecs = nullChecksum;
             uint32_t* ccs = &mcs;
             if (0 < nb) {
                 const int l = min(nb, len);
                 mcs = ComputeBlockChecksum(
-                    mcs, it->Producer() - nb, (size_t)l);
+                    mcs, it->Producer() - nb, (size_t)l, checksumType);
                 len -= l;
                 nb  -= l;
                 if (len <= 0) {
@@ -4530,7 +4870,7 @@ ChunkManager::ReadChunkDone(ReadOp* op)
                 if (0 < nb && 0 < len) {
                     const int l = min(nb, len);
                     ecs = ComputeBlockChecksum(
-                        ecs, it->Producer() - nb, (size_t)l);
+                        ecs, it->Producer() - nb, (size_t)l, checksumType);
                     len -= l;
                 }
             }
@@ -4542,7 +4882,7 @@ ChunkManager::ReadChunkDone(ReadOp* op)
                     }
                     const int l = min(nb, len);
                     *ccs = ComputeBlockChecksum(
-                        *ccs, it->Consumer(), (size_t)l);
+                        *ccs, it->Consumer(), (size_t)l, checksumType);
                     len -= l;
                     nb  -= l;
                     if (len <= 0) {
@@ -4556,7 +4896,7 @@ ChunkManager::ReadChunkDone(ReadOp* op)
                 if (0 < nb) {
                     const int l = min(nb, len);
                     ecs = ComputeBlockChecksum(
-                        ecs, it->Producer() - nb, (size_t)l);
+                        ecs, it->Producer() - nb, (size_t)l, checksumType);
                     len -= l;
                 }
             }
@@ -4565,14 +4905,15 @@ ChunkManager::ReadChunkDone(ReadOp* op)
                 op->status = -EFAULT;
                 return true;
             }
-            uint32_t cs = ChecksumBlocksCombine(bcs, mcs, (size_t)ml);
+            uint32_t cs = ChecksumBlocksCombine(
+                bcs, mcs, (size_t)ml, checksumType);
             if (el > 0) {
-                cs = ChecksumBlocksCombine(cs, ecs, (size_t)el);
+                cs = ChecksumBlocksCombine(cs, ecs, (size_t)el, checksumType);
             }
             const uint32_t hcs =
                 cih->chunkInfo.chunkBlockChecksum[checksumBlock];
             mismatchFlag = cs != hcs && (hcs != 0 ||
-                cs != mNullBlockChecksum || ! mAllowSparseChunksFlag);
+                cs != nullBlockChecksum || ! mAllowSparseChunksFlag);
             if (mismatchFlag) {
                 op->checksum.front() = cs;
             } else {
@@ -4610,14 +4951,14 @@ ChunkManager::ReadChunkDone(ReadOp* op)
             }
             int l = min(len, rem);
             uint32_t cs  = ComputeBlockChecksum(
-                kKfsNullChecksum, it->Producer() - rem, (size_t)l);
+                nullChecksum, it->Producer() - rem, (size_t)l, checksumType);
             rem -= l;
             len -= l;
             uint32_t ecs;
             if (0 < rem) {
                 ecs = cs;
                 cs  = ComputeBlockChecksum(
-                    cs, it->Producer() - rem, (size_t)rem);
+                    cs, it->Producer() - rem, (size_t)rem, checksumType);
                 rem = (int)CHECKSUM_BLOCKSIZE - l - rem;
             } else {
                 rem = (int)CHECKSUM_BLOCKSIZE - l - len;
@@ -4629,14 +4970,15 @@ ChunkManager::ReadChunkDone(ReadOp* op)
                         continue;
                     }
                     l = min(len, nb);
-                    cs = ComputeBlockChecksum(cs, it->Consumer(), (size_t)l);
+                    cs = ComputeBlockChecksum(
+                        cs, it->Consumer(), (size_t)l, checksumType);
                     len -= l;
                     nb  -= l;
                 }
                 ecs = cs;
                 if (0 < nb) {
                     cs = ComputeBlockChecksum(
-                        cs, it->Producer() - nb, (size_t)nb);
+                        cs, it->Producer() - nb, (size_t)nb, checksumType);
                     rem -= nb;
                 }
             }
@@ -4646,7 +4988,8 @@ ChunkManager::ReadChunkDone(ReadOp* op)
                 if (nb <= 0) {
                     continue;
                 }
-                cs = ComputeBlockChecksum(cs, it->Consumer(), (size_t)nb);
+                cs = ComputeBlockChecksum(
+                    cs, it->Consumer(), (size_t)nb, checksumType);
                 rem -= nb;
             }
             if (rem != 0) {
@@ -4657,7 +5000,7 @@ ChunkManager::ReadChunkDone(ReadOp* op)
             const size_t   idx = checksumBlock - obi + blockCount - 1;
             const uint32_t hcs = cih->chunkInfo.chunkBlockChecksum[idx];
             mismatchFlag = cs != hcs && (hcs != 0 ||
-                cs != mNullBlockChecksum || ! mAllowSparseChunksFlag);
+                cs != nullBlockChecksum || ! mAllowSparseChunksFlag);
             if (mismatchFlag) {
                 obi           = blockCount - 1;
                 checksumBlock = idx;
@@ -4675,7 +5018,8 @@ ChunkManager::ReadChunkDone(ReadOp* op)
     } else {
         mCounters.mReadChecksumCount++;
         mCounters.mReadChecksumByteCount += bufSize;
-        op->checksum = ComputeChecksums(&op->dataBuf, bufSize);
+        op->checksum = ComputeChecksums(&op->dataBuf, bufSize, 0,
+            CHECKSUM_BLOCKSIZE, checksumType);
         if ((size_t)blockCount != op->checksum.size()) {
             die("read verify: invalid checksum vector size");
             op->status = -EFAULT;
@@ -4687,7 +5031,7 @@ ChunkManager::ReadChunkDone(ReadOp* op)
         for ( ; obi < (size_t)blockCount; checksumBlock++, obi++) {
             const uint32_t checksum =
                 cih->chunkInfo.chunkBlockChecksum[checksumBlock];
-            if (checksum == 0 && op->checksum[obi] == mNullBlockChecksum &&
+            if (checksum == 0 && op->checksum[obi] == nullBlockChecksum &&
                     mAllowSparseChunksFlag) {
                 KFS_LOG_STREAM_INFO <<
                     " chunk: "      << cih->chunkInfo.chunkId <<
@@ -4707,14 +5051,33 @@ ChunkManager::ReadChunkDone(ReadOp* op)
         }
     }
     if (! mismatchFlag) {
+        if (! op->skipVerifyDiskChecksumFlag && IsBlockCacheable(cih, op)) {
+            // All blocks were verified, add these to the cache. The buffer is
+            // zero padded, the last partial block is cached as well.
+            mBlockCache.Put(cih->chunkInfo.chunkId,
+                cih->chunkInfo.chunkVersion,
+                OffsetToChecksumBlockStart(op->offset), op->dataBuf);
+        }
         // for checksums to verify, we did reads in multiples of
         // checksum block sizes.  so, get rid of the extra
-        cih->ReadStats(op->status, readLen, op->diskIOTime);
+        if (! cacheRead) {
+            cih->ReadStats(op->status, readLen, op->diskIOTime);
+        }
         AdjustDataRead(op);
         return true;
     }
+    if (cacheRead) {
+        KFS_LOG_STREAM_ERROR <<
+            "tier read cache: checksum mismatch"
+            " chunk: "  << op->chunkId <<
+            " offset: " << op->offset <<
+            " bytes: "  << op->numBytesIO <<
+        KFS_LOG_EOM;
+        return RetryTierReadCacheRead(op);
+    }
     const bool retry = op->retryCnt++ < mReadChecksumMismatchMaxRetryCount;
     op->status = -EBADCKSUM;
+    InvalidateReadCaches(cih->chunkInfo.chunkId);
     cih->ReadStats(op->status, readLen, op->diskIOTime);
 
     ostringstream os;
@@ -4940,6 +5303,7 @@ ChunkManager::NotifyMetaChunksLost(
             }
         }
     }
+    mTierReadCache.DirLost(dir.dirname);
     const bool updateFlag = dir.IsCountFsSpaceAvailable();
     dir.Stop();
     if (updateFlag) {
@@ -5075,6 +5439,34 @@ ChunkManager::GetChecksums(kfsChunkId_t chunkId, int64_t chunkVersion,
     ));
 }
 
+vector<uint32_t>
+ChunkManager::GetWriteChecksums(kfsChunkId_t chunkId, int64_t chunkVersion,
+    int64_t offset, size_t numBytes)
+{
+    if (offset < 0) {
+        return vector<uint32_t>();
+    }
+    const bool kAddObjectBlockMappingFlag = false;
+    const ChunkInfoHandle* const cih =
+        GetChunkInfoHandle(chunkId, chunkVersion, kAddObjectBlockMappingFlag);
+    if (! cih) {
+        return vector<uint32_t>();
+    }
+    if (cih->chunkInfo.GetChecksumType() == kKfsChecksumTypeAdler32) {
+        return GetChecksums(chunkId, chunkVersion, offset, numBytes);
+    }
+    if (cih->writeChecksums.empty()) {
+        return vector<uint32_t>();
+    }
+    return (vector<uint32_t>(
+        cih->writeChecksums.begin() + OffsetToChecksumBlockNum(offset),
+        cih->writeChecksums.begin() +
+            min(MAX_CHUNK_CHECKSUM_BLOCKS,
+                OffsetToChecksumBlockNum(
+                    offset + numBytes + CHECKSUM_BLOCKSIZE - 1))
+    ));
+}
+
 DiskIo*
 ChunkManager::SetupDiskIo(ChunkInfoHandle *cih, KfsCallbackObj* op)
 {
@@ -5103,45 +5495,52 @@ ChunkManager::Restart()
 //
 // On a restart, whatever chunks were dirty need to be nuked: we may
 // have had writes pending to them and we never flushed them to disk.
+// The tier read cache chunk copies are removed as well, as the chunks might
+// have changed while the chunk server was down.
 //
 void
 ChunkManager::RemoveDirtyChunks()
 {
+    const int     subDirCount = mTierReadCacheTier != kKfsSTierUndef ? 2 : 1;
+    const string* subDirs[2]  = { &mDirtyChunksDir, &mTierReadCacheDir };
     for (ChunkDirs::iterator it = mChunkDirs.begin();
             it != mChunkDirs.end();
             ++it) {
         if (it->availableSpace < 0) {
             continue;
         }
-        const string dir = it->dirname + mDirtyChunksDir;
-        DIR* const dirStream = opendir(dir.c_str());
-        if (! dirStream) {
-            const int err = errno;
-            KFS_LOG_STREAM_ERROR <<
-                "unable to open " << dir <<
-                " error: " << QCUtils::SysError(err) <<
-                KFS_LOG_EOM;
-            continue;
-        }
-        struct dirent const* dent;
-        while ((dent = readdir(dirStream))) {
-            const string name = dir + dent->d_name;
-            struct stat buf;
-            if (stat(name.c_str(), &buf) || ! S_ISREG(buf.st_mode)) {
-                continue;
-            }
-            KFS_LOG_STREAM_INFO <<
-                "cleaning out dirty chunk: " << name <<
-            KFS_LOG_EOM;
-            if (unlink(name.c_str())) {
+        for (int i = 0; i < subDirCount; i++) {
+            const string dir = it->dirname + *subDirs[i];
+            DIR* const dirStream = opendir(dir.c_str());
+            if (! dirStream) {
                 const int err = errno;
                 KFS_LOG_STREAM_ERROR <<
-                    "unable to remove " << name <<
+                    "unable to open " << dir <<
                     " error: " << QCUtils::SysError(err) <<
+                    KFS_LOG_EOM;
+                continue;
+            }
+            struct dirent const* dent;
+            while ((dent = readdir(dirStream))) {
+                const string name = dir + dent->d_name;
+                struct stat buf;
+                if (stat(name.c_str(), &buf) || ! S_ISREG(buf.st_mode)) {
+                    continue;
+                }
+                KFS_LOG_STREAM_INFO <<
+                    "cleaning out " <<
+                    (i == 0 ? "dirty chunk: " : "chunk copy: ") << name <<
                 KFS_LOG_EOM;
+                if (unlink(name.c_str())) {
+                    const int err = errno;
+                    KFS_LOG_STREAM_ERROR <<
+                        "unable to remove " << name <<
+                        " error: " << QCUtils::SysError(err) <<
+                    KFS_LOG_EOM;
+                }
             }
+            closedir(dirStream);
         }
-        closedir(dirStream);
     }
 }
 
@@ -5551,6 +5950,8 @@ ChunkManager::Timeout()
         SendChunkDirInfo();
         mNextSendChunDirInfoTime = now + mSendChunDirInfoIntervalSecs;
     }
+    mBlockCache.Shrink();
+    mTierReadCache.Timeout(now);
     gLeaseClerk.Timeout();
     gAtomicRecordAppendManager.Timeout();
 }
@@ -5751,6 +6152,9 @@ ChunkManager::StartDiskIo()
     }
     mDirChecker.AddSubDir(mStaleChunksDir, mForceDeleteStaleChunksFlag);
     mDirChecker.AddSubDir(mDirtyChunksDir, true);
+    if (mTierReadCacheTier != kKfsSTierUndef) {
+        mDirChecker.AddSubDir(mTierReadCacheDir, true);
+    }
     mDirChecker.SetIoTimeout(-1); // Turn off on startup.
     DirChecker::DirsAvailable dirs;
     mDirChecker.Start(dirs);
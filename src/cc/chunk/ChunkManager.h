@@ -33,6 +33,8 @@
 #include "KfsOps.h"
 #include "DiskIo.h"
 #include "DirChecker.h"
+#include "ChunkBlockCache.h"
+#include "TierReadCache.h"
 
 #include "kfsio/ITimeout.h"
 #include "kfsio/CryptoKeys.h"
@@ -91,6 +93,20 @@ public:
         Counter mReadSkipDiskVerifyErrorCount;
         Counter mReadSkipDiskVerifyByteCount;
         Counter mReadSkipDiskVerifyChecksumByteCount;
+        Counter mReadSendFileCount;
+        Counter mReadSendFileByteCount;
+        Counter mReadBlockCacheHitCount;
+        Counter mReadBlockCacheHitByteCount;
+        Counter mReadBlockCacheMissCount;
+        Counter mReadBlockCacheByteCount;
+        Counter mTierReadCacheHitCount;
+        Counter mTierReadCacheHitByteCount;
+        Counter mTierReadCacheMissCount;
+        Counter mTierReadCacheRetryCount;
+        Counter mTierReadCacheAdmitCount;
+        Counter mTierReadCacheCopyErrorCount;
+        Counter mTierReadCacheEvictCount;
+        Counter mTierReadCacheByteCount;
 
         void Clear()
         {
@@ -109,6 +125,20 @@ public:
             mReadSkipDiskVerifyErrorCount        = 0;
             mReadSkipDiskVerifyByteCount         = 0;
             mReadSkipDiskVerifyChecksumByteCount = 0;
+            mReadSendFileCount                   = 0;
+            mReadSendFileByteCount               = 0;
+            mReadBlockCacheHitCount              = 0;
+            mReadBlockCacheHitByteCount          = 0;
+            mReadBlockCacheMissCount             = 0;
+            mReadBlockCacheByteCount             = 0;
+            mTierReadCacheHitCount               = 0;
+            mTierReadCacheHitByteCount           = 0;
+            mTierReadCacheMissCount              = 0;
+            mTierReadCacheRetryCount             = 0;
+            mTierReadCacheAdmitCount             = 0;
+            mTierReadCacheCopyErrorCount         = 0;
+            mTierReadCacheEvictCount             = 0;
+            mTierReadCacheByteCount              = 0;
         }
     };
 
@@ -212,14 +242,28 @@ public:
     vector<uint32_t> GetChecksums(kfsChunkId_t chunkId,
         int64_t chunkVersion, int64_t offset, size_t numBytes);
 
+    /// Given a byte range, return the adler32 checksums of the blocks in
+    /// that range, that the write protocol uses. For chunks with different
+    /// block checksums algorithm these are the checksums of the blocks
+    /// written since the chunk became writable, or empty vector if none.
+    vector<uint32_t> GetWriteChecksums(kfsChunkId_t chunkId,
+        int64_t chunkVersion, int64_t offset, size_t numBytes);
+
+    /// Block checksums algorithm for new chunks.
+    KfsChecksumType GetChecksumType() const
+        { return mChecksumType; }
+
     /// For telemetry purposes, provide the driveName where the chunk
     /// is stored and pass that back to the client.
     string GetDirName(chunkId_t chunkId, int64_t chunkVersion) const;
 
     /// Schedule a read on a chunk.
     /// @param[in] op  The read operation being scheduled.
+    /// @param[in] useReadCacheFlag  complete the read from the block cache,
+    /// without queueing disk io, if all requested blocks are in the cache,
+    /// or read from the fast storage tier chunk copy, if one exists.
     /// @retval 0 if op was successfully scheduled; -1 otherwise
-    int ReadChunk(ReadOp *op);
+    int ReadChunk(ReadOp *op, bool useReadCacheFlag = false);
 
     /// Schedule a write on a chunk.
     /// @param[in] op  The write operation being scheduled.
@@ -243,6 +287,10 @@ public:
     /// @param[in] op  The write op that just finished
     ///
     bool ReadChunkDone(ReadOp *op);
+    /// Discard fast storage tier chunk copy that the read failed to use, and
+    /// re-schedule the read with the chunk file.
+    /// @retval false if the read was re-scheduled
+    bool RetryTierReadCacheRead(ReadOp *op);
     void ReplicationDone(kfsChunkId_t chunkId, int status,
         const DiskIo::FilePtr& filePtr);
     /// Determine the size of a chunk.
@@ -347,7 +395,15 @@ public:
     inline void UpdateStale(ChunkInfoHandle& cih);
 
     void GetCounters(Counters& counters)
-        { counters = mCounters; }
+    {
+        counters = mCounters;
+        counters.mReadBlockCacheByteCount = mBlockCache.GetSize();
+        const TierReadCache::Counters& tc = mTierReadCache.GetCounters();
+        counters.mTierReadCacheAdmitCount     = tc.mAdmitCount;
+        counters.mTierReadCacheCopyErrorCount = tc.mCopyErrorCount;
+        counters.mTierReadCacheEvictCount     = tc.mEvictCount;
+        counters.mTierReadCacheByteCount      = mTierReadCache.GetSize();
+    }
 
     /// Utility function that sets up a disk connection for an
     /// I/O operation on a chunk.
@@ -898,7 +954,13 @@ private:
     int64_t mCheckDirTestWriteSize;
     string mCheckDirWritableTmpFileName;
 
-    uint32_t mNullBlockChecksum;
+    KfsChecksumType mChecksumType;
+    uint32_t        mNullBlockChecksum[kKfsChecksumTypeCount];
+    ChunkBlockCache mBlockCache;
+    TierReadCache   mTierReadCache;
+    kfsSTier_t      mTierReadCacheTier;
+    string          mTierReadCacheDir;
+    uint64_t        mTierReadCacheFileSeq;
 
     Counters   mCounters;
     DirChecker mDirChecker;
@@ -950,6 +1012,13 @@ private:
 
     inline void Delete(ChunkInfoHandle& cih);
     inline void Release(ChunkInfoHandle& cih);
+    inline bool IsBlockCacheable(
+        const ChunkInfoHandle* cih, const ReadOp* op) const;
+    inline bool IsTierReadCacheable(
+        const ChunkInfoHandle* cih, const ReadOp* op) const;
+    inline void InvalidateReadCaches(kfsChunkId_t chunkId);
+    void AddToTierReadCache(ChunkInfoHandle* cih);
+    bool SendFileRead(ChunkInfoHandle* cih, ReadOp* op);
 
     /// When a checkpoint file is read, update the mChunkTable[] to
     /// include a mapping for cih->chunkInfo.chunkId.
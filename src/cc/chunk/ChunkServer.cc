@@ -51,7 +51,8 @@ ChunkServer::Init(
     bool                  ipV6OnlyFlag,
     const string&         serverIp,
     int                   threadCount,
-    int                   firstCpuIdx)
+    int                   firstCpuIdx,
+    bool                  reusePortFlag)
 {
     if (clientListener.port < 0) {
         KFS_LOG_STREAM_FATAL <<
@@ -90,6 +91,7 @@ ChunkServer::Init(
                 ipV6OnlyFlag,
                 threadCount,
                 firstCpuIdx,
+                reusePortFlag,
                 mMutex) ||
             gClientManager.GetPort() <= 0) {
         KFS_LOG_STREAM_FATAL <<
@@ -34,6 +34,7 @@
 #include "kfsio/SslFilter.h"
 #include "kfsio/DelegationToken.h"
 #include "kfsio/Globals.h"
+#include "kfsio/TcpSocket.h"
 
 #include "qcdio/QCUtils.h"
 #include "qcdio/qcdebug.h"
@@ -175,6 +176,51 @@ private:
         const Auth& inAuth);
 };
 
+// Per client thread acceptor, used with SO_REUSEPORT in order to let the
+// kernel distribute connections between client threads.
+class ClientManager::ThreadAcceptor : public IAcceptorOwner
+{
+public:
+    ThreadAcceptor(
+        ClientManager&        inManager,
+        ClientThread&         inThread,
+        const ServerLocation& inLocation,
+        bool                  inIpV6OnlyFlag,
+        int                   inCpuIdx)
+        : IAcceptorOwner(),
+          mManager(inManager),
+          mThread(inThread),
+          mAcceptor(
+            inThread.GetNetManager(),
+            inLocation,
+            inIpV6OnlyFlag,
+            this,
+            kBindOnlyFlag,
+            kReusePortFlag,
+            inCpuIdx)
+        {}
+    virtual KfsCallbackObj* CreateKfsCallbackObj(
+        NetConnectionPtr& inConnPtr)
+    {
+        ClientThread::StMutexLocker theLocker(&mThread);
+        return mManager.AcceptClient(inConnPtr, &mThread);
+    }
+    Acceptor& GetAcceptor()
+        { return mAcceptor; }
+private:
+    static const bool kBindOnlyFlag  = true;
+    static const bool kReusePortFlag = true;
+
+    ClientManager& mManager;
+    ClientThread&  mThread;
+    Acceptor       mAcceptor;
+private:
+    ThreadAcceptor(
+        const ThreadAcceptor& inAcceptor);
+    ThreadAcceptor& operator=(
+        const ThreadAcceptor& inAcceptor);
+};
+
 ClientManager gClientManager;
 
 ClientManager::ClientManager()
@@ -187,16 +233,25 @@ ClientManager::ClientManager()
       mCurThreadIdx(0),
       mFirstClientThreadIndex(0),
       mThreadCount(0),
-      mThreadsPtr(0)
+      mThreadsPtr(0),
+      mSendFileFlag(false),
+      mZeroCopyMinSize(0),
+      mIpV6OnlyFlag(false),
+      mReusePortFlag(false),
+      mFirstCpuIdx(-1),
+      mThreadClientCountsPtr(0),
+      mThreadAcceptorsPtr(0)
 {
     mCounters.Clear();
 }
 
 ClientManager::~ClientManager()
 {
+    DeleteThreadAcceptors();
     delete mAcceptorPtr;
     delete &mAuth;
     delete [] mThreadsPtr;
+    delete [] mThreadClientCountsPtr;
     KfsOp::SetMutex(0);
 }
 
@@ -206,14 +261,24 @@ ClientManager::BindAcceptor(
     bool                  ipV6OnlyFlag,
     int                   inThreadCount,
     int                   inFirstCpuIdx,
+    bool                  inReusePortFlag,
     QCMutex*&             outMutexPtr)
 {
     Stop();
+    DeleteThreadAcceptors();
     delete mAcceptorPtr;
     delete [] mThreadsPtr;
-    mAcceptorPtr = 0;
-    mThreadsPtr  = 0;
-    mThreadCount = 0;
+    delete [] mThreadClientCountsPtr;
+    mAcceptorPtr           = 0;
+    mThreadsPtr            = 0;
+    mThreadClientCountsPtr = 0;
+    mThreadCount           = 0;
+    mIpV6OnlyFlag          = ipV6OnlyFlag;
+    mFirstCpuIdx           = inFirstCpuIdx;
+    // The main acceptor listens only if the client thread acceptors cannot
+    // be started. It is bound without SO_REUSEPORT, in order to fail if
+    // another process is already listening on the port.
+    mReusePortFlag         = inReusePortFlag && 0 < inThreadCount;
     const bool kBindOnlyFlag = true;
     mAcceptorPtr = new Acceptor(
         globalNetManager(), clientListener, ipV6OnlyFlag, this, kBindOnlyFlag);
@@ -224,6 +289,12 @@ ClientManager::BindAcceptor(
         mThreadsPtr  = ClientThread::CreateThreads(
             inThreadCount, inFirstCpuIdx, outMutexPtr);
         mThreadCount = mThreadsPtr ? inThreadCount : 0;
+        if (0 < mThreadCount) {
+            mThreadClientCountsPtr = new int[mThreadCount];
+            for (int i = 0; i < mThreadCount; i++) {
+                mThreadClientCountsPtr[i] = 0;
+            }
+        }
     } else {
         outMutexPtr = 0;
     }
@@ -236,10 +307,105 @@ ClientManager::StartListening()
     if (! mAcceptorPtr) {
         return false;
     }
+    if (mReusePortFlag) {
+        if (! IsPortAvailable()) {
+            return false;
+        }
+        if (StartThreadAcceptors()) {
+            return true;
+        }
+    }
     mAcceptorPtr->StartListening();
     return mAcceptorPtr->IsAcceptorStarted();
 }
 
+    bool
+ClientManager::IsPortAvailable() const
+{
+    // SO_REUSEPORT lets another process running as the same user listen on
+    // the same port. Listen without SO_REUSEPORT first, in order to fail the
+    // same way as the main acceptor would if another chunk server has
+    // started listening on the port since the acceptor was bound.
+    const ServerLocation& theLocation = mAcceptorPtr->GetLocation();
+    TcpSocket             theSocket;
+    int                   theRet      = theSocket.Bind(
+        theLocation,
+        (theLocation.hostname.empty() && mIpV6OnlyFlag) ?
+            TcpSocket::kTypeIpV6 : TcpSocket::kTypeIpV4,
+        mIpV6OnlyFlag
+    );
+    if (0 <= theRet) {
+        const bool kNonBlockingAcceptFlag = true;
+        theRet = theSocket.StartListening(kNonBlockingAcceptFlag, 1);
+    }
+    theSocket.Close();
+    if (theRet < 0) {
+        KFS_LOG_STREAM_ERROR <<
+            "client listener port: " << theLocation <<
+            " is not available: " << QCUtils::SysError(-theRet) <<
+        KFS_LOG_EOM;
+        return false;
+    }
+    return true;
+}
+
+    bool
+ClientManager::StartThreadAcceptors()
+{
+    DeleteThreadAcceptors();
+    const int theStart = max(mFirstClientThreadIndex, 0);
+    if (mThreadCount <= theStart) {
+        return false;
+    }
+    mThreadAcceptorsPtr = new ThreadAcceptor*[mThreadCount];
+    for (int i = 0; i < mThreadCount; i++) {
+        mThreadAcceptorsPtr[i] = 0;
+    }
+    for (int i = theStart; i < mThreadCount; i++) {
+        ThreadAcceptor* const thePtr = new ThreadAcceptor(
+            *this,
+            mThreadsPtr[i],
+            mAcceptorPtr->GetLocation(),
+            mIpV6OnlyFlag,
+            mFirstCpuIdx < 0 ? -1 : mFirstCpuIdx + i
+        );
+        mThreadAcceptorsPtr[i] = thePtr;
+        if (! thePtr->GetAcceptor().IsAcceptorStarted()) {
+            KFS_LOG_STREAM_ERROR <<
+                "failed to bind client thread " << i <<
+                " acceptor to: " << mAcceptorPtr->GetLocation() <<
+                " using main thread acceptor" <<
+            KFS_LOG_EOM;
+            DeleteThreadAcceptors();
+            return false;
+        }
+    }
+    for (int i = theStart; i < mThreadCount; i++) {
+        mThreadsPtr[i].StartListening(mThreadAcceptorsPtr[i]->GetAcceptor());
+    }
+    KFS_LOG_STREAM_INFO <<
+        "started " << (mThreadCount - theStart) <<
+        " client thread acceptors on: " << mAcceptorPtr->GetLocation() <<
+    KFS_LOG_EOM;
+    return true;
+}
+
+    void
+ClientManager::DeleteThreadAcceptors()
+{
+    if (! mThreadAcceptorsPtr) {
+        return;
+    }
+    // Must be invoked with client threads stopped, or prior to start
+    // listening, as the acceptors' connections belong to the client threads'
+    // net managers.
+    for (int i = 0; i < mThreadCount; i++) {
+        delete mThreadAcceptorsPtr[i];
+    }
+    delete [] mThreadAcceptorsPtr;
+    mThreadAcceptorsPtr = 0;
+}
+
     void
 ClientManager::Stop()
 {
@@ -249,6 +415,14 @@ ClientManager::Stop()
     /* virtual */ KfsCallbackObj*
 ClientManager::CreateKfsCallbackObj(
     NetConnectionPtr& inConnPtr)
+{
+    return AcceptClient(inConnPtr, 0);
+}
+
+    KfsCallbackObj*
+ClientManager::AcceptClient(
+    NetConnectionPtr& inConnPtr,
+    ClientThread*     inAcceptThreadPtr)
 {
     if (! inConnPtr || ! inConnPtr->IsGood()) {
         return 0;
@@ -265,19 +439,44 @@ ClientManager::CreateKfsCallbackObj(
     }
     mCounters.mAcceptCount++;
     mCounters.mClientCount++;
-    ClientThread* const theThreadPtr = GetNextClientThreadPtr();
-    ClientSM*     const theClientPtr = new ClientSM(inConnPtr, theThreadPtr);
+    ClientThread* const theThreadPtr = inAcceptThreadPtr ?
+        inAcceptThreadPtr :
+        GetNextClientThreadPtr(0 <= mFirstCpuIdx ?
+            inConnPtr->GetIncomingCpu() : -1);
+    if (theThreadPtr) {
+        mThreadClientCountsPtr[theThreadPtr - mThreadsPtr]++;
+    }
+    ClientSM* const theClientPtr = new ClientSM(inConnPtr, theThreadPtr);
     if (! mAuth.Setup(*inConnPtr, *theClientPtr)) {
         delete theClientPtr;
         return 0;
     }
-    if (theThreadPtr) {
+    if (theThreadPtr && ! inAcceptThreadPtr) {
         inConnPtr.reset(); // Thread takes ownership.
         theThreadPtr->Add(*theClientPtr);
     }
+    // With thread acceptor the acceptor adds connection to the thread's net
+    // manager.
     return theClientPtr;
 }
 
+    void
+ClientManager::Remove(
+    ClientSM* inClientPtr)
+{
+    assert(mCounters.mClientCount > 0);
+    mCounters.mClientCount--;
+    ClientThread* const theThreadPtr =
+        inClientPtr ? inClientPtr->GetClientThread() : 0;
+    if (theThreadPtr && mThreadClientCountsPtr) {
+        const int theIdx = (int)(theThreadPtr - mThreadsPtr);
+        if (0 <= theIdx && theIdx < mThreadCount &&
+                0 < mThreadClientCountsPtr[theIdx]) {
+            mThreadClientCountsPtr[theIdx]--;
+        }
+    }
+}
+
     bool
 ClientManager::SetParameters(
     const char*       inParamsPrefixPtr,
@@ -298,6 +497,12 @@ ClientManager::SetParameters(
     mFirstClientThreadIndex =
         inProps.getValue(theParamName.Truncate(thePrefLen).Append(
         "firstClientThreadIndex"), mFirstClientThreadIndex);
+    mSendFileFlag = NetConnection::IsSendFileSupported() &&
+        inProps.getValue(theParamName.Truncate(thePrefLen).Append(
+        "sendFile"), mSendFileFlag ? 1 : 0) != 0;
+    mZeroCopyMinSize = inProps.getValue(
+        theParamName.Truncate(thePrefLen).Append(
+        "zeroCopyMinSize"), mZeroCopyMinSize);
     mMaxClientCount = inMaxClientCount;
     return mAuth.SetParameters(
         theParamName.Truncate(thePrefLen).Append("auth.").GetPtr(),
@@ -330,6 +535,7 @@ ClientManager::Shutdown()
 {
     Stop();
     KfsOp::SetMutex(0);
+    DeleteThreadAcceptors();
     delete mAcceptorPtr;
     mAcceptorPtr = 0;
     mAuth.Clear();
@@ -345,18 +551,42 @@ ClientManager::GetCurrentClientThreadPtr()
 }
 
     ClientThread*
-ClientManager::GetNextClientThreadPtr()
+ClientManager::GetNextClientThreadPtr(
+    int inIncomingCpu)
 {
     if (mThreadCount <= 0 || mThreadCount <= mFirstClientThreadIndex) {
         return 0;
     }
-    QCASSERT(0 <= mCurThreadIdx && mCurThreadIdx < mThreadCount);
-    ClientThread* const theRetPtr = mThreadsPtr + mCurThreadIdx;
-    mCurThreadIdx++;
+    const int theStart = max(mFirstClientThreadIndex, 0);
+    const int theCount = mThreadCount - theStart;
+    if (mCurThreadIdx < theStart || mThreadCount <= mCurThreadIdx) {
+        mCurThreadIdx = theStart;
+    }
+    // Pick the thread with the least number of clients, the round robin
+    // position breaks ties.
+    int theIdx = mCurThreadIdx;
+    for (int i = 1; i < theCount; i++) {
+        const int theCur = theStart + (mCurThreadIdx - theStart + i) % theCount;
+        if (mThreadClientCountsPtr[theCur] < mThreadClientCountsPtr[theIdx]) {
+            theIdx = theCur;
+        }
+    }
+    // Prefer the thread with affinity to the cpu that received the connection,
+    // unless the thread is noticeably more loaded.
+    if (0 <= inIncomingCpu && 0 <= mFirstCpuIdx) {
+        const int theCpuIdx = inIncomingCpu - mFirstCpuIdx;
+        if (theStart <= theCpuIdx && theCpuIdx < mThreadCount) {
+            const int theMin = mThreadClientCountsPtr[theIdx];
+            if (mThreadClientCountsPtr[theCpuIdx] <= theMin + 4 + theMin / 8) {
+                theIdx = theCpuIdx;
+            }
+        }
+    }
+    mCurThreadIdx = theIdx + 1;
     if (mThreadCount <= mCurThreadIdx) {
-        mCurThreadIdx = max(mFirstClientThreadIndex, 0);
+        mCurThreadIdx = theStart;
     }
-    return theRetPtr;
+    return (mThreadsPtr + theIdx);
 }
 
     ClientThread*
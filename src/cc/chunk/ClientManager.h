@@ -108,6 +108,7 @@ public:
         bool                  ipV6OnlyFlag,
         int                   inThreadCount,
         int                   inFirstCpuIdx,
+        bool                  inReusePortFlag,
         QCMutex*&             outMutexPtr);
     bool StartListening();
     virtual KfsCallbackObj* CreateKfsCallbackObj(
@@ -126,11 +127,7 @@ public:
         { return (mAcceptorPtr ? mAcceptorPtr->GetPort() : -1); }
     void Stop();
     void Remove(
-        ClientSM* /* inClientPtr */)
-    {
-        assert(mCounters.mClientCount > 0);
-        mCounters.mClientCount--;
-    }
+        ClientSM* inClientPtr);
     void BadRequest()
         { mCounters.mBadRequestCount++; }
     void BadRequestHeader()
@@ -207,7 +204,8 @@ public:
         { return mThreadCount; }
     const QCMutex* GetMutexPtr() const;
     ClientThread* GetCurrentClientThreadPtr();
-    ClientThread* GetNextClientThreadPtr();
+    ClientThread* GetNextClientThreadPtr(
+        int inIncomingCpu = -1);
     ClientThread* GetClientThread(
         int inIdx);
     bool IsAuthEnabled() const;
@@ -219,8 +217,13 @@ public:
     void Shutdown();
     int GetMaxClientCount() const
         { return mMaxClientCount; }
+    bool IsSendFileEnabled() const
+        { return mSendFileFlag; }
+    int GetZeroCopyMinSize() const
+        { return mZeroCopyMinSize; }
 private:
     class Auth;
+    class ThreadAcceptor;
 
     Acceptor*     mAcceptorPtr;
     int           mIoTimeoutSec;
@@ -232,6 +235,20 @@ private:
     int           mFirstClientThreadIndex;
     int           mThreadCount;
     ClientThread* mThreadsPtr;
+    bool          mSendFileFlag;
+    int           mZeroCopyMinSize;
+    bool          mIpV6OnlyFlag;
+    bool          mReusePortFlag;
+    int           mFirstCpuIdx;
+    int*          mThreadClientCountsPtr;
+    ThreadAcceptor** mThreadAcceptorsPtr;
+
+    KfsCallbackObj* AcceptClient(
+        NetConnectionPtr& inConnPtr,
+        ClientThread*     inAcceptThreadPtr);
+    bool IsPortAvailable() const;
+    bool StartThreadAcceptors();
+    void DeleteThreadAcceptors();
 
 private:
     // No copy.
@@ -33,6 +33,7 @@
 #include "AtomicRecordAppender.h"
 #include "DiskIo.h"
 #include "ClientManager.h"
+#include "Replicator.h"
 
 #include "common/MsgLogger.h"
 #include "common/time.h"
@@ -132,15 +133,23 @@ ClientSM::PutAndResetDevBufferManager(KfsOp& op, ByteCount opBytes)
     }
 }
 
+inline ClientSM::ByteCount
+ClientSM::GetNumBytesToWrite() const
+{
+    // Buffers sent with zero copy remain in use until the kernel releases
+    // them, count these against the buffer quota until then.
+    return (mNetConnection->GetNumBytesToWrite() +
+        mNetConnection->GetNumBytesPinned());
+}
+
 inline void
 ClientSM::SendResponse(KfsOp& op)
 {
-    ByteCount       respBytes = mNetConnection->GetNumBytesToWrite();
+    ByteCount       respBytes = GetNumBytesToWrite();
     const ByteCount opBytes   = op.bufferBytes.mCount;
     SendResponseSelf(op);
-    respBytes = max(ByteCount(0),
-        mNetConnection->GetNumBytesToWrite() - respBytes);
-    mPrevNumToWrite = mNetConnection->GetNumBytesToWrite();
+    respBytes = max(ByteCount(0), GetNumBytesToWrite() - respBytes);
+    mPrevNumToWrite = GetNumBytesToWrite();
     PutAndResetDevBufferManager(op, opBytes);
     GetBufferManager().Put(*this, opBytes - respBytes);
 }
@@ -221,6 +230,9 @@ ClientSM::ClientSM(
     }
     mNetConnection->SetMaxReadAhead(sMaxCmdHeaderReadAhead);
     mNetConnection->SetInactivityTimeout(gClientManager.GetIdleTimeoutSec());
+    if (0 < gClientManager.GetZeroCopyMinSize()) {
+        mNetConnection->SetZeroCopy(gClientManager.GetZeroCopyMinSize());
+    }
     SetReceiveOp();
 }
 
@@ -289,6 +301,26 @@ ClientSM::SendResponseSelf(KfsOp& op)
     IOBuffer* iobuf = 0;
     int       len   = 0;
     op.ResponseContent(iobuf, len);
+    if (0 < len && op.op == CMD_READ && mNetConnection->IsDirectWrite()) {
+        ReadOp& rop = static_cast<ReadOp&>(op);
+        if (0 <= rop.sendFileFd && mNetConnection->WriteFile(
+                rop.sendFileFd, rop.sendFileOffset, len)) {
+            // The connection owns the file descriptor now.
+            rop.sendFileFd = -1;
+            iobuf->Clear();
+            len = 0;
+        }
+        rop.ReleaseSendFileFd();
+        if (iobuf->BytesConsumable() < len) {
+            // The disk read was skipped, and the data can not be sent.
+            CLIENT_SM_LOG_STREAM_ERROR <<
+                "sendfile failure, closing connection " << op.Show() <<
+            KFS_LOG_EOM;
+            mNetConnection->Close();
+            gClientManager.RequestDone(timespent, op);
+            return;
+        }
+    }
     mNetConnection->Write(iobuf, len);
     gClientManager.RequestDone(timespent, op);
 }
@@ -372,7 +404,7 @@ ClientSM::HandleRequest(int code, void* data)
     }
 
     case EVENT_NET_WROTE: {
-        const int rem = mNetConnection->GetNumBytesToWrite();
+        const ByteCount rem = GetNumBytesToWrite();
         GetBufferManager().Put(*this, mPrevNumToWrite - rem);
         mPrevNumToWrite = rem;
         break;
@@ -1069,6 +1101,10 @@ ClientSM::HandleClientCmd(IOBuffer& iobuf, int inCmdLen)
     op->clientSMFlag       = true;
     op->clnt               = this;
     op->bufferBytes.mCount = bufferBytes;
+    if (op->op == CMD_READ && mNetConnection->IsDirectWrite() &&
+            gClientManager.IsSendFileEnabled()) {
+        static_cast<ReadOp*>(op)->sendFileFlag = true;
+    }
     if (op->op == CMD_WRITE_SYNC) {
         // make the write sync depend on a previous write
         if (! mOps.empty()) {
@@ -1421,4 +1457,45 @@ ClientSM::CheckAccess(ChunkAccessRequestOp& op)
     return true;
 }
 
+bool
+ClientSM::CheckAccess(ReadOp& op)
+{
+    KfsClientChunkOp& chunkOp = op;
+    if (! CheckAccess(chunkOp)) {
+        return false;
+    }
+    if (op.repairChain.empty()) {
+        return true;
+    }
+    // The pipelined recovery chain makes this chunk server connect to the
+    // next hop. Accept it only from the chunk servers, and only with the next
+    // hops that are chunk servers known to the meta server.
+    ServerLocation peer;
+    if (IsAccessEnforced()) {
+        if ((mDelegationToken.GetFlags() &
+                DelegationToken::kChunkServerFlag) == 0) {
+            op.statusMsg = "repair chain: requestor is not chunk server";
+            op.status    = -EPERM;
+            return false;
+        }
+    } else if (! mNetConnection ||
+            mNetConnection->GetPeerLocation(peer) != 0 ||
+            ! peer.IsValid()) {
+        op.statusMsg = "repair chain: no requestor address";
+        op.status    = -EPERM;
+        return false;
+    }
+    if (! Replicator::IsRepairChainAllowed(op.repairChain,
+            IsAccessEnforced() ? 0 : &peer.hostname, op.statusMsg)) {
+        CLIENT_SM_LOG_STREAM_ERROR <<
+            op.statusMsg <<
+            " chain: " << op.repairChain <<
+            " "        << op.Show() <<
+        KFS_LOG_EOM;
+        op.status = -EPERM;
+        return false;
+    }
+    return true;
+}
+
 }
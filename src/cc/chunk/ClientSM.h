@@ -64,6 +64,9 @@ class Properties;
 class ClientThread;
 class ClientThreadListEntry
 {
+public:
+    ClientThread* GetClientThread() const
+        { return mClientThreadPtr; }
 private:
     enum {
         kDispatchQueueIdx   = 0,
@@ -248,6 +251,7 @@ public:
     bool CheckAccess(KfsOp& op);
     bool CheckAccess(KfsClientChunkOp& op);
     bool CheckAccess(ChunkAccessRequestOp& op);
+    bool CheckAccess(ReadOp& op);
     const DelegationToken& GetDelegationToken() const
         { return mDelegationToken; }
     const string& GetSessionKey() const
@@ -413,6 +417,7 @@ private:
     int HandleRequestSelf(int code, void* data);
     int HandleGranted();
     inline time_t TimeNow() const;
+    inline ByteCount GetNumBytesToWrite() const;
     inline void SendResponse(KfsOp& op);
     inline static BufferManager& GetBufferManager();
     inline static BufferManager* FindDevBufferManager(KfsOp& op);
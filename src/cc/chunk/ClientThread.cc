@@ -37,6 +37,7 @@
 #include "qcdio/qcdebug.h"
 
 #include "kfsio/NetManager.h"
+#include "kfsio/Acceptor.h"
 #include "kfsio/IOBuffer.h"
 #include "kfsio/Globals.h"
 #include "kfsio/checksum.h"
@@ -176,6 +177,7 @@ public:
           mTmpDispatchQueue(),
           mTmpSyncSMQueue(),
           mTmpRSReplicatorQueue(),
+          mPendingAcceptors(),
           mWakeupCnt(0),
           mOuter(inOuter)
     {
@@ -206,6 +208,13 @@ public:
             Wakeup();
         }
     }
+    void StartListening(
+        Acceptor& inAcceptor)
+    {
+        QCASSERT(GetMutex().IsOwned());
+        mPendingAcceptors.push_back(&inAcceptor);
+        Wakeup();
+    }
     void Enqueue(
         RSReplicatorEntry& inEntry)
     {
@@ -288,6 +297,20 @@ public:
                 mNetManager.AddConnection(theConnPtr);
             }
         }
+        while (! mPendingAcceptors.empty()) {
+            Acceptor& theAcceptor = *mPendingAcceptors.back();
+            mPendingAcceptors.pop_back();
+            if (mShutdownFlag || ! mRunFlag) {
+                continue;
+            }
+            theAcceptor.StartListening();
+            if (! theAcceptor.IsAcceptorStarted()) {
+                KFS_LOG_STREAM_ERROR <<
+                    "client thread: failed to start acceptor on: " <<
+                        theAcceptor.GetLocation() <<
+                KFS_LOG_EOM;
+            }
+        }
         if (! mRunFlag && ! mShutdownFlag) {
             mNetManager.Shutdown();
         }
@@ -501,6 +524,7 @@ private:
     typedef vector<ClientSM*>                    TmpDispatchQueue;
     typedef vector<RemoteSyncSM*>                TmpSyncSMQueue;
     typedef vector<RSReplicatorEntry*>           TmpRSReplicatorQueue;
+    typedef vector<Acceptor*>                    PendingAcceptors;
     enum { kDispatchQueueCount = ClientThreadListEntry::kDispatchQueueCount };
 
     QCThread               mThread;
@@ -512,6 +536,7 @@ private:
     TmpDispatchQueue       mTmpDispatchQueue;
     TmpSyncSMQueue         mTmpSyncSMQueue;
     TmpRSReplicatorQueue   mTmpRSReplicatorQueue;
+    PendingAcceptors       mPendingAcceptors;
     volatile int           mWakeupCnt;
     ClientThread&          mOuter;
     ClientThreadListEntry* mAddQueuePtr[kDispatchQueueCount];
@@ -817,6 +842,13 @@ ClientThread::Add(
     mImpl.Add(inClient);
 }
 
+    void
+ClientThread::StartListening(
+    Acceptor& inAcceptor)
+{
+    mImpl.StartListening(inAcceptor);
+}
+
     NetManager&
 ClientThread::GetNetManager()
 {
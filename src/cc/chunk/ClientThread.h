@@ -33,6 +33,7 @@ namespace KFS
 {
 
 class ClientSM;
+class Acceptor;
 class RemoteSyncSM;
 class NetManager;
 class RemoteSyncSM;
@@ -76,6 +77,9 @@ public:
     ~ClientThread();
     void Add(
         ClientSM& inClient);
+    // Start listening and accepting connections in this thread.
+    void StartListening(
+        Acceptor& inAcceptor);
     NetManager& GetNetManager();
     void Lock();
     void Unlock();
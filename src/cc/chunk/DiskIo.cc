@@ -323,6 +323,8 @@ public:
     void SetParameters(
         const Properties& inProperties)
     {
+        SetPriorityParameters(inProperties);
+        SetWriteCoalescingParameters(inProperties);
         if (! mIoMethodsPtr) {
             return;
         }
@@ -333,6 +335,43 @@ public:
             );
         }
     }
+    void SetPriorityParameters(
+        const Properties& inProperties)
+    {
+        // By default no class has in flight limit or deadline, and the disk
+        // queue dispatches all requests in the queue order.
+        const char* const kNamesPtr[kPriorityCount] =
+            { "high", "normal", "low" };
+        string theName;
+        for (int i = 0; i < kPriorityCount; i++) {
+            theName = kDiskQueueParametersPrefixPtr;
+            theName += kNamesPtr[i];
+            const size_t theLen = theName.size();
+            theName += "PriorityMaxInFlight";
+            const int theMaxInFlight = inProperties.getValue(
+                theName, 0);
+            theName.resize(theLen);
+            theName += "PriorityDeadlineMilliSec";
+            const Time theDeadline = (Time)inProperties.getValue(
+                theName, 0) * 1000 * 1000;
+            QCDiskQueue::SetPriorityParameters(
+                Priority(i), theMaxInFlight, theDeadline);
+        }
+    }
+    void SetWriteCoalescingParameters(
+        const Properties& inProperties)
+    {
+        // Chunk header and data writes are adjacent, therefore the header
+        // write can be coalesced with the data writes that follow it.
+        int64_t theMaxSize = inProperties.getValue(
+            "chunkServer.diskQueue.maxCoalescedWriteSize",
+            int64_t(4) << 20);
+        theMaxSize = min(theMaxSize, (int64_t)min(
+            DiskIo::GetMaxRequestSize(), size_t(1) << 30));
+        const int theBlockSize = GetBlockSize();
+        QCDiskQueue::SetMaxCoalescedWriteBlockCount(0 < theBlockSize ?
+            (int)(theMaxSize / theBlockSize) : 0);
+    }
     void Delete(
         DiskQueue** inListPtr)
     {
@@ -564,6 +603,10 @@ public:
             "chunkServer.diskQueue.threadCount", 2)),
           mDiskQueueMaxQueueDepth(inConfig.getValue(
             "chunkServer.diskQueue.maxDepth", 4 << 10)),
+          mDiskQueueIoUringFlag(inConfig.getValue(
+            "chunkServer.diskQueue.ioUring", 0) != 0),
+          mDiskQueueIoUringThreadCount(inConfig.getValue(
+            "chunkServer.diskQueue.ioUringThreadCount", 1)),
           mDiskQueueMaxBuffersPerRequest(inConfig.getValue(
             "chunkServer.diskQueue.maxBuffersPerRequest", 1 << 8)),
           mDiskQueueMaxEnqueueWaitNanoSec(inConfig.getValue(
@@ -577,6 +620,12 @@ public:
             "chunkServer.ioBufferPool.bufferSize", 4 << 10)),
           mBufferPoolLockMemoryFlag(inConfig.getValue(
             "chunkServer.ioBufferPool.lockMemory", false)),
+          mBufferPoolThreadCacheBufferCount(inConfig.getValue(
+            "chunkServer.ioBufferPool.threadCacheBufferCount", 32)),
+          mBufferPoolHugePageSize(inConfig.getValue(
+            "chunkServer.ioBufferPool.hugePageSize", 0)),
+          mBufferPoolNumaFlag(inConfig.getValue(
+            "chunkServer.ioBufferPool.numa", 0) != 0),
           mDiskOverloadedPendingRequestCount(inConfig.getValue(
             "chunkServer.diskIo.overloadedPendingRequestCount",
                 mDiskQueueMaxQueueDepth * 3 / 4)),
@@ -656,7 +705,10 @@ public:
             mBufferPoolPartitionCount,
             mBufferPoolPartitionBufferCount,
             mBufferPoolBufferSize,
-            mBufferPoolLockMemoryFlag
+            mBufferPoolLockMemoryFlag,
+            mBufferPoolThreadCacheBufferCount,
+            mBufferPoolHugePageSize,
+            mBufferPoolNumaFlag
         );
         if (theSysError) {
             if (inErrMessagePtr) {
@@ -894,6 +946,7 @@ public:
         if (theQueuePtr) {
             theQueuePtr->AddFileNamePrefix(inDirNamePtr);
             theQueuePtr->SetDeviceId(inDeviceId);
+            SetBufferPoolNumaNode(*theQueuePtr, inDirNamePtr);
             return true;
         }
         int theMinWriteBlkSize = inMinWriteBlkSize;
@@ -911,11 +964,17 @@ public:
                 return false;
             }
         }
-        const int theThreadCount    = 0 < inThreadCount ?
-            inThreadCount : mDiskQueueThreadCount;
+        // With io_uring host file system io method a single thread can keep
+        // many requests in flight.
+        const bool theIoUringFlag   =
+            ! inCanUseIoMethodFlag && mDiskQueueIoUringFlag;
+        int         theThreadCount  = 0 < inThreadCount ? inThreadCount :
+            (theIoUringFlag && 0 < mDiskQueueIoUringThreadCount ?
+                mDiskQueueIoUringThreadCount : mDiskQueueThreadCount);
         IOMethod**  theIoMethodsPtr = 0;
         const char* kLogPrefixPtr   = 0;
-        for (int i = inCanUseIoMethodFlag ? 0 : theThreadCount;
+        for (int i = (inCanUseIoMethodFlag || theIoUringFlag) ?
+                    0 : theThreadCount;
                 i < theThreadCount;
                 i++) {
             IOMethod* const thePtr = IOMethod::Create(
@@ -940,6 +999,10 @@ public:
             }
             theIoMethodsPtr[i] = thePtr;
         }
+        if (theIoUringFlag && ! theIoMethodsPtr && inThreadCount <= 0) {
+            // Fall back to thread pool if io_uring is not available.
+            theThreadCount = mDiskQueueThreadCount;
+        }
         theQueuePtr = new DiskQueue(
             mDiskQueuesPtr,
             inDeviceId,
@@ -979,8 +1042,27 @@ public:
             }
             return false;
         }
+        theQueuePtr->SetPriorityParameters(mParameters);
+        theQueuePtr->SetWriteCoalescingParameters(mParameters);
+        SetBufferPoolNumaNode(*theQueuePtr, inDirNamePtr);
         return true;
     }
+    // Read buffers are allocated from the pool partitions local to the
+    // device, if its node is known.
+    void SetBufferPoolNumaNode(
+        DiskQueue&  inQueue,
+        const char* inDirNamePtr)
+    {
+        if (! mBufferPoolNumaFlag) {
+            return;
+        }
+        const int theNode = QCIoBufferPool::GetDeviceNumaNode(inDirNamePtr);
+        KFS_LOG_STREAM_INFO <<
+            "disk queue: " << inDirNamePtr <<
+            " numa node: " << theNode      <<
+        KFS_LOG_EOM;
+        inQueue.SetBufferPoolNumaNode(theNode);
+    }
     DiskQueue::Time GetMaxEnqueueWaitTimeNanoSec() const
         { return mDiskQueueMaxEnqueueWaitNanoSec; }
     IOBufferAllocator& GetBufferAllocator()
@@ -1239,12 +1321,17 @@ private:
 
     const int                      mDiskQueueThreadCount;
     const int                      mDiskQueueMaxQueueDepth;
+    const bool                     mDiskQueueIoUringFlag;
+    const int                      mDiskQueueIoUringThreadCount;
     const int                      mDiskQueueMaxBuffersPerRequest;
     const DiskQueue::Time          mDiskQueueMaxEnqueueWaitNanoSec;
     const int                      mBufferPoolPartitionCount;
     const int                      mBufferPoolPartitionBufferCount;
     const int                      mBufferPoolBufferSize;
     const int                      mBufferPoolLockMemoryFlag;
+    const int                      mBufferPoolThreadCacheBufferCount;
+    const int                      mBufferPoolHugePageSize;
+    const bool                     mBufferPoolNumaFlag;
     const int                      mDiskOverloadedPendingRequestCount;
     const int                      mDiskClearOverloadedPendingRequestCount;
     const int                      mDiskOverloadedMinFreeBufferCount;
@@ -1940,6 +2027,13 @@ DiskIo::File::GetMinWriteBlkSize() const
     return (mQueuePtr ? mQueuePtr->GetMinWriteBlkSize() : 0);
 }
 
+    int
+DiskIo::File::DupBufferedIoFd() const
+{
+    return ((mQueuePtr && 0 <= mFileIdx) ?
+        mQueuePtr->DupBufferedIoFd(mFileIdx) : -EBADF);
+}
+
     bool
 DiskIo::File::ReserveSpace(
     string* inErrMessagePtr)
@@ -1988,6 +2082,18 @@ DiskIo::File::Reset()
     mIoBuffers.clear();
 }
 
+    inline static QCDiskQueue::Priority
+ToQueuePriority(
+    int inIoPriority)
+{
+    switch (inIoPriority) {
+        case kKfsIoPriorityHigh: return QCDiskQueue::kPriorityHigh;
+        case kKfsIoPriorityLow:  return QCDiskQueue::kPriorityLow;
+        default:                 break;
+    }
+    return QCDiskQueue::kPriorityNormal;
+}
+
 DiskIo::DiskIo(
     DiskIo::FilePtr inFilePtr,
     KfsCallbackObj* inCallBackObjPtr)
@@ -2004,6 +2110,7 @@ DiskIo::DiskIo(
       mCachedFlag(false),
       mCompletionRequestId(QCDiskQueue::kRequestIdNone),
       mCompletionCode(QCDiskQueue::kErrorNone),
+      mIoPriority(QCDiskQueue::kPriorityNormal),
       mChainedPtr(0)
 {
     QCRTASSERT(mCallbackObjPtr && mFilePtr.get());
@@ -2052,7 +2159,8 @@ private:
     ssize_t
 DiskIo::Read(
     DiskIo::Offset inOffset,
-    size_t         inNumBytes)
+    size_t         inNumBytes,
+    int            inIoPriority /* = kKfsIoPriorityNormal */)
 {
     if (inOffset < 0 ||
             mRequestId != QCDiskQueue::kRequestIdNone || ! mFilePtr->IsOpen()) {
@@ -2086,6 +2194,7 @@ DiskIo::Read(
     mIoRetCode     = 0;
     mBlockIdx      = -1;
     mReadBufOffset = inOffset % theBlockSize;
+    mIoPriority    = ToQueuePriority(inIoPriority);
     mReadLength    = inNumBytes;
     const int theBufferCnt =
         (mReadLength + mReadBufOffset + theBlockSize - 1) / theBlockSize;
@@ -2153,7 +2262,8 @@ DiskIo::Read(
         0, // inBufferIteratorPtr // allocate buffers just beofre read
         theBufferCnt,
         this,
-        sDiskIoQueuesPtr->GetMaxEnqueueWaitTimeNanoSec()
+        sDiskIoQueuesPtr->GetMaxEnqueueWaitTimeNanoSec(),
+        mIoPriority
     );
     if (theStatus.IsGood()) {
         sDiskIoQueuesPtr->ReadPending(inNumBytes);
@@ -2178,7 +2288,8 @@ DiskIo::Write(
     size_t         inNumBytes,
     IOBuffer*      inBufferPtr,
     bool           inSyncFlag /* = false */,
-    DiskIo::Offset inEofHint  /* = -1 */)
+    DiskIo::Offset inEofHint    /* = -1 */,
+    int            inIoPriority /* = kKfsIoPriorityNormal */)
 {
     if (inOffset < 0 || ! inBufferPtr ||
             mRequestId != QCDiskQueue::kRequestIdNone || ! mFilePtr->IsOpen()) {
@@ -2196,6 +2307,7 @@ DiskIo::Write(
     mIoRetCode     = 0;
     mBlockIdx      = -1;
     mReadBufOffset = 0;
+    mIoPriority    = ToQueuePriority(inIoPriority);
     mIoBuffers.clear();
     if (mFilePtr->IsReadOnly()) {
         KFS_LOG_STREAM_ERROR << "write: read only mode" << KFS_LOG_EOM;
@@ -2519,7 +2631,8 @@ DiskIo::SubmitWrite(
         this,
         sDiskIoQueuesPtr->GetMaxEnqueueWaitTimeNanoSec(),
         inSyncFlag,
-        inEofHint
+        inEofHint,
+        mIoPriority
     );
     if (theStatus.IsGood()) {
         sDiskIoQueuesPtr->WritePending(inNumBytes);
@@ -32,6 +32,7 @@
 #include <vector>
 
 #include "kfsio/IOBuffer.h"
+#include "common/kfstypes.h"
 #include "qcdio/QCDiskQueue.h"
 #include "qcdio/QCDLList.h"
 
@@ -229,6 +230,9 @@ public:
             int64_t& outWriteBlockCount,
             int&     outBlockSize);
         int GetMinWriteBlkSize() const;
+        // Returns duplicate file descriptor for sending data with sendfile,
+        // or negative error code if the file is opened for direct io.
+        int DupBufferedIoFd() const;
         int GetError() const
             { return mError; }
     private:
@@ -261,25 +265,29 @@ public:
     /// Schedule a read at the specified offset for numBytes.
     /// @param[in] numBytes # of bytes that need to be read.
     /// @param[in] offset offset in the file at which to start reading data from.
+    /// @param[in] ioPriority KfsIoPriority disk queue priority class.
     /// @retval # of bytes for which read was successfully scheduled;
     /// -1 if there was an error.
     ssize_t Read(
         Offset inOffset,
-        size_t inNumBytes);
+        size_t inNumBytes,
+        int    inIoPriority = kKfsIoPriorityNormal);
 
     /// Schedule a write.
     /// @param[in] numBytes # of bytes that need to be written
     /// @param[in] offset offset in the file at which to start writing data.
     /// @param[in] buf IOBuffer which contains data that should be written
     /// out to disk.
+    /// @param[in] ioPriority KfsIoPriority disk queue priority class.
     /// @retval # of bytes for which write was successfully scheduled;
     /// -1 if there was an error.
     ssize_t Write(
         Offset    inOffset,
         size_t    inNumBytes,
         IOBuffer* inBufferPtr,
-        bool      inSyncFlag = false,
-        Offset    inEofHint  = -1);
+        bool      inSyncFlag   = false,
+        Offset    inEofHint    = -1,
+        int       inIoPriority = kKfsIoPriorityNormal);
 
     /// Retrieves [pending] open completion by queuing empty read.
     int CheckOpenStatus();
@@ -301,6 +309,7 @@ private:
     bool                   mCachedFlag;
     QCDiskQueue::RequestId mCompletionRequestId;
     QCDiskQueue::Error     mCompletionCode;
+    QCDiskQueue::Priority  mIoPriority;
     DiskIo*                mChainedPtr;
     DiskIo*                mPrevPtr[1];
     DiskIo*                mNextPtr[1];
@@ -110,6 +110,7 @@ IOMethod::Create(
         &KFS_MAKE_REGISTERED_IO_METHOD_NAME(inType))
 
 __KFS_DECLARE_EXTERN_IO_METHOD(KFS_IO_METHOD_NAME_S3ION);
+__KFS_DECLARE_EXTERN_IO_METHOD(KFS_IO_METHOD_NAME_IOURING);
 
 #undef __KFS_DECLARE_EXTERN_IO_METHOD    
 
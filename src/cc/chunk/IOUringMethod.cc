@@ -0,0 +1,1167 @@
+//---------------------------------------------------------- -*- Mode: C++ -*-
+// $Id$
+//
+// Created 2026/10/16
+//
+// Copyright 2026 Quantcast Corp.
+//
+// This file is part of Kosmos File System (KFS).
+//
+// Licensed under the Apache License, Version 2.0
+// (the "License"); you may not use this file except in compliance with
+// the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+//
+// Linux io_uring host file system io method.
+// A single disk queue thread submits io requests in batches into the
+// submission ring, and reaps completions from the completion ring, instead of
+// issuing one blocking system call per request from a pool of io threads.
+// The disk queue thread wakeup is implemented with eventfd poll request
+// submitted into the same ring, in order to wait for either io completion or
+// new request with a single io_uring_enter() call.
+// Open is submitted into the ring as IORING_OP_OPENAT, if the kernel supports
+// it. The disk queue thread keeps reaping io completions while waiting for the
+// open to complete. The remaining meta requests (delete, rename, file system
+// space, etc) are executed by a helper thread, in order not to stall io
+// submission. Close is executed synchronously by the disk queue thread.
+//
+//----------------------------------------------------------------------------
+
+#include "IOMethodDef.h"
+
+#include "common/MsgLogger.h"
+#include "common/Properties.h"
+
+#include "qcdio/QCUtils.h"
+#include "qcdio/QCMutex.h"
+#include "qcdio/QCThread.h"
+#include "qcdio/qcdebug.h"
+#include "qcdio/qcstutils.h"
+
+#ifdef KFS_HAVE_LINUX_IO_URING_H
+#include <linux/io_uring.h>
+#include <sys/syscall.h>
+#include <sys/mman.h>
+#include <sys/eventfd.h>
+#include <sys/stat.h>
+#include <sys/statvfs.h>
+#include <sys/uio.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <poll.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <stdio.h>
+#endif
+
+#include <errno.h>
+#include <string.h>
+
+#include <string>
+#include <vector>
+#include <deque>
+
+#ifdef KFS_HAVE_LINUX_IO_URING_H
+#ifndef __NR_io_uring_setup
+#   define __NR_io_uring_setup 425
+#endif
+#ifndef __NR_io_uring_enter
+#   define __NR_io_uring_enter 426
+#endif
+#ifndef __NR_io_uring_register
+#   define __NR_io_uring_register 427
+#endif
+#endif
+
+namespace KFS
+{
+using std::string;
+using std::vector;
+using std::deque;
+
+#ifdef KFS_HAVE_LINUX_IO_URING_H
+
+class IOUringMethod : public IOMethod, public QCRunnable
+{
+public:
+    typedef QCDiskQueue::Request       Request;
+    typedef QCDiskQueue::ReqType       ReqType;
+    typedef QCDiskQueue::BlockIdx      BlockIdx;
+    typedef QCDiskQueue::InputIterator InputIterator;
+    typedef QCDiskQueue::Error         Error;
+
+    static IOMethod* New(
+        const char*       inUrlPtr,
+        const char*       inLogPrefixPtr,
+        const char*       inParamsPrefixPtr,
+        const Properties& inParameters)
+    {
+        // Host file system directories only, not object store urls.
+        if (! inUrlPtr || *inUrlPtr != '/') {
+            return 0;
+        }
+        string theName = inParamsPrefixPtr ? inParamsPrefixPtr : "";
+        const size_t theLen = theName.size();
+        if (inParameters.getValue(theName.append("ioUring"), 0) == 0) {
+            return 0;
+        }
+        theName.resize(theLen);
+        IOUringMethod* const thePtr = new IOUringMethod(
+            inUrlPtr,
+            inLogPrefixPtr,
+            inParameters.getValue(
+                theName.append("ioUringQueueDepth"), 128)
+        );
+        if (! thePtr->CreateRing()) {
+            delete thePtr;
+            return 0;
+        }
+        return thePtr;
+    }
+    virtual ~IOUringMethod()
+    {
+        IOUringMethod::Stop();
+    }
+    virtual bool Init(
+        QCDiskQueue& inDiskQueue,
+        int          inBlockSize,
+        int64_t      /* inMinWriteBlkSize */,
+        int64_t      /* inMaxFileSize */,
+        bool&        /* outCanEnforceIoTimeoutFlag */)
+    {
+        if (inBlockSize <= 0) {
+            KFS_LOG_STREAM_ERROR << mLogPrefix <<
+                "invalid block size: " << inBlockSize <<
+            KFS_LOG_EOM;
+            return false;
+        }
+        mDiskQueuePtr = &inDiskQueue;
+        mBlockSize    = inBlockSize;
+        return (0 <= mRingFd);
+    }
+    virtual void SetParameters(
+        const char*       /* inPrefixPtr */,
+        const Properties& /* inParameters */)
+        {}
+    virtual void ProcessAndWait()
+    {
+        if (mRingFd < 0) {
+            return;
+        }
+        ArmWakeupPoll();
+        if (0 < Reap() || mWakeupFlag) {
+            mWakeupFlag = false;
+            if (0 < mPendingSubmitCount) {
+                Enter(0);
+            }
+            MetaDone();
+            return;
+        }
+        WaitForCompletion();
+        mWakeupFlag = false;
+        MetaDone();
+    }
+    virtual void Wakeup()
+    {
+        const uint64_t theVal = 1;
+        while (write(mEventFd, &theVal, sizeof(theVal)) < 0 &&
+                errno == EINTR)
+            {}
+    }
+    virtual void Stop()
+    {
+        {
+            QCStMutexLocker theLocker(mMetaMutex);
+            mMetaRunFlag = false;
+            mMetaCond.Notify();
+        }
+        // The helper thread executes the queued meta requests first.
+        mMetaThread.Join();
+        MetaDone();
+        if (mRingFd < 0) {
+            return;
+        }
+        while (0 < mInFlightCount) {
+            if (WaitForCompletion() != 0) {
+                break;
+            }
+        }
+        if (0 < mInFlightCount) {
+            KFS_LOG_STREAM_ERROR << mLogPrefix <<
+                "stop: requests in flight: " << mInFlightCount <<
+            KFS_LOG_EOM;
+        }
+        DestroyRing();
+    }
+    virtual int Open(
+        const char* inFileNamePtr,
+        bool        inReadOnlyFlag,
+        bool        inCreateFlag,
+        bool        inCreateExclusiveFlag,
+        bool        inBufferedIoFlag,
+        int64_t&    ioMaxFileSize)
+    {
+        const int theFd = OpenFile(
+            inFileNamePtr,
+            (inReadOnlyFlag ? O_RDONLY : O_RDWR) |
+                QCDiskQueue::GetOpenCommonFlags(inBufferedIoFlag) | O_CLOEXEC,
+            inCreateFlag,
+            inCreateExclusiveFlag,
+            mOpenAtFlag
+        );
+        if (theFd < 0) {
+            return theFd;
+        }
+        struct stat theStat;
+        if (fstat(theFd, &theStat)) {
+            const int theErr = errno;
+            close(theFd);
+            return (theErr ? -theErr : -EIO);
+        }
+        // The disk queue uses max file size, if set, to compute last block
+        // index, and the actual file size to decide if space allocation is
+        // needed.
+        ioMaxFileSize = theStat.st_size;
+        return theFd;
+    }
+    virtual int Close(
+        int     inFd,
+        int64_t inEof)
+    {
+        int theErr = 0;
+        if (0 <= inEof && ftruncate(inFd, (off_t)inEof)) {
+            theErr = errno ? errno : -1;
+        }
+        if (close(inFd)) {
+            theErr = errno ? errno : -1;
+        }
+        return theErr;
+    }
+    virtual void StartIo(
+        Request&        inRequest,
+        ReqType         inReqType,
+        int             inFd,
+        BlockIdx        inStartBlockIdx,
+        int             inBufferCount,
+        InputIterator*  inInputIteratorPtr,
+        int64_t         inSpaceAllocSize,
+        int64_t         /* inEof */)
+    {
+        const bool theReadFlag = QCDiskQueue::kReqTypeRead == inReqType;
+        if (theReadFlag && inBufferCount <= 0 && 0 <= inFd) {
+            // Empty read is used by the disk queue to check the file open
+            // status.
+            Done(inRequest, QCDiskQueue::kErrorNone, 0, 0, inStartBlockIdx);
+            return;
+        }
+        if (! inInputIteratorPtr || inBufferCount <= 0 || inFd < 0 ||
+                mRingFd < 0 || (! theReadFlag &&
+                    QCDiskQueue::kReqTypeWrite     != inReqType &&
+                    QCDiskQueue::kReqTypeWriteSync != inReqType)) {
+            Done(inRequest, QCDiskQueue::kErrorParameter,
+                mRingFd < 0 ? EIO : EINVAL, 0, inStartBlockIdx);
+            return;
+        }
+        if (0 < inSpaceAllocSize) {
+            const int64_t theResv =
+                QCUtils::ReserveFileSpace(inFd, inSpaceAllocSize);
+            int theSysErr = 0;
+            if (theResv < 0) {
+                theSysErr = int(-theResv);
+            } else if (0 < theResv && ftruncate(inFd, inSpaceAllocSize)) {
+                theSysErr = errno ? errno : EIO;
+            }
+            if (0 != theSysErr) {
+                Done(inRequest, QCDiskQueue::kErrorSpaceAlloc,
+                    theSysErr, 0, inStartBlockIdx);
+                return;
+            }
+        }
+        int         theSysErr  = 0;
+        Slot* const theSlotPtr = GetSlot(theSysErr);
+        if (! theSlotPtr) {
+            Done(inRequest,
+                theReadFlag ? QCDiskQueue::kErrorRead : QCDiskQueue::kErrorWrite,
+                theSysErr, 0, inStartBlockIdx);
+            return;
+        }
+        Slot& theSlot = *theSlotPtr;
+        theSlot.mReqPtr      = &inRequest;
+        theSlot.mReqType     = inReqType;
+        theSlot.mFd          = inFd;
+        theSlot.mBlockIdx    = inStartBlockIdx;
+        theSlot.mOffset      = (off_t)inStartBlockIdx * mBlockSize;
+        theSlot.mIoByteCount = 0;
+        theSlot.mNextIoVec   = 0;
+        theSlot.mSegIoVec    = 0;
+        theSlot.mSegBytes    = 0;
+        theSlot.mSyncFlag    = false;
+        theSlot.mIoVec.clear();
+        char* thePtr;
+        while ((thePtr = inInputIteratorPtr->Get())) {
+            struct iovec theIoVec;
+            theIoVec.iov_base = thePtr;
+            theIoVec.iov_len  = mBlockSize;
+            theSlot.mIoVec.push_back(theIoVec);
+        }
+        if (theSlot.mIoVec.empty()) {
+            Finish(theSlot, QCDiskQueue::kErrorParameter, EINVAL);
+            return;
+        }
+        SubmitIo(theSlot);
+        if (mSubmitBatchCount <= mPendingSubmitCount) {
+            Enter(0);
+        }
+        Reap();
+    }
+    virtual void StartMeta(
+        Request&    inRequest,
+        ReqType     inReqType,
+        const char* inNamePtr,
+        const char* inName2Ptr)
+    {
+        MetaReq theReq;
+        theReq.mReqPtr       = &inRequest;
+        theReq.mReqType      = inReqType;
+        theReq.mName         = inNamePtr ? inNamePtr : "";
+        theReq.mHasName2Flag = inName2Ptr != 0;
+        if (inName2Ptr) {
+            theReq.mName2 = inName2Ptr;
+        }
+        QCStMutexLocker theLocker(mMetaMutex);
+        if (! mMetaThread.IsStarted()) {
+            const int kStackSize = 64 << 10;
+            const int theErr     = mMetaThread.TryToStart(this, kStackSize);
+            if (theErr) {
+                KFS_LOG_STREAM_ERROR << mLogPrefix <<
+                    "failed to start meta requests thread: " <<
+                    QCThread::GetErrorMsg(theErr) <<
+                KFS_LOG_EOM;
+                QCStMutexUnlocker theUnlocker(mMetaMutex);
+                ExecuteMeta(theReq);
+                Done(*theReq.mReqPtr, theReq.mError, theReq.mSysErr,
+                    theReq.mRetCount, theReq.mBlkIdx);
+                return;
+            }
+            mMetaRunFlag = true;
+        }
+        mMetaQueue.push_back(theReq);
+        mMetaCond.Notify();
+    }
+    virtual void Run()
+    {
+        QCStMutexLocker theLocker(mMetaMutex);
+        for (; ;) {
+            while (mMetaRunFlag && mMetaQueue.empty()) {
+                mMetaCond.Wait(mMetaMutex);
+            }
+            if (mMetaQueue.empty()) {
+                break;
+            }
+            MetaReq theReq = mMetaQueue.front();
+            mMetaQueue.pop_front();
+            {
+                QCStMutexUnlocker theUnlocker(mMetaMutex);
+                ExecuteMeta(theReq);
+            }
+            // The disk queue thread reports the completion, as the disk
+            // queue might be holding its mutex while stopping this thread.
+            mMetaDone.push_back(theReq);
+            Wakeup();
+        }
+    }
+private:
+    enum
+    {
+        kWakeupUserData    = 0,
+        kOpenUserData      = 1,
+        kSlotUserDataStart = 2,
+        kReservedSqEntries = kSlotUserDataStart,
+        kRetryIntervalMs   = 10
+    };
+    class Slot
+    {
+    public:
+        typedef vector<struct iovec> IoVec;
+
+        Slot()
+            : mReqPtr(0),
+              mReqType(QCDiskQueue::kReqTypeNone),
+              mFd(-1),
+              mBlockIdx(-1),
+              mOffset(0),
+              mIoByteCount(0),
+              mSegBytes(0),
+              mSegIoVec(0),
+              mNextIoVec(0),
+              mNextFree(-1),
+              mSyncFlag(false),
+              mIoVec()
+            {}
+        Request* mReqPtr;
+        ReqType  mReqType;
+        int      mFd;
+        BlockIdx mBlockIdx;
+        off_t    mOffset;
+        int64_t  mIoByteCount;
+        int64_t  mSegBytes;
+        size_t   mSegIoVec;
+        size_t   mNextIoVec;
+        int      mNextFree;
+        bool     mSyncFlag;
+        IoVec    mIoVec;
+    };
+    typedef vector<Slot> Slots;
+    struct MetaReq
+    {
+        MetaReq()
+            : mReqPtr(0),
+              mReqType(QCDiskQueue::kReqTypeNone),
+              mName(),
+              mName2(),
+              mHasName2Flag(false),
+              mError(QCDiskQueue::kErrorNone),
+              mSysErr(0),
+              mRetCount(0),
+              mBlkIdx(-1)
+            {}
+        Request* mReqPtr;
+        ReqType  mReqType;
+        string   mName;
+        string   mName2;
+        bool     mHasName2Flag;
+        Error    mError;
+        int      mSysErr;
+        int64_t  mRetCount;
+        BlockIdx mBlkIdx;
+    };
+    typedef deque<MetaReq> MetaQueue;
+
+    QCDiskQueue*        mDiskQueuePtr;
+    int                 mBlockSize;
+    const string        mDirName;
+    const string        mLogPrefix;
+    const int           mQueueDepth;
+    const int           mSubmitBatchCount;
+    int                 mRingFd;
+    int                 mEventFd;
+    void*               mSqRingPtr;
+    size_t              mSqRingSize;
+    void*               mCqRingPtr;
+    size_t              mCqRingSize;
+    struct io_uring_sqe* mSqesPtr;
+    size_t              mSqesSize;
+    volatile unsigned*  mSqHeadPtr;
+    volatile unsigned*  mSqTailPtr;
+    unsigned            mSqMask;
+    unsigned            mSqEntries;
+    unsigned*           mSqArrayPtr;
+    volatile unsigned*  mCqHeadPtr;
+    volatile unsigned*  mCqTailPtr;
+    unsigned            mCqMask;
+    struct io_uring_cqe* mCqesPtr;
+    unsigned            mSqTail;
+    int                 mPendingSubmitCount;
+    int                 mInFlightCount;
+    int                 mFreeSlot;
+    bool                mWakeupArmedFlag;
+    bool                mWakeupFlag;
+    bool                mOpenAtFlag;
+    bool                mOpenPendingFlag;
+    int                 mOpenRes;
+    uint64_t            mEventFdVal;
+    Slots               mSlots;
+    QCMutex             mMetaMutex;
+    QCCondVar           mMetaCond;
+    QCThread            mMetaThread;
+    MetaQueue           mMetaQueue;
+    MetaQueue           mMetaDone;
+    bool                mMetaRunFlag;
+
+    void MetaDone()
+    {
+        MetaQueue theDone;
+        {
+            QCStMutexLocker theLocker(mMetaMutex);
+            if (mMetaDone.empty()) {
+                return;
+            }
+            theDone.swap(mMetaDone);
+        }
+        for (MetaQueue::const_iterator theIt = theDone.begin();
+                theIt != theDone.end();
+                ++theIt) {
+            Done(*theIt->mReqPtr, theIt->mError, theIt->mSysErr,
+                theIt->mRetCount, theIt->mBlkIdx);
+        }
+    }
+    void ExecuteMeta(
+        MetaReq& inReq)
+    {
+        const char* const theNamePtr  = inReq.mName.c_str();
+        const char* const theName2Ptr =
+            inReq.mHasName2Flag ? inReq.mName2.c_str() : 0;
+        Error             theError    = QCDiskQueue::kErrorNone;
+        int               theSysErr   = 0;
+        int64_t           theRetCount = 0;
+        BlockIdx          theBlkIdx   = -1;
+        switch (inReq.mReqType) {
+            case QCDiskQueue::kReqTypeDelete:
+                if (unlink(theNamePtr)) {
+                    theSysErr = errno;
+                    theError  = QCDiskQueue::kErrorDelete;
+                }
+                break;
+            case QCDiskQueue::kReqTypeRename:
+                if (! theName2Ptr || rename(theNamePtr, theName2Ptr)) {
+                    theSysErr = theName2Ptr ? errno : EINVAL;
+                    theError  = QCDiskQueue::kErrorRename;
+                }
+                break;
+            case QCDiskQueue::kReqTypeGetFsAvailable: {
+                    struct statvfs theStat;
+                    if (statvfs(theNamePtr, &theStat)) {
+                        theSysErr = errno;
+                        theError  = QCDiskQueue::kErrorGetFsAvailable;
+                    } else {
+                        theRetCount =
+                            (int64_t)theStat.f_bavail * theStat.f_frsize;
+                        theBlkIdx   = (BlockIdx)((int64_t)theStat.f_blocks *
+                            theStat.f_frsize / mBlockSize);
+                    }
+                }
+                break;
+            case QCDiskQueue::kReqTypeCheckDirReadable: {
+                    DIR* const theDirPtr = opendir(theNamePtr);
+                    if (! theDirPtr || closedir(theDirPtr)) {
+                        theSysErr = errno;
+                        theError  = QCDiskQueue::kErrorCheckDirReadable;
+                    }
+                }
+                break;
+            case QCDiskQueue::kReqTypeCheckDirWritable:
+                if ((theSysErr = CheckDirWritable(theNamePtr, theName2Ptr))) {
+                    theError = QCDiskQueue::kErrorCheckDirWritable;
+                }
+                break;
+            default:
+                theError  = QCDiskQueue::kErrorParameter;
+                theSysErr = ENXIO;
+                KFS_LOG_STREAM_ERROR << mLogPrefix <<
+                    "start meta:"     <<
+                    " request type: " << inReq.mReqType <<
+                    " is not supported" <<
+                KFS_LOG_EOM;
+                break;
+        }
+        inReq.mError    = theError;
+        inReq.mSysErr   = theSysErr;
+        inReq.mRetCount = theRetCount;
+        inReq.mBlkIdx   = theBlkIdx;
+    }
+    IOUringMethod(
+        const char* inDirNamePtr,
+        const char* inLogPrefixPtr,
+        int         inQueueDepth)
+        : IOMethod(),
+          mDiskQueuePtr(0),
+          mBlockSize(0),
+          mDirName(inDirNamePtr ? inDirNamePtr : ""),
+          mLogPrefix(string(inLogPrefixPtr ? inLogPrefixPtr : "") +
+            (inLogPrefixPtr && *inLogPrefixPtr ? " " : "") +
+            "io_uring " + mDirName + " "),
+          mQueueDepth(max(8, min(4 << 10, inQueueDepth))),
+          mSubmitBatchCount(max(1, mQueueDepth / 4)),
+          mRingFd(-1),
+          mEventFd(-1),
+          mSqRingPtr(MAP_FAILED),
+          mSqRingSize(0),
+          mCqRingPtr(MAP_FAILED),
+          mCqRingSize(0),
+          mSqesPtr((struct io_uring_sqe*)MAP_FAILED),
+          mSqesSize(0),
+          mSqHeadPtr(0),
+          mSqTailPtr(0),
+          mSqMask(0),
+          mSqEntries(0),
+          mSqArrayPtr(0),
+          mCqHeadPtr(0),
+          mCqTailPtr(0),
+          mCqMask(0),
+          mCqesPtr(0),
+          mSqTail(0),
+          mPendingSubmitCount(0),
+          mInFlightCount(0),
+          mFreeSlot(-1),
+          mWakeupArmedFlag(false),
+          mWakeupFlag(false),
+          mOpenAtFlag(false),
+          mOpenPendingFlag(false),
+          mOpenRes(-EIO),
+          mEventFdVal(0),
+          mSlots(),
+          mMetaMutex(),
+          mMetaCond(),
+          mMetaThread(),
+          mMetaQueue(),
+          mMetaDone(),
+          mMetaRunFlag(false)
+        {}
+    static int max(
+        int inA,
+        int inB)
+        { return (inA < inB ? inB : inA); }
+    static int min(
+        int inA,
+        int inB)
+        { return (inA < inB ? inA : inB); }
+    bool CreateRing()
+    {
+        struct io_uring_params theParams;
+        memset(&theParams, 0, sizeof(theParams));
+        // Extra entries for the wakeup poll and open requests.
+        const int theFd = (int)syscall(
+            __NR_io_uring_setup, mQueueDepth + kReservedSqEntries, &theParams);
+        if (theFd < 0) {
+            const int theErr = errno;
+            KFS_LOG_STREAM_ERROR << mLogPrefix <<
+                "io_uring_setup failure: " << QCUtils::SysError(theErr) <<
+                ", using io threads" <<
+            KFS_LOG_EOM;
+            return false;
+        }
+        mRingFd = theFd;
+        if (fcntl(mRingFd, F_SETFD, FD_CLOEXEC) ||
+                (mEventFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)) < 0) {
+            const int theErr = errno;
+            KFS_LOG_STREAM_ERROR << mLogPrefix <<
+                "eventfd failure: " << QCUtils::SysError(theErr) <<
+            KFS_LOG_EOM;
+            DestroyRing();
+            return false;
+        }
+        mSqRingSize = theParams.sq_off.array +
+            theParams.sq_entries * sizeof(unsigned);
+        mCqRingSize = theParams.cq_off.cqes +
+            theParams.cq_entries * sizeof(struct io_uring_cqe);
+        mSqesSize   = theParams.sq_entries * sizeof(struct io_uring_sqe);
+        mSqRingPtr  = mmap(0, mSqRingSize, PROT_READ | PROT_WRITE,
+            MAP_SHARED | MAP_POPULATE, mRingFd, IORING_OFF_SQ_RING);
+        mCqRingPtr  = mmap(0, mCqRingSize, PROT_READ | PROT_WRITE,
+            MAP_SHARED | MAP_POPULATE, mRingFd, IORING_OFF_CQ_RING);
+        mSqesPtr    = (struct io_uring_sqe*)mmap(0, mSqesSize,
+            PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, mRingFd,
+            IORING_OFF_SQES);
+        if (MAP_FAILED == mSqRingPtr || MAP_FAILED == mCqRingPtr ||
+                MAP_FAILED == (void*)mSqesPtr) {
+            const int theErr = errno;
+            KFS_LOG_STREAM_ERROR << mLogPrefix <<
+                "io_uring mmap failure: " << QCUtils::SysError(theErr) <<
+            KFS_LOG_EOM;
+            DestroyRing();
+            return false;
+        }
+        char* const theSqPtr = (char*)mSqRingPtr;
+        mSqHeadPtr  = (volatile unsigned*)(theSqPtr + theParams.sq_off.head);
+        mSqTailPtr  = (volatile unsigned*)(theSqPtr + theParams.sq_off.tail);
+        mSqMask     = *(unsigned*)(theSqPtr + theParams.sq_off.ring_mask);
+        mSqEntries  = *(unsigned*)(theSqPtr + theParams.sq_off.ring_entries);
+        mSqArrayPtr = (unsigned*)(theSqPtr + theParams.sq_off.array);
+        mSqTail     = *mSqTailPtr;
+        char* const theCqPtr = (char*)mCqRingPtr;
+        mCqHeadPtr  = (volatile unsigned*)(theCqPtr + theParams.cq_off.head);
+        mCqTailPtr  = (volatile unsigned*)(theCqPtr + theParams.cq_off.tail);
+        mCqMask     = *(unsigned*)(theCqPtr + theParams.cq_off.ring_mask);
+        mCqesPtr    = (struct io_uring_cqe*)(theCqPtr + theParams.cq_off.cqes);
+        // Each slot has at most one request in flight, therefore neither
+        // submission nor completion rings can overflow. One entry is
+        // reserved for the wakeup poll, and one for open.
+        const int theSlotCount =
+            min(mQueueDepth, (int)mSqEntries - kReservedSqEntries);
+        if (theSlotCount <= 0) {
+            KFS_LOG_STREAM_ERROR << mLogPrefix <<
+                "insufficient io_uring entries: " << mSqEntries <<
+                ", using io threads" <<
+            KFS_LOG_EOM;
+            DestroyRing();
+            return false;
+        }
+#ifdef IO_URING_OP_SUPPORTED
+        mOpenAtFlag = IsOpSupported(IORING_OP_OPENAT);
+#endif
+        mSlots.resize(theSlotCount);
+        for (int i = theSlotCount - 1; 0 <= i; i--) {
+            mSlots[i].mNextFree = mFreeSlot;
+            mFreeSlot = i;
+        }
+        KFS_LOG_STREAM_INFO << mLogPrefix <<
+            "started:"
+            " entries: " << mSqEntries <<
+            " slots: "   << theSlotCount <<
+            " openat: "  << mOpenAtFlag <<
+        KFS_LOG_EOM;
+        return true;
+    }
+#ifdef IO_URING_OP_SUPPORTED
+    bool IsOpSupported(
+        int inOp)
+    {
+        // Kernels prior to 5.6 support neither probe, nor open.
+        const int    kMaxOps = 256;
+        vector<char> theBuf(sizeof(struct io_uring_probe) +
+            kMaxOps * sizeof(struct io_uring_probe_op), 0);
+        struct io_uring_probe& theProbe =
+            *reinterpret_cast<struct io_uring_probe*>(&theBuf[0]);
+        return (0 <= inOp && 0 == syscall(__NR_io_uring_register, mRingFd,
+                (unsigned)IORING_REGISTER_PROBE, &theProbe, kMaxOps) &&
+            inOp < (int)theProbe.ops_len &&
+            (theProbe.ops[inOp].flags & IO_URING_OP_SUPPORTED) != 0
+        );
+    }
+#endif
+    void DestroyRing()
+    {
+        if (MAP_FAILED != (void*)mSqesPtr) {
+            munmap(mSqesPtr, mSqesSize);
+            mSqesPtr = (struct io_uring_sqe*)MAP_FAILED;
+        }
+        if (MAP_FAILED != mCqRingPtr) {
+            munmap(mCqRingPtr, mCqRingSize);
+            mCqRingPtr = MAP_FAILED;
+        }
+        if (MAP_FAILED != mSqRingPtr) {
+            munmap(mSqRingPtr, mSqRingSize);
+            mSqRingPtr = MAP_FAILED;
+        }
+        if (0 <= mEventFd) {
+            close(mEventFd);
+            mEventFd = -1;
+        }
+        if (0 <= mRingFd) {
+            close(mRingFd);
+            mRingFd = -1;
+        }
+        mSqHeadPtr       = 0;
+        mSqTailPtr       = 0;
+        mSqArrayPtr      = 0;
+        mCqHeadPtr       = 0;
+        mCqTailPtr       = 0;
+        mCqesPtr         = 0;
+        mWakeupArmedFlag = false;
+    }
+    struct io_uring_sqe& GetSqe()
+    {
+        __sync_synchronize();
+        QCRTASSERT(mSqTail - *mSqHeadPtr < mSqEntries);
+        const unsigned theIdx = mSqTail & mSqMask;
+        struct io_uring_sqe& theSqe = mSqesPtr[theIdx];
+        memset(&theSqe, 0, sizeof(theSqe));
+        mSqArrayPtr[theIdx] = theIdx;
+        return theSqe;
+    }
+    void CommitSqe()
+    {
+        mSqTail++;
+        __sync_synchronize();
+        *mSqTailPtr = mSqTail;
+        mPendingSubmitCount++;
+    }
+    int Enter(
+        unsigned inWaitCount)
+    {
+        for (; ;) {
+            const int theRet = (int)syscall(
+                __NR_io_uring_enter,
+                mRingFd,
+                (unsigned)mPendingSubmitCount,
+                inWaitCount,
+                0 < inWaitCount ? (unsigned)IORING_ENTER_GETEVENTS : 0u,
+                (void*)0,
+                (size_t)0
+            );
+            if (0 <= theRet) {
+                mPendingSubmitCount -= min(theRet, mPendingSubmitCount);
+                return 0;
+            }
+            const int theErr = errno;
+            if (EINTR == theErr) {
+                continue;
+            }
+            if (EAGAIN != theErr && EBUSY != theErr) {
+                KFS_LOG_STREAM_ERROR << mLogPrefix <<
+                    "io_uring_enter failure: " << QCUtils::SysError(theErr) <<
+                KFS_LOG_EOM;
+            }
+            return theErr;
+        }
+    }
+    // Submits pending requests, waits for, and reaps completions.
+    // Returns 0, or fatal io_uring_enter() error.
+    int WaitForCompletion()
+    {
+        const int theErr = Enter(1);
+        if (EAGAIN == theErr || EBUSY == theErr) {
+            // The completion ring is over committed, or the kernel is out of
+            // resources. Reap the completions, or wait for ones with ring fd
+            // poll and time out, in case nothing is in flight, instead of
+            // spinning. The submission is retried with the next call.
+            if (Reap() <= 0) {
+                struct pollfd thePoll;
+                thePoll.fd      = mRingFd;
+                thePoll.events  = POLLIN;
+                thePoll.revents = 0;
+                while (poll(&thePoll, 1, kRetryIntervalMs) < 0 &&
+                        errno == EINTR)
+                    {}
+                Reap();
+            }
+            return 0;
+        }
+        if (0 == theErr) {
+            Reap();
+        }
+        return theErr;
+    }
+    int Reap()
+    {
+        int      theCount = 0;
+        unsigned theHead  = *mCqHeadPtr;
+        for (; ;) {
+            __sync_synchronize();
+            if (theHead == *mCqTailPtr) {
+                break;
+            }
+            const struct io_uring_cqe& theCqe = mCqesPtr[theHead & mCqMask];
+            const uint64_t             theUserData = theCqe.user_data;
+            const int                  theRes      = theCqe.res;
+            theHead++;
+            __sync_synchronize();
+            *mCqHeadPtr = theHead;
+            Complete(theUserData, theRes);
+            theCount++;
+        }
+        return theCount;
+    }
+    void ArmWakeupPoll()
+    {
+        if (mWakeupArmedFlag) {
+            return;
+        }
+        struct io_uring_sqe& theSqe = GetSqe();
+        theSqe.opcode      = IORING_OP_POLL_ADD;
+        theSqe.fd          = mEventFd;
+        theSqe.poll_events = POLLIN;
+        theSqe.user_data   = kWakeupUserData;
+        CommitSqe();
+        mWakeupArmedFlag = true;
+    }
+    Slot* GetSlot(
+        int& outSysErr)
+    {
+        if (mSlots.empty()) {
+            outSysErr = EIO;
+            return 0;
+        }
+        while (mFreeSlot < 0) {
+            if ((outSysErr = WaitForCompletion()) != 0) {
+                return 0;
+            }
+        }
+        Slot& theSlot = mSlots[mFreeSlot];
+        mFreeSlot = theSlot.mNextFree;
+        theSlot.mNextFree = -1;
+        mInFlightCount++;
+        return &theSlot;
+    }
+    void SubmitIo(
+        Slot& inSlot)
+    {
+#ifdef IOV_MAX
+        const size_t kMaxIoVecCount = IOV_MAX;
+#else
+        const size_t kMaxIoVecCount = 1 << 10;
+#endif
+        const size_t theCnt = std::min(
+            inSlot.mIoVec.size() - inSlot.mNextIoVec, kMaxIoVecCount);
+        const size_t theEnd   = inSlot.mNextIoVec + theCnt;
+        int64_t      theBytes = 0;
+        for (size_t i = inSlot.mNextIoVec; i < theEnd; i++) {
+            theBytes += (int64_t)inSlot.mIoVec[i].iov_len;
+        }
+        struct io_uring_sqe& theSqe = GetSqe();
+        theSqe.opcode    = QCDiskQueue::kReqTypeRead == inSlot.mReqType ?
+            IORING_OP_READV : IORING_OP_WRITEV;
+        theSqe.fd        = inSlot.mFd;
+        theSqe.off       = (uint64_t)(inSlot.mOffset + inSlot.mIoByteCount);
+        theSqe.addr      = (uint64_t)(uintptr_t)(
+            &inSlot.mIoVec[0] + inSlot.mNextIoVec);
+        theSqe.len       = (unsigned)theCnt;
+        theSqe.user_data = (uint64_t)(&inSlot - &mSlots[0]) +
+            kSlotUserDataStart;
+        inSlot.mSegIoVec   = inSlot.mNextIoVec;
+        inSlot.mNextIoVec += theCnt;
+        inSlot.mSegBytes   = theBytes;
+        CommitSqe();
+    }
+    void SubmitSync(
+        Slot& inSlot)
+    {
+        struct io_uring_sqe& theSqe = GetSqe();
+        theSqe.opcode    = IORING_OP_FSYNC;
+        theSqe.fd        = inSlot.mFd;
+        theSqe.user_data = (uint64_t)(&inSlot - &mSlots[0]) +
+            kSlotUserDataStart;
+        inSlot.mSyncFlag = true;
+        CommitSqe();
+    }
+    void Complete(
+        uint64_t inUserData,
+        int      inRes)
+    {
+        if (kWakeupUserData == inUserData) {
+            mWakeupArmedFlag = false;
+            mWakeupFlag      = true;
+            while (read(mEventFd, &mEventFdVal, sizeof(mEventFdVal)) < 0 &&
+                    errno == EINTR)
+                {}
+            return;
+        }
+        if (kOpenUserData == inUserData) {
+            mOpenPendingFlag = false;
+            mOpenRes         = inRes;
+            return;
+        }
+        QCRTASSERT(kSlotUserDataStart <= inUserData &&
+            inUserData - kSlotUserDataStart < mSlots.size());
+        Slot&      theSlot     =
+            mSlots[(size_t)(inUserData - kSlotUserDataStart)];
+        const bool theReadFlag = QCDiskQueue::kReqTypeRead == theSlot.mReqType;
+        if (inRes < 0) {
+            Finish(theSlot,
+                theReadFlag ? QCDiskQueue::kErrorRead : QCDiskQueue::kErrorWrite,
+                -inRes);
+            return;
+        }
+        if (theSlot.mSyncFlag) {
+            Finish(theSlot, QCDiskQueue::kErrorNone, 0);
+            return;
+        }
+        theSlot.mIoByteCount += inRes;
+        if (inRes < theSlot.mSegBytes) {
+            if (theReadFlag) {
+                // Short read -- end of file.
+                Finish(theSlot, QCDiskQueue::kErrorNone, 0);
+            } else if (inRes <= 0) {
+                Finish(theSlot, QCDiskQueue::kErrorWrite, EIO);
+            } else {
+                // Short write -- resubmit the remainder of the segment.
+                Slot::IoVec::iterator theIt =
+                    theSlot.mIoVec.begin() + theSlot.mSegIoVec;
+                size_t theRem = (size_t)inRes;
+                while (theIt->iov_len <= theRem) {
+                    theRem -= theIt->iov_len;
+                    ++theIt;
+                }
+                theIt->iov_base = (char*)theIt->iov_base + theRem;
+                theIt->iov_len -= theRem;
+                theSlot.mNextIoVec = (size_t)(theIt - theSlot.mIoVec.begin());
+                SubmitIo(theSlot);
+            }
+            return;
+        }
+        if (theSlot.mNextIoVec < theSlot.mIoVec.size()) {
+            SubmitIo(theSlot);
+            return;
+        }
+        if (QCDiskQueue::kReqTypeWriteSync == theSlot.mReqType) {
+            SubmitSync(theSlot);
+            return;
+        }
+        Finish(theSlot, QCDiskQueue::kErrorNone, 0);
+    }
+    void Finish(
+        Slot& inSlot,
+        Error inError,
+        int   inSysError)
+    {
+        Request&       theReq      = *inSlot.mReqPtr;
+        const int64_t  theIoBytes  = inSlot.mIoByteCount;
+        const BlockIdx theBlockIdx = inSlot.mBlockIdx;
+        inSlot.mReqPtr   = 0;
+        inSlot.mNextFree = mFreeSlot;
+        mFreeSlot = (int)(&inSlot - &mSlots[0]);
+        mInFlightCount--;
+        Done(theReq, inError, inSysError, theIoBytes, theBlockIdx);
+    }
+    void Done(
+        Request& inRequest,
+        Error    inError,
+        int      inSysError,
+        int64_t  inIoByteCount,
+        BlockIdx inBlockIdx)
+    {
+        mDiskQueuePtr->Done(
+            *this,
+            inRequest,
+            inError,
+            inSysError,
+            inIoByteCount,
+            inBlockIdx
+        );
+    }
+    int OpenFile(
+        const char* inFileNamePtr,
+        int         inFlags,
+        bool        inCreateFlag,
+        bool        inCreateExclusiveFlag,
+        bool        inUseRingFlag)
+    {
+        const int theFlags = inFlags | (inCreateFlag ?
+            (O_CREAT | (inCreateExclusiveFlag ? O_EXCL : 0)) : 0);
+        int theFd;
+        for (int i = 0; i < 2; i++) {
+            while ((theFd = OpenSelf(inFileNamePtr,
+                        i == 0 ? theFlags : (theFlags & ~O_DIRECT),
+                        inUseRingFlag)) == -EEXIST &&
+                    inCreateFlag && unlink(inFileNamePtr) == 0)
+                {}
+            // Retry without direct io if host file system does not support
+            // it.
+            if (0 <= theFd || -EINVAL != theFd) {
+                break;
+            }
+        }
+        return theFd;
+    }
+    int OpenSelf(
+        const char* inFileNamePtr,
+        int         inFlags,
+        bool        inUseRingFlag)
+    {
+#ifdef IO_URING_OP_SUPPORTED
+        if (inUseRingFlag && 0 <= mRingFd) {
+            struct io_uring_sqe& theSqe = GetSqe();
+            theSqe.opcode     = IORING_OP_OPENAT;
+            theSqe.fd         = AT_FDCWD;
+            theSqe.addr       = (uint64_t)(uintptr_t)inFileNamePtr;
+            theSqe.len        = S_IRUSR | S_IWUSR;
+            theSqe.open_flags = (uint32_t)inFlags;
+            theSqe.user_data  = kOpenUserData;
+            CommitSqe();
+            mOpenPendingFlag = true;
+            mOpenRes         = -EIO;
+            // Keep reaping io completions while waiting for open.
+            while (mOpenPendingFlag) {
+                const int theErr = WaitForCompletion();
+                if (theErr) {
+                    mOpenPendingFlag = false;
+                    mOpenAtFlag      = false;
+                    return -theErr;
+                }
+            }
+            return mOpenRes;
+        }
+#endif
+        const int theFd = open(inFileNamePtr, inFlags, S_IRUSR | S_IWUSR);
+        return (theFd < 0 ? (errno ? -errno : -EIO) : theFd);
+    }
+    int CheckDirWritable(
+        const char* inNamePtr,
+        const char* inParamsPtr)
+    {
+        bool    theBufferedIoFlag    = false;
+        bool    theAllocateSpaceFlag = false;
+        int64_t theSize              = 0;
+        if (inParamsPtr && *inParamsPtr && inParamsPtr[1]) {
+            const char* thePtr = inParamsPtr;
+            theBufferedIoFlag    = (*thePtr++ & 0xFF) != '0';
+            theAllocateSpaceFlag = (*thePtr++ & 0xFF) != '0';
+            int theSym;
+            while ((theSym = (*thePtr++ & 0xFF))) {
+                theSize <<= 4;
+                theSize |= (theSym - '0') & 0xF;
+            }
+        }
+        const int theFd = OpenFile(
+            inNamePtr,
+            O_RDWR | QCDiskQueue::GetOpenCommonFlags(theBufferedIoFlag) |
+                O_CLOEXEC,
+            true,
+            true,
+            false // Executed by the meta requests thread.
+        );
+        if (theFd < 0) {
+            return -theFd;
+        }
+        int theSysErr = 0;
+        if (0 < theSize && theAllocateSpaceFlag) {
+            const int64_t theResv = QCUtils::ReserveFileSpace(theFd, theSize);
+            if (theResv < 0) {
+                theSysErr = int(-theResv);
+            }
+        }
+        void* theBufPtr = 0;
+        if (0 == theSysErr && 0 < theSize &&
+                posix_memalign(&theBufPtr, 4 << 10, mBlockSize) == 0) {
+            memset(theBufPtr, 0xF9, mBlockSize);
+            for (int64_t thePos = 0; thePos < theSize; thePos += mBlockSize) {
+                if (pwrite(theFd, theBufPtr, mBlockSize, (off_t)thePos) !=
+                        (ssize_t)mBlockSize) {
+                    theSysErr = errno ? errno : EIO;
+                    break;
+                }
+            }
+            free(theBufPtr);
+        }
+        if (close(theFd) && 0 == theSysErr) {
+            theSysErr = errno;
+        }
+        if (unlink(inNamePtr) && 0 == theSysErr) {
+            theSysErr = errno;
+        }
+        return theSysErr;
+    }
+private:
+    IOUringMethod(
+        const IOUringMethod& inMethod);
+    IOUringMethod& operator=(
+        const IOUringMethod& inMethod);
+};
+
+#else /* KFS_HAVE_LINUX_IO_URING_H */
+
+class IOUringMethod
+{
+public:
+    static IOMethod* New(
+        const char*       inUrlPtr,
+        const char*       inLogPrefixPtr,
+        const char*       inParamsPrefixPtr,
+        const Properties& inParameters)
+    {
+        if (! inUrlPtr || *inUrlPtr != '/') {
+            return 0;
+        }
+        string theName = inParamsPrefixPtr ? inParamsPrefixPtr : "";
+        if (inParameters.getValue(theName.append("ioUring"), 0) != 0) {
+            KFS_LOG_STREAM_ERROR <<
+                (inLogPrefixPtr ? inLogPrefixPtr : "") <<
+                "io_uring is not supported, using io threads" <<
+            KFS_LOG_EOM;
+        }
+        return 0;
+    }
+};
+
+#endif /* KFS_HAVE_LINUX_IO_URING_H */
+
+KFS_REGISTER_IO_METHOD(KFS_IO_METHOD_NAME_IOURING, IOUringMethod::New);
+
+} // namespace KFS
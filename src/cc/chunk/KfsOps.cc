@@ -59,6 +59,7 @@
 #include <iomanip>
 #include <iterator>
 #include <stdlib.h>
+#include <unistd.h>
 
 #ifdef KFS_OS_NAME_SUNOS
 #include <sys/loadavg.h>
@@ -528,6 +529,12 @@ ChunkAccessRequestOp::CheckAccess(ClientSM& sm)
     return sm.CheckAccess(*this);
 }
 
+/* virtual */ bool
+ReadOp::CheckAccess(ClientSM& sm)
+{
+    return sm.CheckAccess(*this);
+}
+
 void
 ChunkAccessRequestOp::WriteChunkAccessResponse(
     ostream& os, int64_t subjectId, int accessTokenFlags)
@@ -830,7 +837,12 @@ ReadOp::HandleDone(int code, void *data)
                 " version: "  << chunkVersion <<
             KFS_LOG_EOM;
         }
-        if (status != -ETIMEDOUT) {
+        if (tierReadCacheFlag) {
+            // Chunk copy io failure does not affect the chunk.
+            if (! gChunkManager.RetryTierReadCacheRead(this)) {
+                return 0; // Retry.
+            }
+        } else if (status != -ETIMEDOUT) {
             gChunkManager.ChunkIOFailed(
                 chunkId, chunkVersion, status, diskIo.get());
         }
@@ -859,14 +871,27 @@ ReadOp::HandleDone(int code, void *data)
         );
         if (numBytesIO <= 0) {
             checksum.clear();
+        } else if (checksumType != kKfsChecksumTypeAdler32 &&
+                checksumType != acceptChecksumType) {
+            // The requestor does not support chunk checksum algorithm, send
+            // back adler32 checksums.
+            checksum.clear();
+            AppendToChecksumVector(dataBuf, numBytesIO, 0,
+                skipVerifyDiskChecksumFlag ?
+                    CHECKSUM_BLOCKSIZE - offset % CHECKSUM_BLOCKSIZE :
+                    CHECKSUM_BLOCKSIZE,
+                checksum);
+            checksumType = kKfsChecksumTypeAdler32;
         } else if (! skipVerifyDiskChecksumFlag) {
             if (offset % CHECKSUM_BLOCKSIZE != 0) {
-                checksum = ComputeChecksums(&dataBuf, numBytesIO);
+                checksum = ComputeChecksums(&dataBuf, numBytesIO, 0,
+                    CHECKSUM_BLOCKSIZE, checksumType);
             } else {
                 const int len = (int)(numBytesIO % CHECKSUM_BLOCKSIZE);
                 if (len > 0) {
                     checksum.back() = ComputeBlockChecksumAt(
-                        &dataBuf, numBytesIO - len, (size_t)len);
+                        &dataBuf, numBytesIO - len, (size_t)len,
+                        checksumType);
                 }
             }
             assert((size_t)((numBytesIO + CHECKSUM_BLOCKSIZE - 1) /
@@ -900,6 +925,10 @@ ReadOp::HandleDone(int code, void *data)
         gChunkManager.CloseChunk(chunkId, ci->chunkVersion);
     }
 
+    if (0 <= repairCoefficient) {
+        Replicator::RepairRead(this);
+        return 0;
+    }
     gLogger.Submit(this);
     return 0;
 }
@@ -914,7 +943,7 @@ ReadOp::VerifyReply()
     if (status >= 0) {
         assert(numBytesIO == dataBuf.BytesConsumable());
         vector<uint32_t> datacksums = ComputeChecksums(
-            &dataBuf, numBytesIO);
+            &dataBuf, numBytesIO, 0, CHECKSUM_BLOCKSIZE, checksumType);
         if (datacksums.size() > checksum.size()) {
             KFS_LOG_STREAM_INFO <<
                 "Checksum number of entries mismatch in re-replication: "
@@ -982,6 +1011,16 @@ ReadOp::HandleScrubReadDone(int code, void *data)
     return scrubOp->HandleScrubReadDone(code, data);
 }
 
+void
+ReadOp::ReleaseSendFileFd()
+{
+    if (0 <= sendFileFd) {
+        close(sendFileFd);
+        sendFileFd = -1;
+    }
+    sendFileOffset = -1;
+}
+
 bool
 ReadOp::IsChunkReadOp(int64_t& outNumBytes, kfsChunkId_t& outChunkId)
 {
@@ -1590,6 +1629,25 @@ AppendStorageTiersInfo(ostream& os, const ChunkManager::StorageTiersInfo& tiersI
     os << "\r\n";
 }
 
+bool
+HeartbeatOp::ParseContent(istream& is)
+{
+    if (status != 0) {
+        return false;
+    }
+    rsRepairPeers.clear();
+    ServerLocation loc;
+    while ((is >> loc)) {
+        if (! loc.IsValid()) {
+            statusMsg = "invalid chunk server location: " + loc.ToString();
+            status    = -EINVAL;
+            break;
+        }
+        rsRepairPeers.push_back(loc);
+    }
+    return (status == 0);
+}
+
 // This is the heartbeat sent by the meta server
 void
 HeartbeatOp::Execute()
@@ -1599,6 +1657,9 @@ HeartbeatOp::Execute()
     getloadavg(loadavg, 3);
 #endif
     gChunkManager.MetaHeartbeat(*this);
+    if (rsRepairPeersFlag) {
+        Replicator::SetRepairPeers(rsRepairPeers);
+    }
 
     const int64_t writeCount       = gChunkManager.GetNumWritableChunks();
     const int64_t writeAppendCount =
@@ -1694,6 +1755,36 @@ HeartbeatOp::Execute()
         cm.mReadSkipDiskVerifyByteCount);
     HBAppend(os, "Read-chksum-skip-cs-bytes", "rsc",
         cm.mReadSkipDiskVerifyChecksumByteCount);
+    HBAppend(os, "Read-sendfile",             "rsf",
+        cm.mReadSendFileCount);
+    HBAppend(os, "Read-sendfile-bytes",       "rsfb",
+        cm.mReadSendFileByteCount);
+    HBAppend(os, 0, "rdcache", "");
+    HBAppend(os, "Read-cache-hit",       "hit",
+        cm.mReadBlockCacheHitCount);
+    HBAppend(os, "Read-cache-hit-bytes", "hitb",
+        cm.mReadBlockCacheHitByteCount);
+    HBAppend(os, "Read-cache-miss",      "miss",
+        cm.mReadBlockCacheMissCount);
+    HBAppend(os, "Read-cache-bytes",     "size",
+        cm.mReadBlockCacheByteCount);
+    HBAppend(os, 0, "tiercache", "");
+    HBAppend(os, "Tier-cache-hit",         "hit",
+        cm.mTierReadCacheHitCount);
+    HBAppend(os, "Tier-cache-hit-bytes",   "hitb",
+        cm.mTierReadCacheHitByteCount);
+    HBAppend(os, "Tier-cache-miss",        "miss",
+        cm.mTierReadCacheMissCount);
+    HBAppend(os, "Tier-cache-retry",       "retry",
+        cm.mTierReadCacheRetryCount);
+    HBAppend(os, "Tier-cache-admit",       "admit",
+        cm.mTierReadCacheAdmitCount);
+    HBAppend(os, "Tier-cache-copy-errors", "cperr",
+        cm.mTierReadCacheCopyErrorCount);
+    HBAppend(os, "Tier-cache-evict",       "evict",
+        cm.mTierReadCacheEvictCount);
+    HBAppend(os, "Tier-cache-bytes",       "size",
+        cm.mTierReadCacheByteCount);
 
     MetaServerSM::Counters mc;
     gMetaServerSM.GetCounters(mc);
@@ -2030,6 +2121,10 @@ ReadOp::Execute()
             "read request size exceeds chunk size: " << numBytes <<
         KFS_LOG_EOM;
         status = -EINVAL;
+    } else if (0 <= repairCoefficient && (255 < repairCoefficient ||
+            offset < 0 || offset % CHECKSUM_BLOCKSIZE != 0)) {
+        statusMsg = "invalid repair read";
+        status    = -EINVAL;
     } else if (clientSMFlag &&
             ! gChunkManager.IsChunkReadable(chunkId, chunkVersion)) {
         // Do not allow dirty reads.
@@ -2051,6 +2146,10 @@ ReadOp::Execute()
         gLogger.Submit(this);
         return;
     }
+    if (0 <= repairCoefficient && ! Replicator::StartRepairRead(this)) {
+        gLogger.Submit(this);
+        return;
+    }
     SET_HANDLER(this, &ReadOp::HandleChunkMetaReadDone);
     const bool kAddObjectBlockMappingFlag = true;
     const int res = gChunkManager.ReadChunkMetadata(
@@ -2063,7 +2162,11 @@ ReadOp::Execute()
             " status: "  << res <<
         KFS_LOG_EOM;
         status = res;
-        gLogger.Submit(this);
+        if (0 <= repairCoefficient) {
+            Replicator::RepairRead(this);
+        } else {
+            gLogger.Submit(this);
+        }
     }
 }
 
@@ -2074,16 +2177,42 @@ ReadOp::HandleChunkMetaReadDone(int code, void *data)
         status = *(int *) data;
     }
     if (status < 0) {
-        gLogger.Submit(this);
+        if (0 <= repairCoefficient) {
+            Replicator::RepairRead(this);
+        } else {
+            gLogger.Submit(this);
+        }
         return 0;
     }
+    if (0 <= repairCoefficient) {
+        // The data is transformed, and the checksums are re-computed,
+        // therefore the disk checksums must be verified.
+        skipVerifyDiskChecksumFlag = false;
+        const ChunkInfo_t* const ci =
+            gChunkManager.GetChunkInfo(chunkId, chunkVersion);
+        if (ci && ci->chunkSize <= offset) {
+            // Past the end of the chunk, the chunk contributes only zeros.
+            numBytesIO = 0;
+            dataBuf.Clear();
+            checksum.clear();
+            Replicator::RepairRead(this);
+            return 0;
+        }
+    }
 
     SET_HANDLER(this, &ReadOp::HandleDone);
-    status = gChunkManager.ReadChunk(this);
+    status = 0;
+    // With block cache hit the read completes, and the op is submitted before
+    // ReadChunk() returns, therefore the op must not be accessed on success.
+    const bool kUseReadCacheFlag = true;
+    const int  res = gChunkManager.ReadChunk(this, kUseReadCacheFlag);
 
-    if (status < 0) {
+    if (res < 0) {
+        status = res;
         // clnt->HandleEvent(EVENT_CMD_DONE, this);
-        if (! wop) {
+        if (0 <= repairCoefficient) {
+            Replicator::RepairRead(this);
+        } else if (! wop) {
             // we are done with this op; this needs draining
             gLogger.Submit(this);
         } else {
@@ -2119,6 +2248,12 @@ ReadOp::ParseResponse(const Properties& props, IOBuffer& iobuf)
     }
     skipVerifyDiskChecksumFlag = skipVerifyDiskChecksumFlag &&
         props.getValue("Skip-Disk-Chksum", 0) != 0;
+    const int type = props.getValue("Checksum-type",
+        int(kKfsChecksumTypeAdler32));
+    if (type != kKfsChecksumTypeAdler32 && type != acceptChecksumType) {
+        return false;
+    }
+    checksumType = (KfsChecksumType)type;
     const int off = (int)(offset % IOBufferData::GetDefaultBufferSize());
     if (0 < off) {
         IOBuffer buf;
@@ -2579,9 +2714,12 @@ WriteSyncOp::Execute()
     // the checksum.
     // In the write slave case, the checksums should match the write master
     // write checksum.
+    // The client and the peers send adler32 checksums, for the chunks with
+    // different checksums algorithm these are verified against adler32
+    // checksums of the written blocks.
     bool                   mismatch    = false;
-    const vector<uint32_t> myChecksums =
-        gChunkManager.GetChecksums(chunkId, chunkVersion, offset, numBytes);
+    const vector<uint32_t> myChecksums = gChunkManager.GetWriteChecksums(
+        chunkId, chunkVersion, offset, numBytes);
     if ((writeMaster && (
             (offset % CHECKSUM_BLOCKSIZE) != 0 ||
             (numBytes % CHECKSUM_BLOCKSIZE) != 0)) || checksums.empty()) {
@@ -2677,8 +2815,8 @@ WriteSyncOp::ForwardToPeer(
     SET_HANDLER(fwdedOp, &KfsOp::HandleDone);
 
     if (writeMaster) {
-        fwdedOp->checksums =
-            gChunkManager.GetChecksums(chunkId, chunkVersion, offset, numBytes);
+        fwdedOp->checksums = gChunkManager.GetWriteChecksums(
+            chunkId, chunkVersion, offset, numBytes);
     } else {
         fwdedOp->checksums = checksums;
     }
@@ -2906,6 +3044,7 @@ GetChunkMetadataOp::HandleChunkMetaReadDone(int code, void *data)
         if (info->chunkBlockChecksum || info->chunkSize == 0) {
             chunkVersion = info->chunkVersion;
             chunkSize    = info->chunkSize;
+            checksumType = info->GetChecksumType();
             if (info->chunkBlockChecksum) {
                 dataBuf.CopyIn((const char *)info->chunkBlockChecksum,
                     MAX_CHUNK_CHECKSUM_BLOCKS * sizeof(uint32_t));
@@ -3116,6 +3255,11 @@ GetChunkMetadataOp::Response(ostream &os)
         "Chunk-handle: "   << chunkId      << "\r\n"
         "Chunk-version: "  << chunkVersion << "\r\n"
         "Size: "           << chunkSize    << "\r\n"
+    ;
+    if (checksumType != kKfsChecksumTypeAdler32) {
+        os << "Checksum-type: " << checksumType << "\r\n";
+    }
+    os <<
         "Content-length: " << numBytesIO   << "\r\n"
     "\r\n";
 }
@@ -3134,6 +3278,9 @@ ReadOp::Response(ostream &os)
     if (skipVerifyDiskChecksumFlag) {
         os << "Skip-Disk-Chksum: 1\r\n";
     }
+    if (checksumType != kKfsChecksumTypeAdler32) {
+        os << "Checksum-type: " << checksumType << "\r\n";
+    }
     if (checksum.size() == 0) {
         os << "Checksums: " << 0 << "\r\n";
     } else {
@@ -3308,6 +3455,18 @@ ReadOp::Request(ostream& os)
     if (skipVerifyDiskChecksumFlag) {
         os << "Skip-Disk-Chksum: 1\r\n";
     }
+    if (acceptChecksumType != kKfsChecksumTypeAdler32) {
+        os << "Checksum-type: " << acceptChecksumType << "\r\n";
+    }
+    if (0 <= repairCoefficient) {
+        os << "RS-repair-coef: " << repairCoefficient << "\r\n";
+        if (! repairChain.empty()) {
+            os << "RS-repair-chain: " << repairChain << "\r\n";
+        }
+    }
+    if (ioPriority != kKfsIoPriorityHigh) {
+        os << "IO-priority: " << ioPriority << "\r\n";
+    }
     if (requestChunkAccess) {
         os << "C-access: " << requestChunkAccess << "\r\n";
     }
@@ -765,6 +765,7 @@ struct ReplicateChunkOp : public KfsOp {
     kfsSTier_t      maxStorageTier;
     string          pathName;
     string          invalidStripeIdx;
+    string          rsRepairSources; // input: pipelined recovery sources
     int             metaPort;
     bool            allowCSClearTextFlag;
     StringBufT<64>  locationStr;
@@ -788,6 +789,7 @@ struct ReplicateChunkOp : public KfsOp {
         maxStorageTier(kKfsSTierUndef),
         pathName(),
         invalidStripeIdx(),
+        rsRepairSources(),
         metaPort(-1),
         allowCSClearTextFlag(false),
         locationStr(),
@@ -844,13 +846,19 @@ struct ReplicateChunkOp : public KfsOp {
         .Def("C-access",             &ReplicateChunkOp::chunkAccess)
         .Def("CS-access",            &ReplicateChunkOp::chunkServerAccess)
         .Def("CS-clear-text",        &ReplicateChunkOp::allowCSClearTextFlag)
+        .Def("RS-repair-sources",    &ReplicateChunkOp::rsRepairSources)
         ;
     }
 };
 
 struct HeartbeatOp : public KfsOp {
+    typedef vector<ServerLocation> RepairPeers;
+
     int64_t           metaEvacuateCount; // input
     bool              authenticateFlag;
+    bool              rsRepairPeersFlag; // input: the content has peer list
+    int               contentLength;
+    RepairPeers       rsRepairPeers;     // chunk servers locations
     IOBuffer          response;
     string            cmdShow;
     bool              sendCurrentKeyFlag;
@@ -861,6 +869,9 @@ struct HeartbeatOp : public KfsOp {
         : KfsOp(CMD_HEARTBEAT, s),
           metaEvacuateCount(-1),
           authenticateFlag(false),
+          rsRepairPeersFlag(false),
+          contentLength(0),
+          rsRepairPeers(),
           response(),
           cmdShow(),
           sendCurrentKeyFlag(false),
@@ -869,6 +880,8 @@ struct HeartbeatOp : public KfsOp {
         {}
     void Execute();
     void Response(ostream &os);
+    virtual int GetContentLength() const { return contentLength; }
+    virtual bool ParseContent(istream& is);
     virtual ostream& ShowSelf(ostream& os) const {
         if (cmdShow.empty()) {
             return os << "heartbeat";
@@ -884,6 +897,8 @@ struct HeartbeatOp : public KfsOp {
         return KfsOp::ParserDef(parser)
         .Def("Num-evacuate", &HeartbeatOp::metaEvacuateCount, int64_t(-1))
         .Def("Authenticate", &HeartbeatOp::authenticateFlag, false)
+        .Def("RS-repair-peers", &HeartbeatOp::rsRepairPeersFlag, false)
+        .Def("Content-length",  &HeartbeatOp::contentLength, 0)
         ;
     }
 };
@@ -1399,6 +1414,10 @@ struct WriteOp : public KfsOp {
     IOBuffer         dataBuf; /* buffer with the data to be written */
     int64_t          diskIOTime;
     vector<uint32_t> checksums; /* store the checksum for logging purposes */
+    KfsChecksumType  checksumType; /* checksums algorithm */
+    /* adler32 checksums of the written blocks, used by write sync checksums
+     * verification with chunks with the different checksums algorithm */
+    vector<uint32_t> writeChecksums;
     /*
      * for writes that are smaller than a checksum block, we need to
      * read the whole block in, compute the new checksum and then write
@@ -1430,6 +1449,8 @@ struct WriteOp : public KfsOp {
           dataBuf(),
           diskIOTime(0),
           checksums(),
+          checksumType(kKfsChecksumTypeAdler32),
+          writeChecksums(),
           rop(0),
           wpop(0),
           isFromReReplication(false),
@@ -1450,6 +1471,8 @@ struct WriteOp : public KfsOp {
           dataBuf(),
           diskIOTime(0),
           checksums(),
+          checksumType(kKfsChecksumTypeAdler32),
+          writeChecksums(),
           rop(0),
           wpop(0),
           isFromReReplication(false),
@@ -1621,10 +1644,31 @@ struct ReadOp : public KfsClientChunkOp {
     DiskIoPtr        diskIo;     /* disk connection used for reading data */
     IOBuffer         dataBuf;    /* buffer with the data read */
     vector<uint32_t> checksum;   /* checksum over the data that is sent back to client */
+    KfsChecksumType  checksumType; /* checksum vector algorithm */
+    int              acceptChecksumType; /* input: algorithm supported by the
+                                          requestor, besides adler32 */
     int64_t          diskIOTime; /* how long did the AIOs take */
     int              retryCnt;
     bool             skipVerifyDiskChecksumFlag;
+    int              ioPriority; /* KfsIoPriority disk io priority class */
     const char*      requestChunkAccess;
+    /*
+     * pipelined RS recovery: the data read is multiplied by the repair
+     * coefficient, and the result of the remaining hops in the repair chain
+     * is added to it. Negative value means regular read.
+     */
+    int              repairCoefficient;
+    string           repairChain;
+    KfsCallbackObj*  repairReader; /* in flight read from the next hop */
+    /*
+     * client read reply can be sent with sendfile from the chunk file
+     * descriptor duplicate, instead of the data buffer.
+     */
+    bool             sendFileFlag;    /* input: sendfile can be used */
+    int              sendFileFd;      /* output: owned by the op */
+    int64_t          sendFileOffset;  /* output: chunk file offset */
+    /* the read uses fast storage tier chunk copy */
+    bool             tierReadCacheFlag;
     /*
      * for writes that require the associated checksum block to be
      * read in, store the pointer to the associated write op.
@@ -1642,10 +1686,20 @@ struct ReadOp : public KfsClientChunkOp {
           diskIo(),
           dataBuf(),
           checksum(),
+          checksumType(kKfsChecksumTypeAdler32),
+          acceptChecksumType(kKfsChecksumTypeAdler32),
           diskIOTime(0),
           retryCnt(0),
           skipVerifyDiskChecksumFlag(false),
+          ioPriority(kKfsIoPriorityHigh),
           requestChunkAccess(0),
+          repairCoefficient(-1),
+          repairChain(),
+          repairReader(0),
+          sendFileFlag(false),
+          sendFileFd(-1),
+          sendFileOffset(-1),
+          tierReadCacheFlag(false),
           wop(0),
           scrubOp(0),
           devBufMgr(0)
@@ -1658,10 +1712,21 @@ struct ReadOp : public KfsClientChunkOp {
           diskIo(),
           dataBuf(),
           checksum(),
+          checksumType(kKfsChecksumTypeAdler32),
+          acceptChecksumType(kKfsChecksumTypeAdler32),
           diskIOTime(0),
           retryCnt(0),
           skipVerifyDiskChecksumFlag(false),
+          ioPriority(w->isFromReReplication ?
+            kKfsIoPriorityLow : kKfsIoPriorityNormal),
           requestChunkAccess(0),
+          repairCoefficient(-1),
+          repairChain(),
+          repairReader(0),
+          sendFileFlag(false),
+          sendFileFd(-1),
+          sendFileOffset(-1),
+          tierReadCacheFlag(false),
           wop(w),
           scrubOp(0),
           devBufMgr(0)
@@ -1673,7 +1738,9 @@ struct ReadOp : public KfsClientChunkOp {
     }
     ~ReadOp() {
         assert(! wop);
+        ReleaseSendFileFd();
     }
+    void ReleaseSendFileFd();
 
     void SetScrubOp(GetChunkMetadataOp *sop) {
         scrubOp = sop;
@@ -1701,7 +1768,8 @@ struct ReadOp : public KfsClientChunkOp {
             " version: "  << chunkVersion <<
             " offset: "   << offset <<
             " numBytes: " << numBytes <<
-            (skipVerifyDiskChecksumFlag ? " skip-disk-chksum" : "")
+            (skipVerifyDiskChecksumFlag ? " skip-disk-chksum" : "") <<
+            (0 <= repairCoefficient ? " repair" : "")
         ;
     }
     virtual bool IsChunkReadOp(int64_t& outNumBytes, kfsChunkId_t& outChunkId);
@@ -1712,6 +1780,7 @@ struct ReadOp : public KfsClientChunkOp {
             findFlag, resetFlag, chunkId, chunkVersion, devBufMgr);
     }
     virtual bool ParseResponse(const Properties& props, IOBuffer& iobuf);
+    virtual bool CheckAccess(ClientSM& sm);
     virtual bool GetResponseContent(IOBuffer& iobuf, int len)
     {
         const int nmv = dataBuf.Move(&iobuf, len);
@@ -1728,6 +1797,12 @@ struct ReadOp : public KfsClientChunkOp {
         .Def("Offset",           &ReadOp::offset)
         .Def("Num-bytes",        &ReadOp::numBytes)
         .Def("Skip-Disk-Chksum", &ReadOp::skipVerifyDiskChecksumFlag, false)
+        .Def("Checksum-type",    &ReadOp::acceptChecksumType,
+            int(kKfsChecksumTypeAdler32))
+        .Def("RS-repair-coef",   &ReadOp::repairCoefficient, -1)
+        .Def("RS-repair-chain",  &ReadOp::repairChain)
+        .Def("IO-priority",      &ReadOp::ioPriority,
+            int(kKfsIoPriorityHigh))
         ;
     }
 };
@@ -1875,6 +1950,7 @@ struct GetChunkMetadataOp : public KfsClientChunkOp {
     int64_t      chunkSize; // output
     IOBuffer     dataBuf; // buffer with the checksum info
     size_t       numBytesIO;
+    KfsChecksumType checksumType; // output
     ReadOp       readOp; // internally generated
     int64_t      numBytesScrubbed;
     const char*  requestChunkAccess;
@@ -1886,6 +1962,7 @@ struct GetChunkMetadataOp : public KfsClientChunkOp {
           chunkSize(0),
           dataBuf(),
           numBytesIO(0),
+          checksumType(kKfsChecksumTypeAdler32),
           readOp(0),
           numBytesScrubbed(0),
           requestChunkAccess(0)
@@ -163,7 +163,8 @@ public:
     bool Setup(
         NetConnection&         inConn,
         const string&          inSessionId,
-        const CryptoKeys::Key& inSessionKey)
+        const CryptoKeys::Key& inSessionKey,
+        bool                   inShutdownSslFlag)
     {
         if (! mEnabledFlag) {
             return true;
@@ -190,6 +191,10 @@ public:
             delete theFilterPtr;
             return false;
         }
+        if (inShutdownSslFlag) {
+            // The connection continues in clear text after ssl shutdown.
+            theFilterPtr->DisableKtls();
+        }
         string theErrMsg;
         const int theStatus = inConn.SetFilter(theFilterPtr, &theErrMsg);
         if (theStatus == 0) {
@@ -226,6 +231,7 @@ RemoteSyncSM::Auth* RemoteSyncSM::sAuthPtr                  = 0;
 bool                RemoteSyncSM::sTraceRequestResponseFlag = false;
 int                 RemoteSyncSM::sOpResponseTimeoutSec     = 5 * 60;
 int                 RemoteSyncSM::sRemoteSyncCount          = 0;
+int                 RemoteSyncSM::sZeroCopyMinSize          = 0;
 
 const int kMaxCmdHeaderLength = 2 << 10;
 
@@ -254,6 +260,9 @@ RemoteSyncSM::SetParameters(
     sOpResponseTimeoutSec = props.getValue(
         name.Truncate(len).Append(
             "responseTimeoutSec"), sOpResponseTimeoutSec);
+    sZeroCopyMinSize = props.getValue(
+        name.Truncate(len).Append(
+            "zeroCopyMinSize"), sZeroCopyMinSize);
     if (! sAuthPtr) {
         sAuthPtr = new Auth();
     }
@@ -366,12 +375,16 @@ RemoteSyncSM::Connect()
     mNetConnection.reset(new NetConnection(sock, this));
     mNetConnection->SetDoingNonblockingConnect();
     mNetConnection->SetMaxReadAhead(kMaxCmdHeaderLength);
+    if (0 < sZeroCopyMinSize) {
+        mNetConnection->SetZeroCopy(sZeroCopyMinSize);
+    }
     QCASSERT(sAuthPtr);
     mSslShutdownInProgressFlag = false;
     if (! mSessionId.empty()) {
         int  err          = 0;
         bool noFilterFlag = false;
-        if (! sAuthPtr->Setup(*mNetConnection, mSessionId, mSessionKey) ||
+        if (! sAuthPtr->Setup(*mNetConnection, mSessionId, mSessionKey,
+                    mShutdownSslFlag) ||
                 (noFilterFlag = ! mNetConnection->GetFilter()) ||
                 (mShutdownSslFlag && (err = mNetConnection->Shutdown()) != 0)) {
             if (err) {
@@ -211,6 +211,7 @@ private:
     static bool        sTraceRequestResponseFlag;
     static int         sOpResponseTimeoutSec;
     static int         sRemoteSyncCount;
+    static int         sZeroCopyMinSize;
     static Auth*       sAuthPtr;
 
     ~RemoteSyncSM();
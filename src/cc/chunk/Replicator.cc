@@ -61,15 +61,24 @@
 #include "libclient/KfsNetClient.h"
 #include "libclient/Reader.h"
 #include "libclient/KfsOps.h"
+#include "libclient/ECMethod.h"
+
+#include "qcrs/rs.h"
 
 #include <string>
 #include <sstream>
+#include <set>
+#include <string.h>
 
 namespace KFS
 {
 
 using std::string;
+using std::set;
+using std::less;
 using std::ostringstream;
+using std::istringstream;
+using std::ws;
 using std::pair;
 using std::make_pair;
 using std::max;
@@ -277,6 +286,8 @@ ReplicatorImpl::ReplicatorImpl(ReplicateChunkOp *op, const RemoteSyncSMPtr &peer
         mChunkMetadataOp.requestChunkAccess = mReadOp.requestChunkAccess;
     }
     mReadOp.clnt = this;
+    mReadOp.acceptChecksumType = gChunkManager.GetChecksumType();
+    mReadOp.ioPriority = kKfsIoPriorityLow;
     mWriteOp.clnt = this;
     mChunkMetadataOp.clnt = this;
     mWriteOp.Reset();
@@ -561,6 +572,7 @@ ReplicatorImpl::HandleReadDone(int code, void* data)
     } else {
         mWriteOp.checksums = mReadOp.checksum;
     }
+    mWriteOp.checksumType = mReadOp.checksumType;
 
     // align the writes to checksum boundaries
     bool moveDataFlag = true;
@@ -735,6 +747,409 @@ ReplicatorImpl::GetPeerName() const
     return (mPeer ? mPeer->GetLocation().ToString() : "none");
 }
 
+static RemoteSyncSMPtr
+CreateRepairPeer(const ServerLocation& location, int& status, string& statusMsg)
+{
+    // The pipelined recovery chain is only used with no chunk server
+    // authentication.
+    const bool      kKeyIsNotEncryptedFlag = true;
+    const bool      kAllowCSClearTextFlag  = false;
+    const bool      connectFlag            = gClientManager.GetMutexPtr() == 0;
+    RemoteSyncSMPtr peer                   = RemoteSyncSM::Create(
+        location,
+        0,
+        0,
+        0,
+        0,
+        kKeyIsNotEncryptedFlag,
+        kAllowCSClearTextFlag,
+        status,
+        statusMsg,
+        connectFlag,
+        ! connectFlag
+    );
+    if (peer && status < 0) {
+        peer.reset();
+    }
+    return peer;
+}
+
+// Pipelined RS recovery chain hop. Multiplies the local chunk data by the
+// repair coefficient, and adds the partial result computed by the remaining
+// hops, received from the next hop. With this every link in the chain carries
+// about one chunk worth of data, instead of the recovering node fetching
+// the data of all source chunks. The read from the next hop is issued when
+// the request arrives, and runs concurrently with the local chunk read, in
+// order to have all hops in the chain read their chunks in parallel.
+class RSRepairReader : public KfsCallbackObj
+{
+public:
+    static bool Start(ReadOp& op)
+    {
+        assert(! op.repairReader && 0 <= op.repairCoefficient);
+        if (op.repairChain.empty()) {
+            return true;
+        }
+        int            coef    = -1;
+        kfsChunkId_t   chunkId = -1;
+        int64_t        version = -1;
+        ServerLocation location;
+        string         rest;
+        if (! ParseHop(op.repairChain, coef, chunkId, version, location,
+                rest)) {
+            op.status    = -EINVAL;
+            op.statusMsg = "invalid repair chain";
+            return false;
+        }
+        int                   status = 0;
+        string                statusMsg;
+        const RemoteSyncSMPtr peer   =
+            CreateRepairPeer(location, status, statusMsg);
+        if (! peer) {
+            KFS_LOG_STREAM_ERROR << "repair read:"
+                " chunk: " << op.chunkId <<
+                " unable to find peer: " << location <<
+                " " << statusMsg <<
+            KFS_LOG_EOM;
+            op.status    = status < 0 ? status : -EHOSTUNREACH;
+            op.statusMsg = "repair chain: next hop is not reachable";
+            return false;
+        }
+        RSRepairReader& reader = *(new RSRepairReader(op, peer));
+        ReadOp&         fwd    = reader.mFwdOp;
+        fwd.chunkId            = chunkId;
+        fwd.chunkVersion       = version;
+        fwd.offset             = op.offset;
+        fwd.numBytes           = op.numBytes;
+        fwd.acceptChecksumType = op.acceptChecksumType;
+        fwd.ioPriority         = op.ioPriority;
+        fwd.repairCoefficient  = coef;
+        fwd.repairChain.swap(rest);
+        op.repairReader = &reader;
+        peer->Enqueue(&fwd);
+        return true;
+    }
+    static void Run(ReadOp& op)
+    {
+        if (op.repairReader) {
+            RSRepairReader& reader =
+                *static_cast<RSRepairReader*>(op.repairReader);
+            assert(&reader.mOp == &op && ! reader.mLocalDoneFlag);
+            reader.mLocalDoneFlag = true;
+            if (reader.mFwdDoneFlag) {
+                reader.Done();
+            }
+            return;
+        }
+        if (0 <= op.status) {
+            Combine(op, 0);
+        }
+        gLogger.Submit(&op);
+    }
+    static bool ParseHop(
+        const string&   chain,
+        int&            coef,
+        kfsChunkId_t&   chunkId,
+        int64_t&        version,
+        ServerLocation& location,
+        string&         rest)
+    {
+        istringstream is(chain);
+        if (! (is >> coef >> chunkId >> version >> location) ||
+                coef < 0 || 255 < coef || chunkId < 0 ||
+                ! location.IsValid()) {
+            return false;
+        }
+        rest.clear();
+        getline(is >> ws, rest);
+        return true;
+    }
+private:
+    ReadOp&               mOp;
+    ReadOp                mFwdOp;
+    RemoteSyncSMPtr const mPeer;
+    bool                  mLocalDoneFlag;
+    bool                  mFwdDoneFlag;
+
+    RSRepairReader(ReadOp& op, const RemoteSyncSMPtr& peer)
+        : KfsCallbackObj(),
+          mOp(op),
+          mFwdOp(0),
+          mPeer(peer),
+          mLocalDoneFlag(false),
+          mFwdDoneFlag(false)
+    {
+        mFwdOp.clnt = this;
+        SET_HANDLER(&mFwdOp, &ReadOp::HandleReplicatorDone);
+        SET_HANDLER(this, &RSRepairReader::HandleFwdDone);
+    }
+    int HandleFwdDone(int code, void* data)
+    {
+        assert(code == EVENT_CMD_DONE && data == &mFwdOp && ! mFwdDoneFlag);
+        mFwdDoneFlag = true;
+        if (mLocalDoneFlag) {
+            Done();
+        }
+        return 0;
+    }
+    void Done()
+    {
+        if (mOp.status < 0) {
+            // Local read failure, the next hop result is discarded.
+        } else if (mFwdOp.status < 0) {
+            KFS_LOG_STREAM_ERROR << "repair read:"
+                " chunk: "  << mOp.chunkId <<
+                " peer: "   << mPeer->GetLocation() <<
+                " chunk: "  << mFwdOp.chunkId <<
+                " status: " << mFwdOp.status <<
+                " "         << mFwdOp.statusMsg <<
+            KFS_LOG_EOM;
+            mOp.status    = mFwdOp.status;
+            mOp.statusMsg = "repair chain: " + mFwdOp.statusMsg;
+        } else if (mFwdOp.dataBuf.BytesConsumable() != (int)mOp.numBytes) {
+            mOp.status    = -EINVAL;
+            mOp.statusMsg = "repair chain: invalid read size";
+        } else {
+            Combine(mOp, &mFwdOp.dataBuf);
+        }
+        ReadOp& op = mOp;
+        op.repairReader = 0;
+        delete this;
+        gLogger.Submit(&op);
+    }
+    static void Combine(ReadOp& op, const IOBuffer* partial)
+    {
+        const int size = (int)op.numBytes;
+        if (size <= 0) {
+            op.dataBuf.Clear();
+            op.checksum.clear();
+            op.numBytesIO = 0;
+            op.status     = 0;
+            return;
+        }
+        // The vector kernels require aligned buffers. Bytes past the local
+        // chunk end are zeros.
+        const int   kAlign = 64;
+        const int   len    = (size + kAlign - 1) / kAlign * kAlign;
+        const int   bufLen = 2 * len + kAlign;
+        char* const buf    = new char[bufLen];
+        const int   align  = (int)(reinterpret_cast<size_t>(buf) % kAlign);
+        const int   offset = align == 0 ? 0 : kAlign - align;
+        char* const ptr    = buf + offset;
+        const int   rd     = op.dataBuf.CopyOut(ptr, size);
+        memset(ptr + rd, 0, len - rd);
+        unsigned char matrix[2];
+        void*         src[2];
+        void*         dst[1];
+        int           cnt = 0;
+        matrix[cnt] = (unsigned char)op.repairCoefficient;
+        src[cnt++]  = ptr;
+        if (partial) {
+            const int prd = partial->CopyOut(ptr + len, size);
+            memset(ptr + len + prd, 0, len - prd);
+            matrix[cnt] = 1;
+            src[cnt++]  = ptr + len;
+        }
+        dst[0] = ptr;
+        rs_matrix_mul(1, cnt, matrix, len, src, dst);
+        op.dataBuf.Clear();
+        op.dataBuf.Append(IOBufferData(buf, bufLen, offset, size));
+        op.checksumType = IsValidChecksumType(op.acceptChecksumType) ?
+            (KfsChecksumType)op.acceptChecksumType : kKfsChecksumTypeAdler32;
+        op.checksum     = ComputeChecksums(&op.dataBuf, size, 0,
+            CHECKSUM_BLOCKSIZE, op.checksumType);
+        op.numBytesIO   = size;
+        op.status       = size;
+    }
+private:
+    RSRepairReader(const RSRepairReader&);
+    RSRepairReader& operator=(const RSRepairReader&);
+};
+
+// Pipelined RS recovery. The meta server provides the locations of the
+// available chunks in the RS block. The source chunk servers are chained, the
+// last hop in the chain reads its chunk and multiplies it by its repair
+// coefficient, and each preceding hop adds its own contribution to the
+// partial result, before forwarding it. The recovering node reads the final
+// result from the head of the chain as with a regular replication.
+class RSPipelinedReplicatorImpl : public ReplicatorImpl
+{
+public:
+    static ReplicatorImpl* Create(ReplicateChunkOp* op)
+    {
+        const int    stripeCount   = op->numStripes;
+        const int    recoveryCount = op->numRecoveryStripes;
+        const int    totalCount    = stripeCount + recoveryCount;
+        const int    stripeIdx     =
+            (int)(op->chunkOffset / (int64_t)CHUNKSIZE % totalCount);
+        const size_t kMaxCount     = 256;
+        if (op->rsRepairSources.empty() || op->fileSize < 0 ||
+                stripeCount <= 0 || recoveryCount <= 0 ||
+                kMaxCount < (size_t)totalCount) {
+            return 0;
+        }
+        kfsChunkId_t   chunkIds[kMaxCount];
+        int64_t        versions[kMaxCount];
+        ServerLocation locations[kMaxCount];
+        bool           availFlags[kMaxCount];
+        for (int i = 0; i < totalCount; i++) {
+            availFlags[i] = false;
+        }
+        istringstream is(op->rsRepairSources);
+        int           idx;
+        while (is >> idx) {
+            if (idx < 0 || totalCount <= idx || idx == stripeIdx ||
+                    availFlags[idx] ||
+                    ! (is >> chunkIds[idx] >> versions[idx] >>
+                        locations[idx]) ||
+                    ! locations[idx].IsValid()) {
+                KFS_LOG_STREAM_ERROR << "recovery:"
+                    " invalid repair sources: " << op->rsRepairSources <<
+                    " " << op->Show() <<
+                KFS_LOG_EOM;
+                return 0;
+            }
+            availFlags[idx] = true;
+        }
+        int missing[kMaxCount];
+        int missingCnt = 0;
+        for (int i = 0; i < totalCount; i++) {
+            if (! availFlags[i]) {
+                missing[missingCnt++] = i;
+            }
+        }
+        string                     errMsg;
+        client::ECMethod::Decoder* const decoder =
+            client::ECMethod::FindDecoder(
+                op->striperType, stripeCount, recoveryCount, &errMsg);
+        if (! decoder) {
+            KFS_LOG_STREAM_ERROR << "recovery: " << errMsg <<
+                " " << op->Show() <<
+            KFS_LOG_EOM;
+            return 0;
+        }
+        int           sources[kMaxCount];
+        unsigned char coefs[kMaxCount];
+        const int     cnt = decoder->GetRepairCoefficients(
+            stripeCount, recoveryCount, stripeIdx, missingCnt, missing,
+            sources, coefs);
+        decoder->Release();
+        if (cnt <= 0) {
+            KFS_LOG_STREAM_DEBUG << "recovery:"
+                " no pipelined repair: " << op->Show() <<
+            KFS_LOG_EOM;
+            return 0;
+        }
+        // The first source is the head of the chain.
+        string chain;
+        for (int i = 1; i < cnt; i++) {
+            const int k = sources[i];
+            if (! chain.empty()) {
+                chain += ' ';
+            }
+            AppendDecIntToString(chain, (int)coefs[i]) += ' ';
+            AppendDecIntToString(chain, chunkIds[k]) += ' ';
+            AppendDecIntToString(chain, versions[k]) += ' ';
+            chain += locations[k].ToString();
+        }
+        const int head = sources[0];
+        const RemoteSyncSMPtr peer = CreateRepairPeer(
+            locations[head], op->status, op->statusMsg);
+        if (! peer) {
+            KFS_LOG_STREAM_ERROR << "recovery:"
+                " unable to find peer: " << locations[head] <<
+                " " << op->statusMsg <<
+            KFS_LOG_EOM;
+            op->status = 0;
+            op->statusMsg.clear();
+            return 0;
+        }
+        const int64_t chunkSize = GetChunkSize(
+            stripeIdx, stripeCount, recoveryCount, op->stripeSize,
+            op->chunkOffset, op->fileSize);
+        KFS_LOG_STREAM_INFO << "recovery:"
+            " chunk: "   << op->chunkId <<
+            " stripe: "  << stripeIdx <<
+            " size: "    << chunkSize <<
+            " sources: " << cnt <<
+            " pipelined repair chain: " << locations[head] <<
+            " " << chain <<
+        KFS_LOG_EOM;
+        return new RSPipelinedReplicatorImpl(op, peer, chunkIds[head],
+            versions[head], (int)coefs[0], chain, chunkSize);
+    }
+private:
+    kfsChunkId_t const mSrcChunkId;
+    int64_t const      mSrcChunkVersion;
+    int64_t const      mRecoverChunkSize;
+
+    RSPipelinedReplicatorImpl(
+        ReplicateChunkOp*      op,
+        const RemoteSyncSMPtr& peer,
+        kfsChunkId_t           srcChunkId,
+        int64_t                srcChunkVersion,
+        int                    coef,
+        const string&          chain,
+        int64_t                chunkSize)
+        : ReplicatorImpl(op, peer),
+          mSrcChunkId(srcChunkId),
+          mSrcChunkVersion(srcChunkVersion),
+          mRecoverChunkSize(chunkSize)
+    {
+        mReadOp.repairCoefficient = coef;
+        mReadOp.repairChain       = chain;
+    }
+    virtual void Start()
+    {
+        // The chunk size is known from the file size, the chunk version is
+        // the recovery target version.
+        mChunkMetadataOp.chunkSize         = mRecoverChunkSize;
+        mChunkMetadataOp.chunkVersion      = mOwner->chunkVersion;
+        mChunkMetadataOp.status            = 0;
+        mReadOp.skipVerifyDiskChecksumFlag = false;
+        HandleStartDone(EVENT_CMD_DONE, &mChunkMetadataOp);
+    }
+    virtual void Read()
+    {
+        mReadOp.chunkId      = mSrcChunkId;
+        mReadOp.chunkVersion = mSrcChunkVersion;
+        ReplicatorImpl::Read();
+    }
+    static int64_t GetChunkSize(
+        int     stripeIdx,
+        int     stripeCount,
+        int     recoveryCount,
+        int     stripeSize,
+        int64_t chunkOffset,
+        int64_t fileSize)
+    {
+        // Same as the RS striper chunk size: the recovery stripes are
+        // padded to the stripe size.
+        const int64_t kChunkSize  = (int64_t)CHUNKSIZE;
+        const int64_t blockSize   = kChunkSize * stripeCount;
+        const int64_t strideSize  = (int64_t)stripeSize * stripeCount;
+        const int64_t blockPos    = chunkOffset / kChunkSize /
+            (stripeCount + recoveryCount) * blockSize;
+        const int64_t size        = fileSize - blockPos;
+        if (size <= 0 || blockSize <= size) {
+            return kChunkSize;
+        }
+        const int64_t strideHead  = size % strideSize;
+        const int64_t headIdx     = strideHead / stripeSize;
+        const int     idx         = stripeIdx < stripeCount ? stripeIdx : 0;
+        int64_t       chunkSize   = size / strideSize * stripeSize;
+        if (idx < headIdx) {
+            chunkSize += stripeSize;
+        } else if (idx == headIdx) {
+            chunkSize += strideHead % stripeSize;
+        }
+        return min(kChunkSize, chunkSize);
+    }
+private:
+    RSPipelinedReplicatorImpl(const RSPipelinedReplicatorImpl&);
+    RSPipelinedReplicatorImpl& operator=(const RSPipelinedReplicatorImpl&);
+};
+
 const char* const kRsReadMetaAuthPrefix = "chunkServer.rsReader.auth.";
 
 class RSReplicatorImpl :
@@ -1193,7 +1608,10 @@ private:
             if (0 < mReadOp.numBytes && ! buf.IsEmpty() &&
                         mReadOp.offset   % (int)CHECKSUM_BLOCKSIZE == 0 &&
                         mReadOp.numBytes % (int)CHECKSUM_BLOCKSIZE == 0) {
-                mReadOp.checksum = ComputeChecksums(&buf, mReadOp.numBytes);
+                mReadOp.checksumType = gChunkManager.GetChecksumType();
+                mReadOp.checksum     = ComputeChecksums(&buf,
+                    mReadOp.numBytes, 0, CHECKSUM_BLOCKSIZE,
+                    mReadOp.checksumType);
             }
         }
         if (! mOwner) {
@@ -1771,6 +2189,107 @@ Replicator::GetCounters(Replicator::Counters& counters)
     ReplicatorImpl::GetCounters(counters);
 }
 
+bool
+Replicator::StartRepairRead(ReadOp* op)
+{
+    assert(op && 0 <= op->repairCoefficient);
+    return RSRepairReader::Start(*op);
+}
+
+void
+Replicator::RepairRead(ReadOp* op)
+{
+    assert(op && 0 <= op->repairCoefficient);
+    RSRepairReader::Run(*op);
+}
+
+// The chunk server locations received from the meta server. Accessed from the
+// client threads, therefore protected by its own mutex.
+class RSRepairPeers
+{
+public:
+    static void Set(const vector<ServerLocation>& peers)
+    {
+        QCStMutexLocker lock(sMutex);
+        sLocations.clear();
+        sHosts.clear();
+        for (vector<ServerLocation>::const_iterator it = peers.begin();
+                it != peers.end();
+                ++it) {
+            sLocations.insert(*it);
+            sHosts.insert(it->hostname);
+        }
+        KFS_LOG_STREAM_DEBUG <<
+            "repair peers: " << sLocations.size() <<
+        KFS_LOG_EOM;
+    }
+    static bool IsChainAllowed(
+        const string& chain,
+        const string* peerHost,
+        string&       errMsg)
+    {
+        QCStMutexLocker lock(sMutex);
+        if (sLocations.empty()) {
+            errMsg = "repair chain: no chunk server list";
+            return false;
+        }
+        if (peerHost && sHosts.find(*peerHost) == sHosts.end()) {
+            errMsg = "repair chain: requestor is not chunk server";
+            return false;
+        }
+        string         hops = chain;
+        string         rest;
+        int            coef;
+        kfsChunkId_t   chunkId;
+        int64_t        version;
+        ServerLocation location;
+        while (! hops.empty()) {
+            if (! RSRepairReader::ParseHop(
+                    hops, coef, chunkId, version, location, rest)) {
+                errMsg = "invalid repair chain";
+                return false;
+            }
+            if (sLocations.find(location) == sLocations.end()) {
+                errMsg = "repair chain: " + location.ToString() +
+                    " is not chunk server";
+                return false;
+            }
+            hops.swap(rest);
+        }
+        return true;
+    }
+private:
+    typedef set<
+        ServerLocation,
+        less<ServerLocation>,
+        StdFastAllocator<ServerLocation>
+    > Locations;
+    typedef set<
+        string,
+        less<string>,
+        StdFastAllocator<string>
+    > Hosts;
+    static QCMutex   sMutex;
+    static Locations sLocations;
+    static Hosts     sHosts;
+};
+QCMutex                  RSRepairPeers::sMutex;
+RSRepairPeers::Locations RSRepairPeers::sLocations;
+RSRepairPeers::Hosts     RSRepairPeers::sHosts;
+
+void
+Replicator::SetRepairPeers(const vector<ServerLocation>& peers)
+{
+    RSRepairPeers::Set(peers);
+}
+
+bool
+Replicator::IsRepairChainAllowed(
+    const string& chain, const string* peerHost, string& errMsg)
+{
+    return RSRepairPeers::IsChainAllowed(chain, peerHost, errMsg);
+}
+
 void
 Replicator::Run(ReplicateChunkOp* op)
 {
@@ -1882,7 +2401,13 @@ Replicator::Run(ReplicateChunkOp* op)
             KFS_LOG_EOM;
             ReplicatorImpl::Ctrs().mRecoveryErrorCount++;
         } else {
-            impl = RSReplicatorImpl::Create(op, token, tokenLen, key, keyLen);
+            if (tokenLen <= 0 && ! op->rsRepairSources.empty()) {
+                impl = RSPipelinedReplicatorImpl::Create(op);
+            }
+            if (! impl) {
+                impl = RSReplicatorImpl::Create(
+                    op, token, tokenLen, key, keyLen);
+            }
         }
     }
     if (impl) {
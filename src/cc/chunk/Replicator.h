@@ -28,12 +28,20 @@
 #define CHUNKSERVER_REPLICATOR_H
 
 #include "common/kfstypes.h"
+#include "common/kfsdecls.h"
+
 #include <stdint.h>
 
+#include <string>
+#include <vector>
+
 namespace KFS
 {
+using std::string;
+using std::vector;
 
 struct ReplicateChunkOp;
+struct ReadOp;
 class Properties;
 class NetManager;
 
@@ -78,6 +86,19 @@ public:
     static void SetParameters(const Properties& props);
     static void GetCounters(Counters& counters);
     static void Shutdown();
+    // Pipelined recovery chain hop: starts the read from the next hop in the
+    // chain, if any. Returns false, and sets the op status on failure.
+    static bool StartRepairRead(ReadOp* op);
+    // Pipelined recovery chain hop: completes the repair read op once the
+    // local chunk data is read. Must be invoked on every repair read op
+    // completion once started, including the failures.
+    static void RepairRead(ReadOp* op);
+    // Sets the chunk server list received from the meta server.
+    static void SetRepairPeers(const vector<ServerLocation>& peers);
+    // Returns true if all the repair chain hops, and the requestor host,
+    // unless null, are chunk servers known to the meta server.
+    static bool IsRepairChainAllowed(
+        const string& chain, const string* peerHost, string& errMsg);
 };
 
 class ClientThread;
@@ -0,0 +1,642 @@
+//---------------------------------------------------------- -*- Mode: C++ -*-
+// $Id$
+//
+// Created 2026/10/16
+//
+// Copyright 2026 Quantcast Corp.
+//
+// This file is part of Kosmos File System (KFS).
+//
+// Licensed under the Apache License, Version 2.0
+// (the "License"); you may not use this file except in compliance with
+// the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+//
+// \file TierReadCache.cc
+// \brief Read cache of stable chunk copies in fast storage tier directories.
+//
+//----------------------------------------------------------------------------
+
+#include "TierReadCache.h"
+#include "BufferManager.h"
+
+#include "common/MsgLogger.h"
+#include "common/Properties.h"
+#include "kfsio/KfsCallbackObj.h"
+#include "kfsio/event.h"
+#include "kfsio/Globals.h"
+#include "qcdio/QCUtils.h"
+
+#include <errno.h>
+
+#include <algorithm>
+#include <utility>
+
+namespace KFS
+{
+
+using std::max;
+using std::min;
+using std::make_pair;
+using libkfsio::globalNetManager;
+
+class TierReadCache::Entry
+{
+public:
+    Entry(
+        kfsChunkId_t  inChunkId,
+        int64_t       inChunkVersion,
+        ByteCount     inFileSize,
+        const string& inDirName,
+        const string& inFileName,
+        bool          inBufferedIoFlag)
+        : mChunkId(inChunkId),
+          mChunkVersion(inChunkVersion),
+          mFileSize(inFileSize),
+          mDirName(inDirName),
+          mFileName(inFileName),
+          mBufferedIoFlag(inBufferedIoFlag),
+          mCopierPtr(0),
+          mFilePtr(),
+          mAccessTime(0)
+    {
+        QCDLListOp<Entry, 0>::Init(*this);
+        QCDLListOp<Entry, 1>::Init(*this);
+    }
+    const kfsChunkId_t mChunkId;
+    const int64_t      mChunkVersion;
+    const ByteCount    mFileSize;
+    const string       mDirName;
+    const string       mFileName;
+    const bool         mBufferedIoFlag;
+    Copier*            mCopierPtr;
+    DiskIo::FilePtr    mFilePtr;
+    time_t             mAccessTime;
+private:
+    Entry* mPrevPtr[2];
+    Entry* mNextPtr[2];
+
+    friend class QCDLListOp<Entry, 0>;
+    friend class QCDLListOp<Entry, 1>;
+private:
+    Entry(
+        const Entry& inEntry);
+    Entry& operator=(
+        const Entry& inEntry);
+};
+
+// Copies the chunk file, including the chunk header, sequentially with low
+// priority disk io requests. The copy file is padded to the io block size, the
+// chunk reads never access the padding.
+class TierReadCache::Copier : public KfsCallbackObj
+{
+public:
+    Copier(
+        TierReadCache&         inCache,
+        Entry&                 inEntry,
+        const DiskIo::FilePtr& inSrcFilePtr,
+        int                    inIoSize)
+        : KfsCallbackObj(),
+          mCache(inCache),
+          mEntry(inEntry),
+          mSrcFilePtr(inSrcFilePtr),
+          mDstFilePtr(new DiskIo::File()),
+          mDiskIoPtr(),
+          mBuf(),
+          mIoSize(inIoSize),
+          mPos(0),
+          mEnd(0),
+          mIoLength(0)
+        { SET_HANDLER(this, &Copier::Handle); }
+    virtual ~Copier()
+        { mDiskIoPtr.reset(); } // Cancel io in flight, if any.
+    void Start()
+    {
+        string theErrMsg;
+        if (! mDstFilePtr->Open(
+                mEntry.mFileName.c_str(),
+                mEntry.mFileSize + kBlockSize,
+                false, // inReadOnlyFlag
+                false, // inReserveFileSpaceFlag
+                true,  // inCreateFlag
+                &theErrMsg,
+                0,
+                mEntry.mBufferedIoFlag)) {
+            Error(theErrMsg.c_str(), -EIO);
+            return;
+        }
+        const int theBlockSize =
+            max(int(kBlockSize), mDstFilePtr->GetMinWriteBlkSize());
+        const int theMaxIoSize = (int)min(
+            size_t(mIoSize), max(DiskIo::GetMaxRequestSize(), size_t(1)));
+        mIoSize = max(theBlockSize, theMaxIoSize / theBlockSize * theBlockSize);
+        mEnd    = (mEntry.mFileSize + theBlockSize - 1) /
+            theBlockSize * theBlockSize;
+        Read();
+    }
+    const DiskIo::FilePtr& GetFilePtr() const
+        { return mDstFilePtr; }
+private:
+    enum { kBlockSize = 4 << 10 };
+
+    TierReadCache&        mCache;
+    Entry&                mEntry;
+    DiskIo::FilePtr       mSrcFilePtr;
+    DiskIo::FilePtr const mDstFilePtr;
+    DiskIoPtr             mDiskIoPtr;
+    IOBuffer              mBuf;
+    int                   mIoSize;
+    ByteCount             mPos;
+    ByteCount             mEnd;
+    int                   mIoLength;
+
+    int Handle(
+        int   inCode,
+        void* inDataPtr)
+    {
+        switch (inCode) {
+            case EVENT_DISK_READ: {
+                IOBuffer* const theBufPtr =
+                    reinterpret_cast<IOBuffer*>(inDataPtr);
+                if (! theBufPtr || theBufPtr->BytesConsumable() < mIoLength) {
+                    Error("short read", -EIO);
+                    break;
+                }
+                mBuf.Clear();
+                mBuf.Move(theBufPtr, mIoLength);
+                Write();
+                break;
+            }
+            case EVENT_DISK_WROTE: {
+                const int theLength = inDataPtr ?
+                    *reinterpret_cast<const int*>(inDataPtr) : -1;
+                if (theLength < mBuf.BytesConsumable()) {
+                    Error("short write", -EIO);
+                    break;
+                }
+                mBuf.Clear();
+                mPos += mIoLength;
+                if (mEntry.mFileSize <= mPos) {
+                    mDiskIoPtr.reset();
+                    mSrcFilePtr.reset();
+                    // The entry deletes this.
+                    mCache.CopyDone(mEntry, true);
+                    break;
+                }
+                Read();
+                break;
+            }
+            case EVENT_DISK_ERROR:
+                Error("io error", inDataPtr ?
+                    *reinterpret_cast<const int*>(inDataPtr) : -EIO);
+                break;
+            default:
+                Error("unexpected event", -EINVAL);
+                break;
+        }
+        return 0;
+    }
+    void Read()
+    {
+        // Do not compete with the clients for io buffers.
+        if (DiskIo::GetBufferManager().IsLowOnBuffers()) {
+            Error("low on io buffers", -ESERVERBUSY);
+            return;
+        }
+        mIoLength = (int)min(ByteCount(mIoSize), mEntry.mFileSize - mPos);
+        mDiskIoPtr.reset(new DiskIo(mSrcFilePtr, this));
+        const ssize_t theRet = mDiskIoPtr->Read(
+            mPos, (size_t)mIoLength, kKfsIoPriorityLow);
+        if (theRet < 0) {
+            Error("read", (int)theRet);
+        }
+    }
+    void Write()
+    {
+        const bool theLastFlag = mEntry.mFileSize <= mPos + mIoLength;
+        if (theLastFlag) {
+            // Disk io writes require complete io blocks.
+            mBuf.MakeBuffersFull();
+            mBuf.ZeroFill((int)(mEnd - mPos) - mBuf.BytesConsumable());
+        }
+        mDiskIoPtr.reset(new DiskIo(mDstFilePtr, this));
+        const ssize_t theRet = mDiskIoPtr->Write(
+            mPos,
+            (size_t)mBuf.BytesConsumable(),
+            &mBuf,
+            theLastFlag,
+            theLastFlag ? mEnd : DiskIo::Offset(-1),
+            kKfsIoPriorityLow
+        );
+        if (theRet < 0) {
+            Error("write", (int)theRet);
+        }
+    }
+    void Error(
+        const char* inMsgPtr,
+        int         inStatus)
+    {
+        KFS_LOG_STREAM(inStatus == -ESERVERBUSY ?
+                MsgLogger::kLogLevelDEBUG : MsgLogger::kLogLevelERROR) <<
+            "tier read cache:"
+            " chunk: "    << mEntry.mChunkId <<
+            " version: "  << mEntry.mChunkVersion <<
+            " copy: "     << mEntry.mFileName <<
+            " position: " << mPos <<
+            " "           << inMsgPtr <<
+            " "           << QCUtils::SysError(-inStatus) <<
+        KFS_LOG_EOM;
+        // The entry deletes this.
+        mCache.CopyDone(mEntry, false);
+    }
+private:
+    Copier(
+        const Copier& inCopier);
+    Copier& operator=(
+        const Copier& inCopier);
+};
+
+TierReadCache::TierReadCache()
+    : mEntries(),
+      mReadCounts(),
+      mMaxSize(0),
+      mSize(0),
+      mMinReadCount(4),
+      mReadCountHalfLifeSec(10 * 60),
+      mMaxTrackedChunks(64 << 10),
+      mMaxCopiesInFlight(2),
+      mCopyIoSize(1 << 20),
+      mMaxOpenFiles(64),
+      mInactiveFileCloseSec(60),
+      mCopiesInFlightCount(0),
+      mOpenFilesCount(0),
+      mNextReadCountDecayTime(0),
+      mCounters()
+{
+    Lru::Init(mLruPtr);
+    OpenFiles::Init(mOpenFilesPtr);
+}
+
+TierReadCache::~TierReadCache()
+{
+    TierReadCache::Shutdown();
+}
+
+    void
+TierReadCache::SetParameters(
+    const Properties& inProps)
+{
+    mMaxSize = max(ByteCount(0), inProps.getValue(
+        "chunkServer.tierReadCache.maxSize", mMaxSize));
+    mMinReadCount = max(1, inProps.getValue(
+        "chunkServer.tierReadCache.minReadCount", mMinReadCount));
+    mReadCountHalfLifeSec = max(1, inProps.getValue(
+        "chunkServer.tierReadCache.readCountHalfLifeSec",
+        mReadCountHalfLifeSec));
+    mMaxTrackedChunks = max(0, inProps.getValue(
+        "chunkServer.tierReadCache.maxTrackedChunks", mMaxTrackedChunks));
+    mMaxCopiesInFlight = max(0, inProps.getValue(
+        "chunkServer.tierReadCache.maxCopiesInFlight", mMaxCopiesInFlight));
+    mCopyIoSize = max(4 << 10, inProps.getValue(
+        "chunkServer.tierReadCache.copyIoSize", mCopyIoSize));
+    mMaxOpenFiles = max(1, inProps.getValue(
+        "chunkServer.tierReadCache.maxOpenFiles", mMaxOpenFiles));
+    mInactiveFileCloseSec = max(1, inProps.getValue(
+        "chunkServer.tierReadCache.inactiveFileCloseSec",
+        mInactiveFileCloseSec));
+    if (! IsEnabled()) {
+        mReadCounts.clear();
+    }
+    if (mMaxSize < mSize) {
+        Evict(mSize - mMaxSize);
+    }
+}
+
+    DiskIo::FilePtr
+TierReadCache::Get(
+    kfsChunkId_t inChunkId,
+    int64_t      inChunkVersion)
+{
+    Entries::iterator const theIt = mEntries.find(inChunkId);
+    if (theIt == mEntries.end()) {
+        return DiskIo::FilePtr();
+    }
+    Entry& theEntry = *theIt->second;
+    if (theEntry.mCopierPtr) {
+        return DiskIo::FilePtr();
+    }
+    if (theEntry.mChunkVersion != inChunkVersion) {
+        mCounters.mInvalidateCount++;
+        Erase(theIt, true);
+        return DiskIo::FilePtr();
+    }
+    const time_t theNow = globalNetManager().Now();
+    if (! theEntry.mFilePtr) {
+        if (mMaxOpenFiles <= mOpenFilesCount &&
+                ! CloseInactiveFiles(theNow, true)) {
+            return DiskIo::FilePtr();
+        }
+        DiskIo::FilePtr theFilePtr(new DiskIo::File());
+        string          theErrMsg;
+        if (! theFilePtr->Open(
+                theEntry.mFileName.c_str(),
+                -1,
+                true,  // inReadOnlyFlag
+                false, // inReserveFileSpaceFlag
+                false, // inCreateFlag
+                &theErrMsg,
+                0,
+                theEntry.mBufferedIoFlag)) {
+            KFS_LOG_STREAM_ERROR <<
+                "tier read cache:"
+                " chunk: "  << theEntry.mChunkId <<
+                " version: " << theEntry.mChunkVersion <<
+                " open: "   << theEntry.mFileName <<
+                " "         << theErrMsg <<
+            KFS_LOG_EOM;
+            mCounters.mInvalidateCount++;
+            Erase(theIt, true);
+            return DiskIo::FilePtr();
+        }
+        theEntry.mFilePtr = theFilePtr;
+        mOpenFilesCount++;
+    }
+    theEntry.mAccessTime = theNow;
+    Lru::PushFront(mLruPtr, theEntry);
+    OpenFiles::PushFront(mOpenFilesPtr, theEntry);
+    return theEntry.mFilePtr;
+}
+
+    bool
+TierReadCache::IsFileEquals(
+    kfsChunkId_t  inChunkId,
+    int64_t       inChunkVersion,
+    const DiskIo* inDiskIoPtr) const
+{
+    if (! inDiskIoPtr) {
+        return false;
+    }
+    Entries::const_iterator const theIt = mEntries.find(inChunkId);
+    return (theIt != mEntries.end() &&
+        ! theIt->second->mCopierPtr &&
+        theIt->second->mChunkVersion == inChunkVersion &&
+        theIt->second->mFilePtr &&
+        theIt->second->mFilePtr == inDiskIoPtr->GetFilePtr()
+    );
+}
+
+    bool
+TierReadCache::RecordRead(
+    kfsChunkId_t inChunkId,
+    int64_t      inChunkVersion)
+{
+    if (! IsEnabled()) {
+        return false;
+    }
+    ReadCounts::iterator theIt = mReadCounts.find(inChunkId);
+    if (theIt == mReadCounts.end()) {
+        if ((size_t)mMaxTrackedChunks <= mReadCounts.size()) {
+            return false;
+        }
+        theIt = mReadCounts.insert(
+            make_pair(inChunkId, ReadCount(inChunkVersion))).first;
+    } else if (theIt->second.mChunkVersion != inChunkVersion) {
+        theIt->second = ReadCount(inChunkVersion);
+    }
+    theIt->second.mCount++;
+    return (
+        mMinReadCount <= theIt->second.mCount &&
+        mCopiesInFlightCount < mMaxCopiesInFlight &&
+        mEntries.find(inChunkId) == mEntries.end()
+    );
+}
+
+    bool
+TierReadCache::Add(
+    kfsChunkId_t           inChunkId,
+    int64_t                inChunkVersion,
+    TierReadCache::ByteCount inFileSize,
+    const DiskIo::FilePtr& inSrcFilePtr,
+    const string&          inDirName,
+    const string&          inFileName,
+    bool                   inBufferedIoFlag)
+{
+    if (! IsEnabled() || inFileSize <= 0 || mMaxSize < inFileSize ||
+            ! inSrcFilePtr || ! inSrcFilePtr->IsOpen() ||
+            mMaxCopiesInFlight <= mCopiesInFlightCount ||
+            mEntries.find(inChunkId) != mEntries.end()) {
+        return false;
+    }
+    if (mMaxSize < mSize + inFileSize &&
+            ! Evict(mSize + inFileSize - mMaxSize)) {
+        return false;
+    }
+    Entry& theEntry = *(new Entry(inChunkId, inChunkVersion, inFileSize,
+        inDirName, inFileName, inBufferedIoFlag));
+    mEntries.insert(make_pair(inChunkId, &theEntry));
+    mSize += inFileSize;
+    mCopiesInFlightCount++;
+    mCounters.mAdmitCount++;
+    KFS_LOG_STREAM_DEBUG <<
+        "tier read cache:"
+        " chunk: "   << inChunkId <<
+        " version: " << inChunkVersion <<
+        " size: "    << inFileSize <<
+        " copy: "    << inFileName <<
+    KFS_LOG_EOM;
+    theEntry.mCopierPtr = new Copier(
+        *this, theEntry, inSrcFilePtr, mCopyIoSize);
+    // Start can invoke CopyDone(), the entry must not be accessed after.
+    theEntry.mCopierPtr->Start();
+    return true;
+}
+
+    void
+TierReadCache::CopyDone(
+    TierReadCache::Entry& inEntry,
+    bool                  inOkFlag)
+{
+    Copier* const theCopierPtr = inEntry.mCopierPtr;
+    inEntry.mCopierPtr = 0;
+    mCopiesInFlightCount--;
+    if (inOkFlag) {
+        mCounters.mCopyDoneCount++;
+        // Keep the copy file open for the subsequent reads.
+        inEntry.mFilePtr    = theCopierPtr->GetFilePtr();
+        inEntry.mAccessTime = globalNetManager().Now();
+        delete theCopierPtr;
+        mOpenFilesCount++;
+        Lru::PushFront(mLruPtr, inEntry);
+        OpenFiles::PushFront(mOpenFilesPtr, inEntry);
+        if (mMaxSize < mSize) {
+            Evict(mSize - mMaxSize);
+        }
+        return;
+    }
+    mCounters.mCopyErrorCount++;
+    delete theCopierPtr;
+    Erase(mEntries.find(inEntry.mChunkId), true);
+}
+
+    void
+TierReadCache::Invalidate(
+    kfsChunkId_t inChunkId)
+{
+    Entries::iterator const theIt = mEntries.find(inChunkId);
+    if (theIt != mEntries.end()) {
+        mCounters.mInvalidateCount++;
+        Erase(theIt, true);
+    }
+}
+
+    void
+TierReadCache::Invalidate(
+    kfsChunkId_t  inChunkId,
+    const DiskIo* inDiskIoPtr)
+{
+    Entries::iterator const theIt = mEntries.find(inChunkId);
+    if (inDiskIoPtr && theIt != mEntries.end() && theIt->second->mFilePtr &&
+            theIt->second->mFilePtr == inDiskIoPtr->GetFilePtr()) {
+        mCounters.mInvalidateCount++;
+        Erase(theIt, true);
+    }
+}
+
+    void
+TierReadCache::DirLost(
+    const string& inDirName)
+{
+    Entries::iterator theIt = mEntries.begin();
+    while (theIt != mEntries.end()) {
+        if (theIt->second->mDirName == inDirName) {
+            Erase(theIt++, false);
+        } else {
+            ++theIt;
+        }
+    }
+}
+
+    void
+TierReadCache::Timeout(
+    time_t inNow)
+{
+    if (mNextReadCountDecayTime <= inNow) {
+        DecayReadCounts();
+        mNextReadCountDecayTime = inNow + mReadCountHalfLifeSec;
+    }
+    CloseInactiveFiles(inNow, false);
+    while (mMaxOpenFiles < mOpenFilesCount &&
+            CloseInactiveFiles(inNow, true))
+        {}
+}
+
+    void
+TierReadCache::Shutdown()
+{
+    // Leave the copies in place, these are removed on restart.
+    while (! mEntries.empty()) {
+        Erase(mEntries.begin(), false);
+    }
+    mReadCounts.clear();
+}
+
+    void
+TierReadCache::Erase(
+    TierReadCache::Entries::iterator inIt,
+    bool                             inDeleteFileFlag)
+{
+    Entry* const theEntryPtr = inIt->second;
+    mEntries.erase(inIt);
+    if (theEntryPtr->mCopierPtr) {
+        delete theEntryPtr->mCopierPtr;
+        mCopiesInFlightCount--;
+    }
+    if (theEntryPtr->mFilePtr) {
+        CloseFile(*theEntryPtr);
+    }
+    Lru::Remove(mLruPtr, *theEntryPtr);
+    mSize -= theEntryPtr->mFileSize;
+    // Reads in flight, if any, hold on to the file descriptor, therefore
+    // the file can be removed now.
+    if (inDeleteFileFlag &&
+            ! DiskIo::Delete(theEntryPtr->mFileName.c_str())) {
+        KFS_LOG_STREAM_ERROR <<
+            "tier read cache: failed to delete: " << theEntryPtr->mFileName <<
+        KFS_LOG_EOM;
+    }
+    delete theEntryPtr;
+}
+
+    bool
+TierReadCache::Evict(
+    TierReadCache::ByteCount inByteCount)
+{
+    ByteCount theRem = inByteCount;
+    while (0 < theRem) {
+        const Entry* const theEntryPtr = Lru::Back(mLruPtr);
+        if (! theEntryPtr) {
+            break;
+        }
+        theRem -= theEntryPtr->mFileSize;
+        mCounters.mEvictCount++;
+        Erase(mEntries.find(theEntryPtr->mChunkId), true);
+    }
+    return (theRem <= 0);
+}
+
+    void
+TierReadCache::CloseFile(
+    TierReadCache::Entry& inEntry)
+{
+    OpenFiles::Remove(mOpenFilesPtr, inEntry);
+    mOpenFilesCount--;
+    // The file is closed when the last io that uses it completes.
+    inEntry.mFilePtr.reset();
+}
+
+    bool
+TierReadCache::CloseInactiveFiles(
+    time_t inNow,
+    bool   inCloseOneFlag)
+{
+    // The open files list is in the access time order, the least recently
+    // accessed is at the back.
+    const time_t theExpireTime = inNow - mInactiveFileCloseSec;
+    Entry*       thePtr        = OpenFiles::Back(mOpenFilesPtr);
+    for (int i = mOpenFilesCount; thePtr && 0 < i; i--) {
+        Entry& theEntry = *thePtr;
+        thePtr = &OpenFiles::GetPrev(theEntry);
+        if (! inCloseOneFlag && theExpireTime < theEntry.mAccessTime) {
+            break;
+        }
+        if (theEntry.mFilePtr.unique()) {
+            CloseFile(theEntry);
+            if (inCloseOneFlag) {
+                return true;
+            }
+        }
+    }
+    return ! inCloseOneFlag;
+}
+
+    void
+TierReadCache::DecayReadCounts()
+{
+    ReadCounts::iterator theIt = mReadCounts.begin();
+    while (theIt != mReadCounts.end()) {
+        if ((theIt->second.mCount /= 2) <= 0) {
+            mReadCounts.erase(theIt++);
+        } else {
+            ++theIt;
+        }
+    }
+}
+
+}
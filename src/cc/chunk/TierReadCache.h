@@ -0,0 +1,206 @@
+//---------------------------------------------------------- -*- Mode: C++ -*-
+// $Id$
+//
+// Created 2026/10/16
+//
+// Copyright 2026 Quantcast Corp.
+//
+// This file is part of Kosmos File System (KFS).
+//
+// Licensed under the Apache License, Version 2.0
+// (the "License"); you may not use this file except in compliance with
+// the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+//
+// \file TierReadCache.h
+// \brief Read cache of stable chunk copies in fast storage tier directories.
+//
+//----------------------------------------------------------------------------
+
+#ifndef TIER_READ_CACHE_H
+#define TIER_READ_CACHE_H
+
+#include "DiskIo.h"
+
+#include "common/kfstypes.h"
+#include "common/StdAllocator.h"
+#include "qcdio/QCDLList.h"
+
+#include <time.h>
+
+#include <map>
+#include <string>
+
+namespace KFS
+{
+
+using std::map;
+using std::less;
+using std::pair;
+using std::string;
+
+class Properties;
+
+// Cache of complete copies of frequently read stable chunks, whose files
+// reside in slow storage tier chunk directories. The copies are kept in the
+// sub directory of the fast storage tier chunk directories. The copies are not
+// chunks: the meta server is not aware of their existence, and the copies are
+// removed on restart. The chunk read is admitted into the cache once the
+// number of chunk reads, that is halved periodically, reaches the configured
+// threshold. The copy is created in the background by reading the chunk file
+// and writing the copy with low priority disk io. The least recently used
+// copies are removed in order to keep the total size of the copies within the
+// configured limit.
+class TierReadCache
+{
+public:
+    typedef int64_t ByteCount;
+    struct Counters
+    {
+        typedef int64_t Counter;
+
+        Counter mAdmitCount;
+        Counter mCopyDoneCount;
+        Counter mCopyErrorCount;
+        Counter mEvictCount;
+        Counter mInvalidateCount;
+
+        Counters()
+            { Clear(); }
+        void Clear()
+        {
+            mAdmitCount      = 0;
+            mCopyDoneCount   = 0;
+            mCopyErrorCount  = 0;
+            mEvictCount      = 0;
+            mInvalidateCount = 0;
+        }
+    };
+
+    TierReadCache();
+    ~TierReadCache();
+    void SetParameters(
+        const Properties& inProps);
+    bool IsEnabled() const
+        { return (0 < mMaxSize); }
+    ByteCount GetSize() const
+        { return mSize; }
+    int GetCopiesInFlightCount() const
+        { return mCopiesInFlightCount; }
+    const Counters& GetCounters() const
+        { return mCounters; }
+    // Returns the file of the complete chunk copy, or null if the copy does
+    // not exist, or can not be opened.
+    DiskIo::FilePtr Get(
+        kfsChunkId_t inChunkId,
+        int64_t      inChunkVersion);
+    // Returns true if the disk io uses the file of the current chunk copy.
+    bool IsFileEquals(
+        kfsChunkId_t  inChunkId,
+        int64_t       inChunkVersion,
+        const DiskIo* inDiskIoPtr) const;
+    // Counts chunk read, and returns true if the chunk should be added to the
+    // cache.
+    bool RecordRead(
+        kfsChunkId_t inChunkId,
+        int64_t      inChunkVersion);
+    // Starts copying chunk file, with the specified size, into the specified
+    // file in the fast storage tier directory.
+    bool Add(
+        kfsChunkId_t           inChunkId,
+        int64_t                inChunkVersion,
+        ByteCount              inFileSize,
+        const DiskIo::FilePtr& inSrcFilePtr,
+        const string&          inDirName,
+        const string&          inFileName,
+        bool                   inBufferedIoFlag);
+    void Invalidate(
+        kfsChunkId_t inChunkId);
+    // Invalidates the chunk copy only if the disk io uses the copy file.
+    void Invalidate(
+        kfsChunkId_t  inChunkId,
+        const DiskIo* inDiskIoPtr);
+    // Removes copies in the chunk directory that is no longer available.
+    void DirLost(
+        const string& inDirName);
+    void Timeout(
+        time_t inNow);
+    void Shutdown();
+private:
+    class Entry;
+    class Copier;
+    friend class Copier;
+    typedef QCDLList<Entry, 0> Lru;
+    typedef QCDLList<Entry, 1> OpenFiles;
+    typedef map<
+        kfsChunkId_t,
+        Entry*,
+        less<kfsChunkId_t>,
+        StdFastAllocator<pair<const kfsChunkId_t, Entry*> >
+    > Entries;
+    struct ReadCount
+    {
+        ReadCount(
+            int64_t inChunkVersion = -1)
+            : mChunkVersion(inChunkVersion),
+              mCount(0)
+            {}
+        int64_t mChunkVersion;
+        int     mCount;
+    };
+    typedef map<
+        kfsChunkId_t,
+        ReadCount,
+        less<kfsChunkId_t>,
+        StdFastAllocator<pair<const kfsChunkId_t, ReadCount> >
+    > ReadCounts;
+
+    Entries    mEntries;
+    ReadCounts mReadCounts;
+    Entry*     mLruPtr[1];
+    Entry*     mOpenFilesPtr[2]; // The open files list index is 1.
+    ByteCount  mMaxSize;
+    ByteCount  mSize;
+    int        mMinReadCount;
+    int        mReadCountHalfLifeSec;
+    int        mMaxTrackedChunks;
+    int        mMaxCopiesInFlight;
+    int        mCopyIoSize;
+    int        mMaxOpenFiles;
+    int        mInactiveFileCloseSec;
+    int        mCopiesInFlightCount;
+    int        mOpenFilesCount;
+    time_t     mNextReadCountDecayTime;
+    Counters   mCounters;
+
+    void CopyDone(
+        Entry& inEntry,
+        bool   inOkFlag);
+    void Erase(
+        Entries::iterator inIt,
+        bool              inDeleteFileFlag);
+    bool Evict(
+        ByteCount inByteCount);
+    void CloseFile(
+        Entry& inEntry);
+    bool CloseInactiveFiles(
+        time_t inNow,
+        bool   inCloseOneFlag);
+    void DecayReadCounts();
+private:
+    TierReadCache(
+        const TierReadCache& inCache);
+    TierReadCache& operator=(
+        const TierReadCache& inCache);
+};
+
+}
+
+#endif /* TIER_READ_CACHE_H */
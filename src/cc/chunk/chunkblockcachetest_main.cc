@@ -0,0 +1,289 @@
+//---------------------------------------------------------- -*- Mode: C++ -*-
+// $Id$
+//
+// Created 2026/10/16
+//
+// Copyright 2026 Quantcast Corp.
+//
+// This file is part of Kosmos File System (KFS).
+//
+// Licensed under the Apache License, Version 2.0
+// (the "License"); you may not use this file except in compliance with
+// the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+//
+// Chunk checksum block cache unit test: hit, miss, partial tail block,
+// version mismatch, invalidation, lru eviction, and buffer manager pressure.
+//
+//----------------------------------------------------------------------------
+
+#include "ChunkBlockCache.h"
+#include "BufferManager.h"
+
+#include "kfsio/checksum.h"
+#include "kfsio/IOBuffer.h"
+
+#include <iostream>
+#include <string>
+
+namespace KFS
+{
+
+using std::cerr;
+using std::cout;
+using std::string;
+
+class ChunkBlockCacheTest
+{
+public:
+    enum { kBlockSize = (int)CHECKSUM_BLOCKSIZE };
+
+    ChunkBlockCacheTest()
+        : mBufferManager(true),
+          mCache(),
+          mErrorCount(0)
+    {
+        mBufferManager.Init(
+            0,                             // No buffer pool.
+            BufferManager::ByteCount(64) * kBlockSize,
+            BufferManager::ByteCount(64) * kBlockSize,
+            0
+        );
+        mCache.SetBufferManager(&mBufferManager);
+        mCache.SetMaxSize(BufferManager::ByteCount(16) * kBlockSize);
+    }
+    int Run()
+    {
+        TestMiss();
+        TestHit();
+        TestTail();
+        TestInvalidate();
+        TestEviction();
+        TestBufferPressure();
+        TestDisable();
+        if (mErrorCount <= 0) {
+            cout << "chunk block cache test: passed\n";
+        }
+        return (mErrorCount <= 0 ? 0 : 1);
+    }
+private:
+    class Waiter : public BufferManager::Client
+    {
+    public:
+        Waiter()
+            : BufferManager::Client()
+            {}
+        virtual void Granted(
+            ByteCount /* inByteCount */)
+            {}
+    };
+
+    BufferManager   mBufferManager;
+    ChunkBlockCache mCache;
+    int             mErrorCount;
+
+    void Expect(
+        bool        inFlag,
+        const char* inMsgPtr)
+    {
+        if (! inFlag) {
+            cerr << "chunk block cache test: failed: " << inMsgPtr << "\n";
+            mErrorCount++;
+        }
+    }
+    static void Fill(
+        IOBuffer&    inBuf,
+        kfsChunkId_t inChunkId,
+        int64_t      inOffset,
+        int          inLength)
+    {
+        string theData;
+        theData.reserve(inLength);
+        for (int i = 0; i < inLength; i++) {
+            theData.push_back((char)((inChunkId * 131 + inOffset + i) % 251));
+        }
+        inBuf.CopyIn(theData.data(), inLength);
+    }
+    static bool Equals(
+        IOBuffer&    inBuf,
+        kfsChunkId_t inChunkId,
+        int64_t      inOffset,
+        int          inLength)
+    {
+        IOBuffer theExpected;
+        Fill(theExpected, inChunkId, inOffset, inLength);
+        return (inBuf.BytesConsumable() == inLength &&
+            theExpected.BytesConsumable() == inLength &&
+            ComputeBlockChecksum(&inBuf, inLength) ==
+            ComputeBlockChecksum(&theExpected, inLength));
+    }
+    bool Put(
+        kfsChunkId_t inChunkId,
+        int64_t      inVersion,
+        int64_t      inOffset,
+        int          inLength)
+    {
+        IOBuffer theBuf;
+        Fill(theBuf, inChunkId, inOffset, inLength);
+        mCache.Put(inChunkId, inVersion, inOffset, theBuf);
+        return (theBuf.BytesConsumable() == inLength);
+    }
+    bool Get(
+        kfsChunkId_t inChunkId,
+        int64_t      inVersion,
+        int64_t      inOffset,
+        int          inLength)
+    {
+        IOBuffer theBuf;
+        if (! mCache.Get(inChunkId, inVersion, inOffset, inLength, theBuf)) {
+            Expect(theBuf.IsEmpty(), "miss must not return data");
+            return false;
+        }
+        Expect(Equals(theBuf, inChunkId, inOffset, inLength),
+            "cached data mismatch");
+        return true;
+    }
+    bool IsAccounted()
+    {
+        return (mCache.GetSize() == mCache.GetByteCount() &&
+            mBufferManager.GetUsedByteCount() == mCache.GetByteCount());
+    }
+    void TestMiss()
+    {
+        Expect(mCache.IsEnabled(), "cache must be enabled");
+        Expect(! Get(1, 1, 0, kBlockSize), "empty cache hit");
+        Expect(Put(1, 1, 0, 3 * kBlockSize), "put must not modify buffer");
+        Expect(! Get(1, 1, kBlockSize / 2, kBlockSize), "unaligned read hit");
+        Expect(! Get(1, 1, 0, 4 * kBlockSize), "partially cached range hit");
+        Expect(! Get(1, 2, 0, kBlockSize), "other version hit");
+        Expect(! Get(2, 1, 0, kBlockSize), "other chunk hit");
+        mCache.Clear();
+        Expect(mCache.GetSize() == 0 && IsAccounted(), "clear");
+    }
+    void TestHit()
+    {
+        Put(1, 1, 0, 3 * kBlockSize);
+        Expect(mCache.GetSize() == 3 * kBlockSize, "size after put");
+        Expect(Get(1, 1, 0, 3 * kBlockSize), "full range miss");
+        Expect(Get(1, 1, kBlockSize, kBlockSize), "middle block miss");
+        Expect(Get(1, 1, kBlockSize, kBlockSize + 10), "partial range miss");
+        Put(1, 1, 2 * kBlockSize, 2 * kBlockSize);
+        Expect(mCache.GetSize() == 4 * kBlockSize, "overlapping put size");
+        Expect(Get(1, 1, 0, 4 * kBlockSize), "extended range miss");
+        Expect(IsAccounted(), "hit accounting");
+        mCache.Clear();
+    }
+    void TestTail()
+    {
+        const int theLength = 2 * kBlockSize + 100;
+        Put(2, 1, 0, theLength);
+        Expect(mCache.GetSize() == 3 * kBlockSize, "tail block not cached");
+        Expect(Get(2, 1, 0, theLength), "read with tail miss");
+        Expect(Get(2, 1, 2 * kBlockSize, 100), "tail block miss");
+        IOBuffer theBuf;
+        Expect(mCache.Get(2, 1, 2 * kBlockSize, kBlockSize, theBuf) &&
+            theBuf.BytesConsumable() == kBlockSize,
+            "zero padded tail block miss");
+        theBuf.Consume(100);
+        char theByte = 1;
+        bool theZeroFlag = true;
+        while (theZeroFlag && theBuf.CopyOut(&theByte, 1) == 1) {
+            theZeroFlag = theByte == 0;
+            theBuf.Consume(1);
+        }
+        Expect(theZeroFlag, "tail block is not zero padded");
+        Expect(IsAccounted(), "tail accounting");
+        mCache.Clear();
+    }
+    void TestInvalidate()
+    {
+        // The chunk manager invalidates chunk's blocks on write, truncate,
+        // version change and delete.
+        Put(3, 1, 0, 2 * kBlockSize);
+        Put(4, 1, 0, 2 * kBlockSize);
+        Put(5, 1, 0, 2 * kBlockSize);
+        mCache.Invalidate(4);
+        Expect(! Get(4, 1, 0, kBlockSize), "invalidated chunk hit");
+        Expect(Get(3, 1, 0, 2 * kBlockSize) && Get(5, 1, 0, 2 * kBlockSize),
+            "invalidate removed other chunks");
+        Expect(mCache.GetSize() == 4 * kBlockSize && IsAccounted(),
+            "invalidate accounting");
+        // Re-written chunk with the new version must not return the old data.
+        Put(4, 2, kBlockSize, kBlockSize);
+        Expect(! Get(4, 1, kBlockSize, kBlockSize), "stale version hit");
+        Expect(Get(4, 2, kBlockSize, kBlockSize), "new version miss");
+        mCache.Clear();
+    }
+    void TestEviction()
+    {
+        mCache.SetMaxSize(4 * kBlockSize);
+        Put(6, 1, 0, 4 * kBlockSize);
+        Expect(Get(6, 1, 0, kBlockSize), "block 0 miss");
+        Put(6, 1, 4 * kBlockSize, kBlockSize);
+        Expect(mCache.GetSize() == 4 * kBlockSize, "size exceeds max");
+        Expect(Get(6, 1, 0, kBlockSize), "recently used block evicted");
+        Expect(! Get(6, 1, kBlockSize, kBlockSize),
+            "least recently used block not evicted");
+        Expect(Get(6, 1, 2 * kBlockSize, 3 * kBlockSize), "blocks 2-4 miss");
+        mCache.SetMaxSize(2 * kBlockSize);
+        Expect(mCache.GetSize() == 2 * kBlockSize && IsAccounted(),
+            "max size decrease");
+        Expect(Get(6, 1, 3 * kBlockSize, 2 * kBlockSize),
+            "most recently used blocks evicted");
+        mCache.SetMaxSize(16 * kBlockSize);
+        mCache.Clear();
+    }
+    void TestBufferPressure()
+    {
+        Put(7, 1, 0, 8 * kBlockSize);
+        Expect(mCache.GetSize() == 8 * kBlockSize, "size before pressure");
+        Waiter theWaiter;
+        Expect(! mBufferManager.Get(theWaiter,
+            mBufferManager.GetRemainingByteCount() + kBlockSize),
+            "request must wait");
+        Expect(0 < mBufferManager.GetWaitingCount(), "no waiting client");
+        Put(8, 1, 0, kBlockSize);
+        Expect(! Get(8, 1, 0, kBlockSize),
+            "block added while other client waits for buffers");
+        Expect(mCache.GetSize() < 8 * kBlockSize,
+            "blocks not released while other client waits for buffers");
+        mCache.Shrink();
+        Expect(mCache.GetSize() <= 0 && IsAccounted(), "shrink");
+        theWaiter.CancelRequest();
+        theWaiter.Unregister();
+        mCache.Clear();
+    }
+    void TestDisable()
+    {
+        Put(9, 1, 0, 2 * kBlockSize);
+        mCache.SetBufferManager(0);
+        Expect(! mCache.IsEnabled(), "enabled without buffer manager");
+        Expect(mCache.GetSize() == 0 &&
+            mBufferManager.GetUsedByteCount() == 0, "buffers not released");
+        Put(9, 1, 0, 2 * kBlockSize);
+        Expect(mCache.GetSize() == 0, "put without buffer manager");
+    }
+private:
+    ChunkBlockCacheTest(
+        const ChunkBlockCacheTest& inTest);
+    ChunkBlockCacheTest& operator=(
+        const ChunkBlockCacheTest& inTest);
+};
+
+}
+
+    int
+main(
+    int    /* inArgCount */,
+    char** /* inArgs */)
+{
+    KFS::ChunkBlockCacheTest theTest;
+    return theTest.Run();
+}
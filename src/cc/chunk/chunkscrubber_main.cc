@@ -210,7 +210,8 @@ scrubFile(const string& fn, bool hdrChksumRequiredFlag,
     for (int i = 0, b = 0;
             i < chunkInfo.chunkSize;
             i += CHECKSUM_BLOCKSIZE, b++) {
-        const uint32_t cksum = ComputeBlockChecksum(buf + i, CHECKSUM_BLOCKSIZE);
+        const uint32_t cksum = ComputeBlockChecksum(buf + i,
+            CHECKSUM_BLOCKSIZE, chunkInfo.GetChecksumType());
         if (cksum != chunkInfo.chunkBlockChecksum[b]) {
             KFS_LOG_STREAM_ERROR <<
                 fn << ": checksum mismatch"
@@ -324,6 +324,7 @@ public:
           mClientListenerIpV6OnlyFlag(false),
           mClientThreadCount(0),
           mFirstCpuIndex(-1),
+          mClientThreadReusePortFlag(false),
           mChunkServerHostname(),
           mClusterKey(),
           mChunkServerRackId(-1),
@@ -341,6 +342,7 @@ private:
     bool           mClientListenerIpV6OnlyFlag;
     int            mClientThreadCount;
     int            mFirstCpuIndex;
+    bool           mClientThreadReusePortFlag;
     string         mChunkServerHostname;
     string         mClusterKey;
     int            mChunkServerRackId;
@@ -441,8 +443,12 @@ ChunkServerMain::LoadParams(const char* fileName)
         "chunkServer.clientThreadCount", mClientThreadCount);
     mFirstCpuIndex = mProp.getValue(
         "chunkServer.clientThreadFirstCpuIndex", mFirstCpuIndex);
+    mClientThreadReusePortFlag = mProp.getValue(
+        "chunkServer.clientThreadReusePort",
+        mClientThreadReusePortFlag ? 1 : 0) != 0;
     KFS_LOG_STREAM_INFO << "chunk server client thread count: " <<
         mClientThreadCount <<  " first cpu: " << mFirstCpuIndex <<
+        " reuse port: " << mClientThreadReusePortFlag <<
     KFS_LOG_EOM;
 
     mChunkServerHostname = mProp.getValue("chunkServer.hostname",
@@ -602,7 +608,8 @@ ChunkServerMain::Run(int argc, char **argv)
                 mClientListenerIpV6OnlyFlag,
                 mChunkServerHostname,
                 mClientThreadCount,
-                mFirstCpuIndex)) {
+                mFirstCpuIndex,
+                mClientThreadReusePortFlag)) {
         ret = gChunkServer.MainLoop(mChunkDirs, mProp, mLogDir) ? 0 : 1;
     }
     NetErrorSimulatorConfigure(globalNetManager());
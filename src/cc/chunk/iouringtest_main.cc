@@ -0,0 +1,537 @@
+//---------------------------------------------------------- -*- Mode: C++ -*-
+// $Id$
+//
+// Created 2026/10/16
+//
+// Copyright 2026 Quantcast Corp.
+//
+// This file is part of Kosmos File System (KFS).
+//
+// Licensed under the Apache License, Version 2.0
+// (the "License"); you may not use this file except in compliance with
+// the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+//
+// Io uring io method unit test: open and create through the ring, write,
+// write with sync, read back, short reads at and past the end of file,
+// more requests in flight than the ring slots, close with truncate, and the
+// delete and rename meta requests, with the disk queue in temporary
+// directory. The test is skipped if io uring is not available.
+//
+//----------------------------------------------------------------------------
+
+#include "IOMethodDef.h"
+
+#include "common/Properties.h"
+
+#include "qcdio/QCDiskQueue.h"
+#include "qcdio/QCIoBufferPool.h"
+#include "qcdio/QCMutex.h"
+#include "qcdio/QCUtils.h"
+#include "qcdio/qcstutils.h"
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace KFS
+{
+
+extern KFS_DECLARE_IO_METHOD(KFS_IO_METHOD_NAME_IOURING);
+
+using std::cerr;
+using std::cout;
+using std::ostringstream;
+using std::string;
+using std::vector;
+
+class IOUringMethodTest
+{
+public:
+    enum
+    {
+        kBlockSize   = 4 << 10,
+        kFileBlocks  = 64,
+        kMaxFileSize = kFileBlocks * kBlockSize,
+        kQueueDepth  = 8,
+        kFileCount   = 4
+    };
+
+    IOUringMethodTest()
+        : mBufferPool(),
+          mQueue(),
+          mMethodPtr(0),
+          mProcessorPtr(0),
+          mDirName(),
+          mBufs(),
+          mErrorCount(0)
+        {}
+    ~IOUringMethodTest()
+    {
+        if (mMethodPtr) {
+            mQueue.Stop();
+            delete mMethodPtr;
+        }
+        for (Bufs::const_iterator theIt = mBufs.begin();
+                theIt != mBufs.end();
+                ++theIt) {
+            free(*theIt);
+        }
+        if (! mDirName.empty()) {
+            unlink(FileName("a").c_str());
+            unlink(FileName("b").c_str());
+            unlink(FileName("c").c_str());
+            rmdir(mDirName.c_str());
+        }
+    }
+    int Run()
+    {
+        if (! Start()) {
+            return (mErrorCount <= 0 ? 0 : 1);
+        }
+        const QCDiskQueue::FileIdx theFileIdx = Open("a");
+        if (0 <= theFileIdx) {
+            TestWriteRead(theFileIdx);
+            TestShortRead(theFileIdx);
+            TestInFlight(theFileIdx);
+            TestClose(theFileIdx);
+        }
+        TestMeta();
+        if (mErrorCount <= 0) {
+            cout << "io uring method test: passed\n";
+        }
+        return (mErrorCount <= 0 ? 0 : 1);
+    }
+private:
+    typedef vector<char*> Bufs;
+
+    class Iterator : public QCDiskQueue::InputIterator
+    {
+    public:
+        Iterator(
+            char** inBufsPtr,
+            int    inCount)
+            : mCurPtr(inBufsPtr),
+              mEndPtr(inBufsPtr + inCount)
+            {}
+        virtual char* Get()
+            { return (mCurPtr < mEndPtr ? *mCurPtr++ : 0); }
+    private:
+        char**       mCurPtr;
+        char** const mEndPtr;
+    };
+    class Waiter : public QCDiskQueue::IoCompletion
+    {
+    public:
+        Waiter()
+            : mMutex(),
+              mDoneCond(),
+              mRequestCount(0),
+              mErrorCount(0),
+              mIoByteCount(0)
+            {}
+        virtual ~Waiter()
+            { Waiter::Wait(); }
+        virtual bool Done(
+            QCDiskQueue::RequestId      /* inRequestId */,
+            QCDiskQueue::FileIdx        /* inFileIdx */,
+            QCDiskQueue::BlockIdx       /* inStartBlockIdx */,
+            QCDiskQueue::InputIterator& /* inBufferItr */,
+            int                         /* inBufferCount */,
+            QCDiskQueue::Error          inCompletionCode,
+            int                         inSysErrorCode,
+            int64_t                     inIoByteCount)
+        {
+            QCStMutexLocker theLock(mMutex);
+            if (inCompletionCode != QCDiskQueue::kErrorNone ||
+                    inSysErrorCode != 0) {
+                mErrorCount++;
+            }
+            mIoByteCount += inIoByteCount;
+            if (--mRequestCount <= 0) {
+                mDoneCond.Notify();
+            }
+            // The test owns the buffers.
+            return true;
+        }
+        bool Add(
+            const QCDiskQueue::EnqueueStatus& inStatus)
+        {
+            if (inStatus.IsError()) {
+                return false;
+            }
+            QCStMutexLocker theLock(mMutex);
+            mRequestCount++;
+            return true;
+        }
+        void Wait()
+        {
+            QCStMutexLocker theLock(mMutex);
+            while (0 < mRequestCount) {
+                mDoneCond.Wait(mMutex);
+            }
+        }
+        int GetErrorCount() const
+            { return mErrorCount; }
+        int64_t GetIoByteCount() const
+            { return mIoByteCount; }
+    private:
+        QCMutex   mMutex;
+        QCCondVar mDoneCond;
+        int       mRequestCount;
+        int       mErrorCount;
+        int64_t   mIoByteCount;
+    private:
+        Waiter(
+            const Waiter& inWaiter);
+        Waiter& operator=(
+            const Waiter& inWaiter);
+    };
+
+    QCIoBufferPool mBufferPool;
+    QCDiskQueue    mQueue;
+    IOMethod*      mMethodPtr;
+    // The disk queue keeps the pointer to the request processors array.
+    QCDiskQueue::RequestProcessor* mProcessorPtr;
+    string         mDirName;
+    Bufs           mBufs;
+    int            mErrorCount;
+
+    void Expect(
+        bool        inFlag,
+        const char* inMsgPtr)
+    {
+        if (! inFlag) {
+            cerr << "io uring method test: failed: " << inMsgPtr << "\n";
+            mErrorCount++;
+        }
+    }
+    void Expect(
+        const QCDiskQueue::CompletionStatus& inStatus,
+        int64_t                              inIoByteCount,
+        const char*                          inMsgPtr)
+    {
+        if (inStatus.IsError() || inStatus.GetIoByteCount() != inIoByteCount) {
+            cerr << "io uring method test: failed: " << inMsgPtr <<
+                ": " << QCDiskQueue::ToString(inStatus.GetError()) <<
+                " "  << QCUtils::SysError(inStatus.GetSysError()) <<
+                " io bytes: " << inStatus.GetIoByteCount() <<
+                " expected: " << inIoByteCount <<
+            "\n";
+            mErrorCount++;
+        }
+    }
+    string FileName(
+        const char* inNamePtr) const
+        { return (mDirName + "/" + inNamePtr); }
+    static char Byte(
+        int64_t inPos,
+        int     inGen)
+        { return (char)((inPos * 7 + inPos / 251 + inGen * 13) % 253); }
+    char* Buf(
+        int inIdx)
+    {
+        while ((int)mBufs.size() <= inIdx) {
+            void* thePtr = 0;
+            if (posix_memalign(&thePtr, kBlockSize, kBlockSize)) {
+                return 0;
+            }
+            mBufs.push_back((char*)thePtr);
+        }
+        return mBufs[inIdx];
+    }
+    void Fill(
+        int                   inBufIdx,
+        QCDiskQueue::BlockIdx inBlockIdx,
+        int                   inCount,
+        int                   inGen)
+    {
+        for (int i = 0; i < inCount; i++) {
+            char* const   thePtr = Buf(inBufIdx + i);
+            const int64_t thePos = (inBlockIdx + i) * (int64_t)kBlockSize;
+            for (int k = 0; k < kBlockSize; k++) {
+                thePtr[k] = Byte(thePos + k, inGen);
+            }
+        }
+    }
+    void Clear(
+        int inBufIdx,
+        int inCount)
+    {
+        for (int i = 0; i < inCount; i++) {
+            memset(Buf(inBufIdx + i), 0, kBlockSize);
+        }
+    }
+    bool Verify(
+        int                   inBufIdx,
+        QCDiskQueue::BlockIdx inBlockIdx,
+        int64_t               inByteCount,
+        int                   inGen)
+    {
+        const int64_t theStart = inBlockIdx * (int64_t)kBlockSize;
+        for (int64_t i = 0; i < inByteCount; i++) {
+            if (Buf(inBufIdx + (int)(i / kBlockSize))[i % kBlockSize] !=
+                    Byte(theStart + i, inGen)) {
+                return false;
+            }
+        }
+        return true;
+    }
+    bool Start()
+    {
+        const char* const theTmpPtr = getenv("TMPDIR");
+        string theTemplate = string(theTmpPtr ? theTmpPtr : "/tmp") +
+            "/iouringtest.XXXXXX";
+        if (! mkdtemp(&theTemplate[0])) {
+            cerr << "io uring method test: " << theTemplate << ": " <<
+                strerror(errno) << "\n";
+            mErrorCount++;
+            return false;
+        }
+        mDirName = theTemplate;
+        Properties    theProps;
+        ostringstream theStream;
+        theStream <<
+            "chunkServer.diskQueue.ioUring = 1\n"
+            "chunkServer.diskQueue.ioUringQueueDepth = " << kQueueDepth << "\n"
+        ;
+        const string theStr = theStream.str();
+        theProps.loadProperties(theStr.data(), theStr.size(), (char)'=');
+        mMethodPtr = KFS_MAKE_REGISTERED_IO_METHOD_NAME(
+            KFS_IO_METHOD_NAME_IOURING)(
+            mDirName.c_str(),
+            "iouringtest",
+            "chunkServer.diskQueue.",
+            theProps
+        );
+        if (! mMethodPtr) {
+            cout << "io uring method test: io uring is not available,"
+                " skipped\n";
+            return false;
+        }
+        int theSysErr = mBufferPool.Create(1, 256, kBlockSize, false);
+        if (theSysErr) {
+            cerr << "io uring method test: buffer pool: " <<
+                QCUtils::SysError(theSysErr) << "\n";
+            mErrorCount++;
+            return false;
+        }
+        bool theCanEnforceIoTimeoutFlag = false;
+        if (! mMethodPtr->Init(mQueue, kBlockSize, 0, -1,
+                theCanEnforceIoTimeoutFlag)) {
+            cerr << "io uring method test: init failure\n";
+            mErrorCount++;
+            delete mMethodPtr;
+            mMethodPtr = 0;
+            return false;
+        }
+        mProcessorPtr = mMethodPtr;
+        const bool kBufferedIoFlag            = true;
+        const bool kCreateExclusiveFlag       = true;
+        const bool kRequestAffinityFlag       = true;
+        const bool kSerializeMetaRequestsFlag = true;
+        theSysErr = mQueue.Start(
+            1,
+            kQueueDepth * 8,
+            kFileBlocks,
+            kFileCount,
+            0,
+            mBufferPool,
+            0,
+            QCDiskQueue::CpuAffinity::None(),
+            0,
+            kBufferedIoFlag,
+            kCreateExclusiveFlag,
+            kRequestAffinityFlag,
+            kSerializeMetaRequestsFlag,
+            &mProcessorPtr
+        );
+        if (theSysErr) {
+            cerr << "io uring method test: disk queue start: " <<
+                QCUtils::SysError(theSysErr) << "\n";
+            mErrorCount++;
+            delete mMethodPtr;
+            mMethodPtr = 0;
+            return false;
+        }
+        return true;
+    }
+    QCDiskQueue::FileIdx Open(
+        const char* inNamePtr)
+    {
+        const bool kReadOnlyFlag          = false;
+        const bool kAllocateFileSpaceFlag = false;
+        const bool kCreateFlag            = true;
+        const bool kBufferedIoFlag        = true;
+        const QCDiskQueue::OpenFileStatus theStatus = mQueue.OpenFile(
+            FileName(inNamePtr).c_str(),
+            kMaxFileSize,
+            kReadOnlyFlag,
+            kAllocateFileSpaceFlag,
+            kCreateFlag,
+            kBufferedIoFlag
+        );
+        Expect(theStatus.IsGood(), "open");
+        if (theStatus.IsError()) {
+            return -1;
+        }
+        Waiter theWaiter;
+        Expect(theWaiter.Add(mQueue.CheckOpenStatus(
+            theStatus.GetFileIdx(), &theWaiter)), "check open status");
+        theWaiter.Wait();
+        Expect(theWaiter.GetErrorCount() == 0, "open completion");
+        return (theWaiter.GetErrorCount() == 0 ? theStatus.GetFileIdx() : -1);
+    }
+    void TestWriteRead(
+        QCDiskQueue::FileIdx inFileIdx)
+    {
+        const int kCount = 8;
+        Fill(0, 0, kCount, 0);
+        Iterator theWrItr(&mBufs[0], kCount);
+        Expect(mQueue.SyncWrite(inFileIdx, 0, &theWrItr, kCount),
+            kCount * kBlockSize, "write");
+        // Write with sync submits fsync after the write completes.
+        Fill(0, kCount, kCount, 0);
+        Iterator theSyncItr(&mBufs[0], kCount);
+        const bool kSyncFlag = true;
+        Expect(mQueue.SyncWrite(inFileIdx, kCount, &theSyncItr, kCount, 0,
+            kSyncFlag), kCount * kBlockSize, "write sync");
+        Clear(0, 2 * kCount);
+        Iterator theRdItr(&mBufs[0], 2 * kCount);
+        Expect(mQueue.SyncRead(inFileIdx, 0, &theRdItr, 2 * kCount),
+            2 * kCount * kBlockSize, "read");
+        Expect(Verify(0, 0, 2 * kCount * kBlockSize, 0), "read data");
+    }
+    void TestShortRead(
+        QCDiskQueue::FileIdx inFileIdx)
+    {
+        // The file has 16 blocks, the max file size is larger, therefore the
+        // disk queue passes the reads past the end of file to the io method.
+        const int kCount = 4;
+        Clear(0, kCount);
+        Iterator theItr(&mBufs[0], kCount);
+        Expect(mQueue.SyncRead(inFileIdx, 14, &theItr, kCount),
+            2 * kBlockSize, "short read at end of file");
+        Expect(Verify(0, 14, 2 * kBlockSize, 0), "short read data");
+        Iterator theEofItr(&mBufs[0], kCount);
+        Expect(mQueue.SyncRead(inFileIdx, 32, &theEofItr, kCount),
+            0, "read past end of file");
+        // Partial block at the end of file.
+        const string theName = FileName("a");
+        const int64_t kTail = 100;
+        Expect(truncate(theName.c_str(), 16 * kBlockSize - kTail) == 0,
+            "truncate");
+        Clear(0, kCount);
+        Iterator thePartItr(&mBufs[0], kCount);
+        Expect(mQueue.SyncRead(inFileIdx, 14, &thePartItr, kCount),
+            2 * kBlockSize - kTail, "partial block read");
+        Expect(Verify(0, 14, 2 * kBlockSize - kTail, 0),
+            "partial block read data");
+    }
+    void TestInFlight(
+        QCDiskQueue::FileIdx inFileIdx)
+    {
+        // Queue single block requests, several times more than the ring
+        // slots, in order to have the io method wait for free slots while
+        // reaping completions.
+        const int kCount = kFileBlocks;
+        Fill(0, 0, kCount, 1);
+        Waiter theWrWaiter;
+        for (int i = 0; i < kCount; i++) {
+            Iterator theItr(&mBufs[i], 1);
+            Expect(theWrWaiter.Add(mQueue.Write(
+                inFileIdx, i, &theItr, 1, &theWrWaiter)),
+                "enqueue write");
+        }
+        theWrWaiter.Wait();
+        Expect(theWrWaiter.GetErrorCount() == 0 &&
+            theWrWaiter.GetIoByteCount() == (int64_t)kCount * kBlockSize,
+            "writes in flight");
+        Clear(0, kCount);
+        Waiter theRdWaiter;
+        for (int i = 0; i < kCount; i++) {
+            Iterator theItr(&mBufs[i], 1);
+            Expect(theRdWaiter.Add(mQueue.Read(
+                inFileIdx, i, &theItr, 1, &theRdWaiter)),
+                "enqueue read");
+        }
+        theRdWaiter.Wait();
+        Expect(theRdWaiter.GetErrorCount() == 0 &&
+            theRdWaiter.GetIoByteCount() == (int64_t)kCount * kBlockSize,
+            "reads in flight");
+        Expect(Verify(0, 0, (int64_t)kCount * kBlockSize, 1),
+            "reads in flight data");
+    }
+    void TestClose(
+        QCDiskQueue::FileIdx inFileIdx)
+    {
+        const int64_t kEof = 3 * kBlockSize + 10;
+        Expect(mQueue.CloseFile(inFileIdx, kEof).IsGood(), "close");
+        struct stat theStat;
+        Expect(stat(FileName("a").c_str(), &theStat) == 0 &&
+            theStat.st_size == kEof, "close file size");
+    }
+    void TestMeta()
+    {
+        Waiter theWaiter;
+        const string theA = FileName("a");
+        const string theB = FileName("b");
+        Expect(theWaiter.Add(mQueue.Rename(
+            theA.c_str(), theB.c_str(), &theWaiter)), "enqueue rename");
+        theWaiter.Wait();
+        struct stat theStat;
+        Expect(theWaiter.GetErrorCount() == 0 &&
+            stat(theA.c_str(), &theStat) != 0 &&
+            stat(theB.c_str(), &theStat) == 0, "rename");
+        Expect(theWaiter.Add(mQueue.Delete(theB.c_str(), &theWaiter)),
+            "enqueue delete");
+        theWaiter.Wait();
+        Expect(theWaiter.GetErrorCount() == 0 &&
+            stat(theB.c_str(), &theStat) != 0, "delete");
+        Expect(theWaiter.Add(mQueue.Delete(theB.c_str(), &theWaiter)),
+            "enqueue delete non existent");
+        theWaiter.Wait();
+        Expect(theWaiter.GetErrorCount() == 1, "delete non existent");
+        const string theC = FileName("c");
+        const bool    kBufferedIoFlag  = true;
+        const bool    kAllocSpaceFlag  = false;
+        const int64_t kWriteSize       = 2 * kBlockSize;
+        Waiter theDirWaiter;
+        Expect(theDirWaiter.Add(mQueue.CheckDirWritable(theC.c_str(),
+            kBufferedIoFlag, kAllocSpaceFlag, kWriteSize, &theDirWaiter)),
+            "enqueue check dir writable");
+        theDirWaiter.Wait();
+        Expect(theDirWaiter.GetErrorCount() == 0 &&
+            stat(theC.c_str(), &theStat) != 0, "check dir writable");
+    }
+private:
+    IOUringMethodTest(
+        const IOUringMethodTest& inTest);
+    IOUringMethodTest& operator=(
+        const IOUringMethodTest& inTest);
+};
+
+}
+
+    int
+main(
+    int    /* inArgCount */,
+    char** /* inArgs */)
+{
+    KFS::IOUringMethodTest theTest;
+    return theTest.Run();
+}
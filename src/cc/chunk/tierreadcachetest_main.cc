@@ -0,0 +1,420 @@
+//---------------------------------------------------------- -*- Mode: C++ -*-
+// $Id$
+//
+// Created 2026/10/16
+//
+// Copyright 2026 Quantcast Corp.
+//
+// This file is part of Kosmos File System (KFS).
+//
+// Licensed under the Apache License, Version 2.0
+// (the "License"); you may not use this file except in compliance with
+// the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+//
+// Tier read cache unit test: read count admission threshold and decay, miss,
+// copy and hit, version mismatch, invalidation, lru eviction, and lost
+// directory, with the disk io queue in temporary directory.
+//
+//----------------------------------------------------------------------------
+
+#include "TierReadCache.h"
+#include "DiskIo.h"
+
+#include "common/Properties.h"
+#include "kfsio/KfsCallbackObj.h"
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+namespace KFS
+{
+
+using std::cerr;
+using std::cout;
+using std::ifstream;
+using std::ofstream;
+using std::ostringstream;
+using std::string;
+
+class TierReadCacheTest
+{
+public:
+    enum { kChunkSize = (3 << 16) + 1000 };
+
+    TierReadCacheTest()
+        : mCache(),
+          mDirName(),
+          mSrcFileName(),
+          mSrcFilePtr(),
+          mDiskIoFlag(false),
+          mErrorCount(0)
+        {}
+    ~TierReadCacheTest()
+    {
+        mCache.Shutdown();
+        mSrcFilePtr.reset();
+        if (mDiskIoFlag) {
+            string theErrMsg;
+            DiskIo::Shutdown(&theErrMsg);
+        }
+        if (! mDirName.empty()) {
+            for (int i = 0; i < 10; i++) {
+                unlink(CopyName(i).c_str());
+            }
+            unlink(mSrcFileName.c_str());
+            rmdir(mDirName.c_str());
+        }
+    }
+    int Run()
+    {
+        TestDisabled();
+        TestAdmission();
+        TestMiss();
+        if (StartIoQueue()) {
+            TestHit();
+            TestInvalidate();
+            TestEviction();
+            TestDirLost();
+            TestDisable();
+        }
+        if (mErrorCount <= 0) {
+            cout << "tier read cache test: passed\n";
+        }
+        return (mErrorCount <= 0 ? 0 : 1);
+    }
+private:
+    class Reader : public KfsCallbackObj
+    {
+    public:
+        Reader()
+            : KfsCallbackObj()
+            { SET_HANDLER(this, &Reader::Handle); }
+        int Handle(
+            int   /* inCode */,
+            void* /* inDataPtr */)
+            { return 0; }
+    };
+
+    TierReadCache   mCache;
+    string          mDirName;
+    string          mSrcFileName;
+    DiskIo::FilePtr mSrcFilePtr;
+    bool            mDiskIoFlag;
+    int             mErrorCount;
+
+    void Expect(
+        bool        inFlag,
+        const char* inMsgPtr)
+    {
+        if (! inFlag) {
+            cerr << "tier read cache test: failed: " << inMsgPtr << "\n";
+            mErrorCount++;
+        }
+    }
+    void SetParameters(
+        TierReadCache::ByteCount inMaxSize)
+    {
+        Properties theProps;
+        ostringstream theStream;
+        theStream <<
+            "chunkServer.tierReadCache.maxSize = " << inMaxSize << "\n"
+            "chunkServer.tierReadCache.minReadCount = 3\n"
+            "chunkServer.tierReadCache.maxTrackedChunks = 3\n"
+            "chunkServer.tierReadCache.maxCopiesInFlight = 1\n"
+            "chunkServer.tierReadCache.copyIoSize = 65536\n"
+        ;
+        const string theStr = theStream.str();
+        theProps.loadProperties(theStr.data(), theStr.size(), (char)'=');
+        mCache.SetParameters(theProps);
+    }
+    string CopyName(
+        kfsChunkId_t inChunkId) const
+    {
+        ostringstream theStream;
+        theStream << mDirName << "/copy." << inChunkId;
+        return theStream.str();
+    }
+    static bool Exists(
+        const string& inFileName)
+    {
+        struct stat theStat;
+        return (stat(inFileName.c_str(), &theStat) == 0);
+    }
+    static char Byte(
+        int inPos)
+        { return (char)((inPos * 7 + inPos / 251) % 253); }
+    // Runs disk io completions, until all copies are done, and the files of
+    // the removed copies are deleted.
+    bool WaitForIo(
+        kfsChunkId_t inDeletedChunkId = -1)
+    {
+        for (int i = 0; i < 10000; i++) {
+            DiskIo::RunIoCompletion();
+            if (mCache.GetCopiesInFlightCount() <= 0 &&
+                    (inDeletedChunkId < 0 ||
+                        ! Exists(CopyName(inDeletedChunkId)))) {
+                return true;
+            }
+            usleep(1000);
+        }
+        return false;
+    }
+    bool Add(
+        kfsChunkId_t inChunkId,
+        int64_t      inVersion)
+    {
+        return mCache.Add(inChunkId, inVersion, kChunkSize, mSrcFilePtr,
+            mDirName, CopyName(inChunkId), true);
+    }
+    bool IsCopyValid(
+        kfsChunkId_t inChunkId)
+    {
+        ifstream theStream(CopyName(inChunkId).c_str(),
+            ifstream::in | ifstream::binary);
+        string theData(kChunkSize, 0);
+        if (! theStream.read(&theData[0], kChunkSize)) {
+            return false;
+        }
+        for (int i = 0; i < kChunkSize; i++) {
+            if (theData[i] != Byte(i)) {
+                return false;
+            }
+        }
+        return true;
+    }
+    bool StartIoQueue()
+    {
+        const char* const theTmpPtr = getenv("TMPDIR");
+        string theTemplate = string(theTmpPtr ? theTmpPtr : "/tmp") +
+            "/tierreadcachetest.XXXXXX";
+        if (! mkdtemp(&theTemplate[0])) {
+            cerr << "tier read cache test: " << theTemplate << ": " <<
+                strerror(errno) << "\n";
+            mErrorCount++;
+            return false;
+        }
+        mDirName     = theTemplate;
+        mSrcFileName = mDirName + "/chunk";
+        {
+            string theData(kChunkSize, 0);
+            for (int i = 0; i < kChunkSize; i++) {
+                theData[i] = Byte(i);
+            }
+            ofstream theStream(mSrcFileName.c_str(),
+                ofstream::out | ofstream::binary);
+            theStream.write(theData.data(), kChunkSize);
+            theStream.close();
+            Expect(! theStream.fail(), "chunk file write");
+        }
+        struct stat theStat;
+        Properties  theProps;
+        string      theErrMsg;
+        theProps.setValue("chunkServer.ioBufferPool.partitionBufferCount",
+            "4096");
+        if (stat(mDirName.c_str(), &theStat) != 0 ||
+                ! (mDiskIoFlag = DiskIo::Init(theProps, &theErrMsg)) ||
+                ! DiskIo::StartIoQueue(
+                    mDirName.c_str(), theStat.st_dev, 64, &theErrMsg)) {
+            cerr << "tier read cache test: failed to start disk io: " <<
+                theErrMsg << "\n";
+            mErrorCount++;
+            return false;
+        }
+        mSrcFilePtr.reset(new DiskIo::File());
+        if (! mSrcFilePtr->Open(
+                mSrcFileName.c_str(),
+                -1,
+                true,  // inReadOnlyFlag
+                false, // inReserveFileSpaceFlag
+                false, // inCreateFlag
+                &theErrMsg,
+                0,
+                true)) {
+            cerr << "tier read cache test: " << mSrcFileName << ": " <<
+                theErrMsg << "\n";
+            mErrorCount++;
+            return false;
+        }
+        return true;
+    }
+    void TestDisabled()
+    {
+        Expect(! mCache.IsEnabled(), "enabled by default");
+        for (int i = 0; i < 8; i++) {
+            Expect(! mCache.RecordRead(1, 1), "disabled cache admission");
+        }
+        Expect(! mCache.Get(1, 1), "disabled cache hit");
+    }
+    void TestAdmission()
+    {
+        SetParameters(4 * kChunkSize);
+        Expect(mCache.IsEnabled(), "not enabled");
+        Expect(! mCache.RecordRead(1, 1) && ! mCache.RecordRead(1, 1),
+            "admission below threshold");
+        Expect(mCache.RecordRead(1, 1), "no admission at threshold");
+        // Chunk version change starts new count.
+        Expect(! mCache.RecordRead(1, 2) && ! mCache.RecordRead(1, 2),
+            "count not reset on version change");
+        Expect(mCache.RecordRead(1, 2), "no admission at new version");
+        // The number of tracked chunks is limited.
+        mCache.RecordRead(2, 1);
+        mCache.RecordRead(3, 1);
+        for (int i = 0; i < 4; i++) {
+            Expect(! mCache.RecordRead(4, 1), "untracked chunk admission");
+        }
+        // The counts are halved, and the chunks with no reads are no longer
+        // tracked.
+        const time_t theNow = time(0);
+        mCache.Timeout(theNow);
+        Expect(! mCache.RecordRead(1, 2) && mCache.RecordRead(1, 2),
+            "decayed count admission");
+        mCache.Timeout(theNow);
+        Expect(! mCache.RecordRead(4, 1) && ! mCache.RecordRead(4, 1),
+            "admission before decay interval");
+        Expect(mCache.RecordRead(4, 1), "decayed chunk not removed");
+        // Disabling cache discards the counts.
+        SetParameters(0);
+        SetParameters(4 * kChunkSize);
+        Expect(! mCache.RecordRead(4, 1), "counts not cleared");
+        SetParameters(0);
+        SetParameters(4 * kChunkSize);
+    }
+    void TestMiss()
+    {
+        Expect(! mCache.Get(1, 1), "empty cache hit");
+        Expect(! Add(1, 1), "add without source file");
+        DiskIo::FilePtr theFilePtr(new DiskIo::File());
+        Expect(! mCache.Add(1, 1, 5 * kChunkSize, theFilePtr, "/", "/copy",
+            true), "add of closed file or chunk larger than cache");
+        mCache.Invalidate(1);
+        Expect(mCache.GetSize() == 0 && mCache.GetCopiesInFlightCount() == 0,
+            "empty cache size");
+        const TierReadCache::Counters& theCounters = mCache.GetCounters();
+        Expect(theCounters.mAdmitCount == 0 &&
+            theCounters.mInvalidateCount == 0,
+            "empty cache counters");
+    }
+    void TestHit()
+    {
+        const TierReadCache::Counters& theCounters = mCache.GetCounters();
+        Expect(Add(5, 1), "add");
+        Expect(mCache.GetSize() == kChunkSize, "size after add");
+        Expect(! Add(6, 1), "max copies in flight exceeded");
+        Expect(! mCache.Get(5, 1), "hit with copy in flight");
+        Expect(! mCache.RecordRead(5, 1) && ! mCache.RecordRead(5, 1) &&
+            ! mCache.RecordRead(5, 1), "admission of cached chunk");
+        Expect(WaitForIo(), "copy timed out");
+        Expect(theCounters.mCopyDoneCount == 1 &&
+            theCounters.mCopyErrorCount == 0, "copy failed");
+        Expect(IsCopyValid(5), "copy data mismatch");
+        const DiskIo::FilePtr theFilePtr = mCache.Get(5, 1);
+        Expect(theFilePtr && theFilePtr->IsOpen(), "miss after copy");
+        Expect(mCache.Get(5, 1) == theFilePtr, "other file on hit");
+        Expect(! mCache.Get(6, 1), "other chunk hit");
+        Reader theReader;
+        DiskIo theCopyIo(theFilePtr, &theReader);
+        DiskIo theSrcIo(mSrcFilePtr, &theReader);
+        Expect(mCache.IsFileEquals(5, 1, &theCopyIo), "copy io not detected");
+        Expect(! mCache.IsFileEquals(5, 1, &theSrcIo) &&
+            ! mCache.IsFileEquals(5, 2, &theCopyIo),
+            "chunk file io detected as copy io");
+    }
+    void TestInvalidate()
+    {
+        // The chunk manager invalidates the copy on write, truncate, and
+        // delete, and the version mismatch invalidates the copy on read.
+        const TierReadCache::Counters& theCounters = mCache.GetCounters();
+        Expect(! mCache.Get(5, 2), "stale version hit");
+        Expect(! mCache.Get(5, 1), "hit after version change");
+        Expect(theCounters.mInvalidateCount == 1 && mCache.GetSize() == 0,
+            "version mismatch invalidation");
+        Expect(WaitForIo(5), "stale copy not deleted");
+        Expect(Add(5, 2) && WaitForIo() && Add(6, 1) && WaitForIo(),
+            "add after invalidate");
+        Reader theReader;
+        DiskIo theSrcIo(mSrcFilePtr, &theReader);
+        mCache.Invalidate(5, &theSrcIo);
+        Expect(mCache.Get(5, 2).get() != 0, "invalidation with chunk file io");
+        {
+            DiskIo theCopyIo(mCache.Get(5, 2), &theReader);
+            mCache.Invalidate(5, &theCopyIo);
+        }
+        Expect(! mCache.Get(5, 2), "hit after copy io invalidation");
+        mCache.Invalidate(6);
+        Expect(! mCache.Get(6, 1), "invalidated chunk hit");
+        Expect(theCounters.mInvalidateCount == 3 && mCache.GetSize() == 0,
+            "invalidate accounting");
+        Expect(WaitForIo(5) && WaitForIo(6), "invalidated copy not deleted");
+    }
+    void TestEviction()
+    {
+        const TierReadCache::Counters& theCounters = mCache.GetCounters();
+        SetParameters(2 * kChunkSize);
+        Expect(Add(7, 1) && WaitForIo() && Add(8, 1) && WaitForIo(),
+            "add before eviction");
+        Expect(mCache.Get(7, 1).get() != 0, "chunk 7 miss");
+        Expect(Add(9, 1) && WaitForIo(), "add with eviction");
+        Expect(mCache.GetSize() == 2 * kChunkSize, "size exceeds max");
+        Expect(theCounters.mEvictCount == 1, "eviction count");
+        Expect(mCache.Get(7, 1) && mCache.Get(9, 1),
+            "recently used copy evicted");
+        Expect(! mCache.Get(8, 1), "least recently used copy not evicted");
+        Expect(WaitForIo(8), "evicted copy not deleted");
+    }
+    void TestDirLost()
+    {
+        // The copies in the lost directory are no longer accessible, and
+        // must not be deleted.
+        mCache.DirLost(mDirName + "x");
+        Expect(mCache.GetSize() == 2 * kChunkSize, "other directory lost");
+        mCache.DirLost(mDirName);
+        Expect(mCache.GetSize() == 0 && ! mCache.Get(7, 1) &&
+            ! mCache.Get(9, 1), "hit after directory lost");
+        WaitForIo();
+        Expect(Exists(CopyName(7)) && Exists(CopyName(9)),
+            "lost directory copy deleted");
+    }
+    void TestDisable()
+    {
+        SetParameters(2 * kChunkSize);
+        Expect(Add(1, 1) && WaitForIo(), "add after directory lost");
+        SetParameters(0);
+        Expect(! mCache.IsEnabled() && mCache.GetSize() == 0 &&
+            ! mCache.Get(1, 1), "disabled cache hit");
+        Expect(WaitForIo(1), "copy not deleted on disable");
+        Expect(! Add(1, 1), "add to disabled cache");
+    }
+private:
+    TierReadCacheTest(
+        const TierReadCacheTest& inTest);
+    TierReadCacheTest& operator=(
+        const TierReadCacheTest& inTest);
+};
+
+}
+
+    int
+main(
+    int    /* inArgCount */,
+    char** /* inArgs */)
+{
+    KFS::TierReadCacheTest theTest;
+    return theTest.Run();
+}
@@ -38,6 +38,11 @@
 #include <string.h>
 #include <stdlib.h>
 
+#if defined(__SSE2__) && defined(__GNUC__)
+#   include <emmintrin.h>
+#   define KFS_REQUEST_PARSER_USE_SSE2
+#endif
+
 #include "StBuffer.h"
 
 namespace KFS
@@ -446,6 +451,52 @@ public:
     static bool IsWSpace(
         char inChar)
         { return ((inChar & 0xFF) <= ' '); }
+    // Returns pointer to the first of the three characters, or inEndPtr if
+    // none found. With SSE2 16 bytes are checked at a time.
+    static const char* FindFirstOf(
+        const char* inPtr,
+        const char* inEndPtr,
+        char        inFirst,
+        char        inSecond,
+        char        inThird)
+    {
+        const char* thePtr = inPtr;
+#ifdef KFS_REQUEST_PARSER_USE_SSE2
+        const __m128i theFirst  = _mm_set1_epi8(inFirst);
+        const __m128i theSecond = _mm_set1_epi8(inSecond);
+        const __m128i theThird  = _mm_set1_epi8(inThird);
+        for (; thePtr + 16 <= inEndPtr; thePtr += 16) {
+            const __m128i theBlock =
+                _mm_loadu_si128(reinterpret_cast<const __m128i*>(thePtr));
+            const int theMask = _mm_movemask_epi8(_mm_or_si128(
+                _mm_or_si128(
+                    _mm_cmpeq_epi8(theBlock, theFirst),
+                    _mm_cmpeq_epi8(theBlock, theSecond)),
+                _mm_cmpeq_epi8(theBlock, theThird)
+            ));
+            if (theMask != 0) {
+                return (thePtr + __builtin_ctz((unsigned int)theMask));
+            }
+        }
+#endif
+        while (thePtr < inEndPtr && *thePtr != inFirst &&
+                *thePtr != inSecond && *thePtr != inThird) {
+            thePtr++;
+        }
+        return thePtr;
+    }
+    // Returns pointer past the last non white space character in
+    // [inPtr, inEndPtr), or inPtr if all characters are white space.
+    static const char* TrimEnd(
+        const char* inPtr,
+        const char* inEndPtr)
+    {
+        const char* thePtr = inEndPtr;
+        while (inPtr < thePtr && IsWSpace(thePtr[-1])) {
+            --thePtr;
+        }
+        return thePtr;
+    }
     bool Next(int inSeparator = kSeparator)
     {
         while (mPtr < mEndPtr) {
@@ -465,18 +516,14 @@ public:
             if (mPtr >= mEndPtr) {
                 break;
             }
-            const char* theKeyEndPtr = mPtr;
-            while (mPtr < mEndPtr && *mPtr != inSeparator &&
-                    *mPtr != '\r' && *mPtr != '\n') {
-                if (! IsWSpace(*mPtr)) {
-                    theKeyEndPtr = mPtr + 1;
-                }
-                mPtr++;
-            }
-            if (*mPtr != inSeparator) {
+            const char* const theKeyTailPtr = mPtr;
+            mPtr = FindFirstOf(mPtr, mEndPtr, (char)inSeparator, '\r', '\n');
+            const char* const theKeyEndPtr = TrimEnd(theKeyTailPtr, mPtr);
+            if (mPtr >= mEndPtr || *mPtr != inSeparator) {
                 // Ignore malformed line.
-                while (mPtr < mEndPtr && *mPtr != '\n') {
-                    mPtr++;
+                if (mPtr < mEndPtr && ! (mPtr = (const char*)memchr(
+                        mPtr, '\n', mEndPtr - mPtr))) {
+                    mPtr = mEndPtr;
                 }
                 if (mIgnoreMalformedFlag) {
                     continue;
@@ -491,14 +538,9 @@ public:
                 mPtr++;
             }
             // Find end of line and discard trailing white space.
-            const char* const theValuePtr    = mPtr;
-            const char*       theValueEndPtr = mPtr;
-            while (mPtr < mEndPtr && *mPtr != '\r' && *mPtr != '\n') {
-                if (! IsWSpace(*mPtr)) {
-                    theValueEndPtr = mPtr + 1;
-                }
-                mPtr++;
-            }
+            const char* const theValuePtr = mPtr;
+            mPtr = FindFirstOf(mPtr, mEndPtr, '\r', '\n', '\n');
+            const char* const theValueEndPtr = TrimEnd(theValuePtr, mPtr);
             mKey   = Token(theKeyPtr,   theKeyEndPtr);
             mValue = Token(theValuePtr, theValueEndPtr);
             return true;
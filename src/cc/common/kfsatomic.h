@@ -54,6 +54,14 @@ template<typename T> T SyncAddAndFetch(volatile T& val, T inc)
     return ret;
 }
 
+template<typename T> T SyncLoadAcquire(const volatile T& val)
+{
+    atomicmpl::AtomicLock();
+    const T ret = val;
+    atomicmpl::AtomicUnlock();
+    return ret;
+}
+
 #else
 
 template<typename T> T SyncAddAndFetch(volatile T& val, T inc)
@@ -61,6 +69,19 @@ template<typename T> T SyncAddAndFetch(volatile T& val, T inc)
     return __sync_add_and_fetch(&val, inc);
 }
 
+// Load with acquire semantics: the memory accesses that follow are not
+// reordered before the load.
+template<typename T> T SyncLoadAcquire(const volatile T& val)
+{
+#ifdef __ATOMIC_ACQUIRE
+    return __atomic_load_n(&val, __ATOMIC_ACQUIRE);
+#else
+    const T ret = val;
+    __sync_synchronize();
+    return ret;
+#endif
+}
+
 #endif /* _KFS_ATOMIC_USE_MUTEX */
 }
 
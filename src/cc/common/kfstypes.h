@@ -110,7 +110,9 @@ const int EINVALCHUNKSIZE = 1007;
 
 #define KFS_FOR_EACH_EC_METHOD(f) \
     f(STRIPED_FILE_TYPE_RS) \
-    f(STRIPED_FILE_TYPE_RS_JERASURE)
+    f(STRIPED_FILE_TYPE_RS_JERASURE) \
+    f(STRIPED_FILE_TYPE_RS_CAUCHY) \
+    f(STRIPED_FILE_TYPE_RS_LRC)
 
 enum StripedFileType
 {
@@ -123,6 +125,17 @@ enum StripedFileType
     KFS_STRIPED_FILE_TYPE_COUNT
 };
 
+// Chunk read and write disk io priority classes. Sent with chunk read
+// requests by the chunk servers and clients doing replication and recovery,
+// in order to let the chunk server schedule background disk io behind the
+// client io.
+enum KfsIoPriority
+{
+    kKfsIoPriorityHigh   = 0,
+    kKfsIoPriorityNormal = 1,
+    kKfsIoPriorityLow    = 2
+};
+
 const int KFS_STRIPE_ALIGNMENT          = 4096;
 const int KFS_MIN_STRIPE_SIZE           = KFS_STRIPE_ALIGNMENT;
 const int KFS_MAX_STRIPE_SIZE           = (int)CHUNKSIZE;
@@ -153,6 +166,36 @@ static inline bool ValidateStripeParameters(
     );
 }
 
+// Locally repairable code local group count: each group of data stripes has
+// one local parity stripe, the remaining recovery stripes are global.
+static inline int GetLrcLocalGroupCount(
+    int inStripeCount,
+    int inRecoveryStripeCount)
+{
+    const int theCount = (inRecoveryStripeCount + 1) / 2;
+    return (inStripeCount < theCount ? inStripeCount : theCount);
+}
+
+// Max. number of lost chunks in a chunk block that can always be recovered.
+// The maximum distance separable codes tolerate the loss of any recovery
+// stripe count chunks, the locally repairable code with l local groups
+// tolerates only the loss of global parity count plus one chunks.
+static inline int GetRecoveryStripeTolerance(
+    int inStipedFileType,
+    int inStripeCount,
+    int inRecoveryStripeCount)
+{
+    if (inStipedFileType == KFS_STRIPED_FILE_TYPE_NONE ||
+            inStripeCount <= 0 || inRecoveryStripeCount <= 0) {
+        return 0;
+    }
+    if (inStipedFileType == KFS_STRIPED_FILE_TYPE_RS_LRC) {
+        return (inRecoveryStripeCount + 1 - GetLrcLocalGroupCount(
+            inStripeCount, inRecoveryStripeCount));
+    }
+    return inRecoveryStripeCount;
+}
+
 enum AuthenticationType
 {
     kAuthenticationTypeUndef = 0x0,
@@ -34,10 +34,11 @@ int main(int argc, char** argv)
 {
     if (argc > 1 && (!strcmp(argv[1], "-h") || !strcmp(argv[1], "--help"))) {
         printf("Usage: %s [flags]\n"
-               "       flags can be any combination of 'c', 'n', 'd'.\n"
-               "       c: test adler32 combine.\n"
+               "       flags can be any combination of 'c', 'n', 'd', 'r'.\n"
+               "       c: test checksum combine.\n"
                "       n: don't pad with 0.\n"
                "       d: debug.\n"
+               "       r: use crc32c instead of adler32.\n"
                "       The test reads input from STDIN ended by Ctrl+D.\n",
                argv[0]);
         return 0;
@@ -50,6 +51,8 @@ int main(int argc, char** argv)
     const bool    padd  = argc <= 1 || strchr(argv[1], 'n') == 0;
     const bool    tcomb = argc > 1 && strchr(argv[1], 'c');
     const bool    debug = argc > 1 && strchr(argv[1], 'd');
+    const KFS::KfsChecksumType type = (argc > 1 && strchr(argv[1], 'r')) ?
+        KFS::kKfsChecksumTypeCrc32c : KFS::kKfsChecksumTypeAdler32;
     char* const   e = p + (tcomb ? sizeof(buf) : KFS::CHECKSUM_BLOCKSIZE);
 
     do {
@@ -63,10 +66,10 @@ int main(int argc, char** argv)
         if (padd && p < e) {
             memset(p, 0, e - p);
         }
-        const uint32_t cksum = KFS::ComputeBlockChecksum(buf, len);
+        const uint32_t cksum = KFS::ComputeBlockChecksum(buf, len, type);
         if (tcomb) {
             uint32_t cck = 0;
-            KFS::ComputeChecksums(buf, len, &cck);
+            KFS::ComputeChecksums(buf, len, &cck, type);
             if (cck != cksum) {
                 printf("mismatch %lu %lu %u %u\n", o, (unsigned long)len,
                     (unsigned int)cksum, (unsigned int)cck);
@@ -0,0 +1,296 @@
+//---------------------------------------------------------- -*- Mode: C++ -*-
+// $Id$
+//
+// Created 2026/10/16
+//
+// Copyright 2026 Quantcast Corp.
+//
+// This file is part of Kosmos File System (KFS).
+//
+// Licensed under the Apache License, Version 2.0
+// (the "License"); you may not use this file except in compliance with
+// the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+//
+// Block checksum unit test: the run time selected checksum implementations
+// against the bit by bit reference, at all alignments, lengths, and split
+// points, checksum combine, and block checksum vectors.
+//
+//----------------------------------------------------------------------------
+
+#include "kfsio/checksum.h"
+#include "kfsio/crc32c.h"
+#include "kfsio/adler32.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <iostream>
+#include <vector>
+
+namespace KFS
+{
+
+using std::cerr;
+using std::cout;
+using std::vector;
+
+class ChecksumTest
+{
+public:
+    ChecksumTest()
+        : mErrorCount(0),
+          mBuf(3 * CHECKSUM_BLOCKSIZE + 64)
+    {
+        srandom(1);
+        for (size_t i = 0; i < mBuf.size(); i++) {
+            mBuf[i] = (unsigned char)random();
+        }
+    }
+    int Run()
+    {
+        TestCrc32cKnown();
+        TestCrc32cLengths();
+        TestCrc32cSplit();
+        TestCrc32cCombine();
+        TestBlockChecksums(kKfsChecksumTypeCrc32c);
+        TestAdler32Known();
+        TestAdler32Lengths();
+        TestAdler32Overflow();
+        TestAdler32Combine();
+        TestBlockChecksums(kKfsChecksumTypeAdler32);
+        if (mErrorCount <= 0) {
+            cout << "checksum test: passed\n";
+        }
+        return (mErrorCount <= 0 ? 0 : 1);
+    }
+private:
+    int                   mErrorCount;
+    vector<unsigned char> mBuf;
+
+    void Check(
+        bool        inOkFlag,
+        const char* inMsgPtr,
+        size_t      inOffset = 0,
+        size_t      inLength = 0)
+    {
+        if (! inOkFlag) {
+            cerr << "error: " << inMsgPtr <<
+                " offset: " << inOffset <<
+                " length: " << inLength <<
+            "\n";
+            mErrorCount++;
+        }
+    }
+    const unsigned char* Ptr(
+        size_t inOffset) const
+        { return &mBuf[0] + inOffset; }
+    static uint32_t Crc32cReference(
+        uint32_t             inCrc,
+        const unsigned char* inPtr,
+        size_t               inLength)
+    {
+        uint32_t theCrc = ~inCrc;
+        for (size_t i = 0; i < inLength; i++) {
+            theCrc ^= inPtr[i];
+            for (int k = 0; k < 8; k++) {
+                theCrc = (theCrc & 1) ?
+                    (theCrc >> 1) ^ 0x82F63B78 : theCrc >> 1;
+            }
+        }
+        return ~theCrc;
+    }
+    void TestCrc32cKnown()
+    {
+        const char kStr[] = "123456789";
+        Check(Crc32cUpdate(0, kStr, sizeof(kStr) - 1) == 0xE3069283,
+            "crc32c check value mismatch");
+        Check(Crc32cUpdate(0, kStr, 0) == 0,
+            "crc32c empty buffer is not 0");
+        unsigned char theZeros[32];
+        memset(theZeros, 0, sizeof(theZeros));
+        Check(Crc32cUpdate(0, theZeros, sizeof(theZeros)) == 0x8A9136AA,
+            "crc32c 32 zero bytes mismatch");
+    }
+    void TestCrc32cLengths()
+    {
+        // Cover the byte, word, and three lane paths of the hardware
+        // implementations at every alignment.
+        const size_t kMaxLen = 3 * kCrc32cLaneSize * 2 + 17;
+        for (size_t theOffset = 0; theOffset < 8; theOffset++) {
+            for (size_t theLen = 0; theLen <= kMaxLen;
+                    theLen += theLen < 64 ? 1 : 61) {
+                Check(Crc32cUpdate(0, Ptr(theOffset), theLen) ==
+                        Crc32cReference(0, Ptr(theOffset), theLen),
+                    "crc32c mismatch", theOffset, theLen);
+            }
+        }
+        Check(Crc32cUpdate(0, Ptr(3), CHECKSUM_BLOCKSIZE) ==
+                Crc32cReference(0, Ptr(3), CHECKSUM_BLOCKSIZE),
+            "crc32c block mismatch", 3, CHECKSUM_BLOCKSIZE);
+    }
+    void TestCrc32cSplit()
+    {
+        const size_t   kLen    = 3 * kCrc32cLaneSize + 100;
+        const uint32_t theCrc  = Crc32cReference(0, Ptr(1), kLen);
+        for (size_t theSplit = 0; theSplit <= kLen; theSplit += 37) {
+            const uint32_t theFirst = Crc32cUpdate(0, Ptr(1), theSplit);
+            Check(Crc32cUpdate(theFirst, Ptr(1 + theSplit), kLen - theSplit) ==
+                    theCrc,
+                "crc32c incremental update mismatch", 1, theSplit);
+        }
+    }
+    void TestCrc32cCombine()
+    {
+        const size_t kLen = 2 * CHECKSUM_BLOCKSIZE;
+        const uint32_t theCrc = Crc32cUpdate(0, Ptr(0), kLen);
+        for (size_t theSplit = 0; theSplit <= kLen;
+                theSplit += theSplit < 16 ? 1 : 4099) {
+            const uint32_t theFirst  = Crc32cUpdate(0, Ptr(0), theSplit);
+            const uint32_t theSecond =
+                Crc32cUpdate(0, Ptr(theSplit), kLen - theSplit);
+            Check(Crc32cCombine(theFirst, theSecond, kLen - theSplit) ==
+                    theCrc,
+                "crc32c combine mismatch", 0, theSplit);
+            Check(ChecksumBlocksCombine(theFirst, theSecond, kLen - theSplit,
+                    kKfsChecksumTypeCrc32c) == theCrc,
+                "crc32c block combine mismatch", 0, theSplit);
+        }
+    }
+    static uint32_t Adler32Reference(
+        uint32_t             inAdler,
+        const unsigned char* inPtr,
+        size_t               inLength)
+    {
+        uint32_t theS1 = inAdler & 0xFFFF;
+        uint32_t theS2 = inAdler >> 16;
+        for (size_t i = 0; i < inLength; i++) {
+            theS1 = (theS1 + inPtr[i]) % 65521;
+            theS2 = (theS2 + theS1) % 65521;
+        }
+        return (theS1 | (theS2 << 16));
+    }
+    void TestAdler32Known()
+    {
+        const char kStr[] = "Wikipedia";
+        Check(Adler32Update(1, kStr, sizeof(kStr) - 1) == 0x11E60398,
+            "adler32 check value mismatch");
+        Check(Adler32Update(1, kStr, 0) == 1,
+            "adler32 empty buffer is not 1");
+    }
+    void TestAdler32Lengths()
+    {
+        // Cover the simd block loop, the reduction interval, and the tail
+        // at every alignment, with the initial sums close to the modulus.
+        const uint32_t kInitial[] = { 1, 0xFFF0FFF0, 0x12345678 };
+        const size_t   kMaxLen    = 3 * 5552 + 100;
+        for (size_t k = 0; k < sizeof(kInitial) / sizeof(kInitial[0]); k++) {
+            const uint32_t theAdler =
+                Adler32Reference(kInitial[k], Ptr(0), 0);
+            for (size_t theOffset = 0; theOffset < 32; theOffset += 3) {
+                for (size_t theLen = 0; theLen <= kMaxLen;
+                        theLen += theLen < 96 ? 1 : 211) {
+                    Check(Adler32Update(theAdler, Ptr(theOffset), theLen) ==
+                            Adler32Reference(theAdler, Ptr(theOffset), theLen),
+                        "adler32 mismatch", theOffset, theLen);
+                }
+            }
+        }
+    }
+    void TestAdler32Overflow()
+    {
+        // All ones bytes maximize the sums between the modulo reductions.
+        const vector<unsigned char> theOnes(CHECKSUM_BLOCKSIZE + 77, 0xFF);
+        const uint32_t              theMax = (65520u << 16) | 65520u;
+        for (size_t theLen = CHECKSUM_BLOCKSIZE - 64;
+                theLen <= theOnes.size();
+                theLen += 7) {
+            Check(Adler32Update(theMax, &theOnes[0], theLen) ==
+                    Adler32Reference(theMax, &theOnes[0], theLen),
+                "adler32 all ones mismatch", 0, theLen);
+        }
+    }
+    void TestAdler32Combine()
+    {
+        const size_t   kLen      = 2 * CHECKSUM_BLOCKSIZE;
+        const uint32_t theAdler  = Adler32Update(1, Ptr(0), kLen);
+        for (size_t theSplit = 0; theSplit <= kLen;
+                theSplit += theSplit < 16 ? 1 : 4099) {
+            const uint32_t theFirst  = Adler32Update(1, Ptr(0), theSplit);
+            const uint32_t theSecond =
+                Adler32Update(1, Ptr(theSplit), kLen - theSplit);
+            Check(Adler32Update(theFirst, Ptr(theSplit), kLen - theSplit) ==
+                    theAdler,
+                "adler32 incremental update mismatch", 0, theSplit);
+            Check(ChecksumBlocksCombine(theFirst, theSecond, kLen - theSplit,
+                    kKfsChecksumTypeAdler32) == theAdler,
+                "adler32 block combine mismatch", 0, theSplit);
+        }
+    }
+    void TestBlockChecksums(
+        KfsChecksumType inType)
+    {
+        const size_t kLen = 2 * CHECKSUM_BLOCKSIZE + 1000;
+        const char* const thePtr = reinterpret_cast<const char*>(Ptr(5));
+        uint32_t               theTotal = 0;
+        const vector<uint32_t> theSums  =
+            ComputeChecksums(thePtr, kLen, &theTotal, inType);
+        Check(theSums.size() == 3, "invalid block checksum count", 5, kLen);
+        Check(theTotal == ComputeBlockChecksum(thePtr, kLen, inType),
+            "combined block checksums mismatch", 5, kLen);
+        IOBuffer theBuf;
+        theBuf.CopyIn(thePtr, (int)kLen);
+        const vector<uint32_t> theBufSums =
+            ComputeChecksums(&theBuf, kLen, 0, CHECKSUM_BLOCKSIZE, inType);
+        Check(theBufSums == theSums,
+            "io buffer block checksums mismatch", 5, kLen);
+        Check(ComputeBlockChecksum(&theBuf, CHECKSUM_BLOCKSIZE, inType) ==
+                theSums[0],
+            "io buffer block checksum mismatch", 5, CHECKSUM_BLOCKSIZE);
+        Check(ComputeBlockChecksumAt(&theBuf, (int)CHECKSUM_BLOCKSIZE,
+                CHECKSUM_BLOCKSIZE, inType) == theSums[1],
+            "io buffer block checksum at mismatch", 5 + CHECKSUM_BLOCKSIZE,
+            CHECKSUM_BLOCKSIZE);
+        for (size_t i = 0; i < theSums.size(); i++) {
+            const size_t theOffset = i * CHECKSUM_BLOCKSIZE;
+            const size_t theLen    =
+                std::min(size_t(CHECKSUM_BLOCKSIZE), kLen - theOffset);
+            Check(i < theSums.size() && theSums[i] ==
+                    ComputeBlockChecksum(thePtr + theOffset, theLen, inType),
+                "block checksum mismatch", theOffset, theLen);
+            if (inType == kKfsChecksumTypeCrc32c) {
+                Check(theSums[i] == Crc32cReference(0,
+                    Ptr(5 + theOffset), theLen),
+                    "crc32c block checksum reference mismatch",
+                    theOffset, theLen);
+            } else {
+                Check(theSums[i] == Adler32Reference(1,
+                    Ptr(5 + theOffset), theLen),
+                    "adler32 block checksum reference mismatch",
+                    theOffset, theLen);
+            }
+        }
+        Check(ComputeBlockChecksum(thePtr, 0, inType) ==
+                KfsNullChecksum(inType),
+            "empty block checksum is not null checksum");
+    }
+};
+
+}
+
+    int
+main(
+    int    /* inArgCount */,
+    char** /* inArgs */)
+{
+    KFS::ChecksumTest theTest;
+    return theTest.Run();
+}
@@ -0,0 +1,1038 @@
+//---------------------------------------------------------- -*- Mode: C++ -*-
+// $Id$
+//
+// Created 2026/10/16
+//
+// Copyright 2026 Quantcast Corp.
+//
+// This file is part of Kosmos File System (KFS).
+//
+// Licensed under the Apache License, Version 2.0
+// (the "License"); you may not use this file except in compliance with
+// the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+//
+// \brief Erasure code and checksum micro benchmark.
+//
+// Measures qcrs encode and every decode pattern class with 1, 2, and 3
+// missing blocks, general k+m matrix encode and decode, and the checksum.cc
+// entry points on contiguous and fragmented IOBuffers. The output is tab
+// separated, one measurement per line, with the column names in the first
+// non comment line, in order to make diffing the results across builds and
+// cpus straightforward.
+//
+//----------------------------------------------------------------------------
+
+#include "qcrs/rs.h"
+#include "kfsio/checksum.h"
+#include "kfsio/IOBuffer.h"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <time.h>
+#include <stdint.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#   include <x86intrin.h>
+#   define KFS_ECBENCH_HAS_TSC
+#endif
+
+namespace KFS
+{
+using std::string;
+using std::vector;
+
+class ECBench
+{
+public:
+    ECBench()
+        : mStripeCounts(),
+          mBlockSizes(),
+          mAlignments(),
+          mVectorSizes(),
+          mRecoveryCounts(),
+          mChecksumSize(4 << 20),
+          mMinTime(0.2),
+          mRsFlag(true),
+          mMatrixFlag(true),
+          mChecksumFlag(true),
+          mErrorCount(0)
+        {}
+    int Run(
+        int    inArgCount,
+        char** inArgsPtr)
+    {
+        int theOpt;
+        while ((theOpt = getopt(inArgCount, inArgsPtr, "k:b:a:v:m:c:t:s:h"))
+                != -1) {
+            bool theOkFlag = true;
+            switch (theOpt) {
+                case 'k':
+                    theOkFlag = ParseList(optarg, mStripeCounts);
+                    break;
+                case 'b':
+                    theOkFlag = ParseList(optarg, mBlockSizes);
+                    break;
+                case 'a':
+                    theOkFlag = ParseList(optarg, mAlignments);
+                    break;
+                case 'v':
+                    theOkFlag = ParseList(optarg, mVectorSizes);
+                    break;
+                case 'm':
+                    theOkFlag = ParseList(optarg, mRecoveryCounts);
+                    break;
+                case 'c':
+                    mChecksumSize = atoi(optarg);
+                    break;
+                case 't':
+                    mMinTime = atof(optarg);
+                    break;
+                case 's':
+                    mRsFlag       = strstr(optarg, "rs")       != 0;
+                    mMatrixFlag   = strstr(optarg, "matrix")   != 0;
+                    mChecksumFlag = strstr(optarg, "checksum") != 0;
+                    break;
+                default:
+                    theOkFlag = false;
+                    break;
+            }
+            if (! theOkFlag) {
+                return Usage(inArgsPtr[0]);
+            }
+        }
+        if (mStripeCounts.empty()) {
+            mStripeCounts.push_back(6);
+            mStripeCounts.push_back(10);
+            mStripeCounts.push_back(RS_LIB_MAX_DATA_BLOCKS);
+        }
+        if (mBlockSizes.empty()) {
+            mBlockSizes.push_back(4 << 10);
+            mBlockSizes.push_back(64 << 10);
+            mBlockSizes.push_back(1 << 20);
+        }
+        if (mAlignments.empty()) {
+            mAlignments.push_back(0);
+            mAlignments.push_back(16);
+        }
+        if (mVectorSizes.empty()) {
+            mVectorSizes.push_back(0);
+        }
+        if (mRecoveryCounts.empty()) {
+            mRecoveryCounts.push_back(3);
+            mRecoveryCounts.push_back(4);
+        }
+        for (size_t i = 0; i < mStripeCounts.size(); i++) {
+            if (mStripeCounts[i] <= 0 ||
+                    RS_LIB_MAX_DATA_BLOCKS < mStripeCounts[i]) {
+                fprintf(stderr, "invalid stripe count: %d\n",
+                    mStripeCounts[i]);
+                return 1;
+            }
+        }
+        for (size_t i = 0; i < mBlockSizes.size(); i++) {
+            if (mBlockSizes[i] <= 0 || mBlockSizes[i] % 16 != 0) {
+                fprintf(stderr, "invalid block size: %d,"
+                    " must be positive multiple of 16\n", mBlockSizes[i]);
+                return 1;
+            }
+        }
+        for (size_t i = 0; i < mAlignments.size(); i++) {
+            if (mAlignments[i] < 0 || kPageSize <= mAlignments[i] ||
+                    mAlignments[i] % 16 != 0) {
+                fprintf(stderr, "invalid alignment: %d,"
+                    " must be multiple of 16 less than %d\n",
+                    mAlignments[i], kPageSize);
+                return 1;
+            }
+        }
+        for (size_t i = 0; i < mRecoveryCounts.size(); i++) {
+            if (mRecoveryCounts[i] <= 0 ||
+                    kMaxMatrixRecoveryBlocks < mRecoveryCounts[i]) {
+                fprintf(stderr, "invalid recovery count: %d\n",
+                    mRecoveryCounts[i]);
+                return 1;
+            }
+        }
+        if (mChecksumSize <= 0 || mMinTime < 0) {
+            return Usage(inArgsPtr[0]);
+        }
+        PrintHeader();
+        if (mRsFlag || mMatrixFlag) {
+            RunErasureCode();
+        }
+        if (mChecksumFlag) {
+            RunChecksums();
+        }
+        return (mErrorCount == 0 ? 0 : 1);
+    }
+private:
+    enum { kPageSize = 4 << 10 };
+    enum { kMaxMatrixRecoveryBlocks = 8 };
+    enum { kMaxBlocks = RS_LIB_MAX_DATA_BLOCKS + kMaxMatrixRecoveryBlocks };
+
+    class Timer
+    {
+    public:
+        Timer()
+            : mStart(Now()),
+              mStartTsc(Tsc())
+            {}
+        double Elapsed() const
+            { return (Now() - mStart); }
+        double Cycles() const
+            { return (double)(Tsc() - mStartTsc); }
+    private:
+        const double   mStart;
+        const uint64_t mStartTsc;
+
+        static double Now()
+        {
+            struct timespec theTime;
+            clock_gettime(CLOCK_MONOTONIC, &theTime);
+            return (theTime.tv_sec + theTime.tv_nsec * 1e-9);
+        }
+        static uint64_t Tsc()
+        {
+#ifdef KFS_ECBENCH_HAS_TSC
+            return __rdtsc();
+#else
+            return 0;
+#endif
+        }
+    };
+    // The operation must be repeatable, the run count is increased until the
+    // run takes at least the min time.
+    class Op
+    {
+    public:
+        virtual void Execute() = 0;
+    protected:
+        virtual ~Op()
+            {}
+    };
+    template<typename T>
+    class OpT : public Op
+    {
+    public:
+        OpT(
+            T& inFunc)
+            : mFunc(inFunc)
+            {}
+        virtual void Execute()
+            { mFunc(); }
+    private:
+        T& mFunc;
+    };
+
+    vector<int> mStripeCounts;
+    vector<int> mBlockSizes;
+    vector<int> mAlignments;
+    vector<int> mVectorSizes;
+    vector<int> mRecoveryCounts;
+    int         mChecksumSize;
+    double      mMinTime;
+    bool        mRsFlag;
+    bool        mMatrixFlag;
+    bool        mChecksumFlag;
+    int         mErrorCount;
+
+    static int Usage(
+        const char* inNamePtr)
+    {
+        fprintf(stderr,
+            "Usage: %s [-k stripes] [-b block sizes] [-a alignments]"
+                " [-v vector sizes]\n"
+            "          [-m recovery blocks] [-c checksum buffer size]"
+                " [-t min seconds]\n"
+            "          [-s rs,matrix,checksum]\n"
+            "Erasure code and checksum micro benchmark, lists are comma"
+                " separated.\n"
+            "  -k data stripe counts, default 6,10,%d\n"
+            "  -b block sizes, multiple of 16, default 4096,65536,1048576\n"
+            "  -a buffer offsets from page boundary, multiple of 16,"
+                " default 0,16\n"
+            "  -v max vector sizes, 0 -- all supported, default 0\n"
+            "  -m general k+m code recovery block counts, default 3,4\n"
+            "  -c checksum buffer size, default 4194304\n"
+            "  -t min time per measurement in seconds, default 0.2,\n"
+            "     0 runs each measurement once, and can be used as a self"
+                " test\n"
+            "  -s suites to run, default rs,matrix,checksum\n"
+            "Columns: suite op variant layout vector stripes recovery"
+                " block_size align bytes\n"
+            "iterations seconds gbps cycles_per_byte; cycles are time"
+                " stamp counter\n"
+            "cycles, or -1 if not available.\n",
+            inNamePtr, RS_LIB_MAX_DATA_BLOCKS
+        );
+        return 1;
+    }
+    static bool ParseList(
+        const char*  inStrPtr,
+        vector<int>& outList)
+    {
+        outList.clear();
+        const char* thePtr = inStrPtr;
+        while (*thePtr) {
+            char*      theEndPtr = 0;
+            const long theVal    = strtol(thePtr, &theEndPtr, 0);
+            if (theEndPtr == thePtr || (*theEndPtr && *theEndPtr != ',') ||
+                    theVal < 0 || (1L << 30) < theVal) {
+                return false;
+            }
+            outList.push_back((int)theVal);
+            thePtr = *theEndPtr ? theEndPtr + 1 : theEndPtr;
+        }
+        return (! outList.empty());
+    }
+    void PrintHeader()
+    {
+        FILE* const theFilePtr = fopen("/proc/cpuinfo", "r");
+        if (theFilePtr) {
+            char theLine[512];
+            while (fgets(theLine, sizeof(theLine), theFilePtr)) {
+                if (strncmp(theLine, "model name", 10) == 0) {
+                    printf("# cpu: %s", strchr(theLine, ':') ?
+                        strchr(theLine, ':') + 2 : theLine);
+                    break;
+                }
+            }
+            fclose(theFilePtr);
+        }
+        const int theMaxVs = rs_set_max_vector_size(0);
+        printf("# max vector size: %d\n", theMaxVs);
+#ifdef KFS_ECBENCH_HAS_TSC
+        printf("# cycles: tsc\n");
+#else
+        printf("# cycles: not available\n");
+#endif
+        printf("suite\top\tvariant\tlayout\tvector\tstripes\trecovery"
+            "\tblock_size\talign\tbytes\titerations\tseconds\tgbps"
+            "\tcycles_per_byte\n");
+        fflush(stdout);
+    }
+    void Measure(
+        Op&         inOp,
+        const char* inSuitePtr,
+        const char* inOpPtr,
+        const char* inVariantPtr,
+        const char* inLayoutPtr,
+        int         inVectorSize,
+        int         inStripes,
+        int         inRecovery,
+        int         inBlockSize,
+        int         inAlign,
+        double      inBytesPerRun)
+    {
+        inOp.Execute(); // Warm up.
+        int64_t theCount   = 1;
+        double  theElapsed = 0;
+        double  theCycles  = 0;
+        for (; ;) {
+            const Timer theTimer;
+            for (int64_t i = 0; i < theCount; i++) {
+                inOp.Execute();
+            }
+            theElapsed = theTimer.Elapsed();
+            theCycles  = theTimer.Cycles();
+            if (mMinTime <= theElapsed || (int64_t(1) << 40) < theCount) {
+                break;
+            }
+            theCount *= theElapsed <= 0 ? 16 :
+                std::max(2, std::min(16, (int)(mMinTime / theElapsed * 1.2)));
+        }
+        const double theBytes = inBytesPerRun * theCount;
+        printf("%s\t%s\t%s\t%s\t%d\t%d\t%d\t%d\t%d\t%.0f\t%lld"
+                "\t%.6f\t%.3f\t%.4f\n",
+            inSuitePtr, inOpPtr, inVariantPtr, inLayoutPtr, inVectorSize,
+            inStripes, inRecovery, inBlockSize, inAlign,
+            theBytes, (long long)theCount, theElapsed,
+            theElapsed > 0 ? theBytes / theElapsed * 1e-9 : 0.,
+            (theBytes > 0 && theCycles > 0) ? theCycles / theBytes : -1.
+        );
+        fflush(stdout);
+    }
+    void Error(
+        const char* inMsgPtr,
+        const char* inOpPtr,
+        const char* inVariantPtr,
+        int         inStripes,
+        int         inBlockSize)
+    {
+        fprintf(stderr, "error: %s: %s %s stripes: %d block size: %d\n",
+            inMsgPtr, inOpPtr, inVariantPtr, inStripes, inBlockSize);
+        mErrorCount++;
+    }
+    static void FillRandom(
+        char* inPtr,
+        int   inSize)
+    {
+        for (int i = 0; i < inSize; i++) {
+            inPtr[i] = (char)rand();
+        }
+    }
+
+    // Erasure code.
+    class RsEncode
+    {
+    public:
+        RsEncode(
+            int    inStripes,
+            int    inBlockSize,
+            void** inDataPtr)
+            : mStripes(inStripes),
+              mBlockSize(inBlockSize),
+              mDataPtr(inDataPtr)
+            {}
+        void operator()()
+            { rs_encode(mStripes + 3, mBlockSize, mDataPtr); }
+    private:
+        const int    mStripes;
+        const int    mBlockSize;
+        void** const mDataPtr;
+    };
+    class RsDecode
+    {
+    public:
+        RsDecode(
+            int        inStripes,
+            int        inBlockSize,
+            void**     inDataPtr,
+            int        inMissingCount,
+            const int* inMissingPtr)
+            : mStripes(inStripes),
+              mBlockSize(inBlockSize),
+              mDataPtr(inDataPtr),
+              mMissingCount(inMissingCount),
+              mMissingPtr(inMissingPtr)
+            {}
+        void operator()()
+        {
+            const int theN = mStripes + 3;
+            switch (mMissingCount) {
+                case 1:
+                    rs_decode1(theN, mBlockSize, mMissingPtr[0], mDataPtr);
+                    break;
+                case 2:
+                    rs_decode2(theN, mBlockSize,
+                        mMissingPtr[0], mMissingPtr[1], mDataPtr);
+                    break;
+                default:
+                    rs_decode3(theN, mBlockSize,
+                        mMissingPtr[0], mMissingPtr[1], mMissingPtr[2],
+                        mDataPtr);
+                    break;
+            }
+        }
+    private:
+        const int        mStripes;
+        const int        mBlockSize;
+        void** const     mDataPtr;
+        const int        mMissingCount;
+        const int* const mMissingPtr;
+    };
+    class MatrixMul
+    {
+    public:
+        MatrixMul(
+            int                  inRows,
+            int                  inCols,
+            const unsigned char* inMatrixPtr,
+            int                  inBlockSize,
+            void**               inSrcPtr,
+            void**               inDstPtr)
+            : mRows(inRows),
+              mCols(inCols),
+              mMatrixPtr(inMatrixPtr),
+              mBlockSize(inBlockSize),
+              mSrcPtr(inSrcPtr),
+              mDstPtr(inDstPtr)
+            {}
+        void operator()()
+        {
+            rs_matrix_mul(mRows, mCols, mMatrixPtr, mBlockSize,
+                mSrcPtr, mDstPtr);
+        }
+    private:
+        const int                  mRows;
+        const int                  mCols;
+        const unsigned char* const mMatrixPtr;
+        const int                  mBlockSize;
+        void** const               mSrcPtr;
+        void** const               mDstPtr;
+    };
+
+    bool VerifyBlocks(
+        int    inCount,
+        int    inBlockSize,
+        void** inDataPtr,
+        void** inOrigPtr)
+    {
+        for (int i = 0; i < inCount; i++) {
+            if (memcmp(inDataPtr[i], inOrigPtr[i], inBlockSize) != 0) {
+                return false;
+            }
+        }
+        return true;
+    }
+    // Recompute the recovery blocks with the 16 bytes vector kernels and the
+    // general matrix multiplication, and compare them with the blocks
+    // produced by the measured encode. The data blocks are shared, and the
+    // reference recovery blocks are written into inRefPtr.
+    bool VerifyEncode(
+        int                  inVectorSize,
+        int                  inStripes,
+        int                  inRecoveryCount,
+        const unsigned char* inMatrixPtr,
+        int                  inBlockSize,
+        void**               inDataPtr,
+        void**               inRefPtr)
+    {
+        unsigned char theMatrix[
+            kMaxMatrixRecoveryBlocks * RS_LIB_MAX_DATA_BLOCKS];
+        const unsigned char* theMatrixPtr = inMatrixPtr;
+        if (! theMatrixPtr) {
+            rs_pqr_matrix(inStripes, inRecoveryCount, theMatrix);
+            theMatrixPtr = theMatrix;
+        } else if (inVectorSize <= 16) {
+            return true; // Same kernels as the measured encode.
+        }
+        const int theVs = rs_set_max_vector_size(16);
+        rs_matrix_mul(inRecoveryCount, inStripes, theMatrixPtr, inBlockSize,
+            inDataPtr, inRefPtr + inStripes);
+        rs_set_max_vector_size(theVs);
+        return VerifyBlocks(inRecoveryCount, inBlockSize,
+            inDataPtr + inStripes, inRefPtr + inStripes);
+    }
+    void RunErasureCode()
+    {
+        int theMaxStripes   = 0;
+        int theMaxBlockSize = 0;
+        for (size_t i = 0; i < mStripeCounts.size(); i++) {
+            theMaxStripes = std::max(theMaxStripes, mStripeCounts[i]);
+        }
+        for (size_t i = 0; i < mBlockSizes.size(); i++) {
+            theMaxBlockSize = std::max(theMaxBlockSize, mBlockSizes[i]);
+        }
+        const int theBlockCount = theMaxStripes + kMaxMatrixRecoveryBlocks;
+        const int theAllocSize  = theMaxBlockSize + kPageSize;
+        vector<char*> theAllocs;
+        for (int i = 0; i < 2 * theBlockCount; i++) {
+            void* thePtr = 0;
+            const int theErr = posix_memalign(&thePtr, kPageSize, theAllocSize);
+            if (theErr) {
+                fprintf(stderr, "%s\n", strerror(theErr));
+                mErrorCount++;
+                break;
+            }
+            FillRandom((char*)thePtr, theAllocSize);
+            theAllocs.push_back((char*)thePtr);
+        }
+        if ((int)theAllocs.size() == 2 * theBlockCount) {
+            vector<int> theVectorSizes;
+            for (size_t i = 0; i < mVectorSizes.size(); i++) {
+                if (mVectorSizes[i] == 0) {
+                    const int theMaxVs = rs_set_max_vector_size(0);
+                    for (int vs = 16; vs <= theMaxVs; vs *= 2) {
+                        if (rs_set_max_vector_size(vs) == vs) {
+                            theVectorSizes.push_back(vs);
+                        }
+                    }
+                } else {
+                    theVectorSizes.push_back(
+                        rs_set_max_vector_size(mVectorSizes[i]));
+                }
+            }
+            for (size_t v = 0; v < theVectorSizes.size(); v++) {
+                const int theVs = rs_set_max_vector_size(theVectorSizes[v]);
+                if (theVs != theVectorSizes[v]) {
+                    continue;
+                }
+                for (size_t s = 0; s < mStripeCounts.size(); s++) {
+                for (size_t b = 0; b < mBlockSizes.size(); b++) {
+                for (size_t a = 0; a < mAlignments.size(); a++) {
+                    void* theData[kMaxBlocks];
+                    void* theOrig[kMaxBlocks];
+                    for (int i = 0; i < theBlockCount; i++) {
+                        theData[i] = theAllocs[i] + mAlignments[a];
+                        theOrig[i] =
+                            theAllocs[theBlockCount + i] + mAlignments[a];
+                    }
+                    if (mRsFlag) {
+                        RunRs(theVs, mStripeCounts[s], mBlockSizes[b],
+                            mAlignments[a], theData, theOrig);
+                    }
+                    if (mMatrixFlag) {
+                        RunMatrix(theVs, mStripeCounts[s], mBlockSizes[b],
+                            mAlignments[a], theData, theOrig);
+                    }
+                }}}
+            }
+            rs_set_max_vector_size(0);
+        }
+        for (size_t i = 0; i < theAllocs.size(); i++) {
+            free(theAllocs[i]);
+        }
+    }
+    void RunRs(
+        int    inVectorSize,
+        int    inStripes,
+        int    inBlockSize,
+        int    inAlign,
+        void** inDataPtr,
+        void** inOrigPtr)
+    {
+        const int    theN     = inStripes + 3;
+        const double theBytes = (double)inStripes * inBlockSize;
+        RsEncode     theEncode(inStripes, inBlockSize, inDataPtr);
+        OpT<RsEncode> theEncodeOp(theEncode);
+        Measure(theEncodeOp, "rs", "encode", "-", "flat", inVectorSize,
+            inStripes, 3, inBlockSize, inAlign, theBytes);
+        if (! VerifyEncode(inVectorSize, inStripes, 3, 0, inBlockSize,
+                inDataPtr, inOrigPtr)) {
+            Error("encode mismatch", "encode", "-", inStripes, inBlockSize);
+        }
+        for (int i = 0; i < theN; i++) {
+            memcpy(inOrigPtr[i], inDataPtr[i], inBlockSize);
+        }
+        // Every pattern class: missing data blocks, taken from the beginning
+        // of the stripe, combined with every subset of P, Q, and R.
+        for (int theMissingCount = 1; theMissingCount <= 3;
+                theMissingCount++) {
+            for (int theParityMask = 0; theParityMask < 8; theParityMask++) {
+                int theMissing[3];
+                int theDataCount = theMissingCount;
+                for (int p = 0; p < 3; p++) {
+                    if ((theParityMask & (1 << p)) != 0) {
+                        theDataCount--;
+                    }
+                }
+                if (theDataCount < 0 || inStripes < theDataCount) {
+                    continue;
+                }
+                string theVariant;
+                int    theCnt = 0;
+                for (int i = 0; i < theDataCount; i++) {
+                    theMissing[theCnt++] = i;
+                    theVariant += 'D';
+                }
+                for (int p = 0; p < 3; p++) {
+                    if ((theParityMask & (1 << p)) != 0) {
+                        theMissing[theCnt++] = inStripes + p;
+                        theVariant += "PQR"[p];
+                    }
+                }
+                for (int i = 0; i < theCnt; i++) {
+                    memset(inDataPtr[theMissing[i]], 0, inBlockSize);
+                }
+                char theOpName[32];
+                snprintf(theOpName, sizeof(theOpName), "decode%d",
+                    theMissingCount);
+                RsDecode theDecode(inStripes, inBlockSize, inDataPtr,
+                    theCnt, theMissing);
+                OpT<RsDecode> theDecodeOp(theDecode);
+                Measure(theDecodeOp, "rs", theOpName, theVariant.c_str(),
+                    "flat", inVectorSize, inStripes, 3, inBlockSize, inAlign,
+                    theBytes);
+                if (! VerifyBlocks(theN, inBlockSize, inDataPtr, inOrigPtr)) {
+                    Error("decode mismatch", theOpName, theVariant.c_str(),
+                        inStripes, inBlockSize);
+                    for (int i = 0; i < theN; i++) {
+                        memcpy(inDataPtr[i], inOrigPtr[i], inBlockSize);
+                    }
+                }
+            }
+        }
+    }
+    void RunMatrix(
+        int    inVectorSize,
+        int    inStripes,
+        int    inBlockSize,
+        int    inAlign,
+        void** inDataPtr,
+        void** inOrigPtr)
+    {
+        const double theBytes = (double)inStripes * inBlockSize;
+        for (size_t r = 0; r < mRecoveryCounts.size(); r++) {
+            const int theM = mRecoveryCounts[r];
+            unsigned char theMatrix[
+                kMaxMatrixRecoveryBlocks * RS_LIB_MAX_DATA_BLOCKS];
+            unsigned char theDecode[
+                kMaxMatrixRecoveryBlocks * RS_LIB_MAX_DATA_BLOCKS];
+            int   theMissing[kMaxMatrixRecoveryBlocks];
+            int   theSources[RS_LIB_MAX_DATA_BLOCKS];
+            void* theSrc[RS_LIB_MAX_DATA_BLOCKS];
+            void* theDst[kMaxMatrixRecoveryBlocks];
+            rs_cauchy_matrix(inStripes, theM, theMatrix);
+            MatrixMul theEncode(theM, inStripes, theMatrix, inBlockSize,
+                inDataPtr, inDataPtr + inStripes);
+            OpT<MatrixMul> theEncodeOp(theEncode);
+            Measure(theEncodeOp, "matrix", "encode", "cauchy", "flat",
+                inVectorSize, inStripes, theM, inBlockSize, inAlign,
+                theBytes);
+            if (! VerifyEncode(inVectorSize, inStripes, theM, theMatrix,
+                    inBlockSize, inDataPtr, inOrigPtr)) {
+                Error("encode mismatch", "encode", "cauchy",
+                    inStripes, inBlockSize);
+            }
+            for (int i = 0; i < inStripes + theM; i++) {
+                memcpy(inOrigPtr[i], inDataPtr[i], inBlockSize);
+            }
+            // The worst case: m missing data blocks, or all data blocks if
+            // there are fewer data blocks than m.
+            const int theCnt = std::min(theM, inStripes);
+            for (int i = 0; i < theCnt; i++) {
+                theMissing[i] = i;
+            }
+            if (rs_matrix_decode_matrix(inStripes, theM, theMatrix,
+                    theCnt, theMissing, theSources, theDecode) != 0) {
+                Error("decode matrix", "decode", "cauchy",
+                    inStripes, inBlockSize);
+                continue;
+            }
+            for (int i = 0; i < inStripes; i++) {
+                theSrc[i] = inDataPtr[theSources[i]];
+            }
+            for (int i = 0; i < theCnt; i++) {
+                theDst[i] = inDataPtr[theMissing[i]];
+                memset(theDst[i], 0, inBlockSize);
+            }
+            char theVariant[32];
+            snprintf(theVariant, sizeof(theVariant), "cauchy-%dD", theCnt);
+            MatrixMul theDecodeMul(theCnt, inStripes, theDecode, inBlockSize,
+                theSrc, theDst);
+            OpT<MatrixMul> theDecodeOp(theDecodeMul);
+            Measure(theDecodeOp, "matrix", "decode", theVariant, "flat",
+                inVectorSize, inStripes, theM, inBlockSize, inAlign,
+                theBytes);
+            if (! VerifyBlocks(inStripes + theM, inBlockSize,
+                    inDataPtr, inOrigPtr)) {
+                Error("decode mismatch", "decode", theVariant,
+                    inStripes, inBlockSize);
+            }
+        }
+    }
+
+    // Checksums.
+    class BlockChecksumBuf
+    {
+    public:
+        BlockChecksumBuf(
+            const char*     inBufPtr,
+            int             inSize,
+            KfsChecksumType inType)
+            : mBufPtr(inBufPtr),
+              mSize(inSize),
+              mType(inType),
+              mResult(0)
+            {}
+        void operator()()
+        {
+            for (int i = 0; i < mSize; i += (int)CHECKSUM_BLOCKSIZE) {
+                mResult += ComputeBlockChecksum(mBufPtr + i,
+                    std::min((int)CHECKSUM_BLOCKSIZE, mSize - i), mType);
+            }
+        }
+    private:
+        const char* const     mBufPtr;
+        const int             mSize;
+        const KfsChecksumType mType;
+        uint32_t              mResult;
+    };
+    class ChecksumsBuf
+    {
+    public:
+        ChecksumsBuf(
+            const char*     inBufPtr,
+            int             inSize,
+            KfsChecksumType inType)
+            : mBufPtr(inBufPtr),
+              mSize(inSize),
+              mType(inType),
+              mResult(0)
+            {}
+        void operator()()
+        {
+            uint32_t theChksum = 0;
+            mResult += (uint32_t)ComputeChecksums(
+                mBufPtr, mSize, &theChksum, mType).size() + theChksum;
+        }
+    private:
+        const char* const     mBufPtr;
+        const int             mSize;
+        const KfsChecksumType mType;
+        uint32_t              mResult;
+    };
+    class Crc32Buf
+    {
+    public:
+        Crc32Buf(
+            const char* inBufPtr,
+            int         inSize)
+            : mBufPtr(inBufPtr),
+              mSize(inSize),
+              mResult(0)
+            {}
+        void operator()()
+            { mResult = ComputeCrc32(mBufPtr, mSize, mResult); }
+    private:
+        const char* const mBufPtr;
+        const int         mSize;
+        uint32_t          mResult;
+    };
+    class Combine
+    {
+    public:
+        Combine(
+            const vector<uint32_t>& inChecksums,
+            KfsChecksumType         inType)
+            : mChecksums(inChecksums),
+              mType(inType),
+              mResult(0)
+            {}
+        void operator()()
+        {
+            uint32_t theChksum = KfsNullChecksum(mType);
+            for (size_t i = 0; i < mChecksums.size(); i++) {
+                theChksum = ChecksumBlocksCombine(theChksum, mChecksums[i],
+                    CHECKSUM_BLOCKSIZE, mType);
+            }
+            mResult += theChksum;
+        }
+    private:
+        const vector<uint32_t>& mChecksums;
+        const KfsChecksumType   mType;
+        uint32_t                mResult;
+    };
+    class BlockChecksumIoBuf
+    {
+    public:
+        BlockChecksumIoBuf(
+            const IOBuffer& inBuf,
+            KfsChecksumType inType)
+            : mBuf(inBuf),
+              mType(inType),
+              mResult(0)
+            {}
+        void operator()()
+        {
+            mResult += ComputeBlockChecksum(&mBuf, mBuf.BytesConsumable(),
+                mType);
+        }
+    private:
+        const IOBuffer&       mBuf;
+        const KfsChecksumType mType;
+        uint32_t              mResult;
+    };
+    class BlockChecksumAtIoBuf
+    {
+    public:
+        BlockChecksumAtIoBuf(
+            const IOBuffer& inBuf,
+            int             inPos,
+            KfsChecksumType inType)
+            : mBuf(inBuf),
+              mPos(inPos),
+              mType(inType),
+              mResult(0)
+            {}
+        void operator()()
+        {
+            mResult += ComputeBlockChecksumAt(&mBuf, mPos,
+                mBuf.BytesConsumable() - mPos, mType);
+        }
+    private:
+        const IOBuffer&       mBuf;
+        const int             mPos;
+        const KfsChecksumType mType;
+        uint32_t              mResult;
+    };
+    class ChecksumsIoBuf
+    {
+    public:
+        ChecksumsIoBuf(
+            const IOBuffer& inBuf,
+            KfsChecksumType inType)
+            : mBuf(inBuf),
+              mType(inType),
+              mResult(0)
+            {}
+        void operator()()
+        {
+            uint32_t theChksum = 0;
+            mResult += (uint32_t)ComputeChecksums(&mBuf,
+                mBuf.BytesConsumable(), &theChksum, CHECKSUM_BLOCKSIZE,
+                mType).size() + theChksum;
+        }
+    private:
+        const IOBuffer&       mBuf;
+        const KfsChecksumType mType;
+        uint32_t              mResult;
+    };
+    class AppendToVectorIoBuf
+    {
+    public:
+        AppendToVectorIoBuf(
+            const IOBuffer& inBuf,
+            size_t          inFirstBlockLen,
+            KfsChecksumType inType)
+            : mBuf(inBuf),
+              mFirstBlockLen(inFirstBlockLen),
+              mType(inType),
+              mChecksums(),
+              mResult(0)
+            {}
+        void operator()()
+        {
+            uint32_t theChksum = 0;
+            mChecksums.clear();
+            AppendToChecksumVector(mBuf, mBuf.BytesConsumable(), &theChksum,
+                mFirstBlockLen, mChecksums, mType);
+            mResult += theChksum;
+        }
+    private:
+        const IOBuffer&       mBuf;
+        const size_t          mFirstBlockLen;
+        const KfsChecksumType mType;
+        vector<uint32_t>      mChecksums;
+        uint32_t              mResult;
+    };
+
+    static const char* TypeName(
+        KfsChecksumType inType)
+    {
+        return (inType == kKfsChecksumTypeCrc32c ? "crc32c" : "adler32");
+    }
+    void RunChecksums()
+    {
+        const int theSize = mChecksumSize;
+        for (size_t a = 0; a < mAlignments.size(); a++) {
+            const int theAlign     = mAlignments[a];
+            void*     theAllocPtr  = 0;
+            const int theErr       = posix_memalign(
+                &theAllocPtr, kPageSize, theSize + kPageSize);
+            if (theErr) {
+                fprintf(stderr, "%s\n", strerror(theErr));
+                mErrorCount++;
+                return;
+            }
+            char* const theBufPtr = (char*)theAllocPtr + theAlign;
+            FillRandom(theBufPtr, theSize);
+            for (int t = 0; t < kKfsChecksumTypeCount; t++) {
+                const KfsChecksumType theType = (KfsChecksumType)t;
+                const char* const     theName = TypeName(theType);
+                BlockChecksumBuf theBlock(theBufPtr, theSize, theType);
+                OpT<BlockChecksumBuf> theBlockOp(theBlock);
+                Measure(theBlockOp, "checksum", "block_buf", theName, "flat",
+                    0, 0, 0, theSize, theAlign, theSize);
+                ChecksumsBuf theChecksums(theBufPtr, theSize, theType);
+                OpT<ChecksumsBuf> theChecksumsOp(theChecksums);
+                Measure(theChecksumsOp, "checksum", "checksums_buf", theName,
+                    "flat", 0, 0, 0, theSize, theAlign, theSize);
+                const vector<uint32_t> theBlockChecksums =
+                    ComputeChecksums(theBufPtr, theSize, 0, theType);
+                Combine theCombine(theBlockChecksums, theType);
+                OpT<Combine> theCombineOp(theCombine);
+                Measure(theCombineOp, "checksum", "combine", theName, "flat",
+                    0, 0, 0, theSize, theAlign, theSize);
+            }
+            Crc32Buf theCrc32(theBufPtr, theSize);
+            OpT<Crc32Buf> theCrc32Op(theCrc32);
+            Measure(theCrc32Op, "checksum", "crc32_buf", "crc32", "flat",
+                0, 0, 0, theSize, theAlign, theSize);
+            // Contiguous: one buffer, "4k": the default IOBuffer blocks,
+            // "1448": tcp segment size fragments referencing one buffer.
+            const char* const kLayouts[] = { "contig", "4k", "1448" };
+            for (size_t l = 0; l < sizeof(kLayouts) / sizeof(kLayouts[0]);
+                    l++) {
+                IOBuffer theIoBuf;
+                if (l == 0) {
+                    char* const thePtr = new char[theSize + theAlign];
+                    memcpy(thePtr + theAlign, theBufPtr, theSize);
+                    theIoBuf.Append(IOBufferData(
+                        thePtr, theSize + theAlign, theAlign, theSize));
+                } else if (l == 1) {
+                    theIoBuf.CopyIn(theBufPtr, theSize);
+                } else {
+                    char* const thePtr = new char[theSize + theAlign];
+                    memcpy(thePtr + theAlign, theBufPtr, theSize);
+                    const IOBufferData theData(
+                        thePtr, theSize + theAlign, theAlign, theSize);
+                    for (int i = 0; i < theSize; i += 1448) {
+                        char* const theStartPtr =
+                            const_cast<char*>(theData.Consumer()) + i;
+                        theIoBuf.Append(IOBufferData(theData, theStartPtr,
+                            theStartPtr + std::min(1448, theSize - i)));
+                    }
+                }
+                if (theIoBuf.BytesConsumable() != theSize) {
+                    Error("iobuffer", kLayouts[l], "", 0, theSize);
+                    continue;
+                }
+                for (int t = 0; t < kKfsChecksumTypeCount; t++) {
+                    const KfsChecksumType theType = (KfsChecksumType)t;
+                    const char* const     theName = TypeName(theType);
+                    BlockChecksumIoBuf theBlock(theIoBuf, theType);
+                    OpT<BlockChecksumIoBuf> theBlockOp(theBlock);
+                    Measure(theBlockOp, "checksum", "block_iobuf", theName,
+                        kLayouts[l], 0, 0, 0, theSize, theAlign, theSize);
+                    // Unaligned start position, like partial block reads.
+                    const int theStartPos = 512;
+                    BlockChecksumAtIoBuf theBlockAt(
+                        theIoBuf, theStartPos, theType);
+                    OpT<BlockChecksumAtIoBuf> theBlockAtOp(theBlockAt);
+                    Measure(theBlockAtOp, "checksum", "block_at_iobuf",
+                        theName, kLayouts[l], 0, 0, 0, theSize, theAlign,
+                        theSize - theStartPos);
+                    ChecksumsIoBuf theChecksums(theIoBuf, theType);
+                    OpT<ChecksumsIoBuf> theChecksumsOp(theChecksums);
+                    Measure(theChecksumsOp, "checksum", "checksums_iobuf",
+                        theName, kLayouts[l], 0, 0, 0, theSize, theAlign,
+                        theSize);
+                    AppendToVectorIoBuf theAppend(theIoBuf,
+                        CHECKSUM_BLOCKSIZE - theStartPos, theType);
+                    OpT<AppendToVectorIoBuf> theAppendOp(theAppend);
+                    Measure(theAppendOp, "checksum", "append_vector_iobuf",
+                        theName, kLayouts[l], 0, 0, 0, theSize, theAlign,
+                        theSize);
+                    vector<uint32_t> theVec;
+                    uint32_t         theIoChksum  = 0;
+                    uint32_t         theBufChksum = 0;
+                    AppendToChecksumVector(theIoBuf, theSize, &theIoChksum,
+                        CHECKSUM_BLOCKSIZE, theVec, theType);
+                    if (ComputeChecksums(theBufPtr, theSize, &theBufChksum,
+                                theType) != theVec ||
+                            theIoChksum != theBufChksum) {
+                        Error("checksum mismatch", "append_vector_iobuf",
+                            kLayouts[l], 0, theSize);
+                    }
+                }
+            }
+            free(theAllocPtr);
+        }
+    }
+};
+
+}
+
+int
+main(int argc, char** argv)
+{
+    KFS::ECBench theBench;
+    return theBench.Run(argc, argv);
+}
@@ -0,0 +1,464 @@
+//---------------------------------------------------------- -*- Mode: C++ -*-
+// $Id$
+//
+// Created 2026/10/16
+//
+// Copyright 2026 Quantcast Corp.
+//
+// This file is part of Kosmos File System (KFS).
+//
+// Licensed under the Apache License, Version 2.0
+// (the "License"); you may not use this file except in compliance with
+// the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+//
+// IOBuffer unit test: random sequences of the buffer operations checked
+// against a flat string model, including shared buffer fragments and moved
+// available space, string search across fragment boundaries, buffer
+// reference counts, and fragment ring growth and iterators.
+//
+//----------------------------------------------------------------------------
+
+#include "kfsio/IOBuffer.h"
+
+#include <stdlib.h>
+
+#include <algorithm>
+#include <iostream>
+#include <string>
+
+#include <boost/shared_ptr.hpp>
+
+namespace KFS
+{
+
+using std::cerr;
+using std::cout;
+using std::max;
+using std::min;
+using std::string;
+
+class IOBufferTest
+{
+public:
+    IOBufferTest()
+        : mErrorCount(0),
+          mOpCount(0)
+        {}
+    int Run()
+    {
+        TestSwap();
+        TestRefCount();
+        TestRing();
+        srandom(1);
+        TestIndexOf();
+        IOBuffer theBufs[2];
+        string   theModels[2];
+        for (mOpCount = 0; mOpCount < 50000 && mErrorCount <= 0;
+                mOpCount++) {
+            const int theIdx = (int)(random() & 1);
+            RandomOp(theBufs[theIdx], theModels[theIdx],
+                theBufs[1 - theIdx], theModels[1 - theIdx]);
+            Verify(theBufs[0], theModels[0], "first buffer");
+            Verify(theBufs[1], theModels[1], "second buffer");
+        }
+        if (mErrorCount <= 0) {
+            cout << "io buffer test: passed\n";
+        }
+        return (mErrorCount <= 0 ? 0 : 1);
+    }
+private:
+    int mErrorCount;
+    int mOpCount;
+
+    void Check(
+        bool        inOkFlag,
+        const char* inMsgPtr)
+    {
+        if (! inOkFlag) {
+            cerr << "error: " << inMsgPtr << " op: " << mOpCount << "\n";
+            mErrorCount++;
+        }
+    }
+    void Verify(
+        const IOBuffer& inBuf,
+        const string&   inModel,
+        const char*     inMsgPtr)
+    {
+        inBuf.Verify();
+        if (inBuf.BytesConsumable() != (int)inModel.size()) {
+            Check(false, inMsgPtr);
+            return;
+        }
+        string theData(inModel.size(), 0);
+        if (! theData.empty()) {
+            inBuf.CopyOut(&theData[0], (int)theData.size());
+        }
+        Check(theData == inModel, inMsgPtr);
+    }
+    static int Rand(
+        int inMax)
+        { return (inMax <= 0 ? 0 : (int)(random() % (inMax + 1))); }
+    static string RandomData(
+        int inSize)
+    {
+        string theRet(inSize, 0);
+        for (int i = 0; i < inSize; i++) {
+            theRet[i] = (char)random();
+        }
+        return theRet;
+    }
+    static int RandomSize()
+    {
+        const int theBufSize = IOBufferData::GetDefaultBufferSize();
+        return ((random() & 1) == 0 ? Rand(64) : Rand(3 * theBufSize + 7));
+    }
+    void CopyIn(
+        IOBuffer& inBuf,
+        string&   inModel,
+        int       inSize)
+    {
+        const string theData = RandomData(inSize);
+        Check(inBuf.CopyIn(theData.data(), inSize) == inSize, "copy in");
+        inModel += theData;
+    }
+    void RandomOp(
+        IOBuffer& inBuf,
+        string&   inModel,
+        IOBuffer& inOther,
+        string&   inOtherModel)
+    {
+        if ((256 << 10) < inModel.size()) {
+            const int theSize = Rand((int)inModel.size());
+            inBuf.Consume(theSize);
+            inModel.erase(0, theSize);
+        }
+        const int theSize = RandomSize();
+        switch (Rand(14)) {
+            case 0:
+            case 1:
+                CopyIn(inBuf, inModel, theSize);
+                break;
+            case 2: {
+                const int theLen = min(theSize, (int)inOtherModel.size());
+                Check(inBuf.Copy(&inOther, theSize) == theLen, "copy");
+                inModel += inOtherModel.substr(0, theLen);
+                break;
+            }
+            case 3: {
+                const int theLen = min(theSize, (int)inOtherModel.size());
+                Check(inBuf.Move(&inOther, theSize) == theLen, "move");
+                inModel += inOtherModel.substr(0, theLen);
+                inOtherModel.erase(0, theLen);
+                break;
+            }
+            case 4:
+                inBuf.Move(&inOther);
+                inModel += inOtherModel;
+                inOtherModel.clear();
+                break;
+            case 5: {
+                const int theLen = min(theSize, (int)inModel.size());
+                Check(inBuf.Consume(theSize) == theLen, "consume");
+                inModel.erase(0, theLen);
+                break;
+            }
+            case 6:
+                // Trim leaves the trimmed space available in the last
+                // buffer, which might be shared, remove it before appending.
+                inBuf.Trim(theSize);
+                inBuf.RemoveSpaceAvailable();
+                inModel.resize(min(inModel.size(), (size_t)theSize));
+                break;
+            case 7:
+            case 8: {
+                const int theOffset = Rand((int)inModel.size() + 5000);
+                const int theLen    = min(theSize, (int)inOtherModel.size());
+                if (Rand(1) == 0) {
+                    inBuf.Replace(&inOther, theOffset, theSize);
+                } else {
+                    // The callers keep the destination buffers full, and never
+                    // request more than the source has.
+                    inBuf.MakeBuffersFull();
+                    inBuf.ReplaceKeepBuffersFull(&inOther, theOffset, theLen);
+                }
+                if (inModel.size() < (size_t)theOffset) {
+                    inModel.resize(theOffset, 0);
+                }
+                inModel.replace(theOffset, theLen,
+                    inOtherModel.substr(0, theLen));
+                inOtherModel.erase(0, theLen);
+                break;
+            }
+            case 9:
+                inBuf.ZeroFill(theSize);
+                inModel.append(theSize, 0);
+                break;
+            case 10:
+                inBuf.MakeBuffersFull();
+                break;
+            case 11: {
+                // Modifications of the clone must not change the original.
+                inBuf.MakeBuffersFull();
+                IOBuffer* const theClonePtr = inBuf.Clone();
+                string          theModel    = inModel;
+                Verify(*theClonePtr, theModel, "clone");
+                CopyIn(*theClonePtr, theModel, theSize);
+                IOBuffer theSrc;
+                string   theSrcModel;
+                CopyIn(theSrc, theSrcModel, RandomSize());
+                const int theOffset = Rand((int)theModel.size());
+                theClonePtr->ReplaceKeepBuffersFull(
+                    &theSrc, theOffset, (int)theSrcModel.size());
+                theModel.replace(theOffset, theSrcModel.size(), theSrcModel);
+                Verify(*theClonePtr, theModel, "modified clone");
+                delete theClonePtr;
+                break;
+            }
+            case 12: {
+                const int theOtherSize = inOther.BytesConsumable();
+                inBuf.MoveSpace(&inOther, theSize);
+                const int theLen = theOtherSize - inOther.BytesConsumable();
+                Check(0 <= theLen && theLen <= theSize, "move space");
+                inModel += inOtherModel.substr(0, theLen);
+                inOtherModel.erase(0, theLen);
+                break;
+            }
+            case 13: {
+                // Append to both buffers after moving the available space,
+                // in order to check that the space is no longer shared.
+                inBuf.MoveSpaceAvailable(&inOther, theSize);
+                CopyIn(inBuf, inModel, RandomSize());
+                CopyIn(inOther, inOtherModel, RandomSize());
+                break;
+            }
+            case 14: {
+                // Use the available space transiently, the space remains
+                // owned by the other buffer.
+                inBuf.EnsureSpaceAvailable(theSize);
+                IOBuffer theTmp;
+                string   theTmpModel;
+                CopyIn(theTmp, theTmpModel, RandomSize());
+                const int theLen = theTmp.UseSpaceAvailable(&inBuf, theSize);
+                Check(0 <= theLen && theLen <= theSize, "use space available");
+                Verify(theTmp, theTmpModel, "use space available");
+                break;
+            }
+        }
+    }
+    // Search random header like data split into random fragments, with the
+    // patterns that can match across the fragment boundaries, and the
+    // fragments longer than the 16 byte search blocks.
+    void TestIndexOf()
+    {
+        const char kAlphabet[] = "\r\n\r\nab";
+        const int  kLast       = (int)sizeof(kAlphabet) - 2;
+        const char* const kPatterns[] = {
+            "\r\n\r\n", "\r\n", "\n", "ab\r", "\r\n\r\na", 0
+        };
+        for (int k = 0; k < 20000 && mErrorCount <= 0; k++) {
+            const int theSize = (k & 15) == 0 ? Rand(5000) : Rand(300);
+            string    theModel(theSize, 0);
+            for (int i = 0; i < theSize; i++) {
+                theModel[i] = kAlphabet[Rand(kLast)];
+            }
+            IOBuffer theBuf;
+            for (int thePos = 0; thePos < theSize; ) {
+                const int theLen = min(theSize - thePos,
+                    1 + ((random() & 7) == 0 ? Rand(2000) : Rand(40)));
+                IOBuffer theFrag;
+                theFrag.CopyIn(theModel.data() + thePos, theLen);
+                theBuf.Move(&theFrag);
+                thePos += theLen;
+            }
+            string thePattern;
+            for (int i = 0; i < 6; i++) {
+                if (kPatterns[i]) {
+                    thePattern = kPatterns[i];
+                } else if (0 < theSize && (random() & 1) == 0) {
+                    thePattern = theModel.substr(
+                        Rand(theSize - 1), 1 + Rand(20));
+                } else {
+                    thePattern.resize(1 + Rand(20));
+                    for (size_t j = 0; j < thePattern.size(); j++) {
+                        thePattern[j] = kAlphabet[Rand(kLast)];
+                    }
+                }
+                const int    theOffset =
+                    (k & 1) == 0 ? 0 : Rand(theSize + 2) - 1;
+                const size_t theRef    =
+                    theModel.find(thePattern, max(0, theOffset));
+                Check(theBuf.IndexOf(theOffset, thePattern.c_str()) ==
+                        (theRef == string::npos ? -1 : (int)theRef),
+                    "index of");
+            }
+        }
+    }
+    void TestSwap()
+    {
+        IOBufferData       theData;
+        const IOBufferData theShared(theData, theData.Consumer(),
+            theData.Consumer() + theData.SpaceAvailable());
+        IOBufferData       theOther;
+        const char* const  theConsumer = theOther.Consumer();
+        const size_t       theSpace    = theOther.SpaceAvailable();
+        Check(theData.IsShared() && ! theOther.IsShared(), "swap: setup");
+        theData.Swap(theOther);
+        Check(! theData.IsShared() && theOther.IsShared() &&
+            theData.Consumer() == theConsumer &&
+            theData.SpaceAvailable() == theSpace &&
+            theOther.Consumer() == theShared.Consumer(),
+            "swap: buffers not exchanged");
+    }
+    struct CountingDeleter
+    {
+        CountingDeleter(
+            int& inCount)
+            : mCount(inCount)
+            {}
+        void operator()(
+            char* inPtr)
+        {
+            mCount++;
+            delete [] inPtr;
+        }
+        int& mCount;
+    };
+    void TestRefCount()
+    {
+        IOBufferData theData;
+        Check(! theData.IsShared(), "ref count: new buffer is shared");
+        {
+            IOBufferData theCopy(theData);
+            Check(theData.IsShared() && theCopy.IsShared() &&
+                theCopy.Consumer() == theData.Consumer(),
+                "ref count: copy is not shared");
+            IOBufferData theOther;
+            theOther = theCopy;
+            theCopy  = IOBufferData();
+            Check(theData.IsShared() && ! theCopy.IsShared(),
+                "ref count: assignment");
+            Check(! theData.DetachBuffer(true),
+                "ref count: shared buffer detached");
+        }
+        Check(! theData.IsShared(), "ref count: copies not released");
+        char* const theConsumer = theData.Consumer();
+        char* const theBufPtr   = theData.DetachBuffer(true);
+        Check(theBufPtr == theConsumer && ! theData.Consumer() &&
+            theData.SpaceAvailable() == 0, "ref count: detach");
+        delete [] theBufPtr;
+
+        int theDeleteCount = 0;
+        {
+            const IOBufferData::IOBufferBlockPtr theBlockPtr(
+                new char[64], CountingDeleter(theDeleteCount));
+            IOBufferData theBlock(theBlockPtr, 64, 0, 16);
+            IOBufferData theShared(theBlock, theBlock.Consumer(),
+                theBlock.Producer());
+            Check(theBlock.BytesConsumable() == 16 &&
+                theShared.BytesConsumable() == 16 &&
+                ! theBlock.DetachBuffer(false),
+                "ref count: block pointer");
+        }
+        Check(theDeleteCount == 1, "ref count: block pointer not released");
+
+        const int    theBufSize = IOBufferData::GetDefaultBufferSize();
+        const string theModel   = RandomData(3 * theBufSize);
+        IOBuffer     theBuf;
+        theBuf.CopyIn(theModel.data(), (int)theModel.size());
+        IOBuffer* const theClonePtr = theBuf.Clone();
+        Check(! theBuf.DetachFrontBuffer(true),
+            "ref count: shared front buffer detached");
+        delete theClonePtr;
+        char* const theFrontPtr = theBuf.DetachFrontBuffer(true);
+        Check(theFrontPtr &&
+            theBuf.BytesConsumable() == (int)theModel.size() - theBufSize,
+            "ref count: front buffer detach");
+        delete [] theFrontPtr;
+    }
+    void TestRing()
+    {
+        // Many small fragments to grow the ring past the inline storage.
+        const int kFragmentCount = 300;
+        IOBuffer  theBuf;
+        string    theModel;
+        IOBuffer::iterator const theEnd = theBuf.end();
+        for (int i = 0; i < kFragmentCount; i++) {
+            const int    theSize = 1 + i % 13;
+            const string theData = RandomData(theSize);
+            IOBufferData theFrag(theSize);
+            theFrag.CopyIn(theData.data(), theSize);
+            theBuf.Append(theFrag);
+            theModel += theData;
+        }
+        Verify(theBuf, theModel, "ring: append");
+        Check(theEnd == theBuf.end(), "ring: end iterator changed");
+        int theCount = 0;
+        int thePos   = (int)theModel.size();
+        for (IOBuffer::iterator theIt = theBuf.end();
+                theIt != theBuf.begin(); ) {
+            --theIt;
+            const int theSize = theIt->BytesConsumable();
+            thePos -= theSize;
+            Check(0 <= thePos && string(theIt->Consumer(), theSize) ==
+                theModel.substr(thePos, theSize), "ring: reverse iteration");
+            theCount++;
+        }
+        Check(theCount == kFragmentCount && thePos == 0,
+            "ring: reverse iteration count");
+        // Iterators past the consumed fragments remain valid.
+        IOBuffer::iterator theIt = theBuf.begin();
+        int theSkip = 0;
+        for (int i = 0; i < kFragmentCount / 2; i++) {
+            theSkip += theIt->BytesConsumable();
+            ++theIt;
+        }
+        const char* const theConsumer = theIt->Consumer();
+        theBuf.Consume(theSkip);
+        theModel.erase(0, theSkip);
+        Check(theIt == theBuf.begin() && theIt->Consumer() == theConsumer,
+            "ring: iterator invalidated by consume");
+        // Move between the large ring, and the buffers with inline fragments.
+        IOBuffer theSmall;
+        string   theSmallModel = RandomData(5);
+        theSmall.CopyIn(theSmallModel.data(), (int)theSmallModel.size());
+        theSmall.Move(&theBuf);
+        theSmallModel += theModel;
+        theModel.clear();
+        Verify(theBuf, theModel, "ring: move source");
+        Verify(theSmall, theSmallModel, "ring: move destination");
+        theBuf.Move(&theSmall, 7);
+        theModel = theSmallModel.substr(0, 7);
+        theSmallModel.erase(0, 7);
+        theSmall.MakeBuffersFull();
+        Verify(theBuf, theModel, "ring: partial move");
+        Verify(theSmall, theSmallModel, "ring: make buffers full");
+        theBuf.Replace(&theSmall, 3, 40);
+        theModel = theModel.substr(0, 3) + theSmallModel.substr(0, 40);
+        theSmallModel.erase(0, 40);
+        Verify(theBuf, theModel, "ring: replace");
+        Verify(theSmall, theSmallModel, "ring: replace source");
+        theSmall.Clear();
+        theSmallModel.clear();
+        Check(theSmall.begin() == theSmall.end(), "ring: clear");
+        Verify(theSmall, theSmallModel, "ring: clear");
+    }
+};
+
+}
+
+    int
+main(
+    int    /* inArgCount */,
+    char** /* inArgs */)
+{
+    KFS::IOBufferTest theTest;
+    return theTest.Run();
+}
@@ -0,0 +1,192 @@
+//---------------------------------------------------------- -*- Mode: C++ -*-
+// $Id$
+//
+// Created 2026/10/16
+//
+// Copyright 2026 Quantcast Corp.
+//
+// This file is part of Kosmos File System (KFS).
+//
+// Licensed under the Apache License, Version 2.0
+// (the "License"); you may not use this file except in compliance with
+// the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+//
+// Properties tokenizer test: random request headers tokenized with the
+// block scan tokenizer and the byte by byte reference.
+//
+//----------------------------------------------------------------------------
+
+#include "common/RequestParser.h"
+
+#include <stdlib.h>
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace KFS
+{
+
+using std::cerr;
+using std::cout;
+using std::string;
+using std::vector;
+
+class PropertiesTokenizerTest
+{
+public:
+    PropertiesTokenizerTest()
+        : mErrorCount(0)
+        {}
+    int Run()
+    {
+        srandom(1);
+        for (int i = 0; i < 100000 && mErrorCount <= 0; i++) {
+            const string theHdr = RandomHeader(
+                (i & 15) == 0 ? (int)(random() % 4000) :
+                    (int)(random() % 200));
+            for (int k = 0; k < 4; k++) {
+                const int  theSeparator = (k & 1) == 0 ? ':' : '=';
+                const bool theIgnoreFlag = (k & 2) == 0;
+                Check(Tokenize(theHdr, theSeparator, theIgnoreFlag) ==
+                    Reference(theHdr, theSeparator, theIgnoreFlag), theHdr);
+            }
+        }
+        if (mErrorCount <= 0) {
+            cout << "properties tokenizer test: passed\n";
+        }
+        return (mErrorCount <= 0 ? 0 : 1);
+    }
+private:
+    typedef vector<string> Tokens;
+
+    int mErrorCount;
+
+    void Check(
+        bool          inOkFlag,
+        const string& inHeader)
+    {
+        if (! inOkFlag) {
+            cerr << "error: tokens mismatch, header length: " <<
+                inHeader.size() << "\n";
+            mErrorCount++;
+        }
+    }
+    static string RandomHeader(
+        int inSize)
+    {
+        // Mostly key value lines, with the white space and separators
+        // frequent enough to produce all line forms.
+        const char kAlphabet[] = " \t\r\n:=\x01\xFF" "abcdefgh";
+        string theRet(inSize, 0);
+        for (int i = 0; i < inSize; i++) {
+            theRet[i] = kAlphabet[random() % (sizeof(kAlphabet) - 1)];
+        }
+        return theRet;
+    }
+    static Tokens Tokenize(
+        const string& inHeader,
+        int           inSeparator,
+        bool          inIgnoreMalformedFlag)
+    {
+        // Copy into exact size buffer, in order to detect reads past the
+        // end with memory checkers.
+        vector<char>        theBuf(inHeader.begin(), inHeader.end());
+        const char* const   thePtr = theBuf.empty() ? 0 : &theBuf[0];
+        PropertiesTokenizer theTokenizer(
+            thePtr, theBuf.size(), inIgnoreMalformedFlag);
+        Tokens theRet;
+        while (theTokenizer.Next(inSeparator)) {
+            theRet.push_back(theTokenizer.GetKey().ToString());
+            theRet.push_back(theTokenizer.GetValue().ToString());
+        }
+        theRet.push_back(theTokenizer.GetKey().ToString());
+        return theRet;
+    }
+    static bool IsWSpace(
+        char inChar)
+        { return ((inChar & 0xFF) <= ' '); }
+    // Byte by byte tokenizer, the same as the PropertiesTokenizer::Next()
+    // prior to the block scan.
+    static Tokens Reference(
+        const string& inHeader,
+        int           inSeparator,
+        bool          inIgnoreMalformedFlag)
+    {
+        const char*       thePtr    = inHeader.data();
+        const char* const theEndPtr = thePtr + inHeader.size();
+        Tokens            theRet;
+        string            theKey;
+        while (thePtr < theEndPtr) {
+            while (thePtr < theEndPtr && IsWSpace(*thePtr)) {
+                thePtr++;
+            }
+            if (thePtr >= theEndPtr) {
+                break;
+            }
+            const char* const theKeyPtr = thePtr;
+            while (thePtr < theEndPtr && *thePtr != inSeparator &&
+                    ! IsWSpace(*thePtr)) {
+                thePtr++;
+            }
+            if (thePtr >= theEndPtr) {
+                break;
+            }
+            const char* theKeyEndPtr = thePtr;
+            while (thePtr < theEndPtr && *thePtr != inSeparator &&
+                    *thePtr != '\r' && *thePtr != '\n') {
+                if (! IsWSpace(*thePtr)) {
+                    theKeyEndPtr = thePtr + 1;
+                }
+                thePtr++;
+            }
+            if (thePtr >= theEndPtr || *thePtr != inSeparator) {
+                while (thePtr < theEndPtr && *thePtr != '\n') {
+                    thePtr++;
+                }
+                if (inIgnoreMalformedFlag) {
+                    continue;
+                }
+                theKey.assign(theKeyPtr, theKeyEndPtr - theKeyPtr);
+                break;
+            }
+            thePtr++;
+            while (thePtr < theEndPtr && IsWSpace(*thePtr) &&
+                    *thePtr != '\r' && *thePtr != '\n') {
+                thePtr++;
+            }
+            const char* const theValuePtr    = thePtr;
+            const char*       theValueEndPtr = thePtr;
+            while (thePtr < theEndPtr && *thePtr != '\r' && *thePtr != '\n') {
+                if (! IsWSpace(*thePtr)) {
+                    theValueEndPtr = thePtr + 1;
+                }
+                thePtr++;
+            }
+            theKey.assign(theKeyPtr, theKeyEndPtr - theKeyPtr);
+            theRet.push_back(theKey);
+            theRet.push_back(string(theValuePtr, theValueEndPtr - theValuePtr));
+        }
+        theRet.push_back(theKey);
+        return theRet;
+    }
+};
+
+}
+
+    int
+main(
+    int    /* inArgCount */,
+    char** /* inArgs */)
+{
+    KFS::PropertiesTokenizerTest theTest;
+    return theTest.Run();
+}
@@ -51,6 +51,7 @@ using std::cerr;
 using std::cout;
 using std::string;
 using std::istringstream;
+using std::ostringstream;
 
 class SslFilterTest :
     private IAcceptorOwner,
@@ -102,6 +103,7 @@ private:
     int             mMaxReadAhead;
     int             mMaxWriteBehind;
     bool            mUseFilterFlag;
+    int             mGetPskCount;
 
     static SslFilterTest* sInstancePtr;
 
@@ -180,7 +182,26 @@ private:
                     }
                     break;
 
-	        case EVENT_NET_ERROR:
+	        case EVENT_NET_ERROR: {
+                    NetConnection::Filter* theFilterPtr;
+                    if (mConnectionPtr->IsGood() &&
+                            (theFilterPtr = mConnectionPtr->GetFilter()) &&
+                            theFilterPtr->IsShutdownReceived() &&
+                            ! mConnectionPtr->IsWriteReady() &&
+                            mConnectionPtr->GetInBuffer().IsEmpty()) {
+                        // Ssl shutdown from the other side, continue in
+                        // clear text.
+                        const int theErr = mConnectionPtr->Shutdown();
+                        KFS_LOG_STREAM(theErr == 0 ?
+                                MsgLogger::kLogLevelDEBUG :
+                                MsgLogger::kLogLevelERROR) <<
+                            mPeerName << "filter shutdown"
+                            " status: " << theErr <<
+                        KFS_LOG_EOM;
+                        if (theErr == 0) {
+                            break;
+                        }
+                    }
                     mConnectionPtr->SetMaxReadAhead(0);
                     if (mConnectionPtr->IsGood() &&
                             mConnectionPtr->IsWriteReady()) {
@@ -188,6 +209,7 @@ private:
                             ! mConnectionPtr->HasPendingRead();
                         break;
                     }
+                }
                     // Fall through
                 case EVENT_INACTIVITY_TIMEOUT:
                     mConnectionPtr->Close();
@@ -570,6 +592,348 @@ private:
             const Initiator& inInitiator);
     };
 
+    // Sends message over ssl, shuts down ssl, then sends message in clear text
+    // over the same connection, and checks that the responder echoes both.
+    class ShutdownTest : public KfsCallbackObj
+    {
+    public:
+        ShutdownTest(
+            SslFilter::Ctx&       inCtx,
+            const string&         inPsk,
+            const string&         inIdentity,
+            const ServerLocation& inServerLocation,
+            NetManager&           inNetManager,
+            int&                  outStatus)
+            : KfsCallbackObj(),
+              mConnectionPtr(),
+              mSslFilter(
+                inCtx,
+                inPsk.data(),
+                inPsk.size(),
+                inIdentity.c_str(),
+                0,    // inServerPskPtr
+                0,    // inVerifyPeerPtr
+                false // inDeleteOnCloseFlag
+              ),
+              mServerLocation(inServerLocation),
+              mNetManager(inNetManager),
+              mStatus(outStatus),
+              mState(kStateSsl),
+              mExpected()
+        {
+            SET_HANDLER(this, &ShutdownTest::EventHandler);
+            mStatus = 1;
+        }
+        ~ShutdownTest()
+        {
+            if (mConnectionPtr) {
+                mConnectionPtr->Close();
+            }
+        }
+        bool Start(
+            string* inErrMsgPtr)
+        {
+            TcpSocket& theSocket = *(new TcpSocket());
+            const bool kNonBlockingFlag = true;
+            const int  theErr           = theSocket.Connect(
+                mServerLocation, kNonBlockingFlag);
+            if (theErr && theErr != -EINPROGRESS) {
+                if (inErrMsgPtr) {
+                    *inErrMsgPtr = QCUtils::SysError(-theErr);
+                }
+                delete &theSocket;
+                return false;
+            }
+            mConnectionPtr.reset(new NetConnection(&theSocket, this));
+            mConnectionPtr->SetDoingNonblockingConnect();
+            const int kIoTimeout = 60;
+            mConnectionPtr->SetInactivityTimeout(kIoTimeout);
+            mConnectionPtr->SetMaxReadAhead(kMaxReadAhead);
+            // The connection continues in clear text after ssl shutdown.
+            mSslFilter.DisableKtls();
+            const int theStatus = mConnectionPtr->SetFilter(
+                &mSslFilter, inErrMsgPtr);
+            if (theStatus) {
+                return false;
+            }
+            mNetManager.AddConnection(mConnectionPtr);
+            Send("message sent over ssl\n");
+            return true;
+        }
+        int EventHandler(
+            int   inEventCode,
+            void* inEventDataPtr)
+        {
+            switch (inEventCode) {
+	        case EVENT_NET_READ: {
+                    IOBuffer& theIoBuf = mConnectionPtr->GetInBuffer();
+                    QCASSERT(&theIoBuf == inEventDataPtr);
+                    if (theIoBuf.BytesConsumable() < (int)mExpected.size()) {
+                        break;
+                    }
+                    string theReceived;
+                    theReceived.resize(theIoBuf.BytesConsumable());
+                    theIoBuf.CopyOut(&theReceived[0], theReceived.size());
+                    theIoBuf.Clear();
+                    if (theReceived != mExpected) {
+                        Done("echo mismatch: " + theReceived);
+                        break;
+                    }
+                    if (mState == kStateSsl) {
+                        mState = kStateShutdown;
+                        const int theErr = mConnectionPtr->Shutdown();
+                        if (theErr) {
+                            Done("ssl shutdown: " +
+                                QCUtils::SysError(theErr < 0 ? -theErr : theErr));
+                        }
+                    } else if (mState == kStateClearText) {
+                        mStatus = 0;
+                        Done("passed");
+                    } else {
+                        Done("unexpected read");
+                    }
+                    break;
+                }
+	        case EVENT_NET_WROTE:
+                    break;
+
+	        case EVENT_NET_ERROR:
+                    if (mState == kStateShutdown &&
+                            mConnectionPtr->IsGood() &&
+                            ! mConnectionPtr->GetFilter()) {
+                        // Ssl shutdown complete.
+                        mState = kStateClearText;
+                        Send("message sent in clear text\n");
+                        break;
+                    }
+                    Done("network error: " + mConnectionPtr->GetErrorMsg());
+                    break;
+
+                case EVENT_INACTIVITY_TIMEOUT:
+                    Done("timed out");
+                    break;
+
+	        default:
+                    QCASSERT(!"Unexpected event code");
+                    break;
+            }
+            return 0;
+        }
+    private:
+        enum State
+        {
+            kStateSsl,
+            kStateShutdown,
+            kStateClearText,
+            kStateDone
+        };
+        enum { kMaxReadAhead = 4 << 10 };
+
+        NetConnectionPtr     mConnectionPtr;
+        SslFilter            mSslFilter;
+        ServerLocation const mServerLocation;
+        NetManager&          mNetManager;
+        int&                 mStatus;
+        State                mState;
+        string               mExpected;
+
+        void Send(
+            const char* inMsgPtr)
+        {
+            mExpected = inMsgPtr;
+            mConnectionPtr->GetOutBuffer().CopyIn(
+                mExpected.data(), (int)mExpected.size());
+            mConnectionPtr->StartFlush();
+        }
+        void Done(
+            const string& inMsg)
+        {
+            KFS_LOG_STREAM(mStatus == 0 ?
+                    MsgLogger::kLogLevelINFO :
+                    MsgLogger::kLogLevelERROR) <<
+                "shutdown test: " << inMsg <<
+            KFS_LOG_EOM;
+            mState = kStateDone;
+            mConnectionPtr->Close();
+            mNetManager.Shutdown();
+        }
+    private:
+        ShutdownTest(
+            const ShutdownTest& inTest);
+        ShutdownTest& operator=(
+            const ShutdownTest& inTest);
+    };
+
+    // Sends message over ssl, closes the connection, then re-connects and
+    // sends message again. Checks that the second connection resumes the
+    // session, and that the server re-validates the psk identity stored in
+    // the resumed session.
+    class ResumeTest : public KfsCallbackObj
+    {
+    public:
+        ResumeTest(
+            SslFilterTest&        inTest,
+            SslFilter::Ctx&       inCtx,
+            const string&         inPsk,
+            const string&         inIdentity,
+            const ServerLocation& inServerLocation,
+            NetManager&           inNetManager,
+            int&                  outStatus)
+            : KfsCallbackObj(),
+              mTest(inTest),
+              mCtx(inCtx),
+              mPsk(inPsk),
+              mIdentity(inIdentity),
+              mConnectionPtr(),
+              mServerLocation(inServerLocation),
+              mNetManager(inNetManager),
+              mStatus(outStatus),
+              mConnectCount(0),
+              mFilterPtr(0),
+              mExpected("message sent over ssl\n")
+        {
+            SET_HANDLER(this, &ResumeTest::EventHandler);
+            mStatus = 1;
+        }
+        ~ResumeTest()
+        {
+            if (mConnectionPtr) {
+                mConnectionPtr->Close();
+            }
+        }
+        bool Start(
+            string* inErrMsgPtr)
+        {
+            TcpSocket& theSocket = *(new TcpSocket());
+            const bool kNonBlockingFlag = true;
+            const int  theErr           = theSocket.Connect(
+                mServerLocation, kNonBlockingFlag);
+            if (theErr && theErr != -EINPROGRESS) {
+                if (inErrMsgPtr) {
+                    *inErrMsgPtr = QCUtils::SysError(-theErr);
+                }
+                delete &theSocket;
+                return false;
+            }
+            mConnectCount++;
+            mConnectionPtr.reset(new NetConnection(&theSocket, this));
+            mConnectionPtr->SetDoingNonblockingConnect();
+            const int kIoTimeout = 60;
+            mConnectionPtr->SetInactivityTimeout(kIoTimeout);
+            mConnectionPtr->SetMaxReadAhead(kMaxReadAhead);
+            SslFilter& theFilter = SslFilter::Create(
+                mCtx,
+                mPsk.data(),
+                mPsk.size(),
+                mIdentity.c_str()
+            );
+            theFilter.SetSessionResumeKey(mServerLocation.ToString());
+            const int theStatus = mConnectionPtr->SetFilter(
+                &theFilter, inErrMsgPtr);
+            if (theStatus) {
+                delete &theFilter;
+                return false;
+            }
+            mFilterPtr = &theFilter;
+            mNetManager.AddConnection(mConnectionPtr);
+            mConnectionPtr->GetOutBuffer().CopyIn(
+                mExpected.data(), (int)mExpected.size());
+            mConnectionPtr->StartFlush();
+            return true;
+        }
+        int EventHandler(
+            int   inEventCode,
+            void* inEventDataPtr)
+        {
+            switch (inEventCode) {
+	        case EVENT_NET_READ: {
+                    IOBuffer& theIoBuf = mConnectionPtr->GetInBuffer();
+                    QCASSERT(&theIoBuf == inEventDataPtr);
+                    if (theIoBuf.BytesConsumable() < (int)mExpected.size()) {
+                        break;
+                    }
+                    string theReceived;
+                    theReceived.resize(theIoBuf.BytesConsumable());
+                    theIoBuf.CopyOut(&theReceived[0], theReceived.size());
+                    theIoBuf.Clear();
+                    if (theReceived != mExpected) {
+                        Done("echo mismatch: " + theReceived);
+                        break;
+                    }
+                    if (mConnectCount < 2) {
+                        mConnectionPtr->Close();
+                        string theErrMsg;
+                        if (! Start(&theErrMsg)) {
+                            Done("re-connect: " + theErrMsg);
+                        }
+                        break;
+                    }
+                    // The server must look up the psk of the resumed session
+                    // identity, therefore both connections invoke GetPsk().
+                    if (! mFilterPtr->IsSessionReused() ||
+                            mTest.mGetPskCount != 2) {
+                        ostringstream theStream;
+                        theStream << "session was not resumed:"
+                            " reused: "    << mFilterPtr->IsSessionReused() <<
+                            " psk lookups: " << mTest.mGetPskCount;
+                        Done(theStream.str());
+                        break;
+                    }
+                    mStatus = 0;
+                    Done("passed");
+                    break;
+                }
+	        case EVENT_NET_WROTE:
+                    break;
+
+	        case EVENT_NET_ERROR:
+                    Done("network error: " + mConnectionPtr->GetErrorMsg());
+                    break;
+
+                case EVENT_INACTIVITY_TIMEOUT:
+                    Done("timed out");
+                    break;
+
+	        default:
+                    QCASSERT(!"Unexpected event code");
+                    break;
+            }
+            return 0;
+        }
+    private:
+        enum { kMaxReadAhead = 4 << 10 };
+
+        SslFilterTest&       mTest;
+        SslFilter::Ctx&      mCtx;
+        string const         mPsk;
+        string const         mIdentity;
+        NetConnectionPtr     mConnectionPtr;
+        ServerLocation const mServerLocation;
+        NetManager&          mNetManager;
+        int&                 mStatus;
+        int                  mConnectCount;
+        SslFilter*           mFilterPtr;
+        string const         mExpected;
+
+        void Done(
+            const string& inMsg)
+        {
+            KFS_LOG_STREAM(mStatus == 0 ?
+                    MsgLogger::kLogLevelINFO :
+                    MsgLogger::kLogLevelERROR) <<
+                "resume test: " << inMsg <<
+            KFS_LOG_EOM;
+            mConnectionPtr->Close();
+            mNetManager.Shutdown();
+        }
+    private:
+        ResumeTest(
+            const ResumeTest& inTest);
+        ResumeTest& operator=(
+            const ResumeTest& inTest);
+    };
+    friend class ResumeTest;
+
     SslFilterTest()
         : IAcceptorOwner(),
           SslFilterServerPsk(),
@@ -581,7 +945,8 @@ private:
           mPskKey("test"),
           mMaxReadAhead((8 << 10) - 1),
           mMaxWriteBehind((8 << 10) - 1),
-          mUseFilterFlag(true)
+          mUseFilterFlag(true),
+          mGetPskCount(0)
         {}
     virtual ~SslFilterTest()
     {
@@ -646,6 +1011,17 @@ private:
             "sslFilterTest.maxWriteBehind", mMaxWriteBehind);
         mUseFilterFlag = mProperties.getValue(
             "sslFilterTest.useFilter", mUseFilterFlag ? 0 : 1) != 0;
+        const string theTestName = mProperties.getValue(
+            "sslFilterTest.test", string());
+        if (! theTestName.empty() && theTestName != "shutdown" &&
+                theTestName != "resume") {
+            cerr << "invalid test name: " << theTestName << "\n";
+            return 1;
+        }
+        mUseFilterFlag = mUseFilterFlag || ! theTestName.empty();
+        if (theTestName == "resume") {
+            mProperties.setValue("sslFilterTest.session.resume", "1");
+        }
         int theRet = 0;
         if (0 <= theAcceptPort) {
             const bool kServerFlag  = true;
@@ -672,7 +1048,10 @@ private:
                 }
             }
         }
-        SslFilter::Ctx* theSslCtxPtr = 0;
+        SslFilter::Ctx* theSslCtxPtr       = 0;
+        ShutdownTest*   theShutdownTestPtr = 0;
+        ResumeTest*     theResumeTestPtr   = 0;
+        int             theTestStatus      = 0;
         if (theRet == 0) {
             const ServerLocation theServerLocation(
                 mProperties.getValue("sslFilterTest.connect.host",
@@ -695,6 +1074,39 @@ private:
                         theErrMsg <<
                     KFS_LOG_EOM;
                     theRet = 1;
+                } else if (theTestName == "shutdown") {
+                    theShutdownTestPtr = new ShutdownTest(
+                        *theSslCtxPtr,
+                        mPskKey,
+                        mPskIdentity,
+                        theServerLocation,
+                        mNetManager,
+                        theTestStatus
+                    );
+                    if (! theShutdownTestPtr->Start(&theErrMsg)) {
+                        KFS_LOG_STREAM_ERROR <<
+                            "shutdown test start error: " <<
+                            theErrMsg <<
+                        KFS_LOG_EOM;
+                        theRet = 1;
+                    }
+                } else if (theTestName == "resume") {
+                    theResumeTestPtr = new ResumeTest(
+                        *this,
+                        *theSslCtxPtr,
+                        mPskKey,
+                        mPskIdentity,
+                        theServerLocation,
+                        mNetManager,
+                        theTestStatus
+                    );
+                    if (! theResumeTestPtr->Start(&theErrMsg)) {
+                        KFS_LOG_STREAM_ERROR <<
+                            "resume test start error: " <<
+                            theErrMsg <<
+                        KFS_LOG_EOM;
+                        theRet = 1;
+                    }
                 } else {
                     Initiator* const theClientPtr = new Initiator(
                         fileno(stdin),  //inInputFd,
@@ -724,10 +1136,15 @@ private:
             sInstancePtr = this;
             mNetManager.MainLoop();
             sInstancePtr = 0;
+            if (theShutdownTestPtr || theResumeTestPtr) {
+                theRet = theTestStatus;
+            }
         }
+        delete theShutdownTestPtr;
+        delete theResumeTestPtr;
         SslFilter::FreeCtx(theSslCtxPtr);
         MsgLogger::Stop();
-        return 0;
+        return theRet;
     }
     void ShutdownSelf()
         { mNetManager.Shutdown(); }
@@ -738,6 +1155,9 @@ private:
             "Usage " << (inNamePtr ? inNamePtr : "") << ":\n"
             " -c <config file name>\n"
             " -D config-key=config-value\n"
+            " -D sslFilterTest.test=shutdown -- run ssl shutdown followed by"
+            " clear text write test\n"
+            " -D sslFilterTest.test=resume -- run session resume test\n"
         ;
     }
     virtual KfsCallbackObj* CreateKfsCallbackObj(
@@ -771,6 +1191,7 @@ private:
         }
         memcpy(inPskBufferPtr, mPskKey.data(), mPskKey.size());
         outAuthName = "test";
+        mGetPskCount++;
         return mPskKey.size();
     }
 
@@ -41,9 +41,13 @@ Acceptor::Acceptor(
     const ServerLocation& location,
     bool                  ipV6OnlyFlag,
     IAcceptorOwner*       owner,
-    bool                  bindOnlyFlag)
+    bool                  bindOnlyFlag,
+    bool                  reusePortFlag /* = false */,
+    int                   incomingCpu   /* = -1 */)
     : mLocation(location),
       mIpV6OnlyFlag(ipV6OnlyFlag),
+      mReusePortFlag(reusePortFlag),
+      mIncomingCpu(incomingCpu),
       mAcceptorOwner(owner),
       mConn(),
       mNetManager(netManager)
@@ -62,6 +66,8 @@ Acceptor::Acceptor(
     bool            bindOnlyFlag /* = false */)
     : mLocation(string(), port),
       mIpV6OnlyFlag(false),
+      mReusePortFlag(false),
+      mIncomingCpu(-1),
       mAcceptorOwner(owner),
       mConn(),
       mNetManager(netManager)
@@ -96,7 +102,8 @@ Acceptor::Bind()
         mLocation,
         (mLocation.hostname.empty() && mIpV6OnlyFlag) ?
             TcpSocket::kTypeIpV6 : TcpSocket::kTypeIpV4,
-        mIpV6OnlyFlag
+        mIpV6OnlyFlag,
+        mReusePortFlag
     );
     if (res < 0) {
         KFS_LOG_STREAM_ERROR <<
@@ -117,6 +124,10 @@ Acceptor::Bind()
             mLocation.port = loc.port;
         }
     }
+    if (0 <= mIncomingCpu) {
+        // Affinity hint only, ignore errors.
+        sock->SetIncomingCpu(mIncomingCpu);
+    }
     const bool kListenOnlyFlag = true;
     mConn.reset(new NetConnection(sock, this, kListenOnlyFlag));
 }
@@ -87,12 +87,19 @@ public:
         int             port,
         IAcceptorOwner* owner,
         bool            bindOnlyFlag = false);
+    /// @param reusePortFlag bind with SO_REUSEPORT, in order to allow
+    /// multiple acceptors, each with its own net manager, on the same port.
+    /// @param incomingCpu if non negative, the cpu to set with
+    /// SO_INCOMING_CPU, to have the kernel prefer this acceptor for
+    /// connections received by the cpu.
     Acceptor(
         NetManager&           netManager,
         const ServerLocation& location,
         bool                  ipV6OnlyFlag,
         IAcceptorOwner*       owner,
-        bool                  bindOnlyFlag);
+        bool                  bindOnlyFlag,
+        bool                  reusePortFlag = false,
+        int                   incomingCpu   = -1);
     ~Acceptor();
     void StartListening();
 
@@ -119,6 +126,8 @@ private:
     ///
     ServerLocation        mLocation;
     bool                  mIpV6OnlyFlag;
+    bool                  mReusePortFlag;
+    int                   mIncomingCpu;
     IAcceptorOwner* const mAcceptorOwner;
     NetConnectionPtr      mConn;
     NetManager&           mNetManager;
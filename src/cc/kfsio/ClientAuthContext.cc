@@ -450,7 +450,9 @@ public:
         const char*    inKeyIdPtr,
         const char*    inKeyDataPtr,
         int            inKeyDataSize,
-        string*        outErrMsgPtr)
+        string*        outErrMsgPtr,
+        const char*    inPeerNamePtr     = 0,
+        bool           inShutdownSslFlag = false)
     {
         if (! mSslCtxPtr) {
             if (outErrMsgPtr) {
@@ -502,6 +504,19 @@ public:
             delete &theFilter;
             return -EFAULT;
         }
+        if (inPeerNamePtr && *inPeerNamePtr) {
+            // Resume the session only with the same peer and key.
+            string theKey(inPeerNamePtr);
+            theKey += '/';
+            if (inKeyIdPtr) {
+                theKey += inKeyIdPtr;
+            }
+            theFilter.SetSessionResumeKey(theKey);
+        }
+        if (inShutdownSslFlag) {
+            // The connection continues in clear text after ssl shutdown.
+            theFilter.DisableKtls();
+        }
         return inNetConnection.SetFilter(&theFilter, outErrMsgPtr);
     }
     bool IsChunkServerClearTextAllowed() const
@@ -820,10 +835,13 @@ ClientAuthContext::StartSsl(
     const char*    inKeyIdPtr,
     const char*    inKeyDataPtr,
     int            inKeyDataSize,
-    string*        outErrMsgPtr)
+    string*        outErrMsgPtr,
+    const char*    inPeerNamePtr,
+    bool           inShutdownSslFlag)
 {
     return mImpl.StartSsl(
-        inNetConnection, inKeyIdPtr, inKeyDataPtr, inKeyDataSize, outErrMsgPtr);
+        inNetConnection, inKeyIdPtr, inKeyDataPtr, inKeyDataSize, outErrMsgPtr,
+        inPeerNamePtr, inShutdownSslFlag);
 }
 
     bool
@@ -100,7 +100,9 @@ public:
         const char*    inKeyIdPtr,
         const char*    inKeyDataPtr,
         int            inKeyDataSize,
-        string*        outErrMsgPtr);
+        string*        outErrMsgPtr,
+        const char*    inPeerNamePtr     = 0,
+        bool           inShutdownSslFlag = false);
     int GetMaxAuthRetryCount() const;
     bool IsChunkServerClearTextAllowed() const;
     string GetPskId() const;
@@ -31,9 +31,6 @@
 #include "IOBuffer.h"
 #include "Globals.h"
 
-#include "qcdio/QCMutex.h"
-#include "qcdio/qcstutils.h"
-
 #include <sys/types.h>
 #include <sys/uio.h>
 #include <limits.h>
@@ -44,16 +41,18 @@
 #include <cerrno>
 #include <iostream>
 #include <algorithm>
-#include <vector>
+#include <new>
+
+#if defined(__SSE2__) && defined(__GNUC__)
+#   include <emmintrin.h>
+#   define KFS_IOBUFFER_USE_SSE2
+#endif
 
 namespace KFS
 {
 
 using std::min;
 using std::max;
-using std::list;
-using std::vector;
-using std::find;
 
 using namespace KFS::libkfsio;
 
@@ -64,124 +63,68 @@ static libkfsio::IOBufferAllocator* sIOBufferAllocator = 0;
 static volatile bool sIsIOBufferAllocatorUsed = false;
 int IOBufferData::sDefaultBufferSize = 4 << 10;
 
-class IOBufferDetacher
-{
-public:
-    static char* Detach(IOBufferData::IOBufferBlockPtr& data)
-    {
-        if (! data.unique()) {
-            return 0;
-        }
-        char* const dbuf = data.get();
-        if (! dbuf) {
-            return dbuf;
-        }
-        const void* buf = dbuf;
-        sInstance.DetachSelf(buf);
-        data.reset();
-        if (buf) {
-            // Deleter must be different, than one of supported deleters. There
-            // is no way to recover from this failure, as is isn't possible to
-            // determine deleter type when arbitrary deleter is used. Non
-            // default deleter must implement required detach logic, if needed.
-            //
-            // The alternative is to check whether or not one of the supported
-            // deleters is used prior to data.reset() invocation, and possibly
-            // maintain deleter instance "do not delte" flag, insteadof using
-            // global do not delete list, at the price of deleter instance size
-            // increase.
-            // The alternative approach doesn't seem to be warranted given the
-            // overhead, and rather rare / uncommon use of this functionality..
-            abort();
-        }
-        return dbuf;
-    };
-    static bool Detached(const void* buf)
-        { return sInstance.DetachedSelf(buf); }
-private:
-    IOBufferDetacher()
-        : mMutex(),
-          mList(),
-          mHasEntriesFlag(false)
-        { mList.reserve(128); }
-    void DetachSelf(const void*& buf)
-    {
-        QCStMutexLocker lock(mMutex);
-        // Do not assign, uless the value changes, as store might not be atomic.
-        if (! mHasEntriesFlag) {
-            mHasEntriesFlag = true;
-        }
-        mList.push_back(&buf);
-    }
-    bool DetachedSelf(const void* buf)
-    {
-        // Flag fetch should not present a problem as Detach and Detached must
-        // be invoked from the same thread with the same buffer.
-        if (mHasEntriesFlag) {
-            QCStMutexLocker lock(mMutex);
-            List::iterator it;
-            for (it = mList.begin(); it != mList.end() && **it != buf; ++it)
-                {}
-            if (it != mList.end()) {
-                **it = 0;
-                mList.erase(it);
-                if (mList.empty()) {
-                    mHasEntriesFlag = false;
-                }
-                return true;
-            }
-        }
-        return false;
-    }
-private:
-    typedef vector<const void**> List;
+inline
+IOBufferData::Block::Block(char* buf, IOBufferData::Block::Type type,
+    libkfsio::IOBufferAllocator* allocator)
+    : mBuf(buf),
+      mAllocator(allocator),
+      mData(),
+      mRefCount(1),
+      mType(type)
+{}
 
-    QCMutex       mMutex;
-    List          mList;
-    volatile bool mHasEntriesFlag;
+inline
+IOBufferData::Block::~Block()
+{}
 
-    static IOBufferDetacher sInstance;
-};
-IOBufferDetacher IOBufferDetacher::sInstance;
+// Allocate buffer headers from the pool, instead of allocating one with new
+// for every buffer.
+IOBufferData::Block*
+IOBufferData::Block::Create(char* buf, IOBufferData::Block::Type type,
+    libkfsio::IOBufferAllocator* allocator)
+{
+    return new (StdFastAllocator<Block>().allocate(1))
+        Block(buf, type, allocator);
+}
 
-struct IOBufferArrayDeallocator
+IOBufferData::Block*
+IOBufferData::Block::Create(const IOBufferData::IOBufferBlockPtr& data)
 {
-    void operator()(char* buf)
-    {
-        if (IOBufferDetacher::Detached(buf)) {
-            return;
-        }
-        delete [] buf;
-    }
-};
+    Block* const block = Create(data.get(), kTypeBlockPtr, 0);
+    block->mData = data;
+    return block;
+}
 
-struct IOBufferDeallocator
+void
+IOBufferData::Block::Destroy()
 {
-    void operator()(char* buf)
-    {
-        if (IOBufferDetacher::Detached(buf)) {
-            return;
+    if (mBuf) {
+        switch (mType) {
+            case kTypeArray:
+                delete [] mBuf;
+                break;
+            case kTypeAllocator:
+                mAllocator->Deallocate(mBuf);
+                break;
+            default:
+                break;
         }
-        sIOBufferAllocator->Deallocate(buf);
     }
-};
+    this->~Block();
+    StdFastAllocator<Block>().deallocate(this, 1);
+}
 
-struct IOBufferDeallocatorCustom
+char*
+IOBufferData::Block::Detach()
 {
-    IOBufferDeallocatorCustom(
-        libkfsio::IOBufferAllocator& allocator)
-        : mAllocator(allocator)
-        {}
-    void operator()(char* buf)
-    {
-        if (IOBufferDetacher::Detached(buf)) {
-            return;
-        }
-        mAllocator.Deallocate(buf);
+    if (mType == kTypeBlockPtr || ! IsUnique()) {
+        return 0;
     }
-private:
-    libkfsio::IOBufferAllocator& mAllocator;
-};
+    char* const buf = mBuf;
+    mBuf = 0;
+    Destroy();
+    return buf;
+}
 
 // Call this function if you want to change the default allocator.
 bool
@@ -213,11 +156,11 @@ IOBufferData::Init(char* buf, int bufSize)
     // glibc malloc returns 2 * sizeof(size_t) aligned blocks.
     const int size = max(0, bufSize);
     if (size <= 0 && ! buf) {
-        mData.reset();
+        mProducer = 0;
     } else {
-        mData.reset(buf ? buf : new char [size], IOBufferArrayDeallocator());
+        mProducer = buf ? buf : new char [size];
+        mBlock    = Block::Create(mProducer, Block::kTypeArray, 0);
     }
-    mProducer = mData.get();
     mEnd      = mProducer + size;
     mConsumer = mProducer;
 }
@@ -230,15 +173,11 @@ IOBufferData::Init(char* buf, libkfsio::IOBufferAllocator& allocator)
             sDefaultBufferSize = sIOBufferAllocator->GetBufferSize();
         }
         sIsIOBufferAllocatorUsed = true;
-        mData.reset(buf ? buf : allocator.Allocate(),
-            IOBufferDeallocator());
-    } else {
-        mData.reset(buf ? buf : allocator.Allocate(),
-            IOBufferDeallocatorCustom(allocator));
     }
-    if (! (mProducer = mData.get())) {
+    if (! (mProducer = buf ? buf : allocator.Allocate())) {
         abort();
     }
+    mBlock    = Block::Create(mProducer, Block::kTypeAllocator, &allocator);
     mEnd      = mProducer + allocator.GetBufferSize();
     mConsumer = mProducer;
 }
@@ -246,21 +185,43 @@ IOBufferData::Init(char* buf, libkfsio::IOBufferAllocator& allocator)
 // setup a new IOBufferData for access by block sharing.
 IOBufferData::IOBufferData(const IOBufferData& other,
     char* c, char* e, char* p /* = 0 */)
-    : mData(other.mData),
+    : mBlock(other.mBlock),
       mEnd(e),
       mProducer(p ? p : e),
       mConsumer(c)
 {
-    if (! (mData.get() <= mConsumer &&
+    if (! (mBlock && mBlock->Get() <= mConsumer &&
                 mConsumer <= mProducer &&
                 mProducer <= mEnd &&
                 mEnd <= other.mEnd)) {
         abort();
     }
+    mBlock->Ref();
+}
+
+IOBufferData::IOBufferData(const IOBufferData& other)
+    : mBlock(other.mBlock),
+      mEnd(other.mEnd),
+      mProducer(other.mProducer),
+      mConsumer(other.mConsumer)
+{
+    if (mBlock) {
+        mBlock->Ref();
+    }
+}
+
+IOBufferData&
+IOBufferData::operator=(const IOBufferData& other)
+{
+    if (this != &other) {
+        IOBufferData tmp(other);
+        Swap(tmp);
+    }
+    return *this;
 }
 
 IOBufferData::IOBufferData()
-    : mData(),
+    : mBlock(0),
       mEnd(0),
       mProducer(0),
       mConsumer(0)
@@ -273,7 +234,7 @@ IOBufferData::IOBufferData()
 }
 
 IOBufferData::IOBufferData(int bufsz)
-    : mData(),
+    : mBlock(0),
       mEnd(0),
       mProducer(0),
       mConsumer(0)
@@ -283,7 +244,7 @@ IOBufferData::IOBufferData(int bufsz)
 
 IOBufferData::IOBufferData(char* buf, int offset, int size,
     libkfsio::IOBufferAllocator& allocator)
-    : mData(),
+    : mBlock(0),
       mEnd(0),
       mProducer(0),
       mConsumer(0)
@@ -294,7 +255,7 @@ IOBufferData::IOBufferData(char* buf, int offset, int size,
 }
 
 IOBufferData::IOBufferData(char* buf, int bufSize, int offset, int size)
-    : mData(),
+    : mBlock(0),
       mEnd(0),
       mProducer(0),
       mConsumer(0)
@@ -306,12 +267,12 @@ IOBufferData::IOBufferData(char* buf, int bufSize, int offset, int size)
 
 IOBufferData::IOBufferData(const IOBufferBlockPtr& data,
     int bufSize, int offset, int size)
-    : mData(data),
+    : mBlock(data ? Block::Create(data) : 0),
       mEnd(0),
       mProducer(0),
       mConsumer(0)
 {
-    char* const buf = mData.get();
+    char* const buf = data.get();
     mEnd      = buf + bufSize;
     mProducer = buf;
     mConsumer = buf;
@@ -321,6 +282,9 @@ IOBufferData::IOBufferData(const IOBufferBlockPtr& data,
 
 IOBufferData::~IOBufferData()
 {
+    if (mBlock) {
+        mBlock->Unref();
+    }
 }
 
 int
@@ -433,11 +397,12 @@ IOBufferData::CopyOut(char *buf, int numBytes) const
 char*
 IOBufferData::DetachBuffer(bool consumerAtBufferStartFlag)
 {
-    if (consumerAtBufferStartFlag && mData.get() != mConsumer) {
+    if (! mBlock || (consumerAtBufferStartFlag && mBlock->Get() != mConsumer)) {
         return 0;
     }
-    char* const buf = IOBufferDetacher::Detach(mData);
+    char* const buf = mBlock->Detach();
     if (buf) {
+        mBlock    = 0;
         mEnd      = 0;
         mConsumer = 0;
         mProducer = 0;
@@ -527,6 +492,263 @@ inline void IOBuffer::DebugVerify(bool updateChecksum)                 {}
 inline void IOBuffer::DebugVerify() const                              {}
 #endif
 
+inline void
+IOBuffer::BList::Construct(IOBufferData* ptr, IOBuffer::BList::Pos count)
+{
+    for (Pos i = 0; i < count; i++) {
+        new (ptr + i) IOBufferData(0);
+    }
+}
+
+inline void
+IOBuffer::BList::Destroy(IOBufferData* ptr, IOBuffer::BList::Pos count)
+{
+    for (Pos i = 0; i < count; i++) {
+        ptr[i].~IOBufferData();
+    }
+}
+
+IOBuffer::BList::BList()
+    : mPtr(InlinePtr()),
+      mHead(Pos(1) << 62),
+      mSize(0),
+      mMask(kInlineCount - 1)
+{
+    Construct(mPtr, kInlineCount);
+}
+
+IOBuffer::BList::~BList()
+{
+    FreeStorage();
+    Destroy(InlinePtr(), kInlineCount);
+}
+
+inline void
+IOBuffer::BList::FreeStorage()
+{
+    if (! IsInline()) {
+        Destroy(mPtr, mMask + 1);
+        ::operator delete(mPtr);
+        mPtr  = InlinePtr();
+        mMask = kInlineCount - 1;
+    }
+}
+
+// All slots are always constructed, the unused slots contain empty buffers,
+// therefore the fragments are moved into and out of the slots with Swap().
+void
+IOBuffer::BList::Reserve(IOBuffer::BList::Pos size)
+{
+    Pos capacity = mMask + 1;
+    if (size <= capacity) {
+        return;
+    }
+    while (capacity < size) {
+        capacity <<= 1;
+    }
+    IOBufferData* const ptr = static_cast<IOBufferData*>(
+        ::operator new((size_t)capacity * sizeof(IOBufferData)));
+    Construct(ptr, capacity);
+    const Pos mask = capacity - 1;
+    for (Pos i = mHead, e = mHead + mSize; i != e; ++i) {
+        ptr[(size_t)(i & mask)].Swap(At(i));
+    }
+    FreeStorage();
+    mPtr  = ptr;
+    mMask = mask;
+}
+
+void
+IOBuffer::BList::clear()
+{
+    for (Pos i = mHead, e = mHead + mSize; i != e; ++i) {
+        Reset(At(i));
+    }
+    mSize = 0;
+    FreeStorage();
+}
+
+void
+IOBuffer::BList::push_back(const IOBufferData& buf)
+{
+    IOBufferData d(buf);
+    Reserve(mSize + 1);
+    At(mHead + mSize).Swap(d);
+    mSize++;
+}
+
+void
+IOBuffer::BList::pop_front()
+{
+    assert(0 < mSize);
+    Reset(At(mHead));
+    mHead++;
+    mSize--;
+}
+
+void
+IOBuffer::BList::pop_back()
+{
+    assert(0 < mSize);
+    mSize--;
+    Reset(At(mHead + mSize));
+}
+
+// Insert count empty slots before pos. The preceding fragments are moved
+// towards the front, in order to keep pos and the following iterators valid.
+IOBuffer::BList::iterator
+IOBuffer::BList::Insert(IOBuffer::BList::const_iterator pos,
+    IOBuffer::BList::Pos count)
+{
+    assert(pos.mList == this);
+    Reserve(mSize + count);
+    if (pos.mPos == EndPos()) {
+        const Pos ret = mHead + mSize;
+        mSize += count;
+        return iterator(this, ret);
+    }
+    for (Pos i = mHead; i != pos.mPos; ++i) {
+        At(i - count).Swap(At(i));
+    }
+    mHead -= count;
+    mSize += count;
+    return iterator(this, pos.mPos - count);
+}
+
+IOBuffer::BList::iterator
+IOBuffer::BList::insert(IOBuffer::BList::const_iterator pos,
+    const IOBufferData& buf)
+{
+    IOBufferData d(buf);
+    const iterator it = Insert(pos, 1);
+    it->Swap(d);
+    return it;
+}
+
+IOBuffer::BList::iterator
+IOBuffer::BList::erase(IOBuffer::BList::const_iterator pos)
+{
+    assert(pos.mList == this && pos.mPos != EndPos());
+    Reset(At(pos.mPos));
+    if (pos.mPos + 1 == mHead + mSize) {
+        mSize--;
+        return end();
+    }
+    for (Pos i = pos.mPos; i != mHead; --i) {
+        At(i).Swap(At(i - 1));
+    }
+    mHead++;
+    mSize--;
+    return iterator(this, pos.mPos + 1);
+}
+
+IOBuffer::BList::iterator
+IOBuffer::BList::erase(IOBuffer::BList::const_iterator first,
+    IOBuffer::BList::const_iterator last)
+{
+    assert(first.mList == this && last.mList == this);
+    if (last.mPos == EndPos()) {
+        if (first.mPos != EndPos()) {
+            while (mHead + mSize != first.mPos) {
+                pop_back();
+            }
+        }
+        return end();
+    }
+    if (first.mPos == last.mPos) {
+        return iterator(this, last.mPos);
+    }
+    const Pos count = last.mPos - first.mPos;
+    for (Pos i = first.mPos; i != last.mPos; ++i) {
+        Reset(At(i));
+    }
+    for (Pos i = first.mPos; i != mHead; ) {
+        --i;
+        At(i + count).Swap(At(i));
+    }
+    mHead += count;
+    mSize -= count;
+    return iterator(this, last.mPos);
+}
+
+void
+IOBuffer::BList::splice(IOBuffer::BList::const_iterator pos,
+    IOBuffer::BList& other, IOBuffer::BList::const_iterator it)
+{
+    assert(&other != this && it.mList == &other);
+    Insert(pos, 1)->Swap(other.At(it.mPos));
+    other.erase(it);
+}
+
+void
+IOBuffer::BList::splice(IOBuffer::BList::const_iterator pos,
+    IOBuffer::BList& other,
+    IOBuffer::BList::const_iterator first,
+    IOBuffer::BList::const_iterator last)
+{
+    assert(&other != this && first.mList == &other && last.mList == &other);
+    Pos count = 0;
+    for (const_iterator it = first; it != last; ++it) {
+        count++;
+    }
+    if (count <= 0) {
+        return;
+    }
+    iterator dst = Insert(pos, count);
+    for (const_iterator it = first; it != last; ++it, ++dst) {
+        dst->Swap(other.At(it.mPos));
+    }
+    other.erase(first, last);
+}
+
+void
+IOBuffer::BList::splice(IOBuffer::BList::const_iterator pos,
+    IOBuffer::BList& other)
+{
+    if (mSize <= 0) {
+        Take(other);
+    } else {
+        splice(pos, other, other.begin(), other.end());
+    }
+}
+
+// Move all fragments from other into this empty list.
+void
+IOBuffer::BList::Take(IOBuffer::BList& other)
+{
+    assert(mSize <= 0 && &other != this);
+    if (other.IsInline()) {
+        for (Pos i = 0; i < other.mSize; i++) {
+            At(mHead + i).Swap(other.At(other.mHead + i));
+        }
+    } else {
+        FreeStorage();
+        mPtr        = other.mPtr;
+        mMask       = other.mMask;
+        mHead       = other.mHead;
+        other.mPtr  = other.InlinePtr();
+        other.mMask = kInlineCount - 1;
+    }
+    mSize       = other.mSize;
+    other.mSize = 0;
+}
+
+void
+IOBuffer::BList::swap(IOBuffer::BList& other)
+{
+    if (IsInline() || other.IsInline()) {
+        BList tmp;
+        tmp.Take(*this);
+        Take(other);
+        other.Take(tmp);
+        return;
+    }
+    std::swap(mPtr,  other.mPtr);
+    std::swap(mHead, other.mHead);
+    std::swap(mSize, other.mSize);
+    std::swap(mMask, other.mMask);
+}
+
 IOBuffer::IOBuffer()
     : mBuf(), mByteCount(0)
 #ifdef DEBUG_IOBuffer
@@ -541,6 +763,37 @@ IOBuffer::~IOBuffer()
     DebugVerify();
 }
 
+// The following insert empty list entry, and then swap buffers into it, in
+// order to avoid copying IOBufferData with the corresponding reference count
+// updates. The shared buffer is created prior to the insertion, as other can
+// be moved by the insertion.
+inline IOBuffer::BList::iterator
+IOBuffer::InsertNew(IOBuffer::BList& buf, IOBuffer::BList::iterator pos)
+{
+    IOBufferData d;
+    const BList::iterator it = buf.insert(pos, IOBufferData(0));
+    it->Swap(d);
+    return it;
+}
+
+inline IOBuffer::BList::iterator
+IOBuffer::InsertShared(IOBuffer::BList& buf, IOBuffer::BList::iterator pos,
+    const IOBufferData& other, char* c, char* e, char* p /* = 0 */)
+{
+    IOBufferData d(other, c, e, p);
+    const BList::iterator it = buf.insert(pos, IOBufferData(0));
+    it->Swap(d);
+    return it;
+}
+
+inline void
+IOBuffer::Assign(IOBufferData& dst,
+    const IOBufferData& other, char* c, char* e, char* p /* = 0 */)
+{
+    IOBufferData d(other, c, e, p);
+    dst.Swap(d);
+}
+
 void
 IOBuffer::Append(const IOBufferData &buf)
 {
@@ -619,21 +872,22 @@ IOBuffer::MoveSpaceAvailable(IOBuffer *other, int numBytes)
                 mBuf.splice(mBuf.end(), buf, it++);
             } else {
                 char* const p = d.Producer();
-                mBuf.push_back(IOBufferData(d, p, p + n, p));
-                d = IOBufferData(d, d.Consumer(), p);
+                InsertShared(mBuf, mBuf.end(), d, p, p + n, p);
+                Assign(d, d, d.Consumer(), p);
                 ++it;
             }
             nBytes -= n;
         } else {
             ++it;
             char* const p = d.Producer();
-            mBuf.push_back(IOBufferData(d, p, p + nBytes, p));
-            const IOBufferData nd(d, p + nBytes, p + n, p + nBytes);
+            InsertShared(mBuf, mBuf.end(), d, p, p + nBytes, p);
             if (d.IsEmpty()) {
-                d = nd;
+                Assign(d, d, p + nBytes, p + n, p + nBytes);
             } else {
-                d = IOBufferData(d, d.Consumer(), p);
-                buf.insert(it, nd);
+                // Insertion moves d, split it first.
+                IOBufferData r(d, p + nBytes, p + n, p + nBytes);
+                Assign(d, d, d.Consumer(), p);
+                buf.insert(it, IOBufferData(0))->Swap(r);
             }
             nBytes = 0;
         }
@@ -654,10 +908,10 @@ IOBuffer::EnsureSpaceAvailable(int numBytes)
         assert(nb > 0);
         if (nBytes + nb > numBytes) {
             char* const p = buf.Producer();
-            mBuf.push_back(IOBufferData(buf, p, p + numBytes - nBytes, p));
+            InsertShared(mBuf, mBuf.end(), buf, p, p + numBytes - nBytes, p);
             nBytes = numBytes;
         } else {
-            mBuf.push_back(buf);
+            mBuf.insert(mBuf.end(), IOBufferData(0))->Swap(buf);
             nBytes += nb;
         }
     }
@@ -716,7 +970,7 @@ IOBuffer::UseSpaceAvailable(const IOBuffer* other, int numBytes)
                 nb -= n;
                 nBytes -= n;
             }
-            mBuf.insert(it, d);
+            mBuf.insert(it, IOBufferData(0))->Swap(d);
             nBytes -= nb;
         }
         ++oit;
@@ -779,8 +1033,8 @@ IOBuffer::Move(IOBuffer* other, int numBytes)
             // this is the last buffer being moved; only partial data
             // from the buffer needs to be moved.  do the move by
             // sharing the block (and therby avoid data copy)
-            mBuf.push_back(IOBufferData(
-                s, s.Consumer(), s.Consumer() + nBytes));
+            InsertShared(mBuf, mBuf.end(),
+                s, s.Consumer(), s.Consumer() + nBytes);
             nBytes -= s.Consume(nBytes);
             assert(nBytes == 0);
         }
@@ -844,8 +1098,9 @@ IOBuffer::MoveSpace(IOBuffer* other, int numBytes)
             // from the buffer needs to be moved.  do the move by
             // sharing the block (and therby avoid data copy)
             char* const c = s.Consumer();
-            mBuf.push_back(IOBufferData(s, c, c + nBytes, c + min(nBytes, nb)));
-            s = IOBufferData(s, c + nBytes, c + st, c + max(nBytes, nb));
+            InsertShared(mBuf, mBuf.end(),
+                s, c, c + nBytes, c + min(nBytes, nb));
+            Assign(s, s, c + nBytes, c + st, c + max(nBytes, nb));
             const int n = mBuf.back().BytesConsumable();
             other->mByteCount -= n;
             mByteCount += n;
@@ -884,16 +1139,15 @@ IOBuffer::SplitBufferListAt(IOBuffer::BList& buf, int& nBytes)
 {
     IOBuffer::BList::iterator iter = buf.begin();
     while (nBytes > 0 && iter != buf.end()) {
-        IOBufferData& data = *iter;
-        const int nb = data.BytesConsumable();
+        const int nb = iter->BytesConsumable();
         if (nb <= 0) {
             iter = buf.erase(iter);
             continue;
         }
         if (nb > nBytes) {
-            buf.insert(iter, IOBufferData(
-                data, data.Consumer(), data.Consumer() + nBytes));
-            nBytes -= data.Consume(nBytes);
+            char* const c = iter->Consumer();
+            InsertShared(buf, iter, *iter, c, c + nBytes);
+            nBytes -= iter->Consume(nBytes);
             assert(nBytes == 0);
         } else {
             nBytes -= nb;
@@ -978,8 +1232,7 @@ IOBuffer::ReplaceKeepBuffersFull(IOBuffer* srcBuf, int inOffset, int numBytes)
             nFill -= dst.back().ZeroFill(nFill);
         }
         while (nFill > 0) {
-            dst.push_back(IOBufferData());
-            IOBufferData& d = dst.back();
+            IOBufferData& d = *InsertNew(dst, dst.end());
             nFill -= d.ZeroFill(nFill);
         }
         assert(nFill == 0);
@@ -1069,10 +1322,19 @@ IOBuffer::ReplaceKeepBuffersFull(IOBuffer* srcBuf, int inOffset, int numBytes)
         // Un-share if needed.
         if (di->IsShared()) {
             BList::iterator in = di;
-            IOBufferData fp(*in); // Make a shallow copy.
-            *in = IOBufferData(); // Replace with new buffer.
+            IOBufferData fp(0);
+            fp.Swap(*in); // Take the shared buffer.
+            IOBufferData nb;
+            in->Swap(nb); // Replace with new buffer.
+            int cnt = 0;
             while ((dl -= fp.Consume(in->CopyIn(fp.Consumer(), dl))) > 0) {
-                in = dst.insert(++in, IOBufferData());
+                in = InsertNew(dst, ++in);
+                cnt++;
+            }
+            // Insertion moves the preceding buffers, re-position to the first
+            // created buffer.
+            for (di = in; 0 < cnt; cnt--) {
+                --di;
             }
             // If more than one buffer was created, then postion to the one
             // at the requested offset.
@@ -1114,7 +1376,7 @@ IOBuffer::ReplaceKeepBuffersFull(IOBuffer* srcBuf, int inOffset, int numBytes)
             continue;
         }
         if (dst.empty() || dst.back().IsFull()) {
-            dst.push_back(IOBufferData());
+            InsertNew(dst, dst.end());
         }
         rem -= s.Consume(dst.back().CopyIn(&s, rem));
     }
@@ -1138,7 +1400,7 @@ IOBuffer::ZeroFill(int numBytes)
     int nBytes = numBytes;
     for (; ;) {
         if (it == mBuf.end()) {
-            it = mBuf.insert(it, IOBufferData());
+            it = InsertNew(mBuf, it);
         }
         if ((nBytes -= it->ZeroFill(nBytes)) <= 0) {
             break;
@@ -1173,7 +1435,7 @@ IOBuffer::Read(int fd, int maxReadAhead, IOBuffer::Reader* reader)
     if (maxReadAhead > 0 && maxReadAhead <= int(bufSize)) {
         const bool addBufFlag = it == mBuf.end();
         if (addBufFlag) {
-            it = mBuf.insert(mBuf.end(), IOBufferData());
+            it = InsertNew(mBuf, mBuf.end());
         }
         if (it->SpaceAvailable() >= size_t(maxReadAhead)) {
             const int nRd = reader ?
@@ -1289,7 +1551,7 @@ IOBuffer::Read(int fd, int maxReadAhead, IOBuffer::Reader* reader)
 }
 
 int
-IOBuffer::Write(int fd)
+IOBuffer::Write(int fd, int maxBytes /* = -1 */)
 {
     DebugVerify();
     const int    kMaxWritevBufs      = 32;
@@ -1297,20 +1559,26 @@ IOBuffer::Write(int fd)
     const int    kPreferredWriteSize = 64 << 10;
     struct iovec writeVec[kMaxWritevBufs];
     ssize_t      totWr = 0;
+    ssize_t      rem   = maxBytes < 0 ? (ssize_t)mByteCount : (ssize_t)maxBytes;
 
-    while (! mBuf.empty()) {
+    while (0 < rem && ! mBuf.empty()) {
         BList::iterator it;
         int             nVec;
         ssize_t         toWr;
+        bool            partialFlag = false;
         for (it = mBuf.begin(), nVec = 0, toWr = 0;
                 it != mBuf.end() && nVec < maxWriteBufs &&
-                    toWr < kPreferredWriteSize;
+                    toWr < kPreferredWriteSize && toWr < rem;
                 ) {
-            const int nBytes = it->BytesConsumable();
+            int nBytes = it->BytesConsumable();
             if (nBytes <= 0) {
                 it = mBuf.erase(it);
                 continue;
             }
+            if (rem - toWr < nBytes) {
+                nBytes      = (int)(rem - toWr);
+                partialFlag = true;
+            }
             writeVec[nVec].iov_base = it->Consumer();
             writeVec[nVec].iov_len  = (size_t)nBytes;
             toWr += nBytes;
@@ -1323,7 +1591,7 @@ IOBuffer::Write(int fd)
             break;
         }
         const ssize_t nWr = writev(fd, writeVec, nVec);
-        if (nWr == toWr && it == mBuf.end()) {
+        if (nWr == toWr && it == mBuf.end() && ! partialFlag) {
             mBuf.clear();
         } else {
             ssize_t nBytes = nWr;
@@ -1339,6 +1607,7 @@ IOBuffer::Write(int fd)
         }
         if (nWr > 0) {
             totWr += nWr;
+            rem   -= nWr;
             globals().ctrNetBytesWritten.Update(nWr);
         } else if (totWr <= 0 && (totWr = -(errno == 0 ? EAGAIN : errno)) > 0) {
             totWr = -totWr;
@@ -1482,7 +1751,7 @@ IOBuffer::CopyIn(const char* buf, int numBytes, IOBuffer::iterator pos)
     int nBytes = numBytes;
     for (; ;) {
         if (pos == mBuf.end()) {
-            pos = mBuf.insert(mBuf.end(), IOBufferData());
+            pos = InsertNew(mBuf, mBuf.end());
         }
         if ((nBytes -= const_cast<IOBufferData&>(*pos).CopyIn(
                 buf + numBytes - nBytes, nBytes)) <= 0) {
@@ -1526,14 +1795,14 @@ IOBuffer::CopyIn(const char *buf, int numBytes)
             (numBytes + defaultBufSz - 1) / defaultBufSz * defaultBufSz);
         mByteCount += bd.CopyIn(buf, numBytes);
         assert(mByteCount == numBytes);
-        mBuf.push_back(bd);
+        mBuf.insert(mBuf.end(), IOBufferData(0))->Swap(bd);
         DebugVerify(true);
         return mByteCount;
     }
     // Copy into available space at the end, if any.
     BList::iterator it = BeginSpaceAvailable();
     if (it == mBuf.end()) {
-        it = mBuf.insert(it, IOBufferData());
+        it = InsertNew(mBuf, it);
     }
     int nBytes = numBytes;
     const char* cur = buf;
@@ -1546,7 +1815,7 @@ IOBuffer::CopyIn(const char *buf, int numBytes)
         }
         assert(it->IsFull());
         if (++it == mBuf.end()) {
-            it = mBuf.insert(it, IOBufferData());
+            it = InsertNew(mBuf, it);
         }
     }
     nBytes = numBytes - nBytes;
@@ -1586,7 +1855,7 @@ IOBuffer::Copy(const IOBuffer* buf, int numBytes)
             continue;
         }
         char* const c = const_cast<char*>(it->Consumer());
-        mBuf.push_back(IOBufferData(*it, c, c + nb));
+        InsertShared(mBuf, mBuf.end(), *it, c, c + nb);
         rem -= nb;
     }
     rem = numBytes - rem;
@@ -1608,9 +1877,9 @@ IOBuffer::Clone() const
     BList::const_iterator  it;
     for (it = mBuf.begin(); it != mBuf.end(); ++it) {
         if (! it->IsEmpty()) {
-            clone->mBuf.push_back(IOBufferData(*it,
+            InsertShared(clone->mBuf, clone->mBuf.end(), *it,
                 const_cast<char*>(it->Consumer()),
-                const_cast<char*>(it->Producer())));
+                const_cast<char*>(it->Producer()));
         }
     }
     assert(mByteCount >= 0);
@@ -1645,7 +1914,7 @@ IOBuffer::MakeBuffersFull()
                 mBuf.splice(mBuf.end(), buf, buf.begin());
                 continue;
             }
-            mBuf.push_back(IOBufferData());
+            InsertNew(mBuf, mBuf.end());
         }
         s.Consume(mBuf.back().CopyIn(&s, nb));
     }
@@ -1683,6 +1952,45 @@ IOBuffer::TrimAtBufferBoundaryLeaveOnly(int& offset, int& numBytes)
     DebugVerify(true);
 }
 
+// Returns pointer to the first occurrence of the string of length len, that
+// fits into [ptr, end), or 0 if not found. With SSE2 16 possible start
+// positions are checked at a time by comparing the first and the last string
+// characters, then the candidates are verified with memcmp().
+static inline const char*
+FindInBuffer(const char* ptr, const char* end, const char* str, int len)
+{
+    const char* const last = end - len;
+    const char*       p    = ptr;
+#ifdef KFS_IOBUFFER_USE_SSE2
+    const __m128i first = _mm_set1_epi8(str[0]);
+    const __m128i lastc = _mm_set1_epi8(str[len - 1]);
+    for (; p + 16 <= last + 1; p += 16) {
+        unsigned int mask = (unsigned int)_mm_movemask_epi8(_mm_and_si128(
+            _mm_cmpeq_epi8(first,
+                _mm_loadu_si128(reinterpret_cast<const __m128i*>(p))),
+            _mm_cmpeq_epi8(lastc,
+                _mm_loadu_si128(reinterpret_cast<const __m128i*>(
+                    p + len - 1)))
+        ));
+        while (mask != 0) {
+            const char* const f = p + __builtin_ctz(mask);
+            if (memcmp(f, str, len) == 0) {
+                return f;
+            }
+            mask &= mask - 1;
+        }
+    }
+#endif
+    while (p <= last &&
+            (p = (const char*)memchr(p, str[0], last - p + 1))) {
+        if (memcmp(p, str, len) == 0) {
+            return p;
+        }
+        p++;
+    }
+    return 0;
+}
+
 int
 IOBuffer::IndexOf(int offset, const char* str) const
 {
@@ -1702,6 +2010,7 @@ IOBuffer::IndexOf(int offset, const char* str) const
         // Nothing to search for.
         return (it != mBuf.end() ? soff : -1);
     }
+    const int             slen = (int)strlen(ss);
     int                   off = soff - nBytes;
     const char*           s   = ss;
     int                   idx = -1;
@@ -1734,6 +2043,16 @@ IOBuffer::IndexOf(int offset, const char* str) const
                 continue;
             }
         } else {
+            if (1 < slen) {
+                const char* const f = FindInBuffer(n, e, ss, slen);
+                if (f) {
+                    // Found.
+                    DebugVerify();
+                    return (off + int(f - c));
+                }
+                // Only look for the prefix at the end of the buffer.
+                n = max(n, e - (slen - 1));
+            }
             while (n < e && (n = (const char*)memchr(n, *s, e - n))) {
                 const char* const f = n;
                 while (*++s != 0 && ++n < e && *n == *s)
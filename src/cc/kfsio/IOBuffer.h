@@ -32,6 +32,8 @@
 #define _LIBIO_IOBUFFER_H
 
 #include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
 
 #include <cassert>
 #include <list>
@@ -40,9 +42,12 @@
 #include <ostream>
 #include <istream>
 #include <limits>
+#include <algorithm>
+#include <iterator>
 
 #include <boost/shared_ptr.hpp>
 #include "common/StdAllocator.h"
+#include "common/kfsatomic.h"
 
 namespace KFS
 {
@@ -99,6 +104,8 @@ public:
     /// set the producer/consumer based on the start/end positions
     /// that are passed in
     IOBufferData(const IOBufferData &other, char *s, char *e, char* p = 0);
+    IOBufferData(const IOBufferData& other);
+    IOBufferData& operator=(const IOBufferData& other);
     ~IOBufferData();
 
     ///
@@ -184,25 +191,88 @@ public:
     int IsEmpty() const { return mProducer <= mConsumer; }
     /// Returns true if has whole data buffer.
     bool HasCompleteBuffer() const {
-        return (mData.get() == mConsumer &&
+        return (mBlock && mBlock->Get() == mConsumer &&
             mConsumer + sDefaultBufferSize == mEnd);
     }
     bool IsShared() const {
-        return (! mData.unique());
+        return (! mBlock || ! mBlock->IsUnique());
     }
     static int GetDefaultBufferSize() {
         return sDefaultBufferSize;
     }
     /// Detach buffer can only detach non shared buffers. The caller assumes
-    /// full responsibility for releasing the buffer correctly. The method
-    /// should not be called if and object was created with IOBufferData(const
-    ///g IOBufferBlockPtr& data, ...) constructor.
+    /// full responsibility for releasing the buffer correctly. Buffers of the
+    /// objects created with IOBufferData(const IOBufferBlockPtr& data, ...)
+    /// constructor cannot be detached, and the method returns 0.
     char* DetachBuffer(bool consumerAtBufferStartFlag);
+    /// Exchange the buffers, and producer / consumer pointers. Unlike
+    /// assignment this does not modify the buffers' reference counts.
+    void Swap(IOBufferData& other)
+    {
+        std::swap(mBlock,    other.mBlock);
+        std::swap(mEnd,      other.mEnd);
+        std::swap(mProducer, other.mProducer);
+        std::swap(mConsumer, other.mConsumer);
+    }
 private:
-    IOBufferBlockPtr mData;
+    /// Reference counted data buffer header. Buffers are normally owned by a
+    /// single IOBuffer, therefore the reference count is modified with atomic
+    /// operations only when the buffer is shared: only the owner of the last
+    /// reference can observe the count equal to 1. The count can become 1 as
+    /// the result of other thread's atomic decrement, therefore Unref() reads
+    /// the count with acquire semantics, in order to ensure that the other
+    /// thread's accesses to the buffer happen before Destroy().
+    class Block
+    {
+    public:
+        enum Type
+        {
+            kTypeArray,
+            kTypeAllocator,
+            kTypeBlockPtr
+        };
+        static Block* Create(char* buf, Type type,
+            libkfsio::IOBufferAllocator* allocator);
+        static Block* Create(const IOBufferBlockPtr& data);
+        void Ref()
+        {
+            if (mRefCount == 1) {
+                mRefCount = 2;
+            } else {
+                SyncAddAndFetch(mRefCount, 1);
+            }
+        }
+        void Unref()
+        {
+            if (SyncLoadAcquire(mRefCount) == 1 ||
+                    SyncAddAndFetch(mRefCount, -1) == 0) {
+                Destroy();
+            }
+        }
+        bool IsUnique() const
+            { return (mRefCount == 1); }
+        char* Get() const
+            { return mBuf; }
+        char* Detach();
+    private:
+        char*                        mBuf;
+        libkfsio::IOBufferAllocator* mAllocator;
+        IOBufferBlockPtr             mData;
+        volatile int                 mRefCount;
+        Type                         mType;
+
+        Block(char* buf, Type type, libkfsio::IOBufferAllocator* allocator);
+        ~Block();
+        void Destroy();
+    private:
+        Block(const Block&);
+        Block& operator=(const Block&);
+    };
+
+    Block*           mBlock;
     /// Pointers that correspond to the start/end of the buffer
     char*            mEnd;
-    /// Pointers into mData that correspond to producer/consumer
+    /// Pointers into mBlock buffer that correspond to producer/consumer
     char*            mProducer;
     char*            mConsumer;
 
@@ -227,11 +297,171 @@ private:
 class IOBuffer
 {
 private:
-    typedef list<
-        IOBufferData,
-        StdFastAllocator<IOBufferData>
-    > BList;
+    /// Buffer fragments ring. The first kInlineCount fragments are stored in
+    /// the ring object itself, therefore most buffers do not allocate memory
+    /// for the fragments list, larger rings double the allocated capacity.
+    /// The list like interface provides the subset of std::list methods used
+    /// by IOBuffer. Iterators are logical positions in the ring: similarly
+    /// to std::list the end() iterator and the iterators at and past the
+    /// insert and erase position remain valid, but unlike std::list the
+    /// iterators preceding the position and the spliced from iterators are
+    /// invalidated, and all references to the fragments are invalidated by
+    /// any modification, as the fragments are moved with Swap().
+    class BList
+    {
+    public:
+        typedef uint64_t Pos;
+
+        template<typename T, typename L>
+        class Iterator
+        {
+        public:
+            typedef std::bidirectional_iterator_tag iterator_category;
+            typedef IOBufferData                    value_type;
+            typedef ptrdiff_t                       difference_type;
+            typedef T*                              pointer;
+            typedef T&                              reference;
+
+            Iterator()
+                : mList(0),
+                  mPos(BList::EndPos())
+                {}
+            template<typename OT, typename OL>
+            Iterator(const Iterator<OT, OL>& other)
+                : mList(other.mList),
+                  mPos(other.mPos)
+                {}
+            T& operator*() const
+                { return mList->At(mPos); }
+            T* operator->() const
+                { return &mList->At(mPos); }
+            Iterator& operator++()
+            {
+                mPos = mList->Next(mPos);
+                return *this;
+            }
+            Iterator& operator--()
+            {
+                mPos = mList->Prev(mPos);
+                return *this;
+            }
+            Iterator operator++(int)
+            {
+                Iterator ret(*this);
+                mPos = mList->Next(mPos);
+                return ret;
+            }
+            Iterator operator--(int)
+            {
+                Iterator ret(*this);
+                mPos = mList->Prev(mPos);
+                return ret;
+            }
+            template<typename OT, typename OL>
+            bool operator==(const Iterator<OT, OL>& other) const
+                { return (mPos == other.mPos && mList == other.mList); }
+            template<typename OT, typename OL>
+            bool operator!=(const Iterator<OT, OL>& other) const
+                { return (mPos != other.mPos || mList != other.mList); }
+        private:
+            L*  mList;
+            Pos mPos;
+
+            Iterator(L* list, Pos pos)
+                : mList(list),
+                  mPos(pos)
+                {}
+            template<typename OT, typename OL> friend class Iterator;
+            friend class BList;
+        };
+        typedef Iterator<IOBufferData, BList>             iterator;
+        typedef Iterator<const IOBufferData, const BList> const_iterator;
+
+        BList();
+        ~BList();
+        bool empty() const
+            { return (mSize <= 0); }
+        iterator begin()
+            { return iterator(this, mSize <= 0 ? EndPos() : mHead); }
+        iterator end()
+            { return iterator(this, EndPos()); }
+        const_iterator begin() const
+            { return const_iterator(this, mSize <= 0 ? EndPos() : mHead); }
+        const_iterator end() const
+            { return const_iterator(this, EndPos()); }
+        IOBufferData& front()
+            { return At(mHead); }
+        IOBufferData& back()
+            { return At(mHead + mSize - 1); }
+        const IOBufferData& front() const
+            { return At(mHead); }
+        const IOBufferData& back() const
+            { return At(mHead + mSize - 1); }
+        void push_back(const IOBufferData& buf);
+        void pop_front();
+        void pop_back();
+        iterator insert(const_iterator pos, const IOBufferData& buf);
+        iterator erase(const_iterator pos);
+        iterator erase(const_iterator first, const_iterator last);
+        void splice(const_iterator pos, BList& other);
+        void splice(const_iterator pos, BList& other, const_iterator it);
+        void splice(const_iterator pos, BList& other,
+            const_iterator first, const_iterator last);
+        void clear();
+        void swap(BList& other);
+
+        IOBufferData& At(Pos pos)
+            { return mPtr[(size_t)(pos & mMask)]; }
+        const IOBufferData& At(Pos pos) const
+            { return mPtr[(size_t)(pos & mMask)]; }
+        Pos Next(Pos pos) const
+            { return (pos + 1 - mHead < mSize ? pos + 1 : EndPos()); }
+        Pos Prev(Pos pos) const
+            { return (pos == EndPos() ? mHead + mSize - 1 : pos - 1); }
+        static Pos EndPos()
+            { return ~Pos(0); }
+    private:
+        enum { kInlineCount = 4 };
+        enum
+        {
+            kInlineSize = (kInlineCount * sizeof(IOBufferData) +
+                sizeof(size_t) - 1) / sizeof(size_t)
+        };
+
+        IOBufferData* mPtr;
+        Pos           mHead;
+        Pos           mSize;
+        Pos           mMask;
+        size_t        mInline[kInlineSize];
+
+        IOBufferData* InlinePtr()
+            { return reinterpret_cast<IOBufferData*>(mInline); }
+        bool IsInline() const
+            { return (mPtr == reinterpret_cast<const IOBufferData*>(mInline)); }
+        void Reserve(Pos size);
+        void FreeStorage();
+        void Take(BList& other);
+        iterator Insert(const_iterator pos, Pos count);
+        static void Construct(IOBufferData* ptr, Pos count);
+        static void Destroy(IOBufferData* ptr, Pos count);
+        static void Reset(IOBufferData& buf)
+        {
+            IOBufferData empty(0);
+            buf.Swap(empty);
+        }
+    private:
+        BList(const BList&);
+        BList& operator=(const BList&);
+    };
 public:
+    /// Buffer fragments iterator. The iterator invalidation rules differ from
+    /// std::list: an IOBuffer modification invalidates the iterators that
+    /// precede the fragment insert or erase position, the end() iterator and
+    /// the iterators at or past the position remain valid. The iterators of
+    /// the buffer that the data is moved from with Move(), Replace(), etc. are
+    /// all invalidated. References and pointers to IOBufferData obtained with
+    /// the iterator are invalidated by any modification of the buffer, as
+    /// the fragments are moved within the ring.
     typedef BList::const_iterator iterator;
     class Reader
     {
@@ -291,7 +521,8 @@ public:
     int Read(int fd, int maxReadAhead, Reader* reader);
     int Read(int fd, int maxReadAhead = -1)
         { return Read(fd, maxReadAhead, 0); }
-    int Write(int fd);
+    /// Write up to maxBytes, or all data if maxBytes is negative.
+    int Write(int fd, int maxBytes = -1);
 
     /// Move data from one buffer to another.  This involves (mostly)
     /// shuffling pointers without incurring data copying.
@@ -455,6 +686,7 @@ public:
 #endif
     /// Buffer list iterator.
     /// Do not modify IOBufferData pointed by the iterator, or its content.
+    /// See the iterator type description for the invalidation rules.
     iterator begin() const { return mBuf.begin(); }
     iterator end()   const { return mBuf.end();   }
 
@@ -573,6 +805,13 @@ private:
     inline void DebugVerify(bool updateChecksum);
 
     inline static BList::iterator SplitBufferListAt(BList& buf, int& nBytes);
+    inline static BList::iterator InsertNew(
+        BList& buf, BList::iterator pos);
+    inline static BList::iterator InsertShared(
+        BList& buf, BList::iterator pos,
+        const IOBufferData& other, char* c, char* e, char* p = 0);
+    inline static void Assign(IOBufferData& dst,
+        const IOBufferData& other, char* c, char* e, char* p = 0);
     inline BList::iterator BeginSpaceAvailable(int* nBytes = 0);
     inline bool IsValidCopyInPos(const IOBuffer::iterator& pos);
     IOBuffer(const IOBuffer& buf);
@@ -32,6 +32,21 @@
 
 #include <cerrno>
 #include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <string.h>
+#include <deque>
+#include <algorithm>
+
+#ifdef KFS_OS_NAME_LINUX
+#include <sys/sendfile.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <linux/errqueue.h>
+#if defined(SO_ZEROCOPY) && defined(MSG_ZEROCOPY)
+#define KFS_NET_ZERO_COPY
+#endif
+#endif
 
 namespace KFS
 {
@@ -49,6 +64,393 @@ IsFatalError(int err)
     return (err != EAGAIN && err != EWOULDBLOCK && err != EINTR);
 }
 
+class NetConnection::SendFileQueue
+{
+public:
+    struct Region
+    {
+        int     mFd;
+        int64_t mOffset;
+        int64_t mSize;
+        // Out buffer bytes that must be sent before this region.
+        int     mOutBufBytes;
+    };
+    typedef std::deque<Region> Regions;
+
+    SendFileQueue()
+        : mRegions(),
+          mOutBufBytes(0)
+        {}
+    ~SendFileQueue()
+    {
+        for (Regions::const_iterator it = mRegions.begin();
+                it != mRegions.end();
+                ++it) {
+            close(it->mFd);
+        }
+    }
+
+    Regions mRegions;
+    int     mOutBufBytes;
+};
+
+class NetConnection::ZeroCopy
+{
+public:
+    // The kernel documentation suggests that zero copy sends are generally
+    // only effective with writes larger than around 10KB, as page pinning
+    // and completion notification have a cost.
+    enum { kMinSize = 10 << 10 };
+
+    ZeroCopy()
+        : mMinSize(-1),
+          mNextSeq(0),
+          mCopiedFlag(false),
+          mPinnedBytes(0),
+          mPinned(),
+          mSends()
+        {}
+    bool IsIdle() const
+        { return mSends.empty(); }
+    bool IsEnabled() const
+        { return (0 < mMinSize && ! mCopiedFlag); }
+    int GetPinnedBytes() const
+        { return mPinnedBytes; }
+    // Keep references to the buffers being sent until the send completes.
+    void Pin(const IOBuffer& buf, int numBytes)
+    {
+        Send send;
+        send.mSeq   = mNextSeq++;
+        send.mCount = 0;
+        send.mBytes = numBytes;
+        int rem = numBytes;
+        for (IOBuffer::iterator it = buf.begin();
+                0 < rem && it != buf.end();
+                ++it) {
+            const int nb = it->BytesConsumable();
+            if (nb <= 0) {
+                continue;
+            }
+            mPinned.push_back(*it);
+            send.mCount++;
+            rem -= nb;
+        }
+        // Each successful zero copy send is assigned the next sequence
+        // number by the kernel.
+        mSends.push_back(send);
+        mPinnedBytes += numBytes;
+    }
+    int Reap(int fd);
+
+    int      mMinSize;
+    uint32_t mNextSeq;
+    bool     mCopiedFlag;
+private:
+    struct Send
+    {
+        uint32_t mSeq;
+        int      mCount;
+        int      mBytes;
+    };
+    typedef std::deque<IOBufferData> Pinned;
+    typedef std::deque<Send>         Sends;
+
+    int    mPinnedBytes;
+    Pinned mPinned;
+    Sends  mSends;
+
+    void Release(uint32_t last)
+    {
+        while (! mSends.empty() &&
+                0 <= (int32_t)(last - mSends.front().mSeq)) {
+            mPinned.erase(mPinned.begin(),
+                mPinned.begin() + mSends.front().mCount);
+            mPinnedBytes -= mSends.front().mBytes;
+            mSends.pop_front();
+        }
+    }
+};
+
+int
+NetConnection::ZeroCopy::Reap(int fd)
+{
+    int count = 0;
+#ifdef KFS_NET_ZERO_COPY
+    for (; ;) {
+        char          control[256];
+        struct msghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_control    = control;
+        msg.msg_controllen = sizeof(control);
+        if (recvmsg(fd, &msg, MSG_ERRQUEUE | MSG_DONTWAIT) < 0) {
+            break;
+        }
+        for (struct cmsghdr* cm = CMSG_FIRSTHDR(&msg);
+                cm;
+                cm = CMSG_NXTHDR(&msg, cm)) {
+            if (! ((cm->cmsg_level == SOL_IP &&
+                        cm->cmsg_type == IP_RECVERR) ||
+                    (cm->cmsg_level == SOL_IPV6 &&
+                        cm->cmsg_type == IPV6_RECVERR))) {
+                continue;
+            }
+            const struct sock_extended_err* const err =
+                reinterpret_cast<const struct sock_extended_err*>(
+                    CMSG_DATA(cm));
+            if (err->ee_errno != 0 ||
+                    err->ee_origin != SO_EE_ORIGIN_ZEROCOPY) {
+                continue;
+            }
+            if ((err->ee_code & SO_EE_CODE_ZEROCOPY_COPIED) != 0) {
+                // The kernel had to copy the data anyway, for example with
+                // loopback, or the device does not support scatter gather.
+                // Stop using zero copy with this connection.
+                mCopiedFlag = true;
+            }
+            // The range [ee_info, ee_data] is complete, and the tcp
+            // completions are in order.
+            Release(err->ee_data);
+            count++;
+        }
+    }
+#else
+    (void)fd;
+#endif
+    return count;
+}
+
+bool
+NetConnection::ReapZeroCopy(int fd, NetConnection::ZeroCopy& zeroCopy)
+{
+    if (! zeroCopy.IsIdle() && 0 <= fd) {
+        zeroCopy.Reap(fd);
+    }
+    return zeroCopy.IsIdle();
+}
+
+void
+NetConnection::DeleteZeroCopy(NetConnection::ZeroCopy* zeroCopy)
+{
+    delete zeroCopy;
+}
+
+int
+NetConnection::GetNumBytesPinned() const
+{
+    return (mZeroCopyPtr ? mZeroCopyPtr->GetPinnedBytes() : 0);
+}
+
+int
+NetConnection::SetZeroCopy(int minSize)
+{
+    if (minSize <= 0) {
+        if (mZeroCopyPtr) {
+            mZeroCopyPtr->mMinSize = -1;
+        }
+        return 0;
+    }
+#ifdef KFS_NET_ZERO_COPY
+    if (! IsGood()) {
+        return -ENOTCONN;
+    }
+    if (! mZeroCopyPtr) {
+        const int on = 1;
+        if (setsockopt(mSock->GetFd(), SOL_SOCKET, SO_ZEROCOPY,
+                &on, sizeof(on))) {
+            return (errno ? -errno : -EINVAL);
+        }
+        mZeroCopyPtr = new ZeroCopy();
+    }
+    mZeroCopyPtr->mMinSize = std::max((int)ZeroCopy::kMinSize, minSize);
+    return 0;
+#else
+    return -ENOTSUP;
+#endif
+}
+
+int
+NetConnection::WriteZeroCopy()
+{
+    const int  fd       = mSock->GetFd();
+    ZeroCopy&  zeroCopy = *mZeroCopyPtr;
+    if (! zeroCopy.IsIdle()) {
+        zeroCopy.Reap(fd);
+    }
+#ifdef KFS_NET_ZERO_COPY
+    const int    kMaxWriteBufs = 64;
+    const int    kMaxWriteSize = 1 << 20;
+    struct iovec writeVec[kMaxWriteBufs];
+    int          total = 0;
+    while (zeroCopy.IsEnabled() &&
+            zeroCopy.mMinSize <= mOutBuffer.BytesConsumable()) {
+        int nVec = 0;
+        int toWr = 0;
+        for (IOBuffer::iterator it = mOutBuffer.begin();
+                it != mOutBuffer.end() && nVec < kMaxWriteBufs &&
+                    toWr < kMaxWriteSize;
+                ++it) {
+            const int nb = it->BytesConsumable();
+            if (nb <= 0) {
+                continue;
+            }
+            writeVec[nVec].iov_base = const_cast<char*>(it->Consumer());
+            writeVec[nVec].iov_len  = (size_t)nb;
+            toWr += nb;
+            nVec++;
+        }
+        if (toWr < zeroCopy.mMinSize) {
+            break;
+        }
+        struct msghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_iov    = writeVec;
+        msg.msg_iovlen = nVec;
+        const ssize_t nWr = sendmsg(fd, &msg, MSG_ZEROCOPY);
+        if (nWr < 0) {
+            const int err = errno;
+            if (err == ENOBUFS) {
+                break; // Socket option memory limit, send with copy.
+            }
+            return (0 < total ? total : -(err ? err : EAGAIN));
+        }
+        zeroCopy.Pin(mOutBuffer, (int)nWr);
+        mOutBuffer.Consume((int)nWr);
+        globals().ctrNetBytesWritten.Update(nWr);
+        total += (int)nWr;
+        if (nWr < toWr) {
+            return total; // Socket buffer is full.
+        }
+    }
+    if (! mOutBuffer.IsEmpty()) {
+        const int nwr = mOutBuffer.Write(fd);
+        if (0 < nwr) {
+            total += nwr;
+        } else if (total <= 0 && IsFatalError(-nwr)) {
+            return nwr;
+        }
+    }
+    return total;
+#else
+    return mOutBuffer.Write(fd);
+#endif
+}
+
+void
+NetConnection::CloseZeroCopy()
+{
+    ZeroCopy* const zeroCopy = mZeroCopyPtr;
+    mZeroCopyPtr = 0;
+    const int fd = mSock ? mSock->GetFd() : -1;
+    if (ReapZeroCopy(fd, *zeroCopy)) {
+        DeleteZeroCopy(zeroCopy);
+        return;
+    }
+    // The kernel might still be sending from the pinned buffers. Keep the
+    // buffers, and the socket open with descriptor duplicate, until the
+    // sends complete.
+    NetManager::ZeroCopyLinger(mNetManagerEntry,
+        fd < 0 ? -1 : fcntl(fd, F_DUPFD_CLOEXEC, 0), zeroCopy);
+}
+
+bool
+NetConnection::IsSendFileSupported()
+{
+#ifdef KFS_OS_NAME_LINUX
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool
+NetConnection::WriteFile(int fd, int64_t offset, int64_t size,
+    bool resetTimerFlag /* = true */)
+{
+    if (! IsSendFileSupported() || ! IsDirectWrite() || fd < 0 ||
+            offset < 0 || size <= 0 || ! IsGood()) {
+        return false;
+    }
+    const bool resetTimer = resetTimerFlag && ! IsWriteReady();
+    if (! mSendFilePtr) {
+        mSendFilePtr = new SendFileQueue();
+    }
+    SendFileQueue::Region region;
+    region.mFd          = fd;
+    region.mOffset      = offset;
+    region.mSize        = size;
+    region.mOutBufBytes =
+        mOutBuffer.BytesConsumable() - mSendFilePtr->mOutBufBytes;
+    mSendFilePtr->mRegions.push_back(region);
+    mSendFilePtr->mOutBufBytes += region.mOutBufBytes;
+    mSendFileByteCount         += size;
+    Update(resetTimer);
+    return true;
+}
+
+void
+NetConnection::ClearSendFile()
+{
+    delete mSendFilePtr;
+    mSendFilePtr       = 0;
+    mSendFileByteCount = 0;
+}
+
+int
+NetConnection::WriteSendFile()
+{
+#ifdef KFS_OS_NAME_LINUX
+    const int64_t kMaxSendFileSize = 1 << 20;
+    const int     fd               = mSock->GetFd();
+    SendFileQueue::Regions& regions = mSendFilePtr->mRegions;
+    int total = 0;
+    while (! regions.empty()) {
+        SendFileQueue::Region& region = regions.front();
+        if (0 < region.mOutBufBytes) {
+            const int nwr = mOutBuffer.Write(fd, region.mOutBufBytes);
+            if (nwr <= 0) {
+                return ((0 < total || ! IsFatalError(-nwr)) ? total : nwr);
+            }
+            region.mOutBufBytes        -= nwr;
+            mSendFilePtr->mOutBufBytes -= nwr;
+            total                      += nwr;
+            if (0 < region.mOutBufBytes) {
+                return total;
+            }
+        }
+        const ssize_t nwr = sendfile(fd, region.mFd, &region.mOffset,
+            (size_t)std::min(region.mSize, kMaxSendFileSize));
+        if (nwr <= 0) {
+            // Zero means that the file is shorter than the region, and the
+            // promised data can not be sent. With the socket buffer full,
+            // return what was sent so far, and let the net manager invoke
+            // the write handler again once the socket becomes writable.
+            const int err = nwr == 0 ? EIO : (errno ? errno : EIO);
+            return ((0 < total || ! IsFatalError(err)) ? total : -err);
+        }
+        globals().ctrNetBytesWritten.Update(nwr);
+        region.mSize       -= nwr;
+        mSendFileByteCount -= nwr;
+        total              += (int)nwr;
+        if (0 < region.mSize) {
+            return total; // Socket buffer is full.
+        }
+        close(region.mFd);
+        regions.pop_front();
+    }
+    if (! mOutBuffer.IsEmpty()) {
+        const int nwr = mOutBuffer.Write(fd);
+        if (0 < nwr) {
+            total += nwr;
+        } else if (total <= 0) {
+            return nwr;
+        }
+    }
+    return total;
+#else
+    return -ENOTSUP;
+#endif
+}
+
 void
 NetConnection::HandleReadEvent(int maxAcceptsPerRead /* = 1 */)
 {
@@ -113,11 +515,14 @@ NetConnection::HandleWriteEvent()
     int nwrote = 0;
     if (IsGood()) {
         mTryWrite = false; // Reset to prevent possible recursion.
-        bool forceInvokeErrHandlerFlag = false;
-        nwrote = WantWrite() ? (mFilter ?
+        bool      forceInvokeErrHandlerFlag = false;
+        const int pinned                    = GetNumBytesPinned();
+        nwrote = WantWrite() ? (! IsDirectWrite() ?
             mFilter->Write(*this, *mSock, mOutBuffer,
                 forceInvokeErrHandlerFlag) :
-            mOutBuffer.Write(mSock->GetFd())
+            (0 < mSendFileByteCount ? WriteSendFile() :
+                ((mZeroCopyPtr && ! mFilter) ? WriteZeroCopy() :
+                    mOutBuffer.Write(mSock->GetFd())))
         ) : 0;
         if (nwrote < 0 && IsFatalError(-nwrote)) {
             GetErrorMsg();
@@ -134,7 +539,8 @@ NetConnection::HandleWriteEvent()
                 "write: forcing error handler invocation, wrote: " << nwrote <<
             KFS_LOG_EOM;
             mCallbackObj->HandleEvent(EVENT_NET_ERROR, 0);
-        } else if (nwrote > 0 || wasConnectPending) {
+        } else if (nwrote > 0 || wasConnectPending ||
+                GetNumBytesPinned() < pinned) {
             mCallbackObj->HandleEvent(EVENT_NET_WROTE, &mOutBuffer);
         }
     }
@@ -146,9 +552,20 @@ void
 NetConnection::HandleErrorEvent()
 {
     if (IsGood()) {
+        int sockErr = -1;
+        if (mZeroCopyPtr && ! mZeroCopyPtr->IsIdle() &&
+                0 < mZeroCopyPtr->Reap(mSock->GetFd()) &&
+                (sockErr = GetSocketError()) == 0) {
+            // Zero copy send completion, not an error. Let the owner know
+            // that the pinned buffers were released.
+            mCallbackObj->HandleEvent(EVENT_NET_WROTE, &mOutBuffer);
+            Update(false);
+            return;
+        }
         GetErrorMsg();
         IsAuthFailure();
-        int status = mAuthFailureFlag ? -EPERM : -GetSocketError();
+        int status = mAuthFailureFlag ? -EPERM :
+            -(0 <= sockErr ? sockErr : GetSocketError());
         NET_CONNECTION_LOG_STREAM_DEBUG <<
             "closing connection due to error" <<
             (mAuthFailureFlag ? " auth failure" : "") <<
@@ -112,6 +112,11 @@ public:
             { return string(); }
         bool IsReadPending() const
             { return mReadPendingFlag; }
+        /// Returns true if the filter has handed the send side over to the
+        /// kernel, for example with kernel tls, and the output can be
+        /// written directly into the socket.
+        virtual bool IsWriteThrough() const
+            { return false; }
     protected:
         Filter()
             : mReadPendingFlag(false)
@@ -139,7 +144,10 @@ public:
           maxReadAhead(-1),
           mPeerName(),
           mLstErrorMsg(),
-          mFilter(filter) {
+          mFilter(filter),
+          mSendFilePtr(0),
+          mSendFileByteCount(0),
+          mZeroCopyPtr(0) {
         assert(mSock);
     }
 
@@ -147,10 +155,21 @@ public:
         return mFilter;
     }
 
+    /// Returns true if the output is written directly into the socket.
+    bool IsDirectWrite() const {
+        return (! mFilter || mFilter->IsWriteThrough());
+    }
+
     int SetFilter(Filter* filter, string* outErrMsg) {
         if (mFilter == filter) {
             return 0;
         }
+        if (filter && 0 < mSendFileByteCount) {
+            if (outErrMsg) {
+                *outErrMsg = "send file is pending";
+            }
+            return -EBUSY;
+        }
         if (mFilter) {
             mFilter->Detach(*this, mSock);
         }
@@ -160,6 +179,8 @@ public:
 
     ~NetConnection() {
         NetConnection::Close();
+        ClearSendFile();
+        DeleteZeroCopy(mZeroCopyPtr);
     }
 
     void SetOwningKfsCallbackObj(KfsCallbackObj* c) {
@@ -220,14 +241,18 @@ public:
 
     /// Is data available for writing?
     bool IsWriteReady() const {
-        return (! mOutBuffer.IsEmpty());
+        return (! mOutBuffer.IsEmpty() || 0 < mSendFileByteCount);
     }
 
     /// # of bytes available for writing(false),
     int GetNumBytesToWrite() const {
-        return mOutBuffer.BytesConsumable();
+        return (mOutBuffer.BytesConsumable() + (int)mSendFileByteCount);
     }
 
+    /// # of bytes sent with zero copy, and not yet released by the kernel.
+    /// EVENT_NET_WROTE is issued when the kernel releases the buffers.
+    int GetNumBytesPinned() const;
+
     /// Is the connection still good?
     bool IsGood() const {
         return (mSock && mSock->IsGood());
@@ -259,6 +284,10 @@ public:
         return (IsGood() ? mSock->GetSockLocation(loc) : -ENOTCONN);
     }
 
+    int GetIncomingCpu() const {
+        return (IsGood() ? mSock->GetIncomingCpu() : -ENOTCONN);
+    }
+
     /// Enqueue data to be sent out.
     void Write(const IOBufferData &ioBufData, bool resetTimerFlag = true) {
         if (! ioBufData.IsEmpty()) {
@@ -303,6 +332,31 @@ public:
         }
     }
 
+    /// Enqueue file region to be sent out with sendfile(), after all data
+    /// presently in the out buffer. The connection takes ownership of the
+    /// file descriptor, and closes it once the region is sent, or the
+    /// connection is closed.
+    /// @retval false, and the file descriptor is not closed, if sendfile is
+    /// not supported, or the connection has a filter.
+    bool WriteFile(int fd, int64_t offset, int64_t size,
+        bool resetTimerFlag = true);
+    static bool IsSendFileSupported();
+
+    /// Send with MSG_ZEROCOPY when at least minSize bytes are ready to be
+    /// sent, and the connection has no filter. The sent buffers are kept
+    /// until the kernel reports the send completion on the socket error
+    /// queue. Sizes less than 10KB are raised to 10KB, as zero copy is not
+    /// effective with small writes. Zero or negative size turns zero copy
+    /// sends off.
+    /// @retval 0 on success, or negative error code.
+    int SetZeroCopy(int minSize);
+    /// Zero copy send state, kept by the net manager after the connection
+    /// is closed, and until all in flight sends complete.
+    class ZeroCopy;
+    /// Reap completions. Returns true if no sends are in flight.
+    static bool ReapZeroCopy(int fd, ZeroCopy& zeroCopy);
+    static void DeleteZeroCopy(ZeroCopy* zeroCopy);
+
     bool CanStartFlush() const {
         return (mTryWrite && IsWriteReady() && IsGood());
     }
@@ -338,11 +392,15 @@ public:
         }
         // To avoid race with file descriptor number re-use by the OS,
         // remove the socket from poll set first, then close the socket.
+        if (mZeroCopyPtr) {
+            CloseZeroCopy();
+        }
         TcpSocket* const sock = mOwnsSocket ? mSock : 0;
         mSock = 0;
         // Clear data that can not be sent, but keep input data if any.
         if (clearOutBufferFlag) {
             mOutBuffer.Clear();
+            ClearSendFile();
         }
         Update();
         if (sock) {
@@ -389,6 +447,7 @@ public:
 
     void DiscardWrite() {
         mOutBuffer.Clear();
+        ClearSendFile();
         Update();
     }
 
@@ -527,6 +586,16 @@ private:
     string          mPeerName;
     string          mLstErrorMsg;
     Filter*         mFilter;
+    /// File regions pending to be sent with sendfile(), allocated on demand.
+    class SendFileQueue;
+    SendFileQueue*  mSendFilePtr;
+    int64_t         mSendFileByteCount;
+    ZeroCopy*       mZeroCopyPtr;
+
+    int WriteSendFile();
+    void ClearSendFile();
+    int WriteZeroCopy();
+    void CloseZeroCopy();
 
     friend class NetManagerEntry;
 private:
@@ -32,6 +32,7 @@
 #include <limits>
 #include <unistd.h>
 #include <fcntl.h>
+#include <sys/socket.h>
 
 #include "NetManager.h"
 #include "TcpSocket.h"
@@ -76,7 +77,8 @@ NetManager::NetManager(int timeoutMs)
       mPendingReadList(),
       mPendingUpdate(),
       mCurTimeoutHandler(0),
-      mEpollError()
+      mEpollError(),
+      mZeroCopyLinger()
 {
     TimeoutHandlers::Init(mTimeoutHandlers);
     mPendingUpdate.reserve(1 << 10);
@@ -537,6 +539,9 @@ NetManager::MainLoop(
             mRemove.clear();
         }
         mTimerRunningFlag = false;
+        if (! mZeroCopyLinger.empty() && mLastTimerTime < mNow) {
+            ReapZeroCopyLinger(false);
+        }
         mLastTimerTime = mNow;
         mTimerWheelBucketItr = mRemove.end();
         if (runOnceFlag) {
@@ -613,6 +618,67 @@ NetManager::CleanUp(bool childAtForkFlag, bool onlyCloseFdFlag)
         mRemove.clear();
     }
     mTimerWheelBucketItr = mRemove.end();
+    if (childAtForkFlag) {
+        // Socket options are shared with the parent, only close descriptors.
+        for (ZeroCopyLingerList::const_iterator it = mZeroCopyLinger.begin();
+                it != mZeroCopyLinger.end();
+                ++it) {
+            close(it->mFd);
+            NetConnection::DeleteZeroCopy(it->mZeroCopyPtr);
+        }
+        mZeroCopyLinger.clear();
+    } else {
+        ReapZeroCopyLinger(true);
+    }
+}
+
+void
+NetManager::ZeroCopyLinger(NetConnection::NetManagerEntry& entry, int fd,
+    NetConnection::ZeroCopy* zeroCopy)
+{
+    NetManager* const netManager = entry.mNetManager;
+    if (! netManager || fd < 0 || netManager->mShutdownFlag) {
+        if (0 <= fd) {
+            close(fd);
+        }
+        NetConnection::DeleteZeroCopy(zeroCopy);
+        return;
+    }
+    ZeroCopyLingerEntry linger;
+    linger.mFd          = fd;
+    linger.mZeroCopyPtr = zeroCopy;
+    linger.mExpireTime  = netManager->mNow + kZeroCopyLingerTimeSec;
+    netManager->mZeroCopyLinger.push_back(linger);
+}
+
+void
+NetManager::ReapZeroCopyLinger(bool closeAllFlag)
+{
+    ZeroCopyLingerList::iterator it = mZeroCopyLinger.begin();
+    while (it != mZeroCopyLinger.end()) {
+        const bool idleFlag =
+            NetConnection::ReapZeroCopy(it->mFd, *it->mZeroCopyPtr);
+        if (! idleFlag && ! closeAllFlag && mNow < it->mExpireTime) {
+            ++it;
+            continue;
+        }
+        if (! idleFlag) {
+            // Reset the connection, in order to prevent further sends from
+            // the buffers that are about to be released.
+            struct linger lingerOpt;
+            lingerOpt.l_onoff  = 1;
+            lingerOpt.l_linger = 0;
+            setsockopt(it->mFd, SOL_SOCKET, SO_LINGER,
+                &lingerOpt, sizeof(lingerOpt));
+            KFS_LOG_STREAM_DEBUG <<
+                "zero copy linger: fd: " << it->mFd <<
+                " closing with sends in flight" <<
+            KFS_LOG_EOM;
+        }
+        close(it->mFd);
+        NetConnection::DeleteZeroCopy(it->mZeroCopyPtr);
+        it = mZeroCopyLinger.erase(it);
+    }
 }
 
 void
@@ -203,13 +203,25 @@ public:
     /// Method used by NetConnection only.
     static void Update(NetManagerEntry& entry, int fd,
         bool resetTimer);
+    /// Keep socket descriptor and buffers of the closed connection with
+    /// zero copy sends in flight until the sends complete.
+    static void ZeroCopyLinger(NetManagerEntry& entry, int fd,
+        NetConnection::ZeroCopy* zeroCopy);
     static inline const NetManager* GetNetManager(const NetConnection& conn);
 private:
     typedef NetManagerEntry::List            List;
     typedef QCDLList<ITimeout>               TimeoutHandlers;
     typedef NetManagerEntry::PendingReadList PendingReadList;
     typedef vector<NetConnection*>           PendingUpdate;
+    struct ZeroCopyLingerEntry
+    {
+        int                      mFd;
+        NetConnection::ZeroCopy* mZeroCopyPtr;
+        time_t                   mExpireTime;
+    };
+    typedef vector<ZeroCopyLingerEntry>      ZeroCopyLingerList;
     enum { kTimerWheelSize = (1 << 8) };
+    enum { kZeroCopyLingerTimeSec = 120 };
 
     List            mRemove;
     List::iterator  mTimerWheelBucketItr;
@@ -247,6 +259,7 @@ private:
     ITimeout*       mTimeoutHandlers[1];
     List            mEpollError;
     List            mTimerWheel[kTimerWheelSize + 1];
+    ZeroCopyLingerList mZeroCopyLinger;
 
     void CheckIfOverloaded();
     void CleanUp(bool childAtForkFlag = false, bool onlyCloseFdFlag = false);
@@ -254,6 +267,7 @@ private:
     void UpdateSelf(NetManagerEntry& entry, int fd,
         bool resetTimer, bool epollError);
     void PollRemove(int fd);
+    void ReapZeroCopyLinger(bool closeAllFlag);
 private:
     NetManager(const NetManager&);
     NetManager& operator=(const NetManager&);
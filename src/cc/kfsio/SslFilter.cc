@@ -48,16 +48,120 @@
 
 #include <string>
 #include <algorithm>
+#include <map>
+#include <list>
+
+#if defined(SSL_OP_ENABLE_KTLS) && ! defined(OPENSSL_NO_KTLS) && \
+    defined(SSL_OP_NO_RENEGOTIATION)
+#define KFS_SSL_KTLS
+#endif
 
 namespace KFS
 {
 using std::string;
 using std::max;
+using std::map;
+using std::list;
+using std::make_pair;
 using namespace KFS::libkfsio;
 
 class SslFilter::Impl : private IOBuffer::Reader
 {
 private:
+    // Client side sessions for resume, keyed by peer and psk identity. The
+    // least recently used session is evicted when the cache is full.
+    class ClientSessions
+    {
+    public:
+        ClientSessions(
+            long inMaxSize)
+            : mSessions(),
+              mLru(),
+              mMaxSize(max(long(1), inMaxSize))
+            {}
+        ~ClientSessions()
+        {
+            for (Sessions::iterator theIt = mSessions.begin();
+                    theIt != mSessions.end();
+                    ++theIt) {
+                SSL_SESSION_free(theIt->second.mSessionPtr);
+            }
+        }
+        SSL_SESSION* Get(
+            const string& inKey,
+            time_t        inNow)
+        {
+            Sessions::iterator const theIt = mSessions.find(inKey);
+            if (theIt == mSessions.end()) {
+                return 0;
+            }
+            SSL_SESSION* const thePtr = theIt->second.mSessionPtr;
+            if (SSL_SESSION_get_time(thePtr) +
+                    SSL_SESSION_get_timeout(thePtr) <= inNow) {
+                Erase(theIt);
+                return 0;
+            }
+            mLru.splice(mLru.end(), mLru, theIt->second.mLruIt);
+            return thePtr;
+        }
+        void Set(
+            const string& inKey,
+            SSL_SESSION*  inSessionPtr)
+        {
+            Sessions::iterator theIt = mSessions.find(inKey);
+            if (theIt != mSessions.end()) {
+                SSL_SESSION_free(theIt->second.mSessionPtr);
+                theIt->second.mSessionPtr = inSessionPtr;
+                mLru.splice(mLru.end(), mLru, theIt->second.mLruIt);
+                return;
+            }
+            if (mMaxSize <= (long)mSessions.size()) {
+                Erase(mSessions.find(mLru.front()));
+            }
+            Entry& theEntry = mSessions[inKey];
+            theEntry.mSessionPtr = inSessionPtr;
+            theEntry.mLruIt      = mLru.insert(mLru.end(), inKey);
+        }
+    private:
+        typedef list<string> Lru;
+        struct Entry
+        {
+            Entry()
+                : mSessionPtr(0),
+                  mLruIt()
+                {}
+            SSL_SESSION*  mSessionPtr;
+            Lru::iterator mLruIt;
+        };
+        typedef map<string, Entry> Sessions;
+
+        Sessions   mSessions;
+        Lru        mLru;
+        long const mMaxSize;
+
+        void Erase(
+            Sessions::iterator inIt)
+        {
+            SSL_SESSION_free(inIt->second.mSessionPtr);
+            mLru.erase(inIt->second.mLruIt);
+            mSessions.erase(inIt);
+        }
+    private:
+        ClientSessions(
+            const ClientSessions& inSessions);
+        ClientSessions& operator=(
+            const ClientSessions& inSessions);
+    };
+    static void SslCtxClientSessionsFree(
+        void*           /* inSslCtx */,
+        void*           inSessionsPtr,
+        CRYPTO_EX_DATA* /* inDataPtr */,
+        int             /* inIdx */,
+        long            /* inArgLong */,
+        void*           /* inArgPtr */)
+    {
+        delete reinterpret_cast<ClientSessions*>(inSessionsPtr);
+    }
     static void SslCtxSessionFree(
         void*           /* inSslCtx */,
         void*           inSessionPtr,
@@ -132,6 +236,14 @@ public:
             Cleanup();
             return theErr;
         }
+        sOpenSslInitPtr->mExDataClientSessionsIdx =
+            SSL_CTX_get_ex_new_index(0, (void*)"ClientSessions", 0, 0,
+                &SslCtxClientSessionsFree);
+        if (sOpenSslInitPtr->mExDataClientSessionsIdx < 0) {
+            const Error theErr = GetAndClearErr();
+            Cleanup();
+            return theErr;
+        }
         // Create ssl cts to ensure that all ssl libs static / globals are
         // properly initialized, to help to avoid any possible races.
         SSL_CTX* const theCtxPtr = SSL_CTX_new(TLSv1_method());
@@ -180,17 +292,43 @@ public:
         const Properties& inParams,
         string*           inErrMsgPtr)
     {
+        Properties::String theParamName;
+        if (inParamsPrefixPtr) {
+            theParamName.Append(inParamsPrefixPtr);
+        }
+        const size_t thePrefLen = theParamName.GetSize();
+#ifdef KFS_SSL_KTLS
+        // Kernel tls requires tls 1.2 or later. Use tls 1.2 in order to
+        // retain the psk semantics.
+        const bool     theKtlsFlag = inParams.getValue(
+            theParamName.Truncate(thePrefLen).Append("ktls"), 0) != 0;
+        SSL_CTX* const theRetPtr   = SSL_CTX_new(theKtlsFlag ?
+            (inServerFlag ? TLS_server_method() : TLS_client_method()) :
+            (inServerFlag ? TLSv1_server_method() : TLSv1_client_method()));
+        if (! theRetPtr) {
+            return 0;
+        }
+        if (theKtlsFlag) {
+            if (! SSL_CTX_set_max_proto_version(theRetPtr, TLS1_2_VERSION)) {
+                if (inErrMsgPtr) {
+                    *inErrMsgPtr = GetErrorMsg(GetAndClearErr());
+                }
+                SSL_CTX_free(theRetPtr);
+                return 0;
+            }
+            // The kernel owns the keys after the handshake, therefore
+            // renegotiation cannot be supported.
+            SSL_CTX_set_options(theRetPtr,
+                SSL_OP_ENABLE_KTLS | SSL_OP_NO_RENEGOTIATION);
+        }
+#else
         SSL_CTX* const theRetPtr = SSL_CTX_new(
             inServerFlag ? TLSv1_server_method() : TLSv1_client_method());
         if (! theRetPtr) {
             return 0;
         }
+#endif
         SSL_CTX_set_mode(theRetPtr, SSL_MODE_ENABLE_PARTIAL_WRITE);
-        Properties::String theParamName;
-        if (inParamsPrefixPtr) {
-            theParamName.Append(inParamsPrefixPtr);
-        }
-        const size_t thePrefLen = theParamName.GetSize();
         if (! SSL_CTX_set_cipher_list(
             theRetPtr,
             inParams.getValue(
@@ -234,7 +372,21 @@ public:
         }
         if (inPskOnlyFlag) {
             SSL_CTX_set_verify(theRetPtr, SSL_VERIFY_NONE, 0);
-            SSL_CTX_set_session_cache_mode(theRetPtr, SSL_SESS_CACHE_OFF);
+            if (inParams.getValue(
+                    theParamName.Truncate(thePrefLen).Append(
+                    "session.resume"), 0) == 0) {
+                SSL_CTX_set_session_cache_mode(theRetPtr, SSL_SESS_CACHE_OFF);
+            } else if (! SetSessionResume(
+                    *theRetPtr,
+                    inServerFlag,
+                    inParams.getValue(
+                        theParamName.Truncate(thePrefLen).Append(
+                            "sessionCacheSize"),
+                        SSL_CTX_sess_get_cache_size(theRetPtr)),
+                    inErrMsgPtr)) {
+                SSL_CTX_free(theRetPtr);
+                return 0;
+            }
             return reinterpret_cast<Ctx*>(theRetPtr);
         }
         if (inParams.getValue(
@@ -343,6 +495,35 @@ public:
         }
         return reinterpret_cast<Ctx*>(theRetPtr);
     }
+    static bool SetSessionResume(
+        SSL_CTX& inCtx,
+        bool     inServerFlag,
+        long     inCacheSize,
+        string*  inErrMsgPtr)
+    {
+#ifdef SSL_OP_NO_TICKET
+        // Tickets allow to resume sessions evicted from the server cache.
+        SSL_CTX_clear_options(&inCtx, SSL_OP_NO_TICKET);
+#endif
+        if (inServerFlag) {
+            SSL_CTX_set_session_cache_mode(&inCtx, SSL_SESS_CACHE_SERVER);
+            SSL_CTX_sess_set_cache_size(&inCtx, inCacheSize);
+            return true;
+        }
+        // Client sessions are kept per peer, the ssl filter user supplies
+        // the peer key with SetSessionResumeKey().
+        SSL_CTX_set_session_cache_mode(&inCtx, SSL_SESS_CACHE_OFF);
+        ClientSessions* const theSessionsPtr = new ClientSessions(inCacheSize);
+        if (! SSL_CTX_set_ex_data(&inCtx,
+                sOpenSslInitPtr->mExDataClientSessionsIdx, theSessionsPtr)) {
+            delete theSessionsPtr;
+            if (inErrMsgPtr) {
+                *inErrMsgPtr = GetErrorMsg(GetAndClearErr());
+            }
+            return false;
+        }
+        return true;
+    }
     static long GetSessionTimeout(
         Ctx& inCtx)
         { return SSL_CTX_get_timeout(reinterpret_cast<SSL_CTX*>(&inCtx)); }
@@ -398,6 +579,7 @@ public:
           mAuthName(),
           mPeerPskId(),
           mPeerName(),
+          mSessionResumeKey(),
           mServerPskPtr(inServerPskPtr),
           mVerifyPeerPtr(inVerifyPeerPtr),
           mReadPendingFlag(inReadPendingFlag),
@@ -410,7 +592,8 @@ public:
           mSslErrorFlag(false),
           mShutdownCompleteFlag(false),
           mVerifyOrGetPskInvokedFlag(false),
-          mRenegotiationPendingFlag(false)
+          mRenegotiationPendingFlag(false),
+          mKtlsSendFlag(false)
     {
         if (! mSslPtr) {
             return;
@@ -426,7 +609,10 @@ public:
             }
 #endif
             SetPskCB();
-            SSL_set_read_ahead(mSslPtr, 1);
+            if (! IsKtlsEnabled()) {
+                // Kernel tls receive cannot be used with read ahead.
+                SSL_set_read_ahead(mSslPtr, 1);
+            }
             mServerFlag = ! SSL_in_connect_init(mSslPtr);
         } else {
             mError = GetAndClearErr();
@@ -452,6 +638,50 @@ public:
         mPskData.assign(inPskDataPtr, inPskDataLen);
         SetPskCB();
     }
+    void SetSessionResumeKey(
+        const string& inKey)
+        { mSessionResumeKey = inKey; }
+    void DisableKtls()
+    {
+        if (! mSslPtr || ! IsKtlsEnabled()) {
+            return;
+        }
+#ifdef KFS_SSL_KTLS
+        SSL_clear_options(mSslPtr, SSL_OP_ENABLE_KTLS);
+        SSL_set_read_ahead(mSslPtr, 1);
+        if (! SSL_in_before(mSslPtr)) {
+            return;
+        }
+        // Kernel tls works only with aead ciphers. Offer only non aead ciphers
+        // in order to prevent the peer from installing kernel tls on its side
+        // of the connection.
+        STACK_OF(SSL_CIPHER)* const theCiphersPtr = SSL_get_ciphers(mSslPtr);
+        string theList;
+        for (int i = 0; theCiphersPtr && i < sk_SSL_CIPHER_num(theCiphersPtr);
+                i++) {
+            const SSL_CIPHER* const theCipherPtr =
+                sk_SSL_CIPHER_value(theCiphersPtr, i);
+            if (SSL_CIPHER_is_aead(theCipherPtr)) {
+                continue;
+            }
+            if (! theList.empty()) {
+                theList += ':';
+            }
+            theList += SSL_CIPHER_get_name(theCipherPtr);
+        }
+        if (theList.empty()) {
+            KFS_LOG_STREAM_WARN <<
+                "ssl: no non aead ciphers configured, the peer might use"
+                " kernel tls" <<
+            KFS_LOG_EOM;
+        } else if (! SSL_set_cipher_list(mSslPtr, theList.c_str())) {
+            KFS_LOG_STREAM_WARN <<
+                "ssl: failed to exclude kernel tls ciphers: " <<
+                GetErrorMsg(GetAndClearErr()) <<
+            KFS_LOG_EOM;
+        }
+#endif
+    }
     bool WantRead(
         const NetConnection& inConnection) const
     {
@@ -597,6 +827,7 @@ public:
                 theRet = -ENOMEM;
             }
         }
+        mKtlsSendFlag = false;
         if (theRet == 0 && SSL_in_before(mSslPtr)) {
             mError                     = 0;
             mSslEofFlag                = false;
@@ -693,6 +924,17 @@ public:
     }
     bool IsHandshakeDone() const
         { return (mSslPtr && mError == 0 && SSL_is_init_finished(mSslPtr)); }
+    bool IsSessionReused() const
+        { return (IsHandshakeDone() && SSL_session_reused(mSslPtr) != 0); }
+    bool IsWriteThrough() const
+    {
+        // The send side can be bypassed only after the handshake and peer
+        // verification are complete, and ssl has no partial record pending.
+        return (
+            mKtlsSendFlag && mError == 0 && ! mShutdownInitiatedFlag &&
+            ! mRenegotiationPendingFlag && ! SSL_want_write(mSslPtr)
+        );
+    }
     string GetAuthName() const
     {
         return (
@@ -755,6 +997,7 @@ private:
     string            mAuthName;
     string            mPeerPskId;
     string            mPeerName;
+    string            mSessionResumeKey;
     ServerPsk* const  mServerPskPtr;
     VerifyPeer* const mVerifyPeerPtr;
     bool&             mReadPendingFlag;
@@ -768,6 +1011,7 @@ private:
     bool              mShutdownCompleteFlag:1;
     bool              mVerifyOrGetPskInvokedFlag:1;
     bool              mRenegotiationPendingFlag:1;
+    bool              mKtlsSendFlag:1;
 
     struct OpenSslInit
     {
@@ -778,6 +1022,7 @@ private:
               mExDataIdx(-1),
               mExDataSessionIdx(-1),
               mExDataClientX509Idx(-1),
+              mExDataClientSessionsIdx(-1),
               mErrFileNamePtr(0),
               mErrLine(-1),
               mAES256CbcCypherDebugPtr(0)
@@ -792,6 +1037,7 @@ private:
         int               mExDataIdx;
         int               mExDataSessionIdx;
         int               mExDataClientX509Idx;
+        int               mExDataClientSessionsIdx;
         const char*       mErrFileNamePtr;
         int               mErrLine;
         // To simplify tracking down using core file if aes-ni is engaged or
@@ -1007,6 +1253,29 @@ private:
             return true;
         }
         // This is invoked in the case of ssl session resume.
+#if ! (OPENSSL_VERSION_NUMBER < 0x10000000L || defined(OPENSSL_NO_PSK))
+        const char* const theIdentityPtr =
+            mServerFlag ? SSL_get_psk_identity(mSslPtr) : 0;
+        if (theIdentityPtr && mServerPskPtr) {
+            // Psk callback is not invoked with resume. Re-establish the
+            // authentication from the psk identity stored in the session.
+            mVerifyOrGetPskInvokedFlag = true;
+            mPeerPskId.clear();
+            mAuthName.clear();
+            unsigned char theKey[PSK_MAX_PSK_LEN];
+            const unsigned long theLen = mServerPskPtr->GetPsk(
+                theIdentityPtr, theKey, sizeof(theKey), mAuthName);
+            OPENSSL_cleanse(theKey, sizeof(theKey));
+            return (0 < theLen);
+        }
+        if (theIdentityPtr && ! mPskData.empty()) {
+            unsigned char theKey[PSK_MAX_PSK_LEN];
+            const unsigned int theLen =
+                PskSetServer(theIdentityPtr, theKey, sizeof(theKey));
+            OPENSSL_cleanse(theKey, sizeof(theKey));
+            return (0 < theLen);
+        }
+#endif
         string      thePeerName;
         X509* const theCertPtr       = SSL_get_peer_certificate(mSslPtr);
         int64_t     theTime          = 0;
@@ -1027,6 +1296,43 @@ private:
             theTimeValidFlag
         );
     }
+    bool IsKtlsEnabled() const
+    {
+#ifdef KFS_SSL_KTLS
+        return ((SSL_get_options(mSslPtr) & SSL_OP_ENABLE_KTLS) != 0);
+#else
+        return false;
+#endif
+    }
+    bool IsKtlsActive() const
+    {
+#ifdef KFS_SSL_KTLS
+        BIO* theBioPtr;
+        return (
+            ((theBioPtr = SSL_get_wbio(mSslPtr)) &&
+                BIO_get_ktls_send(theBioPtr)) ||
+            ((theBioPtr = SSL_get_rbio(mSslPtr)) &&
+                BIO_get_ktls_recv(theBioPtr))
+        );
+#else
+        return false;
+#endif
+    }
+    void UpdateKtlsSend()
+    {
+        if (mKtlsSendFlag || ! IsKtlsEnabled()) {
+            return;
+        }
+        BIO* const theBioPtr = SSL_get_wbio(mSslPtr);
+        mKtlsSendFlag = theBioPtr && BIO_get_ktls_send(theBioPtr);
+        if (mKtlsSendFlag) {
+            KFS_LOG_STREAM_DEBUG <<
+                "ssl: " << (mServerFlag ? "server" : "client") <<
+                " kernel tls send enabled, receive: " <<
+                    (theBioPtr && BIO_get_ktls_recv(SSL_get_rbio(mSslPtr))) <<
+            KFS_LOG_EOM;
+        }
+    }
     int DoHandshake()
     {
         if (SSL_is_init_finished(mSslPtr)) {
@@ -1036,6 +1342,7 @@ private:
             if (! mServerFlag && ! mSessionStoredFlag) {
                 StoreClientSession();
             }
+            UpdateKtlsSend();
             return 0;
         }
         if (mRenegotiationPendingFlag) {
@@ -1049,6 +1356,7 @@ private:
             }
             // Try to update in case of renegotiation.
             StoreClientSession();
+            UpdateKtlsSend();
             return 0;
         }
         const int theErr = SslRetToErr(theRet);
@@ -1107,6 +1415,15 @@ private:
         if (SSL_get_verify_result(mSslPtr) != X509_V_OK) {
             return;
         }
+        ClientSessions* const theSessionsPtr = GetClientSessions();
+        if (theSessionsPtr) {
+            SSL_SESSION* const theCurPtr = SSL_get1_session(mSslPtr);
+            if (theCurPtr) {
+                QCStMutexLocker theLock(sOpenSslInitPtr->mSessionUpdateMutex);
+                theSessionsPtr->Set(mSessionResumeKey, theCurPtr);
+            }
+            return;
+        }
         SSL_SESSION* const theCurSessionPtr = SSL_get_session(mSslPtr);
         if (! theCurSessionPtr || ! theCurSessionPtr->peer) {
             // Do not store session with no peer certificate, i.e. PSK sessions.
@@ -1144,6 +1461,16 @@ private:
             }
         }
     }
+    ClientSessions* GetClientSessions() const
+    {
+        if (mSessionResumeKey.empty()) {
+            return 0;
+        }
+        return reinterpret_cast<ClientSessions*>(SSL_CTX_get_ex_data(
+            SSL_get_SSL_CTX(mSslPtr),
+            sOpenSslInitPtr->mExDataClientSessionsIdx
+        ));
+    }
     void SetStoredClientSession()
     {
         if (mServerFlag) {
@@ -1151,6 +1478,15 @@ private:
         }
         QCASSERT(mSslPtr && sOpenSslInitPtr);
         QCStMutexLocker theLock(sOpenSslInitPtr->mSessionUpdateMutex);
+        ClientSessions* const theSessionsPtr = GetClientSessions();
+        if (theSessionsPtr) {
+            SSL_SESSION* const thePtr =
+                theSessionsPtr->Get(mSessionResumeKey, time(0));
+            if (thePtr) {
+                SSL_set_session(mSslPtr, thePtr);
+            }
+            return;
+        }
         SSL_SESSION* const thePtr = reinterpret_cast<SSL_SESSION*>(
             SSL_CTX_get_ex_data(
                 SSL_get_SSL_CTX(mSslPtr),
@@ -1195,8 +1531,20 @@ private:
         if (! SSL_is_init_finished(mSslPtr)) {
             // Always run full handshake.
             // Wait for handshake to complete, then issue shutdown.
+            DisableKtls();
             return 0;
         }
+        if (IsKtlsActive()) {
+            // The kernel continues to encrypt and decrypt the socket data
+            // after ssl shutdown, therefore the connection cannot be used in
+            // clear text.
+            KFS_LOG_STREAM_ERROR <<
+                "ssl: " << (mServerFlag ? "server" : "client") <<
+                " shutdown is not supported with kernel tls" <<
+            KFS_LOG_EOM;
+            mSslErrorFlag = true;
+            return -EINVAL;
+        }
         int theRet = SSL_shutdown(mSslPtr);
         if (theRet == 0) {
             // Call shutdown again to initiate read state, if the shutdown call
@@ -1431,6 +1779,19 @@ SslFilter::SetPsk(
     mImpl.SetPsk(inPskDataPtr, inPskDataLen);
 }
 
+    void
+SslFilter::SetSessionResumeKey(
+    const string& inKey)
+{
+    mImpl.SetSessionResumeKey(inKey);
+}
+
+    void
+SslFilter::DisableKtls()
+{
+    mImpl.DisableKtls();
+}
+
     SslFilter::Error
 SslFilter::GetError() const
 {
@@ -1511,6 +1872,18 @@ SslFilter::IsHandshakeDone() const
     return mImpl.IsHandshakeDone();
 }
 
+    bool
+SslFilter::IsSessionReused() const
+{
+    return mImpl.IsSessionReused();
+}
+
+    /* virtual */ bool
+SslFilter::IsWriteThrough() const
+{
+    return mImpl.IsWriteThrough();
+}
+
     string
 SslFilter::GetAuthName() const
 {
@@ -131,6 +131,17 @@ public:
     void SetPsk(
         const char* inPskDataPtr,
         size_t      inPskDataLen);
+    // Client side session resume key. Must be set before attaching the filter
+    // to the connection. Sessions are resumed only with ssl contexts that
+    // have session resume enabled.
+    void SetSessionResumeKey(
+        const string& inKey);
+    // Kernel tls cannot be turned off once the handshake installs it, and the
+    // connection cannot continue in clear text after ssl shutdown. Must be
+    // invoked before attaching the filter to the connection that might be
+    // shut down, in order to exclude the ciphers that kernel tls supports,
+    // and prevent the peer from installing kernel tls.
+    void DisableKtls();
     virtual ~SslFilter();
     virtual bool WantRead(
         const NetConnection& inConnection) const;
@@ -165,7 +176,9 @@ public:
     virtual int GetErrorCode() const;
     virtual bool IsShutdownReceived() const;
     virtual string GetPeerId() const;
+    virtual bool IsWriteThrough() const;
     bool IsHandshakeDone() const;
+    bool IsSessionReused() const;
     static bool GetCtxX509EndTime(
         Ctx&     inCtx,
         int64_t& outEndTime);
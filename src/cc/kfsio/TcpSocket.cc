@@ -261,7 +261,8 @@ TcpSocket::StartListening(bool nonBlockingAccept, int maxQueue)
 }
 
 int
-TcpSocket::Bind(const ServerLocation& location, Type type, bool ipV6OnlyFlag)
+TcpSocket::Bind(const ServerLocation& location, Type type, bool ipV6OnlyFlag,
+    bool reusePortFlag /* = false */)
 {
     Close();
     if (sMaxOpenSockets <= globals().ctrOpenNetFds.GetValue()) {
@@ -297,6 +298,15 @@ TcpSocket::Bind(const ServerLocation& location, Type type, bool ipV6OnlyFlag)
     if (SetSockOpt(mSockFd, SOL_SOCKET, SO_REUSEADDR, flag)) {
         Perror("setsockopt SO_REUSEADDR");
     }
+    if (reusePortFlag) {
+#ifdef SO_REUSEPORT
+        if (SetSockOpt(mSockFd, SOL_SOCKET, SO_REUSEPORT, flag)) {
+            return PerrorFatal("setsockopt SO_REUSEPORT");
+        }
+#else
+        return PerrorFatal("setsockopt SO_REUSEPORT", ENOTSUP);
+#endif
+    }
     if (bind(mSockFd, addr.Ptr(), addr.Size())) {
         return PerrorFatal(addr);
     }
@@ -549,6 +559,40 @@ TcpSocket::GetSocketError() const
     return err;
 }
 
+int
+TcpSocket::GetIncomingCpu() const
+{
+#ifdef SO_INCOMING_CPU
+    if (mSockFd < 0) {
+        return -EBADF;
+    }
+    int       cpu = -1;
+    socklen_t len = sizeof(cpu);
+    if (getsockopt(mSockFd, SOL_SOCKET, SO_INCOMING_CPU, &cpu, &len)) {
+        return -(errno != 0 ? errno : EINVAL);
+    }
+    return cpu;
+#else
+    return -ENOTSUP;
+#endif
+}
+
+int
+TcpSocket::SetIncomingCpu(int cpu)
+{
+#ifdef SO_INCOMING_CPU
+    if (mSockFd < 0) {
+        return -EBADF;
+    }
+    if (SetSockOpt(mSockFd, SOL_SOCKET, SO_INCOMING_CPU, cpu)) {
+        return Perror("setsockopt SO_INCOMING_CPU");
+    }
+    return 0;
+#else
+    return -ENOTSUP;
+#endif
+}
+
 string
 TcpSocket::ToString(const Address& saddr)
 {
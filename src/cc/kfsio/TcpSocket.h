@@ -62,7 +62,10 @@ public:
     ~TcpSocket();
 
     /// Setup and bind TCP socket to the port specified.
-    int Bind(const ServerLocation& location, Type type, bool ipV6OnlyFlag);
+    /// With reusePortFlag set SO_REUSEPORT is used, in order to allow
+    /// multiple listening sockets to bind to the same port.
+    int Bind(const ServerLocation& location, Type type, bool ipV6OnlyFlag,
+        bool reusePortFlag = false);
 
     /// Start listening;
     int StartListening(bool nonBlockingAccept, int maxQueue = 8192);
@@ -114,6 +117,10 @@ public:
     int Shutdown() { return Shutdown(true, true); }
     /// Get and clear pending socket error: getsockopt(SO_ERROR)
     int GetSocketError() const;
+    /// Get / set cpu that processes the socket receive: SO_INCOMING_CPU.
+    /// Returns negative value on error or if not supported.
+    int GetIncomingCpu() const;
+    int SetIncomingCpu(int cpu);
     Type GetType() const { return mType; }
     static int Validate(const string& address);
     static int GetDefaultRecvBufSize() { return sRecvBufSize; }
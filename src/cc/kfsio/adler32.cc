@@ -0,0 +1,71 @@
+//---------------------------------------------------------- -*- Mode: C++ -*-
+// $Id$
+//
+// Created 2026/10/16
+//
+// Copyright 2026 Quantcast Corp.
+//
+// This file is part of Kosmos File System (KFS).
+//
+// Licensed under the Apache License, Version 2.0
+// (the "License"); you may not use this file except in compliance with
+// the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+//
+// Adler32 run time implementation selection.
+//
+//----------------------------------------------------------------------------
+
+#include "adler32.h"
+
+#include <zlib.h>
+
+namespace KFS
+{
+
+static uint32_t
+Adler32UpdateZlib(uint32_t adler, const unsigned char* buf, size_t len)
+{
+    return (uint32_t)adler32(adler, buf, len);
+}
+
+class Adler32Impl
+{
+public:
+    typedef uint32_t (*UpdateFunc)(uint32_t, const unsigned char*, size_t);
+
+    Adler32Impl()
+        : mUpdate(&Adler32UpdateZlib)
+    {
+#if defined(KFS_ADLER32_USE_AVX2)
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2")) {
+            mUpdate = &Adler32UpdateAvx2;
+        }
+#endif
+    }
+    UpdateFunc mUpdate;
+};
+
+// Initialized before main(), and before any threads are started.
+static const Adler32Impl sAdler32Impl;
+
+uint32_t
+Adler32Update(uint32_t adler, const void* buf, size_t len)
+{
+    const unsigned char* const p = reinterpret_cast<const unsigned char*>(buf);
+    // Handle invocation from other static constructors.
+    return (sAdler32Impl.mUpdate ?
+        (*sAdler32Impl.mUpdate)(adler, p, len) :
+        Adler32UpdateZlib(adler, p, len)
+    );
+}
+
+}
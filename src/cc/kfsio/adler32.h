@@ -0,0 +1,46 @@
+//---------------------------------------------------------- -*- Mode: C++ -*-
+// $Id$
+//
+// Created 2026/10/16
+//
+// Copyright 2026 Quantcast Corp.
+//
+// This file is part of Kosmos File System (KFS).
+//
+// Licensed under the Apache License, Version 2.0
+// (the "License"); you may not use this file except in compliance with
+// the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+//
+// Adler32 checksum with simd implementation selected at run time. The
+// results are identical to zlib adler32().
+//
+//----------------------------------------------------------------------------
+
+#ifndef KFSIO_ADLER32_H
+#define KFSIO_ADLER32_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+namespace KFS
+{
+
+/// Returns updated checksum, the checksum of an empty buffer is 1.
+uint32_t Adler32Update(uint32_t adler, const void* buf, size_t len);
+
+// Internal interface between the portable and the instruction set specific
+// implementations.
+uint32_t Adler32UpdateAvx2(uint32_t adler, const unsigned char* buf,
+    size_t len);
+
+}
+
+#endif /* KFSIO_ADLER32_H */
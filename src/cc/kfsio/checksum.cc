@@ -21,11 +21,13 @@
 // implied. See the License for the specific language governing
 // permissions and limitations under the License.
 //
-// An adaptation of the 32-bit Adler checksum algorithm
+// An adaptation of the 32-bit Adler checksum algorithm, and CRC32C
 //
 //----------------------------------------------------------------------------
 
 #include "checksum.h"
+#include "adler32.h"
+#include "crc32c.h"
 
 #include <algorithm>
 #include <vector>
@@ -39,9 +41,13 @@ using std::vector;
 using std::list;
 
 static inline uint32_t
-KfsChecksum(uint32_t chksum, const void* buf, size_t len)
+KfsChecksum(uint32_t chksum, const void* buf, size_t len,
+    KfsChecksumType type = kKfsChecksumTypeAdler32)
 {
-    return adler32(chksum, reinterpret_cast<const Bytef*>(buf), len);
+    return (type == kKfsChecksumTypeCrc32c ?
+        Crc32cUpdate(chksum, buf, len) :
+        Adler32Update(chksum, buf, len)
+    );
 }
 
 #ifndef _KFS_NO_ADDLER32_COMBINE
@@ -83,8 +89,12 @@ bug_fix_for_adler32_combine(uint32_t adler1, uint32_t adler2, int64_t len2)
 #endif
 
 static inline uint32_t
-KfsChecksumCombine(uint32_t chksum1, uint32_t chksum2, size_t len2)
+KfsChecksumCombine(uint32_t chksum1, uint32_t chksum2, size_t len2,
+    KfsChecksumType type = kKfsChecksumTypeAdler32)
 {
+    if (type == kKfsChecksumTypeCrc32c) {
+        return Crc32cCombine(chksum1, chksum2, len2);
+    }
 #ifndef _KFS_NO_ADDLER32_COMBINE
     return bug_fix_for_adler32_combine(chksum1, chksum2, (int64_t)len2);
 #else
@@ -93,9 +103,10 @@ KfsChecksumCombine(uint32_t chksum1, uint32_t chksum2, size_t len2)
 }
 
 uint32_t
-ChecksumBlocksCombine(uint32_t chksum1, uint32_t chksum2, size_t len2)
+ChecksumBlocksCombine(uint32_t chksum1, uint32_t chksum2, size_t len2,
+    KfsChecksumType type)
 {
-    return KfsChecksumCombine(chksum1, chksum2, len2);
+    return KfsChecksumCombine(chksum1, chksum2, len2, type);
 }
 
 uint32_t
@@ -119,24 +130,26 @@ OffsetToChecksumBlockEnd(off_t offset)
 }
 
 uint32_t
-ComputeBlockChecksum(const char* buf, size_t len)
+ComputeBlockChecksum(const char* buf, size_t len, KfsChecksumType type)
 {
-    return KfsChecksum(kKfsNullChecksum, buf, len);
+    return KfsChecksum(KfsNullChecksum(type), buf, len, type);
 }
 
 uint32_t
-ComputeBlockChecksum(uint32_t ckhsum, const char* buf, size_t len)
+ComputeBlockChecksum(uint32_t ckhsum, const char* buf, size_t len,
+    KfsChecksumType type)
 {
-    return KfsChecksum(ckhsum, buf, len);
+    return KfsChecksum(ckhsum, buf, len, type);
 }
 
 vector<uint32_t>
-ComputeChecksums(const char* buf, size_t len, uint32_t* chksum)
+ComputeChecksums(const char* buf, size_t len, uint32_t* chksum,
+    KfsChecksumType type)
 {
     vector <uint32_t> cksums;
 
     if (len <= CHECKSUM_BLOCKSIZE) {
-        uint32_t cks = ComputeBlockChecksum(buf, len);
+        uint32_t cks = ComputeBlockChecksum(buf, len, type);
         if (chksum) {
             *chksum = cks;
         }
@@ -144,15 +157,15 @@ ComputeChecksums(const char* buf, size_t len, uint32_t* chksum)
         return cksums;
     }
     if (chksum) {
-        *chksum = kKfsNullChecksum;
+        *chksum = KfsNullChecksum(type);
     }
     cksums.reserve((len + CHECKSUM_BLOCKSIZE - 1) / CHECKSUM_BLOCKSIZE);
     size_t curr = 0;
     while (curr < len) {
         const size_t   tlen = min((size_t) CHECKSUM_BLOCKSIZE, len - curr);
-        const uint32_t cks  = ComputeBlockChecksum(buf + curr, tlen);
+        const uint32_t cks  = ComputeBlockChecksum(buf + curr, tlen, type);
         if (chksum) {
-            *chksum = KfsChecksumCombine(*chksum, cks, tlen);
+            *chksum = KfsChecksumCombine(*chksum, cks, tlen, type);
         }
         cksums.push_back(cks);
         curr += tlen;
@@ -161,7 +174,14 @@ ComputeChecksums(const char* buf, size_t len, uint32_t* chksum)
 }
 
 uint32_t
-ComputeBlockChecksum(const IOBuffer* data, size_t len, uint32_t chksum)
+ComputeBlockChecksum(const IOBuffer* data, size_t len, KfsChecksumType type)
+{
+    return ComputeBlockChecksum(data, len, KfsNullChecksum(type), type);
+}
+
+uint32_t
+ComputeBlockChecksum(const IOBuffer* data, size_t len, uint32_t chksum,
+    KfsChecksumType type)
 {
     uint32_t res = chksum;
     for (IOBuffer::iterator iter = data->begin();
@@ -170,7 +190,7 @@ ComputeBlockChecksum(const IOBuffer* data, size_t len, uint32_t chksum)
         if (tlen == 0) {
             continue;
         }
-        res = KfsChecksum(res, iter->Consumer(), tlen);
+        res = KfsChecksum(res, iter->Consumer(), tlen, type);
         len -= tlen;
     }
     return res;
@@ -178,7 +198,15 @@ ComputeBlockChecksum(const IOBuffer* data, size_t len, uint32_t chksum)
 
 uint32_t
 ComputeBlockChecksumAt(
-    const IOBuffer* data, int pos, size_t len, uint32_t chksum)
+    const IOBuffer* data, int pos, size_t len, KfsChecksumType type)
+{
+    return ComputeBlockChecksumAt(data, pos, len, KfsNullChecksum(type), type);
+}
+
+uint32_t
+ComputeBlockChecksumAt(
+    const IOBuffer* data, int pos, size_t len, uint32_t chksum,
+    KfsChecksumType type)
 {
     IOBuffer::iterator const end = data->end();
     IOBuffer::iterator       it  = data->begin();
@@ -188,7 +216,7 @@ ComputeBlockChecksumAt(
         const int nb = it->BytesConsumable();
         if (rem < nb) {
             const size_t sz = min((size_t)(nb - rem), l);
-            res = KfsChecksum(res, it->Consumer() + rem, sz);
+            res = KfsChecksum(res, it->Consumer() + rem, sz, type);
             l -= sz;
             rem = 0;
         } else if (nb > 0) {
@@ -200,11 +228,15 @@ ComputeBlockChecksumAt(
 
 void
 AppendToChecksumVector(const IOBuffer& data, size_t inlen,
-    uint32_t* chksum, size_t firstBlockLen, vector<uint32_t>& cksums)
+    uint32_t* chksum, size_t firstBlockLen, vector<uint32_t>& cksums,
+    KfsChecksumType type)
 {
-    size_t len = min(inlen, size_t(max(0, data.BytesConsumable())));
+    const uint32_t nullChecksum = KfsNullChecksum(type);
+    size_t         len          =
+        min(inlen, size_t(max(0, data.BytesConsumable())));
     if (len <= firstBlockLen) {
-        const uint32_t cks = ComputeBlockChecksum(&data, len);
+        const uint32_t cks = ComputeBlockChecksum(
+            &data, len, nullChecksum, type);
         if (chksum) {
             *chksum = cks;
         }
@@ -212,7 +244,7 @@ AppendToChecksumVector(const IOBuffer& data, size_t inlen,
         return;
     }
     if (chksum) {
-        *chksum = kKfsNullChecksum;
+        *chksum = nullChecksum;
     }
     IOBuffer::iterator iter = data.begin();
     if (iter == data.end()) {
@@ -225,7 +257,7 @@ AppendToChecksumVector(const IOBuffer& data, size_t inlen,
     size_t rem = firstBlockLen;
     while (0 < len && iter != data.end()) {
         size_t   currLen = 0;
-        uint32_t res     = kKfsNullChecksum;
+        uint32_t res     = nullChecksum;
         while (currLen < rem) {
             size_t navail = min((size_t) (iter->Producer() - buf), len);
             if (currLen + navail > rem) {
@@ -241,11 +273,11 @@ AppendToChecksumVector(const IOBuffer& data, size_t inlen,
             }
             currLen += navail;
             len -= navail;
-            res = KfsChecksum(res, buf, navail);
+            res = KfsChecksum(res, buf, navail, type);
             buf += navail;
         }
         if (chksum) {
-            *chksum = KfsChecksumCombine(*chksum, res, currLen);
+            *chksum = KfsChecksumCombine(*chksum, res, currLen, type);
         }
         cksums.push_back(res);
         rem = CHECKSUM_BLOCKSIZE;
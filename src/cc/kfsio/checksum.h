@@ -21,7 +21,7 @@
 // implied. See the License for the specific language governing
 // permissions and limitations under the License.
 //
-// Code for computing 32-bit Adler checksums
+// Code for computing 32-bit Adler and CRC32C checksums
 //----------------------------------------------------------------------------
 
 #ifndef CHUNKSERVER_CHECKSUM_H
@@ -36,38 +36,71 @@ namespace KFS
 using std::vector;
 
 /// Checksums are computed on 64KB block boundaries.  We use the
-/// "rolling" 32-bit Adler checksum algorithm
+/// "rolling" 32-bit Adler checksum algorithm, or CRC32C.
 const uint32_t CHECKSUM_BLOCKSIZE = 65536;
 const uint32_t kKfsNullChecksum   = 1;
 
+/// The checksum algorithm id is stored in the chunk header, and passed with
+/// the checksums over the wire. Adler32 is the default, and the only
+/// algorithm known to the prior versions.
+enum KfsChecksumType
+{
+    kKfsChecksumTypeAdler32 = 0,
+    kKfsChecksumTypeCrc32c  = 1,
+    kKfsChecksumTypeCount
+};
+
+inline static bool IsValidChecksumType(int type)
+{
+    return (kKfsChecksumTypeAdler32 <= type && type < kKfsChecksumTypeCount);
+}
+
+/// Checksum of an empty buffer.
+inline static uint32_t KfsNullChecksum(KfsChecksumType type)
+{
+    return (type == kKfsChecksumTypeCrc32c ? 0 : kKfsNullChecksum);
+}
+
 uint32_t OffsetToChecksumBlockNum(off_t offset);
 uint32_t OffsetToChecksumBlockStart(off_t offset);
 uint32_t OffsetToChecksumBlockEnd(off_t offset);
-uint32_t ChecksumBlocksCombine(uint32_t chksum1, uint32_t chksum2, size_t len2);
+uint32_t ChecksumBlocksCombine(uint32_t chksum1, uint32_t chksum2, size_t len2,
+    KfsChecksumType type = kKfsChecksumTypeAdler32);
 
 /// Call this function if you want checksum computed over CHECKSUM_BLOCKSIZE
-/// bytes
+/// bytes. The checksum starts from KfsNullChecksum(type), the overloads with
+/// the initial checksum require the type the initial checksum was computed
+/// with.
 uint32_t ComputeBlockChecksum(const IOBuffer* data, size_t len,
-    uint32_t chksum = kKfsNullChecksum);
+    KfsChecksumType type = kKfsChecksumTypeAdler32);
+uint32_t ComputeBlockChecksum(const IOBuffer* data, size_t len,
+    uint32_t chksum, KfsChecksumType type);
+uint32_t ComputeBlockChecksumAt(const IOBuffer* data, int pos, size_t len,
+    KfsChecksumType type = kKfsChecksumTypeAdler32);
 uint32_t ComputeBlockChecksumAt(const IOBuffer* data, int pos, size_t len,
-    uint32_t chksum = kKfsNullChecksum);
-uint32_t ComputeBlockChecksum(const char* data, size_t len);
-uint32_t ComputeBlockChecksum(uint32_t ckhsum, const char* buf, size_t len);
+    uint32_t chksum, KfsChecksumType type);
+uint32_t ComputeBlockChecksum(const char* data, size_t len,
+    KfsChecksumType type = kKfsChecksumTypeAdler32);
+uint32_t ComputeBlockChecksum(uint32_t ckhsum, const char* buf, size_t len,
+    KfsChecksumType type = kKfsChecksumTypeAdler32);
 
 /// Call this function if you want a checksums for a sequence of
 /// CHECKSUM_BLOCKSIZE bytes
 void AppendToChecksumVector(const IOBuffer& data, size_t len,
-    uint32_t* chksum, size_t firstBlockLen, vector<uint32_t>& vec);
+    uint32_t* chksum, size_t firstBlockLen, vector<uint32_t>& vec,
+    KfsChecksumType type = kKfsChecksumTypeAdler32);
 
 inline static vector<uint32_t> ComputeChecksums(const IOBuffer* data, size_t len,
-    uint32_t* chksum = 0, size_t firstBlockLen = CHECKSUM_BLOCKSIZE)
+    uint32_t* chksum = 0, size_t firstBlockLen = CHECKSUM_BLOCKSIZE,
+    KfsChecksumType type = kKfsChecksumTypeAdler32)
 {
     vector<uint32_t> ret;
-    AppendToChecksumVector(*data, len, chksum, firstBlockLen, ret);
+    AppendToChecksumVector(*data, len, chksum, firstBlockLen, ret, type);
     return ret;
 }
 vector<uint32_t> ComputeChecksums(
-    const char* data, size_t len, uint32_t* chksum = 0);
+    const char* data, size_t len, uint32_t* chksum = 0,
+    KfsChecksumType type = kKfsChecksumTypeAdler32);
 
 uint32_t ComputeCrc32(const char* data, size_t len, uint32_t cchksum = 0);
 
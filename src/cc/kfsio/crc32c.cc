@@ -0,0 +1,237 @@
+//---------------------------------------------------------- -*- Mode: C++ -*-
+// $Id$
+//
+// Created 2026/10/16
+//
+// Copyright 2026 Quantcast Corp.
+//
+// This file is part of Kosmos File System (KFS).
+//
+// Licensed under the Apache License, Version 2.0
+// (the "License"); you may not use this file except in compliance with
+// the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+//
+// CRC32C (Castagnoli) checksum: table driven implementation, crc combine,
+// and run time selection of the crc32 instruction implementation.
+//
+//----------------------------------------------------------------------------
+
+#include "crc32c.h"
+
+#include <string.h>
+
+#if defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+#   include <arm_acle.h>
+#   define KFS_CRC32C_USE_ARMV8
+#endif
+
+namespace KFS
+{
+
+// Reflected Castagnoli polynomial.
+const uint32_t kCrc32cPoly = 0x82F63B78;
+
+class Crc32cTables
+{
+public:
+    Crc32cTables()
+        : mRawUpdate(0)
+        { Init(); }
+    void Init()
+    {
+        for (int i = 0; i < 256; i++) {
+            uint32_t crc = (uint32_t)i;
+            for (int k = 0; k < 8; k++) {
+                crc = (crc & 1) ? (crc >> 1) ^ kCrc32cPoly : crc >> 1;
+            }
+            mTable[0][i] = crc;
+        }
+        for (int i = 0; i < 256; i++) {
+            for (int k = 1; k < 8; k++) {
+                mTable[k][i] = (mTable[k - 1][i] >> 8) ^
+                    mTable[0][mTable[k - 1][i] & 0xFF];
+            }
+        }
+        // x^(2^k) mod p, x2n[0] = x.
+        mX2n[0] = uint32_t(1) << 30;
+        for (int k = 1; k < 64; k++) {
+            mX2n[k] = MultModP(mX2n[k - 1], mX2n[k - 1]);
+        }
+        // Multiplication by x^(8 * kCrc32cLaneSize) is linear, tabulate it
+        // byte by byte, in order to make combining the lanes cheap.
+        const uint32_t lane = X2nModP(kCrc32cLaneSize, 3);
+        for (int k = 0; k < 4; k++) {
+            for (int i = 0; i < 256; i++) {
+                mLaneShift[k][i] = MultModP(lane, uint32_t(i) << (8 * k));
+            }
+        }
+        mRawUpdate = &RawUpdateSw;
+#if defined(KFS_CRC32C_USE_SSE42)
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("sse4.2")) {
+            mRawUpdate = &Crc32cRawUpdateSse42;
+        }
+#elif defined(KFS_CRC32C_USE_ARMV8)
+        mRawUpdate = &RawUpdateArmV8;
+#endif
+    }
+    uint32_t MultModP(uint32_t a, uint32_t b) const
+    {
+        uint32_t m = uint32_t(1) << 31;
+        uint32_t p = 0;
+        for (; ;) {
+            if ((a & m) != 0) {
+                p ^= b;
+                if ((a & (m - 1)) == 0) {
+                    break;
+                }
+            }
+            m >>= 1;
+            b = (b & 1) ? (b >> 1) ^ kCrc32cPoly : b >> 1;
+        }
+        return p;
+    }
+    uint32_t X2nModP(uint64_t n, int k) const
+    {
+        uint32_t p = uint32_t(1) << 31; // x^0
+        while (n != 0) {
+            if ((n & 1) != 0) {
+                p = MultModP(mX2n[k & 63], p);
+            }
+            n >>= 1;
+            k++;
+        }
+        return p;
+    }
+    uint32_t ShiftLane(uint32_t crc) const
+    {
+        return (
+            mLaneShift[0][crc & 0xFF] ^
+            mLaneShift[1][(crc >> 8) & 0xFF] ^
+            mLaneShift[2][(crc >> 16) & 0xFF] ^
+            mLaneShift[3][crc >> 24]
+        );
+    }
+    uint32_t RawUpdate(uint32_t crc, const unsigned char* buf, size_t len) const
+        { return (*mRawUpdate)(crc, buf, len); }
+    static uint32_t RawUpdateSw(
+        uint32_t crc, const unsigned char* buf, size_t len);
+#if defined(KFS_CRC32C_USE_ARMV8)
+    static uint32_t RawUpdateArmV8(
+        uint32_t crc, const unsigned char* buf, size_t len);
+#endif
+private:
+    Crc32cRawUpdateFunc mRawUpdate;
+    uint32_t            mTable[8][256];
+    uint32_t            mX2n[64];
+    uint32_t            mLaneShift[4][256];
+};
+
+// Initialized before main(), and before any threads are started.
+static const Crc32cTables sCrc32cTables;
+
+    /* static */ uint32_t
+Crc32cTables::RawUpdateSw(uint32_t crc, const unsigned char* buf, size_t len)
+{
+    const uint32_t (&t)[8][256] = sCrc32cTables.mTable;
+    while (0 < len && ((size_t)buf & 7) != 0) {
+        crc = (crc >> 8) ^ t[0][(crc ^ *buf++) & 0xFF];
+        len--;
+    }
+    // Slicing by 8.
+    while (8 <= len) {
+        uint32_t lo;
+        uint32_t hi;
+        memcpy(&lo, buf, sizeof(lo));
+        memcpy(&hi, buf + 4, sizeof(hi));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+        lo = __builtin_bswap32(lo);
+        hi = __builtin_bswap32(hi);
+#endif
+        lo ^= crc;
+        crc =
+            t[7][lo & 0xFF] ^ t[6][(lo >> 8) & 0xFF] ^
+            t[5][(lo >> 16) & 0xFF] ^ t[4][lo >> 24] ^
+            t[3][hi & 0xFF] ^ t[2][(hi >> 8) & 0xFF] ^
+            t[1][(hi >> 16) & 0xFF] ^ t[0][hi >> 24];
+        buf += 8;
+        len -= 8;
+    }
+    while (0 < len) {
+        crc = (crc >> 8) ^ t[0][(crc ^ *buf++) & 0xFF];
+        len--;
+    }
+    return crc;
+}
+
+#if defined(KFS_CRC32C_USE_ARMV8)
+
+    /* static */ uint32_t
+Crc32cTables::RawUpdateArmV8(
+    uint32_t crc, const unsigned char* buf, size_t len)
+{
+    while (0 < len && ((size_t)buf & 7) != 0) {
+        crc = __crc32cb(crc, *buf++);
+        len--;
+    }
+    // Three independent lanes hide the crc instruction latency.
+    while (3 * kCrc32cLaneSize <= len) {
+        uint32_t       crc1 = 0;
+        uint32_t       crc2 = 0;
+        const uint64_t* p   = reinterpret_cast<const uint64_t*>(buf);
+        const size_t    n   = kCrc32cLaneSize / 8;
+        for (size_t i = 0; i < n; i++) {
+            crc  = __crc32cd(crc,  p[i]);
+            crc1 = __crc32cd(crc1, p[i + n]);
+            crc2 = __crc32cd(crc2, p[i + 2 * n]);
+        }
+        crc = sCrc32cTables.ShiftLane(
+            sCrc32cTables.ShiftLane(crc) ^ crc1) ^ crc2;
+        buf += 3 * kCrc32cLaneSize;
+        len -= 3 * kCrc32cLaneSize;
+    }
+    while (8 <= len) {
+        uint64_t v;
+        memcpy(&v, buf, sizeof(v));
+        crc = __crc32cd(crc, v);
+        buf += 8;
+        len -= 8;
+    }
+    while (0 < len) {
+        crc = __crc32cb(crc, *buf++);
+        len--;
+    }
+    return crc;
+}
+
+#endif /* KFS_CRC32C_USE_ARMV8 */
+
+uint32_t
+Crc32cShiftLane(uint32_t crc)
+{
+    return sCrc32cTables.ShiftLane(crc);
+}
+
+uint32_t
+Crc32cUpdate(uint32_t crc, const void* buf, size_t len)
+{
+    return ~sCrc32cTables.RawUpdate(
+        ~crc, reinterpret_cast<const unsigned char*>(buf), len);
+}
+
+uint32_t
+Crc32cCombine(uint32_t crc1, uint32_t crc2, size_t len2)
+{
+    return (sCrc32cTables.MultModP(
+        sCrc32cTables.X2nModP(len2, 3), crc1) ^ crc2);
+}
+
+}
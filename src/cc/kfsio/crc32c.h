@@ -0,0 +1,54 @@
+//---------------------------------------------------------- -*- Mode: C++ -*-
+// $Id$
+//
+// Created 2026/10/16
+//
+// Copyright 2026 Quantcast Corp.
+//
+// This file is part of Kosmos File System (KFS).
+//
+// Licensed under the Apache License, Version 2.0
+// (the "License"); you may not use this file except in compliance with
+// the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+//
+// CRC32C (Castagnoli) checksum. The crc32 instruction is used if the cpu
+// supports it, with fall back to the table driven implementation.
+//
+//----------------------------------------------------------------------------
+
+#ifndef KFSIO_CRC32C_H
+#define KFSIO_CRC32C_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+namespace KFS
+{
+
+/// Returns updated crc, the crc of an empty buffer is 0, the same convention
+/// as zlib crc32().
+uint32_t Crc32cUpdate(uint32_t crc, const void* buf, size_t len);
+/// Returns crc of the concatenation of two buffers given their crcs.
+uint32_t Crc32cCombine(uint32_t crc1, uint32_t crc2, size_t len2);
+
+// Internal interface between the portable and the instruction set specific
+// implementations. The "raw" crc is the shift register state, i.e. without
+// pre and post conditioning.
+const size_t kCrc32cLaneSize = 1344;
+typedef uint32_t (*Crc32cRawUpdateFunc)(
+    uint32_t crc, const unsigned char* buf, size_t len);
+uint32_t Crc32cShiftLane(uint32_t crc);
+uint32_t Crc32cRawUpdateSse42(
+    uint32_t crc, const unsigned char* buf, size_t len);
+
+}
+
+#endif /* KFSIO_CRC32C_H */
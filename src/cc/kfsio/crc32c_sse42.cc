@@ -0,0 +1,87 @@
+//---------------------------------------------------------- -*- Mode: C++ -*-
+// $Id$
+//
+// Created 2026/10/16
+//
+// Copyright 2026 Quantcast Corp.
+//
+// This file is part of Kosmos File System (KFS).
+//
+// Licensed under the Apache License, Version 2.0
+// (the "License"); you may not use this file except in compliance with
+// the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+//
+// CRC32C with sse 4.2 crc32 instruction. This file is compiled with -msse4.2,
+// the code is only invoked if cpuid reports sse 4.2 support.
+//
+//----------------------------------------------------------------------------
+
+#include "crc32c.h"
+
+#include <string.h>
+#include <nmmintrin.h>
+
+namespace KFS
+{
+
+uint32_t
+Crc32cRawUpdateSse42(uint32_t crc, const unsigned char* buf, size_t len)
+{
+    while (0 < len && ((size_t)buf & 7) != 0) {
+        crc = _mm_crc32_u8(crc, *buf++);
+        len--;
+    }
+#if defined(__x86_64__)
+    // The crc32 instruction has 3 cycles latency and 1 cycle throughput,
+    // three independent lanes keep the pipeline full. The lane size is
+    // chosen for three lanes to fit into 4KB IOBuffer block.
+    while (3 * kCrc32cLaneSize <= len) {
+        uint64_t        crc0 = crc;
+        uint64_t        crc1 = 0;
+        uint64_t        crc2 = 0;
+        const uint64_t* p    = reinterpret_cast<const uint64_t*>(buf);
+        const size_t    n    = kCrc32cLaneSize / 8;
+        for (size_t i = 0; i < n; i++) {
+            crc0 = _mm_crc32_u64(crc0, p[i]);
+            crc1 = _mm_crc32_u64(crc1, p[i + n]);
+            crc2 = _mm_crc32_u64(crc2, p[i + 2 * n]);
+        }
+        crc = Crc32cShiftLane(
+            Crc32cShiftLane((uint32_t)crc0) ^ (uint32_t)crc1) ^
+            (uint32_t)crc2;
+        buf += 3 * kCrc32cLaneSize;
+        len -= 3 * kCrc32cLaneSize;
+    }
+    uint64_t crc64 = crc;
+    while (8 <= len) {
+        uint64_t v;
+        memcpy(&v, buf, sizeof(v));
+        crc64 = _mm_crc32_u64(crc64, v);
+        buf += 8;
+        len -= 8;
+    }
+    crc = (uint32_t)crc64;
+#endif
+    while (4 <= len) {
+        uint32_t v;
+        memcpy(&v, buf, sizeof(v));
+        crc = _mm_crc32_u32(crc, v);
+        buf += 4;
+        len -= 4;
+    }
+    while (0 < len) {
+        crc = _mm_crc32_u8(crc, *buf++);
+        len--;
+    }
+    return crc;
+}
+
+}
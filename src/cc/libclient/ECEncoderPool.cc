@@ -0,0 +1,224 @@
+//---------------------------------------------------------- -*- Mode: C++ -*-
+// $Id$
+//
+// Created 2026/10/16
+//
+// Copyright 2026 Quantcast Corp.
+//
+// This file is part of Kosmos File System (KFS).
+//
+// Licensed under the Apache License, Version 2.0
+// (the "License"); you may not use this file except in compliance with
+// the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+//
+// Erasure code encoder thread pool implementation.
+//
+//----------------------------------------------------------------------------
+
+#include "ECEncoderPool.h"
+
+#include "kfsio/NetManager.h"
+#include "common/MsgLogger.h"
+#include "qcdio/QCThread.h"
+#include "qcdio/QCUtils.h"
+#include "qcdio/qcstutils.h"
+#include "qcdio/qcdebug.h"
+
+namespace KFS
+{
+namespace client
+{
+
+class ECEncoderPool::Worker : public QCThread
+{
+public:
+    Worker()
+        : QCThread(),
+          mPoolPtr(0)
+        {}
+    virtual ~Worker()
+        {}
+    virtual void Run()
+    {
+        QCASSERT(mPoolPtr);
+        mPoolPtr->Run();
+    }
+    int Start(
+        ECEncoderPool& inPool)
+    {
+        const int kStackSize = 64 << 10;
+        mPoolPtr = &inPool;
+        return TryToStart(this, kStackSize, "ECEncoder");
+    }
+private:
+    ECEncoderPool* mPoolPtr;
+};
+
+ECEncoderPool::ECEncoderPool(
+    NetManager& inNetManager,
+    int         inThreadCount)
+    : ITimeout(),
+      mNetManager(inNetManager),
+      mThreadCount(inThreadCount < 0 ? 0 : inThreadCount),
+      mWorkersPtr(0),
+      mMutex(),
+      mWorkCond(),
+      mDoneCond(),
+      mRunFlag(false)
+{
+    JobList::Init(mQueue);
+    JobList::Init(mDoneQueue);
+}
+
+ECEncoderPool::~ECEncoderPool()
+{
+    ECEncoderPool::Stop();
+}
+
+int
+ECEncoderPool::Start()
+{
+    if (mRunFlag || mThreadCount <= 0) {
+        return 0;
+    }
+    SetTimeoutInterval(0);
+    mNetManager.RegisterTimeoutHandler(this);
+    mWorkersPtr = new Worker[mThreadCount];
+    mRunFlag    = true;
+    for (int i = 0; i < mThreadCount; i++) {
+        const int theErr = mWorkersPtr[i].Start(*this);
+        if (theErr != 0) {
+            KFS_LOG_STREAM_ERROR <<
+                "failed to start encoder thread: " << i <<
+                " error: " << QCUtils::SysError(theErr) <<
+            KFS_LOG_EOM;
+            Stop();
+            return theErr;
+        }
+    }
+    KFS_LOG_STREAM_DEBUG <<
+        "encoder threads: " << mThreadCount <<
+    KFS_LOG_EOM;
+    return 0;
+}
+
+void
+ECEncoderPool::Stop()
+{
+    if (! mWorkersPtr) {
+        return;
+    }
+    {
+        QCStMutexLocker theLock(mMutex);
+        mRunFlag = false;
+        mWorkCond.NotifyAll();
+    }
+    for (int i = 0; i < mThreadCount; i++) {
+        if (mWorkersPtr[i].IsStarted()) {
+            mWorkersPtr[i].Join();
+        }
+    }
+    delete [] mWorkersPtr;
+    mWorkersPtr = 0;
+    mNetManager.UnRegisterTimeoutHandler(this);
+    // All jobs must be waited for or completed by now.
+    QCRTASSERT(JobList::IsEmpty(mQueue) && JobList::IsEmpty(mDoneQueue));
+}
+
+void
+ECEncoderPool::Enqueue(
+    ECEncoderPool::Job& inJob)
+{
+    QCStMutexLocker theLock(mMutex);
+    QCRTASSERT(mRunFlag && inJob.mState == Job::kStateNone);
+    inJob.mState = Job::kStateQueued;
+    JobList::PushBack(mQueue, inJob);
+    mWorkCond.Notify();
+}
+
+void
+ECEncoderPool::Wait(
+    ECEncoderPool::Job& inJob)
+{
+    QCStMutexLocker theLock(mMutex);
+    switch (inJob.mState) {
+        case Job::kStateNone:
+            return;
+        case Job::kStateQueued:
+            // Not started yet, run the job in the calling thread instead of
+            // waiting for a pool thread.
+            JobList::Remove(mQueue, inJob);
+            inJob.mState = Job::kStateRunning;
+            {
+                QCStMutexUnlocker theUnlock(mMutex);
+                inJob.Run();
+            }
+            break;
+        case Job::kStateRunning:
+            while (inJob.mState == Job::kStateRunning) {
+                mDoneCond.Wait(mMutex);
+            }
+            QCASSERT(inJob.mState == Job::kStateDone);
+            JobList::Remove(mDoneQueue, inJob);
+            break;
+        case Job::kStateDone:
+            JobList::Remove(mDoneQueue, inJob);
+            break;
+    }
+    inJob.mState = Job::kStateNone;
+}
+
+void
+ECEncoderPool::Timeout()
+{
+    // Pop one job at a time, as job completion might invoke Wait() for the
+    // jobs that are in the done queue.
+    for (; ;) {
+        Job* theJobPtr;
+        {
+            QCStMutexLocker theLock(mMutex);
+            if (! (theJobPtr = JobList::PopFront(mDoneQueue))) {
+                break;
+            }
+            theJobPtr->mState = Job::kStateNone;
+        }
+        theJobPtr->Done();
+    }
+}
+
+void
+ECEncoderPool::Run()
+{
+    QCStMutexLocker theLock(mMutex);
+    for (; ;) {
+        while (mRunFlag && JobList::IsEmpty(mQueue)) {
+            mWorkCond.Wait(mMutex);
+        }
+        if (! mRunFlag) {
+            break;
+        }
+        Job& theJob = *JobList::PopFront(mQueue);
+        theJob.mState = Job::kStateRunning;
+        {
+            QCStMutexUnlocker theUnlock(mMutex);
+            theJob.Run();
+        }
+        theJob.mState = Job::kStateDone;
+        const bool theWakeupFlag = JobList::IsEmpty(mDoneQueue);
+        JobList::PushBack(mDoneQueue, theJob);
+        mDoneCond.NotifyAll();
+        if (theWakeupFlag) {
+            mNetManager.Wakeup();
+        }
+    }
+}
+
+}}
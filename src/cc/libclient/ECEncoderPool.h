@@ -0,0 +1,124 @@
+//---------------------------------------------------------- -*- Mode: C++ -*-
+// $Id$
+//
+// Created 2026/10/16
+//
+// Copyright 2026 Quantcast Corp.
+//
+// This file is part of Kosmos File System (KFS).
+//
+// Licensed under the Apache License, Version 2.0
+// (the "License"); you may not use this file except in compliance with
+// the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+//
+// Erasure code encoder thread pool. The striped writer uses the pool to
+// compute recovery stripes of the next stride, while the previous stride
+// is being sent to the chunk servers. Jobs run on the pool threads, and
+// completion is delivered on the net manager thread.
+//
+//----------------------------------------------------------------------------
+
+#ifndef KFS_LIBCLIENT_ECENCODERPOOL_H
+#define KFS_LIBCLIENT_ECENCODERPOOL_H
+
+#include "kfsio/ITimeout.h"
+#include "qcdio/QCMutex.h"
+#include "qcdio/QCDLList.h"
+
+namespace KFS
+{
+class NetManager;
+
+namespace client
+{
+
+class ECEncoderPool : public ITimeout
+{
+public:
+    class Job
+    {
+    public:
+        // Invoked by a pool thread, or by the thread invoking Wait().
+        virtual void Run() = 0;
+        // Invoked by the net manager thread once Run() completes, unless
+        // Wait() was invoked for the job.
+        virtual void Done() = 0;
+    protected:
+        Job()
+            : mState(kStateNone)
+            { List::Init(*this); }
+        virtual ~Job()
+            {}
+    private:
+        enum State
+        {
+            kStateNone    = 0,
+            kStateQueued  = 1,
+            kStateRunning = 2,
+            kStateDone    = 3
+        };
+        typedef QCDLListOp<Job, 0> List;
+
+        State mState;
+        Job*  mPrevPtr[1];
+        Job*  mNextPtr[1];
+
+        friend class ECEncoderPool;
+        friend class QCDLListOp<Job, 0>;
+    private:
+        Job(
+            const Job& inJob);
+        Job& operator=(
+            const Job& inJob);
+    };
+
+    ECEncoderPool(
+        NetManager& inNetManager,
+        int         inThreadCount);
+    virtual ~ECEncoderPool();
+    // Start and Stop must be invoked from the net manager thread.
+    int Start();
+    void Stop();
+    bool IsRunning() const
+        { return mRunFlag; }
+    int GetThreadCount() const
+        { return mThreadCount; }
+    void Enqueue(
+        Job& inJob);
+    // Wait for the job to complete. The job's Done() method is not
+    // invoked, the caller is responsible for handling job completion.
+    void Wait(
+        Job& inJob);
+    virtual void Timeout();
+private:
+    class Worker;
+    typedef QCDLList<Job, 0> JobList;
+
+    NetManager& mNetManager;
+    const int   mThreadCount;
+    Worker*     mWorkersPtr;
+    QCMutex     mMutex;
+    QCCondVar   mWorkCond;
+    QCCondVar   mDoneCond;
+    bool        mRunFlag;
+    Job*        mQueue[1];
+    Job*        mDoneQueue[1];
+
+    void Run();
+private:
+    ECEncoderPool(
+        const ECEncoderPool& inPool);
+    ECEncoderPool& operator=(
+        const ECEncoderPool& inPool);
+};
+}}
+
+#endif /* KFS_LIBCLIENT_ECENCODERPOOL_H */
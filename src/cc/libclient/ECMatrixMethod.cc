@@ -0,0 +1,428 @@
+//---------------------------------------------------------- -*- Mode: C++ -*-
+// $Id$
+//
+// Created 2026/10/16
+//
+// Copyright 2026 Quantcast Corp.
+//
+// This file is part of Kosmos File System (KFS).
+//
+// Licensed under the Apache License, Version 2.0
+// (the "License"); you may not use this file except in compliance with
+// the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+//
+// Coding matrix erasure code method base implementation.
+//
+//----------------------------------------------------------------------------
+
+#include "ECMatrixMethod.h"
+
+#include "qcrs/rs.h"
+
+#include "common/kfstypes.h"
+#include "common/kfsatomic.h"
+#include "common/StBuffer.h"
+#include "common/IntToString.h"
+
+#include "qcdio/QCUtils.h"
+#include "qcdio/qcstutils.h"
+#include "qcdio/qcdebug.h"
+
+#include <algorithm>
+
+#include <errno.h>
+
+namespace KFS
+{
+namespace client
+{
+
+using std::make_pair;
+using std::min;
+using std::sort;
+
+// Decode matrix for one erasure pattern: the indices of the stripes to
+// decode from, followed by target count x source count matrix.
+class ECMatrixMethod::XCoder::DecodeMatrix
+{
+public:
+    enum { kMaxCacheCount = 4 << 10 };
+
+    DecodeMatrix(
+        int inStripeCount,
+        int inTargetCount)
+        : mSourcesPtr(new int[inStripeCount]),
+          mMatrixPtr(new unsigned char[inStripeCount * inTargetCount]),
+          mSourceCount(0)
+        {}
+    ~DecodeMatrix()
+    {
+        delete [] mSourcesPtr;
+        delete [] mMatrixPtr;
+    }
+    int* const           mSourcesPtr;
+    unsigned char* const mMatrixPtr;
+    int                  mSourceCount;
+private:
+    DecodeMatrix(
+        const DecodeMatrix& inMatrix);
+    DecodeMatrix& operator=(
+        const DecodeMatrix& inMatrix);
+};
+
+ECMatrixMethod::XCoder::XCoder(
+    int inStripeCount,
+    int inRecoveryStripeCount)
+    : ECMethod::Encoder(),
+      ECMethod::Decoder(),
+      mStripeCount(inStripeCount),
+      mRecoveryStripeCount(inRecoveryStripeCount),
+      mMatrixPtr(new unsigned char[inStripeCount * inRecoveryStripeCount]),
+      mMutex(),
+      mDecodeMatrices(),
+      mRefCount(1),
+      mIt()
+{
+    List::Init(*this);
+}
+
+ECMatrixMethod::XCoder::~XCoder()
+{
+    for (DecodeMatrices::iterator theIt = mDecodeMatrices.begin();
+            theIt != mDecodeMatrices.end();
+            ++theIt) {
+        delete theIt->second;
+    }
+    delete [] mMatrixPtr;
+    mRefCount = -1000; // To catch double delete.
+}
+
+    int
+ECMatrixMethod::XCoder::GetRepairCoefficients(
+    int            inStripeCount,
+    int            inRecoveryStripeCount,
+    int            inStripeIdx,
+    int            inMissingCount,
+    int const*     inMissingStripesIdxPtr,
+    int*           outStripesIdxPtr,
+    unsigned char* outCoefficientsPtr) const
+{
+    if (! IsValid(inStripeCount, inRecoveryStripeCount)) {
+        return -1;
+    }
+    return rs_matrix_repair_matrix(
+        mStripeCount,
+        mRecoveryStripeCount,
+        mMatrixPtr,
+        inMissingCount,
+        inMissingStripesIdxPtr,
+        1,
+        &inStripeIdx,
+        outStripesIdxPtr,
+        outCoefficientsPtr
+    );
+}
+
+    int
+ECMatrixMethod::XCoder::Decode(
+    int        inStripeCount,
+    int        inRecoveryStripeCount,
+    int        inLength,
+    void**     inBuffersPtr,
+    int const* inMissingStripesIdxPtr)
+{
+    if (! IsValid(inStripeCount, inRecoveryStripeCount) ||
+            inLength < 0 || inLength % 16 != 0) {
+        return -EINVAL;
+    }
+    const int          theTotal = mStripeCount + mRecoveryStripeCount;
+    StBufferT<int, 32> theMissingBuf;
+    int* const         theMissingPtr = theMissingBuf.Resize(theTotal);
+    int                theMissingCnt = 0;
+    while (theMissingCnt < theTotal &&
+            0 <= inMissingStripesIdxPtr[theMissingCnt]) {
+        theMissingPtr[theMissingCnt] = inMissingStripesIdxPtr[theMissingCnt];
+        theMissingCnt++;
+    }
+    if (theMissingCnt <= 0 || inLength <= 0) {
+        return 0;
+    }
+    sort(theMissingPtr, theMissingPtr + theMissingCnt);
+    StBufferT<int, 16>   theTargetsBuf;
+    int* const           theTargetsPtr = theTargetsBuf.Resize(theMissingCnt);
+    StBufferT<void*, 16> theDstBuf;
+    void** const         theDstPtr     = theDstBuf.Resize(theMissingCnt);
+    int                  theTargetCnt  = 0;
+    for (int i = 0; i < theMissingCnt; i++) {
+        void* const thePtr = inBuffersPtr[theMissingPtr[i]];
+        if (thePtr) {
+            theTargetsPtr[theTargetCnt] = theMissingPtr[i];
+            theDstPtr[theTargetCnt]     = thePtr;
+            theTargetCnt++;
+        }
+    }
+    if (theTargetCnt <= 0) {
+        return 0;
+    }
+    DecodeMatrix*       theTmpPtr = 0;
+    const DecodeMatrix* theDecodePtr;
+    {
+        QCStMutexLocker theLocker(mMutex);
+        theDecodePtr = GetDecodeMatrix(
+            theMissingPtr, theMissingCnt,
+            theTargetsPtr, theTargetCnt,
+            inBuffersPtr, theTmpPtr);
+    }
+    if (! theDecodePtr) {
+        return -EIO;
+    }
+    StBufferT<void*, 64> theSrcBuf;
+    void** const         theSrcPtr =
+        theSrcBuf.Resize(theDecodePtr->mSourceCount);
+    for (int i = 0; i < theDecodePtr->mSourceCount; i++) {
+        if (! (theSrcPtr[i] = inBuffersPtr[theDecodePtr->mSourcesPtr[i]])) {
+            delete theTmpPtr;
+            return -EINVAL;
+        }
+    }
+    rs_matrix_mul(theTargetCnt, theDecodePtr->mSourceCount,
+        theDecodePtr->mMatrixPtr, inLength, theSrcPtr, theDstPtr);
+    delete theTmpPtr;
+    return 0;
+}
+
+    int
+ECMatrixMethod::XCoder::Encode(
+    int    inStripeCount,
+    int    inRecoveryStripeCount,
+    int    inLength,
+    void** inBuffersPtr)
+{
+    if (! IsValid(inStripeCount, inRecoveryStripeCount) ||
+            inLength < 0 || inLength % 16 != 0) {
+        return -EINVAL;
+    }
+    rs_matrix_mul(mRecoveryStripeCount, mStripeCount, mMatrixPtr,
+        inLength, inBuffersPtr, inBuffersPtr + mStripeCount);
+    return 0;
+}
+
+    void
+ECMatrixMethod::XCoder::Release()
+{
+    const int theRef = SyncAddAndFetch(mRefCount, -1);
+    if (0 < theRef) {
+        return;
+    }
+    QCRTASSERT(theRef == 0);
+    delete this;
+}
+
+    ECMatrixMethod::XCoder*
+ECMatrixMethod::XCoder::Ref()
+{
+    if (SyncAddAndFetch(mRefCount, 1) <= 1) {
+        QCRTASSERT(! "invalid ref. count");
+    }
+    return this;
+}
+
+// The cached matrices are immutable, and are deleted only with the coder,
+// therefore the pointer can be used after releasing the mutex. Once the
+// cache is full, new matrix is returned in outTmpPtr, and the caller must
+// delete it.
+    const ECMatrixMethod::XCoder::DecodeMatrix*
+ECMatrixMethod::XCoder::GetDecodeMatrix(
+    const int*     inMissingPtr,
+    int            inMissingCnt,
+    const int*     inTargetsPtr,
+    int            inTargetCnt,
+    void* const*   inBuffersPtr,
+    DecodeMatrix*& outTmpPtr)
+{
+    string theKey;
+    theKey.reserve(2 * inMissingCnt);
+    for (int i = 0; i < inMissingCnt; i++) {
+        theKey.push_back((char)inMissingPtr[i]);
+    }
+    for (int i = 0; i < inMissingCnt; i++) {
+        theKey.push_back(inBuffersPtr[inMissingPtr[i]] ? 1 : 0);
+    }
+    DecodeMatrices::const_iterator const theIt = mDecodeMatrices.find(theKey);
+    if (theIt != mDecodeMatrices.end()) {
+        return theIt->second;
+    }
+    DecodeMatrix* const thePtr = new DecodeMatrix(mStripeCount, inTargetCnt);
+    thePtr->mSourceCount = rs_matrix_repair_matrix(
+        mStripeCount,
+        mRecoveryStripeCount,
+        mMatrixPtr,
+        inMissingCnt,
+        inMissingPtr,
+        inTargetCnt,
+        inTargetsPtr,
+        thePtr->mSourcesPtr,
+        thePtr->mMatrixPtr
+    );
+    if (thePtr->mSourceCount <= 0) {
+        delete thePtr;
+        return 0;
+    }
+    if ((size_t)DecodeMatrix::kMaxCacheCount <= mDecodeMatrices.size()) {
+        outTmpPtr = thePtr;
+    } else {
+        mDecodeMatrices.insert(make_pair(theKey, thePtr));
+    }
+    return thePtr;
+}
+
+ECMatrixMethod::ECMatrixMethod(
+    int         inMethodType,
+    const char* inNamePtr,
+    const char* inDescriptionPtr)
+    : ECMethod(),
+      mMethodType(inMethodType),
+      mNamePtr(inNamePtr),
+      mDescription(Describe(inDescriptionPtr)),
+      mXCoders()
+{
+    LruList::Init(mLru);
+}
+
+ECMatrixMethod::~ECMatrixMethod()
+{
+    ECMatrixMethod::Unregister(mMethodType);
+    Cleanup();
+}
+
+    bool
+ECMatrixMethod::Init(
+    int inMethodType)
+{
+    QCRTASSERT(inMethodType == mMethodType);
+    return (inMethodType == mMethodType);
+}
+
+    void
+ECMatrixMethod::Release(
+    int inMethodType)
+{
+    QCRTASSERT(inMethodType == mMethodType);
+    Cleanup();
+}
+
+    bool
+ECMatrixMethod::Validate(
+    int     inMethodType,
+    int     inStripeCount,
+    int     inRecoveryStripeCount,
+    string* outErrMsgPtr)
+{
+    const char* theErrPtr  = 0;
+    bool        theMaxFlag = false;
+    if (inMethodType != mMethodType) {
+        theErrPtr = "invalid method type";
+    } else if (inStripeCount <= 0 ||
+            KFS_MAX_DATA_STRIPE_COUNT < inStripeCount) {
+        theErrPtr = "invalid data stripe count";
+    } else if (inRecoveryStripeCount <= 0 ||
+            KFS_MAX_RECOVERY_STRIPE_COUNT < inRecoveryStripeCount) {
+        theErrPtr = "invalid recovery stripe count";
+    } else if (RS_LIB_MAX_MATRIX_BLOCKS <
+            inStripeCount + inRecoveryStripeCount) {
+        theErrPtr  = "total stripe count exceeds ";
+        theMaxFlag = true;
+    } else {
+        return true;
+    }
+    if (outErrMsgPtr) {
+        *outErrMsgPtr = mNamePtr;
+        *outErrMsgPtr += ": ";
+        *outErrMsgPtr += theErrPtr;
+        if (theMaxFlag) {
+            AppendDecIntToString(*outErrMsgPtr, RS_LIB_MAX_MATRIX_BLOCKS);
+        }
+    }
+    return false;
+}
+
+    ECMatrixMethod::XCoder*
+ECMatrixMethod::GetXCoder(
+    int     inMethodType,
+    int     inStripeCount,
+    int     inRecoveryStripeCount,
+    string* outErrMsgPtr)
+{
+    QCRTASSERT(inMethodType == mMethodType);
+    if (! Validate(inMethodType, inStripeCount, inRecoveryStripeCount,
+            outErrMsgPtr)) {
+        return 0;
+    }
+    XCoders::iterator const theIt = mXCoders.find(make_pair(
+        inStripeCount, inRecoveryStripeCount));
+    if (theIt != mXCoders.end()) {
+        XCoder& theXCoder = *theIt->second;
+        LruList::PushBack(mLru, theXCoder);
+        return theXCoder.Ref();
+    }
+    XCoder& theXCoder = *CreateXCoder(inStripeCount, inRecoveryStripeCount);
+    XCoder* theFrontPtr;
+    while ((size_t)kMaxCodersCacheCount <= mXCoders.size() &&
+            (theFrontPtr = LruList::PopFront(mLru))) {
+        mXCoders.erase(theFrontPtr->GetIterator());
+        theFrontPtr->Release();
+    }
+    theXCoder.SetIterator(
+        mXCoders.insert(make_pair(
+            make_pair(inStripeCount, inRecoveryStripeCount),
+            &theXCoder)).first
+    );
+    QCASSERT(theXCoder.GetIterator()->second == &theXCoder);
+    LruList::PushBack(mLru, theXCoder);
+    return theXCoder.Ref();
+}
+
+    void
+ECMatrixMethod::Cleanup()
+{
+    size_t  theCount = 0;
+    XCoder* thePtr;
+    while ((thePtr = LruList::PopFront(mLru))) {
+        thePtr->Release();
+        theCount++;
+    }
+    QCRTASSERT(mXCoders.size() == theCount);
+    mXCoders.clear();
+}
+
+    string
+ECMatrixMethod::Describe(
+    const char* inDescriptionPtr) const
+{
+    string theRet;
+    theRet += "id: ";
+    AppendDecIntToString(theRet, mMethodType) += "; ";
+    theRet += inDescriptionPtr;
+    theRet += "; data stripes range: [1, ";
+    AppendDecIntToString(theRet, min(KFS_MAX_DATA_STRIPE_COUNT,
+        RS_LIB_MAX_MATRIX_BLOCKS - 1)) +=
+        "]"
+        "; recovery stripes range: [1, ";
+    AppendDecIntToString(theRet, min(KFS_MAX_RECOVERY_STRIPE_COUNT,
+        RS_LIB_MAX_MATRIX_BLOCKS - 1)) +=
+        "]"
+        "; data + recovery stripes: [2, ";
+    AppendDecIntToString(theRet, RS_LIB_MAX_MATRIX_BLOCKS) +=
+        "]";
+    return theRet;
+}
+
+}} /* namespace client KFS */
@@ -0,0 +1,226 @@
+//---------------------------------------------------------- -*- Mode: C++ -*-
+// $Id$
+//
+// Created 2026/10/16
+//
+// Copyright 2026 Quantcast Corp.
+//
+// This file is part of Kosmos File System (KFS).
+//
+// Licensed under the Apache License, Version 2.0
+// (the "License"); you may not use this file except in compliance with
+// the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+//
+// Erasure code method base for the linear codes defined by the recovery
+// stripe count x stripe count coding matrix, implemented with qcrs vector
+// matrix multiplication kernels. The decode matrices are computed once per
+// erasure pattern and cached. The methods only have to define the coding
+// matrix, and optionally the local repair stripes.
+//
+//----------------------------------------------------------------------------
+
+#ifndef KFS_LIBCLIENT_ECMATRIX_METHOD_H
+#define KFS_LIBCLIENT_ECMATRIX_METHOD_H
+
+#include "ECMethod.h"
+
+#include "common/StdAllocator.h"
+
+#include "qcdio/QCDLList.h"
+#include "qcdio/QCMutex.h"
+
+#include <map>
+#include <string>
+
+namespace KFS
+{
+namespace client
+{
+
+using std::map;
+using std::less;
+using std::pair;
+using std::string;
+
+class ECMatrixMethod : public ECMethod
+{
+protected:
+    class XCoder;
+    typedef map<
+        pair<int, int>,
+        XCoder*,
+        less<pair<int, int> >,
+        StdFastAllocator<
+            pair<const pair<int, int>, XCoder*> >
+    > XCoders;
+
+    class XCoder :
+        public ECMethod::Encoder,
+        public ECMethod::Decoder
+    {
+    public:
+        typedef QCDLList<XCoder, 0> List;
+
+        virtual bool SupportsOneRecoveryStripeRebuild() const
+            { return true; }
+        virtual int GetRepairCoefficients(
+            int            inStripeCount,
+            int            inRecoveryStripeCount,
+            int            inStripeIdx,
+            int            inMissingCount,
+            int const*     inMissingStripesIdxPtr,
+            int*           outStripesIdxPtr,
+            unsigned char* outCoefficientsPtr) const;
+        // The missing list is -1 terminated, and might include all stripes
+        // but the local repair stripes. Only the missing stripes with
+        // non null buffers are computed.
+        virtual int Decode(
+            int        inStripeCount,
+            int        inRecoveryStripeCount,
+            int        inLength,
+            void**     inBuffersPtr,
+            int const* inMissingStripesIdxPtr);
+        virtual int Encode(
+            int    inStripeCount,
+            int    inRecoveryStripeCount,
+            int    inLength,
+            void** inBuffersPtr);
+        virtual void Release();
+        XCoder* Ref();
+        void SetIterator(
+            const XCoders::iterator& inIt)
+            {  mIt = inIt; }
+        XCoders::iterator GetIterator() const
+            {  return mIt; }
+    protected:
+        int const            mStripeCount;
+        int const            mRecoveryStripeCount;
+        unsigned char* const mMatrixPtr;
+
+        // The derived class constructor must initialize the coding matrix.
+        XCoder(
+            int inStripeCount,
+            int inRecoveryStripeCount);
+        virtual ~XCoder();
+        bool IsValid(
+            int inStripeCount,
+            int inRecoveryStripeCount) const
+        {
+            return (inStripeCount == mStripeCount &&
+                inRecoveryStripeCount == mRecoveryStripeCount);
+        }
+    private:
+        class DecodeMatrix;
+        // The key is the sorted missing stripe indices, each fits into one
+        // byte, followed by one byte per missing stripe that is non zero if
+        // the stripe has to be computed.
+        typedef map<
+            string,
+            DecodeMatrix*,
+            less<string>,
+            StdFastAllocator<pair<const string, DecodeMatrix*> >
+        > DecodeMatrices;
+
+        QCMutex           mMutex;
+        DecodeMatrices    mDecodeMatrices;
+        volatile int      mRefCount;
+        XCoders::iterator mIt;
+        XCoder*           mPrevPtr[1];
+        XCoder*           mNextPtr[1];
+
+        const DecodeMatrix* GetDecodeMatrix(
+            const int*     inMissingPtr,
+            int            inMissingCnt,
+            const int*     inTargetsPtr,
+            int            inTargetCnt,
+            void* const*   inBuffersPtr,
+            DecodeMatrix*& outTmpPtr);
+        friend class QCDLListOp<XCoder, 0>;
+    private:
+        XCoder(
+            const XCoder& inCoder);
+        XCoder& operator=(
+            const XCoder& inCoder);
+    };
+
+    ECMatrixMethod(
+        int         inMethodType,
+        const char* inNamePtr,
+        const char* inDescriptionPtr);
+    virtual ~ECMatrixMethod();
+    virtual XCoder* CreateXCoder(
+        int inStripeCount,
+        int inRecoveryStripeCount) = 0;
+    virtual bool Init(
+        int inMethodType);
+    virtual void Release(
+        int inMethodType);
+    virtual string GetDescription() const
+        { return mDescription; }
+    virtual bool Validate(
+        int     inMethodType,
+        int     inStripeCount,
+        int     inRecoveryStripeCount,
+        string* outErrMsgPtr);
+    virtual Encoder* GetEncoder(
+        int     inMethodType,
+        int     inStripeCount,
+        int     inRecoveryStripeCount,
+        string* outErrMsgPtr)
+    {
+        return GetXCoder(
+            inMethodType,
+            inStripeCount,
+            inRecoveryStripeCount,
+            outErrMsgPtr
+        );
+    }
+    virtual Decoder* GetDecoder(
+        int     inMethodType,
+        int     inStripeCount,
+        int     inRecoveryStripeCount,
+        string* outErrMsgPtr)
+    {
+        return GetXCoder(
+            inMethodType,
+            inStripeCount,
+            inRecoveryStripeCount,
+            outErrMsgPtr
+        );
+    }
+private:
+    enum { kMaxCodersCacheCount = 2 << 10 };
+    typedef XCoder::List LruList;
+
+    int const         mMethodType;
+    const char* const mNamePtr;
+    const string      mDescription;
+    XCoders           mXCoders;
+    XCoder*           mLru[1];
+
+    XCoder* GetXCoder(
+        int     inMethodType,
+        int     inStripeCount,
+        int     inRecoveryStripeCount,
+        string* outErrMsgPtr);
+    void Cleanup();
+    string Describe(
+        const char* inDescriptionPtr) const;
+private:
+    ECMatrixMethod(
+        const ECMatrixMethod& inMethod);
+    ECMatrixMethod& operator=(
+        const ECMatrixMethod& inMethod);
+};
+
+}} /* namespace client KFS */
+
+#endif /* KFS_LIBCLIENT_ECMATRIX_METHOD_H */
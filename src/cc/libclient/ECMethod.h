@@ -71,6 +71,34 @@ public:
             int const* inMissingStripesIdx) = 0;
         virtual void Release() = 0;
         virtual bool SupportsOneRecoveryStripeRebuild() const = 0;
+        // Returns the number of stripes, and their indices, sufficient to
+        // recover single stripe inStripeIdx, or 0 if the stripe can only be
+        // recovered from inStripeCount stripes. The output buffer must have
+        // room for inStripeCount entries. The decoder must be able to
+        // recover the stripe, when the indices of all other stripes are in
+        // the missing list with null buffers.
+        virtual int GetLocalRepairStripes(
+            int  /* inStripeCount */,
+            int  /* inRecoveryStripeCount */,
+            int  /* inStripeIdx */,
+            int* /* outStripesIdxPtr */) const
+            { return 0; }
+        // Computes the coefficients of the linear combination of the
+        // available stripes that is equal to stripe inStripeIdx. The stripes
+        // in the missing list, which must include inStripeIdx, are not
+        // available. Returns the number of stripes in the combination, with
+        // the indices and coefficients in the output buffers, which must
+        // have room for inStripeCount entries, or -1 if the method does not
+        // support such repair, or the stripe can not be recovered.
+        virtual int GetRepairCoefficients(
+            int            /* inStripeCount */,
+            int            /* inRecoveryStripeCount */,
+            int            /* inStripeIdx */,
+            int            /* inMissingCount */,
+            int const*     /* inMissingStripesIdxPtr */,
+            int*           /* outStripesIdxPtr */,
+            unsigned char* /* outCoefficientsPtr */) const
+            { return -1; }
     protected:
         Decoder()
             {}
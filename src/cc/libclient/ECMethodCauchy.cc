@@ -0,0 +1,75 @@
+//---------------------------------------------------------- -*- Mode: C++ -*-
+// $Id$
+//
+// Created 2026/10/16
+//
+// Copyright 2026 Quantcast Corp.
+//
+// This file is part of Kosmos File System (KFS).
+//
+// Licensed under the Apache License, Version 2.0
+// (the "License"); you may not use this file except in compliance with
+// the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+//
+// General k+m Reed Solomon erasure code method with Cauchy coding matrix,
+// implemented with qcrs vector matrix multiplication kernels.
+// Decode matrices are computed once per erasure pattern and cached.
+//
+//----------------------------------------------------------------------------
+
+#include "ECMethodDef.h"
+#include "ECMatrixMethod.h"
+
+#include "qcrs/rs.h"
+
+#include "common/kfstypes.h"
+
+namespace KFS
+{
+namespace client
+{
+
+class QCECMethodCauchy : public ECMatrixMethod
+{
+public:
+    static ECMethod* GetMethod()
+    {
+        static QCECMethodCauchy sMethod;
+        return &sMethod;
+    }
+protected:
+    class CXCoder : public XCoder
+    {
+    public:
+        CXCoder(
+            int inStripeCount,
+            int inRecoveryStripeCount)
+            : XCoder(inStripeCount, inRecoveryStripeCount)
+        {
+            rs_cauchy_matrix(mStripeCount, mRecoveryStripeCount,
+                mMatrixPtr);
+        }
+    };
+    virtual XCoder* CreateXCoder(
+        int inStripeCount,
+        int inRecoveryStripeCount)
+        { return new CXCoder(inStripeCount, inRecoveryStripeCount); }
+    QCECMethodCauchy()
+        : ECMatrixMethod(
+            KFS_STRIPED_FILE_TYPE_RS_CAUCHY, "Cauchy RS", "qcrs cauchy")
+        {}
+};
+
+KFS_REGISTER_EC_METHOD(STRIPED_FILE_TYPE_RS_CAUCHY,
+    QCECMethodCauchy::GetMethod()
+);
+
+}} /* namespace client KFS */
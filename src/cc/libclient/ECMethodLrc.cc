@@ -0,0 +1,118 @@
+//---------------------------------------------------------- -*- Mode: C++ -*-
+// $Id$
+//
+// Created 2026/10/16
+//
+// Copyright 2026 Quantcast Corp.
+//
+// This file is part of Kosmos File System (KFS).
+//
+// Licensed under the Apache License, Version 2.0
+// (the "License"); you may not use this file except in compliance with
+// the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+//
+// Locally repairable erasure code method. The data stripes are split into
+// (recovery stripe count + 1) / 2 groups, each group has its own xor parity
+// stripe, the remaining recovery stripes are global Cauchy parities. Single
+// data stripe or local parity stripe is recovered by reading only its group,
+// and any recovery stripe count - local group count + 1 missing stripes are
+// recoverable.
+//
+//----------------------------------------------------------------------------
+
+#include "ECMethodDef.h"
+#include "ECMatrixMethod.h"
+
+#include "qcrs/rs.h"
+
+#include "common/kfstypes.h"
+
+namespace KFS
+{
+namespace client
+{
+
+class QCECMethodLrc : public ECMatrixMethod
+{
+public:
+    static ECMethod* GetMethod()
+    {
+        static QCECMethodLrc sMethod;
+        return &sMethod;
+    }
+protected:
+    class CXCoder : public XCoder
+    {
+    public:
+        CXCoder(
+            int inStripeCount,
+            int inRecoveryStripeCount)
+            : XCoder(inStripeCount, inRecoveryStripeCount),
+              mGroupCount(GetLrcLocalGroupCount(
+                inStripeCount, inRecoveryStripeCount))
+        {
+            rs_lrc_matrix(mStripeCount, mRecoveryStripeCount, mGroupCount,
+                mMatrixPtr);
+        }
+        virtual int GetLocalRepairStripes(
+            int  inStripeCount,
+            int  inRecoveryStripeCount,
+            int  inStripeIdx,
+            int* outStripesIdxPtr) const
+        {
+            if (! IsValid(inStripeCount, inRecoveryStripeCount) ||
+                    mGroupCount <= 1 ||
+                    inStripeIdx < 0 ||
+                    mStripeCount + mGroupCount <= inStripeIdx) {
+                return 0;
+            }
+            int theGroup;
+            if (inStripeIdx < mStripeCount) {
+                theGroup = 0;
+                while ((theGroup + 1) * mStripeCount / mGroupCount <=
+                        inStripeIdx) {
+                    theGroup++;
+                }
+            } else {
+                theGroup = inStripeIdx - mStripeCount;
+            }
+            int       theCnt = 0;
+            const int theEnd = (theGroup + 1) * mStripeCount / mGroupCount;
+            for (int i = theGroup * mStripeCount / mGroupCount;
+                    i < theEnd;
+                    i++) {
+                if (i != inStripeIdx) {
+                    outStripesIdxPtr[theCnt++] = i;
+                }
+            }
+            if (inStripeIdx < mStripeCount) {
+                outStripesIdxPtr[theCnt++] = mStripeCount + theGroup;
+            }
+            return theCnt;
+        }
+    private:
+        int const mGroupCount;
+    };
+    virtual XCoder* CreateXCoder(
+        int inStripeCount,
+        int inRecoveryStripeCount)
+        { return new CXCoder(inStripeCount, inRecoveryStripeCount); }
+    QCECMethodLrc()
+        : ECMatrixMethod(KFS_STRIPED_FILE_TYPE_RS_LRC, "LRC",
+            "qcrs lrc; local groups: (recovery stripes + 1) / 2")
+        {}
+};
+
+KFS_REGISTER_EC_METHOD(STRIPED_FILE_TYPE_RS_LRC,
+    QCECMethodLrc::GetMethod()
+);
+
+}} /* namespace client KFS */
@@ -4618,6 +4618,10 @@ KfsClientImpl::StartProtocolWorker()
     }
     params.mUseClientPoolFlag = mConfig.getValue(
         "client.connectionPool", params.mUseClientPoolFlag ? 1 : 0) != 0;
+    // Compute striped files recovery stripes in parallel with the network
+    // io, by default recovery is computed by the protocol worker thread.
+    params.mEncoderThreadCount = mConfig.getValue(
+        "client.rsEncoderThreads", params.mEncoderThreadCount);
     mProtocolWorker = new KfsProtocolWorker(
         mMetaServerLoc.hostname,
         mMetaServerLoc.port,
@@ -6040,7 +6044,7 @@ GetReadLeasePosition(
 int
 KfsClientImpl::GetDataChecksums(const ServerLocation& loc,
     kfsChunkId_t chunkId, int64_t chunkVersion, chunkOff_t chunkPosition,
-    uint32_t* checksums, bool readVerifyFlag)
+    uint32_t* checksums, bool readVerifyFlag, int* outChecksumType)
 {
     GetChunkMetadataOp op(0, chunkId, readVerifyFlag);
     int64_t leaseId   = -1;
@@ -6075,6 +6079,9 @@ KfsClientImpl::GetDataChecksums(const ServerLocation& loc,
         return -EINVAL;
     }
     memcpy(checksums, op.contentBuf, numChecksums * sizeof(*checksums));
+    if (outChecksumType) {
+        *outChecksumType = op.checksumType;
+    }
     return 0;
 }
 
@@ -6127,7 +6134,8 @@ KfsClientImpl::VerifyDataChecksumsFid(const FileAttr& attr)
     chunkChecksums1.reset(new uint32_t[numChecksums]);
     scoped_array<uint32_t> chunkChecksums2;
     chunkChecksums2.reset(new uint32_t[numChecksums]);
-    int status = 0;
+    const bool kReadVerifyFlag = true;
+    int        status          = 0;
     for (vector<ChunkLayoutInfo>::const_iterator i = lop.chunks.begin();
             i != lop.chunks.end();
             ++i) {
@@ -6141,9 +6149,10 @@ KfsClientImpl::VerifyDataChecksumsFid(const FileAttr& attr)
             KFS_LOG_EOM;
             continue;
         }
+        int checksumType1 = kKfsChecksumTypeAdler32;
         if ((ret = GetDataChecksums(
                 i->chunkServers[0], i->chunkId, i->chunkVersion, i->fileOffset,
-                chunkChecksums1.get())) < 0) {
+                chunkChecksums1.get(), kReadVerifyFlag, &checksumType1)) < 0) {
             KFS_LOG_STREAM_ERROR << "failed to get checksums from server " <<
                 i->chunkServers[0] << " " << ErrorCodeToStr(ret) <<
             KFS_LOG_EOM;
@@ -6153,9 +6162,11 @@ KfsClientImpl::VerifyDataChecksumsFid(const FileAttr& attr)
             continue;
         }
         for (size_t k = 1; k < i->chunkServers.size(); k++) {
+            int checksumType2 = kKfsChecksumTypeAdler32;
             if ((ret = GetDataChecksums(
                     i->chunkServers[k], i->chunkId, i->chunkVersion,
-                    i->fileOffset, chunkChecksums2.get())) < 0) {
+                    i->fileOffset, chunkChecksums2.get(), kReadVerifyFlag,
+                    &checksumType2)) < 0) {
                 KFS_LOG_STREAM_ERROR << "failed get checksums from server: " <<
                     i->chunkServers[k] << " " << ErrorCodeToStr(ret) <<
                 KFS_LOG_EOM;
@@ -6164,6 +6175,16 @@ KfsClientImpl::VerifyDataChecksumsFid(const FileAttr& attr)
                 }
                 continue;
             }
+            if (checksumType1 != checksumType2) {
+                // The replicas are verified by the chunk servers with read
+                // verify, and the checksums cannot be compared.
+                KFS_LOG_STREAM_INFO << "checksum type differs between"
+                    " servers: " <<
+                    i->chunkServers[0] << " " << i->chunkServers[k] <<
+                    " chunk: " << i->chunkId <<
+                KFS_LOG_EOM;
+                continue;
+            }
             for (size_t v = 0; v < numChecksums; v++) {
                 if (chunkChecksums1[v] != chunkChecksums2[v]) {
                     KFS_LOG_STREAM_ERROR <<
@@ -965,7 +965,8 @@ private:
 
     int GetDataChecksums(const ServerLocation &loc,
         kfsChunkId_t chunkId, int64_t chunkVersion, chunkOff_t chunkPosition,
-        uint32_t *checksums, bool readVerifyFlag = true);
+        uint32_t *checksums, bool readVerifyFlag = true,
+        int* outChecksumType = 0);
 
     int VerifyDataChecksumsFid(const FileAttr& attr);
 
@@ -1371,7 +1371,9 @@ private:
                 mKeyId.c_str(),
                 mKeyData.data(),
                 (int)mKeyData.size(),
-                &theErrMsg
+                &theErrMsg,
+                mServerLocation.ToString().c_str(),
+                mShutdownSslFlag
             );
             if (theStatus != 0) {
                 KFS_LOG_STREAM_DEBUG << mLogPrefix <<
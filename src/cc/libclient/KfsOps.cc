@@ -521,6 +521,12 @@ ReadOp::Request(ostream &os)
     if (skipVerifyDiskChecksumFlag) {
         os << "Skip-Disk-Chksum: 1\r\n";
     }
+    if (acceptChecksumType != kKfsChecksumTypeAdler32) {
+        os << "Checksum-type: " << acceptChecksumType << "\r\n";
+    }
+    if (ioPriority != kKfsIoPriorityHigh) {
+        os << "IO-priority: " << ioPriority << "\r\n";
+    }
     os << "\r\n";
 }
 
@@ -1220,6 +1226,13 @@ SizeOp::ParseResponseHeaderSelf(const Properties &prop)
     size = prop.getValue("Size", (long long) 0);
 }
 
+void
+GetChunkMetadataOp::ParseResponseHeaderSelf(const Properties &prop)
+{
+    checksumType = prop.getValue("Checksum-type",
+        int(kKfsChecksumTypeAdler32));
+}
+
 void
 ReadOp::ParseResponseHeaderSelf(const Properties &prop)
 {
@@ -1232,6 +1245,8 @@ ReadOp::ParseResponseHeaderSelf(const Properties &prop)
     skipVerifyDiskChecksumFlag =
         skipVerifyDiskChecksumFlag &&
         prop.getValue("Skip-Disk-Chksum", 0) != 0;
+    checksumType = prop.getValue("Checksum-type",
+        int(kKfsChecksumTypeAdler32));
     istringstream ist(checksumStr);
     checksums.clear();
     for (uint32_t i = 0; i < nentries; i++) {
@@ -33,6 +33,7 @@
 #include "common/RequestParser.h"
 #include "kfsio/NetConnection.h"
 #include "kfsio/CryptoKeys.h"
+#include "kfsio/checksum.h"
 #include "KfsAttr.h"
 
 #include <algorithm>
@@ -870,11 +871,14 @@ operator<<(ostream& os, const ChunkAccessOp::AccessReq& req)
 // Get the chunk metadata (aka checksums) stored on the chunkservers
 struct GetChunkMetadataOp: public ChunkAccessOp {
     bool readVerifyFlag;
+    int  checksumType; /* output: block checksums algorithm */
     GetChunkMetadataOp(kfsSeq_t s, kfsChunkId_t c, bool verifyFlag)
         : ChunkAccessOp(CMD_GET_CHUNK_METADATA, s, c),
-          readVerifyFlag(verifyFlag)
+          readVerifyFlag(verifyFlag),
+          checksumType(kKfsChecksumTypeAdler32)
         {}
     void Request(ostream& os);
+    virtual void ParseResponseHeaderSelf(const Properties& prop);
     virtual ostream& ShowSelf(ostream& os) const {
         os << "get chunk metadata:"
             " chunkId: " << chunkId <<
@@ -1068,6 +1072,10 @@ struct ReadOp : public ChunkAccessOp {
     chunkOff_t       offset;       /* input */
     size_t           numBytes;     /* input */
     bool             skipVerifyDiskChecksumFlag;
+    int              ioPriority;   /* input: KfsIoPriority disk io class */
+    int              acceptChecksumType; /* input: supported algorithm
+                                            besides adler32 */
+    int              checksumType; /* output: checksums algorithm */
     struct timeval   submitTime;   /* when the client sent the request to the server */
     vector<uint32_t> checksums;    /* checksum for each 64KB block */
     float            diskIOTime;   /* as reported by the server */
@@ -1078,6 +1086,9 @@ struct ReadOp : public ChunkAccessOp {
           offset(0),
           numBytes(0),
           skipVerifyDiskChecksumFlag(false),
+          ioPriority(kKfsIoPriorityHigh),
+          acceptChecksumType(kKfsChecksumTypeAdler32),
+          checksumType(kKfsChecksumTypeAdler32),
           diskIOTime(0.0),
           elapsedTime(0.0)
         { chunkVersion = v; }
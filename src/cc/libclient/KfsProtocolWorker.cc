@@ -50,6 +50,7 @@
 #include "Writer.h"
 #include "Reader.h"
 #include "ClientPool.h"
+#include "ECEncoderPool.h"
 
 #include <algorithm>
 #include <map>
@@ -156,6 +157,10 @@ public:
                 0                            // inAuthContextPtr
             ) : 0
         ),
+        mEncoderPoolPtr(0 < inParameters.mEncoderThreadCount ?
+            new ECEncoderPool(mNetManager, inParameters.mEncoderThreadCount) :
+            0
+        ),
         mReadStats(),
         mWriteStats(),
         mAppendStats()
@@ -165,11 +170,23 @@ public:
         CleanupList::Init(mCleanupList);
     }
     virtual ~Impl()
-        { Impl::Stop(); }
+    {
+        Impl::Stop();
+        delete mEncoderPoolPtr;
+    }
     virtual void Run()
     {
         mNetManager.RegisterTimeoutHandler(this);
+        if (mEncoderPoolPtr && mEncoderPoolPtr->Start() != 0) {
+            KFS_LOG_STREAM_ERROR << mLogPrefixPtr <<
+                " failed to start encoder threads,"
+                " recovery will be computed inline" <<
+            KFS_LOG_EOM;
+        }
         mNetManager.MainLoop();
+        if (mEncoderPoolPtr) {
+            mEncoderPoolPtr->Stop();
+        }
         mNetManager.UnRegisterTimeoutHandler(this);
     }
     void Start()
@@ -1113,7 +1130,8 @@ private:
                 min(max(4 << 20, inOwner.mMaxWriteSize),
                     max(inOwner.mMaxWriteSize, inMaxWriteSize)),
                 inLogPrefixPtr,
-                inOwner.mChunkServerInitialSeqNum
+                inOwner.mChunkServerInitialSeqNum,
+                inOwner.mEncoderPoolPtr
               ),
               mCurRequestPtr(0)
             { WorkQueue::Init(mWorkQueue); }
@@ -1661,6 +1679,7 @@ private:
     QCThread             mWorker;
     QCMutex              mMutex;
     ClientPool* const    mClientPoolPtr;
+    ECEncoderPool* const mEncoderPoolPtr;
     FileReader::Stats    mReadStats;
     FileWriter::Stats    mWriteStats;
     Appender::Stats      mAppendStats;
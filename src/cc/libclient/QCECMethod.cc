@@ -157,6 +157,35 @@ private:
             {}
         virtual bool SupportsOneRecoveryStripeRebuild() const
             { return false; }
+        virtual int GetRepairCoefficients(
+            int            inStripeCount,
+            int            inRecoveryStripeCount,
+            int            inStripeIdx,
+            int            inMissingCount,
+            int const*     inMissingStripesIdxPtr,
+            int*           outStripesIdxPtr,
+            unsigned char* outCoefficientsPtr) const
+        {
+            if (inStripeCount <= 0 ||
+                    RS_LIB_MAX_DATA_BLOCKS < inStripeCount ||
+                    inRecoveryStripeCount != RS_LIB_MAX_RECOVERY_BLOCKS) {
+                return -1;
+            }
+            unsigned char theMatrix[
+                RS_LIB_MAX_RECOVERY_BLOCKS * RS_LIB_MAX_DATA_BLOCKS];
+            rs_pqr_matrix(inStripeCount, inRecoveryStripeCount, theMatrix);
+            return rs_matrix_repair_matrix(
+                inStripeCount,
+                inRecoveryStripeCount,
+                theMatrix,
+                inMissingCount,
+                inMissingStripesIdxPtr,
+                1,
+                &inStripeIdx,
+                outStripesIdxPtr,
+                outCoefficientsPtr
+            );
+        }
         virtual int Decode(
             int        inStripeCount,
             int        inRecoveryStripeCount,
@@ -26,6 +26,7 @@
 #include "RSStriper.h"
 #include "Writer.h"
 #include "ECMethod.h"
+#include "ECEncoderPool.h"
 
 #include "kfsio/IOBuffer.h"
 #include "kfsio/checksum.h"
@@ -330,7 +331,8 @@ public:
         const string&            inLogPrefix,
         Impl&                    inOuter,
         Writer::Striper::Offset& outOpenChunkBlockSize,
-        string&                  outErrMsg)
+        string&                  outErrMsg,
+        ECEncoderPool*           inEncoderPoolPtr)
     {
         if (! Validate(
                 inType,
@@ -355,11 +357,13 @@ public:
             inFileSize,
             inLogPrefix,
             inOuter,
-            theEncoderPr
+            theEncoderPr,
+            0 < inRecoveryStripeCount ? inEncoderPoolPtr : 0
         );
     }
     virtual ~RSWriteStriper()
     {
+        WaitForEncodeJobs();
         delete [] mBuffersPtr;
         if (mEncoderPtr) {
             mEncoderPtr->Release();
@@ -374,6 +378,9 @@ public:
         if (ioOffset < 0 && theSize > 0) {
             return kErrorParameters;
         }
+        if (mEncodeStatus != 0) {
+            return kErrorIO;
+        }
         if (mRecoveryStripeCount > 0 && ioOffset != mOffset) {
             if (theSize > 0 &&
                     (mRecoveryEndPos < mOffset ||
@@ -382,6 +389,9 @@ public:
                     "non sequential unaligned write");
                 return kErrorParameters;
             }
+            if (! WaitForEncodeJobs()) {
+                return kErrorIO;
+            }
             Flush(0);
             QCASSERT(mPendingCount == 0);
             mOffset         = ioOffset;
@@ -408,11 +418,18 @@ public:
                 ioOffset % (CHUNKSIZE * mStripeCount) == 0 &&
                 mOffset == mRecoveryEndPos
             );
+            if (! WaitForEncodeJobs()) {
+                return kErrorIO;
+            }
             for (int i = 0; i < mStripeCount + mRecoveryStripeCount; i++) {
                 Write(mBuffersPtr[i]);
             }
         }
         if (mOffset - mRecoveryEndPos < max(1, inWriteThreshold)) {
+            // Flush or close requires all recovery stripes to be written.
+            if (inWriteThreshold <= 1 && ! WaitForEncodeJobs()) {
+                return kErrorIO;
+            }
             Flush(inWriteThreshold);
             return 0;
         }
@@ -422,6 +439,9 @@ public:
                 "non sequential unaligned write/flush");
             return kErrorParameters;
         }
+        if (! WaitForEncodeJobs()) {
+            return kErrorIO;
+        }
         // Zero padd to full stride, and compute recovery.
         QCASSERT(mOffset - mRecoveryEndPos < mStrideSize);
         const int thePaddSize = (int)(mStrideSize - mOffset % mStrideSize);
@@ -593,6 +613,73 @@ private:
         int                mCurPos;
         int                mWriteLen;
     };
+    // Recovery stripes computation for one or more strides. When run by the
+    // encoder pool, the job holds its own references to the data stripes
+    // buffers, and its own temporary buffers, the striper buffers can then
+    // be written and trimmed while the recovery stripes are being computed.
+    class EncodeJob : public ECEncoderPool::Job
+    {
+    public:
+        EncodeJob(
+            RSWriteStriper& inOuter,
+            int             inSize,
+            Offset          inOffset,
+            bool            inSyncFlag)
+            : ECEncoderPool::Job(),
+              mOuter(inOuter),
+              mSize(inSize),
+              mOffset(inOffset),
+              mOwnBuffersFlag(! inSyncFlag),
+              mBuffersPtr(inSyncFlag ?
+                inOuter.mBuffersPtr : new Buffer[inOuter.mStripeCount]),
+              mBufPtr(inSyncFlag ? inOuter.mBufPtr : new void*[
+                inOuter.mStripeCount + inOuter.mRecoveryStripeCount]),
+              mTempBufAllocPtr(inSyncFlag ? 0 :
+                new char[kTempBufSize * inOuter.mStripeCount + kAlign]),
+              mTempBufPtr(inSyncFlag ? inOuter.GetTempBufPtr(0) :
+                mTempBufAllocPtr + (kAlign -
+                    (unsigned int)(mTempBufAllocPtr - kNullCharPtr) % kAlign)),
+              mStatus(0),
+              mDoneFlag(false)
+            { EncodeJobs::Init(*this); }
+        virtual ~EncodeJob()
+        {
+            if (mOwnBuffersFlag) {
+                delete [] mBuffersPtr;
+                delete [] mBufPtr;
+                delete [] mTempBufAllocPtr;
+            }
+        }
+        virtual void Run()
+            { mStatus = mOuter.Encode(*this); }
+        virtual void Done()
+            { mOuter.EncodeDone(*this); }
+        char* GetTempBufPtr(
+            int inIndex) const
+            { return (mTempBufPtr + inIndex * kTempBufSize); }
+
+        RSWriteStriper& mOuter;
+        const int       mSize;
+        const Offset    mOffset;
+        const bool      mOwnBuffersFlag;
+        Buffer* const   mBuffersPtr;
+        void** const    mBufPtr;
+        char* const     mTempBufAllocPtr;
+        char* const     mTempBufPtr;
+        int             mStatus;
+        bool            mDoneFlag;
+    private:
+        EncodeJob* mPrevPtr[1];
+        EncodeJob* mNextPtr[1];
+        friend class QCDLListOp<EncodeJob, 0>;
+    private:
+        EncodeJob(
+            const EncodeJob& inJob);
+        EncodeJob& operator=(
+            const EncodeJob& inJob);
+    };
+    friend class EncodeJob;
+    typedef QCDLList<EncodeJob, 0> EncodeJobs;
     typedef std::set<
         Offset,
         std::less<Offset>,
@@ -607,6 +694,9 @@ private:
     WriteFailures            mWriteFailures;
     Buffer* const            mBuffersPtr;
     ECMethod::Encoder* const mEncoderPtr;
+    ECEncoderPool* const     mEncoderPoolPtr;
+    int                      mEncodeStatus;
+    EncodeJob*               mEncodeJobs[1];
 
     RSWriteStriper(
         int                inStripeSize,
@@ -615,7 +705,8 @@ private:
         Offset             inFileSize,
         string             inFilePrefix,
         Impl&              inOuter,
-        ECMethod::Encoder* inEncoderPtr)
+        ECMethod::Encoder* inEncoderPtr,
+        ECEncoderPool*     inEncoderPoolPtr)
         : Striper(inOuter),
           RSStriper(
             inStripeSize,
@@ -629,8 +720,10 @@ private:
           mLastPartialFlushPos(0),
           mWriteFailures(),
           mBuffersPtr(new Buffer[inStripeCount + inRecoveryStripeCount]),
-          mEncoderPtr(inEncoderPtr)
-        {}
+          mEncoderPtr(inEncoderPtr),
+          mEncoderPoolPtr(inEncoderPoolPtr),
+          mEncodeStatus(0)
+        { EncodeJobs::Init(mEncodeJobs); }
     bool IsChunkWriterFailed(
         Offset inOffset) const
     {
@@ -798,46 +891,120 @@ private:
             (int)((mOffset - theStrideHead) - mRecoveryEndPos);
         const int theSize       = theTotalSize / mStripeCount;
         QCASSERT(theSize * mStripeCount == theTotalSize);
+        // Padded stride recovery is written immediately, and debug verify
+        // fills recovery buffers after the computation.
+        const bool theSyncFlag  = ioPaddSizeWriteFrontTrimPtr ||
+            ! mEncoderPoolPtr || ! mEncoderPoolPtr->IsRunning() ||
+            IOBuffer::IsDebugVerify();
+        EncodeJob& theJob       = *(new EncodeJob(
+            *this, theSize, mRecoveryEndPos, theSyncFlag));
         Offset thePendingCount = 0;
         for (int i = mStripeCount;
                 i < mStripeCount + mRecoveryStripeCount;
                 i++) {
             IOBufferData theBuf = NewDataBuffer(theSize);
-            mBufPtr[i] = theBuf.Producer();
+            theJob.mBufPtr[i] = theBuf.Producer();
             if (IOBuffer::IsDebugVerify()) {
                 thePendingCount += theSize;
             } else {
                 theBuf.Fill(theSize);
             }
+            // The write length is advanced when the encode job completes.
             if (mBuffersPtr[i].mBuffer.IsEmpty()) {
                 const Offset thePos = mBuffersPtr[i - 1].mEndPos + CHUNKSIZE;
                 mBuffersPtr[i].mEndPos = thePos;
                 if (i == mStripeCount) {
                     mBuffersPtr[i].mEndPos -= thePos % mStripeSize;
                 }
-                mBuffersPtr[i].mWriteLen = theSize;
+                mBuffersPtr[i].mWriteLen = 0;
             } else {
-                mBuffersPtr[i].mWriteLen += theSize;
-                mBuffersPtr[i].mEndPos   += theSize;
+                mBuffersPtr[i].mEndPos += theSize;
             }
             mBuffersPtr[i].mBuffer.Append(theBuf);
             thePendingCount += mBuffersPtr[i].mBuffer.BytesConsumable();
         }
+        for (int i = 0; i < mStripeCount; i++) {
+            Buffer&   theBuf     = mBuffersPtr[i];
+            const int theTail    = min(theStrideHead, mStripeSize);
+            theStrideHead -= theTail;
+            const int theBufSize = theBuf.mBuffer.BytesConsumable();
+            thePendingCount += theBufSize;
+            const int theSkip    = theBufSize - (theSize + theTail);
+            theBuf.mWriteLen = theSkip + theSize;
+            if (theSyncFlag) {
+                theBuf.mCurIt  = theBuf.mBuffer.begin();
+                theBuf.mCurPos = theSkip;
+            } else {
+                // Share the data stripe buffers with the job.
+                Buffer& theJobBuf = theJob.mBuffersPtr[i];
+                theJobBuf.mBuffer.Copy(&theBuf.mBuffer, theSkip + theSize);
+                theJobBuf.mBuffer.Consume(theSkip);
+                theJobBuf.mCurIt  = theJobBuf.mBuffer.begin();
+                theJobBuf.mCurPos = 0;
+            }
+        }
+        if (theSyncFlag) {
+            theJob.mStatus = Encode(theJob);
+            if (theJob.mStatus == 0 && IOBuffer::IsDebugVerify()) {
+                for (int i = mStripeCount;
+                        i < mStripeCount + mRecoveryStripeCount;
+                        i++) {
+                    IOBuffer&          theBuf = mBuffersPtr[i].mBuffer;
+                    IOBuffer::iterator theIt  = theBuf.end();
+                    QCVERIFY(
+                        theIt-- != theBuf.begin() &&
+                        theSize == theBuf.CopyInOnlyIntoBufferAtPos(
+                            theIt->Producer(), theSize, theIt
+                    ));
+                }
+            }
+            // Complete all previously queued jobs first, in order to
+            // preserve the recovery stripes order.
+            WaitForEncodeJobs();
+            CompleteEncodeJob(theJob);
+            if (mEncodeStatus != 0) {
+                return false;
+            }
+        } else {
+            EncodeJobs::PushBack(mEncodeJobs, theJob);
+            mEncoderPoolPtr->Enqueue(theJob);
+        }
+        mRecoveryEndPos += theTotalSize;
+        if (mLastPartialFlushPos + mStrideSize > mRecoveryEndPos) {
+            // The partial stride was previously written / flushed.
+            int theHead = (int)(
+                mLastPartialFlushPos + mStrideSize - mRecoveryEndPos);
+            QCRTASSERT(theHead > 0 && theHead < mStrideSize);
+            if (ioPaddSizeWriteFrontTrimPtr) {
+                *ioPaddSizeWriteFrontTrimPtr = theHead;
+                // Do not trim if padded, the caller will do the trimming.
+                theHead = 0;
+            }
+            // Trim only the data buffers, as the recovery stripes may have
+            // changed.
+            for (int i = 0; i < mStripeCount && theHead > 0; i++) {
+                QCASSERT(mBuffersPtr[i].mBuffer.BytesConsumable() >=
+                    min(theHead, mStripeSize));
+                TrimBufferFront(mBuffersPtr[i], theHead, thePendingCount);
+            }
+        }
+        mPendingCount = thePendingCount;
+        return true;
+    }
+    int Encode(
+        EncodeJob& inJob) const
+    {
+        // Invoked by the encoder pool threads, must not modify the striper
+        // state.
+        const int    theSize   = inJob.mSize;
+        void** const theBufPtr = inJob.mBufPtr;
         for (int thePos = 0, thePrevLen = 0; thePos < theSize; ) {
             int theLen = theSize - thePos;
             for (int i = 0; i < mStripeCount; i++) {
-                IOBuffer&           theBuf  = mBuffersPtr[i].mBuffer;
-                IOBuffer::iterator& theIt   = mBuffersPtr[i].mCurIt;
-                int&                theSkip = mBuffersPtr[i].mCurPos;
-                if (thePos == 0) {
-                    const int theTail = min(theStrideHead, mStripeSize);
-                    theStrideHead -= theTail;
-                    const int theBufSize = theBuf.BytesConsumable();
-                    thePendingCount += theBufSize;
-                    theSkip = theBufSize - (theSize + theTail);
-                    theIt   = theBuf.begin();
-                    mBuffersPtr[i].mWriteLen = theSkip + theSize;
-                } else {
+                IOBuffer&           theBuf  = inJob.mBuffersPtr[i].mBuffer;
+                IOBuffer::iterator& theIt   = inJob.mBuffersPtr[i].mCurIt;
+                int&                theSkip = inJob.mBuffersPtr[i].mCurPos;
+                if (thePos != 0) {
                     theSkip += thePrevLen;
                 }
                 int theBufSize;
@@ -853,8 +1020,8 @@ private:
                 );
                 const char* const thePtr = theIt->Consumer() + theSkip;
                 if (theBufSize < kAlign) {
-                    char* theDestPtr = GetTempBufPtr(i);
-                    mBufPtr[i] = memcpy(theDestPtr, thePtr, theBufSize);
+                    char* theDestPtr = inJob.GetTempBufPtr(i);
+                    theBufPtr[i] = memcpy(theDestPtr, thePtr, theBufSize);
                     theDestPtr += theBufSize;
                     int theRem = kAlign - theBufSize;
                     do {
@@ -871,9 +1038,10 @@ private:
                     theLen = min(theLen, theBufSize);
                     if ((thePtr - kNullCharPtr) % kAlign != 0) {
                         theLen = min((int)kTempBufSize, theLen);
-                        mBufPtr[i] = memcpy(GetTempBufPtr(i), thePtr, theLen);
+                        theBufPtr[i] = memcpy(
+                            inJob.GetTempBufPtr(i), thePtr, theLen);
                     } else {
-                        mBufPtr[i] = const_cast<char*>(thePtr);
+                        theBufPtr[i] = const_cast<char*>(thePtr);
                     }
                 }
             }
@@ -881,65 +1049,79 @@ private:
             if (thePos == 0 || thePos + theLen == theSize) {
                 KFS_LOG_STREAM_DEBUG << mLogPrefix <<
                     " recovery:"
-                    " off: " << mRecoveryEndPos <<
+                    " off: " << inJob.mOffset <<
                     " pos: " << thePos <<
                     " len: " << theLen <<
                 KFS_LOG_EOM;
             }
             const int theStatus = mEncoderPtr->Encode(
-                mStripeCount, mRecoveryStripeCount, theLen, mBufPtr);
+                mStripeCount, mRecoveryStripeCount, theLen, theBufPtr);
             if (theStatus != 0) {
                 KFS_LOG_STREAM_ERROR << mLogPrefix <<
                     " recovery:"
                     " encode error: " << theStatus <<
-                    " off: "          << mRecoveryEndPos <<
+                    " off: "          << inJob.mOffset <<
                     " pos: "          << thePos <<
                     " len: "          << theLen <<
                 KFS_LOG_EOM;
-                return false;
+                return theStatus;
             }
             for (int i = mStripeCount;
                     i < mStripeCount + mRecoveryStripeCount;
                     i++) {
-                mBufPtr[i] = reinterpret_cast<char*>(mBufPtr[i]) + theLen;
+                theBufPtr[i] = reinterpret_cast<char*>(theBufPtr[i]) + theLen;
             }
             thePos += theLen;
             thePrevLen = theLen;
         }
-        if (IOBuffer::IsDebugVerify()) {
+        return 0;
+    }
+    void CompleteEncodeJob(
+        EncodeJob& inJob)
+    {
+        if (inJob.mStatus != 0) {
+            if (mEncodeStatus == 0) {
+                mEncodeStatus = inJob.mStatus;
+            }
+        } else if (mEncodeStatus == 0) {
+            // Make the recovery stripes available for writing.
             for (int i = mStripeCount;
                     i < mStripeCount + mRecoveryStripeCount;
                     i++) {
-                IOBuffer&          theBuf = mBuffersPtr[i].mBuffer;
-                IOBuffer::iterator theIt  = theBuf.end();
-                QCVERIFY(
-                    theIt-- != theBuf.begin() &&
-                    theSize == mBuffersPtr[i].mBuffer.CopyInOnlyIntoBufferAtPos(
-                        theIt->Producer(), theSize, theIt
-                ));
+                mBuffersPtr[i].mWriteLen += inJob.mSize;
             }
         }
-        mRecoveryEndPos += theTotalSize;
-        if (mLastPartialFlushPos + mStrideSize > mRecoveryEndPos) {
-            // The partial stride was previously written / flushed.
-            int theHead = (int)(
-                mLastPartialFlushPos + mStrideSize - mRecoveryEndPos);
-            QCRTASSERT(theHead > 0 && theHead < mStrideSize);
-            if (ioPaddSizeWriteFrontTrimPtr) {
-                *ioPaddSizeWriteFrontTrimPtr = theHead;
-                // Do not trim if padded, the caller will do the trimming.
-                theHead = 0;
-            }
-            // Trim only the data buffers, as the recovery stripes may have
-            // changed.
-            for (int i = 0; i < mStripeCount && theHead > 0; i++) {
-                QCASSERT(mBuffersPtr[i].mBuffer.BytesConsumable() >=
-                    min(theHead, mStripeSize));
-                TrimBufferFront(mBuffersPtr[i], theHead, thePendingCount);
+        delete &inJob;
+    }
+    void EncodeDone(
+        EncodeJob& inJob)
+    {
+        inJob.mDoneFlag = true;
+        // Complete jobs in the queue order, the recovery stripes must be
+        // written sequentially.
+        bool       theCompletedFlag = false;
+        EncodeJob* theJobPtr;
+        while ((theJobPtr = EncodeJobs::Front(mEncodeJobs)) &&
+                theJobPtr->mDoneFlag) {
+            EncodeJobs::Remove(mEncodeJobs, *theJobPtr);
+            CompleteEncodeJob(*theJobPtr);
+            theCompletedFlag = true;
+        }
+        if (theCompletedFlag) {
+            // Restart write, the striper might be deleted by the invocation.
+            StartWrite();
+        }
+    }
+    bool WaitForEncodeJobs()
+    {
+        EncodeJob* theJobPtr;
+        while ((theJobPtr = EncodeJobs::PopFront(mEncodeJobs))) {
+            if (! theJobPtr->mDoneFlag) {
+                mEncoderPoolPtr->Wait(*theJobPtr);
             }
+            CompleteEncodeJob(*theJobPtr);
         }
-        mPendingCount = thePendingCount;
-        return true;
+        return (mEncodeStatus == 0);
     }
     void TrimBufferFront(
         Buffer& inBuf,
@@ -1460,6 +1642,7 @@ private:
         kfsChunkId_t mChunkId;
         int64_t      mChunkVersion;
         int64_t      mChunkSize;
+        bool         mLocalRepairSkipFlag;
 
         Buffer(
             Request& inRequest,
@@ -1471,7 +1654,8 @@ private:
               mBufR(*this),
               mChunkId(-1),
               mChunkVersion(-1),
-              mChunkSize(0)
+              mChunkSize(0),
+              mLocalRepairSkipFlag(false)
             {}
         ~Buffer()
             {}
@@ -1480,8 +1664,9 @@ private:
             mBufL.Clear();
             mBuf.Clear();
             mBufR.Clear();
-            mPos       = -1;
-            mChunkSize = 0;
+            mPos                 = -1;
+            mChunkSize           = 0;
+            mLocalRepairSkipFlag = false;
         }
         int GetStripeIdx() const
             { return mRequest.GetStripeIdx(*this); }
@@ -1796,6 +1981,7 @@ private:
         int       mRecursionCount;
         int       mRecoverySize;
         int       mBadStripeCount;
+        int       mLocalRepairCnt;
 
         static Request& Create(
             Outer&    inOuter,
@@ -1860,6 +2046,7 @@ private:
             mRecursionCount = 0;
             mRecoverySize   = 0;
             mBadStripeCount = 0;
+            mLocalRepairCnt = 0;
             const int theBufCount = inOuter.GetBufferCount();
             for (int i = 0; i < theBufCount; i++) {
                 GetBuffer(i).Clear();
@@ -1895,7 +2082,7 @@ private:
                     " round: "       << mRecoveryRound    <<
                 KFS_LOG_EOM;
                 if (inNewFailureFlag && mRecoveryRound <= 0 &&
-                        Recovery(inOuter)) {
+                        Recovery(inOuter, theStripeIdx)) {
                     return;
                 }
             } else if (mRecoveryRound > 0 &&
@@ -1933,9 +2120,16 @@ private:
         void Read(
             Outer& inOuter)
         {
-            if (mRecursionCount > 0 ||
-                    mPendingCount <= 0 ||
-                    mInFlightCount >= mPendingCount) {
+            if (mRecursionCount > 0) {
+                return;
+            }
+            if (mPendingCount <= 0) {
+                // Nothing to read, all data was retrieved from the recovery
+                // cache.
+                Done(inOuter);
+                return;
+            }
+            if (mInFlightCount >= mPendingCount) {
                 return;
             }
             mRecursionCount++;
@@ -1956,7 +2150,8 @@ private:
         bool IsFailed() const
             { return Outer::IsFailure(mStatus); }
         void InitRecovery(
-            Outer& inOuter)
+            Outer&     inOuter,
+            const int* inReadPtr = 0)
         {
             if (mSize <= 0 || mRecoverySize > 0) {
                 return;
@@ -1971,6 +2166,10 @@ private:
                     "failed to start recovery: invalid request");
                 return;
             }
+            if (inOuter.mRecoverStripeIdx < 0) {
+                mRecoverySize = inOuter.GetRecoveryReadAheadSize(
+                    mRecoveryPos, mRecoverySize);
+            }
             KFS_LOG_STREAM_INFO << inOuter.mLogPrefix <<
                 "init recovery:"
                 " req: "  << mPos                 <<
@@ -1980,13 +2179,57 @@ private:
                 " [" << GetChunkPos(mRecoveryPos) << "," <<
                         (GetChunkPos(mRecoveryPos) + mRecoverySize) << ")" <<
             KFS_LOG_EOM;
-            Offset theOffset = mRecoveryPos;
-            for (int i = 0; i < inOuter.mStripeCount; i++) {
-                mPendingCount += GetBuffer(i).InitRecoveryRead(
-                    inOuter, theOffset, mRecoverySize);
+            const int theCnt = inReadPtr ?
+                inOuter.GetBufferCount() : inOuter.mStripeCount;
+            Offset    theOffset = mRecoveryPos;
+            for (int i = 0; i < theCnt; i++) {
+                if (! inReadPtr || inReadPtr[i]) {
+                    mPendingCount += GetBuffer(i).InitRecoveryRead(
+                        inOuter, theOffset, mRecoverySize);
+                }
                 theOffset += (Offset)CHUNKSIZE;
             }
         }
+        // Degraded read with one bad data stripe: read only the local repair
+        // group, and the local recovery stripe, if the decoder supports local
+        // repair. The reads of the stripes outside of the group proceed as is.
+        bool InitLocalRepair(
+            Outer& inOuter,
+            int    inBadStripeIdx)
+        {
+            if (0 <= inOuter.mRecoverStripeIdx || 0 < mRecoverySize ||
+                    mBadStripeCount != 1 || inBadStripeIdx < 0 ||
+                    inOuter.mStripeCount <= inBadStripeIdx) {
+                return false;
+            }
+            const int          theCnt = inOuter.GetBufferCount();
+            StBufferT<int, 32> theTmpBuf;
+            int* const         theReadPtr    = theTmpBuf.Resize(theCnt);
+            const int          theMissingCnt =
+                inOuter.GetLocalRepairReads(inBadStripeIdx, theReadPtr);
+            if (theMissingCnt <= 0) {
+                return false;
+            }
+            // Extend the failed read too, in order to recover the whole range.
+            theReadPtr[inBadStripeIdx] = 1;
+            InitRecovery(inOuter, theReadPtr);
+            if (mRecoverySize <= 0) {
+                return false;
+            }
+            for (int i = 0; i < inOuter.mStripeCount; i++) {
+                GetBuffer(i).mLocalRepairSkipFlag = ! theReadPtr[i];
+            }
+            mLocalRepairCnt = theMissingCnt;
+            KFS_LOG_STREAM_DEBUG << inOuter.mLogPrefix <<
+                "local repair:"
+                " req: "    << mPos           <<
+                ","         << mSize          <<
+                " stripe: " << inBadStripeIdx <<
+                " reads: "  << (theCnt - theMissingCnt) <<
+                " of: "     << theCnt         <<
+            KFS_LOG_EOM;
+            return true;
+        }
 
     private:
         Request* mPrevPtr[1];
@@ -2007,17 +2250,28 @@ private:
               mRecoveryRound(0),
               mRecursionCount(0),
               mRecoverySize(0),
-              mBadStripeCount(0)
+              mBadStripeCount(0),
+              mLocalRepairCnt(0)
             { Requests::Init(*this); }
         ~Request()
             {}
         bool Recovery(
-            Outer& inOuter)
+            Outer& inOuter,
+            int    inStripeIdx)
         {
             if (++mBadStripeCount > inOuter.mRecoveryStripeCount) {
                 return false;
             }
+            if (0 < mLocalRepairCnt) {
+                // Local repair recovers only one stripe, FinishRecovery() will
+                // fail, and the retry round will read all stripes.
+                return false;
+            }
             if (mBadStripeCount <= 1 && mRecoverySize <= 0) {
+                if (InitLocalRepair(inOuter, inStripeIdx)) {
+                    Read(inOuter);
+                    return true;
+                }
                 InitRecovery(inOuter);
             }
             if (mRecoverySize <= 0) {
@@ -2067,7 +2321,9 @@ private:
                                     "get remaining stripes")    <<
                         KFS_LOG_EOM;
                         mRecoveryRound++;
-                        mStatus = 0;
+                        mStatus         = 0;
+                        // Fall back to the recovery from all stripes.
+                        mLocalRepairCnt = 0;
                         int theInvalidChunkSizeCount = 0;
                         for (int i = 0; i < theBufCount; i++) {
                             Buffer&   theBuf    = GetBuffer(i);
@@ -2075,6 +2331,19 @@ private:
                             if (theStatus == kErrorInvalidChunkSizes ||
                                     theStatus == kErrorInvalChunkSize) {
                                 theInvalidChunkSizeCount++;
+                            } else if (theBuf.mLocalRepairSkipFlag) {
+                                // Extend the read outside of the local repair
+                                // group to the recovery range.
+                                theBuf.mLocalRepairSkipFlag = false;
+                                if (theStatus == 0 &&
+                                        theBuf.GetSize() != mRecoverySize) {
+                                    mBadStripeCount++;
+                                }
+                                mPendingCount += theBuf.Retry();
+                                mPendingCount += theBuf.InitRecoveryRead(
+                                    inOuter,
+                                    mRecoveryPos + i * (Offset)CHUNKSIZE,
+                                    mRecoverySize);
                             } else {
                                 if (theStatus == 0 &&
                                         theBuf.GetSize() != mRecoverySize) {
@@ -2321,6 +2590,7 @@ private:
         Offset    mChunkBlockStartPos;
         int       mSize;
         int       mMissingCnt;
+        bool      mLocalRepairFlag;
         StripeIdx mMissingIdx[kMaxRecoveryStripes];
 
         RecoveryInfo()
@@ -2328,7 +2598,8 @@ private:
               mPos(-1),
               mChunkBlockStartPos(-1),
               mSize(0),
-              mMissingCnt(0)
+              mMissingCnt(0),
+              mLocalRepairFlag(false)
             {}
         void ClearBuffer()
         {
@@ -2341,6 +2612,7 @@ private:
             ClearBuffer();
             mMissingCnt         = 0;
             mChunkBlockStartPos = -1;
+            mLocalRepairFlag    = false;
         }
         void Set(
             Outer&   inOuter,
@@ -2352,9 +2624,14 @@ private:
                 Clear();
                 return;
             }
+            if (mLocalRepairFlag && 0 < inRequest.mLocalRepairCnt) {
+                // Local repair succeeded, use it for the rest of the block.
+                return;
+            }
             mPos                = inRequest.mPos;
             mChunkBlockStartPos = mPos - mPos % inOuter.mChunkBlockSize;
             mMissingCnt         = 0;
+            mLocalRepairFlag    = false;
             const int theBufCount = inOuter.GetBufferCount();
             for (int i = 0;
                     i < theBufCount &&
@@ -2388,6 +2665,9 @@ private:
             Clear();
             mPos                = inPos;
             mChunkBlockStartPos = mPos - mPos % inOuter.mChunkBlockSize;
+            if (SetLocalRepair(inOuter, inBadStripeIdx)) {
+                return;
+            }
             const int theCnt    = inOuter.GetBufferCount();
             StBufferT<StripeIdx, (32 + 1) * 2> theTmpBuf;
             StripeIdx* const theSwappedIdx = theTmpBuf.Resize(
@@ -2464,6 +2744,7 @@ private:
                 inRequest.mBadStripeCount == 0 &&
                 inRequest.mInFlightCount == 0
             );
+            inRequest.mLocalRepairCnt = mLocalRepairFlag ? mMissingCnt : 0;
             const int theBufCount = inOuter.GetBufferCount();
             int i;
             for (i = 0; ; i++) {
@@ -2478,6 +2759,11 @@ private:
                                 inOuter.mStripeCount)) {
                         break;
                     }
+                    if (mMissingCnt == 1 && inRequest.InitLocalRepair(
+                            inOuter, mMissingIdx[0])) {
+                        // Local recovery stripe read is already scheduled.
+                        return;
+                    }
                     inRequest.InitRecovery(inOuter);
                     if (inRequest.mRecoverySize <= 0 ||
                             inRequest.mBadStripeCount >= mMissingCnt) {
@@ -2511,8 +2797,12 @@ private:
             if (inRequest.mRecoverySize <= 0) {
                 return;
             }
+            // With local repair read all recovery stripes not in the missing
+            // list, as the local parity might not be the first one.
             for (int l = 0, k = inOuter.mStripeCount;
-                    l < inRequest.mBadStripeCount && k < theBufCount;
+                    (l < inRequest.mBadStripeCount ||
+                        0 < inRequest.mLocalRepairCnt) &&
+                    k < theBufCount;
                     l++, k++) {
                 Buffer& theBuf = inRequest.GetBuffer(k);
                 inRequest.mPendingCount += theBuf.InitRecoveryRead(
@@ -2543,6 +2833,33 @@ private:
             }
         }
     private:
+        // Declare all stripes but the local repair group of the recovered
+        // stripe missing, if the decoder supports local repair.
+        bool SetLocalRepair(
+            Outer& inOuter,
+            int    inBadStripeIdx)
+        {
+            const int          theCnt = inOuter.GetBufferCount();
+            StBufferT<int, 32> theTmpBuf;
+            int* const         theReadPtr = theTmpBuf.Resize(theCnt);
+            if (inOuter.GetLocalRepairReads(inBadStripeIdx, theReadPtr) <= 0) {
+                return false;
+            }
+            for (int i = 0; i < theCnt; i++) {
+                if (! theReadPtr[i]) {
+                    mMissingIdx[mMissingCnt++] = i;
+                }
+            }
+            mLocalRepairFlag = true;
+            KFS_LOG_STREAM_DEBUG << inOuter.mLogPrefix <<
+                "local repair:"
+                " pos: "    << mPos            <<
+                " stripe: " << inBadStripeIdx  <<
+                " reads: "  << (theCnt - mMissingCnt) <<
+                " of: "     << theCnt          <<
+            KFS_LOG_EOM;
+            return true;
+        }
         RecoveryInfo(
             const RecoveryInfo& inInfo);
         RecoveryInfo& operator=(
@@ -2550,6 +2867,125 @@ private:
     };
     friend class RecoveryInfo;
 
+    // Recently recovered stripes cache. Sequential reads smaller than the
+    // stride recover the same chunk range for every request. The cache, along
+    // with the recovery read ahead, allows to read and decode each range once,
+    // and serve the subsequent requests in the range from the cache.
+    class RecoveryCache
+    {
+    public:
+        enum { kMaxSize = 16 << 20 };
+
+        RecoveryCache()
+            : mSize(0)
+            { Entries::Init(mList); }
+        ~RecoveryCache()
+            { Clear(); }
+        void Clear()
+        {
+            Entry* thePtr;
+            while ((thePtr = Entries::PopFront(mList))) {
+                delete thePtr;
+            }
+            mSize = 0;
+        }
+        bool IsEmpty() const
+            { return Entries::IsEmpty(mList); }
+        void Put(
+            Offset          inPos,
+            const IOBuffer& inBuffer,
+            int             inSize)
+        {
+            const int theSize = min(inSize, inBuffer.BytesConsumable());
+            if (theSize <= 0) {
+                return;
+            }
+            Entries::Iterator theIt(mList);
+            Entry*            thePtr;
+            while ((thePtr = theIt.Next())) {
+                if (thePtr->mPos == inPos) {
+                    Remove(*thePtr);
+                    break;
+                }
+            }
+            IOBufferData theData = NewDataBuffer(theSize);
+            theData.Fill(inBuffer.CopyOut(theData.Producer(), theSize));
+            Entry& theEntry = *(new Entry(inPos, theData));
+            Entries::PushFront(mList, theEntry);
+            mSize += theData.BytesConsumable();
+            while (kMaxSize < mSize && Entries::Back(mList) != &theEntry) {
+                Remove(*Entries::Back(mList));
+            }
+        }
+        bool Has(
+            Offset inPos,
+            int    inSize) const
+            { return (Find(inPos, inSize) != 0); }
+        bool Get(
+            Offset    inPos,
+            int       inSize,
+            IOBuffer& inBuffer)
+        {
+            Entry* const thePtr = Find(inPos, inSize);
+            if (! thePtr) {
+                return false;
+            }
+            Entries::PushFront(mList, *thePtr);
+            inBuffer.CopyIn(
+                thePtr->mData.Consumer() + (inPos - thePtr->mPos), inSize);
+            return true;
+        }
+    private:
+        class Entry
+        {
+        public:
+            const Offset       mPos;
+            const IOBufferData mData;
+
+            Entry(
+                Offset              inPos,
+                const IOBufferData& inData)
+                : mPos(inPos),
+                  mData(inData)
+                { Entries::Init(*this); }
+        private:
+            Entry* mPrevPtr[1];
+            Entry* mNextPtr[1];
+            friend class QCDLListOp<Entry, 0>;
+        };
+        typedef QCDLList<Entry, 0> Entries;
+
+        Entry* mList[1];
+        int    mSize;
+
+        Entry* Find(
+            Offset inPos,
+            int    inSize) const
+        {
+            Entries::Iterator theIt(mList);
+            Entry*            thePtr;
+            while ((thePtr = theIt.Next())) {
+                if (thePtr->mPos <= inPos && inPos + inSize <=
+                        thePtr->mPos + thePtr->mData.BytesConsumable()) {
+                    break;
+                }
+            }
+            return thePtr;
+        }
+        void Remove(
+            Entry& inEntry)
+        {
+            Entries::Remove(mList, inEntry);
+            mSize -= inEntry.mData.BytesConsumable();
+            delete &inEntry;
+        }
+    private:
+        RecoveryCache(
+            const RecoveryCache& inCache);
+        RecoveryCache& operator=(
+            const RecoveryCache& inCache);
+    };
+
     // Chunk read request split threshold.
     const int                mMaxReadSize;
     const bool               mUseDefaultBufferAllocatorFlag;
@@ -2559,6 +2995,7 @@ private:
     const Offset             mRecoverBlockPos;
     const Offset             mRecoverChunkEndPos;
     RecoveryInfo             mRecoveryInfo;
+    RecoveryCache            mRecoveryCache;
     BufIterator*             mBufIteratorsPtr;
     IOBufferData*            mZeroBufferPtr;
     Offset                   mPendingCount;
@@ -2607,6 +3044,7 @@ private:
             inRecoverChunkPos +
             GetChunkSize(mRecoverStripeIdx, mRecoverBlockPos, mFileSize)),
           mRecoveryInfo(),
+          mRecoveryCache(),
           mBufIteratorsPtr(0),
           mZeroBufferPtr(0),
           mPendingCount(0),
@@ -2622,9 +3060,171 @@ private:
     void QueueRequest(
         Request& inRequest)
     {
-        mRecoveryInfo.Get(*this, inRequest);
+        if (! GetCachedRecovery(inRequest)) {
+            mRecoveryInfo.Get(*this, inRequest);
+        }
         Requests::PushBack(mPendingQueue, inRequest);
     }
+    bool GetCachedRecovery(
+        Request& inRequest)
+    {
+        if (0 <= mRecoverStripeIdx || mRecoveryCache.IsEmpty() ||
+                0 < inRequest.mRecoverySize ||
+                mRecoveryInfo.mLocalRepairFlag ||
+                mRecoveryInfo.mChunkBlockStartPos < 0 ||
+                inRequest.mPos < mRecoveryInfo.mChunkBlockStartPos ||
+                mRecoveryInfo.mChunkBlockStartPos + mChunkBlockSize <=
+                    inRequest.mPos) {
+            return false;
+        }
+        // Use the cache only if all missing stripes can be retrieved from
+        // it, otherwise run recovery, which updates the cache.
+        int theMissingCnt = 0;
+        for (int i = 0; i < mRecoveryInfo.mMissingCnt; i++) {
+            const int theIdx = mRecoveryInfo.mMissingIdx[i];
+            if (mStripeCount <= theIdx) {
+                continue;
+            }
+            const Buffer& theBuf = inRequest.GetBuffer(theIdx);
+            if (theBuf.mBuf.mSize <= 0) {
+                continue;
+            }
+            if (! mRecoveryCache.Has(theBuf.mPos, theBuf.mBuf.mSize)) {
+                return false;
+            }
+            theMissingCnt++;
+        }
+        if (theMissingCnt <= 0) {
+            return false;
+        }
+        int theHitCnt = 0;
+        for (int i = 0; i < mStripeCount; i++) {
+            Buffer&   theBuf  = inRequest.GetBuffer(i);
+            PBuffer&  thePBuf = theBuf.mBuf;
+            const int theSize = thePBuf.mSize;
+            if (theSize <= 0 || ! mRecoveryCache.Get(
+                    theBuf.mPos, theSize, thePBuf.mBuffer)) {
+                continue;
+            }
+            QCASSERT(inRequest.mPendingCount >= theSize);
+            thePBuf.mDoneFlag = true;
+            inRequest.mPendingCount -= theSize;
+            theHitCnt++;
+        }
+        KFS_LOG_STREAM_DEBUG << mLogPrefix <<
+            "recovery cache:"
+            " req: "     << inRequest.mPos          <<
+            ","          << inRequest.mSize         <<
+            " missing: " << theMissingCnt           <<
+            " hits: "    << theHitCnt               <<
+            " pending: " << inRequest.mPendingCount <<
+        KFS_LOG_EOM;
+        return true;
+    }
+    void PutCachedRecovery(
+        Request& inRequest)
+    {
+        if (0 <= mRecoverStripeIdx || inRequest.IsFailed() ||
+                inRequest.mRecoverySize <= 0) {
+            return;
+        }
+        for (int i = 0; i < mStripeCount; i++) {
+            const BufIterator& theIt = mBufIteratorsPtr[i];
+            if (! theIt.IsRequested()) {
+                continue;
+            }
+            // Cache only the data that was actually read or recovered, and
+            // not the zero padding, in order to preserve the end of the chunk
+            // block detection.
+            const int theSize = theIt.IsFailure() ?
+                theIt.GetBuffer().BytesConsumable() :
+                inRequest.GetBuffer(i).GetReadSize();
+            mRecoveryCache.Put(
+                inRequest.mRecoveryPos + i * (Offset)CHUNKSIZE,
+                theIt.GetBuffer(),
+                theSize
+            );
+        }
+    }
+    // Extend the recovery range in order to recover the stripes following
+    // the requested range, and serve the subsequent sequential reads from the
+    // recovery cache.
+    int GetRecoveryReadAheadSize(
+        Offset inPos,
+        int    inSize) const
+    {
+        if (mFileSize < 0) {
+            return inSize;
+        }
+        const Offset theChunkPos  = GetChunkPos(inPos);
+        const Offset theBlockPos  =
+            inPos / mChunkBlockTotalSize * mChunkBlockSize;
+        const Offset theBlockSize =
+            min(mFileSize - theBlockPos, mChunkBlockSize);
+        if (theBlockSize <= 0) {
+            return inSize;
+        }
+        const Offset theMaxReadAhead = max(Offset(mStripeSize),
+            Offset(RecoveryCache::kMaxSize / 2 / mStripeCount) /
+                mStripeSize * mStripeSize);
+        const Offset theEnd = min(
+            min((Offset)CHUNKSIZE,
+                (theBlockSize + mStrideSize - 1) / mStrideSize * mStripeSize),
+            (theChunkPos + min(Offset(mMaxReadSize), theMaxReadAhead)) /
+                mStripeSize * mStripeSize
+        );
+        return (int)max(Offset(inSize), theEnd - theChunkPos);
+    }
+    // Set the stripes that local repair of the stripe reads, and return the
+    // number of stripes that are not read, or 0 if local repair cannot be
+    // used.
+    int GetLocalRepairReads(
+        int  inStripeIdx,
+        int* outReadPtr) const
+    {
+        if (! mDecoderPtr) {
+            return 0;
+        }
+        const int          theCnt = GetBufferCount();
+        StBufferT<int, 32> theTmpBuf;
+        int* const         theIdxPtr   = theTmpBuf.Resize(theCnt);
+        const int          theLocalCnt = mDecoderPtr->GetLocalRepairStripes(
+            mStripeCount,
+            mRecoveryStripeCount,
+            inStripeIdx,
+            theIdxPtr
+        );
+        if (theLocalCnt <= 0 || mStripeCount < theLocalCnt) {
+            return 0;
+        }
+        for (int i = 0; i < theCnt; i++) {
+            outReadPtr[i] = 0;
+        }
+        for (int i = 0; i < theLocalCnt; i++) {
+            const int theIdx = theIdxPtr[i];
+            if (theIdx < 0 || theCnt <= theIdx || theIdx == inStripeIdx) {
+                return 0;
+            }
+            outReadPtr[theIdx] = 1;
+        }
+        // Read the data stripe prior to the recovered data stripe, as it
+        // might define the hole position, see RecoveryInfo::SetIfEmpty(), and
+        // the first stripe for recovery stripe restore, see
+        // InitRecoveryStripeRestore().
+        outReadPtr[inStripeIdx < mStripeCount ?
+            max(0, inStripeIdx - 1) : 0] = 1;
+        int theMissingCnt = 0;
+        for (int i = 0; i < theCnt; i++) {
+            if (! outReadPtr[i]) {
+                theMissingCnt++;
+            }
+        }
+        if (kMaxRecoveryStripes < theMissingCnt ||
+                theMissingCnt <= mRecoveryStripeCount) {
+            return 0;
+        }
+        return theMissingCnt;
+    }
     void Read()
     {
         Request* thePtr;
@@ -2765,6 +3365,7 @@ private:
         int&     ioFirstGoodRecoveryStripeIdx,
         int&     ioMaxLength,
         int*     inMissingIdxPtr,
+        int      inMaxMissingCnt,
         int&     ioEndPosIdx,
         int&     ioEndPos,
         int&     ioEndPosHead,
@@ -2777,13 +3378,13 @@ private:
         if (theIt.Set(*this, theBuf, theRdSize) != inRequest.mRecoverySize &&
                 (theIt.IsRequested() ||
                 inIdx < mStripeCount ||
-                ioMissingCnt >= mRecoveryStripeCount)) {
+                ioMissingCnt >= inMaxMissingCnt)) {
             InternalError("invalid recovery buffer length");
             inRequest.mStatus = kErrorIO;
             return false;
         }
         if (theIt.IsFailure() || ! theIt.IsRequested()) {
-            if (ioMissingCnt >= mRecoveryStripeCount) {
+            if (ioMissingCnt >= inMaxMissingCnt) {
                 KFS_LOG_STREAM_ERROR << mLogPrefix   <<
                     "read recovery failure:"
                     " req: "      << inRequest.mPos  <<
@@ -2849,7 +3450,8 @@ private:
                         for (int i = mStripeCount - 1; i >= 0; i--) {
                             Buffer&   theCBuf = inRequest.GetBuffer(i);
                             const int theSize = theCBuf.GetReadSize();
-                            if (theSize < 0) {
+                            if (theSize < 0 || (0 < inRequest.mLocalRepairCnt &&
+                                    theCBuf.mLocalRepairSkipFlag)) {
                                 continue;
                             }
                             const int theExtraSize =
@@ -3196,7 +3798,10 @@ private:
                 inRequest.mRecoverySize <= 0) {
             return;
         }
-        if (inRequest.mBadStripeCount > mRecoveryStripeCount) {
+        // With local repair all stripes but the local group are "missing".
+        const int theMaxMissingCnt =
+            max(mRecoveryStripeCount, inRequest.mLocalRepairCnt);
+        if (inRequest.mBadStripeCount > theMaxMissingCnt) {
             if (inRequest.mStatus == 0) {
                 inRequest.mStatus = kErrorIO;
             }
@@ -3216,7 +3821,7 @@ private:
             ! mDecoderPtr->SupportsOneRecoveryStripeRebuild();
         StBufferT<int, 32> theTmpBuf;
         int* const theMissingIdx     =
-            theTmpBuf.Resize(mRecoveryStripeCount + 1);
+            theTmpBuf.Resize(theMaxMissingCnt + 1);
         int        theMissingCnt     = 0;
         int        theSize           = inRequest.mRecoverySize;
         int        thePrevLen        = 0;
@@ -3230,13 +3835,39 @@ private:
         int        theEndPosHead     = -1;
         Offset     theEndChunkSize   = -1;
         Offset     theMaxChunkSize   = -1;
-        theMissingIdx[mRecoveryStripeCount] = -1; // Jerasure end of list.
+        theMissingIdx[theMaxMissingCnt] = -1; // Jerasure end of list.
         for (int thePos = 0; thePos < theSize; ) {
             int theLen = theSize - thePos;
             if (theLen > kAlign) {
                 theLen -= theLen % kAlign;
             }
             for (int i = 0; i < theBufCount; i++) {
+                if (0 < inRequest.mLocalRepairCnt &&
+                        inRequest.GetBuffer(i).mLocalRepairSkipFlag) {
+                    // Degraded read local repair: the stripe is outside of the
+                    // local group, and its read result, if any, is used as is.
+                    if (thePos == 0) {
+                        mBufIteratorsPtr[i].Clear();
+                        if (inRequest.GetBuffer(i).IsFailed() ||
+                                theMaxMissingCnt <= theMissingCnt) {
+                            KFS_LOG_STREAM_INFO << mLogPrefix <<
+                                "read recovery: local repair failure:"
+                                " req: "    << inRequest.mPos  <<
+                                ","         << inRequest.mSize <<
+                                " stripe: " << i               <<
+                            KFS_LOG_EOM;
+                            inRequest.mStatus = kErrorIO;
+                            for (int k = 0; k < i; k++) {
+                                mBufIteratorsPtr[k].Clear();
+                            }
+                            mRecoveryInfo.Set(*this, inRequest);
+                            return;
+                        }
+                        theMissingIdx[theMissingCnt++] = i;
+                    }
+                    mBufPtr[i] = 0;
+                    continue;
+                }
                 if (thePos == 0 &&
                     ! SetBufIterator(
                         inRequest,
@@ -3247,6 +3878,7 @@ private:
                         theRecovIdx,
                         theLen,
                         theMissingIdx,
+                        theMaxMissingCnt,
                         theEndPosIdx,
                         theEndPos,
                         theEndPosHead,
@@ -3263,6 +3895,15 @@ private:
                     return;
                 }
                 BufIterator& theIt = mBufIteratorsPtr[i];
+                if (0 < inRequest.mLocalRepairCnt && 0 <= mRecoverStripeIdx &&
+                        i < mStripeCount && i != mRecoverStripeIdx &&
+                        (theIt.IsFailure() || ! theIt.IsRequested())) {
+                    // Local repair: the stripe is not in the local group,
+                    // and does not need to be recovered.
+                    theIt.Clear();
+                    mBufPtr[i] = 0;
+                    continue;
+                }
                 if (i >= mStripeCount &&
                         (theIt.IsFailure() || ! theIt.IsRequested())) {
                     if (mRecoverStripeIdx < mStripeCount) {
@@ -3409,11 +4050,11 @@ private:
                     }
                 }
                 QCASSERT(
-                    theMissingCnt == mRecoveryStripeCount ||
+                    theMissingCnt == theMaxMissingCnt ||
                     inRequest.mRecoveryRound > 0
                 );
                 for (int i = theBufCount - 1;
-                        theMissingCnt < mRecoveryStripeCount &&
+                        theMissingCnt < theMaxMissingCnt &&
                             mStripeCount <= i;
                         i--) {
                     if (mBufPtr[i]) {
@@ -3460,7 +4101,7 @@ private:
             QCRTASSERT(
                 theLen > 0 &&
                 (theLen % kAlign == 0 || theLen < kAlign) &&
-                theMissingCnt == mRecoveryStripeCount
+                theMissingCnt == theMaxMissingCnt
             );
             if (thePos == 0 || thePos + theLen >= theSize) {
                 KFS_LOG_STREAM_INFO << mLogPrefix       <<
@@ -3515,8 +4156,22 @@ private:
             thePos += theLen;
             thePrevLen = theLen;
         }
+        PutCachedRecovery(inRequest);
         mRecoveryInfo.Set(*this, inRequest);
         for (int i = 0; i < mStripeCount; i++) {
+            if (0 < inRequest.mLocalRepairCnt &&
+                    inRequest.GetBuffer(i).mLocalRepairSkipFlag) {
+                // Outside of the degraded read local group, the read result
+                // is already there.
+                continue;
+            }
+            if (0 < inRequest.mLocalRepairCnt && 0 <= mRecoverStripeIdx &&
+                    i != mRecoverStripeIdx &&
+                    ! mBufIteratorsPtr[i].IsRequested()) {
+                // Not read and not recovered by local repair.
+                inRequest.GetBuffer(i).Clear();
+                continue;
+            }
             mBufIteratorsPtr[i].SetRecoveryResult(inRequest.GetBuffer(i));
         }
         for (int i = mStripeCount; i < theBufCount; i++) {
@@ -3783,7 +4438,8 @@ RSStriperCreate(
     const string&            inLogPrefix,
     Writer::Striper::Impl&   inOuter,
     Writer::Striper::Offset& outOpenChunkBlockSize,
-    string&                  outErrMsg)
+    string&                  outErrMsg,
+    ECEncoderPool*           inEncoderPoolPtr)
 {
     return RSWriteStriper::Create(
         inType,
@@ -3794,7 +4450,8 @@ RSStriperCreate(
         inLogPrefix,
         inOuter,
         outOpenChunkBlockSize,
-        outErrMsg
+        outErrMsg,
+        inEncoderPoolPtr
     );
 }
 
@@ -44,7 +44,8 @@ Writer::Striper* RSStriperCreate(
     const string&            inLogPrefix,
     Writer::Striper::Impl&   inOuter,
     Writer::Striper::Offset& outOpenChunkBlockSize,
-    string&                  outErrMsg);
+    string&                  outErrMsg,
+    ECEncoderPool*           inEncoderPoolPtr);
 
 Reader::Striper* RSStriperCreate(
     int                      inType,
@@ -131,7 +131,8 @@ public:
           mNetManager(mMetaServer.GetNetManager()),
           mStriperPtr(0),
           mCompletionDepthCount(0),
-          mReplicaCount(-1)
+          mReplicaCount(-1),
+          mIoPriority(kKfsIoPriorityHigh)
         { Readers::Init(mReaders); }
     int Open(
         kfsFileId_t inFileId,
@@ -201,6 +202,9 @@ public:
         mErrorCode          = 0;
         mFileId             = inFileId;
         mFailShortReadsFlag = inFailShortReadsFlag;
+        // Chunk recovery reads are background io for the chunk servers.
+        mIoPriority         = inRecoverChunkPos < 0 ?
+            kKfsIoPriorityHigh : kKfsIoPriorityLow;
         return 0;
     }
     int Close()
@@ -366,6 +370,7 @@ private:
                 numBytes                   = inOpSize;
                 offset                     = inOffset;
                 skipVerifyDiskChecksumFlag = true;
+                acceptChecksumType         = kKfsChecksumTypeCrc32c;
             }
             void Delete(
                 ReadOp** inQueuePtr)
@@ -567,6 +572,7 @@ private:
                     inRetryIfFailsFlag,
                     inFailShortReadFlag
                 ));
+                theOp.ioPriority = mOuter.mIoPriority;
                 if (! inRetryIfFailsFlag) {
                     mOpsNoRetryCount++;
                 }
@@ -1420,6 +1426,21 @@ private:
             if (inOp.contentLength <= 0 && inOp.checksums.empty()) {
                 return true;
             }
+            if (inOp.checksumType != kKfsChecksumTypeAdler32 &&
+                    inOp.checksumType != inOp.acceptChecksumType) {
+                KFS_LOG_STREAM_ERROR << mLogPrefix <<
+                    "invalid checksum type:"
+                    " chunk: "    << inOp.chunkId <<
+                    " version: "  << inOp.chunkVersion <<
+                    " type: "     << inOp.checksumType <<
+                KFS_LOG_EOM;
+                inOp.status    = kErrorChecksum;
+                inOp.statusMsg = "invalid checksum type";
+                return false;
+            }
+            const KfsChecksumType theType      =
+                (KfsChecksumType)inOp.checksumType;
+            const uint32_t        theNullCksum = KfsNullChecksum(theType);
             if (inOp.skipVerifyDiskChecksumFlag) {
                 vector<uint32_t>::const_iterator const theOpEndIt =
                     inOp.checksums.end();
@@ -1431,13 +1452,13 @@ private:
                 const char*              thePtr       = 0;
                 const char*              theEndPtr    = 0;
                 size_t                   theIdx       = 0;
-                uint32_t                 theChecksum  = kKfsNullChecksum;
+                uint32_t                 theChecksum  = theNullCksum;
                 bool                     theErrorFlag = false;
                 int                      theLen       = min(theTLen,
                     (int)(CHECKSUM_BLOCKSIZE -
                         inOp.offset % CHECKSUM_BLOCKSIZE));
                 while (0 < theLen) {
-                    theChecksum = kKfsNullChecksum;
+                    theChecksum = theNullCksum;
                     int theRem = theLen;
                     for ( ; ; ) {
                         if (theEndPtr <= thePtr) {
@@ -1454,7 +1475,7 @@ private:
                             continue;
                         }
                         theChecksum = ComputeBlockChecksum(
-                            theChecksum, thePtr, (size_t)theBLen);
+                            theChecksum, thePtr, (size_t)theBLen, theType);
                         thePtr += theBLen;
                         if ((theRem -= theBLen) <= 0) {
                             break;
@@ -1495,8 +1516,9 @@ private:
                 inOp.statusMsg = "received checksum mismatch";
                 return false;
             }
-            vector<uint32_t> const theChecksums =
-                    ComputeChecksums(&inOp.mTmpBuffer, inOp.contentLength);
+            vector<uint32_t> const theChecksums = ComputeChecksums(
+                &inOp.mTmpBuffer, inOp.contentLength, 0, CHECKSUM_BLOCKSIZE,
+                theType);
             if (theChecksums == inOp.checksums) {
                 return true;
             }
@@ -2228,6 +2250,7 @@ private:
     Striper*            mStriperPtr;
     int                 mCompletionDepthCount;
     int                 mReplicaCount;
+    int                 mIoPriority;
     ChunkReader*        mReaders[1];
 
     void InternalError(
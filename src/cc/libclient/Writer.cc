@@ -83,18 +83,19 @@ public:
     };
 
     Impl(
-        Writer&       inOuter,
-        MetaServer&   inMetaServer,
-        Completion*   inCompletionPtr,
-        int           inMaxRetryCount,
-        int           inWriteThreshold,
-        int           inMaxPartialBuffersCount,
-        int           inTimeSecBetweenRetries,
-        int           inOpTimeoutSec,
-        int           inIdleTimeoutSec,
-        int           inMaxWriteSize,
-        const string& inLogPrefix,
-        int64_t       inChunkServerInitialSeqNum)
+        Writer&        inOuter,
+        MetaServer&    inMetaServer,
+        Completion*    inCompletionPtr,
+        int            inMaxRetryCount,
+        int            inWriteThreshold,
+        int            inMaxPartialBuffersCount,
+        int            inTimeSecBetweenRetries,
+        int            inOpTimeoutSec,
+        int            inIdleTimeoutSec,
+        int            inMaxWriteSize,
+        const string&  inLogPrefix,
+        int64_t        inChunkServerInitialSeqNum,
+        ECEncoderPool* inEncoderPoolPtr)
         : QCRefCountedObj(),
           ITimeout(),
           KfsNetClient::OpOwner(),
@@ -131,6 +132,7 @@ public:
           mOpStartTime(0),
           mCompletionDepthCount(0),
           mStriperProcessCount(0),
+          mEncoderPoolPtr(inEncoderPoolPtr),
           mStriperPtr(0)
         { Writers::Init(mWriters); }
     int Open(
@@ -176,7 +178,8 @@ public:
             mLogPrefix,
             *this,
             mOpenChunkBlockSize,
-            theErrMsg
+            theErrMsg,
+            mEncoderPoolPtr
         );
         if (! theErrMsg.empty()) {
             KFS_LOG_STREAM_ERROR << mLogPrefix <<
@@ -1733,6 +1736,7 @@ private:
     time_t              mOpStartTime;
     int                 mCompletionDepthCount;
     int                 mStriperProcessCount;
+    ECEncoderPool*      mEncoderPoolPtr;
     Striper*            mStriperPtr;
     ChunkWriter*        mWriters[1];
 
@@ -2117,7 +2121,8 @@ Writer::Striper::Create(
     const string&            inLogPrefix,
     Writer::Striper::Impl&   inOuter,
     Writer::Striper::Offset& outOpenChunkBlockSize,
-    string&                  outErrMsg)
+    string&                  outErrMsg,
+    ECEncoderPool*           inEncoderPoolPtr)
 {
     switch (inType) {
         case KFS_STRIPED_FILE_TYPE_NONE:
@@ -2133,7 +2138,8 @@ Writer::Striper::Create(
                 inLogPrefix,
                 inOuter,
                 outOpenChunkBlockSize,
-                outErrMsg
+                outErrMsg,
+                inEncoderPoolPtr
             );
     }
     return 0;
@@ -2163,6 +2169,15 @@ Writer::Striper::StartQueuedWrite(
     mOuter.StartQueuedWrite(inQueuedCount);
 }
 
+void
+Writer::Striper::StartWrite()
+{
+    Impl::StRef theRef(mOuter);
+    if (mOuter.IsOpen() && mOuter.mErrorCode == 0) {
+        mOuter.StartWrite();
+    }
+}
+
 Writer::Writer(
     Writer::MetaServer& inMetaServer,
     Writer::Completion* inCompletionPtr               /* = 0 */,
@@ -2174,7 +2189,8 @@ Writer::Writer(
     int                 inIdleTimeoutSec              /* = 5 * 30 */,
     int                 inMaxWriteSize                /* = 1 << 20 */,
     const char*         inLogPrefixPtr                /* = 0 */,
-    int64_t             inChunkServerInitialSeqNum    /* = 1 */)
+    int64_t             inChunkServerInitialSeqNum    /* = 1 */,
+    ECEncoderPool*      inEncoderPoolPtr              /* = 0 */)
     : mImpl(*new Writer::Impl(
         *this,
         inMetaServer,
@@ -2188,7 +2204,8 @@ Writer::Writer(
         inMaxWriteSize,
         (inLogPrefixPtr && inLogPrefixPtr[0]) ?
             (inLogPrefixPtr + string(" ")) : string(),
-        inChunkServerInitialSeqNum
+        inChunkServerInitialSeqNum,
+        inEncoderPoolPtr
     ))
 {
     mImpl.Ref();
@@ -40,6 +40,8 @@ namespace client
 {
 using std::string;
 
+class ECEncoderPool;
+
 // Kfs client write protocol state machine.
 class Writer
 {
@@ -138,15 +140,16 @@ public:
         typedef Writer::Impl   Impl;
         typedef Writer::Offset Offset;
         static Striper* Create(
-            int           inType,
-            int           inStripeCount,
-            int           inRecoveryStripeCount,
-            int           inStripeSize,
-            Offset        inFileSize,
-            const string& inLogPrefix,
-            Impl&         inOuter,
-            Offset&       outOpenChunkBlockSize,
-            std::string&  outErrMsg);
+            int            inType,
+            int            inStripeCount,
+            int            inRecoveryStripeCount,
+            int            inStripeSize,
+            Offset         inFileSize,
+            const string&  inLogPrefix,
+            Impl&          inOuter,
+            Offset&        outOpenChunkBlockSize,
+            std::string&   outErrMsg,
+            ECEncoderPool* inEncoderPoolPtr);
         virtual ~Striper()
             {}
         virtual int Process(
@@ -175,6 +178,7 @@ public:
             int inQueuedCount);
         bool IsWriteQueued() const
             { return mWriteQueuedFlag; }
+        void StartWrite();
     private:
         Impl& mOuter;
         bool  mWriteQueuedFlag;
@@ -186,17 +190,18 @@ public:
     };
     typedef KfsNetClient MetaServer;
     Writer(
-        MetaServer& inMetaServer,
-        Completion* inCompletionPtr            = 0,
-        int         inMaxRetryCount            = 6,
-        int         inWriteThreshold           = 1 << 20,
-        int         inMaxPartialBuffersCount   = 16,
-        int         inTimeSecBetweenRetries    = 15,
-        int         inOpTimeoutSec             = 30,
-        int         inIdleTimeoutSec           = 5 * 30,
-        int         inMaxWriteSize             = 1 << 20,
-        const char* inLogPrefixPtr             = 0,
-        int64_t     inChunkServerInitialSeqNum = 1);
+        MetaServer&    inMetaServer,
+        Completion*    inCompletionPtr            = 0,
+        int            inMaxRetryCount            = 6,
+        int            inWriteThreshold           = 1 << 20,
+        int            inMaxPartialBuffersCount   = 16,
+        int            inTimeSecBetweenRetries    = 15,
+        int            inOpTimeoutSec             = 30,
+        int            inIdleTimeoutSec           = 5 * 30,
+        int            inMaxWriteSize             = 1 << 20,
+        const char*    inLogPrefixPtr             = 0,
+        int64_t        inChunkServerInitialSeqNum = 1,
+        ECEncoderPool* inEncoderPoolPtr           = 0);
     virtual ~Writer();
     int Open(
         kfsFileId_t inFileId,
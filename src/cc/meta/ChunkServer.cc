@@ -383,6 +383,7 @@ ChunkServer::ChunkServer(const NetConnectionPtr& conn, const string& peerName)
       mAuthCtxUpdateCount(0),
       mSessionExpirationTime(TimeNow() + kMaxSessionTimeoutSec),
       mReAuthSentFlag(false),
+      mRSRepairPeersUpdateCount(-1),
       mHelloOp(0),
       mSelfPtr(),
       mSrvLoadSampler(sSrvLoadSamplerSampleCount, 0, TimeNow()),
@@ -1434,10 +1435,7 @@ ChunkServer::HandleHelloMsg(IOBuffer* iobuf, int msgLen)
         mHelloOp->notStableChunks.size()), mNumWritableDrives);
     mLastHeartbeatSent = mLastHeard;
     mHeartbeatSent     = true;
-    Enqueue(new MetaChunkHeartbeat(NextSeq(), shared_from_this(),
-            IsRetiring() ? int64_t(1) :
-                (int64_t)mChunksToEvacuate.Size()),
-        2 * sHeartbeatTimeout);
+    EnqueueHeartbeat(false);
     // Emit message to time parse.
     KFS_LOG_STREAM_INFO << GetPeerName() <<
         " submit hello" <<
@@ -1943,7 +1941,8 @@ int
 ChunkServer::ReplicateChunk(fid_t fid, chunkId_t chunkId,
     const ChunkServerPtr& dataServer, const ChunkRecoveryInfo& recoveryInfo,
     kfsSTier_t minSTier, kfsSTier_t maxSTier,
-    MetaChunkReplicate::FileRecoveryInFlightCount::iterator it)
+    MetaChunkReplicate::FileRecoveryInFlightCount::iterator it,
+    const string& rsRepairSources)
 {
     MetaChunkReplicate* const r = new MetaChunkReplicate(
         NextSeq(), shared_from_this(), fid, chunkId,
@@ -1962,6 +1961,7 @@ ChunkServer::ReplicateChunk(fid_t fid, chunkId_t chunkId,
         r->numRecoveryStripes = recoveryInfo.numRecoveryStripes;
         r->stripeSize         = recoveryInfo.stripeSize;
         r->fileSize           = recoveryInfo.fileSize;
+        r->rsRepairSources    = rsRepairSources;
         r->dataServer.reset();
         r->srcLocation.hostname.clear();
         r->srcLocation.port = sMetaClientPort;
@@ -2102,6 +2102,28 @@ ChunkServer::Restart(bool justExitFlag)
     Enqueue(new MetaChunkServerRestart(NextSeq(), shared_from_this()));
 }
 
+void
+ChunkServer::EnqueueHeartbeat(bool reAuthenticateFlag)
+{
+    MetaChunkHeartbeat* const hb = new MetaChunkHeartbeat(
+        NextSeq(),
+        shared_from_this(),
+        IsRetiring() ? int64_t(1) : (int64_t)mChunksToEvacuate.Size(),
+        reAuthenticateFlag
+    );
+    // Send the chunk server list used to validate pipelined recovery chain
+    // hops only when it changes.
+    int64_t             updateCount = -1;
+    const string* const peers       =
+        gLayoutManager.GetRSRepairPeers(updateCount);
+    if (peers && updateCount != mRSRepairPeersUpdateCount) {
+        hb->rsRepairPeersFlag     = true;
+        hb->rsRepairPeers         = *peers;
+        mRSRepairPeersUpdateCount = updateCount;
+    }
+    Enqueue(hb, 2 * sHeartbeatTimeout);
+}
+
 int
 ChunkServer::Heartbeat()
 {
@@ -2168,14 +2190,7 @@ ChunkServer::Heartbeat()
                 " vs: " << authCtx.GetUpdateCount() <<
             KFS_LOG_EOM;
         }
-        Enqueue(new MetaChunkHeartbeat(
-                NextSeq(),
-                shared_from_this(),
-                IsRetiring() ? int64_t(1) : (int64_t)mChunksToEvacuate.Size(),
-                reAuthenticateFlag
-            ),
-            2 * sHeartbeatTimeout
-        );
+        EnqueueHeartbeat(reAuthenticateFlag);
         mReAuthSentFlag = reAuthenticateFlag;
         return ((sHeartbeatTimeout >= 0 &&
                 sHeartbeatTimeout < sHeartbeatInterval) ?
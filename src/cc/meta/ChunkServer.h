@@ -421,7 +421,8 @@ public:
         const ChunkServerPtr&    dataServer,
         const ChunkRecoveryInfo& recoveryInfo,
         kfsSTier_t minSTier, kfsSTier_t maxSTier,
-        MetaChunkReplicate::FileRecoveryInFlightCount::iterator it);
+        MetaChunkReplicate::FileRecoveryInFlightCount::iterator it,
+        const string& rsRepairSources);
     /// Start write append recovery when chunk master is non operational.
     int BeginMakeChunkStable(fid_t fid, chunkId_t chunkId, seq_t chunkVersion);
     /// Notify a chunkserver that the writes to a chunk are done;
@@ -984,6 +985,7 @@ protected:
     uint64_t           mAuthCtxUpdateCount;
     time_t             mSessionExpirationTime;
     bool               mReAuthSentFlag;
+    int64_t            mRSRepairPeersUpdateCount;
     MetaHello*         mHelloOp;
     ChunkServerPtr     mSelfPtr;
     ValueSampler       mSrvLoadSampler;
@@ -1098,6 +1100,7 @@ protected:
     void FailDispatchedOps(const char* errorMsg);
     /// Periodically, send a heartbeat message to the chunk server.
     int Heartbeat();
+    void EnqueueHeartbeat(bool reAuthenticateFlag);
     int TimeoutOps();
     inline void UpdateChunkWritesPerDrive(
         int  numChunkWrites,
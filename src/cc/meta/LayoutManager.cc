@@ -1466,6 +1466,10 @@ LayoutManager::LayoutManager() :
     mMaxConcurrentWriteReplicationsPerNode(5),
     mMaxConcurrentReadReplicationsPerNode(10),
     mUseEvacuationRecoveryFlag(true),
+    mRSPipelinedRecoveryFlag(false),
+    mChunkServersUpdateCount(0),
+    mRSRepairPeersUpdateCount(-1),
+    mRSRepairPeers(),
     mReplicationFindWorkTimeouts(0),
     // Replication check 30ms/.20-30ms = 120 -- 20% cpu when idle
     mMaxTimeForChunkReplicationCheck(30 * 1000),
@@ -1753,6 +1757,9 @@ LayoutManager::SetParameters(const Properties& props, int clientPort)
     mUseEvacuationRecoveryFlag = props.getValue(
         "metaServer.useEvacuationRecoveryFlag",
         mUseEvacuationRecoveryFlag ? 1 : 0) != 0;
+    mRSPipelinedRecoveryFlag = props.getValue(
+        "metaServer.rsPipelinedRecovery",
+        mRSPipelinedRecoveryFlag ? 1 : 0) != 0;
     mFullReplicationCheckInterval = (int64_t)(props.getValue(
         "metaServer.fullReplicationCheckInterval",
         mFullReplicationCheckInterval * 1e-6) * 1e6);
@@ -2946,6 +2953,7 @@ LayoutManager::AddNewServer(MetaHello *r)
         return;
     }
     mChunkServers.insert(existing, r->server);
+    mChunkServersUpdateCount++;
 
     const uint64_t allocSpace = r->chunks.size() * CHUNKSIZE;
     srv.SetSpace(r->totalSpace, r->usedSpace, allocSpace);
@@ -3675,7 +3683,7 @@ LayoutManager::CanBeRecovered(
             }
         }
     }
-    return ((int)fa->numStripes <= goodCnt);
+    return (fa->GetMinRecoverableStripeCount() <= goodCnt);
 }
 
 typedef KeyOnly<const MetaFattr*> KeyOnlyFattrPtr;
@@ -4467,6 +4475,7 @@ LayoutManager::ServerDown(const ChunkServerPtr& server)
     }
     // Convert const_iterator to iterator below to make erase() compile.
     mChunkServers.erase(mChunkServers.begin() + (i - mChunkServers.begin()));
+    mChunkServersUpdateCount++;
     if (! mAssignMasterByIpFlag &&
             mMastersCount == 0 && ! mChunkServers.empty()) {
         assert(mSlavesCount > 0 &&
@@ -6567,7 +6576,7 @@ LayoutManager::ChunkAvailable(MetaChunkAvailable* r)
                     cblk,
                     &goodCnt) &&
                 0 <= mChunkAvailableUseReplicationOrRecoveryThreshold &&
-                (int)fa.numStripes +
+                fa.GetMinRecoverableStripeCount() +
                     mChunkAvailableUseReplicationOrRecoveryThreshold <=
                     goodCnt) {
             KFS_LOG_STREAM_DEBUG <<
@@ -8617,7 +8626,13 @@ LayoutManager::ReplicateChunk(
         bind(&ChunkServer::IsEvacuationScheduled, _1, clli.GetChunkId())
     );
     vector<kfsSTier_t>::const_iterator ti = tiers.begin();
-    int numDone = 0;
+    int    numDone = 0;
+    string rsRepairSources;
+    // Pipelined recovery requires the file size to determine the recovered
+    // chunk size, and is not supported with chunk server authentication.
+    bool   rsRepairSourcesFlag = ! mRSPipelinedRecoveryFlag ||
+        ! recoveryInfo.HasRecovery() || recoveryInfo.fileSize <= 0 ||
+        mClientCSAuthRequiredFlag;
     for (Servers::const_iterator it = candidates.begin();
             numDone < extraReplicas && it != candidates.end();
             ++it) {
@@ -8685,6 +8700,12 @@ LayoutManager::ReplicateChunk(
         FileRecoveryInFlightCount::iterator recovIt =
             mFileRecoveryInFlightCount.end();
         if (recoveryInfo.HasRecovery() && dataServer == c) {
+            if (! rsRepairSourcesFlag) {
+                rsRepairSourcesFlag = true;
+                if (! GetRSRepairSources(clli, rsRepairSources)) {
+                    rsRepairSources.clear();
+                }
+            }
             if (mClientCSAuthRequiredFlag && cs.GetAuthUid() != kKfsUserNone) {
                 recovIt = mFileRecoveryInFlightCount.insert(
                     make_pair(make_pair(cs.GetAuthUid(), clli.GetFileId()), 0)
@@ -8710,7 +8731,8 @@ LayoutManager::ReplicateChunk(
         }
         // Do not count synchronous failures.
         if (cs.ReplicateChunk(clli.GetFileId(), clli.GetChunkId(),
-                dataServer, recoveryInfo, tier, maxSTier, recovIt) == 0 &&
+                dataServer, recoveryInfo, tier, maxSTier, recovIt,
+                dataServer == c ? rsRepairSources : string()) == 0 &&
                 ! cs.IsDown()) {
             numDone++;
         }
@@ -8785,6 +8807,80 @@ LayoutManager::GetPlacementExcludes(
     return true;
 }
 
+bool
+LayoutManager::GetRSRepairSources(const CSMap::Entry& entry, string& sources)
+{
+    const MetaFattr* const fa = entry.GetFattr();
+    if (! fa->IsStriped() || fa->numRecoveryStripes <= 0) {
+        return false;
+    }
+    StTmp<vector<MetaChunkInfo*> > cinfoTmp(mChunkInfosTmp);
+    vector<MetaChunkInfo*>&        cblk   = cinfoTmp.Get();
+    const MetaChunkInfo* const     chunk  = entry.GetChunkInfo();
+    chunkOff_t                     start  = -1;
+    MetaFattr*                     mfa    = 0;
+    MetaChunkInfo*                 mci    = 0;
+    chunkOff_t                     offset = chunk->offset;
+    if (metatree.getalloc(fa->id(), offset,
+                mfa, mci, &cblk, &start) != 0 ||
+            mfa != fa || mci != chunk) {
+        return false;
+    }
+    // Each available chunk in the RS block: stripe index, chunk id, version,
+    // and location of one of its replicas.
+    const int      stripes = fa->numStripes + fa->numRecoveryStripes;
+    StTmp<Servers> serversTmp(mServers3Tmp);
+    ostringstream  os;
+    int            cnt     = 0;
+    for (vector<MetaChunkInfo*>::const_iterator it = cblk.begin();
+            it != cblk.end();
+            ++it) {
+        if (chunk == *it) {
+            continue;
+        }
+        Servers& servers = serversTmp.Get();
+        mChunkToServerMap.GetServers(GetCsEntry(**it), servers);
+        Servers::const_iterator si = servers.begin();
+        while (si != servers.end() &&
+                ((*si)->IsDown() || ! (*si)->IsResponsiveServer())) {
+            ++si;
+        }
+        if (si == servers.end()) {
+            continue;
+        }
+        os <<
+            (0 < cnt++ ? " " : "") <<
+            ((*it)->offset / (chunkOff_t)CHUNKSIZE % stripes) << " " <<
+            (*it)->chunkId      << " " <<
+            (*it)->chunkVersion << " " <<
+            (*si)->GetServerLocation();
+    }
+    sources = os.str();
+    return (0 < cnt);
+}
+
+const string*
+LayoutManager::GetRSRepairPeers(int64_t& updateCount)
+{
+    if (! mRSPipelinedRecoveryFlag) {
+        updateCount = -1;
+        return 0;
+    }
+    if (mRSRepairPeersUpdateCount != mChunkServersUpdateCount) {
+        ostringstream os;
+        for (Servers::const_iterator it = mChunkServers.begin();
+                it != mChunkServers.end();
+                ++it) {
+            os << (it == mChunkServers.begin() ? "" : " ") <<
+                (*it)->GetServerLocation();
+        }
+        mRSRepairPeers            = os.str();
+        mRSRepairPeersUpdateCount = mChunkServersUpdateCount;
+    }
+    updateCount = mRSRepairPeersUpdateCount;
+    return &mRSRepairPeers;
+}
+
 bool
 LayoutManager::CanReplicateChunkNow(
     CSMap::Entry&                  c,
@@ -8931,7 +9027,8 @@ LayoutManager::CanReplicateChunkNow(
             ++it;
         }
         if (notStable > 0 ||
-                (notStable == 0 && good < (int)fa->numStripes)) {
+                (notStable == 0 &&
+                    good < fa->GetMinRecoverableStripeCount())) {
             if (! servers.empty()) {
                 // Can not use recovery instead of replication.
                 SetReplicationState(c,
@@ -1297,6 +1297,9 @@ public:
     QCIoBufferPool* GetBufferPool()
         { return mBufferPool; }
     int64_t GetFreeIoBufferByteCount() const;
+    /// Returns the space separated list of the chunk server locations, and
+    /// its update count, or null if pipelined RS recovery is not enabled.
+    const string* GetRSRepairPeers(int64_t& updateCount);
     void Done(MetaChunkVersChange& req);
     virtual void Timeout();
     bool Validate(MetaHello& r) const;
@@ -2052,6 +2055,16 @@ protected:
     int     mMaxConcurrentWriteReplicationsPerNode;
     int     mMaxConcurrentReadReplicationsPerNode;
     bool    mUseEvacuationRecoveryFlag;
+    /// Request pipelined RS recovery, where the chunk servers hosting the
+    /// source chunks are chained, and each adds its contribution to the
+    /// partial result, instead of the recovering node reading all sources.
+    bool    mRSPipelinedRecoveryFlag;
+    /// The chunk server list update count, and the list of locations sent
+    /// to the chunk servers with pipelined RS recovery, in order to let
+    /// them validate the repair chain hops.
+    int64_t mChunkServersUpdateCount;
+    int64_t mRSRepairPeersUpdateCount;
+    string  mRSRepairPeers;
     int64_t mReplicationFindWorkTimeouts;
     /// How much do we spend on each internal RPC in chunk-replication-check to handout
     /// replication work.
@@ -2381,6 +2394,7 @@ protected:
         bool stopIfHasAnyReplicationsInFlight = false,
         vector<MetaChunkInfo*>* chunkBlock = 0);
     void ProcessInvalidStripes(MetaChunkReplicate& req);
+    bool GetRSRepairSources(const CSMap::Entry& entry, string& sources);
     RackId GetRackId(const ServerLocation& loc) const;
     RackId GetRackId(const string& loc) const;
     void ScheduleCleanup(size_t maxScanCount = 1);
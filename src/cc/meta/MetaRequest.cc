@@ -5022,6 +5022,15 @@ MetaChunkHeartbeat::request(ostream &os)
     if (reAuthenticateFlag) {
         os << "Authenticate: 1\r\n";
     }
+    if (rsRepairPeersFlag) {
+        os <<
+        "RS-repair-peers: 1\r\n"
+        "Content-length: " << rsRepairPeers.size() << "\r\n"
+        "\r\n"
+        ;
+        os.write(rsRepairPeers.data(), rsRepairPeers.size());
+        return;
+    }
     os <<
     "\r\n"
     ;
@@ -5171,6 +5180,9 @@ MetaChunkReplicate::request(ostream& os)
         if (fileSize > 0) {
             rs << "File-size: " << fileSize << "\r\n";
         }
+        if (! rsRepairSources.empty()) {
+            rs << "RS-repair-sources: " << rsRepairSources << "\r\n";
+        }
     } else {
         rs << "Chunk-location: " << srcLocation << "\r\n";
     }
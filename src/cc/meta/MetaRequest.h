@@ -1742,6 +1742,7 @@ struct MetaChunkReplicate: public MetaChunkRequest {
     MetaChunkVersChange*                versChange;
     FileRecoveryInFlightCount::iterator recovIt;
     string                              metaServerAccess;
+    string                              rsRepairSources;
     MetaChunkReplicate(seq_t n, const ChunkServerPtr& s,
             fid_t f, chunkId_t c, const ServerLocation& loc,
             const ChunkServerPtr& src, kfsSTier_t minTier, kfsSTier_t maxTier,
@@ -1768,7 +1769,8 @@ struct MetaChunkReplicate: public MetaChunkRequest {
           key(),
           versChange(0),
           recovIt(it),
-          metaServerAccess()
+          metaServerAccess(),
+          rsRepairSources()
         {}
     virtual ~MetaChunkReplicate() { assert(! versChange); }
     virtual void handle();
@@ -1877,11 +1879,15 @@ struct MetaChunkSize: public MetaChunkRequest {
 struct MetaChunkHeartbeat: public MetaChunkRequest {
     int64_t evacuateCount;
     bool    reAuthenticateFlag;
+    bool    rsRepairPeersFlag;
+    string  rsRepairPeers;
     MetaChunkHeartbeat(seq_t n, const ChunkServerPtr& s,
             int64_t evacuateCnt, bool reAuthFlag = false)
         : MetaChunkRequest(META_CHUNK_HEARTBEAT, n, false, s, -1),
           evacuateCount(evacuateCnt),
-          reAuthenticateFlag(reAuthFlag)
+          reAuthenticateFlag(reAuthFlag),
+          rsRepairPeersFlag(false),
+          rsRepairPeers()
         {}
     virtual void request(ostream &os);
     virtual ostream& ShowSelf(ostream& os) const
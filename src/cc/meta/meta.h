@@ -249,6 +249,13 @@ public:
     bool HasRecovery() const {
         return (IsStriped() && numRecoveryStripes > 0);
     }
+    // Min. number of available chunks in a chunk block that guarantees
+    // that the missing chunks can be recovered.
+    int GetMinRecoverableStripeCount() const {
+        return ((int)(numStripes + numRecoveryStripes) -
+            GetRecoveryStripeTolerance(
+                striperType, numStripes, numRecoveryStripes));
+    }
     chunkOff_t ChunkPosToChunkBlkIndex(chunkOff_t offset) const {
         const chunkOff_t idx = offset / (chunkOff_t)CHUNKSIZE;
         return (numStripes <= 0 ? idx :
@@ -42,6 +42,8 @@
 #include <unistd.h>
 #include <string.h>
 #include <dirent.h>
+#include <time.h>
+#include <sys/time.h>
 
 #ifdef QC_OS_NAME_DARWIN
 #include <sys/param.h>
@@ -71,6 +73,8 @@ public:
           mFilePendingReqCountPtr(0),
           mIoVecPtr(0),
           mFileInfoPtr(0),
+          mWriteHashPtr(0),
+          mWriteHashSize(0),
           mPendingReadBlockCount(0),
           mPendingWriteBlockCount(0),
           mPendingCloseHeadPtr(0),
@@ -96,8 +100,18 @@ public:
           mRunFlag(false),
           mRequestAffinityFlag(false),
           mSerializeMetaRequestsFlag(true),
-          mBarrierFlag(false)
-        {}
+          mBarrierFlag(false),
+          mPriorityClassesFlag(false),
+          mPriorityDeadlineFlag(false),
+          mMaxCoalescedWriteBlockCount(0),
+          mBufferPoolNumaNode(-1)
+    {
+        for (int i = 0; i < kPriorityCount; i++) {
+            mPriorityInFlightCount[i]    = 0;
+            mPriorityMaxInFlightCount[i] = 0;
+            mPriorityDeadlineNanoSec[i]  = 0;
+        }
+    }
     virtual ~Queue()
         { Queue::Stop(); }
     inline void Done(
@@ -138,7 +152,8 @@ public:
         int            inBufferCount,
         IoCompletion*  inIoCompletionPtr,
         Time           inTimeWaitNanoSec,
-        int64_t        inEofHint);
+        int64_t        inEofHint,
+        Priority       inPriority);
     bool Cancel(
         RequestId inRequestId);
     IoCompletion* CancelOrSetCompletionIfInFlight(
@@ -156,6 +171,46 @@ public:
         outReadBlockCount   = mPendingReadBlockCount;
         outWriteBlockCount  = mPendingWriteBlockCount;
     }
+    Status SetPriorityParameters(
+        Priority inPriority,
+        int      inMaxInFlightCount,
+        Time     inDeadlineNanoSec)
+    {
+        if (inPriority < 0 || kPriorityCount <= inPriority) {
+            return Status(kErrorParameter);
+        }
+        QCStMutexLocker theLocker(mMutex);
+        mPriorityMaxInFlightCount[inPriority] = Max(0, inMaxInFlightCount);
+        mPriorityDeadlineNanoSec[inPriority]  = Max(Time(0), inDeadlineNanoSec);
+        mPriorityClassesFlag  = false;
+        mPriorityDeadlineFlag = false;
+        for (int i = 0; i < kPriorityCount; i++) {
+            if (0 < mPriorityDeadlineNanoSec[i]) {
+                mPriorityDeadlineFlag = true;
+            }
+            if (0 < mPriorityMaxInFlightCount[i]) {
+                mPriorityClassesFlag = true;
+            }
+        }
+        mPriorityClassesFlag = mPriorityClassesFlag || mPriorityDeadlineFlag;
+        if (mRunFlag) {
+            // Limit might have been raised.
+            NotifyAllWithPending();
+        }
+        return Status();
+    }
+    void SetMaxCoalescedWriteBlockCount(
+        int inBlockCount)
+    {
+        QCStMutexLocker theLocker(mMutex);
+        mMaxCoalescedWriteBlockCount = Max(0, inBlockCount);
+    }
+    void SetBufferPoolNumaNode(
+        int inNode)
+    {
+        QCStMutexLocker theLocker(mMutex);
+        mBufferPoolNumaNode = inNode < 0 ? -1 : inNode;
+    }
     OpenFileStatus OpenFile(
         const char* inFileNamePtr,
         int64_t     inMaxFileSize,
@@ -175,6 +230,8 @@ public:
         Time          inTimeWaitNanoSec);
     Status AllocateFileSpace(
         FileIdx inFileIdx);
+    int DupBufferedIoFd(
+        FileIdx inFileIdx);
     EnqueueStatus Rename(
         const char*    inSrcFileNamePtr,
         const char*    inDstFileNamePtr,
@@ -251,12 +308,17 @@ private:
             : QCDiskQueue::Request(),
               mPrevIdx(0),
               mNextIdx(0),
+              mWriteNextIdx(0),
               mReqType(kReqTypeNone),
               mInFlightFlag(false),
               mFreeBuffersIfNoIoCompletionFlag(false),
+              mDequeuedFlag(false),
+              mQueuedFlag(false),
+              mPriority(kPriorityNormal),
               mBufferCount(0),
               mFileIdx(0),
               mBlockIdx(0),
+              mEnqueueTime(0),
               mIoCompletionPtr(0)
             {}
         ~Request()
@@ -267,12 +329,17 @@ private:
             { return (IsMetaReqType(mReqType)); }
         RequestIdx    mPrevIdx;
         RequestIdx    mNextIdx;
+        RequestIdx    mWriteNextIdx; // Queued writes hash chain.
         ReqType       mReqType:8;
         bool          mInFlightFlag:1;
         bool          mFreeBuffersIfNoIoCompletionFlag:1;
+        bool          mDequeuedFlag:1; // Counted in priority in flight.
+        bool          mQueuedFlag:1;   // In io queue.
+        unsigned int  mPriority:2;
         int           mBufferCount;
         uint64_t      mFileIdx:16;
         uint64_t      mBlockIdx:48;
+        Time          mEnqueueTime;
         IoCompletion* mIoCompletionPtr;
     };
 
@@ -426,17 +493,21 @@ private:
               mOpenPendingFlag(false),
               mOpenError(kOpenErrorNone),
               mClosedFlag(false),
+              mQueuedPriority(kPriorityNormal),
               mCloseFileSize(-1),
-              mThreadIdx(0)
+              mThreadIdx(0),
+              mQueuedCount(0)
             {}
-        uint64_t  mLastBlockIdx:48;
-        bool      mSpaceAllocPendingFlag:1;
-        bool      mOpenPendingFlag:1;
-        OpenError mOpenError:2;
-        bool      mClosedFlag:1;
-        bool      mBufferedIoFlag:1;
-        int64_t   mCloseFileSize;
-        int       mThreadIdx;
+        uint64_t     mLastBlockIdx:48;
+        bool         mSpaceAllocPendingFlag:1;
+        bool         mOpenPendingFlag:1;
+        OpenError    mOpenError:2;
+        bool         mClosedFlag:1;
+        bool         mBufferedIoFlag:1;
+        unsigned int mQueuedPriority:2; // Class of the queued requests.
+        int64_t      mCloseFileSize;
+        int          mThreadIdx;
+        int          mQueuedCount;      // Requests in io queue.
     };
 
     QCMutex            mMutex;
@@ -450,6 +521,8 @@ private:
     unsigned int*      mFilePendingReqCountPtr;
     struct iovec*      mIoVecPtr;
     FileInfo*          mFileInfoPtr;
+    RequestIdx*        mWriteHashPtr; // Queued writes by file and block.
+    unsigned int       mWriteHashSize;
     int64_t            mPendingReadBlockCount;
     int64_t            mPendingWriteBlockCount;
     unsigned int*      mPendingCloseHeadPtr;
@@ -477,13 +550,25 @@ private:
     bool               mSerializeMetaRequestsFlag;
     bool               mBarrierFlag; // New req. can not be processed
                                    // until in flight req. done.
-
+    bool               mPriorityClassesFlag;  // Any class limit or deadline.
+    bool               mPriorityDeadlineFlag;
+    int                mPriorityInFlightCount[kPriorityCount];
+    int                mPriorityMaxInFlightCount[kPriorityCount];
+    Time               mPriorityDeadlineNanoSec[kPriorityCount];
+    int                mMaxCoalescedWriteBlockCount;
+    int                mBufferPoolNumaNode;
+
+    // Each io queue has one list per priority class, starting at
+    // kIoQueueIdx + queue index * kPriorityCount.
     enum
     {
         kFreeQueueIdx = 0,
-        kIoQueueIdx   = 1,
-        kRequestQueueCount
+        kIoQueueIdx   = 1
     };
+    enum { kMaxCoalescedWriteCount = 64 };
+    // Max number of queued requests checked in order to determine if the
+    // coalesced write would be dispatched out of the file requests order.
+    enum { kMaxCoalesceOrderCheckCount = 256 };
     enum
     {
         kFreeFdOffset  = 2,
@@ -491,21 +576,6 @@ private:
         kOpenPendingFd = 0x7FFFFFFF
     };
 
-    static int GetOpenCommonFlags(
-        bool inBufferedIoFlag)
-    {
-#ifndef O_DIRECT
-        (void)inBufferedIoFlag;
-#endif
-        return (0
-#ifdef O_DIRECT
-        | (inBufferedIoFlag ? 0 : O_DIRECT)
-#endif
-#ifdef O_NOATIME
-        | O_NOATIME
-#endif
-        );
-    }
     char** GetBuffersPtr(
         Request& inReq)
     {
@@ -571,14 +641,46 @@ private:
     bool Empty(
         RequestIdx inIdx) const
         { return (mRequestsPtr[inIdx].mNextIdx == inIdx); }
+    static RequestIdx GetIoQueueIdx(
+        int inThreadIdx,
+        int inPriority)
+        { return RequestIdx(kIoQueueIdx + inThreadIdx * kPriorityCount +
+            inPriority); }
     bool HasPendingReq(
         int inThreadIdx) const
-        { return (! Empty(kIoQueueIdx + inThreadIdx)); }
+    {
+        const RequestIdx theIdx = GetIoQueueIdx(inThreadIdx, 0);
+        for (int i = 0; i < kPriorityCount; i++) {
+            if (! Empty(theIdx + i)) {
+                return true;
+            }
+        }
+        return false;
+    }
     bool HasPendingNonBarrierReq(
         int inThreadIdx) const
     {
-        const Request* const theReqPtr = Front(kIoQueueIdx + inThreadIdx);
-        return (theReqPtr && ! theReqPtr->IsBarrier());
+        const RequestIdx theIdx = GetIoQueueIdx(inThreadIdx, 0);
+        for (int i = 0; i < kPriorityCount; i++) {
+            const Request* const theReqPtr = Front(theIdx + i);
+            if (theReqPtr && ! theReqPtr->IsBarrier()) {
+                return true;
+            }
+        }
+        return false;
+    }
+    static Time Now()
+    {
+#ifdef CLOCK_MONOTONIC
+        struct timespec theTs;
+        if (clock_gettime(CLOCK_MONOTONIC, &theTs) == 0) {
+            return (Time(theTs.tv_sec) * 1000 * 1000 * 1000 + theTs.tv_nsec);
+        }
+#endif
+        struct timeval theTv;
+        gettimeofday(&theTv, 0);
+        return (Time(theTv.tv_sec) * 1000 * 1000 * 1000 +
+            Time(theTv.tv_usec) * 1000);
     }
     int GetReqListSize(
         Request& inReq)
@@ -610,6 +712,9 @@ private:
         mFreeCount += GetReqListSize(inReq);
         inReq.mReqType         = kReqTypeNone;
         inReq.mInFlightFlag    = false;
+        inReq.mDequeuedFlag    = false;
+        inReq.mQueuedFlag      = false;
+        inReq.mPriority        = kPriorityNormal;
         inReq.mIoCompletionPtr = 0;
         inReq.mBufferCount     = 0;
         Insert(mRequestsPtr[kFreeQueueIdx], inReq);
@@ -663,27 +768,157 @@ private:
         int      inThreadIdx)
     {
         Trace("enqueue", inReq);
-        Insert(mRequestsPtr[kIoQueueIdx + inThreadIdx], inReq);
+        // The requests are dispatched in the queue order only within the
+        // class. Place the request into the class of the file requests that
+        // are already queued, if any, in order to preserve the file requests
+        // order, including the requests queued after open.
+        // With no class limits and deadlines set all requests are placed into
+        // the same class, and dispatched in the queue order.
+        FileInfo& theInfo = mFileInfoPtr[inReq.mFileIdx];
+        if (0 < theInfo.mQueuedCount) {
+            inReq.mPriority = theInfo.mQueuedPriority;
+        } else {
+            if (! mPriorityClassesFlag) {
+                inReq.mPriority = kPriorityHigh;
+            }
+            theInfo.mQueuedPriority = inReq.mPriority;
+        }
+        theInfo.mQueuedCount++;
+        inReq.mQueuedFlag  = true;
+        inReq.mEnqueueTime = Now();
+        Insert(mRequestsPtr[GetIoQueueIdx(inThreadIdx, inReq.mPriority)],
+            inReq);
         mPendingCount++;
         mFilePendingReqCountPtr[inReq.mFileIdx]++;
         if (inReq.mReqType == kReqTypeRead) {
             mPendingReadBlockCount += inReq.mBufferCount;
         } else if (IsWriteReqType(inReq.mReqType)) {
             mPendingWriteBlockCount += inReq.mBufferCount;
+            RequestIdx& theHeadIdx =
+                mWriteHashPtr[WriteHash(inReq.mFileIdx, inReq.mBlockIdx)];
+            inReq.mWriteNextIdx = theHeadIdx;
+            theHeadIdx = RequestIdx(&inReq - mRequestsPtr);
         } else if (inReq.mReqType <= kReqTypeNone ||
                 inReq.mReqType >= kReqTypeMax) {
             QCRTASSERT(! "Bad request type");
         }
     }
+    bool CanDispatch(
+        const Request& inReq) const
+    {
+        const int theMaxCount = mPriorityMaxInFlightCount[inReq.mPriority];
+        return (theMaxCount <= 0 || inReq.IsMeta() ||
+            mPriorityInFlightCount[inReq.mPriority] < theMaxCount);
+    }
     Request* Dequeue(
-        int inThreadIdx)
+        int  inThreadIdx,
+        bool inIgnoreLimitsFlag = false)
     {
-        Request* const theReqPtr = Front(kIoQueueIdx + inThreadIdx);
+        const RequestIdx theIdx    = GetIoQueueIdx(inThreadIdx, 0);
+        Request*         theReqPtr = 0;
+        if (mPriorityDeadlineFlag && ! inIgnoreLimitsFlag) {
+            // Pick the request that is the most past its class deadline.
+            const Time theNow     = Now();
+            Time       theMaxLate = 0;
+            for (int i = 0; i < kPriorityCount; i++) {
+                Request* const thePtr = Front(theIdx + i);
+                if (! thePtr || mPriorityDeadlineNanoSec[i] <= 0) {
+                    continue;
+                }
+                const Time theLate = theNow - thePtr->mEnqueueTime -
+                    mPriorityDeadlineNanoSec[i];
+                if (0 <= theLate && (! theReqPtr || theMaxLate < theLate) &&
+                        CanDispatch(*thePtr)) {
+                    theReqPtr  = thePtr;
+                    theMaxLate = theLate;
+                }
+            }
+        }
+        for (int i = 0; ! theReqPtr && i < kPriorityCount; i++) {
+            Request* const thePtr = Front(theIdx + i);
+            if (thePtr && (inIgnoreLimitsFlag || CanDispatch(*thePtr))) {
+                theReqPtr = thePtr;
+            }
+        }
         if (theReqPtr) {
             RemoveWithSubRequests(*theReqPtr);
+            if (! inIgnoreLimitsFlag && ! theReqPtr->IsMeta()) {
+                theReqPtr->mDequeuedFlag = true;
+                mPriorityInFlightCount[theReqPtr->mPriority]++;
+            }
         }
         return theReqPtr;
     }
+    unsigned int WriteHash(
+        uint64_t inFileIdx,
+        uint64_t inBlockIdx) const
+    {
+        // Adjacent blocks map into adjacent buckets.
+        return (unsigned int)((inBlockIdx + inFileIdx * 2654435761u) &
+            (mWriteHashSize - 1));
+    }
+    void RemoveQueuedWrite(
+        Request& inReq)
+    {
+        const RequestIdx theIdx(&inReq - mRequestsPtr);
+        RequestIdx*      thePtr =
+            mWriteHashPtr + WriteHash(inReq.mFileIdx, inReq.mBlockIdx);
+        while (*thePtr != theIdx) {
+            QCASSERT(*thePtr != kFreeQueueIdx);
+            thePtr = &mRequestsPtr[*thePtr].mWriteNextIdx;
+        }
+        *thePtr = inReq.mWriteNextIdx;
+        inReq.mWriteNextIdx = kFreeQueueIdx;
+    }
+    Request* FindQueuedWrite(
+        uint64_t inFileIdx,
+        uint64_t inBlockIdx)
+    {
+        // More than one queued write to the same block means overwrite, in
+        // which case writes must be issued in the queue order.
+        Request* theRetPtr = 0;
+        for (RequestIdx theIdx =
+                    mWriteHashPtr[WriteHash(inFileIdx, inBlockIdx)];
+                theIdx != kFreeQueueIdx;
+                theIdx = mRequestsPtr[theIdx].mWriteNextIdx) {
+            Request& theReq = mRequestsPtr[theIdx];
+            if (theReq.mFileIdx == inFileIdx &&
+                    theReq.mBlockIdx == inBlockIdx) {
+                if (theRetPtr) {
+                    return 0;
+                }
+                theRetPtr = &theReq;
+            }
+        }
+        return theRetPtr;
+    }
+    bool CanDispatchBeforeQueued(
+        const Request& inReq) const
+    {
+        // Returns true if none of the requests to the same file queued before
+        // the write request is a meta request or overlaps with the write, i.e.
+        // dispatching the write ahead of these requests does not change the
+        // outcome. All queued requests of the file are in the same list, walk
+        // the list back to its head.
+        const uint64_t theEnd = inReq.mBlockIdx + inReq.mBufferCount;
+        RequestIdx     theIdx = inReq.mPrevIdx;
+        for (int i = 0; mRequestQueueCount <= (int)theIdx; i++) {
+            if (kMaxCoalesceOrderCheckCount <= i) {
+                return false;
+            }
+            const Request& theReq = mRequestsPtr[theIdx];
+            theIdx = theReq.mPrevIdx;
+            if (theReq.mReqType == kReqTypeNone ||
+                    theReq.mFileIdx != inReq.mFileIdx) {
+                continue;
+            }
+            if (theReq.IsMeta() || (theReq.mBlockIdx < theEnd &&
+                    inReq.mBlockIdx < theReq.mBlockIdx + theReq.mBufferCount)) {
+                return false;
+            }
+        }
+        return true;
+    }
     void RemoveWithSubRequests(
         Request& inReq)
     {
@@ -692,6 +927,14 @@ private:
         int      theBufCount = inReq.mBufferCount;
         Request* theNextPtr  = mRequestsPtr + inReq.mNextIdx;
         Remove(inReq);
+        if (inReq.mQueuedFlag) {
+            inReq.mQueuedFlag = false;
+            QCASSERT(0 < mFileInfoPtr[inReq.mFileIdx].mQueuedCount);
+            mFileInfoPtr[inReq.mFileIdx].mQueuedCount--;
+            if (IsWriteReqType(inReq.mReqType)) {
+                RemoveQueuedWrite(inReq);
+            }
+        }
         while ((theBufCount -= mRequestBufferCount) > 0) {
             Request& theReq = *theNextPtr;
             QCRTASSERT(
@@ -722,6 +965,24 @@ private:
         int*          inFdPtr,
         struct iovec* inIoVecPtr,
         int           inThreadIdx);
+    int CoalesceWrites(
+        Request&  inReq,
+        Request** outReqsPtr);
+    int64_t WriteCoalesced(
+        int           inFd,
+        struct iovec* inIoVecPtr,
+        Request&      inReq,
+        Request**     inReqsPtr,
+        int           inCount,
+        Error&        outError,
+        int&          outSysError);
+    void CompleteCoalesced(
+        Request&  inReq,
+        Request** inReqsPtr,
+        int       inCount,
+        Error     inError,
+        int       inSysError,
+        int64_t   inIoByteCount);
     void ProcessOpenOrCreate(
         Request& inReq,
         int      inThreadIdx);
@@ -752,6 +1013,16 @@ private:
         } else if (IsWriteReqType(inReq.mReqType)) {
             mPendingWriteBlockCount -= inReq.mBufferCount;
         }
+        if (inReq.mDequeuedFlag) {
+            inReq.mDequeuedFlag = false;
+            const int theMaxCount = mPriorityMaxInFlightCount[inReq.mPriority];
+            if (0 < theMaxCount &&
+                    theMaxCount <= mPriorityInFlightCount[inReq.mPriority]-- &&
+                    mRunFlag) {
+                // Class was at its limit, let the waiting threads dispatch.
+                NotifyAllWithPending();
+            }
+        }
         BlockIdx theBlockIdx;
         if (inReq.IsMeta()) {
             // The first "buffer" has file name allocated with "new char[]".
@@ -1003,7 +1274,7 @@ QCDiskQueue::Queue::StopSelf()
     if (mRequestsPtr) {
         Request* theReqPtr;
         for (int i = 0; i < (mRequestAffinityFlag ? mThreadCount : 0); i++) {
-            while ((theReqPtr = Dequeue(i))) {
+            while ((theReqPtr = Dequeue(i, true))) {
                 Cancel(*theReqPtr);
             }
         }
@@ -1029,6 +1300,9 @@ QCDiskQueue::Queue::StopSelf()
     mRequestBufferCount = 0;
     delete [] mRequestsPtr;
     mRequestsPtr = 0;
+    delete [] mWriteHashPtr;
+    mWriteHashPtr  = 0;
+    mWriteHashSize = 0;
     delete [] mPendingCloseHeadPtr;
     mPendingCloseHeadPtr = 0;
     mPendingCloseTailPtr = 0;
@@ -1163,6 +1437,7 @@ QCDiskQueue::Queue::Start(
             mFileInfoPtr[i].mOpenError             = kOpenErrorNone;
             mFileInfoPtr[i].mClosedFlag            = false;
             mFileInfoPtr[i].mCloseFileSize         = -1;
+            mFileInfoPtr[i].mQueuedCount           = 0;
             mFileInfoPtr[i].mThreadIdx             = mNextThreadIdx++;
             if (theFd < 0 && i < inFileCount) {
                 theFd = mFreeFdHead;
@@ -1176,11 +1451,19 @@ QCDiskQueue::Queue::Start(
     }
     mBuffersPtr = new char*[inMaxQueueDepth * inMaxBuffersPerRequestCount];
     mRequestBufferCount = inMaxBuffersPerRequestCount;
-    mRequestQueueCount  = kRequestQueueCount +
-        (mRequestAffinityFlag ? inThreadCount - 1 : 0);
+    mRequestQueueCount  = (int)GetIoQueueIdx(
+        mRequestAffinityFlag ? inThreadCount : 1, 0);
     const int theReqCnt = mRequestQueueCount + inMaxQueueDepth;
     mRequestsPtr = new Request[theReqCnt];
-    // Init list heads: kFreeQueueIdx kIoQueueIdx.
+    for (mWriteHashSize = 1;
+            mWriteHashSize < (unsigned int)inMaxQueueDepth;
+            mWriteHashSize <<= 1)
+        {}
+    mWriteHashPtr = new RequestIdx[mWriteHashSize];
+    for (unsigned int i = 0; i < mWriteHashSize; i++) {
+        mWriteHashPtr[i] = kFreeQueueIdx;
+    }
+    // Init list heads: kFreeQueueIdx, and io queues priority lists.
     for (mTotalCount = 0; mTotalCount < mRequestQueueCount; mTotalCount++) {
         Init(mRequestsPtr[mTotalCount]);
     }
@@ -1214,9 +1497,11 @@ QCDiskQueue::Queue::Enqueue(
     int                         inBufferCount,
     QCDiskQueue::IoCompletion*  inIoCompletionPtr,
     QCDiskQueue::Time           inTimeWaitNanoSec,
-    int64_t                     inEofHint)
+    int64_t                     inEofHint,
+    QCDiskQueue::Priority       inPriority)
 {
     if ((inReqType != kReqTypeRead && ! IsWriteReqType(inReqType)) ||
+            inPriority < 0 || kPriorityCount <= inPriority ||
             inBufferCount <= 0 ||
             inBufferCount > (mRequestBufferCount *
                 (mTotalCount - mRequestQueueCount)) ||
@@ -1254,6 +1539,7 @@ QCDiskQueue::Queue::Enqueue(
     theReq.mFileIdx         = inFileIdx;
     theReq.mBlockIdx        = inBlockIdx;
     theReq.mIoCompletionPtr = inIoCompletionPtr;
+    theReq.mPriority        = inPriority;
     if (inBufferIteratorPtr) {
         BuffersIterator theItr(*this, theReq, inBufferCount);
         for (int i = 0; i < inBufferCount; i++) {
@@ -1460,18 +1746,26 @@ QCDiskQueue::Queue::Process(
     if (mRequestProcessorsPtr && 0 < theAllocSize) {
         mFileInfoPtr[inReq.mFileIdx].mSpaceAllocPendingFlag = false;
     }
-    const RequestId theReqId = GetRequestId(inReq);
+    Request*  theCoalescedReqsPtr[kMaxCoalescedWriteCount];
+    const int theCoalescedCount = (inReq.mReqType == kReqTypeWrite &&
+            ! mRequestProcessorsPtr) ?
+        CoalesceWrites(inReq, theCoalescedReqsPtr) : 0;
+    const RequestId theReqId    = GetRequestId(inReq);
+    const int       theNumaNode = mBufferPoolNumaNode;
     QCStMutexUnlocker theUnlock(mMutex);
 
-    Trace("process", inReq);
-    if (mIoStartObserverPtr) {
-        mIoStartObserverPtr->Notify(
-            inReq.mReqType,
-            theReqId,
-            inReq.mFileIdx,
-            inReq.mBlockIdx,
-            inReq.mBufferCount
-        );
+    for (int i = -1; i < theCoalescedCount; i++) {
+        Request& theReq = i < 0 ? inReq : *theCoalescedReqsPtr[i];
+        Trace("process", theReq);
+        if (mIoStartObserverPtr) {
+            mIoStartObserverPtr->Notify(
+                theReq.mReqType,
+                i < 0 ? theReqId : GetRequestId(theReq),
+                theReq.mFileIdx,
+                theReq.mBlockIdx,
+                theReq.mBufferCount
+            );
+        }
     }
     if (mRequestProcessorsPtr) {
         const bool theGetBufFlag = ! theBufPtr[0] &&
@@ -1482,7 +1776,7 @@ QCDiskQueue::Queue::Process(
             BuffersIterator theIt(*this, inReq, inReq.mBufferCount);
             // Allocate buffers for read request.
             if (! mBufferPoolPtr->Get(theIt, inReq.mBufferCount,
-                    QCIoBufferPool::kRefillReqIdRead)) {
+                    QCIoBufferPool::kRefillReqIdRead, theNumaNode)) {
                 theUnlock.Lock();
                 RequestComplete(inReq, kErrorOutOfBuffers, 0, 0, theGetBufFlag);
                 return;
@@ -1532,7 +1826,7 @@ QCDiskQueue::Queue::Process(
         BuffersIterator theIt(*this, inReq, inReq.mBufferCount);
         // Allocate buffers for read request.
         if (! mBufferPoolPtr->Get(theIt, inReq.mBufferCount,
-                QCIoBufferPool::kRefillReqIdRead)) {
+                QCIoBufferPool::kRefillReqIdRead, theNumaNode)) {
             theError = kErrorOutOfBuffers;
         }
     }
@@ -1541,6 +1835,23 @@ QCDiskQueue::Queue::Process(
         theError    = kErrorSeek;
         theSysError = errno;
     }
+    if (0 < theCoalescedCount) {
+        const int64_t theIoByteCnt = theError == kErrorNone ?
+            WriteCoalesced(theFd, inIoVecPtr, inReq,
+                theCoalescedReqsPtr, theCoalescedCount,
+                theError, theSysError) : int64_t(0);
+        if (theError == kErrorNone &&
+                theCoalescedReqsPtr[theCoalescedCount - 1]->mReqType ==
+                    kReqTypeWriteSync &&
+                fsync(theFd)) {
+            theError    = kErrorWrite;
+            theSysError = errno;
+        }
+        theUnlock.Lock();
+        CompleteCoalesced(inReq, theCoalescedReqsPtr, theCoalescedCount,
+            theError, theSysError, theIoByteCnt);
+        return;
+    }
     BuffersIterator theItr(*this, inReq, inReq.mBufferCount);
     int             theBufCnt    = inReq.mBufferCount;
     int64_t         theIoByteCnt = 0;
@@ -1601,6 +1912,133 @@ QCDiskQueue::Queue::Process(
     RequestComplete(inReq, theError, theSysError, theIoByteCnt, theGetBufFlag);
 }
 
+    int
+QCDiskQueue::Queue::CoalesceWrites(
+    QCDiskQueue::Queue::Request&  inReq,
+    QCDiskQueue::Queue::Request** outReqsPtr)
+{
+    QCASSERT(mMutex.IsOwned() && inReq.mReqType == kReqTypeWrite);
+    if (mMaxCoalescedWriteBlockCount <= inReq.mBufferCount ||
+            ! GetBuffersPtr(inReq)[0]) {
+        return 0;
+    }
+    // Find queued writes that start where the chain ends. All queued
+    // requests of the file are in the same class, and each coalesced request
+    // is charged to its class the same way as dequeued request. Sync write
+    // ends the chain, as it must be followed by fsync. The write is dispatched
+    // ahead of the requests to the same file queued before it only if none of
+    // these overlaps with the write, in order to preserve the file requests
+    // order.
+    const FileInfo& theInfo      = mFileInfoPtr[inReq.mFileIdx];
+    uint64_t        theNextIdx   = inReq.mBlockIdx + inReq.mBufferCount;
+    int             theBlkCount  = inReq.mBufferCount;
+    int             theCount     = 0;
+    bool            theFoundFlag = true;
+    while (theFoundFlag && theCount < kMaxCoalescedWriteCount) {
+        Request* const theReqPtr = FindQueuedWrite(inReq.mFileIdx, theNextIdx);
+        if (! theReqPtr ||
+                mMaxCoalescedWriteBlockCount <
+                    theBlkCount + theReqPtr->mBufferCount ||
+                theReqPtr->mBufferCount <= 0 ||
+                ! GetBuffersPtr(*theReqPtr)[0] ||
+                (! theInfo.mOpenPendingFlag &&
+                    uint64_t(theInfo.mLastBlockIdx) <
+                    theNextIdx + theReqPtr->mBufferCount) ||
+                ! CanDispatchBeforeQueued(*theReqPtr)) {
+            break;
+        }
+        RemoveWithSubRequests(*theReqPtr);
+        theReqPtr->mInFlightFlag = true;
+        theReqPtr->mDequeuedFlag = true;
+        mPriorityInFlightCount[theReqPtr->mPriority]++;
+        outReqsPtr[theCount++] = theReqPtr;
+        theNextIdx  += theReqPtr->mBufferCount;
+        theBlkCount += theReqPtr->mBufferCount;
+        theFoundFlag = theReqPtr->mReqType == kReqTypeWrite;
+    }
+    return theCount;
+}
+
+    int64_t
+QCDiskQueue::Queue::WriteCoalesced(
+    int                           inFd,
+    struct iovec*                 inIoVecPtr,
+    QCDiskQueue::Queue::Request&  inReq,
+    QCDiskQueue::Queue::Request** inReqsPtr,
+    int                           inCount,
+    QCDiskQueue::Error&           outError,
+    int&                          outSysError)
+{
+    int64_t theIoByteCnt = 0;
+    ssize_t theIoBytes   = 0;
+    int     theIoVecCnt  = 0;
+    for (int i = -1; i < inCount && outError == kErrorNone; i++) {
+        Request&        theReq = i < 0 ? inReq : *inReqsPtr[i];
+        BuffersIterator theItr(*this, theReq, theReq.mBufferCount);
+        char*           thePtr;
+        while ((thePtr = theItr.Get())) {
+            inIoVecPtr[theIoVecCnt  ].iov_base = thePtr;
+            inIoVecPtr[theIoVecCnt++].iov_len  = mBlockSize;
+            theIoBytes += mBlockSize;
+            if (mIoVecPerThreadCount <= theIoVecCnt) {
+                const ssize_t theNWr = writev(inFd, inIoVecPtr, theIoVecCnt);
+                if (theNWr > 0) {
+                    theIoByteCnt += theNWr;
+                }
+                if (theNWr != theIoBytes) {
+                    outError    = kErrorWrite;
+                    outSysError = errno;
+                    break;
+                }
+                theIoVecCnt = 0;
+                theIoBytes  = 0;
+            }
+        }
+    }
+    if (outError == kErrorNone && 0 < theIoVecCnt) {
+        const ssize_t theNWr = writev(inFd, inIoVecPtr, theIoVecCnt);
+        if (theNWr > 0) {
+            theIoByteCnt += theNWr;
+        }
+        if (theNWr != theIoBytes) {
+            outError    = kErrorWrite;
+            outSysError = errno;
+        }
+    }
+    return theIoByteCnt;
+}
+
+    void
+QCDiskQueue::Queue::CompleteCoalesced(
+    QCDiskQueue::Queue::Request&  inReq,
+    QCDiskQueue::Queue::Request** inReqsPtr,
+    int                           inCount,
+    QCDiskQueue::Error            inError,
+    int                           inSysError,
+    int64_t                       inIoByteCount)
+{
+    QCASSERT(mMutex.IsOwned());
+    // Each request is complete if all its blocks were written, the error
+    // applies to the remaining requests, and to the sync write if fsync
+    // failed.
+    int64_t thePos = 0;
+    for (int i = -1; i < inCount; i++) {
+        Request&      theReq   = i < 0 ? inReq : *inReqsPtr[i];
+        const int64_t theSize  = (int64_t)theReq.mBufferCount * mBlockSize;
+        const int64_t theCount = Max(int64_t(0), Min(theSize,
+            inIoByteCount - thePos));
+        thePos += theSize;
+        if (theCount < theSize || (inError != kErrorNone &&
+                theReq.mReqType == kReqTypeWriteSync)) {
+            RequestComplete(theReq,
+                inError == kErrorNone ? kErrorWrite : inError,
+                inSysError, theCount);
+        } else {
+            RequestComplete(theReq, kErrorNone, 0, theCount);
+        }
+    }
+}
+
     void
 QCDiskQueue::Queue::ProcessOpenOrCreate(
     Request& inReq,
@@ -1626,9 +2064,11 @@ QCDiskQueue::Queue::ProcessOpenOrCreate(
         inReq.mReqType == kReqTypeCreate ||
         inReq.mReqType == kReqTypeCreateRO;
     const RequestId   theReqId        = GetRequestId(inReq);
+    const bool        theBufferedIoFlag =
+        mFileInfoPtr[theIdx].mBufferedIoFlag;
     const int         theOpenFlags    =
         (theReadOnlyFlag ? O_RDONLY : O_RDWR) |
-        GetOpenCommonFlags(mFileInfoPtr[theIdx].mBufferedIoFlag);
+        GetOpenCommonFlags(theBufferedIoFlag);
     const bool        theCreateExclusiveFlag = mCreateExclusiveFlag;
 
     QCRTASSERT(theIdx >= 0 && theIdx < mFileCount && theFileNamePtr);
@@ -1657,6 +2097,7 @@ QCDiskQueue::Queue::ProcessOpenOrCreate(
                 theReadOnlyFlag,
                 i == theIdx && theCreateFlag,
                 i == theIdx && theCreateExclusiveFlag,
+                theBufferedIoFlag,
                 theSize
             );
             if (theFd < 0) {
@@ -1859,7 +2300,8 @@ QCDiskQueue::Queue::ProcessMeta(
             inReq,
             inReq.mReqType,
             theNamePtr,
-            kReqTypeRename == inReq.mReqType ?
+            (kReqTypeRename == inReq.mReqType ||
+                kReqTypeCheckDirWritable == inReq.mReqType) ?
                 theNamePtr + theNextNameStart : 0
         );
         return;
@@ -2165,6 +2607,37 @@ QCDiskQueue::Queue::AllocateFileSpace(
     return Status(kErrorNone);
 }
 
+    int
+QCDiskQueue::Queue::DupBufferedIoFd(
+    QCDiskQueue::FileIdx inFileIdx)
+{
+    QCStMutexLocker theLocker(mMutex);
+    if (! mRunFlag) {
+        return -EINVAL;
+    }
+    if (mRequestProcessorsPtr) {
+        return -ENOTSUP;
+    }
+    if (inFileIdx < 0 || inFileIdx >= mFileCount || mFdPtr[inFileIdx] < 0 ||
+            mFdPtr[inFileIdx] == kOpenPendingFd ||
+            mFileInfoPtr[inFileIdx].mClosedFlag ||
+            mFileInfoPtr[inFileIdx].mOpenError != kOpenErrorNone) {
+        return -EBADF;
+    }
+    const int theFd = mFdPtr[inFileIdx];
+#ifdef O_DIRECT
+    const int theFlags = fcntl(theFd, F_GETFL);
+    if (theFlags == -1) {
+        return (errno ? -errno : -EBADF);
+    }
+    if ((theFlags & O_DIRECT) != 0) {
+        return -EINVAL;
+    }
+#endif
+    const int theRet = fcntl(theFd, F_DUPFD_CLOEXEC, 0);
+    return (theRet < 0 ? (errno ? -errno : -EBADF) : theRet);
+}
+
     QCDiskQueue::EnqueueStatus
 QCDiskQueue::Queue::Rename(
         const char*                inSrcFileNamePtr,
@@ -2406,6 +2879,23 @@ private:
     }
 };
 
+    /* static */ int
+QCDiskQueue::GetOpenCommonFlags(
+    bool inBufferedIoFlag)
+{
+#ifndef O_DIRECT
+    (void)inBufferedIoFlag;
+#endif
+    return (0
+#ifdef O_DIRECT
+    | (inBufferedIoFlag ? 0 : O_DIRECT)
+#endif
+#ifdef O_NOATIME
+    | O_NOATIME
+#endif
+    );
+}
+
     /* static */ const char*
 QCDiskQueue::ToString(
     QCDiskQueue::Error inErrorCode)
@@ -2521,7 +3011,8 @@ QCDiskQueue::Enqueue(
     int                         inBufferCount,
     QCDiskQueue::IoCompletion*  inIoCompletionPtr,
     QCDiskQueue::Time           inTimeWaitNanoSec,
-    int64_t                     inEofHint)
+    int64_t                     inEofHint,
+    QCDiskQueue::Priority       inPriority)
 {
     if (! mQueuePtr) {
         return EnqueueStatus(kRequestIdNone, kErrorParameter);
@@ -2534,7 +3025,43 @@ QCDiskQueue::Enqueue(
         inBufferCount,
         inIoCompletionPtr,
         inTimeWaitNanoSec,
-        inEofHint);
+        inEofHint,
+        inPriority);
+}
+
+    QCDiskQueue::Status
+QCDiskQueue::SetPriorityParameters(
+    QCDiskQueue::Priority inPriority,
+    int                   inMaxInFlightCount,
+    QCDiskQueue::Time     inDeadlineNanoSec)
+{
+    if (! mQueuePtr) {
+        return Status(kErrorQueueStopped);
+    }
+    return mQueuePtr->SetPriorityParameters(
+        inPriority, inMaxInFlightCount, inDeadlineNanoSec);
+}
+
+    QCDiskQueue::Status
+QCDiskQueue::SetMaxCoalescedWriteBlockCount(
+    int inBlockCount)
+{
+    if (! mQueuePtr) {
+        return Status(kErrorQueueStopped);
+    }
+    mQueuePtr->SetMaxCoalescedWriteBlockCount(inBlockCount);
+    return Status();
+}
+
+    QCDiskQueue::Status
+QCDiskQueue::SetBufferPoolNumaNode(
+    int inNode)
+{
+    if (! mQueuePtr) {
+        return Status(kErrorQueueStopped);
+    }
+    mQueuePtr->SetBufferPoolNumaNode(inNode);
+    return Status();
 }
 
     bool
@@ -2723,6 +3250,13 @@ QCDiskQueue::GetBlockSize() const
     return (mQueuePtr ? mQueuePtr->GetBlockSize() : 0);
 }
 
+    int
+QCDiskQueue::DupBufferedIoFd(
+    QCDiskQueue::FileIdx inFileIdx)
+{
+    return (mQueuePtr ? mQueuePtr->DupBufferedIoFd(inFileIdx) : -EINVAL);
+}
+
     QCDiskQueue::Status
 QCDiskQueue::AllocateFileSpace(
     QCDiskQueue::FileIdx inFileIdx)
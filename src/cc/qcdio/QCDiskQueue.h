@@ -35,6 +35,22 @@
 // close that is queued after read request will be executed after the read
 // request completes.
 //
+// Read and write requests can be assigned one of the priority classes. Each
+// class has its own request queue, and the requests are dispatched from the
+// highest priority class with pending requests, unless the number of the
+// class requests in flight reached the class limit, or the class with lower
+// priority has a request that waited longer than the class deadline. The
+// requests that exceeded the deadlines are dispatched first, in the order of
+// how long they waited past the deadline. Without limits and deadlines
+// configured, and with all requests in the default class, the queue
+// behaves the same way as a single FIFO queue.
+// The requests to the same file are dispatched in the order they are queued:
+// while the file has requests in the queue, the new requests to this file are
+// placed into the class of the queued requests, regardless of their priority.
+// Open and other meta requests are in the default class.
+// Optionally the io thread can coalesce pending writes to the adjacent blocks
+// of the same file into one sequential write.
+//
 //----------------------------------------------------------------------------
 
 #ifndef QCDISKQUEUE_H
@@ -68,6 +84,14 @@ public:
         kReqTypeMax
     };
 
+    enum Priority
+    {
+        kPriorityHigh   = 0,
+        kPriorityNormal = 1,
+        kPriorityLow    = 2,
+        kPriorityCount
+    };
+
     enum Error
     {
         kErrorNone                 = 0,
@@ -251,6 +275,7 @@ public:
             bool        inReadOnlyFlag,
             bool        inCreateFlag,
             bool        inCreateExclusiveFlag,
+            bool        inBufferedIoFlag,
             int64_t&    ioMaxFileSize) = 0;
         virtual int Close(
             int     inFd,
@@ -298,6 +323,9 @@ public:
 
     static const char* ToString(
         Error inErrorCode);
+    // Host file system open flags, except access mode and create flags.
+    static int GetOpenCommonFlags(
+        bool inBufferedIoFlag);
 
     QCDiskQueue();
     ~QCDiskQueue();
@@ -328,7 +356,8 @@ public:
         int            inBufferCount,
         IoCompletion*  inIoCompletionPtr,
         Time           inTimeWaitNanoSec = -1,
-        int64_t        inEofHint         = -1);
+        int64_t        inEofHint         = -1,
+        Priority       inPriority        = kPriorityNormal);
 
     EnqueueStatus Read(
         FileIdx        inFileIdx,
@@ -336,7 +365,8 @@ public:
         InputIterator* inBufferIteratorPtr,
         int            inBufferCount,
         IoCompletion*  inIoCompletionPtr,
-        Time           inTimeWaitNanoSec = -1)
+        Time           inTimeWaitNanoSec = -1,
+        Priority       inPriority        = kPriorityNormal)
     {
         return Enqueue(
             kReqTypeRead,
@@ -345,7 +375,9 @@ public:
             inBufferIteratorPtr,
             inBufferCount,
             inIoCompletionPtr,
-            inTimeWaitNanoSec);
+            inTimeWaitNanoSec,
+            -1,
+            inPriority);
     }
 
     EnqueueStatus Write(
@@ -356,7 +388,8 @@ public:
         IoCompletion*  inIoCompletionPtr,
         Time           inTimeWaitNanoSec = -1,
         bool           inSyncFlag        = false,
-        int64_t        inEofHint         = -1)
+        int64_t        inEofHint         = -1,
+        Priority       inPriority        = kPriorityNormal)
     {
         return Enqueue(
             inSyncFlag ? kReqTypeWriteSync : kReqTypeWrite,
@@ -366,9 +399,38 @@ public:
             inBufferCount,
             inIoCompletionPtr,
             inTimeWaitNanoSec,
-            inEofHint);
+            inEofHint,
+            inPriority);
     }
 
+    // Sets the max number of the class requests in flight, and the class
+    // request deadline. Non positive values mean no limit, and no deadline
+    // respectively. Meta requests are not subject to the limits. The classes
+    // are dispatched in priority order only if at least one class has limit
+    // or deadline set, otherwise all requests are dispatched in the queue
+    // order. Without deadline the class requests might wait for as long as
+    // the higher priority classes have requests queued.
+    Status SetPriorityParameters(
+        Priority inPriority,
+        int      inMaxInFlightCount,
+        Time     inDeadlineNanoSec);
+
+    // Sets the max number of blocks that io thread can write with a single
+    // sequence of writev calls, by appending the pending writes to the
+    // adjacent blocks of the same file to the write it is about to process.
+    // Each request is completed individually, and is counted against its
+    // class max number of requests in flight. Non positive value turns off
+    // write coalescing. Io methods, i.e. request processors, process each
+    // request individually.
+    Status SetMaxCoalescedWriteBlockCount(
+        int inBlockCount);
+
+    // Sets the NUMA node of the device, in order to allocate the read buffers
+    // from the buffer pool partitions local to the device. Negative value
+    // selects the partitions local to the io thread cpu.
+    Status SetBufferPoolNumaNode(
+        int inNode);
+
     CompletionStatus SyncIo(
         ReqType         inReqType,
         FileIdx         inFileIdx,
@@ -476,6 +538,12 @@ public:
     Status AllocateFileSpace(
         FileIdx inFileIdx);
 
+    // Returns duplicate of the file descriptor, or negative error code. The
+    // file must be open and not use direct io, in order for the reads through
+    // the returned descriptor to be served from the os buffer cache.
+    int DupBufferedIoFd(
+        FileIdx inFileIdx);
+
 private:
     class Queue;
     class RequestWaiter;
@@ -31,8 +31,157 @@
 #include "QCDLList.h"
 
 #include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/stat.h>
 #include <errno.h>
 #include <unistd.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <string>
+
+#if defined(QC_OS_NAME_LINUX) && defined(SYS_mbind)
+#   define QC_IO_BUFFER_POOL_NUMA
+#   include <sched.h>
+#   include <sys/sysmacros.h>
+#endif
+
+#ifdef QC_IO_BUFFER_POOL_NUMA
+// Reads the list of id ranges, for example: 0-1,3, stores the ids in
+// ascending order, and returns the number of the ids stored.
+static int
+QCReadIdList(
+    const char* inFileNamePtr,
+    int*        outIdsPtr,
+    int         inMaxCount)
+{
+    FILE* const theFilePtr = fopen(inFileNamePtr, "r");
+    if (! theFilePtr) {
+        return 0;
+    }
+    int theCount = 0;
+    int theFirst;
+    while (theCount < inMaxCount &&
+            fscanf(theFilePtr, "%d", &theFirst) == 1 && 0 <= theFirst) {
+        int theLast = theFirst;
+        int theSym  = fgetc(theFilePtr);
+        if (theSym == '-') {
+            if (fscanf(theFilePtr, "%d", &theLast) != 1) {
+                break;
+            }
+            theSym = fgetc(theFilePtr);
+        }
+        for (int i = theFirst; i <= theLast && theCount < inMaxCount; i++) {
+            outIdsPtr[theCount++] = i;
+        }
+        if (theSym != ',') {
+            break;
+        }
+    }
+    fclose(theFilePtr);
+    return theCount;
+}
+#endif
+
+// Stores the online NUMA node ids in ascending order, and returns the number
+// of the nodes stored, or 0 if NUMA isn't supported. The node ids are not
+// necessarily contiguous, for example with node 1 offline the list is 0,2.
+static int
+QCGetNumaNodes(
+    int* outNodesPtr,
+    int  inMaxCount)
+{
+#ifdef QC_IO_BUFFER_POOL_NUMA
+    return QCReadIdList(
+        "/sys/devices/system/node/online", outNodesPtr, inMaxCount);
+#else
+    return 0;
+#endif
+}
+
+// Sets the node id of each cpu, or -1 if the cpu is not in any of the nodes,
+// and returns the highest cpu id plus one.
+static int
+QCGetNumaCpuNodes(
+    const int* inNodesPtr,
+    int        inNodeCount,
+    int*       outCpuNodesPtr,
+    int        inMaxCpuCount)
+{
+    for (int i = 0; i < inMaxCpuCount; i++) {
+        outCpuNodesPtr[i] = -1;
+    }
+    int theCpuCount = 0;
+#ifdef QC_IO_BUFFER_POOL_NUMA
+    int* const theCpusPtr = new int[inMaxCpuCount];
+    for (int i = 0; i < inNodeCount; i++) {
+        char theName[64];
+        snprintf(theName, sizeof(theName),
+            "/sys/devices/system/node/node%d/cpulist", inNodesPtr[i]);
+        const int theCnt = QCReadIdList(theName, theCpusPtr, inMaxCpuCount);
+        for (int k = 0; k < theCnt; k++) {
+            const int theCpu = theCpusPtr[k];
+            if (theCpu < inMaxCpuCount) {
+                outCpuNodesPtr[theCpu] = inNodesPtr[i];
+                if (theCpuCount <= theCpu) {
+                    theCpuCount = theCpu + 1;
+                }
+            }
+        }
+    }
+    delete [] theCpusPtr;
+#endif
+    return theCpuCount;
+}
+
+static int
+QCBindToNumaNode(
+    void*  inPtr,
+    size_t inSize,
+    int    inNode)
+{
+#ifdef QC_IO_BUFFER_POOL_NUMA
+    // Use preferred policy, in order to fall back to other nodes instead of
+    // failing allocation when the node is out of memory.
+    const int     kMpolPreferred = 1;
+    unsigned long theMask[1024 / (8 * sizeof(unsigned long))];
+    const size_t  theBitCnt = 8 * sizeof(theMask[0]);
+    if (inNode < 0 || sizeof(theMask) * 8 <= size_t(inNode)) {
+        return EINVAL;
+    }
+    memset(theMask, 0, sizeof(theMask));
+    theMask[inNode / theBitCnt] |= (unsigned long)1 << (inNode % theBitCnt);
+    if (syscall(SYS_mbind, inPtr, inSize, kMpolPreferred, theMask,
+            sizeof(theMask) * 8 + 1, 0) != 0) {
+        const int theErr = errno;
+        return (theErr == 0 ? -1 : theErr);
+    }
+    return 0;
+#else
+    return ENOSYS;
+#endif
+}
+
+static void*
+QCMapHugePages(
+    size_t inSize,
+    int    inHugePageSize)
+{
+#if defined(MAP_HUGETLB) && defined(QC_OS_NAME_LINUX)
+    int theShift = 0;
+    while (theShift < 48 && (size_t(1) << theShift) < size_t(inHugePageSize)) {
+        theShift++;
+    }
+    const int kMapHugeShift = 26;
+    void* const thePtr = mmap(0, inSize, PROT_READ | PROT_WRITE,
+        MAP_PRIVATE | MAP_ANON | MAP_HUGETLB | (theShift << kMapHugeShift),
+        -1, 0);
+    return thePtr;
+#else
+    return MAP_FAILED;
+#endif
+}
 
 class QCIoBufferPool::Partition
 {
@@ -44,7 +193,8 @@ public:
           mFreeListPtr(0),
           mTotalCnt(0),
           mFreeCnt(0),
-          mBufSizeShift(0)
+          mBufSizeShift(0),
+          mNode(-1)
         { List::Init(*this); }
 
     ~Partition()
@@ -53,7 +203,9 @@ public:
     int Create(
         int  inNumBuffers,
         int  inBufferSize,
-        bool inLockMemoryFlag)
+        bool inLockMemoryFlag,
+        int  inHugePageSize,
+        int  inNode)
     {
         int theBufSizeShift = -1;
         for (int i = inBufferSize; i > 0; i >>= 1, theBufSizeShift++)
@@ -72,12 +224,38 @@ public:
             kPageSize : size_t(inBufferSize);
         mAllocSize = size_t(inNumBuffers) * inBufferSize + kAlign;
         mAllocSize = (mAllocSize + kPageSize - 1) / kPageSize * kPageSize;
-        mAllocPtr = mmap(0, mAllocSize,
-            PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANON, -1, 0);
+        mAllocPtr = MAP_FAILED;
+        if (0 < inHugePageSize && kPageSize < size_t(inHugePageSize)) {
+            // Explicit huge pages must be reserved by the system
+            // administrator, fall back to transparent huge pages.
+            const size_t theSize = (mAllocSize + inHugePageSize - 1) /
+                inHugePageSize * inHugePageSize;
+            mAllocPtr = QCMapHugePages(theSize, inHugePageSize);
+            if (mAllocPtr != MAP_FAILED) {
+                mAllocSize = theSize;
+            }
+        }
         if (mAllocPtr == MAP_FAILED) {
-            const int theRet = errno;
-            mAllocPtr = 0;
-            return (theRet == 0 ? -1 : theRet);
+            mAllocPtr = mmap(0, mAllocSize,
+                PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANON, -1, 0);
+            if (mAllocPtr == MAP_FAILED) {
+                const int theRet = errno;
+                mAllocPtr = 0;
+                return (theRet == 0 ? -1 : theRet);
+            }
+#ifdef MADV_HUGEPAGE
+            if (inHugePageSize != 0) {
+                // Transparent huge pages are "best effort", ignore error.
+                madvise(mAllocPtr, mAllocSize, MADV_HUGEPAGE);
+            }
+#endif
+        }
+        // Set memory policy prior to faulting in the pages. If binding
+        // fails, for example the node has no memory, or the kernel does not
+        // support memory policies, use the default policy.
+        if (0 <= inNode &&
+                QCBindToNumaNode(mAllocPtr, mAllocSize, inNode) == 0) {
+            mNode = inNode;
         }
         if (inLockMemoryFlag && mlock(mAllocPtr, mAllocSize) != 0) {
             const int theRet = errno;
@@ -111,6 +289,7 @@ public:
         mTotalCnt     = 0;
         mFreeCnt      = 0;
         mBufSizeShift = 0;
+        mNode         = -1;
     }
 
     char* Get()
@@ -156,6 +335,9 @@ public:
     bool IsFull() const
         { return (mFreeCnt >= mTotalCnt); }
 
+    int GetNode() const
+        { return mNode; }
+
     typedef QCDLList<Partition, 0> List;
 
 private:
@@ -170,10 +352,99 @@ private:
     int          mTotalCnt;
     int          mFreeCnt;
     int          mBufSizeShift;
+    int          mNode;
     Partition*   mPrevPtr[1];
     Partition*   mNextPtr[1];
 };
 
+// Per thread buffer cache. The cache mutex is only contended when the pool
+// reclaims buffers from all caches, or when the thread exits. The cache is
+// owned by the thread, and is deleted on thread exit, or with the pool. The
+// pool detaches the caches, instead of deleting these, when the pool is
+// destroyed, and the thread re-attaches its cache on the next pool access.
+// The buffer count is read by the pool without acquiring the cache mutex,
+// in order to account for the cached buffers as free.
+class QCIoBufferPool::ThreadCache
+{
+public:
+    typedef QCDLList<ThreadCache, 0> List;
+
+    ThreadCache(
+        QCIoBufferPool& inPool,
+        int             inSize)
+        : mPool(inPool),
+          mMutex(),
+          mCount(0),
+          mSize(inSize),
+          mBufsPtr(new char*[inSize]),
+          mDetachedFlag(false)
+        { List::Init(*this); }
+    ~ThreadCache()
+        { delete [] mBufsPtr; }
+    char* Get()
+    {
+        QCStMutexLocker theLock(mMutex);
+        if (mCount <= 0) {
+            return 0;
+        }
+        SetCount(mCount - 1);
+        return mBufsPtr[mCount];
+    }
+    bool Put(
+        char* inBufPtr)
+    {
+        QCStMutexLocker theLock(mMutex);
+        if (mDetachedFlag || mSize <= mCount) {
+            return false;
+        }
+        mBufsPtr[mCount] = inBufPtr;
+        SetCount(mCount + 1);
+        return true;
+    }
+    int GetCount() const
+        { return __atomic_load_n(&mCount, __ATOMIC_RELAXED); }
+private:
+    QCIoBufferPool& mPool;
+    QCMutex         mMutex;
+    int             mCount;
+    int             mSize;
+    char**          mBufsPtr;
+    bool            mDetachedFlag;
+    ThreadCache*    mPrevPtr[1];
+    ThreadCache*    mNextPtr[1];
+
+    void SetCount(
+        int inCount)
+        { __atomic_store_n(&mCount, inCount, __ATOMIC_RELAXED); }
+    void Detach()
+    {
+        // The buffers are discarded with the pool partitions.
+        QCStMutexLocker theLock(mMutex);
+        SetCount(0);
+        mDetachedFlag = true;
+    }
+    void Attach(
+        int inSize)
+    {
+        QCStMutexLocker theLock(mMutex);
+        QCASSERT(mDetachedFlag && mCount == 0);
+        if (mSize != inSize) {
+            delete [] mBufsPtr;
+            mBufsPtr = new char*[inSize];
+            mSize    = inSize;
+        }
+        mDetachedFlag = false;
+    }
+
+    friend class QCIoBufferPool;
+    friend class QCDLListOp<ThreadCache, 0>;
+private:
+    ThreadCache(
+        const ThreadCache& inCache);
+    ThreadCache& operator=(
+        const ThreadCache& inCache);
+};
+
 typedef QCDLList<QCIoBufferPool::Client, 0> QCIoBufferPoolClientList;
 
 QCIoBufferPool::Client::Client()
@@ -190,18 +461,28 @@ QCIoBufferPool::Client::Unregister()
 
 QCIoBufferPool::QCIoBufferPool()
     : mMutex(),
+      mThreadCacheKey(),
+      mThreadCacheKeyFlag(false),
+      mThreadCacheSize(0),
+      mThreadCacheCount(0),
+      mNumaNodeCount(0),
+      mNumaCpuCount(0),
+      mNumaCpuNodesPtr(0),
       mBufferSize(0),
       mFreeCnt(0),
       mTotalCnt(0)
 {
     QCIoBufferPoolClientList::Init(mClientListPtr);
     Partition::List::Init(mPartitionListPtr);
+    ThreadCache::List::Init(mThreadCacheListPtr);
 }
 
 QCIoBufferPool::~QCIoBufferPool()
 {
     QCStMutexLocker theLock(mMutex);
     QCIoBufferPool::Destroy();
+    DeleteThreadCaches();
+    delete [] mNumaCpuNodesPtr;
     Client* thePtr;
     while ((thePtr = QCIoBufferPoolClientList::PopBack(mClientListPtr))) {
         Client& theClient = *thePtr;
@@ -215,17 +496,46 @@ QCIoBufferPool::Create(
     int          inPartitionCount,
     int          inPartitionBufferCount,
     int          inBufferSize,
-    bool         inLockMemoryFlag)
+    bool         inLockMemoryFlag,
+    int          inThreadCacheBufferCount /* = 0 */,
+    int          inHugePageSize           /* = 0 */,
+    bool         inNumaFlag               /* = false */)
 {
     QCStMutexLocker theLock(mMutex);
     Destroy();
     mBufferSize = inBufferSize;
     int theErr = 0;
+    if (1 < inThreadCacheBufferCount) {
+        // The key is kept until the pool is deleted, in order to re-use the
+        // detached thread caches, and to delete these on thread exit.
+        if (! mThreadCacheKeyFlag) {
+            theErr = pthread_key_create(&mThreadCacheKey, &DeleteThreadCache);
+            if (theErr) {
+                return theErr;
+            }
+            mThreadCacheKeyFlag = true;
+        }
+        mThreadCacheSize = inThreadCacheBufferCount;
+    }
+    if (inNumaFlag) {
+        mNumaNodeCount = QCGetNumaNodes(mNumaNodes, kMaxNumaNodes);
+        if (mNumaNodeCount <= 0) {
+            Destroy();
+            return ENOSYS;
+        }
+        if (! mNumaCpuNodesPtr) {
+            mNumaCpuNodesPtr = new int[kMaxNumaCpus];
+        }
+        mNumaCpuCount = QCGetNumaCpuNodes(
+            mNumaNodes, mNumaNodeCount, mNumaCpuNodesPtr, kMaxNumaCpus);
+    }
     for (int i = 0; i < inPartitionCount; i++) {
         Partition& thePart = *(new Partition());
         Partition::List::PushBack(mPartitionListPtr, thePart);
         theErr = thePart.Create(
-            inPartitionBufferCount, inBufferSize, inLockMemoryFlag);
+            inPartitionBufferCount, inBufferSize, inLockMemoryFlag,
+            inHugePageSize,
+            0 < mNumaNodeCount ? mNumaNodes[i % mNumaNodeCount] : -1);
         if (theErr) {
             Destroy();
             break;
@@ -240,29 +550,62 @@ void
 QCIoBufferPool::Destroy()
 {
     QCStMutexLocker theLock(mMutex);
+    DetachThreadCaches();
     Partition* thePtr;
     while ((thePtr = Partition::List::PopBack(mPartitionListPtr))) {
         delete thePtr;
     }
-    mBufferSize = 0;
-    mFreeCnt    = 0;
+    mBufferSize    = 0;
+    mFreeCnt       = 0;
+    mTotalCnt      = 0;
+    mNumaNodeCount = 0;
+    mNumaCpuCount  = 0;
 }
 
 char*
 QCIoBufferPool::Get(
     QCIoBufferPool::RefillReqId inRefillReqId /* = kRefillReqIdUndefined */)
 {
+    ThreadCache* const theCachePtr = GetThreadCache();
+    if (theCachePtr) {
+        char* const theBufPtr = theCachePtr->Get();
+        if (theBufPtr) {
+            return theBufPtr;
+        }
+    }
     QCStMutexLocker theLock(mMutex);
-    if (mFreeCnt <= 0 && ! TryToRefill(inRefillReqId, 1)) {
+    if (mFreeCnt <= 0 && ! ReclaimThreadCaches(1) &&
+            ! TryToRefill(inRefillReqId, 1)) {
         return 0;
     }
-    QCASSERT(mFreeCnt >= 1);
+    const int   theNode   = GetNumaNode();
+    char* const theBufPtr = GetSelf(theNode);
+    if (theCachePtr) {
+        FillThreadCache(*theCachePtr, theNode);
+    }
+    return theBufPtr;
+}
+
+char*
+QCIoBufferPool::GetSelf(
+    int inNode)
+{
+    QCASSERT(mMutex.IsOwned() && mFreeCnt >= 1);
     // Always start from the first partition, to try to keep next
     // partitions full, and be able to reclaim these if needed.
-    Partition::List::Iterator theItr(mPartitionListPtr);
-    Partition* thePtr;
-    while ((thePtr = theItr.Next()) && thePtr->IsEmpty())
-        {}
+    Partition* thePtr = 0;
+    if (0 <= inNode) {
+        // Use the first non empty partition local to the node, if any.
+        Partition::List::Iterator theItr(mPartitionListPtr);
+        while ((thePtr = theItr.Next()) &&
+            (thePtr->IsEmpty() || thePtr->GetNode() != inNode))
+            {}
+    }
+    if (! thePtr) {
+        Partition::List::Iterator theItr(mPartitionListPtr);
+        while ((thePtr = theItr.Next()) && thePtr->IsEmpty())
+            {}
+    }
     char* const theBufPtr = thePtr ? thePtr->Get() : 0;
     QCASSERT(theBufPtr && mFreeCnt > 0);
     mFreeCnt--;
@@ -273,16 +616,26 @@ bool
 QCIoBufferPool::Get(
     QCIoBufferPool::OutputIterator& inIt,
     int                             inBufCnt,
-    QCIoBufferPool::RefillReqId     inRefillReqId /* = kRefillReqIdUndefined */)
+    QCIoBufferPool::RefillReqId     inRefillReqId /* = kRefillReqIdUndefined */,
+    int                             inNumaNode    /* = -1 */)
 {
     if (inBufCnt <= 0) {
         return true;
     }
     QCStMutexLocker theLock(mMutex);
-    if (mFreeCnt < inBufCnt && ! TryToRefill(inRefillReqId, inBufCnt)) {
+    if (mFreeCnt < inBufCnt && ! ReclaimThreadCaches(inBufCnt) &&
+            ! TryToRefill(inRefillReqId, inBufCnt)) {
         return false;
     }
     QCASSERT(mFreeCnt >= inBufCnt);
+    const int theNode = (0 <= inNumaNode && 1 < mNumaNodeCount) ?
+        inNumaNode : GetNumaNode();
+    if (0 <= theNode) {
+        for (int i = 0; i < inBufCnt; i++) {
+            inIt.Put(GetSelf(theNode));
+        }
+        return true;
+    }
     Partition::List::Iterator theItr(mPartitionListPtr);
     for (int i = 0; i < inBufCnt; ) {
         Partition* thePPtr;
@@ -304,8 +657,17 @@ QCIoBufferPool::Put(
     if (! inBufPtr) {
         return;
     }
+    // Return buffers directly to the pool when invoked from Release(), in
+    // order to make buffers available to TryToRefill().
+    ThreadCache* const theCachePtr = mMutex.IsOwned() ? 0 : GetThreadCache();
+    if (theCachePtr && theCachePtr->Put(inBufPtr)) {
+        return;
+    }
     QCStMutexLocker theLock(mMutex);
     PutSelf(inBufPtr);
+    if (theCachePtr) {
+        FlushThreadCache(*theCachePtr, mThreadCacheSize / 2);
+    }
 }
 
 void
@@ -368,6 +730,169 @@ QCIoBufferPool::PutSelf(
     mFreeCnt++;
 }
 
+inline QCIoBufferPool::ThreadCache*
+QCIoBufferPool::GetThreadCache()
+{
+    if (mThreadCacheSize <= 0) {
+        return 0;
+    }
+    void* const thePtr = pthread_getspecific(mThreadCacheKey);
+    if (thePtr) {
+        return reinterpret_cast<ThreadCache*>(thePtr);
+    }
+    QCStMutexLocker theLock(mMutex);
+    if (mThreadCacheSize <= 0) {
+        return 0;
+    }
+    ThreadCache* const theCachePtr = new ThreadCache(*this, mThreadCacheSize);
+    const int theErr = pthread_setspecific(mThreadCacheKey, theCachePtr);
+    if (theErr) {
+        QCUtils::FatalError("pthread_setspecific", theErr);
+    }
+    ThreadCache::List::PushBack(mThreadCacheListPtr, *theCachePtr);
+    mThreadCacheCount++;
+    return theCachePtr;
+}
+
+int
+QCIoBufferPool::GetNumaNode() const
+{
+#ifdef QC_IO_BUFFER_POOL_NUMA
+    QCASSERT(mMutex.IsOwned());
+    if (mNumaNodeCount <= 1) {
+        return -1;
+    }
+    // With glibc sched_getcpu() normally does not enter the kernel, it uses
+    // either vdso, or restartable sequences cpu id.
+    const int theCpu = sched_getcpu();
+    return ((theCpu < 0 || mNumaCpuCount <= theCpu) ?
+        -1 : mNumaCpuNodesPtr[theCpu]);
+#else
+    return -1;
+#endif
+}
+
+void
+QCIoBufferPool::FillThreadCache(
+    QCIoBufferPool::ThreadCache& inCache,
+    int                          inNode)
+{
+    QCASSERT(mMutex.IsOwned());
+    if (inCache.mDetachedFlag) {
+        if (mThreadCacheSize <= 0) {
+            return;
+        }
+        inCache.Attach(mThreadCacheSize);
+        mThreadCacheCount++;
+    }
+    // Leave enough buffers in the pool to re-fill other threads caches, in
+    // order to avoid reclaiming buffers from thread caches back and forth when
+    // the pool is low on buffers.
+    const int theReserveCnt = mThreadCacheCount * mThreadCacheSize;
+    if (mFreeCnt <= theReserveCnt) {
+        return;
+    }
+    QCStMutexLocker theLock(inCache.mMutex);
+    int theCnt = mThreadCacheSize / 2 - inCache.mCount;
+    if (mFreeCnt - theReserveCnt < theCnt) {
+        theCnt = mFreeCnt - theReserveCnt;
+    }
+    int theCount = inCache.mCount;
+    while (0 < theCnt--) {
+        inCache.mBufsPtr[theCount++] = GetSelf(inNode);
+    }
+    inCache.SetCount(theCount);
+}
+
+void
+QCIoBufferPool::FlushThreadCache(
+    QCIoBufferPool::ThreadCache& inCache,
+    int                          inBufCnt)
+{
+    QCASSERT(mMutex.IsOwned());
+    QCStMutexLocker theLock(inCache.mMutex);
+    int theCount = inCache.mCount;
+    for (int i = 0; i < inBufCnt && 0 < theCount; i++) {
+        PutSelf(inCache.mBufsPtr[--theCount]);
+    }
+    inCache.SetCount(theCount);
+}
+
+bool
+QCIoBufferPool::ReclaimThreadCaches(
+    int inBufCnt)
+{
+    QCASSERT(mMutex.IsOwned());
+    ThreadCache::List::Iterator theItr(mThreadCacheListPtr);
+    ThreadCache* thePtr;
+    while (mFreeCnt < inBufCnt && (thePtr = theItr.Next())) {
+        FlushThreadCache(*thePtr, mThreadCacheSize);
+    }
+    return (inBufCnt <= mFreeCnt);
+}
+
+void
+QCIoBufferPool::DetachThreadCaches()
+{
+    QCASSERT(mMutex.IsOwned());
+    // Thread caches remain in the list, and are deleted on thread exit, or
+    // when the pool is deleted.
+    ThreadCache::List::Iterator theItr(mThreadCacheListPtr);
+    ThreadCache* thePtr;
+    while ((thePtr = theItr.Next())) {
+        thePtr->Detach();
+    }
+    mThreadCacheSize  = 0;
+    mThreadCacheCount = 0;
+}
+
+void
+QCIoBufferPool::DeleteThreadCaches()
+{
+    QCASSERT(mMutex.IsOwned());
+    if (! mThreadCacheKeyFlag) {
+        return;
+    }
+    // Thread caches destructors will not be invoked after the key deletion.
+    const int theErr = pthread_key_delete(mThreadCacheKey);
+    if (theErr) {
+        QCUtils::FatalError("pthread_key_delete", theErr);
+    }
+    mThreadCacheKeyFlag = false;
+    ThreadCache* thePtr;
+    while ((thePtr = ThreadCache::List::PopBack(mThreadCacheListPtr))) {
+        delete thePtr;
+    }
+}
+
+/* static */ void
+QCIoBufferPool::DeleteThreadCache(
+    void* inCachePtr)
+{
+    ThreadCache&    theCache = *reinterpret_cast<ThreadCache*>(inCachePtr);
+    QCIoBufferPool& thePool  = theCache.mPool;
+    QCStMutexLocker theLock(thePool.mMutex);
+    if (! theCache.mDetachedFlag) {
+        thePool.FlushThreadCache(theCache, theCache.mCount);
+        thePool.mThreadCacheCount--;
+    }
+    ThreadCache::List::Remove(thePool.mThreadCacheListPtr, theCache);
+    delete &theCache;
+}
+
+int
+QCIoBufferPool::GetThreadCachesBufferCount()
+{
+    QCASSERT(mMutex.IsOwned());
+    int                         theCnt = 0;
+    ThreadCache::List::Iterator theItr(mThreadCacheListPtr);
+    const ThreadCache*          thePtr;
+    while ((thePtr = theItr.Next())) {
+        theCnt += thePtr->GetCount();
+    }
+    return theCnt;
+}
+
 bool
 QCIoBufferPool::TryToRefill(
     QCIoBufferPool::RefillReqId inReqId,
@@ -393,7 +918,8 @@ int
 QCIoBufferPool::GetFreeBufferCount()
 {
     QCStMutexLocker theLock(mMutex);
-    return mFreeCnt;
+    // Buffers in the thread caches are available for allocation.
+    return (mFreeCnt + GetThreadCachesBufferCount());
 }
 
 int
@@ -407,5 +933,45 @@ int
 QCIoBufferPool::GetUsedBufferCount()
 {
     QCStMutexLocker theLock(mMutex);
-    return (mTotalCnt - mFreeCnt);
+    return (mTotalCnt - mFreeCnt - GetThreadCachesBufferCount());
+}
+
+/* static */ int
+QCIoBufferPool::GetDeviceNumaNode(
+    const char* inPathNamePtr)
+{
+#ifdef QC_IO_BUFFER_POOL_NUMA
+    struct stat theStat;
+    if (! inPathNamePtr || stat(inPathNamePtr, &theStat) != 0) {
+        return -1;
+    }
+    char theName[64];
+    snprintf(theName, sizeof(theName), "/sys/dev/block/%u:%u",
+        (unsigned int)major(theStat.st_dev),
+        (unsigned int)minor(theStat.st_dev));
+    char* const theDevPtr = realpath(theName, 0);
+    if (! theDevPtr) {
+        return -1;
+    }
+    // The block device and partition have no node, use the closest parent,
+    // normally the pci device, that has one.
+    std::string thePath(theDevPtr);
+    free(theDevPtr);
+    int    theNode = -1;
+    size_t thePos;
+    while ((thePos = thePath.rfind('/')) != std::string::npos && 0 < thePos) {
+        FILE* const theFilePtr = fopen((thePath + "/numa_node").c_str(), "r");
+        if (theFilePtr) {
+            if (fscanf(theFilePtr, "%d", &theNode) != 1) {
+                theNode = -1;
+            }
+            fclose(theFilePtr);
+            break;
+        }
+        thePath.erase(thePos);
+    }
+    return theNode;
+#else
+    return -1;
+#endif
 }
@@ -30,6 +30,19 @@
 // to satisfy request the "clients" are asked to release the specified number
 // of buffers before declaring allocation failure.
 // All buffer allocations are atomic -- all or nothing.
+// Optionally single buffer Get() and Put() can use per thread buffer caches,
+// in order to reduce the pool mutex contention. The caches are re-filled and
+// flushed in batches, with the pool mutex held. The buffers in the thread
+// caches are accounted as free. When the pool runs out of buffers, the
+// buffers in all thread caches are returned back to the pool before asking the
+// "clients" to release buffers. The thread caches are detached, and re-used
+// after Destroy() and Create(), and deleted on thread exit, or with the pool.
+// The partitions memory can be backed by huge pages. With NUMA enabled the
+// partitions are assigned to the online NUMA nodes in round robin order, and
+// the allocations are done from the partitions assigned to the calling
+// thread's node first, or to the node passed to Get(), for example the node
+// of the device that the disk queue reads into the buffers. The partition
+// memory is not bound to the node if setting the memory policy fails.
 //
 //----------------------------------------------------------------------------
 
@@ -103,14 +116,18 @@ public:
         int          inPartitionCount,
         int          inPartitionBufferCount,
         int          inBufferSize,
-        bool         inLockMemoryFlag);
+        bool         inLockMemoryFlag,
+        int          inThreadCacheBufferCount = 0,
+        int          inHugePageSize           = 0,
+        bool         inNumaFlag               = false);
     void Destroy();
     char* Get(
         RefillReqId inRefillReqId = kRefillReqIdUndefined);
     bool Get(
         OutputIterator& inIt,
         int             inBufCnt,
-        RefillReqId     inRefillReqId = kRefillReqIdUndefined);
+        RefillReqId     inRefillReqId = kRefillReqIdUndefined,
+        int             inNumaNode    = -1);
     void Put(
         char* inBufPtr);
     void Put(
@@ -125,21 +142,52 @@ public:
     int GetFreeBufferCount();
     int GetTotalBufferCount();
     int GetUsedBufferCount();
+    static int GetDeviceNumaNode(
+        const char* inPathNamePtr);
 
 private:
     class Partition;
-    QCMutex    mMutex;
-    Client*    mClientListPtr[1];
-    Partition* mPartitionListPtr[1];
-    int        mBufferSize;
-    int        mFreeCnt;
-    int        mTotalCnt;
+    class ThreadCache;
+    QCMutex       mMutex;
+    Client*       mClientListPtr[1];
+    Partition*    mPartitionListPtr[1];
+    ThreadCache*  mThreadCacheListPtr[1];
+    pthread_key_t mThreadCacheKey;
+    bool          mThreadCacheKeyFlag;
+    int           mThreadCacheSize;
+    int           mThreadCacheCount;
+    enum { kMaxNumaNodes = 128 };
+    enum { kMaxNumaCpus  = 8 << 10 };
+    int           mNumaNodeCount;
+    int           mNumaNodes[kMaxNumaNodes];
+    int           mNumaCpuCount;
+    int*          mNumaCpuNodesPtr;
+    int           mBufferSize;
+    int           mFreeCnt;
+    int           mTotalCnt;
 
     bool TryToRefill(
         RefillReqId inReqId,
         int         inBufCnt);
+    char* GetSelf(
+        int inNode);
+    int GetNumaNode() const;
     void PutSelf(
         char* inBufPtr);
+    inline ThreadCache* GetThreadCache();
+    void FillThreadCache(
+        ThreadCache& inCache,
+        int          inNode);
+    void FlushThreadCache(
+        ThreadCache& inCache,
+        int          inBufCnt);
+    bool ReclaimThreadCaches(
+        int inBufCnt);
+    void DetachThreadCaches();
+    void DeleteThreadCaches();
+    int GetThreadCachesBufferCount();
+    static void DeleteThreadCache(
+        void* inCachePtr);
 
     // No copies.
     QCIoBufferPool( const QCIoBufferPool& inPool);
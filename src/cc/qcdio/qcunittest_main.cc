@@ -35,6 +35,12 @@
 #include <iomanip>
 #include <iostream>
 #include <fstream>
+#include <vector>
+#include <utility>
+
+#include <string.h>
+#include <stdio.h>
+#include <unistd.h>
 
 using namespace std;
 
@@ -172,6 +178,245 @@ public:
             const RequestWaiter& inWaiter);
     };
 
+    // Records the request completion order. The first completion blocks the
+    // io thread until Open() is invoked, in order to let the test queue
+    // requests while the io thread is busy.
+    class OrderRecorder : public QCDiskQueue::IoCompletion
+    {
+    public:
+        typedef pair<QCDiskQueue::FileIdx, QCDiskQueue::BlockIdx> Entry;
+        typedef vector<Entry>                                       Order;
+
+        OrderRecorder()
+            : mMutex(),
+              mCond(),
+              mRequestCount(0),
+              mGateClosedFlag(false),
+              mGateWaitFlag(false),
+              mErrorFlag(false),
+              mIoByteCount(0),
+              mOrder()
+            {}
+        virtual ~OrderRecorder()
+        {
+            OrderRecorder::Open();
+            OrderRecorder::Wait();
+        }
+        virtual bool Done(
+            QCDiskQueue::RequestId      /* inRequestId */,
+            QCDiskQueue::FileIdx        inFileIdx,
+            QCDiskQueue::BlockIdx       inStartBlockIdx,
+            QCDiskQueue::InputIterator& /* inBufferItr */,
+            int                         /* inBufferCount */,
+            QCDiskQueue::Error          inCompletionCode,
+            int                         /* inSysErrorCode */,
+            int64_t                     inIoByteCount)
+        {
+            QCStMutexLocker theLock(mMutex);
+            if (inCompletionCode != QCDiskQueue::kErrorNone) {
+                mErrorFlag = true;
+            }
+            mIoByteCount += inIoByteCount;
+            mOrder.push_back(Entry(inFileIdx, inStartBlockIdx));
+            if (mGateClosedFlag && ! mGateWaitFlag) {
+                mGateWaitFlag = true;
+                mCond.NotifyAll();
+                while (mGateClosedFlag) {
+                    mCond.Wait(mMutex);
+                }
+            }
+            if (--mRequestCount <= 0) {
+                mCond.NotifyAll();
+            }
+            return false; // Tell caller to free the buffers.
+        }
+        bool Add(
+            const QCDiskQueue::EnqueueStatus inStatus)
+        {
+            if (! inStatus.IsGood()) {
+                cerr << "enqueue: " << ToString(inStatus) << endl;
+                return false;
+            }
+            QCStMutexLocker theLock(mMutex);
+            mRequestCount++;
+            return true;
+        }
+        void Close()
+        {
+            QCStMutexLocker theLock(mMutex);
+            mGateClosedFlag = true;
+            mGateWaitFlag   = false;
+            mIoByteCount    = 0;
+            mOrder.clear();
+        }
+        void WaitForGate()
+        {
+            QCStMutexLocker theLock(mMutex);
+            while (mGateClosedFlag && ! mGateWaitFlag) {
+                mCond.Wait(mMutex);
+            }
+        }
+        void Open()
+        {
+            QCStMutexLocker theLock(mMutex);
+            mGateClosedFlag = false;
+            mCond.NotifyAll();
+        }
+        void Wait()
+        {
+            QCStMutexLocker theLock(mMutex);
+            while (mRequestCount > 0) {
+                mCond.Wait(mMutex);
+            }
+        }
+        // Compares the completion order, excluding the first gate request,
+        // with the expected one.
+        bool Check(
+            const char*  inTestNamePtr,
+            const Entry* inExpectedPtr,
+            int          inCount)
+        {
+            QCStMutexLocker theLock(mMutex);
+            bool theRetFlag = ! mErrorFlag &&
+                mOrder.size() == size_t(inCount + 1);
+            for (int i = 0; theRetFlag && i < inCount; i++) {
+                theRetFlag = mOrder[i + 1] == inExpectedPtr[i];
+            }
+            cout << inTestNamePtr << ": " << (theRetFlag ? "OK" : "FAILED") <<
+                (mErrorFlag ? " io error" : "") << " order:";
+            for (Order::const_iterator theIt = mOrder.begin();
+                    theIt != mOrder.end();
+                    ++theIt) {
+                cout << " " << theIt->first << "/" << theIt->second;
+            }
+            cout << endl;
+            mErrorFlag = false;
+            return theRetFlag;
+        }
+        int64_t GetIoByteCount()
+        {
+            QCStMutexLocker theLock(mMutex);
+            return mIoByteCount;
+        }
+    private:
+        QCMutex   mMutex;
+        QCCondVar mCond;
+        int       mRequestCount;
+        bool      mGateClosedFlag;
+        bool      mGateWaitFlag;
+        bool      mErrorFlag;
+        int64_t   mIoByteCount;
+        Order     mOrder;
+
+    private:
+        OrderRecorder(
+            const OrderRecorder& inRecorder);
+        OrderRecorder& operator=(
+            const OrderRecorder& inRecorder);
+    };
+
+    // Keeps the high priority class busy: each high priority read completion
+    // queues the next read, until the low priority read completes, or the
+    // max number of high priority reads is reached.
+    class HighLoad : public QCDiskQueue::IoCompletion
+    {
+    public:
+        HighLoad(
+            QCDiskQueue&         inQueue,
+            QCDiskQueue::FileIdx inHighFileIdx,
+            int                  inMaxHighCount)
+            : mQueue(inQueue),
+              mHighFileIdx(inHighFileIdx),
+              mMaxHighCount(inMaxHighCount),
+              mMutex(),
+              mCond(),
+              mRequestCount(0),
+              mHighCount(0),
+              mLowDoneFlag(false),
+              mErrorFlag(false)
+            {}
+        virtual ~HighLoad()
+            { HighLoad::Wait(); }
+        virtual bool Done(
+            QCDiskQueue::RequestId      /* inRequestId */,
+            QCDiskQueue::FileIdx        inFileIdx,
+            QCDiskQueue::BlockIdx       /* inStartBlockIdx */,
+            QCDiskQueue::InputIterator& /* inBufferItr */,
+            int                         /* inBufferCount */,
+            QCDiskQueue::Error          inCompletionCode,
+            int                         /* inSysErrorCode */,
+            int64_t                     /* inIoBytes */)
+        {
+            QCStMutexLocker theLock(mMutex);
+            if (inCompletionCode != QCDiskQueue::kErrorNone) {
+                mErrorFlag = true;
+            }
+            if (inFileIdx == mHighFileIdx) {
+                mHighCount++;
+                if (! mLowDoneFlag && mHighCount < mMaxHighCount) {
+                    QCStMutexUnlocker theUnlock(mMutex);
+                    Add(QCDiskQueue::kPriorityHigh);
+                }
+            } else {
+                mLowDoneFlag = true;
+            }
+            if (--mRequestCount <= 0) {
+                mCond.NotifyAll();
+            }
+            return false; // Tell caller to free the buffers.
+        }
+        bool Add(
+            QCDiskQueue::Priority inPriority,
+            QCDiskQueue::FileIdx  inFileIdx = -1)
+        {
+            QCStMutexLocker theLock(mMutex);
+            mRequestCount++;
+            QCDiskQueue::EnqueueStatus theStatus;
+            {
+                QCStMutexUnlocker theUnlock(mMutex);
+                theStatus = mQueue.Read(
+                    inFileIdx < 0 ? mHighFileIdx : inFileIdx,
+                    0, 0, 1, this, -1, inPriority);
+            }
+            if (! theStatus.IsGood()) {
+                cerr << "enqueue: " << ToString(theStatus) << endl;
+                mErrorFlag = true;
+                mRequestCount--;
+                return false;
+            }
+            return true;
+        }
+        void Wait()
+        {
+            QCStMutexLocker theLock(mMutex);
+            while (mRequestCount > 0) {
+                mCond.Wait(mMutex);
+            }
+        }
+        bool IsLowDone() const
+            { return mLowDoneFlag; }
+        int GetHighCount() const
+            { return mHighCount; }
+        bool IsError() const
+            { return mErrorFlag; }
+    private:
+        QCDiskQueue&               mQueue;
+        const QCDiskQueue::FileIdx mHighFileIdx;
+        const int                  mMaxHighCount;
+        QCMutex                    mMutex;
+        QCCondVar                  mCond;
+        int                        mRequestCount;
+        int                        mHighCount;
+        bool                       mLowDoneFlag;
+        bool                       mErrorFlag;
+
+    private:
+        HighLoad(
+            const HighLoad& inLoad);
+        HighLoad& operator=(
+            const HighLoad& inLoad);
+    };
+
     class BPClient : public QCIoBufferPool::Client
     {
     public:
@@ -416,6 +661,425 @@ public:
         return 0;
     }
 
+    // Priority classes dispatch order test. Requires at least two files.
+    int PriorityTest(
+        int          inFileCount,
+        const char** inFileNamesPtr)
+    {
+        if (inFileCount < 2) {
+            cout << "priority test requires two files, skipped" << endl;
+            return 0;
+        }
+        QCIoBufferPool theBufPool;
+        int theSysErr = theBufPool.Create(1, 256, 4 << 10, false);
+        if (theSysErr) {
+            cerr << "failed to create buffer pool: " <<
+                QCUtils::SysError(theSysErr) << endl;
+            return 1;
+        }
+        QCDiskQueue theQueue;
+        const bool kRequestAffinityFlag = true;
+        theSysErr = theQueue.Start(
+            1,
+            64,
+            16,
+            inFileCount,
+            inFileNamesPtr,
+            theBufPool,
+            0,
+            QCDiskQueue::CpuAffinity::None(),
+            0,
+            false,
+            true,
+            kRequestAffinityFlag
+        );
+        if (theSysErr) {
+            cerr << "failed to create disk queue: " <<
+                QCUtils::SysError(theSysErr) << endl;
+            return 1;
+        }
+        typedef OrderRecorder::Entry Entry;
+        const QCDiskQueue::Time kMilliSec = 1000 * 1000;
+        OrderRecorder           theRecorder;
+        int                     theRet    = 0;
+
+        // With no class limits and deadlines the requests are dispatched in
+        // the queue order.
+        theRecorder.Close();
+        if (! theRecorder.Add(Read(theQueue, 0, 0, theRecorder))) {
+            return 1;
+        }
+        theRecorder.WaitForGate();
+        if (! theRecorder.Add(Read(theQueue, 0, 1, theRecorder,
+                    QCDiskQueue::kPriorityLow)) ||
+                ! theRecorder.Add(Read(theQueue, 1, 1, theRecorder,
+                    QCDiskQueue::kPriorityHigh)) ||
+                ! theRecorder.Add(Read(theQueue, 1, 2, theRecorder,
+                    QCDiskQueue::kPriorityNormal))) {
+            return 1;
+        }
+        theRecorder.Open();
+        theRecorder.Wait();
+        const Entry kQueueOrder[] = {
+            Entry(0, 1), Entry(1, 1), Entry(1, 2)
+        };
+        if (! theRecorder.Check("priority off queue order", kQueueOrder, 3)) {
+            theRet = 1;
+        }
+
+        // Classes are dispatched in priority order, but the requests to the
+        // file with requests queued join the queued requests class. Set low
+        // priority class deadline that is never reached in order to turn on
+        // the classes.
+        theQueue.SetPriorityParameters(
+            QCDiskQueue::kPriorityLow, 0, 10000 * kMilliSec);
+        theRecorder.Close();
+        if (! theRecorder.Add(Read(theQueue, 0, 0, theRecorder))) {
+            return 1;
+        }
+        theRecorder.WaitForGate();
+        if (! theRecorder.Add(Read(theQueue, 0, 1, theRecorder,
+                    QCDiskQueue::kPriorityLow)) ||
+                ! theRecorder.Add(Read(theQueue, 1, 1, theRecorder,
+                    QCDiskQueue::kPriorityHigh)) ||
+                ! theRecorder.Add(Read(theQueue, 0, 2, theRecorder,
+                    QCDiskQueue::kPriorityHigh)) ||
+                ! theRecorder.Add(Read(theQueue, 1, 2, theRecorder,
+                    QCDiskQueue::kPriorityNormal))) {
+            return 1;
+        }
+        theRecorder.Open();
+        theRecorder.Wait();
+        const Entry kFileOrder[] = {
+            Entry(1, 1), Entry(1, 2), Entry(0, 1), Entry(0, 2)
+        };
+        if (! theRecorder.Check("priority file order", kFileOrder, 4)) {
+            theRet = 1;
+        }
+
+        // Deadline set after the requests are queued only has effect once
+        // the requests waited longer than the deadline.
+        theRecorder.Close();
+        if (! theRecorder.Add(Read(theQueue, 0, 0, theRecorder))) {
+            return 1;
+        }
+        theRecorder.WaitForGate();
+        if (! theRecorder.Add(Read(theQueue, 0, 1, theRecorder,
+                    QCDiskQueue::kPriorityLow)) ||
+                ! theRecorder.Add(Read(theQueue, 1, 1, theRecorder,
+                    QCDiskQueue::kPriorityHigh)) ||
+                ! theRecorder.Add(Read(theQueue, 1, 2, theRecorder,
+                    QCDiskQueue::kPriorityHigh))) {
+            return 1;
+        }
+        theQueue.SetPriorityParameters(
+            QCDiskQueue::kPriorityLow, 0, 10000 * kMilliSec);
+        theRecorder.Open();
+        theRecorder.Wait();
+        const Entry kNoDeadlineOrder[] = {
+            Entry(1, 1), Entry(1, 2), Entry(0, 1)
+        };
+        if (! theRecorder.Check("priority deadline not reached",
+                kNoDeadlineOrder, 3)) {
+            theRet = 1;
+        }
+
+        // Request past its class deadline is dispatched first.
+        theQueue.SetPriorityParameters(QCDiskQueue::kPriorityLow, 0, kMilliSec);
+        theRecorder.Close();
+        if (! theRecorder.Add(Read(theQueue, 0, 0, theRecorder))) {
+            return 1;
+        }
+        theRecorder.WaitForGate();
+        if (! theRecorder.Add(Read(theQueue, 0, 1, theRecorder,
+                    QCDiskQueue::kPriorityLow)) ||
+                ! theRecorder.Add(Read(theQueue, 1, 1, theRecorder,
+                    QCDiskQueue::kPriorityHigh)) ||
+                ! theRecorder.Add(Read(theQueue, 1, 2, theRecorder,
+                    QCDiskQueue::kPriorityHigh))) {
+            return 1;
+        }
+        usleep(20 * 1000);
+        theRecorder.Open();
+        theRecorder.Wait();
+        const Entry kDeadlineOrder[] = {
+            Entry(0, 1), Entry(1, 1), Entry(1, 2)
+        };
+        if (! theRecorder.Check("priority deadline", kDeadlineOrder, 3)) {
+            theRet = 1;
+        }
+
+        // Low priority request is dispatched under continuous high priority
+        // load once it is past its class deadline.
+        const int kMaxHighCount = 1 << 20;
+        theQueue.SetPriorityParameters(
+            QCDiskQueue::kPriorityLow, 0, 10 * kMilliSec);
+        {
+            HighLoad theLoad(theQueue, 1, kMaxHighCount);
+            for (int i = 0; i < 8; i++) {
+                if (! theLoad.Add(QCDiskQueue::kPriorityHigh)) {
+                    return 1;
+                }
+            }
+            if (! theLoad.Add(QCDiskQueue::kPriorityLow, 0)) {
+                return 1;
+            }
+            theLoad.Wait();
+            const bool theOkFlag = ! theLoad.IsError() &&
+                theLoad.IsLowDone() && theLoad.GetHighCount() < kMaxHighCount;
+            cout << "priority deadline under load: " <<
+                (theOkFlag ? "OK" : "FAILED") <<
+                " high priority requests: " << theLoad.GetHighCount() << endl;
+            if (! theOkFlag) {
+                theRet = 1;
+            }
+        }
+        theQueue.SetPriorityParameters(QCDiskQueue::kPriorityLow, 0, 0);
+        theQueue.Stop();
+        return theRet;
+    }
+    // Write coalescing test. Requires at least two files. The writes
+    // appended to the write being processed complete right after it, ahead
+    // of the requests queued before them.
+    int CoalesceTest(
+        int          inFileCount,
+        const char** inFileNamesPtr)
+    {
+        if (inFileCount < 2) {
+            cout << "coalesce test requires two files, skipped" << endl;
+            return 0;
+        }
+        QCIoBufferPool theBufPool;
+        const int      kBufferSize = 4 << 10;
+        int theSysErr = theBufPool.Create(1, 256, kBufferSize, false);
+        if (theSysErr) {
+            cerr << "failed to create buffer pool: " <<
+                QCUtils::SysError(theSysErr) << endl;
+            return 1;
+        }
+        QCDiskQueue theQueue;
+        const bool kRequestAffinityFlag = true;
+        theSysErr = theQueue.Start(
+            1,
+            64,
+            16,
+            inFileCount,
+            inFileNamesPtr,
+            theBufPool,
+            0,
+            QCDiskQueue::CpuAffinity::None(),
+            0,
+            false,
+            true,
+            kRequestAffinityFlag
+        );
+        if (theSysErr) {
+            cerr << "failed to create disk queue: " <<
+                QCUtils::SysError(theSysErr) << endl;
+            return 1;
+        }
+        theQueue.SetMaxCoalescedWriteBlockCount(16);
+        typedef OrderRecorder::Entry Entry;
+        OrderRecorder theRecorder;
+        int           theRet = 0;
+
+        // Adjacent writes are coalesced.
+        theRecorder.Close();
+        if (! theRecorder.Add(Read(theQueue, 1, 0, theRecorder))) {
+            return 1;
+        }
+        theRecorder.WaitForGate();
+        if (! theRecorder.Add(
+                    Write(theQueue, theBufPool, 0, 0, theRecorder)) ||
+                ! theRecorder.Add(Read(theQueue, 1, 1, theRecorder)) ||
+                ! theRecorder.Add(
+                    Write(theQueue, theBufPool, 0, 1, theRecorder))) {
+            return 1;
+        }
+        theRecorder.Open();
+        theRecorder.Wait();
+        const Entry kAdjacentOrder[] = {
+            Entry(0, 0), Entry(0, 1), Entry(1, 1)
+        };
+        if (! theRecorder.Check("coalesce adjacent", kAdjacentOrder, 3)) {
+            theRet = 1;
+        }
+
+        // Non adjacent writes are not coalesced.
+        theRecorder.Close();
+        if (! theRecorder.Add(Read(theQueue, 1, 0, theRecorder))) {
+            return 1;
+        }
+        theRecorder.WaitForGate();
+        if (! theRecorder.Add(
+                    Write(theQueue, theBufPool, 0, 0, theRecorder)) ||
+                ! theRecorder.Add(Read(theQueue, 1, 1, theRecorder)) ||
+                ! theRecorder.Add(
+                    Write(theQueue, theBufPool, 0, 2, theRecorder))) {
+            return 1;
+        }
+        theRecorder.Open();
+        theRecorder.Wait();
+        const Entry kNonAdjacentOrder[] = {
+            Entry(0, 0), Entry(1, 1), Entry(0, 2)
+        };
+        if (! theRecorder.Check("coalesce non adjacent",
+                kNonAdjacentOrder, 3)) {
+            theRet = 1;
+        }
+
+        // Writes queued with different classes join the class of the first
+        // queued write, and are coalesced. With the class limited to one
+        // request in flight, the coalesced writes must be charged to and
+        // released from the class, otherwise the following low priority
+        // read would never be dispatched, or the limit would not apply.
+        theQueue.SetPriorityParameters(QCDiskQueue::kPriorityLow, 1, 0);
+        theRecorder.Close();
+        if (! theRecorder.Add(Read(theQueue, 1, 0, theRecorder))) {
+            return 1;
+        }
+        theRecorder.WaitForGate();
+        if (! theRecorder.Add(Write(theQueue, theBufPool, 0, 0, theRecorder,
+                    QCDiskQueue::kPriorityLow)) ||
+                ! theRecorder.Add(Read(theQueue, 1, 1, theRecorder)) ||
+                ! theRecorder.Add(Write(theQueue, theBufPool, 0, 1,
+                    theRecorder, QCDiskQueue::kPriorityHigh)) ||
+                ! theRecorder.Add(Write(theQueue, theBufPool, 0, 2,
+                    theRecorder, QCDiskQueue::kPriorityNormal))) {
+            return 1;
+        }
+        theRecorder.Open();
+        theRecorder.Wait();
+        const Entry kMixedOrder[] = {
+            Entry(1, 1), Entry(0, 0), Entry(0, 1), Entry(0, 2)
+        };
+        if (! theRecorder.Check("coalesce mixed classes", kMixedOrder, 4)) {
+            theRet = 1;
+        }
+        theRecorder.Close();
+        if (! theRecorder.Add(Read(theQueue, 1, 0, theRecorder))) {
+            return 1;
+        }
+        theRecorder.WaitForGate();
+        if (! theRecorder.Add(Read(theQueue, 0, 3, theRecorder,
+                    QCDiskQueue::kPriorityLow))) {
+            return 1;
+        }
+        theRecorder.Open();
+        theRecorder.Wait();
+        const Entry kLowOrder[] = { Entry(0, 3) };
+        if (! theRecorder.Check("coalesce class release", kLowOrder, 1)) {
+            theRet = 1;
+        }
+        theQueue.SetPriorityParameters(QCDiskQueue::kPriorityLow, 0, 0);
+
+        // Write is not coalesced ahead of the overlapping write to the same
+        // file queued before it, otherwise the older data would overwrite
+        // the newer.
+        theRecorder.Close();
+        if (! theRecorder.Add(Read(theQueue, 1, 0, theRecorder))) {
+            return 1;
+        }
+        theRecorder.WaitForGate();
+        if (! theRecorder.Add(
+                    Write(theQueue, theBufPool, 0, 4, theRecorder)) ||
+                ! theRecorder.Add(
+                    Write(theQueue, theBufPool, 0, 6, theRecorder)) ||
+                ! theRecorder.Add(Write(theQueue, theBufPool, 0, 5,
+                    theRecorder, QCDiskQueue::kPriorityNormal, 3))) {
+            return 1;
+        }
+        theRecorder.Open();
+        theRecorder.Wait();
+        const Entry kOverlapOrder[] = {
+            Entry(0, 4), Entry(0, 6), Entry(0, 5)
+        };
+        if (! theRecorder.Check("coalesce overlapping", kOverlapOrder, 3)) {
+            theRet = 1;
+        }
+
+        // Each coalesced write completes individually with its own byte
+        // count.
+        const int kFanOutCount = 8;
+        theRecorder.Close();
+        if (! theRecorder.Add(Read(theQueue, 1, 0, theRecorder))) {
+            return 1;
+        }
+        theRecorder.WaitForGate();
+        for (int i = 0; i < kFanOutCount; i++) {
+            if (! theRecorder.Add(
+                    Write(theQueue, theBufPool, 0, 8 + i, theRecorder))) {
+                return 1;
+            }
+        }
+        theRecorder.Open();
+        theRecorder.Wait();
+        Entry theFanOutOrder[kFanOutCount];
+        for (int i = 0; i < kFanOutCount; i++) {
+            theFanOutOrder[i] = Entry(0, 8 + i);
+        }
+        if (! theRecorder.Check("coalesce completion",
+                theFanOutOrder, kFanOutCount) ||
+                theRecorder.GetIoByteCount() !=
+                    int64_t(kFanOutCount + 1) * kBufferSize) {
+            cout << "coalesce completion: byte count: " <<
+                theRecorder.GetIoByteCount() << endl;
+            theRet = 1;
+        }
+        theQueue.Stop();
+        return theRet;
+    }
+    static QCDiskQueue::EnqueueStatus Write(
+        QCDiskQueue&          inQueue,
+        QCIoBufferPool&       inBufPool,
+        QCDiskQueue::FileIdx  inFileIdx,
+        QCDiskQueue::BlockIdx inBlockIdx,
+        OrderRecorder&        inRecorder,
+        QCDiskQueue::Priority inPriority = QCDiskQueue::kPriorityNormal,
+        int                   inBufferCount = 1)
+    {
+        Iterator theItr(inBufferCount);
+        for (int i = 0; i < inBufferCount; i++) {
+            char* const theBufPtr = inBufPool.Get();
+            if (! theBufPtr) {
+                PutBuffers(inBufPool, theItr);
+                return QCDiskQueue::EnqueueStatus(
+                    QCDiskQueue::kRequestIdNone,
+                    QCDiskQueue::kErrorOutOfBuffers);
+            }
+            memset(theBufPtr, 'a' + int((inBlockIdx + i) % 26),
+                inBufPool.GetBufferSize());
+            theItr.Put(theBufPtr);
+        }
+        const QCDiskQueue::EnqueueStatus theStatus = inQueue.Write(
+            inFileIdx, inBlockIdx, &theItr.Reset(), inBufferCount,
+            &inRecorder, -1, false, -1, inPriority);
+        if (! theStatus.IsGood()) {
+            PutBuffers(inBufPool, theItr);
+        }
+        return theStatus;
+    }
+    static void PutBuffers(
+        QCIoBufferPool& inBufPool,
+        Iterator&       inItr)
+    {
+        inItr.Reset();
+        char* theBufPtr;
+        while ((theBufPtr = inItr.Get())) {
+            inBufPool.Put(theBufPtr);
+        }
+    }
+    static QCDiskQueue::EnqueueStatus Read(
+        QCDiskQueue&          inQueue,
+        QCDiskQueue::FileIdx  inFileIdx,
+        QCDiskQueue::BlockIdx inBlockIdx,
+        OrderRecorder&        inRecorder,
+        QCDiskQueue::Priority inPriority = QCDiskQueue::kPriorityNormal)
+    {
+        return inQueue.Read(
+            inFileIdx, inBlockIdx, 0, 1, &inRecorder, -1, inPriority);
+    }
+
     QCDiskQueueTest()
         {}
     ~QCDiskQueueTest()
@@ -437,5 +1101,11 @@ main(int argc, char** argv)
     }
 
     QCDiskQueueTest theTest;
-    return theTest.DoTest(argc - 1, (const char**)(argv + 1));
+    if (theTest.DoTest(argc - 1, (const char**)(argv + 1)) != 0) {
+        return 1;
+    }
+    if (theTest.PriorityTest(argc - 1, (const char**)(argv + 1)) != 0) {
+        return 1;
+    }
+    return theTest.CoalesceTest(argc - 1, (const char**)(argv + 1));
 }
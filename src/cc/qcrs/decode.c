@@ -26,50 +26,12 @@
  *------------------------------------------------------------------------------
  */
 
-#include <string.h>     /* for memset */
-
 #include "rs.h"
+#include "kernels.h"
 #include "rs_table.h"
 #include "prim.h"
 
-/* Compute P syndrome over data[?][i]. */
-static v16
-P(v16 **data, int n, int i)
-{
-    int j;
-    v16 p;
-
-    p = data[n-1][i];
-    for (j = n-2; j >= 0; j--)
-        p ^= data[j][i];
-    return p;
-}
-
-/* Compute Q syndrome over data[?][i]. */
-static v16
-Q(v16 **data, int n, int i)
-{
-    int j;
-    v16 q;
-
-    q = data[n-1][i];
-    for (j = n-2; j >= 0; j--)
-        q = mul2(q) ^ data[j][i];
-    return q;
-}
-
-/* Compute R syndrome over data[?][i]. */
-static v16
-R(v16 **data, int n, int i)
-{
-    int j;
-    v16 r;
-
-    r = data[n-1][i];
-    for (j = n-2; j >= 0; j--)
-        r = mul2(mul2(r)) ^ data[j][i];
-    return r;
-}
+typedef v16 vec;
 
 static v16
 mulby(uint8_t x, v16 v)
@@ -116,38 +78,8 @@ mulby(uint8_t x, v16 v)
 #endif
 }
 
-/* Recover data block x using P syndrome. */
-static void
-rs_decode1p(int n, int blocksize, int x, v16 **data)
-{
-    int i;
-
-    memset(data[x], 0, blocksize);
-    for (i = 0; i < blocksize/sizeof(v16); i++)
-        data[x][i] = P(data, n, i) ^ data[n][i];
-}
-
-/* Recover data block x using Q syndrome. */
-static void
-rs_decode1q(int n, int blocksize, int x, v16 **data)
-{
-    int i;
-
-    memset(data[x], 0, blocksize);
-    for (i = 0; i < blocksize/sizeof(v16); i++)
-        data[x][i] = mulby(rs_r1Q[x], Q(data, n, i) ^ data[n+1][i]);
-}
-
-/* Recover data block x using R syndrome. */
-static void
-rs_decode1r(int n, int blocksize, int x, v16 **data)
-{
-    int i;
-
-    memset(data[x], 0, blocksize);
-    for (i = 0; i < blocksize/sizeof(v16); i++)
-        data[x][i] = mulby(rs_r1R[x], R(data, n, i) ^ data[n+2][i]);
-}
+#define RS_KERNELS_NAME rs_kernels16
+#include "kernels_impl.h"
 
 static void
 rs_encode_if_requested(int nblocks, int blocksize, void **data)
@@ -174,111 +106,7 @@ rs_decode1(int nblocks, int blocksize, int x, void **data)
     }
 
     /* Missing data block, use P to recover. */
-    rs_decode1p(n, blocksize, x, (v16**)data);
-}
-
-/* Recover data blocks x and y using syndromes P & Q. */
-static void
-rs_decode2pq(int n, int blocksize, int x, int y, v16 **data)
-{
-    int i;
-    v16 pp, qq;
-    const uint8_t* const c = rs_r2PQ[rs_r2map[x][y]];
-#ifndef KFS_QCRS_DONT_INLINE
-    v16** pd = data + n - 1;
-#endif
-
-    memset(data[x], 0, blocksize);
-    memset(data[y], 0, blocksize);
-    for (i = 0; i < blocksize/sizeof(v16); i++) {
-#ifndef KFS_QCRS_DONT_INLINE
-        pp = (*pd)[i];
-        qq = pp;
-        while (data <= --pd) {
-            const v16 d = (*pd)[i];
-            pp ^= d;
-            qq = mul2(qq) ^ d;
-        }
-        pd = data + n + 1;
-        qq ^= (*pd--)[i];
-        pp ^= (*pd--)[i];
-#else
-        pp = P(data, n, i) ^ data[n][i];
-        qq = Q(data, n, i) ^ data[n+1][i];
-#endif
-        data[x][i] = mulby(c[0], pp) ^ mulby(c[1], qq);
-        data[y][i] = mulby(c[2], pp) ^ mulby(c[3], qq);
-    }
-}
-
-/* Recover data blocks x and y using syndromes P & R. */
-static void
-rs_decode2pr(int n, int blocksize, int x, int y, v16 **data)
-{
-    int i;
-    v16 pp, rr;
-    const uint8_t* const c = rs_r2PR[rs_r2map[x][y]];
-#ifndef KFS_QCRS_DONT_INLINE
-    v16** pd = data + n - 1;
-#endif
-
-    memset(data[x], 0, blocksize);
-    memset(data[y], 0, blocksize);
-    for (i = 0; i < blocksize/sizeof(v16); i++) {
-#ifndef KFS_QCRS_DONT_INLINE
-        pp = (*pd)[i];
-        rr = pp;
-        while (data <= --pd) {
-            const v16 d = (*pd)[i];
-            pp ^= d;
-            rr = mul2(mul2(rr)) ^ d;
-        }
-        pd = data + n + 2;
-        rr ^= (*pd--)[i];
-        pd--;
-        pp ^= (*pd--)[i];
-#else
-        pp = P(data, n, i) ^ data[n][i];
-        rr = R(data, n, i) ^ data[n+2][i];
-#endif
-        data[x][i] = mulby(c[0], pp) ^ mulby(c[1], rr);
-        data[y][i] = mulby(c[2], pp) ^ mulby(c[3], rr);
-    }
-}
-
-/* Recover data blocks x and y using syndromes Q & R. */
-static void
-rs_decode2qr(int n, int blocksize, int x, int y, v16 **data)
-{
-    int i;
-    v16 qq, rr;
-    const uint8_t* const c = rs_r2QR[rs_r2map[x][y]];
-#ifndef KFS_QCRS_DONT_INLINE
-    v16** pd = data + n - 1;
-#endif
-
-    memset(data[x], 0, blocksize);
-    memset(data[y], 0, blocksize);
-    for (i = 0; i < blocksize/sizeof(v16); i++) {
-#ifndef KFS_QCRS_DONT_INLINE
-        qq = (*pd)[i];
-        rr = qq;
-        while (data <= --pd) {
-            const v16 d = (*pd)[i];
-            qq = mul2(qq) ^ d;
-            rr = mul2(mul2(rr)) ^ d;
-        }
-        pd = data + n + 2;
-        rr ^= (*pd--)[i];
-        qq ^= (*pd--)[i];
-        pd--;
-#else
-        qq = Q(data, n, i) ^ data[n+1][i];
-        rr = R(data, n, i) ^ data[n+2][i];
-#endif
-        data[x][i] = mulby(c[0], qq) ^ mulby(c[1], rr);
-        data[y][i] = mulby(c[2], qq) ^ mulby(c[3], rr);
-    }
+    rs_run_kernel(RS_K_DECODE1P, n, blocksize, x, 0, 0, data);
 }
 
 /*
@@ -289,7 +117,6 @@ void
 rs_decode2(int nblocks, int blocksize, int x, int y, void **idata)
 {
     int n, tmp;
-    v16 **data = (v16**)idata;
 
     if (x > y) { tmp = x; x = y; y = tmp; }
 
@@ -303,58 +130,18 @@ rs_decode2(int nblocks, int blocksize, int x, int y, void **idata)
 
     /* x is a data block, y is a syndrome. */
     if (y == n) {   /* P */
-        rs_decode1q(n, blocksize, x, data);
+        rs_run_kernel(RS_K_DECODE1Q, n, blocksize, x, 0, 0, idata);
         rs_encode_if_requested(nblocks, blocksize, idata);
         return;
     }
     if (y == n+1 || y == n+2) { /* Q or R */
-        rs_decode1p(n, blocksize, x, data);
+        rs_run_kernel(RS_K_DECODE1P, n, blocksize, x, 0, 0, idata);
         rs_encode_if_requested(nblocks, blocksize, idata);
         return;
     }
 
     /* Otherwise, x & y are both data blocks; use P & Q */
-    rs_decode2pq(n, blocksize, x, y, data);
-}
-
-/* Recover data blocks x, y, & z using syndromes P, Q & R. */
-static void
-rs_decode3pqr(int n, int blocksize, int x, int y, int z, v16 **data)
-{
-    int i;
-    v16 pp, qq, rr;
-    const uint8_t* const c = rs_r3[rs_r3map[x][y][z]];
-#ifndef KFS_QCRS_DONT_INLINE
-    v16** pd = data + n - 1;
-#endif
-
-    memset(data[x], 0, blocksize);
-    memset(data[y], 0, blocksize);
-    memset(data[z], 0, blocksize);
-    for (i = 0; i < blocksize/sizeof(v16); i++) {
-#ifndef KFS_QCRS_DONT_INLINE
-        pp = (*pd)[i];
-        qq = pp;
-        rr = pp;
-        while (data <= --pd) {
-            const v16 d = (*pd)[i];
-            pp ^= d;
-            qq = mul2(qq) ^ d;
-            rr = mul2(mul2(rr)) ^ d;
-        }
-        pd = data + n + 2;
-        rr ^= (*pd--)[i];
-        qq ^= (*pd--)[i];
-        pp ^= (*pd--)[i];
-#else
-        pp = P(data, n, i) ^ data[n][i];
-        qq = Q(data, n, i) ^ data[n+1][i];
-        rr = R(data, n, i) ^ data[n+2][i];
-#endif
-        data[x][i] = mulby(c[0], pp) ^ mulby(c[1], qq) ^ mulby(c[2], rr);
-        data[y][i] = mulby(c[3], pp) ^ mulby(c[4], qq) ^ mulby(c[5], rr);
-        data[z][i] = mulby(c[6], pp) ^ mulby(c[7], qq) ^ mulby(c[8], rr);
-    }
+    rs_run_kernel(RS_K_DECODE2PQ, n, blocksize, x, y, 0, idata);
 }
 
 /*
@@ -365,7 +152,6 @@ void
 rs_decode3(int nblocks, int blocksize, int x, int y, int z, void **idata)
 {
     int n, tmp;
-    v16 **data = (v16**)idata;
 
     if (x > y) { tmp = x; x = y; y = tmp; }
     if (x > z) { tmp = x; x = z; z = tmp; }
@@ -381,38 +167,38 @@ rs_decode3(int nblocks, int blocksize, int x, int y, int z, void **idata)
 
     /* x is a data block, y & z are syndromes. */
     if (y == n && z == n+1) {
-        rs_decode1r(n, blocksize, x, data);
+        rs_run_kernel(RS_K_DECODE1R, n, blocksize, x, 0, 0, idata);
         rs_encode_if_requested(nblocks, blocksize, idata);
         return;
     }
     if (y == n && z == n+2) {
-        rs_decode1q(n, blocksize, x, data);
+        rs_run_kernel(RS_K_DECODE1Q, n, blocksize, x, 0, 0, idata);
         rs_encode_if_requested(nblocks, blocksize, idata);
         return;
     }
     if (y == n+1 && z == n+2) {
-        rs_decode1p(n, blocksize, x, data);
+        rs_run_kernel(RS_K_DECODE1P, n, blocksize, x, 0, 0, idata);
         rs_encode_if_requested(nblocks, blocksize, idata);
         return;
     }
 
     /* x & y are data blocks, z is a syndrome. */
     if (z == n) {   /* P */
-        rs_decode2qr(n, blocksize, x, y, data);
+        rs_run_kernel(RS_K_DECODE2QR, n, blocksize, x, y, 0, idata);
         rs_encode_if_requested(nblocks, blocksize, idata);
         return;
     }
     if (z == n+1) { /* Q */
-        rs_decode2pr(n, blocksize, x, y, data);
+        rs_run_kernel(RS_K_DECODE2PR, n, blocksize, x, y, 0, idata);
         rs_encode_if_requested(nblocks, blocksize, idata);
         return;
     }
     if (z == n+2) { /* R */
-        rs_decode2pq(n, blocksize, x, y, data);
+        rs_run_kernel(RS_K_DECODE2PQ, n, blocksize, x, y, 0, idata);
         rs_encode_if_requested(nblocks, blocksize, idata);
         return;
     }
 
     /* Otherwise, x, y & x are all data blocks; use P, Q, & R*/
-    rs_decode3pqr(n, blocksize, x, y, z, data);
+    rs_run_kernel(RS_K_DECODE3PQR, n, blocksize, x, y, z, idata);
 }
@@ -0,0 +1,103 @@
+/*---------------------------------------------------------- -*- Mode: C -*-----
+ * $Id$
+ *
+ * Created 2026/10/16
+ *
+ * Copyright 2026 Quantcast Corp.
+ *
+ * This file is part of Kosmos File System (KFS).
+ *
+ * Licensed under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+ * implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ *
+ * \file dispatch.c
+ * \brief Reed Solomon encoder and decoder run time kernel selection.
+ *
+ *------------------------------------------------------------------------------
+ */
+
+#include <stddef.h>
+
+#include "rs.h"
+#include "kernels.h"
+
+static const rs_kernels* volatile rs_cur_kernels = NULL;
+
+static const rs_kernels*
+rs_select_kernels(int max_size)
+{
+#if defined(LIBRS_USE_AVX2) || defined(LIBRS_USE_AVX512)
+    __builtin_cpu_init();
+#endif
+#ifdef LIBRS_USE_AVX512
+    if ((max_size <= 0 || 64 <= max_size) &&
+            __builtin_cpu_supports("avx512bw"))
+        return &rs_kernels64;
+#endif
+#ifdef LIBRS_USE_AVX2
+    if ((max_size <= 0 || 32 <= max_size) &&
+            __builtin_cpu_supports("avx2"))
+        return &rs_kernels32;
+#endif
+    return &rs_kernels16;
+}
+
+const rs_kernels*
+rs_get_kernels(void)
+{
+    const rs_kernels* kn = rs_cur_kernels;
+
+    /* Selection is idempotent, therefore a race here is benign. */
+    if (! kn) {
+        kn = rs_select_kernels(0);
+        rs_cur_kernels = kn;
+    }
+    return kn;
+}
+
+int
+rs_set_max_vector_size(int max_size)
+{
+    const rs_kernels* const kn = rs_select_kernels(max_size);
+
+    rs_cur_kernels = kn;
+    return kn->size;
+}
+
+int
+rs_get_vector_size(void)
+{
+    return rs_get_kernels()->size;
+}
+
+/*
+ * Process the largest prefix of the blocks that is multiple of the vector
+ * size with the selected kernel, and the remainder with 16 bytes kernel.
+ * The kernels never access missing / null syndrome blocks, the null
+ * pointers are passed to the tail kernel as is.
+ */
+void
+rs_run_kernel(int k, int n, int blocksize, int x, int y, int z, void **data)
+{
+    const rs_kernels* const kn = rs_get_kernels();
+    const int head = blocksize - blocksize % kn->size;
+    void* tail[RS_LIB_MAX_DATA_BLOCKS + RS_LIB_MAX_RECOVERY_BLOCKS];
+    int i;
+
+    if (head > 0)
+        kn->fn[k](n, head, x, y, z, data);
+    if (head >= blocksize)
+        return;
+    for (i = 0; i < n + RS_LIB_MAX_RECOVERY_BLOCKS; i++)
+        tail[i] = data[i] ? (char*)data[i] + head : NULL;
+    rs_kernels16.fn[k](n, blocksize - head, x, y, z, tail);
+}
@@ -0,0 +1,86 @@
+/*---------------------------------------------------------- -*- Mode: C -*-----
+ * $Id$
+ *
+ * Created 2026/10/16
+ *
+ * Copyright 2026 Quantcast Corp.
+ *
+ * This file is part of Kosmos File System (KFS).
+ *
+ * Licensed under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+ * implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ *
+ * \file kernels.h
+ * \brief Reed Solomon encoder and decoder vector kernel tables.
+ *
+ * Each vector width has its own kernel table. The table is selected at run
+ * time from cpuid, the 16 byte kernels are always present and used as the
+ * fallback, and to process the block tail that is not a multiple of the wide
+ * vector size.
+ *
+ *------------------------------------------------------------------------------
+ */
+
+#ifndef RS_KERNELS_H
+#define RS_KERNELS_H
+
+#include "rs.h"
+
+enum
+{
+    RS_K_ENCODE,
+    RS_K_DECODE1P,
+    RS_K_DECODE1Q,
+    RS_K_DECODE1R,
+    RS_K_DECODE2PQ,
+    RS_K_DECODE2PR,
+    RS_K_DECODE2QR,
+    RS_K_DECODE3PQR,
+    RS_K_COUNT
+};
+
+/*
+ * n is the number of data blocks, blocksize must be a multiple of the
+ * kernel vector size. x, y, and z are the missing data blocks, the
+ * arguments that a kernel does not need are ignored.
+ */
+typedef void (*rs_kernel)(int n, int blocksize, int x, int y, int z,
+    void **data);
+
+/* General matrix multiplication, see rs_matrix_mul(). */
+typedef void (*rs_matrix_kernel)(int nrows, int ncols,
+    const unsigned char *matrix, int blocksize, void **src, void **dst);
+
+struct rs_kernels
+{
+    int              size;     /* vector size in bytes */
+    rs_kernel        fn[RS_K_COUNT];
+    rs_matrix_kernel matrix_mul;
+};
+typedef struct rs_kernels rs_kernels;
+
+extern const rs_kernels rs_kernels16;
+#ifdef LIBRS_USE_AVX2
+extern const rs_kernels rs_kernels32;
+#endif
+#ifdef LIBRS_USE_AVX512
+extern const rs_kernels rs_kernels64;
+#endif
+
+/* Run kernel k with the widest available kernel table. */
+void rs_run_kernel(int k, int n, int blocksize, int x, int y, int z,
+    void **data);
+
+/* Return the selected kernel table. */
+const rs_kernels* rs_get_kernels(void);
+
+#endif /* RS_KERNELS_H */
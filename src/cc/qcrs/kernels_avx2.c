@@ -0,0 +1,68 @@
+/*---------------------------------------------------------- -*- Mode: C -*-----
+ * $Id$
+ *
+ * Created 2026/10/16
+ *
+ * Copyright 2026 Quantcast Corp.
+ *
+ * This file is part of Kosmos File System (KFS).
+ *
+ * Licensed under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+ * implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ *
+ * \file kernels_avx2.c
+ * \brief Reed Solomon encoder and decoder 32 byte avx2 kernels.
+ *
+ * This file is compiled with -mavx2, the kernels are only invoked if cpuid
+ * reports avx2 support.
+ *
+ *------------------------------------------------------------------------------
+ */
+
+#include <immintrin.h>
+
+#include "rs_table.h"
+
+/* Unaligned type, blocks are only required to be 16 bytes aligned. */
+typedef uint8_t vec __attribute__ ((vector_size (32), aligned (1)));
+typedef int8_t  svec __attribute__ ((vector_size (32)));
+
+#define VEC32(x) ((vec){x,x,x,x, x,x,x,x, x,x,x,x, x,x,x,x, \
+                        x,x,x,x, x,x,x,x, x,x,x,x, x,x,x,x})
+
+static inline vec
+mul2_32(vec v)
+{
+    return (v + v) ^ ((vec)((svec)v < (svec){0}) & VEC32(0x1d));
+}
+
+/* Split nibble table lookup, the same as the 16 bytes ssse3 mulby(). */
+static inline vec
+mulby_32(uint8_t x, vec v)
+{
+    const __m256i lo = _mm256_broadcastsi128_si256(
+        (__m128i)rs_nibmul[x].lo);
+    const __m256i hi = _mm256_broadcastsi128_si256(
+        (__m128i)rs_nibmul[x].hi);
+    const __m256i m  = (__m256i)VEC32(0x0f);
+    const __m256i vv = (__m256i)v;
+
+    return (vec)(
+        _mm256_shuffle_epi8(lo, vv & m) ^
+        _mm256_shuffle_epi8(hi, _mm256_srli_epi16(vv, 4) & m)
+    );
+}
+
+#define mul2  mul2_32
+#define mulby mulby_32
+#define RS_KERNELS_NAME rs_kernels32
+#include "kernels_impl.h"
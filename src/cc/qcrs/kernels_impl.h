@@ -0,0 +1,351 @@
+/*---------------------------------------------------------- -*- Mode: C -*-----
+ * $Id$
+ *
+ * Created 2010/07/24
+ * Author: Dan Adkins
+ *
+ * Copyright 2010-2012 Quantcast Corp.
+ *
+ * This file is part of Kosmos File System (KFS).
+ *
+ * Licensed under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+ * implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ *
+ * \file kernels_impl.h
+ * \brief Reed Solomon encoder and decoder kernels.
+ *
+ * This file is included by each vector width kernel translation unit. The
+ * including file must define vector type `vec', `mul2(vec)', and
+ * `mulby(uint8_t, vec)' primitives, and RS_KERNELS_NAME -- the name of the
+ * resulting kernel table.
+ *
+ *------------------------------------------------------------------------------
+ */
+
+#include <string.h>     /* for memset */
+
+#include "kernels.h"
+#include "rs_table.h"
+
+/* Compute P syndrome over data[?][i]. */
+static vec
+P(vec **data, int n, int i)
+{
+    int j;
+    vec p;
+
+    p = data[n-1][i];
+    for (j = n-2; j >= 0; j--)
+        p ^= data[j][i];
+    return p;
+}
+
+/* Compute Q syndrome over data[?][i]. */
+static vec
+Q(vec **data, int n, int i)
+{
+    int j;
+    vec q;
+
+    q = data[n-1][i];
+    for (j = n-2; j >= 0; j--)
+        q = mul2(q) ^ data[j][i];
+    return q;
+}
+
+/* Compute R syndrome over data[?][i]. */
+static vec
+R(vec **data, int n, int i)
+{
+    int j;
+    vec r;
+
+    r = data[n-1][i];
+    for (j = n-2; j >= 0; j--)
+        r = mul2(mul2(r)) ^ data[j][i];
+    return r;
+}
+
+/*
+ * Reed-Solomon n+3 encoder.
+ * The first n are input data blocks.  The last 3 are the P, Q, and R
+ * syndromes.
+ */
+static void
+rs_encode_k(int n, int blocksize, int x, int y, int z, void **idata)
+{
+    int i, j;
+    vec *p, *q, *r, **data = (vec**)idata;
+
+    p = data[n];
+    q = data[n+1];
+    r = data[n+2];
+    for (i = 0; i < blocksize/sizeof(vec); i++) {
+        p[i] = q[i] = r[i] = data[n-1][i];
+        for (j = n-2; j >= 0; j--) {
+            p[i] ^= data[j][i];
+            q[i] = mul2(q[i]) ^ data[j][i];
+            r[i] = mul2(mul2(r[i])) ^ data[j][i];
+        }
+    }
+}
+
+/* Recover data block x using P syndrome. */
+static void
+rs_decode1p(int n, int blocksize, int x, int y, int z, void **idata)
+{
+    int i;
+    vec **data = (vec**)idata;
+
+    memset(data[x], 0, blocksize);
+    for (i = 0; i < blocksize/sizeof(vec); i++)
+        data[x][i] = P(data, n, i) ^ data[n][i];
+}
+
+/* Recover data block x using Q syndrome. */
+static void
+rs_decode1q(int n, int blocksize, int x, int y, int z, void **idata)
+{
+    int i;
+    vec **data = (vec**)idata;
+
+    memset(data[x], 0, blocksize);
+    for (i = 0; i < blocksize/sizeof(vec); i++)
+        data[x][i] = mulby(rs_r1Q[x], Q(data, n, i) ^ data[n+1][i]);
+}
+
+/* Recover data block x using R syndrome. */
+static void
+rs_decode1r(int n, int blocksize, int x, int y, int z, void **idata)
+{
+    int i;
+    vec **data = (vec**)idata;
+
+    memset(data[x], 0, blocksize);
+    for (i = 0; i < blocksize/sizeof(vec); i++)
+        data[x][i] = mulby(rs_r1R[x], R(data, n, i) ^ data[n+2][i]);
+}
+
+/* Recover data blocks x and y using syndromes P & Q. */
+static void
+rs_decode2pq(int n, int blocksize, int x, int y, int z, void **idata)
+{
+    int i;
+    vec pp, qq, **data = (vec**)idata;
+    const uint8_t* const c = rs_r2PQ[rs_r2map[x][y]];
+#ifndef KFS_QCRS_DONT_INLINE
+    vec** pd = data + n - 1;
+#endif
+
+    memset(data[x], 0, blocksize);
+    memset(data[y], 0, blocksize);
+    for (i = 0; i < blocksize/sizeof(vec); i++) {
+#ifndef KFS_QCRS_DONT_INLINE
+        pp = (*pd)[i];
+        qq = pp;
+        while (data <= --pd) {
+            const vec d = (*pd)[i];
+            pp ^= d;
+            qq = mul2(qq) ^ d;
+        }
+        pd = data + n + 1;
+        qq ^= (*pd--)[i];
+        pp ^= (*pd--)[i];
+#else
+        pp = P(data, n, i) ^ data[n][i];
+        qq = Q(data, n, i) ^ data[n+1][i];
+#endif
+        data[x][i] = mulby(c[0], pp) ^ mulby(c[1], qq);
+        data[y][i] = mulby(c[2], pp) ^ mulby(c[3], qq);
+    }
+}
+
+/* Recover data blocks x and y using syndromes P & R. */
+static void
+rs_decode2pr(int n, int blocksize, int x, int y, int z, void **idata)
+{
+    int i;
+    vec pp, rr, **data = (vec**)idata;
+    const uint8_t* const c = rs_r2PR[rs_r2map[x][y]];
+#ifndef KFS_QCRS_DONT_INLINE
+    vec** pd = data + n - 1;
+#endif
+
+    memset(data[x], 0, blocksize);
+    memset(data[y], 0, blocksize);
+    for (i = 0; i < blocksize/sizeof(vec); i++) {
+#ifndef KFS_QCRS_DONT_INLINE
+        pp = (*pd)[i];
+        rr = pp;
+        while (data <= --pd) {
+            const vec d = (*pd)[i];
+            pp ^= d;
+            rr = mul2(mul2(rr)) ^ d;
+        }
+        pd = data + n + 2;
+        rr ^= (*pd--)[i];
+        pd--;
+        pp ^= (*pd--)[i];
+#else
+        pp = P(data, n, i) ^ data[n][i];
+        rr = R(data, n, i) ^ data[n+2][i];
+#endif
+        data[x][i] = mulby(c[0], pp) ^ mulby(c[1], rr);
+        data[y][i] = mulby(c[2], pp) ^ mulby(c[3], rr);
+    }
+}
+
+/* Recover data blocks x and y using syndromes Q & R. */
+static void
+rs_decode2qr(int n, int blocksize, int x, int y, int z, void **idata)
+{
+    int i;
+    vec qq, rr, **data = (vec**)idata;
+    const uint8_t* const c = rs_r2QR[rs_r2map[x][y]];
+#ifndef KFS_QCRS_DONT_INLINE
+    vec** pd = data + n - 1;
+#endif
+
+    memset(data[x], 0, blocksize);
+    memset(data[y], 0, blocksize);
+    for (i = 0; i < blocksize/sizeof(vec); i++) {
+#ifndef KFS_QCRS_DONT_INLINE
+        qq = (*pd)[i];
+        rr = qq;
+        while (data <= --pd) {
+            const vec d = (*pd)[i];
+            qq = mul2(qq) ^ d;
+            rr = mul2(mul2(rr)) ^ d;
+        }
+        pd = data + n + 2;
+        rr ^= (*pd--)[i];
+        qq ^= (*pd--)[i];
+        pd--;
+#else
+        qq = Q(data, n, i) ^ data[n+1][i];
+        rr = R(data, n, i) ^ data[n+2][i];
+#endif
+        data[x][i] = mulby(c[0], qq) ^ mulby(c[1], rr);
+        data[y][i] = mulby(c[2], qq) ^ mulby(c[3], rr);
+    }
+}
+
+/* Recover data blocks x, y, & z using syndromes P, Q & R. */
+static void
+rs_decode3pqr(int n, int blocksize, int x, int y, int z, void **idata)
+{
+    int i;
+    vec pp, qq, rr, **data = (vec**)idata;
+    const uint8_t* const c = rs_r3[rs_r3map[x][y][z]];
+#ifndef KFS_QCRS_DONT_INLINE
+    vec** pd = data + n - 1;
+#endif
+
+    memset(data[x], 0, blocksize);
+    memset(data[y], 0, blocksize);
+    memset(data[z], 0, blocksize);
+    for (i = 0; i < blocksize/sizeof(vec); i++) {
+#ifndef KFS_QCRS_DONT_INLINE
+        pp = (*pd)[i];
+        qq = pp;
+        rr = pp;
+        while (data <= --pd) {
+            const vec d = (*pd)[i];
+            pp ^= d;
+            qq = mul2(qq) ^ d;
+            rr = mul2(mul2(rr)) ^ d;
+        }
+        pd = data + n + 2;
+        rr ^= (*pd--)[i];
+        qq ^= (*pd--)[i];
+        pp ^= (*pd--)[i];
+#else
+        pp = P(data, n, i) ^ data[n][i];
+        qq = Q(data, n, i) ^ data[n+1][i];
+        rr = R(data, n, i) ^ data[n+2][i];
+#endif
+        data[x][i] = mulby(c[0], pp) ^ mulby(c[1], qq) ^ mulby(c[2], rr);
+        data[y][i] = mulby(c[3], pp) ^ mulby(c[4], qq) ^ mulby(c[5], rr);
+        data[z][i] = mulby(c[6], pp) ^ mulby(c[7], qq) ^ mulby(c[8], rr);
+    }
+}
+
+/*
+ * Multiply up to 4 matrix rows at a time, to keep the accumulators in
+ * registers. The source vector is loaded once per 4 rows.
+ */
+static inline void
+rs_matrix_mul_rows(int nr, int ncols, const uint8_t *matrix,
+    int blocksize, vec **src, vec **dst)
+{
+    int i, j, r;
+    const vec zero = {0};
+    vec acc[4], s;
+    uint8_t c;
+
+    for (i = 0; i < blocksize/sizeof(vec); i++) {
+        for (r = 0; r < nr; r++)
+            acc[r] = zero;
+        for (j = 0; j < ncols; j++) {
+            s = src[j][i];
+            for (r = 0; r < nr; r++) {
+                c = matrix[r*ncols + j];
+                acc[r] ^= c == 1 ? s : mulby(c, s);
+            }
+        }
+        for (r = 0; r < nr; r++)
+            dst[r][i] = acc[r];
+    }
+}
+
+static void
+rs_matrix_mul_k(int nrows, int ncols, const unsigned char *matrix,
+    int blocksize, void **isrc, void **idst)
+{
+    vec **src = (vec**)isrc, **dst = (vec**)idst;
+    int r;
+
+    for (r = 0; r + 4 <= nrows; r += 4)
+        rs_matrix_mul_rows(4, ncols, matrix + r*ncols, blocksize, src,
+            dst + r);
+    switch (nrows - r) {
+        case 3:
+            rs_matrix_mul_rows(3, ncols, matrix + r*ncols, blocksize, src,
+                dst + r);
+            break;
+        case 2:
+            rs_matrix_mul_rows(2, ncols, matrix + r*ncols, blocksize, src,
+                dst + r);
+            break;
+        case 1:
+            rs_matrix_mul_rows(1, ncols, matrix + r*ncols, blocksize, src,
+                dst + r);
+            break;
+        default:
+            break;
+    }
+}
+
+const rs_kernels RS_KERNELS_NAME = {
+    (int)sizeof(vec),
+    {
+        rs_encode_k,
+        rs_decode1p,
+        rs_decode1q,
+        rs_decode1r,
+        rs_decode2pq,
+        rs_decode2pr,
+        rs_decode2qr,
+        rs_decode3pqr
+    },
+    rs_matrix_mul_k
+};
@@ -0,0 +1,355 @@
+/*---------------------------------------------------------- -*- Mode: C -*-----
+ * $Id$
+ *
+ * Created 2026/10/16
+ *
+ * Copyright 2026 Quantcast Corp.
+ *
+ * This file is part of Kosmos File System (KFS).
+ *
+ * Licensed under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+ * implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ *
+ * \file matrix.c
+ * \brief General k+m Reed Solomon code with Cauchy coding matrix, and
+ * locally repairable code.
+ *
+ *------------------------------------------------------------------------------
+ */
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "rs.h"
+#include "rs_table.h"
+#include "kernels.h"
+
+static uint8_t
+gf_mul(uint8_t x, uint8_t y)
+{
+    return ((const uint8_t*)&rs_nibmul[x].lo)[y & 0x0f] ^
+        ((const uint8_t*)&rs_nibmul[x].hi)[y >> 4];
+}
+
+static uint8_t
+gf_inv(uint8_t x)
+{
+    int y;
+
+    for (y = 1; y < 256; y++)
+        if (gf_mul(x, (uint8_t)y) == 1)
+            return (uint8_t)y;
+    return 0;
+}
+
+/*
+ * Cauchy matrix a[i][j] = 1 / (x[i] + y[j]), with x[i] = i, y[j] = m + j.
+ * Scaling columns and rows by non zero constants preserves the property that
+ * every square sub matrix is non singular. Scale the columns to make the
+ * first row all ones, then the rows to make the first column all ones, in
+ * order to reduce the number of multiplications by non unit coefficients.
+ */
+void
+rs_cauchy_matrix(int k, int m, unsigned char *matrix)
+{
+    int i, j;
+    uint8_t c;
+
+    assert(0 < k && 0 < m && k + m <= RS_LIB_MAX_MATRIX_BLOCKS);
+    for (i = 0; i < m; i++)
+        for (j = 0; j < k; j++)
+            matrix[i*k + j] = gf_inv((uint8_t)(i ^ (m + j)));
+    for (j = 0; j < k; j++) {
+        c = gf_inv(matrix[j]);
+        for (i = 0; i < m; i++)
+            matrix[i*k + j] = gf_mul(matrix[i*k + j], c);
+    }
+    for (i = 1; i < m; i++) {
+        c = gf_inv(matrix[i*k]);
+        for (j = 0; j < k; j++)
+            matrix[i*k + j] = gf_mul(matrix[i*k + j], c);
+    }
+}
+
+void
+rs_matrix_mul(int nrows, int ncols, const unsigned char *matrix,
+    int blocksize, void **src, void **dst)
+{
+    const rs_kernels* const kn = rs_get_kernels();
+    const int head = blocksize - blocksize % kn->size;
+    void* tsrc[RS_LIB_MAX_MATRIX_BLOCKS];
+    void* tdst[RS_LIB_MAX_MATRIX_BLOCKS];
+    int i;
+
+    assert(blocksize % 16 == 0);
+    assert(0 < ncols && ncols <= RS_LIB_MAX_MATRIX_BLOCKS &&
+        0 <= nrows && nrows <= RS_LIB_MAX_MATRIX_BLOCKS);
+    if (head > 0)
+        kn->matrix_mul(nrows, ncols, matrix, head, src, dst);
+    if (head >= blocksize)
+        return;
+    for (i = 0; i < ncols; i++)
+        tsrc[i] = (char*)src[i] + head;
+    for (i = 0; i < nrows; i++)
+        tdst[i] = (char*)dst[i] + head;
+    rs_kernels16.matrix_mul(nrows, ncols, matrix, blocksize - head,
+        tsrc, tdst);
+}
+
+/* Gauss-Jordan elimination, a is destroyed. Returns -1 if singular. */
+static int
+gf_invert(int n, uint8_t *a, uint8_t *inv)
+{
+    int i, j, r;
+    uint8_t c, t;
+
+    memset(inv, 0, n * n);
+    for (i = 0; i < n; i++)
+        inv[i*n + i] = 1;
+    for (i = 0; i < n; i++) {
+        for (r = i; r < n && a[r*n + i] == 0; r++)
+            ;
+        if (r >= n)
+            return -1;
+        if (r != i)
+            for (j = 0; j < n; j++) {
+                t = a[i*n + j]; a[i*n + j] = a[r*n + j]; a[r*n + j] = t;
+                t = inv[i*n + j]; inv[i*n + j] = inv[r*n + j];
+                inv[r*n + j] = t;
+            }
+        c = gf_inv(a[i*n + i]);
+        for (j = 0; j < n; j++) {
+            a[i*n + j] = gf_mul(a[i*n + j], c);
+            inv[i*n + j] = gf_mul(inv[i*n + j], c);
+        }
+        for (r = 0; r < n; r++) {
+            if (r == i || (c = a[r*n + i]) == 0)
+                continue;
+            for (j = 0; j < n; j++) {
+                a[r*n + j] ^= gf_mul(a[i*n + j], c);
+                inv[r*n + j] ^= gf_mul(inv[i*n + j], c);
+            }
+        }
+    }
+    return 0;
+}
+
+int
+rs_matrix_decode_matrix(int k, int m, const unsigned char *matrix,
+    int nmissing, const int *missing, int *sources, unsigned char *decode)
+{
+    uint8_t avail[RS_LIB_MAX_MATRIX_BLOCKS];
+    uint8_t *s, *sinv;
+    int i, j, r, x;
+
+    if (k <= 0 || m <= 0 || RS_LIB_MAX_MATRIX_BLOCKS < k + m ||
+            nmissing < 0 || m < nmissing)
+        return -1;
+    memset(avail, 1, k + m);
+    for (i = 0; i < nmissing; i++) {
+        x = missing[i];
+        if (x < 0 || k + m <= x || ! avail[x])
+            return -1;
+        avail[x] = 0;
+    }
+    for (i = 0, j = 0; j < k; i++)
+        if (avail[i])
+            sources[j++] = i;
+    if (! (s = malloc(2 * k * k)))
+        return -1;
+    sinv = s + k * k;
+    /* Rows of the generator matrix [I; matrix] that correspond to sources. */
+    for (i = 0; i < k; i++) {
+        x = sources[i];
+        if (x < k) {
+            memset(s + i*k, 0, k);
+            s[i*k + x] = 1;
+        } else
+            memcpy(s + i*k, matrix + (x - k)*k, k);
+    }
+    if (gf_invert(k, s, sinv) != 0) {
+        free(s);
+        return -1;
+    }
+    for (r = 0; r < nmissing; r++) {
+        x = missing[r];
+        if (x < k) {
+            memcpy(decode + r*k, sinv + x*k, k);
+            continue;
+        }
+        /* Recovery block: coding matrix row times the inverse. */
+        for (j = 0; j < k; j++) {
+            uint8_t c = 0;
+            for (i = 0; i < k; i++)
+                c ^= gf_mul(matrix[(x - k)*k + i], sinv[i*k + j]);
+            decode[r*k + j] = c;
+        }
+    }
+    free(s);
+    return 0;
+}
+
+void
+rs_lrc_matrix(int k, int m, int l, unsigned char *matrix)
+{
+    unsigned char *g;
+    int i, j;
+
+    assert(0 < l && l <= k && l <= m && k + m <= RS_LIB_MAX_MATRIX_BLOCKS);
+    memset(matrix, 0, l * k);
+    for (i = 0; i < l; i++)
+        for (j = i * k / l; j < (i + 1) * k / l; j++)
+            matrix[i*k + j] = 1;
+    if (m <= l)
+        return;
+    /*
+     * The first row of the Cauchy matrix is all ones, it is the sum of the
+     * local parities rows, use the remaining rows as global parities.
+     */
+    g = malloc((m - l + 1) * k);
+    assert(g);
+    rs_cauchy_matrix(k, m - l + 1, g);
+    memcpy(matrix + l*k, g + k, (m - l) * k);
+    free(g);
+}
+
+void
+rs_pqr_matrix(int k, int m, unsigned char *matrix)
+{
+    uint8_t c;
+    int i, j;
+
+    assert(0 < k && 0 < m && m <= RS_LIB_MAX_RECOVERY_BLOCKS);
+    /*
+     * Syndrome r is computed by Horner's rule with multiplier 2^r starting
+     * from the last data block, therefore data block j coefficient is
+     * (2^r)^j.
+     */
+    for (i = 0; i < m; i++) {
+        c = 1;
+        for (j = 0; j < k; j++) {
+            matrix[i*k + j] = c;
+            c = gf_mul(c, (uint8_t)(1 << i));
+        }
+    }
+}
+
+int
+rs_matrix_repair_matrix(int k, int m, const unsigned char *matrix,
+    int nmissing, const int *missing, int ntargets, const int *targets,
+    int *sources, unsigned char *decode)
+{
+    uint8_t avail[RS_LIB_MAX_MATRIX_BLOCKS];
+    uint8_t pivot[RS_LIB_MAX_MATRIX_BLOCKS];
+    uint8_t *e, *c, *v, *w;
+    uint8_t f;
+    int i, j, r, s, x, n, ret;
+
+    if (k <= 0 || m <= 0 || RS_LIB_MAX_MATRIX_BLOCKS < k + m ||
+            nmissing < 0 || k + m < nmissing || ntargets < 0)
+        return -1;
+    memset(avail, 1, k + m);
+    for (i = 0; i < nmissing; i++) {
+        x = missing[i];
+        if (x < 0 || k + m <= x || ! avail[x])
+            return -1;
+        avail[x] = 0;
+    }
+    for (i = 0; i < ntargets; i++)
+        if (targets[i] < 0 || k + m <= targets[i] || avail[targets[i]])
+            return -1;
+    /*
+     * Greedily select linearly independent blocks in index order. Keep the
+     * selected rows of the generator matrix [I; matrix] in the row echelon
+     * form e, and in c the coefficients that express each row of e as a
+     * combination of the selected blocks.
+     */
+    if (! (e = malloc(2 * k * k + 2 * k)))
+        return -1;
+    c = e + k * k;
+    v = c + k * k;
+    w = v + k;
+    r = 0;
+    for (s = 0; s < k + m && r < k; s++) {
+        if (! avail[s])
+            continue;
+        if (s < k) {
+            memset(v, 0, k);
+            v[s] = 1;
+        } else
+            memcpy(v, matrix + (s - k)*k, k);
+        memset(w, 0, k);
+        w[r] = 1;
+        for (i = 0; i < r; i++) {
+            if ((f = v[pivot[i]]) == 0)
+                continue;
+            for (j = 0; j < k; j++) {
+                v[j] ^= gf_mul(e[i*k + j], f);
+                w[j] ^= gf_mul(c[i*k + j], f);
+            }
+        }
+        for (x = 0; x < k && v[x] == 0; x++)
+            ;
+        if (x >= k)
+            continue; /* Linearly dependent. */
+        f = gf_inv(v[x]);
+        for (j = 0; j < k; j++) {
+            e[r*k + j] = gf_mul(v[j], f);
+            c[r*k + j] = gf_mul(w[j], f);
+        }
+        pivot[r] = (uint8_t)x;
+        sources[r++] = s;
+    }
+    /* Express each target as a combination of the selected blocks. */
+    ret = 0;
+    for (n = 0; n < ntargets; n++) {
+        x = targets[n];
+        if (x < k) {
+            memset(v, 0, k);
+            v[x] = 1;
+        } else
+            memcpy(v, matrix + (x - k)*k, k);
+        memset(decode + n*k, 0, k);
+        for (i = 0; i < r; i++) {
+            if ((f = v[pivot[i]]) == 0)
+                continue;
+            for (j = 0; j < k; j++) {
+                v[j] ^= gf_mul(e[i*k + j], f);
+                decode[n*k + j] ^= gf_mul(c[i*k + j], f);
+            }
+        }
+        for (j = 0; j < k && v[j] == 0; j++)
+            ;
+        if (j < k) {
+            ret = -1;
+            break;
+        }
+    }
+    if (ret == 0) {
+        /* Remove the blocks that none of the targets depend on. */
+        for (i = 0, n = 0; i < r; i++) {
+            for (j = 0; j < ntargets && decode[j*k + i] == 0; j++)
+                ;
+            if (j >= ntargets)
+                continue;
+            for (j = 0; j < ntargets; j++)
+                decode[j*k + n] = decode[j*k + i];
+            sources[n++] = sources[i];
+        }
+        for (j = 1; j < ntargets; j++)
+            memmove(decode + j*n, decode + j*k, n);
+        ret = n;
+    }
+    free(e);
+    return ret;
+}
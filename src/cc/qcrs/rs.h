@@ -41,6 +41,72 @@ void rs_decode1(int nblocks, int blocksize, int x, void **data);
 void rs_decode2(int nblocks, int blocksize, int x, int y, void **data);
 void rs_decode3(int nblocks, int blocksize, int x, int y, int z, void **data);
 
+/*
+ * The encoder and decoder use the widest vector kernels supported by the
+ * cpu (64, 32, or 16 bytes), selected at run time. The following limits the
+ * vector size, 0 removes the limit. Both return the vector size in use.
+ */
+int rs_set_max_vector_size(int max_size);
+int rs_get_vector_size(void);
+
+/*
+ * General k+m Reed Solomon code over GF(2^8) defined by m x k Cauchy
+ * coding matrix. k+m must not exceed RS_LIB_MAX_MATRIX_BLOCKS.
+ * The first row and the first column of the coding matrix are all ones,
+ * i.e. the first recovery block is xor of the data blocks.
+ */
+#define RS_LIB_MAX_MATRIX_BLOCKS 256
+
+void rs_cauchy_matrix(int k, int m, unsigned char *matrix);
+
+/*
+ * dst[r] = sum(matrix[r*ncols + c] * src[c]), 0 <= r < nrows, 0 <= c < ncols.
+ * blocksize _must_ be a multiple of 16.
+ */
+void rs_matrix_mul(int nrows, int ncols, const unsigned char *matrix,
+    int blocksize, void **src, void **dst);
+
+/*
+ * Compute nmissing x k decode matrix for missing blocks with indices in
+ * missing[] -- data blocks are [0, k), recovery blocks [k, k+m). The
+ * indices of the k blocks to decode from are returned in sources[].
+ * missing block r is rs_matrix_mul(1, k, decode + r*k, ..., sources blocks).
+ * Returns 0 on success, or -1 if the number of missing blocks exceeds m or
+ * the indices are invalid.
+ */
+int rs_matrix_decode_matrix(int k, int m, const unsigned char *matrix,
+    int nmissing, const int *missing, int *sources, unsigned char *decode);
+
+/*
+ * Locally repairable code m x k coding matrix. The data blocks are split
+ * into l groups of consecutive blocks, group g is [g*k/l, (g+1)*k/l).
+ * Recovery block g < l is xor of the group g data blocks, the remaining
+ * m - l recovery blocks are global Cauchy parities over all data blocks.
+ * Any m - l + 1 missing blocks are recoverable, and a single missing data
+ * block or local parity is recoverable from its group alone.
+ */
+void rs_lrc_matrix(int k, int m, int l, unsigned char *matrix);
+
+/*
+ * m x k coding matrix of the n+3 code rs_encode() computes, m <= 3: the
+ * rows are the P, Q, and R syndromes coefficients. Can be used with the
+ * matrix functions above, for example to compute the repair coefficients.
+ */
+void rs_pqr_matrix(int k, int m, unsigned char *matrix);
+
+/*
+ * General form of rs_matrix_decode_matrix(): compute ntargets x n decode
+ * matrix for the targets[] blocks from the blocks not listed in missing[].
+ * targets[] must be a subset of missing[]. The blocks to decode from are
+ * chosen in index order, only the n blocks with non zero coefficients are
+ * returned in sources[], which must have room for k entries, decode[] must
+ * have room for ntargets x k entries. Returns n, or -1 if the targets
+ * cannot be recovered from the available blocks.
+ */
+int rs_matrix_repair_matrix(int k, int m, const unsigned char *matrix,
+    int nmissing, const int *missing, int ntargets, const int *targets,
+    int *sources, unsigned char *decode);
+
 #ifdef __cplusplus
 }
 #endif
@@ -59,31 +59,228 @@ mkrand(void *buf, int size)
         p[i] = rand();
 }
 
-void *data[RS_LIB_MAX_DATA_BLOCKS+3];
-void *orig[RS_LIB_MAX_DATA_BLOCKS+3];
+#define MATRIX_MAX_RECOVERY_BLOCKS 4
+
+void *data[RS_LIB_MAX_DATA_BLOCKS+MATRIX_MAX_RECOVERY_BLOCKS];
+void *orig[RS_LIB_MAX_DATA_BLOCKS+MATRIX_MAX_RECOVERY_BLOCKS];
+
+/*
+ * Test general k+m code with random erasure patterns, or measure encode and
+ * decode performance with m missing data blocks if iterations > 0.
+ * Return 0 on success, -1 otherwise.
+ */
+static int
+test_matrix(int k, int m, int blocksize, int iterations)
+{
+    unsigned char matrix[MATRIX_MAX_RECOVERY_BLOCKS*RS_LIB_MAX_DATA_BLOCKS];
+    unsigned char decode[MATRIX_MAX_RECOVERY_BLOCKS*RS_LIB_MAX_DATA_BLOCKS];
+    int missing[MATRIX_MAX_RECOVERY_BLOCKS];
+    int sources[RS_LIB_MAX_DATA_BLOCKS];
+    void *src[RS_LIB_MAX_DATA_BLOCKS];
+    void *dst[MATRIX_MAX_RECOVERY_BLOCKS];
+    int i, j, n, x, nmissing;
+    clock_t clk;
+
+    rs_cauchy_matrix(k, m, matrix);
+    for (i = 0; i < k; i++)
+        mkrand(data[i], blocksize);
+    if (iterations > 0) {
+        clk = clock();
+        for (n = 0; n < iterations; n++)
+            rs_matrix_mul(m, k, matrix, blocksize, data, data + k);
+        clk = clock() - clk;
+        printf("matrix %d+%d encode %.3e clocks %.3e sec %.3e bytes/sec\n",
+            k, m, (double)clk, (double)clk/CLOCKS_PER_SEC,
+            blocksize * k * (double)CLOCKS_PER_SEC * iterations /
+                ((double)clk > 0 ? (double)clk : 1e-10));
+        for (i = 0; i < m; i++)
+            missing[i] = i;
+        clk = clock();
+        for (n = 0; n < iterations; n++) {
+            if (rs_matrix_decode_matrix(
+                    k, m, matrix, m, missing, sources, decode) != 0)
+                return -1;
+            for (i = 0; i < k; i++)
+                src[i] = data[sources[i]];
+            for (i = 0; i < m; i++)
+                dst[i] = data[missing[i]];
+            rs_matrix_mul(m, k, decode, blocksize, src, dst);
+        }
+        clk = clock() - clk;
+        printf("matrix %d+%d decode %.3e clocks %.3e sec %.3e bytes/sec\n",
+            k, m, (double)clk, (double)clk/CLOCKS_PER_SEC,
+            blocksize * k * (double)CLOCKS_PER_SEC * iterations /
+                ((double)clk > 0 ? (double)clk : 1e-10));
+        return 0;
+    }
+    rs_matrix_mul(m, k, matrix, blocksize, data, data + k);
+    for (i = 0; i < k + m; i++)
+        memmove(orig[i], data[i], blocksize);
+    for (n = 0; n < 64; n++) {
+        nmissing = 1 + rand() % m;
+        for (i = 0; i < nmissing; ) {
+            x = rand() % (k + m);
+            for (j = 0; j < i && missing[j] != x; j++)
+                ;
+            if (j == i)
+                missing[i++] = x;
+        }
+        for (i = 0; i < nmissing; i++) {
+            memset(data[missing[i]], 0, blocksize);
+            dst[i] = data[missing[i]];
+        }
+        if (rs_matrix_decode_matrix(
+                k, m, matrix, nmissing, missing, sources, decode) != 0)
+            return -1;
+        for (i = 0; i < k; i++)
+            src[i] = data[sources[i]];
+        rs_matrix_mul(nmissing, k, decode, blocksize, src, dst);
+        if (compare(k + m, blocksize, data, orig) != 0)
+            return -1;
+    }
+    return 0;
+}
+
+/*
+ * Locally repairable code with l local groups: any m - l + 1 missing blocks
+ * must be recoverable, and a single missing data block or local parity must
+ * be recovered from its group.
+ */
+static int
+test_lrc(int k, int m, int l, int blocksize)
+{
+    unsigned char matrix[MATRIX_MAX_RECOVERY_BLOCKS*RS_LIB_MAX_DATA_BLOCKS];
+    unsigned char decode[MATRIX_MAX_RECOVERY_BLOCKS*RS_LIB_MAX_DATA_BLOCKS];
+    int missing[MATRIX_MAX_RECOVERY_BLOCKS];
+    int sources[RS_LIB_MAX_DATA_BLOCKS];
+    void *src[RS_LIB_MAX_DATA_BLOCKS];
+    void *dst[MATRIX_MAX_RECOVERY_BLOCKS];
+    int i, j, n, x, g, nmissing, nsources;
+
+    rs_lrc_matrix(k, m, l, matrix);
+    for (i = 0; i < k; i++)
+        mkrand(data[i], blocksize);
+    rs_matrix_mul(m, k, matrix, blocksize, data, data + k);
+    for (i = 0; i < k + m; i++)
+        memmove(orig[i], data[i], blocksize);
+    for (n = 0; n < k + l + 64; n++) {
+        if (n < k + l) {
+            nmissing = 1;
+            missing[0] = n;
+        } else {
+            nmissing = 1 + rand() % (m - l + 1);
+            for (i = 0; i < nmissing; ) {
+                x = rand() % (k + m);
+                for (j = 0; j < i && missing[j] != x; j++)
+                    ;
+                if (j == i)
+                    missing[i++] = x;
+            }
+        }
+        for (i = 0; i < nmissing; i++) {
+            memset(data[missing[i]], 0, blocksize);
+            dst[i] = data[missing[i]];
+        }
+        nsources = rs_matrix_repair_matrix(k, m, matrix, nmissing, missing,
+            nmissing, missing, sources, decode);
+        if (nsources <= 0)
+            return -1;
+        if (n < k + l) {
+            for (g = 0; n < k && (g + 1) * k / l <= n; g++)
+                ;
+            if (k <= n)
+                g = n - k;
+            for (i = 0; i < nsources; i++)
+                if (sources[i] != k + g && (sources[i] >= k ||
+                        sources[i] < g * k / l ||
+                        (g + 1) * k / l <= sources[i]))
+                    return -1;
+        }
+        for (i = 0; i < nsources; i++)
+            src[i] = data[sources[i]];
+        rs_matrix_mul(nmissing, nsources, decode, blocksize, src, dst);
+        if (compare(k + m, blocksize, data, orig) != 0)
+            return -1;
+    }
+    return 0;
+}
+
+/*
+ * The n+3 code coding matrix must match rs_encode(), and any single block
+ * must be recoverable with the repair matrix computed from it.
+ */
+static int
+test_pqr(int k, int blocksize)
+{
+    const int m = RS_LIB_MAX_RECOVERY_BLOCKS;
+    unsigned char matrix[RS_LIB_MAX_RECOVERY_BLOCKS*RS_LIB_MAX_DATA_BLOCKS];
+    unsigned char decode[RS_LIB_MAX_DATA_BLOCKS];
+    int missing[RS_LIB_MAX_RECOVERY_BLOCKS];
+    int sources[RS_LIB_MAX_DATA_BLOCKS];
+    void *src[RS_LIB_MAX_DATA_BLOCKS];
+    void *dst[1];
+    int i, j, n, x, nmissing, nsources;
+
+    rs_pqr_matrix(k, m, matrix);
+    for (i = 0; i < k; i++)
+        mkrand(data[i], blocksize);
+    rs_encode(k + m, blocksize, data);
+    for (i = 0; i < k + m; i++)
+        memmove(orig[i], data[i], blocksize);
+    rs_matrix_mul(m, k, matrix, blocksize, data, data + k);
+    if (compare(k + m, blocksize, data, orig) != 0)
+        return -1;
+    for (n = 0; n < k + m + 64; n++) {
+        missing[0] = n < k + m ? n : rand() % (k + m);
+        for (nmissing = 1; nmissing < (n < k + m ? 1 : 1 + rand() % m); ) {
+            x = rand() % (k + m);
+            for (j = 0; j < nmissing && missing[j] != x; j++)
+                ;
+            if (j == nmissing)
+                missing[nmissing++] = x;
+        }
+        memset(data[missing[0]], 0, blocksize);
+        dst[0] = data[missing[0]];
+        nsources = rs_matrix_repair_matrix(k, m, matrix, nmissing, missing,
+            1, missing, sources, decode);
+        if (nsources <= 0)
+            return -1;
+        for (i = 0; i < nsources; i++)
+            src[i] = data[sources[i]];
+        rs_matrix_mul(1, nsources, decode, blocksize, src, dst);
+        if (compare(k + m, blocksize, data, orig) != 0)
+            return -1;
+    }
+    return 0;
+}
 
 int main(int argc, char **argv)
 {
     if (argc > 1 && (!strcmp(argv[1], "-h") || !strcmp(argv[1], "--help"))) {
-        printf("Usage: %s [data blocks] [block size] [perf iterations]\n"
+        printf("Usage: %s [data blocks] [block size] [perf iterations]"
+                    " [max vector size]\n"
                "       This tests the Reed Solomon encoder and decoder.\n"
                "       0 < data blocks <= %d.\n"
                "       Use perf iterations for performance test.\n"
+               "       Max vector size 0 -- the widest supported by the cpu,\n"
+               "       without perf iterations all vector sizes up to max\n"
+               "       are tested.\n"
                "       Defaults: data blocks=%d, block size=%d\n", argv[0],
                RS_LIB_MAX_DATA_BLOCKS, RS_LIB_MAX_DATA_BLOCKS, (64 << 10));
         exit(0);
     }
 
-    int i, j, k, n, m, err;
+    int i, j, k, n, m, err, vs, cvs;
     const int N = argc > 1 ? atoi(argv[1]) : RS_LIB_MAX_DATA_BLOCKS;
     const int BLOCKSIZE = argc > 2 ? atoi(argv[2]) : (64 << 10);
+    const int MAXVS = rs_set_max_vector_size(argc > 4 ? atoi(argv[4]) : 0);
 
     if (N <= 0 || N > RS_LIB_MAX_DATA_BLOCKS) {
         printf("0 < data blocks <= %d\n", RS_LIB_MAX_DATA_BLOCKS);
         return 1;
     }
 
-    for (i = 0; i < N+3; i++) {
+    for (i = 0; i < N+MATRIX_MAX_RECOVERY_BLOCKS; i++) {
         if ((err = posix_memalign(data + i, 16, BLOCKSIZE)) ||
                 (err = posix_memalign(orig + i, 16, BLOCKSIZE))) {
             printf("%s\n", strerror(err));
@@ -97,6 +294,7 @@ int main(int argc, char **argv)
         double  tbytes = 0;
         // Performance test.
         n = atoi(argv[3]);
+        printf("vector size: %d\n", MAXVS);
         for (i = 0; i < N+3; i++)
             mkrand(data[i], BLOCKSIZE);
         clk = clock();
@@ -143,59 +341,85 @@ int main(int argc, char **argv)
             (double)tclk, (double)tclk/CLOCKS_PER_SEC,
             tbytes * (double)CLOCKS_PER_SEC /
                 ((double)tclk > 0 ? (double)tclk : 1e-10));
+        for (m = 3; m <= MATRIX_MAX_RECOVERY_BLOCKS; m++)
+            if (test_matrix(N, m, BLOCKSIZE, n) != 0) {
+                printf("FAILED: matrix %d+%d\n", N, m);
+                return 1;
+            }
         return 0;
     }
 
-    for (n = 0; n < 17; n++) {
-        if (n > 0) {
-            for (i = 0; i < N; i++)
-                mkrand(data[i], BLOCKSIZE);
-        }
+    for (vs = 16, cvs = 0; vs <= MAXVS; vs *= 2) {
+        if (rs_set_max_vector_size(vs) == cvs)
+            continue;
+        cvs = rs_get_vector_size();
+        for (n = 0; n < 17; n++) {
+            if (n > 0) {
+                for (i = 0; i < N; i++)
+                    mkrand(data[i], BLOCKSIZE);
+            }
 
-        rs_encode(N+3, BLOCKSIZE, data);
+            rs_encode(N+3, BLOCKSIZE, data);
 
-        for (i = 0; i < N+3; i++)
-            memmove(orig[i], data[i], BLOCKSIZE);
-
-        // One missing block
-        for (i = 0; i < N+3; i++) {
-            memset(data[i], 0, BLOCKSIZE);
-            rs_decode1(N+3, BLOCKSIZE, i, data);
-            if (compare(N+3, BLOCKSIZE, data, orig) != 0) {
-                printf("FAILED: %d missing %d\n", n, i);
-                return 1;
-            }
-        }
+            for (i = 0; i < N+3; i++)
+                memmove(orig[i], data[i], BLOCKSIZE);
 
-        // Two missing blocks
-        for (i = 0; i < N+3; i++)
-            for (j = 0; j < N+3; j++) {
-                if (i == j) continue;
+            // One missing block
+            for (i = 0; i < N+3; i++) {
                 memset(data[i], 0, BLOCKSIZE);
-                memset(data[j], 0, BLOCKSIZE);
-                rs_decode2(N+3, BLOCKSIZE, i, j, data);
+                rs_decode1(N+3, BLOCKSIZE, i, data);
                 if (compare(N+3, BLOCKSIZE, data, orig) != 0) {
-                    printf("FAILED: %d missing: %d %d\n", n, i, j);
+                    printf("FAILED: %d missing %d\n", n, i);
                     return 1;
                 }
             }
 
-        // Three missing blocks
-        for (i = 0; i < N+3; i++)
-            for (j = 0; j < N+3; j++) {
-                if (i == j) continue;
-                for (k = 0; k < N+3; k++) {
-                    if (i == k || j == k) continue;
+            // Two missing blocks
+            for (i = 0; i < N+3; i++)
+                for (j = 0; j < N+3; j++) {
+                    if (i == j) continue;
                     memset(data[i], 0, BLOCKSIZE);
                     memset(data[j], 0, BLOCKSIZE);
-                    memset(data[k], 0, BLOCKSIZE);
-                    rs_decode3(N+3, BLOCKSIZE, i, j, k, data);
+                    rs_decode2(N+3, BLOCKSIZE, i, j, data);
                     if (compare(N+3, BLOCKSIZE, data, orig) != 0) {
-                        printf("FAILED: %d missing %d %d %d\n", n, i, j, k);
+                        printf("FAILED: %d missing: %d %d\n", n, i, j);
                         return 1;
                     }
                 }
+
+            // Three missing blocks
+            for (i = 0; i < N+3; i++)
+                for (j = 0; j < N+3; j++) {
+                    if (i == j) continue;
+                    for (k = 0; k < N+3; k++) {
+                        if (i == k || j == k) continue;
+                        memset(data[i], 0, BLOCKSIZE);
+                        memset(data[j], 0, BLOCKSIZE);
+                        memset(data[k], 0, BLOCKSIZE);
+                        rs_decode3(N+3, BLOCKSIZE, i, j, k, data);
+                        if (compare(N+3, BLOCKSIZE, data, orig) != 0) {
+                            printf("FAILED: %d missing %d %d %d\n", n, i, j, k);
+                            return 1;
+                        }
+                    }
+                }
+        }
+        if (test_pqr(N, BLOCKSIZE) != 0) {
+            printf("FAILED: pqr matrix %d+3\n", N);
+            return 1;
+        }
+        for (m = 1; m <= MATRIX_MAX_RECOVERY_BLOCKS; m++)
+            if (test_matrix(N, m, BLOCKSIZE, 0) != 0) {
+                printf("FAILED: matrix %d+%d\n", N, m);
+                return 1;
             }
+        for (m = 2; m <= MATRIX_MAX_RECOVERY_BLOCKS; m++)
+            for (j = 1; j < m && j <= N; j++)
+                if (test_lrc(N, m, j, BLOCKSIZE) != 0) {
+                    printf("FAILED: lrc %d+%d local groups: %d\n", N, m, j);
+                    return 1;
+                }
+        printf("vector size: %d PASS\n", cvs);
     }
     printf("PASS\n");
     return 0;
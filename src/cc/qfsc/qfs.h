@@ -38,7 +38,9 @@ extern "C" {
       KFS_STRIPED_FILE_TYPE_UNKNOWN     = 0,
       KFS_STRIPED_FILE_TYPE_NONE        = 1,
       KFS_STRIPED_FILE_TYPE_RS          = 2,
-      KFS_STRIPED_FILE_TYPE_RS_JERASURE = 3
+      KFS_STRIPED_FILE_TYPE_RS_JERASURE = 3,
+      KFS_STRIPED_FILE_TYPE_RS_CAUCHY   = 4,
+      KFS_STRIPED_FILE_TYPE_RS_LRC      = 5
   };
 
 // From KfsClient.h
@@ -285,6 +285,7 @@ public:
         bool        inReadOnlyFlag,
         bool        inCreateFlag,
         bool        inCreateExclusiveFlag,
+        bool        /* inBufferedIoFlag */,
         int64_t&    ioMaxFileSize)
     {
         const int theErr = ValidateFileName(inFileNamePtr);
@@ -294,6 +294,37 @@ mkdir "$testdir" || exit
 mkdir "$metasrvdir" || exit
 mkdir "$chunksrvdir" || exit
 
+echo "Running disk queue unit tests."
+qcunittest "$testdir/qcunittest.0" "$testdir/qcunittest.1" \
+    > "$testdir/qcunittest.log" 2>&1 || {
+    status=$?
+    cat "$testdir/qcunittest.log"
+    exit $status
+}
+rm -f "$testdir/qcunittest.0" "$testdir/qcunittest.1"
+
+echo "Running chunk server unit tests."
+chunkblockcachetest || exit
+tierreadcachetest || exit
+iouringtest || exit
+
+echo "Running checksum unit tests."
+checksumtest || exit
+
+echo "Running io buffer unit tests."
+iobuffertest || exit
+
+echo "Running properties tokenizer unit tests."
+propertiestokenizertest || exit
+
+echo "Running erasure code and checksum kernels self test."
+ecbench -t 0 -k 1,3,6,10,64 -b 4096,65552 -a 0,16 -v 0,16,32,64 \
+    -m 1,3,8 -c 1048576 > "$testdir/ecbench.log" 2>&1 || {
+    status=$?
+    cat "$testdir/ecbench.log"
+    exit $status
+}
+
 cabundlefileos='/etc/pki/tls/certs/ca-bundle.crt'
 cabundlefile="$chunksrvdir/ca-bundle.crt"
 objectstoredir="$chunksrvdir/object_store"
@@ -488,6 +519,7 @@ chunkServer.exitDebugCheck = 1
 chunkServer.rsReader.debugCheckThread = 1
 chunkServer.clientThreadCount = $chunkserverclithreads
 chunkServer.placementMaxWaitingAvgSecsThreshold = 600
+chunkServer.readBlockCacheSize = 4194304
 # chunkServer.forceVerifyDiskReadChecksum = 1
 # chunkServer.debugTestWriteSync = 1
 EOF
@@ -515,6 +547,49 @@ EOF
 chunkServer.ioBufferPool.partitionBufferCount = 8192
 chunkServer.objStoreBlockWriteBufferSize      = $objectstorebuffersize
 chunkServer.objectDir                         = $objectstoredir
+EOF
+    fi
+    if [ `expr $i % 2` -eq 0 ]; then
+        # Use sendfile read replies on half of the chunk servers. Sendfile
+        # requires buffered io. The copy test file sizes that are not multiple
+        # of the checksum block size cover non aligned chunk tail reads.
+        cat >> "$dir/$chunksrvprop" << EOF
+chunkServer.bufferedIo      = 1
+chunkServer.client.sendFile = 1
+EOF
+    fi
+    if [ `expr $i % 3` -ne 0 ]; then
+        # Use crc32c checksums with the new chunks on two out of three chunk
+        # servers, in order to have chunks with both header versions, and
+        # replication and recovery between the servers with different
+        # checksum types.
+        cat >> "$dir/$chunksrvprop" << EOF
+chunkServer.checksumType = 1
+EOF
+    fi
+    if [ `expr $i % 2` -ne 0 ]; then
+        # Use zero copy sends on the chunk servers that do not use sendfile.
+        # With loopback the kernel copies the data, and zero copy is turned
+        # off on each connection after the first completion report, therefore
+        # the minimum size is set to the lowest effective value.
+        cat >> "$dir/$chunksrvprop" << EOF
+chunkServer.client.zeroCopyMinSize     = 10240
+chunkServer.remoteSync.zeroCopyMinSize = 10240
+EOF
+    fi
+    if [ $i -eq $chunksrvport -a $chunkserverclithreads -gt 0 ]; then
+        # Accept client connections with per client thread SO_REUSEPORT
+        # listeners on the first chunk server.
+        cat >> "$dir/$chunksrvprop" << EOF
+chunkServer.clientThreadReusePort = 1
+EOF
+    fi
+    if [ `expr $i % 2` -ne 0 ]; then
+        # Use io uring with the chunk directories on the chunk servers that do
+        # not use buffered io. The chunk server falls back to io threads if io
+        # uring is not available.
+        cat >> "$dir/$chunksrvprop" << EOF
+chunkServer.diskQueue.ioUring = 1
 EOF
     fi
     cd "$dir" || exit
@@ -555,7 +630,9 @@ fi
 echo "Starting copy test. Test file sizes: $sizes"
 # Run normal test first, then rs test.
 # Enable read ahead and set buffer size to an odd value.
-# For RS disable read ahead and set odd buffer size.
+# For RS disable read ahead and set odd buffer size, then repeat RS test with
+# recovery stripes computed by the encoder threads.
+# Then run the general Cauchy 10+4 and locally repairable code 6+3 tests.
 cppidf="cptest${pidsuf}"
 {
 #    cptokfsopts='-W 2 -b 32767 -w 32767' && \
@@ -571,8 +648,21 @@ cppidf="cptest${pidsuf}"
     cptokfsopts='-S -m 2 -l 2 -w -1' \
     cpfromkfsopts='-r 0 -w 65537' \
     cptest.sh && \
+    mv cptest.log cptest-rs.log && \
+    QFS_CLIENT_CONFIG="$clientenvcfg client.rsEncoderThreads=2" \
+    cptokfsopts='-S -m 2 -l 2 -w -1' \
+    cpfromkfsopts='-r 0 -w 65537' \
+    cptest.sh && \
+    mv cptest.log cptest-rs-enc.log && \
+    cptokfsopts='-u 65536 -y 10 -z 4 -r 1 -F 4 -m 2 -l 2 -w -1' \
+    cpfromkfsopts='-r 0 -w 65537' \
+    cptest.sh && \
+    mv cptest.log cptest-cauchy.log && \
+    cptokfsopts='-u 65536 -y 6 -z 3 -r 1 -F 5 -m 2 -l 2 -w -1' \
+    cpfromkfsopts='-r 0 -w 65537' \
+    cptest.sh && \
+    mv cptest.log cptest-lrc.log && \
     [ x"$jerasuretest" = x'no' ] || { \
-        mv cptest.log cptest-rs.log && \
         cptokfsopts='-u 65536 -y 10 -z 4 -r 1 -F 3 -m 2 -l 2 -w -1' \
         cpfromkfsopts='-r 0 -w 65537' \
         cptest.sh ; \
@@ -24,6 +24,17 @@
 # Test RS recovery with sparse files by creating sparse file and forcing
 # recovery by deleting chunk files and running file verification, and
 # using admin tool to force recovery of existing chunks.
+#
+# With locally repairable code file type, for example
+# filecreateparams='fs.createParams=1,6,3,1048576,5,15,15', the default
+# erasure patterns are within the code loss tolerance, and the test verifies
+# that the chunk servers recover single lost chunk in the group with local
+# repair, by reading only the chunk's local group.
+#
+# With rspipelinedrecovery=1 the meta server requests pipelined RS recovery,
+# and the test verifies that the chunks are recovered with the repair chain.
+# The chain is used only without chunk server authentication, therefore the
+# test setup must be created with qfstest.sh -noauth.
 
 ulimit -c unlimited || exit
 
@@ -50,6 +61,7 @@ csstartport=${csstartport-20400}
 csendport=${csendport-`expr $csstartport + 1`}
 valgrind_cmd=${valgrind_cmd-''}
 recoveryforcetimes=${recoveryforcetimes-1}
+rspipelinedrecovery=${rspipelinedrecovery-0}
 
 start=1
 runtest=1
@@ -144,6 +156,36 @@ if [ $stop -ne 0 ]; then
 fi
 
 datastripes=`echo "$filecreateparams" | cut -d , -f 2`
+stripertype=`echo "$filecreateparams" | cut -d , -f 5`
+
+# Format:
+# <stripe to force recovery> <stripe to delete> <stripe to delete> <stripe to delete>
+# negative stripe / chunk numbers except the first column means restore the
+# "original" chunk.
+if [ x"$stripertype" = x5 ]; then
+    # Locally repairable code 6+3: two local groups 0-2 with parity 6, and
+    # 3-5 with parity 7, and one global parity 8. Up to two lost chunks are
+    # recoverable. The last pattern has two lost chunks in the same group,
+    # and requires global parity.
+    localrepair=${localrepair-1}
+    recoverystripes=${recoverystripes-'1 1
+    7 7
+    4 4 8
+    0 0 3
+    -1 5 6
+    2 2 0'}
+else
+    localrepair=${localrepair-0}
+    recoverystripes=${recoverystripes-'-1 0 1 5
+    6 3 7 8
+    0 0 1 2
+    5 5 6
+    -1 4 5
+    -1 10 11
+    -1 10 11 12
+    -1 -3 -5
+    -1 0 1 5'}
+fi
 
 if [ $start -ne 0 ]; then
     if [ -d "$qfstestdir" ]; then
@@ -163,6 +205,9 @@ if [ $start -ne 0 ]; then
         echo "metaServer.recoveryInterval=0"
         echo "metaServer.maxRecoveryStripeCount=10000"
         echo "metaServer.maxRSDataStripeCount=10000"
+        if [ x"$rspipelinedrecovery" = x1 ]; then
+            echo "metaServer.rsPipelinedRecovery=1"
+        fi
         if [ x = x"$valgrind_cmd" ]; then
             true;
         else
@@ -184,6 +229,12 @@ if [ $start -ne 0 ]; then
         kill -KILL `cat chunkserver.pid` 2>/dev/null
         rm -f chunkserver-recovery.log
         rm -rf kfschunk*/*
+        if [ x"$rspipelinedrecovery" = x1 ] && \
+                grep '^chunkserver.meta.auth' ChunkServer.prp >/dev/null; then
+            echo "pipelined recovery requires no authentication," \
+                "execute qfstest.sh -noauth first" 1>&2
+            exit 1
+        fi
         if [ $datastripes -gt 10 ]; then
             sed -e 's/^\(chunkServer.diskIo.crashOnError.*\)$/# \1/' \
                 -e 's/^\(chunkServer.ioBufferPool.partitionBufferCount.*\)$/# \1/' \
@@ -251,6 +302,28 @@ verify_file()
     return 1
 }
 
+verify_file_degraded()
+{
+    # Read with the buffer size smaller than the stride, in order to serve
+    # sequential reads in the degraded chunk blocks from the client recovered
+    # stripes cache.
+    filemd5=`"$toolsdir"/cpfromqfs \
+        -s "$metahost" -p "$metaport" -f "$clicfg" \
+        -r 0 -w 65537 -F 0 -v \
+        -k "/user/$usr/testrep.dat" -d - \
+        2>>"$degradedreadlog" \
+        | openssl md5 | awk '{print $NF}'`
+
+    if [ x"$testmd5" = x"$filemd5" ]; then
+        return 0
+    fi
+    echo "degraded read checksum mismatch: expected: $testmd5 actual: $filemd5"
+    return 1
+}
+
+degradedreadlog="$qfstestdir/degradedread.log"
+rm -f "$degradedreadlog"
+
 status=0
 "$toolsdir"/qfs \
     -cfg "$clicfg" \
@@ -367,6 +440,10 @@ for testblocksize in $testblocksizes ; do
                 ls -l "$chunkf"
             fi
         done
+        verify_file_degraded || {
+            status=1
+            break
+        }
 
         s=0
         for n in $m ; do
@@ -424,22 +501,43 @@ for testblocksize in $testblocksizes ; do
         echo "============== $testblocksize = $k == $stripes =================="
         k=`expr $k + 1`
     done << EOF
-    -1 0 1 5
-    6 3 7 8
-    0 0 1 2
-    5 5 6
-    -1 4 5
-    -1 10 11
-    -1 10 11 12
-    -1 -3 -5
-    -1 0 1 5
+    $recoverystripes
 EOF
     [ $status -eq 0 ] || break;
 done
-# Format:
-# <stripe to force recovery> <stripe to delete> <stripe to delete> <stripe to delete>
-# negative stripe / chunk numbers except the first column means restore the
-# "original" chunk.
+
+if [ $status -eq 0 -a $localrepair -ne 0 ]; then
+    if cat "$qfstestdir"/chunk/*/chunkserver-recovery.log \
+            | grep 'local repair:'; then
+        true
+    else
+        echo "no chunk recovered with local repair" 1>&2
+        status=1
+    fi
+fi
+
+if [ $status -eq 0 -a $localrepair -eq 0 ]; then
+    if grep 'recovery cache:' "$degradedreadlog" > /dev/null; then
+        true
+    else
+        echo "no degraded read served from recovery cache" 1>&2
+        status=1
+    fi
+fi
+
+if [ $status -eq 0 -a x"$rspipelinedrecovery" = x1 ]; then
+    if cat "$qfstestdir"/chunk/*/chunkserver-recovery.log \
+            | grep 'repair chain: .*\(not chunk server\|no chunk server\)'; then
+        echo "pipelined recovery repair chain rejected" 1>&2
+        status=1
+    elif cat "$qfstestdir"/chunk/*/chunkserver-recovery.log \
+            | grep 'pipelined repair chain:'; then
+        true
+    else
+        echo "no chunk recovered with pipelined repair chain" 1>&2
+        status=1
+    fi
+fi
 
 if [ $stop -eq 0 ] || shutdown; then
     stop=0